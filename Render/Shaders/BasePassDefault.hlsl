@@ -1,10 +1,29 @@
 #include "Common.hlsl"
 
+#if BINDLESS
+#include "Bindless.hlsl"
+
+// Same order as the bindlessTextureSlots of DefaultMat
+#define BaseColorTexture BindlessTextures[gMaterial.TextureIndices.x]
+#define NormalTexture BindlessTextures[gMaterial.TextureIndices.y]
+#define MetallicTexture BindlessTextures[gMaterial.TextureIndices.z]
+#define RoughnessTexture BindlessTextures[gMaterial.TextureIndices.w]
+#else
 Texture2D BaseColorTexture;
 Texture2D NormalTexture;
 Texture2D MetallicTexture;
 Texture2D RoughnessTexture;
+#endif
 
+#if COMPACT_VERTEX
+// CompactVertex, decoded by DecodeVertex
+struct VertexIn
+{
+    float4 PosQ : POSITION;           // unorm16 inside the mesh bounds
+    float4 NormalTangentOct : NORMAL; // octahedral normal in xy, tangent in zw
+    float2 TexC : TEXCOORD;           // half
+};
+#else
 struct VertexIn
 {
     float3 PosL : POSITION;
@@ -12,6 +31,20 @@ struct VertexIn
     float2 TexC : TEXCOORD;
     float3 TangentU : TANGENT;
 };
+#endif
+
+void DecodeVertex(VertexIn vin, out float3 PosL, out float3 NormalL, out float3 TangentU)
+{
+#if COMPACT_VERTEX
+    PosL = gPositionQuantizeMin + vin.PosQ.xyz * gPositionQuantizeScale;
+    NormalL = OctDecode(vin.NormalTangentOct.xy);
+    TangentU = OctDecode(vin.NormalTangentOct.zw);
+#else
+    PosL = vin.PosL;
+    NormalL = vin.NormalL;
+    TangentU = vin.TangentU;
+#endif
+}
 
 struct VertexOut
 {
@@ -41,14 +74,17 @@ VertexOut VS(VertexIn vin)
     // Fetch the material data.
     MaterialData MatData = gMaterial;
 
+    float3 PosL, NormalL, TangentU;
+    DecodeVertex(vin, PosL, NormalL, TangentU);
+
     // Transform to world space.
-    float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+    float4 posW = mul(float4(PosL, 1.0f), gWorld);
     Out.PosW = posW.xyz;
 
     // Assumes nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
-    Out.NormalW = mul(vin.NormalL, (float3x3) gWorld);
+    Out.NormalW = mul(NormalL, (float3x3) gWorld);
 
-    Out.TangentW = mul(vin.TangentU, (float3x3) gWorld);
+    Out.TangentW = mul(TangentU, (float3x3) gWorld);
 
     // Transform to homogeneous clip space.
     Out.PosH = mul(posW, gViewProj);
@@ -56,7 +92,7 @@ VertexOut VS(VertexIn vin)
     // CurPosH and PrevPosH
     Out.CurPosH = mul(posW, gViewProj);
     
-    float4 PrevPosW = mul(float4(vin.PosL, 1.0f), gPrevWorld);
+    float4 PrevPosW = mul(float4(PosL, 1.0f), gPrevWorld);
     Out.PrevPosH = mul(PrevPosW, gPrevViewProj);
 
     // Output vertex attributes for interpolation across triangle.
@@ -95,6 +131,12 @@ PixelOutput PS(VertexOut pin) //: SV_Target
     else
     {
         float4 NormalMapSample = NormalTexture.Sample(gsamAnisotropicWrap, pin.TexC);
+
+        // Rebuild Z from XY, baked normal maps are two channel (BC5)
+        float2 NormalXY = NormalMapSample.rg * 2.0f - 1.0f;
+        float NormalZ = sqrt(saturate(1.0f - dot(NormalXY, NormalXY)));
+        NormalMapSample.b = NormalZ * 0.5f + 0.5f;
+
         float3 Normal = NormalSampleToWorldSpace(NormalMapSample.rgb, pin.NormalW, pin.TangentW);
         Out.Normal = float4(normalize(Normal), 1.0f);
     }
@@ -123,9 +165,10 @@ PixelOutput PS(VertexOut pin) //: SV_Target
     
     Out.OcclusionRoughnessMetallic = float4(0, Roughtness, Metallic, 0);
     
-    // Velocity
+    // Velocity, the previous frame is not jittered
     float4 CurPos = pin.CurPosH;
     CurPos /= CurPos.w; // Complete projection division
+    CurPos.xy -= gJitter;
     CurPos.xy = NDCToUV(CurPos);
     
     float4 PrevPos = pin.PrevPosH;
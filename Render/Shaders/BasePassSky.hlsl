@@ -15,6 +15,8 @@ struct VertexOut
 {
     float4 PosH : SV_POSITION;
     float3 PosL : POSITION;
+    float4 CurPosH : POSITION1;
+    float4 PrevPosH : POSITION2;
 };
 
 struct PixelOutput
@@ -23,6 +25,7 @@ struct PixelOutput
     float4 Normal : SV_TARGET1;
     float4 WorldPos : SV_TARGET2;
     float4 OcclusionRoughnessMetallic : SV_TARGET3;
+    float2 Velocity : SV_TARGET4;
 };
 
 VertexOut VS(VertexIn vin)
@@ -37,6 +40,10 @@ VertexOut VS(VertexIn vin)
     // Set z = w so that z/w = 1 (i.e., skydome always on far plane).
     Out.PosH = PosH.xyww;
     
+    // The sky is infinitely far, only the camera rotation moves it
+    Out.CurPosH = mul(float4(vin.PosL, 0.0f), gViewProj);
+    Out.PrevPosH = mul(float4(vin.PosL, 0.0f), gPrevViewProj);
+    
     return Out;
 }
 
@@ -51,5 +58,11 @@ PixelOutput PS(VertexOut pin)
     Out.OcclusionRoughnessMetallic = 0.0f;
     Out.WorldPos.rbg = 0.0f;
     
+    // Velocity, the previous frame is not jittered
+    float4 CurPos = pin.CurPosH / pin.CurPosH.w;
+    CurPos.xy -= gJitter;
+    float4 PrevPos = pin.PrevPosH / pin.PrevPosH.w;
+    Out.Velocity = NDCToUV(CurPos) - NDCToUV(PrevPos);
+    
     return Out;
 }
\ No newline at end of file
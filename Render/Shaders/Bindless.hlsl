@@ -0,0 +1,10 @@
+#ifndef __SHADER_BINDLESS__
+#define __SHADER_BINDLESS__
+
+// Keep in sync with BindlessTable.h
+#define BINDLESS_TABLE_SIZE 4096
+
+// Every SRV registered in the BindlessTable, indexed with integers from constant buffers
+Texture2D BindlessTextures[BINDLESS_TABLE_SIZE] : register(t0, space1);
+
+#endif //__SHADER_BINDLESS__
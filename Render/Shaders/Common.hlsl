@@ -10,6 +10,10 @@ cbuffer cbPerObject
     float4x4 gWorld;
     float4x4 gPrevWorld;
     float4x4 gTexTransform;
+    float3 gPositionQuantizeMin;
+    float cbObjectPad0;
+    float3 gPositionQuantizeScale;
+    float cbObjectPad1;
 };
 
 cbuffer cbPass
@@ -29,6 +33,8 @@ cbuffer cbPass
     float gFarZ;
     float gTotalTime;
     float gDeltaTime;
+    float2 gJitter; // TAA offset of gProj in NDC
+    float2 cbPassPad3;
 };
 
 struct MaterialData
@@ -40,6 +46,9 @@ struct MaterialData
 	
     float3 EmissiveColor;
     uint ShadingModel;
+
+    // BindlessTable indices, only valid with BINDLESS
+    uint4 TextureIndices;
 };
 
 cbuffer cbMaterialData
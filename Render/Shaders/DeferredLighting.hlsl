@@ -1,6 +1,7 @@
 #include "PBRLighting.hlsl"
 #include "Common.hlsl"
 #include "LightingUtil.hlsl"
+#include "Shadows.hlsl"
 
 StructuredBuffer<LightParameters> Lights;
 
@@ -98,12 +99,53 @@ float4 PS(VertexOut pin) : SV_TARGET
         
         //-----------------------------------------------Direct Light---------------------------------------
 	
-        float3 LightDir = normalize(-Lights[0].Direction);
-        float3 LightPosition = WorldPos + LightDir * 100.0f;
-        float TanLightAngle = tan(3 * PI / 180.0f); //TODO	
-        float3 Radiance = Lights[0].Intensity * Lights[0].Color;
-    
-        finalColor += DirectLighting(Radiance, LightDir, Normal, ViewDir, Roughness, Metallic, BaseColor);
+        bool bCascadesUsed = false;
+        for (uint LightIdx = 0; LightIdx < LightCount; LightIdx++)
+        {
+            LightParameters Light = Lights[LightIdx];
+            
+            if (Light.LightType == LIGHT_TYPE_DIRECTIONAL)
+            {
+                float3 LightDir = normalize(-Light.Direction);
+                float3 Radiance = Light.Intensity * Light.Color;
+                
+                // The cascades belong to the first directional light
+                if (!bCascadesUsed)
+                {
+                    Radiance *= CascadedShadowVisibility(WorldPos, Normal, LightDir);
+                    bCascadesUsed = true;
+                }
+
+                finalColor += DirectLighting(Radiance, LightDir, Normal, ViewDir, Roughness, Metallic, BaseColor);
+            }
+            else if (Light.LightType == LIGHT_TYPE_POINT || Light.LightType == LIGHT_TYPE_SPOT)
+            {
+                float3 ToLight = Light.Position - WorldPos;
+                float Distance = length(ToLight);
+                if (Distance >= Light.Range)
+                {
+                    continue;
+                }
+                
+                float3 LightDir = ToLight / Distance;
+                
+                // Inverse square falloff, windowed to reach zero at the range
+                float Attenuation = Square(saturate(1.0f - Square(Square(Distance / Light.Range)))) / (Distance * Distance + 1.0f);
+                
+                if (Light.LightType == LIGHT_TYPE_SPOT)
+                {
+                    Attenuation *= SpotAttenuation(LightDir, normalize(Light.Direction), Light.SpotAngles);
+                }
+                
+                if (Attenuation > 0.0f && Light.ShadowMapIdx >= 0)
+                {
+                    Attenuation *= LocalShadowVisibility(WorldPos, Normal, Light.Position, (uint) Light.ShadowMapIdx, Light.LightType == LIGHT_TYPE_POINT);
+                }
+                
+                float3 Radiance = Light.Intensity * Light.Color * Attenuation;
+                finalColor += DirectLighting(Radiance, LightDir, Normal, ViewDir, Roughness, Metallic, BaseColor);
+            }
+        }
         
     }
     
@@ -13,9 +13,16 @@ struct LightParameters
     float SpotRadius; // Spot light only
     float2 SpotAngles; // Spot light only
     uint LightType;
-    
+    int ShadowMapIdx; // Point/Spot light only, first face in LocalShadowFaces, -1 without a shadow map
+    float4x4 LightProj;
+    float4x4 ShadowTransform;
 };
 
+// Same values as ELightType
+#define LIGHT_TYPE_DIRECTIONAL 2
+#define LIGHT_TYPE_POINT 3
+#define LIGHT_TYPE_SPOT 4
+
 cbuffer LightCommonData
 {
     uint LightCount;
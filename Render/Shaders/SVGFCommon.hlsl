@@ -0,0 +1,88 @@
+#ifndef __SHADER_SVGF_COMMON__
+#define __SHADER_SVGF_COMMON__
+
+// Mirrors SVGFDenoiser.h
+#define SVGF_COLOR_ALPHA 0.2f
+#define SVGF_MOMENTS_ALPHA 0.2f
+#define SVGF_MAX_HISTORY_LENGTH 32.0f
+#define SVGF_VARIANCE_HISTORY_FRAMES 4.0f
+#define SVGF_REPROJECT_NORMAL_THRESHOLD 0.9f
+#define SVGF_REPROJECT_DEPTH_TOLERANCE 0.1f
+#define SVGF_PHI_COLOR 4.0f
+#define SVGF_PHI_NORMAL 128.0f
+#define SVGF_PHI_DEPTH 1.0f
+#define SVGF_ALBEDO_EPSILON 0.001f
+
+cbuffer cbSVGF
+{
+    uint gHistoryValid; // 0 when the history holds nothing of this view
+    int gStepSize; // pixels between the a-trous taps
+    uint gRemodulate; // the last a-trous iteration multiplies the albedo back in
+    float cbSVGFPad;
+};
+
+float Luminance(float3 Color)
+{
+    return dot(Color, float3(0.2126f, 0.7152f, 0.0722f));
+}
+
+// Nothing was hit, the sky writes a zero normal
+bool IsBackground(float3 Normal)
+{
+    return all(Normal == 0.0f);
+}
+
+float NormalWeight(float3 CenterNormal, float3 Normal)
+{
+    return pow(max(dot(CenterNormal, Normal), 0.0f), SVGF_PHI_NORMAL);
+}
+
+// The depth difference is measured against what the plane through the center would give at that offset
+float DepthWeight(float CenterDepth, float Depth, float2 DepthGradient, float2 Offset)
+{
+    float PlaneDifference = abs(dot(DepthGradient, Offset));
+
+    return exp(-abs(CenterDepth - Depth) / (SVGF_PHI_DEPTH * PlaneDifference + 1e-3f * CenterDepth));
+}
+
+// Depth change per pixel in x and y of a surface texture (normal in xyz, linear depth in w), from the smaller one
+// sided difference so edges do not widen it
+float2 GetDepthGradient(Texture2D Surface, int2 Pixel, int2 Size)
+{
+    float Depth = Surface[Pixel].w;
+    float2 Gradient = 0.0f;
+
+    [unroll]
+    for (int Axis = 0; Axis < 2; Axis++)
+    {
+        float Smallest = 1e30f;
+
+        [unroll]
+        for (int Sign = -1; Sign <= 1; Sign += 2)
+        {
+            int2 SamplePixel = Pixel;
+            SamplePixel[Axis] += Sign;
+            if (any(SamplePixel < 0) || any(SamplePixel >= Size))
+            {
+                continue;
+            }
+
+            float4 SampleSurface = Surface[SamplePixel];
+            if (IsBackground(SampleSurface.xyz))
+            {
+                continue;
+            }
+
+            float Difference = (SampleSurface.w - Depth) * Sign;
+            if (abs(Difference) < Smallest)
+            {
+                Smallest = abs(Difference);
+                Gradient[Axis] = Difference;
+            }
+        }
+    }
+
+    return Gradient;
+}
+
+#endif
@@ -1,4 +1,99 @@
-[numthreads(1, 1, 1)]
-void CS( uint3 DTid : SV_DispatchThreadID )
+#include "SVGFCommon.hlsl"
+
+// One a-trous wavelet iteration with edge stopping functions, the same steps as SVGFDenoiser::FilterIteration.
+// The taps are gStepSize pixels apart, the step doubles every iteration.
+
+Texture2D IlluminationTexture; // illumination in rgb, variance in a
+Texture2D SurfaceTexture; // normal in xyz, linear depth in w
+Texture2D BaseColorGbuffer;
+
+RWTexture2D<float4> FilteredTexture;
+
+// 5x5 B3 spline, separable
+static const float ATrousKernel[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+// 3x3 Gaussian the variance is prefiltered with, separable
+static const float VarianceKernel[2] = { 1.0f / 2.0f, 1.0f / 4.0f };
+
+[numthreads(8, 8, 1)]
+void CS(uint3 DTid : SV_DispatchThreadID)
 {
-}
\ No newline at end of file
+    uint Width, Height;
+    IlluminationTexture.GetDimensions(Width, Height);
+    if (DTid.x >= Width || DTid.y >= Height)
+    {
+        return;
+    }
+
+    int2 Pixel = int2(DTid.xy);
+    int2 Size = int2(Width, Height);
+    int2 MaxPixel = Size - 1;
+
+    float4 Center = IlluminationTexture[Pixel];
+    float4 Surface = SurfaceTexture[Pixel];
+
+    if (IsBackground(Surface.xyz))
+    {
+        FilteredTexture[Pixel] = Center;
+        return;
+    }
+
+    // Prefiltered, a single noisy variance would let the noise through
+    float FilteredVariance = 0.0f;
+    [unroll]
+    for (int vy = -1; vy <= 1; vy++)
+    {
+        [unroll]
+        for (int vx = -1; vx <= 1; vx++)
+        {
+            FilteredVariance += IlluminationTexture[clamp(Pixel + int2(vx, vy), 0, MaxPixel)].a
+                * VarianceKernel[abs(vx)] * VarianceKernel[abs(vy)];
+        }
+    }
+
+    float2 DepthGradient = GetDepthGradient(SurfaceTexture, Pixel, Size);
+    float CenterLuminance = Luminance(Center.rgb);
+    float LuminanceScale = SVGF_PHI_COLOR * sqrt(max(FilteredVariance, 0.0f)) + 1e-10f;
+
+    float3 SumIllumination = 0.0f;
+    float SumVariance = 0.0f;
+    float SumWeight = 0.0f;
+
+    [unroll]
+    for (int y = -2; y <= 2; y++)
+    {
+        [unroll]
+        for (int x = -2; x <= 2; x++)
+        {
+            int2 Offset = int2(x, y) * gStepSize;
+            int2 SamplePixel = Pixel + Offset;
+            if (any(SamplePixel < 0) || any(SamplePixel >= Size))
+            {
+                continue;
+            }
+
+            float4 SampleIllumination = IlluminationTexture[SamplePixel];
+            float4 SampleSurface = SurfaceTexture[SamplePixel];
+
+            float Weight = ATrousKernel[abs(x)] * ATrousKernel[abs(y)]
+                * NormalWeight(Surface.xyz, SampleSurface.xyz)
+                * DepthWeight(Surface.w, SampleSurface.w, DepthGradient, float2(Offset))
+                * exp(-abs(CenterLuminance - Luminance(SampleIllumination.rgb)) / LuminanceScale);
+
+            SumIllumination += SampleIllumination.rgb * Weight;
+            SumVariance += SampleIllumination.a * Weight * Weight;
+            SumWeight += Weight;
+        }
+    }
+
+    // The center tap always has a weight
+    float3 Illumination = SumIllumination / SumWeight;
+    float Variance = SumVariance / (SumWeight * SumWeight);
+
+    if (gRemodulate)
+    {
+        Illumination *= BaseColorGbuffer[Pixel].rgb + SVGF_ALBEDO_EPSILON;
+    }
+
+    FilteredTexture[Pixel] = float4(Illumination, Variance);
+}
@@ -0,0 +1,119 @@
+#include "Common.hlsl"
+#include "SVGFCommon.hlsl"
+
+// Reprojects and accumulates the demodulated illumination and its luminance moments, the same steps as
+// SVGFDenoiser::TemporalAccumulate
+
+Texture2D NoisyTexture;
+Texture2D BaseColorGbuffer;
+Texture2D NormalGbuffer;
+Texture2D WorldPosGbuffer;
+Texture2D VelocityGbuffer;
+Texture2D PrevSurfaceTexture; // normal in xyz, linear depth in w
+Texture2D PrevMomentsTexture; // moments in xy, history length in z
+Texture2D ColorHistoryTexture; // illumination after the first a-trous iteration
+
+RWTexture2D<float4> SurfaceTexture;
+RWTexture2D<float4> MomentsTexture;
+RWTexture2D<float4> IlluminationTexture; // illumination in rgb, temporal variance in a
+
+[numthreads(8, 8, 1)]
+void CS(uint3 DTid : SV_DispatchThreadID)
+{
+    uint Width, Height;
+    NoisyTexture.GetDimensions(Width, Height);
+    if (DTid.x >= Width || DTid.y >= Height)
+    {
+        return;
+    }
+
+    int2 Pixel = int2(DTid.xy);
+    int2 Size = int2(Width, Height);
+
+    float3 Radiance = NoisyTexture[Pixel].rgb;
+    float3 Normal = NormalGbuffer[Pixel].xyz;
+
+    if (IsBackground(Normal))
+    {
+        float BackgroundLuminance = Luminance(Radiance);
+        SurfaceTexture[Pixel] = 0.0f;
+        MomentsTexture[Pixel] = float4(BackgroundLuminance, BackgroundLuminance * BackgroundLuminance, 0.0f, 0.0f);
+        IlluminationTexture[Pixel] = float4(Radiance, 0.0f);
+        return;
+    }
+
+    Normal = normalize(Normal);
+    float3 WorldPos = WorldPosGbuffer[Pixel].xyz;
+    float Depth = mul(float4(WorldPos, 1.0f), gView).z;
+
+    SurfaceTexture[Pixel] = float4(Normal, Depth);
+
+    float3 Illumination = Radiance / (BaseColorGbuffer[Pixel].rgb + SVGF_ALBEDO_EPSILON);
+    float CurrentLuminance = Luminance(Illumination);
+    float2 Moments = float2(CurrentLuminance, CurrentLuminance * CurrentLuminance);
+
+    // Bilinear footprint of the pixel in the previous frame, taps of other surfaces are dropped
+    float3 PrevIllumination = 0.0f;
+    float2 PrevMoments = 0.0f;
+    float PrevLength = 0.0f;
+    float TotalWeight = 0.0f;
+
+    if (gHistoryValid)
+    {
+        float2 PrevPos = ((float2(Pixel) + 0.5f) / float2(Size) - VelocityGbuffer[Pixel].xy) * float2(Size) - 0.5f;
+        float2 FloorPos = floor(PrevPos);
+        float2 Frac = PrevPos - FloorPos;
+
+        // Clip w is the view depth, so this is where the surface was from the previous camera
+        float ExpectedDepth = mul(float4(WorldPos, 1.0f), gPrevViewProj).w;
+
+        [unroll]
+        for (int Tap = 0; Tap < 4; Tap++)
+        {
+            int2 TapOffset = int2(Tap & 1, Tap >> 1);
+            int2 TapPixel = int2(FloorPos) + TapOffset;
+            if (any(TapPixel < 0) || any(TapPixel >= Size))
+            {
+                continue;
+            }
+
+            float4 PrevSurface = PrevSurfaceTexture[TapPixel];
+            if (dot(PrevSurface.xyz, Normal) < SVGF_REPROJECT_NORMAL_THRESHOLD
+                || abs(PrevSurface.w - ExpectedDepth) > SVGF_REPROJECT_DEPTH_TOLERANCE * ExpectedDepth)
+            {
+                continue;
+            }
+
+            float2 TapWeights = TapOffset ? Frac : 1.0f - Frac;
+            float Weight = TapWeights.x * TapWeights.y;
+            float4 TapMoments = PrevMomentsTexture[TapPixel];
+
+            PrevIllumination += ColorHistoryTexture[TapPixel].rgb * Weight;
+            PrevMoments += TapMoments.xy * Weight;
+            PrevLength += TapMoments.z * Weight;
+            TotalWeight += Weight;
+        }
+    }
+
+    // Disoccluded, the pixel starts over
+    if (TotalWeight < 0.01f)
+    {
+        MomentsTexture[Pixel] = float4(Moments, 1.0f, 0.0f);
+        IlluminationTexture[Pixel] = float4(Illumination, 0.0f);
+        return;
+    }
+
+    PrevIllumination /= TotalWeight;
+    PrevMoments /= TotalWeight;
+    float Length = min(PrevLength / TotalWeight + 1.0f, SVGF_MAX_HISTORY_LENGTH);
+
+    // A plain average until the history is long enough for the exponential one
+    float ColorAlpha = max(SVGF_COLOR_ALPHA, 1.0f / Length);
+    float MomentsAlpha = max(SVGF_MOMENTS_ALPHA, 1.0f / Length);
+
+    Illumination = lerp(PrevIllumination, Illumination, ColorAlpha);
+    Moments = lerp(PrevMoments, Moments, MomentsAlpha);
+
+    MomentsTexture[Pixel] = float4(Moments, Length, 0.0f);
+    IlluminationTexture[Pixel] = float4(Illumination, max(Moments.y - Moments.x * Moments.x, 0.0f));
+}
@@ -0,0 +1,26 @@
+#include "Common.hlsl"
+
+#if COMPACT_VERTEX
+struct VertexIn
+{
+    float4 PosQ : POSITION; // unorm16 inside the mesh bounds
+};
+#else
+struct VertexIn
+{
+    float3 PosL : POSITION;
+};
+#endif
+
+// Depth only, gViewProj is the cascade light matrix
+float4 VS(VertexIn vin) : SV_POSITION
+{
+#if COMPACT_VERTEX
+    float3 PosL = gPositionQuantizeMin + vin.PosQ.xyz * gPositionQuantizeScale;
+#else
+    float3 PosL = vin.PosL;
+#endif
+
+    float4 PosW = mul(float4(PosL, 1.0f), gWorld);
+    return mul(PosW, gViewProj);
+}
@@ -0,0 +1,135 @@
+#ifndef __SHADER_SHADOWS__
+#define __SHADER_SHADOWS__
+
+#include "Sampler.hlsl"
+
+#define CSM_CASCADE_COUNT 4
+
+// Receivers are pushed along the normal by this many texels, more at grazing light
+#define CSM_NORMAL_OFFSET_TEXELS 1.5f
+
+cbuffer cbCascadedShadow
+{
+    float4x4 gCascadeShadowTransforms[CSM_CASCADE_COUNT]; // world to shadow map uv and depth
+    float4 gCascadeSpheres[CSM_CASCADE_COUNT]; // xyz center, w radius
+    float4 gCascadeTexelSizes[CSM_CASCADE_COUNT]; // x world units per texel
+    float2 gShadowMapInvSize;
+    uint gCascadeCount;
+    float cbShadowPad0;
+};
+
+Texture2D CascadeShadowMap;
+
+// Point and spot light shadows, mirrors SHADOW_ATLAS_SIZE
+#define SHADOW_ATLAS_SIZE 4096
+
+// Receivers are pushed along the normal by this many texels of their face
+#define LOCAL_SHADOW_NORMAL_OFFSET_TEXELS 1.0f
+
+struct LocalShadowFace
+{
+    float4x4 ShadowTransform; // world to atlas uv and depth, before the divide by w
+    float4 UVBounds; // min xy, max xy, less the filter footprint
+    float TexelAngle; // world units per texel at unit distance from the light
+    float3 Pad;
+};
+
+StructuredBuffer<LocalShadowFace> LocalShadowFaces;
+Texture2D ShadowAtlas;
+
+// 1 when lit, 0 when fully shadowed by the directional light
+float CascadedShadowVisibility(float3 WorldPos, float3 Normal, float3 LightDir)
+{
+    // First cascade whose sphere holds the point, the spheres are already shrunk by the filter margin
+    uint Cascade = gCascadeCount;
+    for (uint i = 0; i < gCascadeCount; i++)
+    {
+        float3 Offset = WorldPos - gCascadeSpheres[i].xyz;
+        if (dot(Offset, Offset) <= gCascadeSpheres[i].w * gCascadeSpheres[i].w)
+        {
+            Cascade = i;
+            break;
+        }
+    }
+
+    if (Cascade >= gCascadeCount)
+    {
+        return 1.0f;
+    }
+
+    float NoL = saturate(dot(Normal, LightDir));
+    float3 ReceiverPos = WorldPos + Normal * gCascadeTexelSizes[Cascade].x * CSM_NORMAL_OFFSET_TEXELS * (1.0f - NoL);
+
+    float4 ShadowPos = mul(float4(ReceiverPos, 1.0f), gCascadeShadowTransforms[Cascade]);
+    float2 UV = ShadowPos.xy;
+    float Depth = ShadowPos.z;
+
+    // 3x3 PCF, each tap is a bilinear comparison
+    float Visibility = 0.0f;
+    [unroll]
+    for (int y = -1; y <= 1; y++)
+    {
+        [unroll]
+        for (int x = -1; x <= 1; x++)
+        {
+            float2 Offset = float2(x, y) * gShadowMapInvSize;
+            Visibility += CascadeShadowMap.SampleCmpLevelZero(gsamShadow, UV + Offset, Depth);
+        }
+    }
+
+    return Visibility / 9.0f;
+}
+
+// 1 when lit, 0 when fully shadowed. FirstFace is the ShadowMapIdx of the light, point lights have six faces in the
+// order of ShadowAtlas::GetPointLightFaceViewProj.
+float LocalShadowVisibility(float3 WorldPos, float3 Normal, float3 LightPos, uint FirstFace, bool bPointLight)
+{
+    float3 FromLight = WorldPos - LightPos;
+
+    uint Face = FirstFace;
+    if (bPointLight)
+    {
+        float3 AbsDir = abs(FromLight);
+        if (AbsDir.x >= AbsDir.y && AbsDir.x >= AbsDir.z)
+        {
+            Face += FromLight.x >= 0.0f ? 0 : 1;
+        }
+        else if (AbsDir.y >= AbsDir.z)
+        {
+            Face += FromLight.y >= 0.0f ? 2 : 3;
+        }
+        else
+        {
+            Face += FromLight.z >= 0.0f ? 4 : 5;
+        }
+    }
+
+    LocalShadowFace ShadowFace = LocalShadowFaces[Face];
+
+    // Texels grow with the distance from the light
+    float3 LightDir = normalize(-FromLight);
+    float NoL = saturate(dot(Normal, LightDir));
+    float TexelSize = ShadowFace.TexelAngle * length(FromLight);
+    float3 ReceiverPos = WorldPos + Normal * TexelSize * LOCAL_SHADOW_NORMAL_OFFSET_TEXELS * (1.0f - NoL);
+
+    float4 ShadowPos = mul(float4(ReceiverPos, 1.0f), ShadowFace.ShadowTransform);
+    ShadowPos.xyz /= ShadowPos.w;
+
+    // 3x3 PCF kept inside the tile of the face
+    float Visibility = 0.0f;
+    [unroll]
+    for (int y = -1; y <= 1; y++)
+    {
+        [unroll]
+        for (int x = -1; x <= 1; x++)
+        {
+            float2 UV = ShadowPos.xy + float2(x, y) / SHADOW_ATLAS_SIZE;
+            UV = clamp(UV, ShadowFace.UVBounds.xy, ShadowFace.UVBounds.zw);
+            Visibility += ShadowAtlas.SampleCmpLevelZero(gsamShadow, UV, ShadowPos.z);
+        }
+    }
+
+    return Visibility / 9.0f;
+}
+
+#endif
@@ -1,4 +1,145 @@
-[numthreads(1, 1, 1)]
-void CS( uint3 DTid : SV_DispatchThreadID )
+#include "Common.hlsl"
+
+// TAA resolve, the same steps as TemporalAA::ResolvePixel
+
+// Mirrors TemporalAA.h
+#define TAA_CURRENT_FRAME_WEIGHT 0.1f
+#define TAA_MOTION_FRAME_WEIGHT 0.2f
+#define TAA_VARIANCE_CLIP_GAMMA 1.0f
+
+cbuffer cbTemporalAA
 {
-}
\ No newline at end of file
+    uint gHistoryValid;
+    float3 cbTemporalAAPad;
+};
+
+Texture2D ColorTexture;
+Texture2D HistoryTexture;
+Texture2D VelocityGbuffer;
+RWTexture2D<float4> ResolvedTexture;
+
+float3 RGBToYCoCg(float3 Color)
+{
+    return float3(
+        0.25f * Color.r + 0.5f * Color.g + 0.25f * Color.b,
+        0.5f * Color.r - 0.5f * Color.b,
+        -0.25f * Color.r + 0.5f * Color.g - 0.25f * Color.b);
+}
+
+float3 YCoCgToRGB(float3 Color)
+{
+    return float3(
+        Color.x + Color.y - Color.z,
+        Color.x + Color.z,
+        Color.x - Color.y - Color.z);
+}
+
+// Moves Color along the line to the box center until it is inside the box
+float3 ClipToAABB(float3 Color, float3 BoxMin, float3 BoxMax)
+{
+    float3 Center = 0.5f * (BoxMax + BoxMin);
+    float3 Extents = 0.5f * (BoxMax - BoxMin) + 1e-5f;
+
+    float3 Offset = Color - Center;
+    float3 Units = abs(Offset / Extents);
+    float MaxUnit = max(Units.x, max(Units.y, Units.z));
+
+    return MaxUnit > 1.0f ? Center + Offset / MaxUnit : Color;
+}
+
+// Catmull-Rom filter from five bilinear fetches, the corner texels are dropped
+float3 SampleHistory(float2 UV, float2 Size)
+{
+    float2 SamplePos = UV * Size;
+    float2 TexPos1 = floor(SamplePos - 0.5f) + 0.5f;
+    float2 F = SamplePos - TexPos1;
+
+    float2 W0 = F * (-0.5f + F * (1.0f - 0.5f * F));
+    float2 W1 = 1.0f + F * F * (-2.5f + 1.5f * F);
+    float2 W2 = F * (0.5f + F * (2.0f - 1.5f * F));
+    float2 W3 = F * F * (-0.5f + 0.5f * F);
+
+    float2 W12 = W1 + W2;
+    float2 TexPos0 = (TexPos1 - 1.0f) / Size;
+    float2 TexPos3 = (TexPos1 + 2.0f) / Size;
+    float2 TexPos12 = (TexPos1 + W2 / W12) / Size;
+
+    float3 Result = 0.0f;
+    Result += HistoryTexture.SampleLevel(gsamLinearClamp, float2(TexPos12.x, TexPos0.y), 0).rgb * W12.x * W0.y;
+    Result += HistoryTexture.SampleLevel(gsamLinearClamp, float2(TexPos0.x, TexPos12.y), 0).rgb * W0.x * W12.y;
+    Result += HistoryTexture.SampleLevel(gsamLinearClamp, float2(TexPos12.x, TexPos12.y), 0).rgb * W12.x * W12.y;
+    Result += HistoryTexture.SampleLevel(gsamLinearClamp, float2(TexPos3.x, TexPos12.y), 0).rgb * W3.x * W12.y;
+    Result += HistoryTexture.SampleLevel(gsamLinearClamp, float2(TexPos12.x, TexPos3.y), 0).rgb * W12.x * W3.y;
+
+    float TotalWeight = W12.x * W0.y + W0.x * W12.y + W12.x * W12.y + W3.x * W12.y + W12.x * W3.y;
+
+    // The negative lobes can ring below zero
+    return max(Result / TotalWeight, 0.0f);
+}
+
+[numthreads(8, 8, 1)]
+void CS(uint3 DTid : SV_DispatchThreadID)
+{
+    uint Width, Height;
+    ColorTexture.GetDimensions(Width, Height);
+    if (DTid.x >= Width || DTid.y >= Height)
+    {
+        return;
+    }
+
+    int2 Pixel = int2(DTid.xy);
+    int2 MaxPixel = int2(Width, Height) - 1;
+    float2 Size = float2(Width, Height);
+
+    float3 CurrentColor = ColorTexture[Pixel].rgb;
+
+    float2 Velocity = VelocityGbuffer[Pixel].xy;
+    float2 UV = (float2(Pixel) + 0.5f) / Size;
+    float2 PrevUV = UV - Velocity;
+
+    // Nothing to reproject from off screen
+    if (!gHistoryValid || any(PrevUV < 0.0f) || any(PrevUV > 1.0f))
+    {
+        ResolvedTexture[Pixel] = float4(CurrentColor, 1.0f);
+        return;
+    }
+
+    // Mean and variance of the neighbourhood
+    float3 Moment1 = 0.0f;
+    float3 Moment2 = 0.0f;
+    float3 NeighbourMin = 1e30f;
+    float3 NeighbourMax = -1e30f;
+    [unroll]
+    for (int y = -1; y <= 1; y++)
+    {
+        [unroll]
+        for (int x = -1; x <= 1; x++)
+        {
+            float3 Neighbour = RGBToYCoCg(ColorTexture[clamp(Pixel + int2(x, y), 0, MaxPixel)].rgb);
+            Moment1 += Neighbour;
+            Moment2 += Neighbour * Neighbour;
+            NeighbourMin = min(NeighbourMin, Neighbour);
+            NeighbourMax = max(NeighbourMax, Neighbour);
+        }
+    }
+
+    float3 Mean = Moment1 / 9.0f;
+    float3 Sigma = sqrt(max(Moment2 / 9.0f - Mean * Mean, 0.0f));
+
+    float3 BoxMin = max(Mean - TAA_VARIANCE_CLIP_GAMMA * Sigma, NeighbourMin);
+    float3 BoxMax = min(Mean + TAA_VARIANCE_CLIP_GAMMA * Sigma, NeighbourMax);
+
+    float3 HistoryColor = ClipToAABB(RGBToYCoCg(SampleHistory(PrevUV, Size)), BoxMin, BoxMax);
+    float3 CurrentYCoCg = RGBToYCoCg(CurrentColor);
+
+    float MotionPixels = length(Velocity * Size);
+    float BlendWeight = TAA_CURRENT_FRAME_WEIGHT + TAA_MOTION_FRAME_WEIGHT * min(MotionPixels, 1.0f);
+
+    // Weighting by inverse luma keeps single bright samples from flickering
+    float CurrentWeight = BlendWeight / (1.0f + max(CurrentYCoCg.x, 0.0f));
+    float HistoryWeight = (1.0f - BlendWeight) / (1.0f + max(HistoryColor.x, 0.0f));
+
+    float3 Resolved = (CurrentYCoCg * CurrentWeight + HistoryColor * HistoryWeight) / (CurrentWeight + HistoryWeight);
+
+    ResolvedTexture[Pixel] = float4(max(YCoCgToRGB(Resolved), 0.0f), 1.0f);
+}
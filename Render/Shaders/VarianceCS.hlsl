@@ -1,4 +1,67 @@
-[numthreads(1, 1, 1)]
-void CS( uint3 DTid : SV_DispatchThreadID )
+#include "SVGFCommon.hlsl"
+
+// Variance of the accumulated illumination, the same steps as SVGFDenoiser::EstimateVariance. Pixels with a short
+// history take their moments from the surface around them, the temporal ones are too noisy yet.
+
+Texture2D IlluminationTexture; // illumination in rgb, temporal variance in a
+Texture2D MomentsTexture; // moments in xy, history length in z
+Texture2D SurfaceTexture; // normal in xyz, linear depth in w
+
+RWTexture2D<float4> FilteredTexture; // illumination in rgb, variance in a
+
+[numthreads(8, 8, 1)]
+void CS(uint3 DTid : SV_DispatchThreadID)
 {
-}
\ No newline at end of file
+    uint Width, Height;
+    IlluminationTexture.GetDimensions(Width, Height);
+    if (DTid.x >= Width || DTid.y >= Height)
+    {
+        return;
+    }
+
+    int2 Pixel = int2(DTid.xy);
+    int2 Size = int2(Width, Height);
+
+    float4 Surface = SurfaceTexture[Pixel];
+    float HistoryLength = MomentsTexture[Pixel].z;
+
+    if (IsBackground(Surface.xyz) || HistoryLength >= SVGF_VARIANCE_HISTORY_FRAMES)
+    {
+        FilteredTexture[Pixel] = IlluminationTexture[Pixel];
+        return;
+    }
+
+    float2 DepthGradient = GetDepthGradient(SurfaceTexture, Pixel, Size);
+
+    float3 SumIllumination = 0.0f;
+    float2 SumMoments = 0.0f;
+    float SumWeight = 0.0f;
+
+    for (int y = -3; y <= 3; y++)
+    {
+        for (int x = -3; x <= 3; x++)
+        {
+            int2 SamplePixel = Pixel + int2(x, y);
+            if (any(SamplePixel < 0) || any(SamplePixel >= Size))
+            {
+                continue;
+            }
+
+            float4 SampleSurface = SurfaceTexture[SamplePixel];
+            float Weight = NormalWeight(Surface.xyz, SampleSurface.xyz)
+                * DepthWeight(Surface.w, SampleSurface.w, DepthGradient, float2(x, y));
+
+            SumIllumination += IlluminationTexture[SamplePixel].rgb * Weight;
+            SumMoments += MomentsTexture[SamplePixel].xy * Weight;
+            SumWeight += Weight;
+        }
+    }
+
+    SumIllumination /= SumWeight;
+    SumMoments /= SumWeight;
+
+    // Scaled up while the history is short, the first frames are the noisiest
+    float Variance = max(SumMoments.y - SumMoments.x * SumMoments.x, 0.0f) * SVGF_VARIANCE_HISTORY_FRAMES / HistoryLength;
+
+    FilteredTexture[Pixel] = float4(SumIllumination, Variance);
+}
@@ -36,6 +36,10 @@ echo [EnviromentCDF - GlobalEdgeCDFCS] CS...
 "%FXC%" /T cs_5_0 /E CS        "%SHADER_DIR%GlobalEdgeCDF.hlsl" /Fo "%OUTDIR%\GlobalEdgeCDFCS.cso"
 if errorlevel 1 goto :error
 
+echo [SVGFTemporalAccumCS] CS...
+"%FXC%" /T cs_5_0 /E CS               "%SHADER_DIR%SVGFTemporalAccumCS.hlsl" /Fo "%OUTDIR%\SVGFTemporalAccumCS.cso"
+if errorlevel 1 goto :error
+
 echo [VarianceCS] CS...
 "%FXC%" /T cs_5_0 /E CS               "%SHADER_DIR%VarianceCS.hlsl"      /Fo "%OUTDIR%\VarianceCS.cso"
 if errorlevel 1 goto :error
@@ -0,0 +1,119 @@
+#include "TestFramework.h"
+#include "../src/Actor/Actor.h"
+#include "../src/Utility/JobSystem.h"
+#include <set>
+#include <thread>
+
+namespace
+{
+	const uint32_t TEST_WORKER_COUNT = 3;
+	const float TEST_DELTA_SECONDS = 1.0f / 60.0f;
+
+	// Counts its ticks. A serial actor given the parallel ones checks that each of them has ticked this frame before it.
+	class TickCountingActor : public Actor
+	{
+	public:
+		TickCountingActor(const std::string& name, const std::vector<TickCountingActor*>* inParallelActors = nullptr)
+			:Actor(name), parallelActors(inParallelActors)
+		{
+			rootComponent = AddComponent<Component>();
+		}
+
+		void Tick(float DeltaSeconds) override
+		{
+			tickCount++;
+			threadId = std::this_thread::get_id();
+			errorCount += DeltaSeconds != TEST_DELTA_SECONDS;
+
+			if (parallelActors)
+			{
+				for (const TickCountingActor* actor : *parallelActors)
+				{
+					errorCount += actor->tickCount != tickCount;
+				}
+			}
+
+			// Only its own flag, the way an actor leaves the parallel ticks from inside Tick
+			if (bStopParallelOnTick)
+			{
+				SetTickInParallel(false);
+				bStopParallelOnTick = false;
+			}
+		}
+
+	public:
+		uint32_t tickCount = 0;
+		uint32_t errorCount = 0;
+		std::thread::id threadId;
+		bool bStopParallelOnTick = false;
+
+	private:
+		const std::vector<TickCountingActor*>* parallelActors;
+	};
+}
+
+// Flagged actors tick on the workers, the others after them on the calling thread. Every actor ticks once per frame,
+// also one that leaves the parallel ticks during its tick.
+TEST_CASE(Actor_TickActorsOncePerFrame)
+{
+	JobSystem::Get().Initialize(TEST_WORKER_COUNT);
+
+	std::vector<std::unique_ptr<Actor>> actors;
+	std::vector<TickCountingActor*> parallelActors, serialActors;
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		const bool bParallel = i % 50 != 0;
+		auto actor = std::make_unique<TickCountingActor>("Actor" + std::to_string(i), bParallel ? nullptr : &parallelActors);
+		actor->SetTickInParallel(bParallel);
+		(bParallel ? parallelActors : serialActors).push_back(actor.get());
+		actors.push_back(std::move(actor));
+	}
+
+	// Leaves on the first frame, a serial actor from the second one
+	TickCountingActor* leavingActor = parallelActors.back();
+	leavingActor->bStopParallelOnTick = true;
+	parallelActors.pop_back();
+
+	const std::thread::id mainThreadId = std::this_thread::get_id();
+	std::set<std::thread::id> parallelThreadIds;
+	std::vector<Actor*> tickActors;
+	uint32_t errorCount = 0;
+	const uint32_t frameCount = 30;
+	for (uint32_t frame = 1; frame <= frameCount; frame++)
+	{
+		Actor::TickActors(actors, TEST_DELTA_SECONDS, tickActors);
+
+		for (const TickCountingActor* actor : parallelActors)
+		{
+			errorCount += actor->tickCount != frame;
+			parallelThreadIds.insert(actor->threadId);
+		}
+		for (const TickCountingActor* actor : serialActors)
+		{
+			errorCount += actor->tickCount != frame || actor->threadId != mainThreadId || actor->errorCount != 0;
+		}
+		errorCount += leavingActor->tickCount != frame;
+		errorCount += frame > 1 && leavingActor->threadId != mainThreadId;
+	}
+
+	std::printf("  %zu parallel actors ticked on %zu threads\n", parallelActors.size(), parallelThreadIds.size());
+	CHECK(errorCount == 0);
+	CHECK(parallelThreadIds.size() > 1);
+	CHECK(!leavingActor->IsTickInParallel());
+	CHECK(tickActors.size() == actors.size());
+
+	JobSystem::Get().Shutdown();
+}
+
+// Attached actors move each other, attaching takes both out of the parallel ticks
+TEST_CASE(Actor_AttachingTicksSerially)
+{
+	TickCountingActor parent("Parent"), child("Child"), other("Other");
+	parent.SetTickInParallel(true);
+	child.SetTickInParallel(true);
+	other.SetTickInParallel(true);
+
+	child.AttachToComponent(parent.GetRootComponent());
+	CHECK(!parent.IsTickInParallel() && !child.IsTickInParallel());
+	CHECK(other.IsTickInParallel());
+}
@@ -0,0 +1,224 @@
+#include "TestFramework.h"
+#include "../src/Texture/BCCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	struct FormatCase
+	{
+		DXGI_FORMAT format;
+		const char* name;
+		uint32_t channelCount; // channels the format stores
+		float endpointError;   // worst error on a block of one or two colors, from the endpoint precision
+		double minPSNR;        // at EBCQuality::Normal on the noisy gradients below
+	};
+
+	// Thresholds sit about 2 dB under what the encoders reach, BC6H is measured on log2 luminance-like values
+	const FormatCase FormatCases[] = {
+		{ DXGI_FORMAT_BC1_UNORM, "BC1", 3, 4.0f, 34.0 },  // 5:6:5 endpoints
+		{ DXGI_FORMAT_BC3_UNORM, "BC3", 4, 4.0f, 35.0 },  // 5:6:5 color, 8 bit alpha
+		{ DXGI_FORMAT_BC4_UNORM, "BC4", 1, 1.0f, 43.0 },
+		{ DXGI_FORMAT_BC5_UNORM, "BC5", 2, 1.0f, 43.0 },
+		{ DXGI_FORMAT_BC7_UNORM, "BC7", 4, 2.0f, 39.0 },  // mode 6, 7 bit endpoints with one p-bit for all channels
+		{ DXGI_FORMAT_BC6H_UF16, "BC6H", 3, 0.0f, 33.0 }, // relative, checked separately
+	};
+
+	// A linear gradient per channel with a little noise, roughly what a block of a photo or a painted texture holds.
+	// BC6H gets the same shape mapped to an exponential HDR range.
+	void MakeBlock(DXGI_FORMAT format, std::mt19937& random, XMFLOAT4A outPixels[16])
+	{
+		float base[4];
+		float slope[4];
+		for (int c = 0; c < 4; c++)
+		{
+			base[c] = 60.0f + random() % 130;
+			slope[c] = (float)((int)(random() % 40) - 20);
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			const float t = ((i % 4) + (i / 4)) / 6.0f;
+			float value[4];
+			for (int c = 0; c < 4; c++)
+			{
+				const float noise = (float)(random() % 9) - 4.0f;
+				value[c] = std::clamp(base[c] + slope[c] * t * 3.0f + noise, 0.0f, 255.0f);
+			}
+
+			if (format == DXGI_FORMAT_BC6H_UF16)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					value[c] = std::exp((value[c] - 128.0f) / 20.0f);
+				}
+				value[3] = 1.0f;
+			}
+
+			outPixels[i] = XMFLOAT4A(value[0], value[1], value[2], value[3]);
+		}
+	}
+
+	double MeasurePSNR(const FormatCase& formatCase, EBCQuality quality, uint32_t blockCount, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		const bool bFloat = BCCodec::IsFloatFormat(formatCase.format);
+
+		double squaredErrorSum = 0.0;
+		double peak = bFloat ? 0.0 : 255.0;
+		uint64_t sampleCount = 0;
+		for (uint32_t b = 0; b < blockCount; b++)
+		{
+			XMFLOAT4A pixels[16];
+			XMFLOAT4A decoded[16];
+			uint8_t block[16];
+			MakeBlock(formatCase.format, random, pixels);
+
+			BCCodec::EncodeBlock(formatCase.format, pixels, quality, block);
+			CHECK(BCCodec::DecodeBlock(formatCase.format, block, decoded));
+
+			for (int i = 0; i < 16; i++)
+			{
+				for (uint32_t c = 0; c < formatCase.channelCount; c++)
+				{
+					double source = (&pixels[i].x)[c];
+					double result = (&decoded[i].x)[c];
+					if (bFloat)
+					{
+						source = std::log2(source + 1e-3);
+						result = std::log2(result + 1e-3);
+						peak = (std::max)(peak, std::abs(source));
+					}
+					squaredErrorSum += (source - result) * (source - result);
+					sampleCount++;
+				}
+			}
+		}
+
+		const double mse = squaredErrorSum / sampleCount;
+		return 10.0 * std::log10(peak * peak / (std::max)(mse, 1e-12));
+	}
+}
+
+TEST_CASE(BCCodec_BlockSizes)
+{
+	CHECK(BCCodec::GetBlockSize(DXGI_FORMAT_BC1_UNORM) == 8);
+	CHECK(BCCodec::GetBlockSize(DXGI_FORMAT_BC4_UNORM) == 8);
+	CHECK(BCCodec::GetBlockSize(DXGI_FORMAT_BC3_UNORM) == 16);
+	CHECK(BCCodec::GetBlockSize(DXGI_FORMAT_BC5_UNORM) == 16);
+	CHECK(BCCodec::GetBlockSize(DXGI_FORMAT_BC6H_UF16) == 16);
+	CHECK(BCCodec::GetBlockSize(DXGI_FORMAT_BC7_UNORM) == 16);
+
+	CHECK(BCCodec::IsFloatFormat(DXGI_FORMAT_BC6H_UF16));
+	CHECK(!BCCodec::IsFloatFormat(DXGI_FORMAT_BC7_UNORM));
+	CHECK(!BCCodec::IsSupported(DXGI_FORMAT_R8G8B8A8_UNORM));
+}
+
+// A single color block round trips to within the endpoint precision
+TEST_CASE(BCCodec_SolidBlocksRoundTrip)
+{
+	const XMFLOAT4A colors[] = {
+		XMFLOAT4A(0.0f, 0.0f, 0.0f, 255.0f),
+		XMFLOAT4A(255.0f, 255.0f, 255.0f, 255.0f),
+		XMFLOAT4A(200.0f, 64.0f, 17.0f, 128.0f),
+	};
+
+	for (const FormatCase& formatCase : FormatCases)
+	{
+		if (BCCodec::IsFloatFormat(formatCase.format))
+		{
+			continue;
+		}
+
+		for (const XMFLOAT4A& color : colors)
+		{
+			XMFLOAT4A pixels[16];
+			std::fill(pixels, pixels + 16, color);
+
+			XMFLOAT4A decoded[16];
+			uint8_t block[16];
+			BCCodec::EncodeBlock(formatCase.format, pixels, EBCQuality::Normal, block);
+			CHECK(BCCodec::DecodeBlock(formatCase.format, block, decoded));
+
+			for (int i = 0; i < 16; i++)
+			{
+				for (uint32_t c = 0; c < formatCase.channelCount; c++)
+				{
+					CHECK_NEAR((&decoded[i].x)[c], (&color.x)[c], formatCase.endpointError);
+				}
+			}
+		}
+	}
+
+	// Mode 11 keeps the top 10 bits of the half float endpoints, the 4 bit indices interpolate between them
+	XMFLOAT4A pixels[16];
+	std::fill(pixels, pixels + 16, XMFLOAT4A(0.25f, 3.0f, 40.0f, 1.0f));
+	XMFLOAT4A decoded[16];
+	uint8_t block[16];
+	BCCodec::EncodeBlock(DXGI_FORMAT_BC6H_UF16, pixels, EBCQuality::Normal, block);
+	CHECK(BCCodec::DecodeBlock(DXGI_FORMAT_BC6H_UF16, block, decoded));
+	CHECK_NEAR(decoded[5].x, 0.25f, 0.25f * 0.02f);
+	CHECK_NEAR(decoded[5].y, 3.0f, 3.0f * 0.02f);
+	CHECK_NEAR(decoded[5].z, 40.0f, 40.0f * 0.02f);
+}
+
+// Two colors, one per half of the block, the endpoints must hit both
+TEST_CASE(BCCodec_TwoColorBlocksRoundTrip)
+{
+	XMFLOAT4A pixels[16];
+	for (int i = 0; i < 16; i++)
+	{
+		pixels[i] = (i % 4) < 2 ? XMFLOAT4A(10.0f, 20.0f, 30.0f, 255.0f) : XMFLOAT4A(240.0f, 200.0f, 160.0f, 255.0f);
+	}
+
+	for (const FormatCase& formatCase : FormatCases)
+	{
+		if (BCCodec::IsFloatFormat(formatCase.format))
+		{
+			continue;
+		}
+
+		XMFLOAT4A decoded[16];
+		uint8_t block[16];
+		BCCodec::EncodeBlock(formatCase.format, pixels, EBCQuality::Normal, block);
+		CHECK(BCCodec::DecodeBlock(formatCase.format, block, decoded));
+
+		for (int i = 0; i < 16; i++)
+		{
+			for (uint32_t c = 0; c < (std::min)(formatCase.channelCount, 3u); c++)
+			{
+				CHECK_NEAR((&decoded[i].x)[c], (&pixels[i].x)[c], formatCase.endpointError);
+			}
+		}
+	}
+}
+
+// 2000 noisy gradient blocks per format, each quality level must reach the PSNR of the format
+// and a higher level must not be clearly worse than a lower one
+TEST_CASE(BCCodec_RoundTripPSNR)
+{
+	const EBCQuality qualities[] = { EBCQuality::Fast, EBCQuality::Normal, EBCQuality::High };
+	const char* qualityNames[] = { "fast", "normal", "high" };
+
+	for (const FormatCase& formatCase : FormatCases)
+	{
+		double psnr[3];
+		for (int q = 0; q < 3; q++)
+		{
+			psnr[q] = MeasurePSNR(formatCase, qualities[q], 2000, 1);
+		}
+
+		std::printf("  %-4s PSNR %s %.2f dB, %s %.2f dB, %s %.2f dB\n", formatCase.name,
+			qualityNames[0], psnr[0], qualityNames[1], psnr[1], qualityNames[2], psnr[2]);
+
+		// Fast only takes the bounding box endpoints and may lose up to 1.5 dB
+		CHECK(psnr[0] >= formatCase.minPSNR - 1.5);
+		CHECK(psnr[1] >= formatCase.minPSNR);
+		CHECK(psnr[2] >= formatCase.minPSNR);
+		CHECK(psnr[1] >= psnr[0] - 0.5);
+		CHECK(psnr[2] >= psnr[1] - 0.5);
+	}
+}
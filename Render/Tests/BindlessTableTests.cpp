@@ -0,0 +1,115 @@
+#include "TestFramework.h"
+#include "../src/Resource/BindlessTable.h"
+#include "../src/Resource/DeferredDeletionQueue.h"
+#include "../src/Material/BindlessMaterial.h"
+#include <set>
+
+namespace
+{
+	// Index 0 stands in for NullTex like Render::GetBindlessTextureIndex
+	struct FakeTextureIndices
+	{
+		std::unordered_map<std::string, uint32_t> indices;
+		uint32_t lookupCount = 0;
+
+		uint32_t operator()(const std::string& textureName)
+		{
+			lookupCount++;
+			auto Iter = indices.find(textureName);
+			return Iter != indices.end() ? Iter->second : 0;
+		}
+	};
+
+	const std::vector<std::string> DefaultTextureSlots = { "BaseColorTexture", "NormalTexture", "MetallicTexture", "RoughnessTexture" };
+}
+
+// Without a descriptor heap only the indices are managed
+TEST_CASE(BindlessTable_RegistersIndicesWithoutHeap)
+{
+	BindlessTable table(8);
+	const D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor = { 0 };
+
+	std::set<uint32_t> indices;
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		const uint32_t index = table.Register(srcDescriptor);
+		CHECK(index < table.GetCapacity());
+		CHECK(table.IsRegistered(index));
+		indices.insert(index);
+	}
+	CHECK(indices.size() == 8);
+	CHECK(table.GetRegisteredCount() == 8);
+
+	table.Unregister(3);
+	CHECK(!table.IsRegistered(3));
+	CHECK(table.Register(srcDescriptor) == 3);
+
+	// Views that never got an index release InvalidIndex
+	table.Unregister(BindlessTable::InvalidIndex);
+	CHECK(table.GetRegisteredCount() == 8);
+	CHECK(!table.IsRegistered(BindlessTable::InvalidIndex));
+}
+
+// A destroyed view keeps its index until the frames that may still read it are done
+TEST_CASE(BindlessTable_DeferredUnregisterWaitsForFence)
+{
+	BindlessTable table(16);
+	DeferredDeletionQueue deletionQueue;
+
+	const uint32_t index = table.Register({ 0 });
+	deletionQueue.Enqueue(&table, index, nullptr, 0);
+	deletionQueue.Submit(5);
+
+	deletionQueue.Retire(4);
+	CHECK(table.IsRegistered(index));
+	CHECK(table.Register({ 0 }) != index);
+
+	deletionQueue.Retire(5);
+	CHECK(!table.IsRegistered(index));
+	CHECK(table.Register({ 0 }) == index);
+}
+
+TEST_CASE(BindlessMaterial_PacksSlotsInOrder)
+{
+	FakeTextureIndices textureIndices;
+	textureIndices.indices = { { "Brick_Albedo", 17 }, { "Brick_Normal", 4 }, { "Brick_Metallic", 250 }, { "Brick_Roughness", 9 } };
+
+	std::unordered_map<std::string, std::string> textureMap = {
+		{ "RoughnessTexture", "Brick_Roughness" },
+		{ "BaseColorTexture", "Brick_Albedo" },
+		{ "MetallicTexture", "Brick_Metallic" },
+		{ "NormalTexture", "Brick_Normal" },
+		{ "UnusedTexture", "Brick_Albedo" },
+	};
+
+	uint32_t packed[MATERIAL_BINDLESS_TEXTURE_SLOTS] = { 0 };
+	CHECK(BindlessMaterial::ResolveTextureIndices(DefaultTextureSlots, textureMap, std::ref(textureIndices), packed));
+	CHECK(packed[0] == 17 && packed[1] == 4 && packed[2] == 250 && packed[3] == 9);
+
+	// Nothing changed, the constant buffer can stay
+	CHECK(!BindlessMaterial::ResolveTextureIndices(DefaultTextureSlots, textureMap, std::ref(textureIndices), packed));
+
+	// A streamed texture got a new view, only its slot changes
+	textureIndices.indices["Brick_Normal"] = 40;
+	CHECK(BindlessMaterial::ResolveTextureIndices(DefaultTextureSlots, textureMap, std::ref(textureIndices), packed));
+	CHECK(packed[0] == 17 && packed[1] == 40 && packed[2] == 250 && packed[3] == 9);
+}
+
+TEST_CASE(BindlessMaterial_MissingAndExtraSlots)
+{
+	FakeTextureIndices textureIndices;
+	textureIndices.indices = { { "Albedo", 3 } };
+
+	// A slot without a texture asks for "" and gets the null texture
+	const std::unordered_map<std::string, std::string> textureMap = { { "BaseColorTexture", "Albedo" } };
+	uint32_t packed[MATERIAL_BINDLESS_TEXTURE_SLOTS] = { 7, 7, 7, 7 };
+	CHECK(BindlessMaterial::ResolveTextureIndices({ "BaseColorTexture", "NormalTexture" }, textureMap, std::ref(textureIndices), packed));
+	CHECK(packed[0] == 3 && packed[1] == 0);
+	CHECK(packed[2] == 7 && packed[3] == 7);
+
+	// Slots past the uint4 are never looked up
+	textureIndices.lookupCount = 0;
+	const std::vector<std::string> tooManySlots = { "A", "B", "C", "D", "E", "F" };
+	BindlessMaterial::ResolveTextureIndices(tooManySlots, textureMap, std::ref(textureIndices), packed);
+	CHECK(textureIndices.lookupCount == MATERIAL_BINDLESS_TEXTURE_SLOTS);
+}
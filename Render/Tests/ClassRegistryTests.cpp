@@ -0,0 +1,243 @@
+#include "TestFramework.h"
+#include "../src/Actor/Actor.h"
+#include "../src/World/ClassRegistry.h"
+
+namespace
+{
+	// Stand-ins for the engine classes, with the same DECLARE_CLASS layout as StaticMeshActor and the lights
+	class TestMeshComponent : public Component
+	{
+		DECLARE_CLASS(TestMeshComponent, Component)
+
+	public:
+		int meshIndex = 1;
+	};
+
+	class TestOtherComponent : public Component
+	{
+		DECLARE_CLASS(TestOtherComponent, Component)
+	};
+
+	class TestMeshActor : public Actor
+	{
+		DECLARE_CLASS(TestMeshActor, Actor)
+
+	public:
+		TestMeshActor(const std::string& name) : Actor(name)
+		{
+			rootComponent = AddComponent<TestMeshComponent>();
+			AddComponent<TestOtherComponent>();
+		}
+	};
+
+	class TestLightActor : public Actor
+	{
+		DECLARE_CLASS(TestLightActor, Actor)
+
+	public:
+		TestLightActor(const std::string& name) : Actor(name)
+		{
+			rootComponent = AddComponent<TestMeshComponent>();
+		}
+
+		virtual bool IsDrawMesh() override { return false; }
+
+		float intensity = 1.0f;
+	};
+
+	class TestPointLightActor : public TestLightActor
+	{
+		DECLARE_CLASS(TestPointLightActor, TestLightActor)
+
+	public:
+		using TestLightActor::TestLightActor;
+	};
+
+	// What World::AddActor does, without the rest of the world
+	struct TestWorld
+	{
+		std::vector<std::unique_ptr<Actor>> actors;
+		ClassRegistry classRegistry;
+
+		template<typename T>
+		T* AddActor(const std::string& name)
+		{
+			actors.push_back(std::make_unique<T>(name));
+			T* result = static_cast<T*>(actors.back().get());
+			result->AddToRegistry(classRegistry);
+			return result;
+		}
+	};
+
+	// One light per 100 actors, like the test scenes
+	void FillWorld(TestWorld& world, uint32_t actorCount)
+	{
+		world.actors.reserve(actorCount);
+		for (uint32_t i = 0; i < actorCount; i++)
+		{
+			if (i % 100 == 0)
+			{
+				world.AddActor<TestPointLightActor>("Light");
+			}
+			else
+			{
+				world.AddActor<TestMeshActor>("Mesh");
+			}
+		}
+	}
+
+	// The per-frame gather of Render before the class lists: a dynamic_cast per actor and per component
+	long GatherWithDynamicCast(const std::vector<std::unique_ptr<Actor>>& actors)
+	{
+		long sum = 0;
+		for (const auto& actor : actors)
+		{
+			if (!actor->IsDrawMesh())
+			{
+				continue;
+			}
+
+			std::vector<TestMeshComponent*> meshComponents;
+			for (Component* component : actor->GetComponents())
+			{
+				if (TestMeshComponent* meshComponent = dynamic_cast<TestMeshComponent*>(component))
+				{
+					meshComponents.push_back(meshComponent);
+				}
+			}
+			for (TestMeshComponent* meshComponent : meshComponents)
+			{
+				sum += meshComponent->meshIndex;
+			}
+		}
+
+		std::vector<TestLightActor*> lights;
+		for (const auto& actor : actors)
+		{
+			if (TestLightActor* light = dynamic_cast<TestLightActor*>(actor.get()))
+			{
+				lights.push_back(light);
+			}
+		}
+		for (TestLightActor* light : lights)
+		{
+			sum += (long)light->intensity;
+		}
+		return sum;
+	}
+
+	long GatherWithClassLists(const ClassRegistry& classRegistry)
+	{
+		long sum = 0;
+		for (TestMeshComponent* meshComponent : classRegistry.Get<TestMeshComponent>())
+		{
+			if (meshComponent->GetOwner()->IsDrawMesh())
+			{
+				sum += meshComponent->meshIndex;
+			}
+		}
+
+		for (TestLightActor* light : classRegistry.Get<TestLightActor>())
+		{
+			sum += (long)light->intensity;
+		}
+		return sum;
+	}
+}
+
+// Every object is listed under its own class and each base class, in the order it was added
+TEST_CASE(ClassRegistry_ListsObjectsUnderEveryBaseClass)
+{
+	TestWorld world;
+	TestMeshActor* mesh = world.AddActor<TestMeshActor>("Mesh");
+	TestPointLightActor* light = world.AddActor<TestPointLightActor>("Light");
+	TestLightActor* otherLight = world.AddActor<TestLightActor>("OtherLight");
+
+	const ClassRegistry& registry = world.classRegistry;
+	CHECK(registry.Get<Actor>().size() == 3);
+	CHECK(registry.Get<Actor>()[0] == mesh && registry.Get<Actor>()[1] == light && registry.Get<Actor>()[2] == otherLight);
+	CHECK(registry.Get<TestMeshActor>().size() == 1);
+	CHECK(registry.Get<TestLightActor>().size() == 2 && registry.Get<TestLightActor>()[0] == light);
+	CHECK(registry.Get<TestPointLightActor>().size() == 1 && registry.Get<TestPointLightActor>()[0] == light);
+
+	CHECK(registry.Get<TestMeshComponent>().size() == 3);
+	CHECK(registry.Get<TestOtherComponent>().size() == 1);
+	CHECK(registry.Get<Component>().size() == 4);
+	for (TestMeshComponent* meshComponent : registry.Get<TestMeshComponent>())
+	{
+		CHECK(meshComponent->GetOwner() != nullptr);
+	}
+}
+
+// Components added after the actor joined the world are listed by AddComponent
+TEST_CASE(ClassRegistry_ListsComponentsAddedLater)
+{
+	TestWorld world;
+	TestMeshActor* mesh = world.AddActor<TestMeshActor>("Mesh");
+
+	TestMeshComponent* lateComponent = mesh->AddComponent<TestMeshComponent>();
+	CHECK(world.classRegistry.Get<TestMeshComponent>().size() == 2);
+	CHECK(world.classRegistry.Get<TestMeshComponent>().back() == lateComponent);
+	CHECK(world.classRegistry.Get<Component>().size() == 3);
+
+	// An actor outside a world lists nothing
+	TestMeshActor outside("Outside");
+	outside.AddComponent<TestMeshComponent>();
+	CHECK(world.classRegistry.Get<TestMeshComponent>().size() == 2);
+}
+
+TEST_CASE(ClassRegistry_UnusedClassIsEmpty)
+{
+	TestWorld world;
+	world.AddActor<TestMeshActor>("Mesh");
+
+	// Class indices are shared by all registries, one registry may never have seen a class another one has
+	ClassRegistry emptyRegistry;
+	CHECK(emptyRegistry.Get<TestMeshActor>().empty());
+	CHECK(world.classRegistry.Get<TestPointLightActor>().empty());
+}
+
+// Adding 1k to 100k actors and one frame of mesh and light gathers, through the class lists
+// and through the dynamic_cast scans they replaced. The lists should scale linearly.
+BENCHMARK_CASE(ClassRegistry_ActorRegistrationAndGather)
+{
+	double gatherMsPerActor[3] = {};
+	int sizeIndex = 0;
+	for (uint32_t actorCount : { 1000u, 10000u, 100000u })
+	{
+		TestWorld world;
+		BenchmarkTimer registrationTimer;
+		FillWorld(world, actorCount);
+		const double registrationMs = registrationTimer.GetElapsedMs();
+
+		CHECK(world.classRegistry.Get<Actor>().size() == actorCount);
+		CHECK(world.classRegistry.Get<TestLightActor>().size() == actorCount / 100);
+		CHECK(world.classRegistry.Get<TestMeshComponent>().size() == actorCount);
+
+		const int frameCount = 20;
+		long scanSum = 0;
+		BenchmarkTimer scanTimer;
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			scanSum += GatherWithDynamicCast(world.actors);
+		}
+		const double scanMs = scanTimer.GetElapsedMs() / frameCount;
+
+		long listSum = 0;
+		BenchmarkTimer listTimer;
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			listSum += GatherWithClassLists(world.classRegistry);
+		}
+		const double listMs = listTimer.GetElapsedMs() / frameCount;
+
+		CHECK(scanSum == listSum);
+		gatherMsPerActor[sizeIndex++] = listMs / actorCount;
+
+		std::printf("  %6u actors: registration %.2f ms, gather per frame: dynamic_cast scan %.3f ms, class lists %.3f ms (%.1fx)\n",
+			actorCount, registrationMs, scanMs, listMs, scanMs / listMs);
+	}
+
+	// Per actor cost at 100k stays within a few times the cost at 10k, the cache misses grow but nothing is quadratic
+	CHECK(gatherMsPerActor[2] < gatherMsPerActor[1] * 8.0);
+}
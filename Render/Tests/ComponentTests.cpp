@@ -0,0 +1,178 @@
+#include "TestFramework.h"
+#include "../src/Component/Component.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// The pass of World::UpdateTransforms over the given roots. Returns the components whose matrices were rebuilt,
+	// outVisited gets every component the pass looked at.
+	std::vector<Component*> UpdateTransforms(const std::vector<Component*>& roots, std::vector<Component*>* outVisited = nullptr)
+	{
+		std::vector<Component*> queue = roots;
+		std::vector<Component*> updated;
+		for (size_t i = 0; i < queue.size(); i++)
+		{
+			Component* component = queue[i];
+			if (!component->NeedsTransformUpdate())
+			{
+				continue;
+			}
+
+			if (outVisited)
+			{
+				outVisited->push_back(component);
+			}
+			if (component->UpdateWorldMatrix())
+			{
+				updated.push_back(component);
+			}
+			queue.insert(queue.end(), component->GetChildren().begin(), component->GetChildren().end());
+		}
+		return updated;
+	}
+
+	float GetMatrixDifference(const TMatrix& a, const TMatrix& b)
+	{
+		const float* valuesA = &a._11;
+		const float* valuesB = &b._11;
+		float difference = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			difference = (std::max)(difference, std::abs(valuesA[i] - valuesB[i]));
+		}
+		return difference;
+	}
+
+	bool Contains(const std::vector<Component*>& components, const Component* component)
+	{
+		return std::find(components.begin(), components.end(), component) != components.end();
+	}
+
+	TTransform MakeTransform(const TVector3& location, const TRotator& rotation, float scale)
+	{
+		TTransform transform;
+		transform.Location = location;
+		transform.Rotation = rotation;
+		transform.Scale = TVector3(scale);
+		return transform;
+	}
+}
+
+// Attaching keeps the relative transform, so the world moves with the parent. Setting the world transform saved
+// before the attach puts it back, through the parent's inverse, and the same holds when moving to another parent
+// and when detaching.
+TEST_CASE(Component_AttachDetachKeepsWorldTransform)
+{
+	Component parentA, parentB, child;
+	parentA.SetRelativeTransform(MakeTransform(TVector3(3.0f, -1.0f, 2.0f), TRotator(10.0f, 35.0f, -60.0f), 2.0f));
+	parentB.SetRelativeTransform(MakeTransform(TVector3(-4.0f, 5.0f, 0.5f), TRotator(-80.0f, 5.0f, 120.0f), 0.5f));
+	child.SetRelativeTransform(MakeTransform(TVector3(1.0f, 2.0f, 3.0f), TRotator(20.0f, -15.0f, 45.0f), 1.5f));
+	UpdateTransforms({ &parentA, &parentB, &child });
+
+	const TMatrix childWorld = child.GetWorldMatrix();
+	const TTransform childWorldTransform = child.GetWorldTransform();
+
+	child.AttachTo(&parentA);
+	CHECK(child.GetParent() == &parentA && parentA.GetChildren().size() == 1);
+	CHECK(child.IsTransformDirty());
+	CHECK(GetMatrixDifference(child.GetWorldMatrix(), child.GetRelativeTransform().GetTransformMatrix() * parentA.GetWorldMatrix()) < 1e-4f);
+
+	child.SetWorldTransform(childWorldTransform);
+	CHECK(GetMatrixDifference(child.GetWorldMatrix(), childWorld) < 1e-4f);
+	UpdateTransforms({ &parentA, &parentB });
+	CHECK(GetMatrixDifference(child.GetWorldMatrix(), childWorld) < 1e-4f);
+	CHECK(GetMatrixDifference(child.GetWorldMatrix() * child.GetInvWorldMatrix(), TMatrix::Identity) < 1e-4f);
+
+	// Re-parenting goes through the detach, the old parent lets go of the child
+	child.AttachTo(&parentB);
+	CHECK(child.GetParent() == &parentB && parentA.GetChildren().empty() && parentB.GetChildren().size() == 1);
+	child.SetWorldTransform(childWorldTransform);
+	UpdateTransforms({ &parentA, &parentB });
+	CHECK(GetMatrixDifference(child.GetWorldMatrix(), childWorld) < 1e-4f);
+	CHECK_NEAR(child.GetWorldTransform().Scale.x, 1.5f, 1e-4f);
+
+	// World location alone, through SetWorldLocation
+	const TVector3 target(7.0f, -2.0f, 4.0f);
+	child.SetWorldLocation(target);
+	CHECK((child.GetWorldLocation() - target).Length() < 1e-4f);
+	UpdateTransforms({ &parentA, &parentB });
+
+	child.Detach();
+	CHECK(child.GetParent() == nullptr && parentB.GetChildren().empty());
+	CHECK(child.IsTransformDirty());
+	CHECK(GetMatrixDifference(child.GetWorldMatrix(), child.GetRelativeTransform().GetTransformMatrix()) == 0.0f);
+	child.SetWorldTransform(childWorldTransform);
+	UpdateTransforms({ &parentA, &parentB, &child });
+	CHECK(GetMatrixDifference(child.GetWorldMatrix(), childWorld) < 1e-4f);
+
+	// A parent destroyed first leaves the child at the root, dirty
+	{
+		Component parentC;
+		child.AttachTo(&parentC);
+		UpdateTransforms({ &parentC });
+	}
+	CHECK(child.GetParent() == nullptr && child.IsTransformDirty());
+}
+
+// Moving a component marks its whole subtree dirty and flags the path above it. The next pass rebuilds exactly that
+// subtree and does not even visit the unchanged sibling.
+TEST_CASE(Component_DirtyFlagReachesDescendantsOnly)
+{
+	Component root, a, a1, a2, b, b1;
+	a.AttachTo(&root);
+	a1.AttachTo(&a);
+	a2.AttachTo(&a1);
+	b.AttachTo(&root);
+	b1.AttachTo(&b);
+
+	Component* const all[] = { &root, &a, &a1, &a2, &b, &b1 };
+	float offset = 1.0f;
+	for (Component* component : all)
+	{
+		component->SetRelativeTransform(MakeTransform(TVector3(offset, 0.0f, -offset), TRotator(offset * 10.0f, 0.0f, offset * 5.0f), 1.0f));
+		offset += 1.0f;
+	}
+
+	CHECK(UpdateTransforms({ &root }).size() == 6);
+	CHECK(UpdateTransforms({ &root }).empty());
+	for (Component* component : all)
+	{
+		CHECK(!component->IsTransformDirty() && !component->NeedsTransformUpdate());
+	}
+
+	const TMatrix bWorld = b.GetWorldMatrix();
+	const TMatrix b1World = b1.GetWorldMatrix();
+
+	a.SetRelativeLocation(TVector3(0.0f, 10.0f, 0.0f));
+	CHECK(a.IsTransformDirty() && a1.IsTransformDirty() && a2.IsTransformDirty());
+	CHECK(!root.IsTransformDirty() && root.NeedsTransformUpdate());
+	CHECK(!b.IsTransformDirty() && !b.NeedsTransformUpdate() && !b1.IsTransformDirty());
+
+	// Dirty matrices read before the pass are composed on the fly
+	const TMatrix a2Expected = a2.GetRelativeTransform().GetTransformMatrix() * a1.GetRelativeTransform().GetTransformMatrix()
+		* a.GetRelativeTransform().GetTransformMatrix() * root.GetWorldMatrix();
+	CHECK(GetMatrixDifference(a2.GetWorldMatrix(), a2Expected) < 1e-4f);
+
+	std::vector<Component*> visited;
+	const std::vector<Component*> updated = UpdateTransforms({ &root }, &visited);
+	CHECK(updated.size() == 3 && Contains(updated, &a) && Contains(updated, &a1) && Contains(updated, &a2));
+	CHECK(!Contains(visited, &b) && !Contains(visited, &b1));
+	CHECK(GetMatrixDifference(a2.GetWorldMatrix(), a2Expected) < 1e-4f);
+	CHECK(GetMatrixDifference(b.GetWorldMatrix(), bWorld) == 0.0f && GetMatrixDifference(b1.GetWorldMatrix(), b1World) == 0.0f);
+
+	// A leaf only rebuilds itself, the root moving rebuilds everything
+	b1.SetRelativeRotation(TRotator(0.0f, 30.0f, 0.0f));
+	CHECK(UpdateTransforms({ &root }) == std::vector<Component*>({ &b1 }));
+	root.SetRelativeLocation(TVector3(-5.0f, 0.0f, 0.0f));
+	CHECK(UpdateTransforms({ &root }).size() == 6);
+
+	// Re-parenting a subtree marks the moved part only
+	a1.AttachTo(&b);
+	CHECK(a1.IsTransformDirty() && a2.IsTransformDirty() && !a.IsTransformDirty() && !b.IsTransformDirty());
+	std::vector<Component*> reparentVisited;
+	CHECK(UpdateTransforms({ &root }, &reparentVisited).size() == 2);
+	CHECK(!Contains(reparentVisited, &a));
+	CHECK(GetMatrixDifference(a2.GetWorldMatrix(), a2.GetRelativeTransform().GetTransformMatrix()
+		* a1.GetRelativeTransform().GetTransformMatrix() * b.GetWorldMatrix()) < 1e-4f);
+}
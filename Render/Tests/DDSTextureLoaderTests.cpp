@@ -0,0 +1,257 @@
+#include "TestFramework.h"
+#include "../src/TextureLoader/DDSTextureLoader.h"
+#include "../src/TextureLoader/DDS.h"
+#include "../src/File/BinaryReader.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <psapi.h>
+
+namespace
+{
+	// RGBA8 2D texture array with a full mip chain in a DX10 header, every texel is a hash of its position
+	// so a subresource pointing to the wrong place does not compare equal by accident
+	class TempDDSFile
+	{
+	public:
+		TempDDSFile(const wchar_t* name, uint32_t size, uint32_t arraySize, bool bTruncate = false)
+		{
+			path = (std::filesystem::temp_directory_path() / name).wstring();
+
+			uint32_t mipCount = 1;
+			while ((size >> (mipCount - 1)) > 1)
+			{
+				mipCount++;
+			}
+
+			DDS_HEADER header = {};
+			header.size = sizeof(DDS_HEADER);
+			header.flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_PITCH | DDS_HEADER_FLAGS_MIPMAP;
+			header.height = size;
+			header.width = size;
+			header.pitchOrLinearSize = size * 4;
+			header.mipMapCount = mipCount;
+			header.ddspf = DDSPF_DX10;
+			header.caps = DDS_SURFACE_FLAGS_TEXTURE | DDS_SURFACE_FLAGS_MIPMAP;
+
+			DDS_HEADER_DXT10 headerDX10 = {};
+			headerDX10.dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+			headerDX10.resourceDimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+			headerDX10.arraySize = arraySize;
+
+			std::ofstream file(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(uint32_t));
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(&headerDX10), sizeof(headerDX10));
+
+			// Slice by slice, each slice holds its whole mip chain
+			std::vector<uint32_t> texels;
+			for (uint32_t slice = 0; slice < arraySize; slice++)
+			{
+				for (uint32_t mip = 0; mip < mipCount; mip++)
+				{
+					const uint32_t mipSize = size >> mip;
+					texels.resize((size_t)mipSize * mipSize);
+					for (size_t i = 0; i < texels.size(); i++)
+					{
+						texels[i] = GetTexel(slice, mip, (uint32_t)i);
+					}
+
+					// The truncated file ends halfway through the top mip of the last slice
+					if (bTruncate && slice == arraySize - 1)
+					{
+						file.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(uint32_t) / 2);
+						break;
+					}
+					file.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(uint32_t));
+				}
+			}
+
+			fileSize = (uint64_t)file.tellp();
+		}
+
+		~TempDDSFile()
+		{
+			std::error_code errorCode;
+			std::filesystem::remove(std::filesystem::path(path), errorCode);
+		}
+
+		static uint32_t GetTexel(uint32_t slice, uint32_t mip, uint32_t index)
+		{
+			uint32_t hash = (slice * 131u + mip) * 2654435761u ^ index * 2246822519u;
+			return hash ^ (hash >> 15);
+		}
+
+		std::wstring path;
+		uint64_t fileSize = 0;
+	};
+
+	struct MemoryCounters
+	{
+		uint64_t workingSet = 0;
+		uint64_t privateBytes = 0; // mapped file pages are not part of it, they can be dropped and read again
+	};
+
+	MemoryCounters GetMemoryCounters()
+	{
+		PROCESS_MEMORY_COUNTERS memoryCounters = {};
+		memoryCounters.cb = sizeof(memoryCounters);
+		GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters));
+		return { memoryCounters.WorkingSetSize, memoryCounters.PagefileUsage };
+	}
+
+	// Stands in for UploadTextureData, the upload buffer takes a copy of every subresource
+	std::vector<uint8_t> CopyToUploadBuffer(const std::vector<D3D12_SUBRESOURCE_DATA>& initData)
+	{
+		uint64_t uploadSize = 0;
+		for (const D3D12_SUBRESOURCE_DATA& subresource : initData)
+		{
+			uploadSize += subresource.SlicePitch;
+		}
+
+		std::vector<uint8_t> uploadBuffer(uploadSize);
+		uint64_t offset = 0;
+		for (const D3D12_SUBRESOURCE_DATA& subresource : initData)
+		{
+			memcpy(uploadBuffer.data() + offset, subresource.pData, subresource.SlicePitch);
+			offset += subresource.SlicePitch;
+		}
+
+		return uploadBuffer;
+	}
+}
+
+// The mapped overload must describe the same texture as the buffered one, with every subresource inside the view
+TEST_CASE(DDSTextureLoader_MappedMatchesBuffered)
+{
+	const uint32_t size = 256;
+	const uint32_t arraySize = 4;
+	TempDDSFile ddsFile(L"DDSTextureLoader_MappedMatchesBuffered.dds", size, arraySize);
+
+	TextureInfo bufferedInfo = {};
+	std::vector<D3D12_SUBRESOURCE_DATA> bufferedInitData;
+	std::vector<uint8_t> ddsData;
+	CHECK(SUCCEEDED(DirectX::CreateDDSTextureFromFile(ddsFile.path.c_str(), bufferedInfo, bufferedInitData, ddsData, false)));
+
+	TextureInfo mappedInfo = {};
+	std::vector<D3D12_SUBRESOURCE_DATA> mappedInitData;
+	std::shared_ptr<TMappedFile> mappedFile;
+	CHECK(SUCCEEDED(DirectX::CreateDDSTextureFromFile(ddsFile.path.c_str(), mappedInfo, mappedInitData, mappedFile, false)));
+
+	CHECK(mappedFile && mappedFile->GetSize() == ddsFile.fileSize);
+	CHECK(ddsData.size() == ddsFile.fileSize);
+
+	CHECK(mappedInfo.width == size && mappedInfo.height == size && mappedInfo.arraySize == arraySize);
+	CHECK(mappedInfo.mipCount == 9 && mappedInfo.format == DXGI_FORMAT_R8G8B8A8_UNORM);
+	CHECK(mappedInfo.width == bufferedInfo.width && mappedInfo.mipCount == bufferedInfo.mipCount);
+	CHECK(mappedInfo.dimension == bufferedInfo.dimension && mappedInfo.arraySize == bufferedInfo.arraySize);
+
+	CHECK(mappedInitData.size() == arraySize * 9);
+	CHECK(mappedInitData.size() == bufferedInitData.size());
+	if (!mappedFile || mappedInitData.size() != bufferedInitData.size())
+	{
+		return;
+	}
+
+	const uint8_t* viewBegin = mappedFile->GetData();
+	const uint8_t* viewEnd = viewBegin + mappedFile->GetSize();
+	for (size_t i = 0; i < mappedInitData.size(); i++)
+	{
+		const D3D12_SUBRESOURCE_DATA& mapped = mappedInitData[i];
+		const D3D12_SUBRESOURCE_DATA& buffered = bufferedInitData[i];
+		const uint8_t* mappedBegin = static_cast<const uint8_t*>(mapped.pData);
+
+		CHECK(mappedBegin >= viewBegin && mappedBegin + mapped.SlicePitch <= viewEnd);
+		CHECK(mapped.RowPitch == buffered.RowPitch && mapped.SlicePitch == buffered.SlicePitch);
+		CHECK(memcmp(mapped.pData, buffered.pData, mapped.SlicePitch) == 0);
+
+		const uint32_t slice = (uint32_t)(i / 9);
+		const uint32_t mip = (uint32_t)(i % 9);
+		CHECK(mapped.RowPitch == (size >> mip) * 4);
+		CHECK(*static_cast<const uint32_t*>(mapped.pData) == TempDDSFile::GetTexel(slice, mip, 0));
+	}
+}
+
+TEST_CASE(DDSTextureLoader_RejectsTruncatedFile)
+{
+	TempDDSFile ddsFile(L"DDSTextureLoader_RejectsTruncatedFile.dds", 128, 2, true);
+
+	TextureInfo textureInfo = {};
+	std::vector<D3D12_SUBRESOURCE_DATA> initData;
+	std::vector<uint8_t> ddsData;
+	CHECK(FAILED(DirectX::CreateDDSTextureFromFile(ddsFile.path.c_str(), textureInfo, initData, ddsData, false)));
+
+	std::shared_ptr<TMappedFile> mappedFile;
+	CHECK(FAILED(DirectX::CreateDDSTextureFromFile(ddsFile.path.c_str(), textureInfo, initData, mappedFile, false)));
+	CHECK(!mappedFile);
+
+	CHECK(FAILED(DirectX::CreateDDSTextureFromFile(L"DDSTextureLoader_Missing.dds", textureInfo, initData, mappedFile, false)));
+}
+
+TEST_CASE(BinaryReader_MappedModeReadsSameData)
+{
+	TempDDSFile ddsFile(L"BinaryReader_MappedModeReadsSameData.dds", 64, 1);
+
+	TBinaryReader buffered(ddsFile.path.c_str(), EBinaryReadMode::Buffered);
+	TBinaryReader mapped(ddsFile.path.c_str(), EBinaryReadMode::MemoryMapped);
+	CHECK(!buffered.GetMappedFile() && mapped.GetMappedFile());
+	CHECK(buffered.GetRemainingSize() == ddsFile.fileSize && mapped.GetRemainingSize() == ddsFile.fileSize);
+
+	CHECK(buffered.Read<uint32_t>() == DDS_MAGIC);
+	CHECK(mapped.Read<uint32_t>() == DDS_MAGIC);
+
+	const size_t remainingSize = mapped.GetRemainingSize();
+	CHECK(memcmp(buffered.ReadArray<uint8_t>(remainingSize), mapped.ReadArray<uint8_t>(remainingSize), remainingSize) == 0);
+
+	bool bThrew = false;
+	try
+	{
+		mapped.Read<uint8_t>();
+	}
+	catch (const std::runtime_error&)
+	{
+		bThrew = true;
+	}
+	CHECK(bThrew);
+}
+
+// A 16 slice 2048x2048 RGBA8 array with mips, about 340 MB, loaded and copied to an upload buffer like Texture does.
+// Memory is sampled while the loaded data and the upload copy are both alive, which is the peak of a load.
+// The process peak counters never go down, so they would hide the smaller of the two paths.
+// The file was just written and sits in the file cache, the times are for a warm load.
+BENCHMARK_CASE(DDSTextureLoader_LoadTimeAndPeakMemory)
+{
+	TempDDSFile ddsFile(L"DDSTextureLoader_LoadTimeAndPeakMemory.dds", 2048, 16);
+	const double fileMB = ddsFile.fileSize / (1024.0 * 1024.0);
+
+	double peakPrivateMB[2] = {};
+	const char* modeNames[2] = { "mapped", "buffered" };
+	for (int mode = 0; mode < 2; mode++)
+	{
+		const MemoryCounters before = GetMemoryCounters();
+		BenchmarkTimer timer;
+
+		TextureInfo textureInfo = {};
+		std::vector<D3D12_SUBRESOURCE_DATA> initData;
+		std::vector<uint8_t> ddsData;
+		std::shared_ptr<TMappedFile> mappedFile;
+		const HRESULT hr = mode == 0
+			? DirectX::CreateDDSTextureFromFile(ddsFile.path.c_str(), textureInfo, initData, mappedFile, false)
+			: DirectX::CreateDDSTextureFromFile(ddsFile.path.c_str(), textureInfo, initData, ddsData, false);
+		CHECK(SUCCEEDED(hr));
+		const double loadMs = timer.GetElapsedMs();
+
+		const std::vector<uint8_t> uploadBuffer = CopyToUploadBuffer(initData);
+		const double totalMs = timer.GetElapsedMs();
+		CHECK(uploadBuffer.size() + sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10) == ddsFile.fileSize);
+
+		const MemoryCounters peak = GetMemoryCounters();
+		peakPrivateMB[mode] = ((double)peak.privateBytes - (double)before.privateBytes) / (1024.0 * 1024.0);
+		std::printf("  %-8s %.0f MB file: load %.1f ms, load + upload copy %.1f ms, peak private +%.0f MB, peak working set +%.0f MB\n",
+			modeNames[mode], fileMB, loadMs, totalMs, peakPrivateMB[mode],
+			((double)peak.workingSet - (double)before.workingSet) / (1024.0 * 1024.0));
+	}
+
+	// Buffered holds the file and the upload copy at once, mapped only the upload copy
+	CHECK(peakPrivateMB[0] < peakPrivateMB[1] * 0.75);
+}
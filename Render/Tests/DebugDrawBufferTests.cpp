@@ -0,0 +1,217 @@
+#include "TestFramework.h"
+#include "../src/Mesh/DebugDrawBuffer.h"
+#include "../src/Math/Transform.h"
+#include <cstring>
+
+namespace
+{
+	// Stand-in for the Line objects of Primitive.h that World kept before DebugDrawBuffer, with the same layout:
+	// a vtable, the transform and bounding box of Primitive, two points and a color
+	class LegacyLine
+	{
+	public:
+		LegacyLine(const TVector3& inPointA, const TVector3& inPointB, const Color& inColor)
+			:pointA(inPointA), pointB(inPointB), color(inColor)
+		{}
+
+		virtual ~LegacyLine() {}
+
+		TTransform worldTransform;
+		TVector3 boxMin;
+		TVector3 boxMax;
+		bool bInit = false;
+
+		TVector3 pointA;
+		TVector3 pointB;
+		Color color;
+	};
+
+	bool IsSameVertex(const PrimitiveVertex& vertex, const TVector3& position, const Color& color)
+	{
+		return vertex.Position.x == position.x && vertex.Position.y == position.y && vertex.Position.z == position.z
+			&& vertex.color.R == color.R && vertex.color.G == color.G && vertex.color.B == color.B && vertex.color.A == color.A;
+	}
+
+	TVector3 LinePointA(uint32_t i) { return TVector3((float)i, 0.0f, 0.0f); }
+	TVector3 LinePointB(uint32_t i, int frame) { return TVector3(0.0f, (float)i, (float)frame); }
+
+	const uint32_t MILLION_LINES = 1000000;
+}
+
+// Each topology and depth mode has its own list, each primitive adds its vertices in order
+TEST_CASE(DebugDrawBuffer_ListsPerTopologyAndDepthMode)
+{
+	DebugDrawBuffer buffer;
+	buffer.AddPoint(TVector3(1.0f, 2.0f, 3.0f), Color::Red);
+	buffer.AddLine(TVector3(0.0f), TVector3(1.0f), Color::Green);
+	buffer.AddLine(TVector3(2.0f), TVector3(3.0f), Color::Blue, EDebugDepthMode::AlwaysOnTop);
+	buffer.AddTriangle(TVector3(0.0f), TVector3(1.0f, 0.0f, 0.0f), TVector3(0.0f, 1.0f, 0.0f), Color::Yellow);
+
+	CHECK(buffer.GetVertexCount() == 1 + 2 + 2 + 3);
+	CHECK(buffer.GetVertices(EDebugTopology::Point, EDebugDepthMode::DepthTest).size() == 1);
+	CHECK(buffer.GetVertices(EDebugTopology::Point, EDebugDepthMode::AlwaysOnTop).empty());
+	CHECK(buffer.GetVertices(EDebugTopology::Triangle, EDebugDepthMode::DepthTest).size() == 3);
+
+	const auto& lines = buffer.GetVertices(EDebugTopology::Line, EDebugDepthMode::DepthTest);
+	CHECK(lines.size() == 2);
+	CHECK(IsSameVertex(lines[0], TVector3(0.0f), Color::Green) && IsSameVertex(lines[1], TVector3(1.0f), Color::Green));
+
+	const auto& onTopLines = buffer.GetVertices(EDebugTopology::Line, EDebugDepthMode::AlwaysOnTop);
+	CHECK(onTopLines.size() == 2);
+	CHECK(IsSameVertex(onTopLines[0], TVector3(2.0f), Color::Blue) && IsSameVertex(onTopLines[1], TVector3(3.0f), Color::Blue));
+
+	// World::TakeDebugDraw: the snapshot takes the lists, the world gets the old ones back empty
+	DebugDrawBuffer snapshot;
+	snapshot.AddPoint(TVector3(9.0f), Color::White);
+	snapshot.Clear();
+	buffer.Swap(snapshot);
+	CHECK(buffer.GetVertexCount() == 0);
+	CHECK(snapshot.GetVertexCount() == 8);
+}
+
+// The 12 edges of a box each run along one axis, the 8 corners are each used 3 times
+TEST_CASE(DebugDrawBuffer_BoxEdges)
+{
+	DebugDrawBuffer buffer;
+	const TVector3 boxMin(-1.0f, 0.0f, 2.0f);
+	const TVector3 boxMax(1.0f, 3.0f, 5.0f);
+	buffer.AddBox(boxMin, boxMax, Color::Cyan, EDebugDepthMode::AlwaysOnTop);
+
+	const auto& vertices = buffer.GetVertices(EDebugTopology::Line, EDebugDepthMode::AlwaysOnTop);
+	CHECK(vertices.size() == 24);
+	CHECK(buffer.GetVertexCount() == 24);
+
+	int cornerUses[8] = {};
+	for (size_t i = 0; i + 1 < vertices.size(); i += 2)
+	{
+		const TVector3& a = vertices[i].Position;
+		const TVector3& b = vertices[i + 1].Position;
+		const int changedAxes = (a.x != b.x) + (a.y != b.y) + (a.z != b.z);
+		CHECK(changedAxes == 1);
+
+		for (const TVector3& corner : { a, b })
+		{
+			CHECK((corner.x == boxMin.x || corner.x == boxMax.x) && (corner.y == boxMin.y || corner.y == boxMax.y)
+				&& (corner.z == boxMin.z || corner.z == boxMax.z));
+			cornerUses[(corner.x == boxMax.x ? 1 : 0) | (corner.y == boxMax.y ? 2 : 0) | (corner.z == boxMax.z ? 4 : 0)]++;
+		}
+	}
+
+	for (int uses : cornerUses)
+	{
+		CHECK(uses == 3);
+	}
+}
+
+// A million lines a frame: every vertex lands in order, and once the lists have grown the next frames reuse them
+// without allocating
+TEST_CASE(DebugDrawBuffer_MillionLinesKeepCapacity)
+{
+	DebugDrawBuffer world;
+	DebugDrawBuffer snapshot;
+
+	const PrimitiveVertex* lineData[2] = {};
+	for (int frame = 0; frame < 4; frame++)
+	{
+		for (uint32_t i = 0; i < MILLION_LINES; i++)
+		{
+			world.AddLine(LinePointA(i), LinePointB(i, frame), Color::Red);
+		}
+
+		snapshot.Clear();
+		world.Swap(snapshot);
+		CHECK(world.GetVertexCount() == 0);
+
+		const auto& vertices = snapshot.GetVertices(EDebugTopology::Line, EDebugDepthMode::DepthTest);
+		CHECK(vertices.size() == 2 * MILLION_LINES);
+		CHECK(snapshot.GetVertexCount() == 2 * MILLION_LINES);
+
+		uint32_t errorCount = 0;
+		for (uint32_t i = 0; i < MILLION_LINES; i++)
+		{
+			errorCount += !IsSameVertex(vertices[2 * i], LinePointA(i), Color::Red);
+			errorCount += !IsSameVertex(vertices[2 * i + 1], LinePointB(i, frame), Color::Red);
+		}
+		CHECK(errorCount == 0);
+
+		// The two buffers trade lists every frame, from the third frame on both are full size
+		if (frame >= 2)
+		{
+			CHECK(vertices.data() == lineData[frame % 2]);
+		}
+		lineData[frame % 2] = vertices.data();
+	}
+}
+
+// A million lines per frame, drawn, handed to the renderer and copied to upload memory:
+// as Line objects converted to vertices by the renderer, and through DebugDrawBuffer
+BENCHMARK_CASE(DebugDrawBuffer_MillionLinesVsLineObjects)
+{
+	const int frameCount = 10;
+
+	// Stands in for the mapped upload memory of the frame ring
+	std::vector<uint8_t> uploadMemory((size_t)MILLION_LINES * 2 * sizeof(PrimitiveVertex));
+
+	double legacyMs = 0.0;
+	{
+		std::vector<LegacyLine> worldLines;
+		std::vector<LegacyLine> snapshotLines;
+		for (int frame = 0; frame < frameCount + 1; frame++)
+		{
+			BenchmarkTimer timer;
+			for (uint32_t i = 0; i < MILLION_LINES; i++)
+			{
+				worldLines.emplace_back(LinePointA(i), LinePointB(i, frame), Color::Red);
+			}
+
+			snapshotLines.clear();
+			worldLines.swap(snapshotLines);
+
+			// What GatherAllPrimitiveBatchs did: a copy of the lines, then a vertex list built from it
+			std::vector<LegacyLine> lines(snapshotLines.begin(), snapshotLines.end());
+			std::vector<PrimitiveVertex> vertices;
+			for (const LegacyLine& line : lines)
+			{
+				vertices.push_back(PrimitiveVertex(line.pointA, line.color));
+				vertices.push_back(PrimitiveVertex(line.pointB, line.color));
+			}
+			std::memcpy(uploadMemory.data(), vertices.data(), vertices.size() * sizeof(PrimitiveVertex));
+
+			// The first frame grows the lists
+			if (frame > 0)
+			{
+				legacyMs += timer.GetElapsedMs();
+			}
+		}
+	}
+
+	double bufferMs = 0.0;
+	{
+		DebugDrawBuffer world;
+		DebugDrawBuffer snapshot;
+		for (int frame = 0; frame < frameCount + 1; frame++)
+		{
+			BenchmarkTimer timer;
+			for (uint32_t i = 0; i < MILLION_LINES; i++)
+			{
+				world.AddLine(LinePointA(i), LinePointB(i, frame), Color::Red);
+			}
+
+			snapshot.Clear();
+			world.Swap(snapshot);
+
+			const auto& vertices = snapshot.GetVertices(EDebugTopology::Line, EDebugDepthMode::DepthTest);
+			std::memcpy(uploadMemory.data(), vertices.data(), vertices.size() * sizeof(PrimitiveVertex));
+
+			if (frame > 0)
+			{
+				bufferMs += timer.GetElapsedMs();
+			}
+		}
+		CHECK(snapshot.GetVertexCount() == 2 * MILLION_LINES);
+	}
+
+	std::printf("  %u lines per frame: Line objects %.1f ms, DebugDrawBuffer %.1f ms (%.1fx), %zu vs %zu bytes per line\n",
+		MILLION_LINES, legacyMs / frameCount, bufferMs / frameCount, legacyMs / bufferMs, sizeof(LegacyLine), 2 * sizeof(PrimitiveVertex));
+	CHECK(bufferMs * 2.0 < legacyMs);
+}
@@ -0,0 +1,184 @@
+#include "TestFramework.h"
+#include "../src/Resource/DeferredDeletionQueue.h"
+#include <map>
+
+namespace
+{
+	// Records what was deleted and when, stands in for a buddy allocator or a bindless table
+	class FakeDeletionVisitor : public IDeferredDeletionVisitor
+	{
+	public:
+		void Delete(uint64_t handle, void* object) override
+		{
+			deletedHandles.push_back(handle);
+			lastObject = object;
+		}
+
+		std::vector<uint64_t> deletedHandles;
+		void* lastObject = nullptr;
+	};
+}
+
+TEST_CASE(DeferredDeletionQueue_DeletesOnceTheFenceCompletes)
+{
+	DeferredDeletionQueue queue;
+	FakeDeletionVisitor visitor;
+	int object = 0;
+
+	queue.Enqueue(&visitor, 1, &object, 256);
+	queue.Enqueue(&visitor, 2, nullptr, 512);
+	CHECK(queue.GetStats().pendingBytes == 768);
+	CHECK(queue.GetStats().inFlightCount == 2);
+
+	// Nothing submitted, a completed fence does not release pending entries
+	CHECK(queue.Retire(100) == 0);
+	queue.Submit(5);
+	CHECK(queue.GetStats().pendingBytes == 0 && queue.GetStats().inFlightBytes == 768);
+
+	queue.Enqueue(&visitor, 3, nullptr, 1024);
+	queue.Submit(6);
+
+	CHECK(queue.Retire(4) == 0);
+	CHECK(visitor.deletedHandles.empty());
+
+	CHECK(queue.Retire(5) == 2);
+	CHECK(visitor.deletedHandles == std::vector<uint64_t>({ 1, 2 }));
+	CHECK(queue.GetStats().inFlightBytes == 1024 && queue.GetStats().deletedBytes == 768);
+
+	CHECK(queue.Retire(6) == 1);
+	CHECK(visitor.deletedHandles.back() == 3);
+	CHECK(queue.GetStats().inFlightBytes == 0 && queue.GetStats().inFlightCount == 0);
+	CHECK(queue.GetStats().peakInFlightBytes == 1792);
+}
+
+// Retire releases at most maxCount entries, the rest of a batch waits for the next call in order
+TEST_CASE(DeferredDeletionQueue_RetireIsAmortized)
+{
+	DeferredDeletionQueue queue;
+	FakeDeletionVisitor visitor;
+
+	for (uint64_t handle = 0; handle < 10; handle++)
+	{
+		queue.Enqueue(&visitor, handle, nullptr, 1);
+	}
+	queue.Submit(1);
+	for (uint64_t handle = 10; handle < 15; handle++)
+	{
+		queue.Enqueue(&visitor, handle, nullptr, 1);
+	}
+	queue.Submit(2);
+
+	CHECK(queue.Retire(2, 4) == 4);
+	CHECK(queue.Retire(2, 4) == 4);
+	CHECK(queue.Retire(2, 4) == 4);
+	CHECK(queue.Retire(2, 4) == 3);
+	CHECK(queue.Retire(2, 4) == 0);
+
+	CHECK(visitor.deletedHandles.size() == 15);
+	for (uint64_t i = 0; i < visitor.deletedHandles.size(); i++)
+	{
+		CHECK(visitor.deletedHandles[i] == i);
+	}
+}
+
+TEST_CASE(DeferredDeletionQueue_FlushReleasesEverything)
+{
+	DeferredDeletionQueue queue;
+	FakeDeletionVisitor first;
+	FakeDeletionVisitor second;
+
+	queue.Enqueue(&first, 1, nullptr, 10);
+	queue.Submit(7);
+	queue.Enqueue(&second, 2, nullptr, 20);
+	queue.Enqueue(&first, 3, nullptr, 30);
+
+	queue.Flush();
+	CHECK(first.deletedHandles == std::vector<uint64_t>({ 1, 3 }));
+	CHECK(second.deletedHandles == std::vector<uint64_t>({ 2 }));
+	CHECK(queue.GetStats().inFlightBytes == 0 && queue.GetStats().deletedBytes == 60);
+}
+
+// Steady frames with the GPU three behind, only the fences decide when memory comes back
+TEST_CASE(DeferredDeletionQueue_NothingIsDeletedBeforeItsFence)
+{
+	DeferredDeletionQueue queue;
+
+	class CheckingVisitor : public IDeferredDeletionVisitor
+	{
+	public:
+		std::map<uint64_t, uint64_t> fenceOfHandle;
+		uint64_t completedFenceValue = 0;
+		uint32_t errorCount = 0;
+		uint32_t deleteCount = 0;
+
+		void Delete(uint64_t handle, void*) override
+		{
+			auto Iter = fenceOfHandle.find(handle);
+			if (Iter == fenceOfHandle.end() || Iter->second > completedFenceValue)
+			{
+				errorCount++;
+			}
+			else
+			{
+				fenceOfHandle.erase(Iter);
+			}
+			deleteCount++;
+		}
+	} visitor;
+
+	uint64_t handle = 0;
+	for (uint64_t fenceValue = 1; fenceValue <= 500; fenceValue++)
+	{
+		for (uint32_t i = 0; i < fenceValue % 37; i++)
+		{
+			visitor.fenceOfHandle[handle] = fenceValue;
+			queue.Enqueue(&visitor, handle++, nullptr, 64);
+		}
+		queue.Submit(fenceValue);
+
+		if (fenceValue > 3)
+		{
+			visitor.completedFenceValue = fenceValue - 3;
+			queue.Retire(visitor.completedFenceValue, 16);
+		}
+	}
+
+	visitor.completedFenceValue = UINT64_MAX;
+	queue.Flush();
+	CHECK(visitor.errorCount == 0);
+	CHECK(visitor.deleteCount == handle && visitor.fenceOfHandle.empty());
+}
+
+// Enqueue is a push_back and Retire walks plain arrays, both should be a few ns per entry
+BENCHMARK_CASE(DeferredDeletionQueue_Throughput)
+{
+	DeferredDeletionQueue queue;
+	FakeDeletionVisitor visitor;
+	visitor.deletedHandles.reserve(20000000);
+
+	const uint32_t frameCount = 10000;
+	const uint32_t entriesPerFrame = 2000;
+
+	BenchmarkTimer timer;
+	uint64_t fenceValue = 0;
+	for (uint32_t frame = 0; frame < frameCount; frame++)
+	{
+		for (uint32_t i = 0; i < entriesPerFrame; i++)
+		{
+			queue.Enqueue(&visitor, i, nullptr, 256);
+		}
+		queue.Submit(++fenceValue);
+
+		if (fenceValue > 3)
+		{
+			queue.Retire(fenceValue - 3);
+		}
+	}
+	const double durationMs = timer.GetElapsedMs();
+
+	CHECK(queue.GetStats().peakInFlightBytes <= 4ull * entriesPerFrame * 256);
+	queue.Flush();
+	CHECK(visitor.deletedHandles.size() == (size_t)frameCount * entriesPerFrame);
+	std::printf("  %.1f ns per enqueued and retired entry, peak in flight %.1f MB\n",
+		durationMs * 1e6 / ((double)frameCount * entriesPerFrame), queue.GetStats().peakInFlightBytes / (1024.0 * 1024.0));
+}
@@ -0,0 +1,175 @@
+#include "TestFramework.h"
+#include "../src/Engine/FramePipeline.h"
+#include <chrono>
+#include <thread>
+
+namespace
+{
+	// Stands in for World, each frame stamps its snapshot with the number of updates so far
+	class TestSimulation : public IFrameSimulation
+	{
+	public:
+		void Update(const GameTimer& gt) override
+		{
+			if (bUpdated)
+			{
+				errorCount++;
+			}
+			bUpdated = true;
+			updateCount++;
+		}
+
+		void ExtractRenderData(RenderSnapshot& snapshot, uint64_t frameIndex) override
+		{
+			if (!bUpdated || frameIndex + 1 != updateCount)
+			{
+				errorCount++;
+			}
+
+			snapshot.frameIndex = frameIndex;
+			snapshot.camera.location = TVector3((float)frameIndex, 0.0f, 0.0f);
+
+			// Takes a while and changes the size of the lists, a renderer reading the same snapshot would see it
+			LightRenderData light;
+			light.intensity = (float)frameIndex;
+			snapshot.lights.assign(frameIndex % 7 + 1, light);
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+
+		void EndFrame(const GameTimer& gt) override
+		{
+			if (!bUpdated)
+			{
+				errorCount++;
+			}
+			bUpdated = false;
+		}
+
+		uint64_t updateCount = 0;
+		uint32_t errorCount = 0;
+
+	private:
+		bool bUpdated = false;
+	};
+
+	// Records the frames it draws and checks each snapshot is whole and does not change while it is drawn
+	class CheckingRenderer : public IFrameRenderer
+	{
+	public:
+		void RenderFrame(const RenderSnapshot& snapshot, const GameTimer& gt) override
+		{
+			renderedFrames.push_back(snapshot.frameIndex);
+			CheckSnapshot(snapshot);
+
+			// The simulation of the next frame runs meanwhile and writes the other snapshot
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			CheckSnapshot(snapshot);
+		}
+
+		std::vector<uint64_t> renderedFrames;
+		uint32_t errorCount = 0;
+
+	private:
+		void CheckSnapshot(const RenderSnapshot& snapshot)
+		{
+			const uint64_t frameIndex = renderedFrames.back();
+			if (snapshot.frameIndex != frameIndex || snapshot.camera.location.x != (float)frameIndex
+				|| snapshot.lights.size() != frameIndex % 7 + 1)
+			{
+				errorCount++;
+				return;
+			}
+
+			for (const LightRenderData& light : snapshot.lights)
+			{
+				if (light.intensity != (float)frameIndex)
+				{
+					errorCount++;
+				}
+			}
+		}
+	};
+
+	const uint32_t TEST_WORKER_COUNT = 3;
+}
+
+// The first frame only simulates, every later one draws the frame before it
+TEST_CASE(FramePipeline_FirstFrameSimulatesOnce)
+{
+	JobSystem::Get().Initialize(TEST_WORKER_COUNT);
+
+	TestSimulation simulation;
+	CheckingRenderer renderer;
+	FramePipeline pipeline;
+	pipeline.Initialize(&simulation, &renderer);
+
+	GameTimer timer;
+	timer.Reset();
+
+	timer.Tick();
+	pipeline.RunFrame(timer);
+	CHECK(simulation.updateCount == 1);
+	CHECK(renderer.renderedFrames.empty());
+
+	timer.Tick();
+	pipeline.RunFrame(timer);
+	CHECK(simulation.updateCount == 2);
+	CHECK(renderer.renderedFrames == std::vector<uint64_t>({ 0 }));
+
+	CHECK(simulation.errorCount == 0 && renderer.errorCount == 0);
+	JobSystem::Get().Shutdown();
+}
+
+// The headless setup of the benchmarks: the simulation runs every frame in order without a device
+TEST_CASE(FramePipeline_NullRendererRunsFramesInOrder)
+{
+	JobSystem::Get().Initialize(TEST_WORKER_COUNT);
+
+	TestSimulation simulation;
+	NullFrameRenderer renderer;
+	FramePipeline pipeline;
+	pipeline.Initialize(&simulation, &renderer);
+
+	GameTimer timer;
+	timer.Reset();
+	for (int frame = 0; frame < 100; frame++)
+	{
+		timer.Tick();
+		pipeline.RunFrame(timer);
+	}
+
+	CHECK(simulation.updateCount == 100);
+	CHECK(simulation.errorCount == 0);
+	CHECK(pipeline.GetTimings().frameMs >= pipeline.GetTimings().waitMs);
+	JobSystem::Get().Shutdown();
+}
+
+// Frame N is drawn while frame N + 1 is simulated into the other snapshot. Every frame is drawn exactly once,
+// in order, and the snapshot being drawn is never written.
+TEST_CASE(FramePipeline_OverlappedFramesHandOffSnapshotsInOrder)
+{
+	JobSystem::Get().Initialize(TEST_WORKER_COUNT);
+
+	TestSimulation simulation;
+	CheckingRenderer renderer;
+	FramePipeline pipeline;
+	pipeline.Initialize(&simulation, &renderer);
+
+	const uint32_t frameCount = 300;
+	GameTimer timer;
+	timer.Reset();
+	for (uint32_t frame = 0; frame < frameCount; frame++)
+	{
+		timer.Tick();
+		pipeline.RunFrame(timer);
+	}
+
+	CHECK(simulation.updateCount == frameCount);
+	CHECK(renderer.renderedFrames.size() == frameCount - 1);
+	for (uint64_t i = 0; i < renderer.renderedFrames.size(); i++)
+	{
+		CHECK(renderer.renderedFrames[i] == i);
+	}
+	CHECK(simulation.errorCount == 0 && renderer.errorCount == 0);
+	JobSystem::Get().Shutdown();
+}
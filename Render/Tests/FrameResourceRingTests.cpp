@@ -0,0 +1,176 @@
+#include "TestFramework.h"
+#include "../src/Resource/FrameResourceRing.h"
+#include <deque>
+#include <random>
+
+namespace
+{
+	// Counts the live instances, stands in for a constant buffer or an upload heap of a frame
+	struct TrackedResource
+	{
+		int& liveCount;
+		explicit TrackedResource(int& inLiveCount) : liveCount(inLiveCount) { liveCount++; }
+		~TrackedResource() { liveCount--; }
+	};
+}
+
+TEST_CASE(FrameResourceRing_ReleasesAfterTheFrameFence)
+{
+	int liveCount = 0;
+	int eventCount = 0;
+	FrameResourceRing ring(3);
+
+	ring.BeginFrame(0);
+	ring.AddDelayDisposeResource(std::make_shared<TrackedResource>(liveCount));
+	ring.AddAfterSyncEvent([&eventCount]() { eventCount++; });
+
+	// Everything signaled so far completed, the frame being recorded is still kept
+	ring.Retire(0);
+	CHECK(liveCount == 1 && eventCount == 0);
+
+	ring.EndFrame(1);
+	CHECK(ring.GetFrameIndex() == 1);
+	CHECK(ring.GetFramesInFlight() == 1);
+
+	ring.Retire(0);
+	CHECK(liveCount == 1 && eventCount == 0);
+
+	ring.Retire(1);
+	CHECK(liveCount == 0 && eventCount == 1);
+	CHECK(ring.GetFramesInFlight() == 0);
+}
+
+// A slot comes around again after GetFrameCount frames and waits for the fence of its last use
+TEST_CASE(FrameResourceRing_SlotWaitsForItsLastFence)
+{
+	FrameResourceRing ring(3);
+	CHECK(ring.GetWaitFenceValue() == 0);
+
+	uint64_t fenceValue = 0;
+	for (int frame = 0; frame < 3; frame++)
+	{
+		ring.BeginFrame(0);
+		ring.EndFrame(++fenceValue);
+	}
+
+	CHECK(ring.GetFrameIndex() == 0);
+	CHECK(ring.GetWaitFenceValue() == 1);
+	CHECK(ring.GetFramesInFlight() == 3);
+
+	ring.BeginFrame(1);
+	CHECK(ring.GetFramesInFlight() == 2);
+	ring.EndFrame(++fenceValue);
+	CHECK(ring.GetWaitFenceValue() == 2);
+}
+
+// An event of a retired frame may queue more work, it lands in the frame being recorded
+TEST_CASE(FrameResourceRing_EventsQueuedFromEventsWaitForTheNextFrame)
+{
+	FrameResourceRing ring(2);
+	int secondEventCount = 0;
+
+	ring.BeginFrame(0);
+	ring.AddAfterSyncEvent([&]() { ring.AddAfterSyncEvent([&secondEventCount]() { secondEventCount++; }); });
+	ring.EndFrame(1);
+
+	ring.BeginFrame(0);
+	ring.Retire(1);
+	CHECK(secondEventCount == 0);
+	ring.EndFrame(2);
+
+	ring.Retire(2);
+	CHECK(secondEventCount == 1);
+}
+
+// The CPU records up to GetFrameCount frames ahead of a GPU that finishes them at random,
+// every resource lives exactly until the fence of the frame that used it
+TEST_CASE(FrameResourceRing_RandomFenceTrace)
+{
+	const uint32_t frameCount = 3;
+	FrameResourceRing ring(frameCount);
+	std::mt19937 random(3);
+
+	int liveCount = 0;
+	int eventCount = 0;
+	uint32_t errorCount = 0;
+	uint64_t signaledFenceValue = 0;
+	uint64_t completedFenceValue = 0;
+	std::deque<uint64_t> gpuQueue;
+	std::vector<std::pair<uint64_t, std::weak_ptr<TrackedResource>>> tracked;
+
+	for (int frame = 0; frame < 2000; frame++)
+	{
+		// The GPU finishes a frame now and then, the CPU blocks while the next slot is in use
+		while (!gpuQueue.empty() && (random() % 3 == 0 || ring.GetWaitFenceValue() > completedFenceValue))
+		{
+			completedFenceValue = gpuQueue.front();
+			gpuQueue.pop_front();
+		}
+
+		CHECK(ring.GetWaitFenceValue() <= completedFenceValue);
+		ring.BeginFrame(completedFenceValue);
+		CHECK(ring.GetFramesInFlight() < frameCount);
+
+		for (const auto& [fenceValue, resource] : tracked)
+		{
+			if ((fenceValue <= completedFenceValue) != resource.expired())
+			{
+				errorCount++;
+			}
+		}
+
+		auto resource = std::make_shared<TrackedResource>(liveCount);
+		const uint64_t frameFenceValue = signaledFenceValue + 1;
+		tracked.push_back({ frameFenceValue, resource });
+		ring.AddDelayDisposeResource(std::move(resource));
+		ring.AddAfterSyncEvent([&, frameFenceValue]()
+		{
+			if (frameFenceValue > completedFenceValue)
+			{
+				errorCount++;
+			}
+			eventCount++;
+		});
+
+		// A flush in the middle of a frame keeps what the frame handed over
+		if (frame % 50 == 0)
+		{
+			while (!gpuQueue.empty())
+			{
+				completedFenceValue = gpuQueue.front();
+				gpuQueue.pop_front();
+			}
+			ring.Retire(completedFenceValue);
+			CHECK(!tracked.back().second.expired());
+		}
+
+		ring.EndFrame(++signaledFenceValue);
+		gpuQueue.push_back(signaledFenceValue);
+	}
+
+	completedFenceValue = signaledFenceValue;
+	ring.Retire(completedFenceValue);
+
+	CHECK(errorCount == 0);
+	CHECK(liveCount == 0 && eventCount == 2000);
+}
+
+// Teardown after the queue was flushed releases whatever is left, including an unfinished frame
+TEST_CASE(FrameResourceRing_DestructorReleasesEverything)
+{
+	int liveCount = 0;
+	int eventCount = 0;
+	{
+		FrameResourceRing ring(3);
+		for (uint64_t fenceValue = 1; fenceValue <= 2; fenceValue++)
+		{
+			ring.BeginFrame(0);
+			ring.AddDelayDisposeResource(std::make_shared<TrackedResource>(liveCount));
+			ring.AddAfterSyncEvent([&eventCount]() { eventCount++; });
+			ring.EndFrame(fenceValue);
+		}
+		ring.AddDelayDisposeResource(std::make_shared<TrackedResource>(liveCount));
+		CHECK(liveCount == 3);
+	}
+	CHECK(liveCount == 0 && eventCount == 2);
+}
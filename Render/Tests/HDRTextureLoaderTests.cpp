@@ -0,0 +1,342 @@
+#include "TestFramework.h"
+#include "../src/TextureLoader/HDRTextureLoader.h"
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	// Wide enough for the run length scheme, with a run the old scheme needs two counts for
+	const uint32_t TEST_WIDTH = 300;
+	const uint32_t TEST_HEIGHT = 6;
+	const uint32_t TEST_LONG_RUN = 260;
+
+	enum class ETestEncoding
+	{
+		Flat,
+		OldRLE,
+		NewRLE,
+	};
+
+	// RGBE pixels, top row first. Noise, a long run of one pixel, a row with only the exponent constant, and a few
+	// black, very dark and dark pixels that 9e5 shifts down.
+	std::vector<uint8_t> MakeTestPixels()
+	{
+		std::mt19937 random(5);
+		std::vector<uint8_t> pixels((size_t)TEST_WIDTH * TEST_HEIGHT * 4);
+		for (uint32_t y = 0; y < TEST_HEIGHT; y++)
+		{
+			for (uint32_t x = 0; x < TEST_WIDTH; x++)
+			{
+				uint8_t* pixel = &pixels[((size_t)y * TEST_WIDTH + x) * 4];
+				do
+				{
+					pixel[0] = random() % 256;
+					pixel[1] = random() % 256;
+					pixel[2] = random() % 256;
+				}
+				// Never a run marker
+				while ((pixel[0] == 1 && pixel[1] == 1 && pixel[2] == 1) || (pixel[0] == 2 && pixel[1] == 2));
+				pixel[3] = y == 2 ? 128 : 110 + random() % 30;
+			}
+		}
+
+		for (uint32_t x = 20; x < 20 + TEST_LONG_RUN; x++)
+		{
+			memcpy(&pixels[((size_t)TEST_WIDTH + x) * 4], &pixels[(size_t)TEST_WIDTH * 4], 4);
+		}
+
+		const uint8_t darkPixels[][4] = { { 0, 0, 0, 0 }, { 200, 100, 50, 100 }, { 255, 128, 3, 106 }, { 130, 2, 60, 111 } };
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			memcpy(&pixels[((size_t)4 * TEST_WIDTH + 7 + i * 50) * 4], darkPixels[i], 4);
+		}
+		return pixels;
+	}
+
+	void WriteString(std::vector<uint8_t>& file, const std::string& text)
+	{
+		file.insert(file.end(), text.begin(), text.end());
+	}
+
+	// Repeats of the previous pixel, the first count in the low byte
+	void WriteOldRun(std::vector<uint8_t>& file, uint32_t count)
+	{
+		for (; count > 0; count >>= 8)
+		{
+			file.insert(file.end(), { 1, 1, 1, (uint8_t)(count & 0xff) });
+		}
+	}
+
+	// Each channel on its own, runs of three or more as (128 + count, value), the rest as (count, values)
+	void WriteNewScanline(std::vector<uint8_t>& file, const uint8_t* row, uint32_t width)
+	{
+		file.insert(file.end(), { 2, 2, (uint8_t)(width >> 8), (uint8_t)(width & 0xff) });
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			auto GetRun = [&](uint32_t x)
+			{
+				uint32_t run = 1;
+				while (x + run < width && run < 127 && row[(x + run) * 4 + c] == row[x * 4 + c])
+				{
+					run++;
+				}
+				return run;
+			};
+
+			uint32_t x = 0;
+			while (x < width)
+			{
+				const uint32_t run = GetRun(x);
+				if (run >= 3)
+				{
+					file.insert(file.end(), { (uint8_t)(128 + run), row[x * 4 + c] });
+					x += run;
+					continue;
+				}
+
+				const uint32_t start = x;
+				while (x < width && x - start < 128 && (x == start || GetRun(x) < 3))
+				{
+					x++;
+				}
+				file.push_back((uint8_t)(x - start));
+				for (uint32_t i = start; i < x; i++)
+				{
+					file.push_back(row[i * 4 + c]);
+				}
+			}
+		}
+	}
+
+	std::vector<uint8_t> MakeTestFile(const std::vector<uint8_t>& pixels, ETestEncoding encoding, bool bTopDown = true)
+	{
+		std::vector<uint8_t> file;
+		WriteString(file, "#?RADIANCE\n# written by the test\nFORMAT=32-bit_rle_rgbe\r\nEXPOSURE=1.0\n\n");
+		WriteString(file, std::string(bTopDown ? "-Y " : "+Y ") + std::to_string(TEST_HEIGHT) + " +X " + std::to_string(TEST_WIDTH) + "\n");
+
+		for (uint32_t line = 0; line < TEST_HEIGHT; line++)
+		{
+			const uint8_t* row = &pixels[(size_t)(bTopDown ? line : TEST_HEIGHT - 1 - line) * TEST_WIDTH * 4];
+			if (encoding == ETestEncoding::NewRLE)
+			{
+				WriteNewScanline(file, row, TEST_WIDTH);
+				continue;
+			}
+
+			uint32_t x = 0;
+			while (x < TEST_WIDTH)
+			{
+				file.insert(file.end(), row + x * 4, row + x * 4 + 4);
+				uint32_t run = 0;
+				while (encoding == ETestEncoding::OldRLE && x + 1 + run < TEST_WIDTH && memcmp(row + (x + 1 + run) * 4, row + x * 4, 4) == 0)
+				{
+					run++;
+				}
+				WriteOldRun(file, run);
+				x += 1 + run;
+			}
+		}
+		return file;
+	}
+
+	// Decodes from a copy of exactly the given size, so that reading past the end is a heap overflow
+	bool Decode(const std::vector<uint8_t>& file, size_t size, EHDRTextureFormat format, std::vector<uint8_t>& outDecoded)
+	{
+		const std::unique_ptr<uint8_t[]> data(new uint8_t[(std::max)(size, (size_t)1)]);
+		memcpy(data.get(), file.data(), size);
+
+		HDRLoadSettings settings;
+		settings.format = format;
+		TextureInfo textureInfo = {};
+		D3D12_SUBRESOURCE_DATA subResource = {};
+		outDecoded.clear();
+		return CreateHDRTextureFromMemory(data.get(), size, textureInfo, subResource, outDecoded, settings);
+	}
+
+	// value = mantissa * 2^(exponent - 136), per channel
+	float GetRGBEValue(const uint8_t* rgbe, uint32_t c)
+	{
+		return rgbe[3] ? std::ldexp((float)rgbe[c], (int)rgbe[3] - 136) : 0.0f;
+	}
+
+	float GetTolerance(float maxValue)
+	{
+		return maxValue * 1e-3f + 1.2e-7f;
+	}
+}
+
+// Flat, old run length and new run length files of the same image decode to the same texels, bottom row first, at the
+// RGBE values. A bottom up file gives the same result.
+TEST_CASE(HDRTextureLoader_EncodingsDecodeTheSame)
+{
+	const std::vector<uint8_t> pixels = MakeTestPixels();
+	const std::vector<uint8_t> flatFile = MakeTestFile(pixels, ETestEncoding::Flat);
+	const std::vector<uint8_t> oldFile = MakeTestFile(pixels, ETestEncoding::OldRLE);
+	const std::vector<uint8_t> newFile = MakeTestFile(pixels, ETestEncoding::NewRLE);
+	const std::vector<uint8_t> bottomUpFile = MakeTestFile(pixels, ETestEncoding::NewRLE, false);
+	std::printf("  file sizes: flat %zu, old rle %zu, new rle %zu bytes\n", flatFile.size(), oldFile.size(), newFile.size());
+	CHECK(oldFile.size() < flatFile.size() - TEST_LONG_RUN * 3);
+
+	for (EHDRTextureFormat format : { EHDRTextureFormat::Half, EHDRTextureFormat::SharedExp })
+	{
+		std::vector<uint8_t> flat, oldRLE, newRLE, bottomUp;
+		CHECK(Decode(flatFile, flatFile.size(), format, flat));
+		CHECK(Decode(oldFile, oldFile.size(), format, oldRLE));
+		CHECK(Decode(newFile, newFile.size(), format, newRLE));
+		CHECK(Decode(bottomUpFile, bottomUpFile.size(), format, bottomUp));
+
+		const size_t texelSize = format == EHDRTextureFormat::Half ? 8 : 4;
+		CHECK(flat.size() == (size_t)TEST_WIDTH * TEST_HEIGHT * texelSize);
+		CHECK(flat == oldRLE);
+		CHECK(flat == newRLE);
+		CHECK(flat == bottomUp);
+	}
+
+	HDRLoadSettings settings;
+	TextureInfo textureInfo = {};
+	D3D12_SUBRESOURCE_DATA subResource = {};
+	std::vector<uint8_t> decoded;
+	CHECK(CreateHDRTextureFromMemory(newFile.data(), newFile.size(), textureInfo, subResource, decoded, settings));
+	CHECK(textureInfo.width == TEST_WIDTH && textureInfo.height == TEST_HEIGHT && textureInfo.mipCount == 1);
+	CHECK(textureInfo.format == DXGI_FORMAT_R16G16B16A16_FLOAT);
+	CHECK(subResource.pData == decoded.data() && subResource.RowPitch == TEST_WIDTH * 8);
+
+	uint32_t errorCount = 0;
+	const HALF* texels = reinterpret_cast<const HALF*>(decoded.data());
+	for (uint32_t y = 0; y < TEST_HEIGHT; y++)
+	{
+		for (uint32_t x = 0; x < TEST_WIDTH; x++)
+		{
+			const uint8_t* rgbe = &pixels[((size_t)(TEST_HEIGHT - 1 - y) * TEST_WIDTH + x) * 4];
+			const HALF* texel = texels + ((size_t)y * TEST_WIDTH + x) * 4;
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				const float expected = GetRGBEValue(rgbe, c);
+				errorCount += std::abs(XMConvertHalfToFloat(texel[c]) - expected) > GetTolerance(expected);
+			}
+			errorCount += XMConvertHalfToFloat(texel[3]) != 1.0f;
+		}
+	}
+	CHECK(errorCount == 0);
+}
+
+// R9G9B9E5 keeps the RGBE mantissas, so it matches the half path to within the half rounding. Pixels too dark for
+// its smallest exponent lose their low bits.
+TEST_CASE(HDRTextureLoader_SharedExpMatchesHalf)
+{
+	const std::vector<uint8_t> file = MakeTestFile(MakeTestPixels(), ETestEncoding::NewRLE);
+
+	std::vector<uint8_t> half, sharedExp;
+	CHECK(Decode(file, file.size(), EHDRTextureFormat::Half, half));
+	CHECK(Decode(file, file.size(), EHDRTextureFormat::SharedExp, sharedExp));
+
+	uint32_t errorCount = 0;
+	float maxRelativeError = 0.0f;
+	for (size_t i = 0; i < (size_t)TEST_WIDTH * TEST_HEIGHT; i++)
+	{
+		const XMVECTOR packed = XMLoadFloat3SE(reinterpret_cast<const XMFLOAT3SE*>(sharedExp.data()) + i);
+		const HALF* texel = reinterpret_cast<const HALF*>(half.data()) + i * 4;
+
+		float maxValue = 0.0f;
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			maxValue = (std::max)(maxValue, XMConvertHalfToFloat(texel[c]));
+		}
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			const float difference = std::abs(XMVectorGetByIndex(packed, c) - XMConvertHalfToFloat(texel[c]));
+			errorCount += difference > GetTolerance(maxValue);
+			// Above the smallest normal half
+			if (maxValue >= 6.2e-5f)
+			{
+				maxRelativeError = (std::max)(maxRelativeError, difference / maxValue);
+			}
+		}
+	}
+
+	std::printf("  9e5 against half: max error %.2e of the brightest channel\n", maxRelativeError);
+	CHECK(errorCount == 0);
+	CHECK(maxRelativeError < 1e-3f);
+}
+
+// Broken headers fail before anything is allocated
+TEST_CASE(HDRTextureLoader_MalformedHeadersFail)
+{
+	const char* headers[] =
+	{
+		"",
+		"#?RADIANCE",
+		"RADIANCE\n\n-Y 2 +X 2\n",
+		"#?RADIANCE\nFORMAT=32-bit_rle_xyze\n\n-Y 2 +X 2\n",
+		"#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n-Y 2 +X 2\n",
+		"#?RADIANCE\n\n+X 2 -Y 2\n",
+		"#?RADIANCE\n\n-Y 0 +X 2\n",
+		"#?RADIANCE\n\n-Y 2 +X -2\n",
+		"#?RADIANCE\n\n-Y 2 +X\n",
+		"#?RADIANCE\n\n-Y 100000 +X 100000\n",
+		"#?RADIANCE\n\n-Y 16384 +X 16384\n",
+	};
+
+	for (const char* header : headers)
+	{
+		std::vector<uint8_t> file, decoded;
+		WriteString(file, header);
+		file.insert(file.end(), 8, 0x40);
+		CHECK(!Decode(file, file.size(), EHDRTextureFormat::Half, decoded));
+		CHECK(decoded.empty());
+	}
+}
+
+// Every cut of a file fails without reading past its end, in the header, between scanlines and inside a run
+TEST_CASE(HDRTextureLoader_TruncatedFilesFail)
+{
+	const std::vector<uint8_t> pixels = MakeTestPixels();
+	for (ETestEncoding encoding : { ETestEncoding::Flat, ETestEncoding::OldRLE, ETestEncoding::NewRLE })
+	{
+		const std::vector<uint8_t> file = MakeTestFile(pixels, encoding);
+		uint32_t errorCount = 0;
+		std::vector<uint8_t> decoded;
+		for (size_t size = 0; size < file.size(); size++)
+		{
+			errorCount += Decode(file, size, EHDRTextureFormat::SharedExp, decoded);
+			errorCount += !decoded.empty();
+		}
+		CHECK(errorCount == 0);
+		CHECK(Decode(file, file.size(), EHDRTextureFormat::SharedExp, decoded));
+	}
+}
+
+// Run lengths that overrun the scanline, or a run with nothing before it, fail the whole file
+TEST_CASE(HDRTextureLoader_OverrunningRunsFail)
+{
+	auto DecodeScanline = [](std::initializer_list<uint8_t> scanline)
+	{
+		std::vector<uint8_t> file, decoded;
+		WriteString(file, "#?RADIANCE\n\n-Y 1 +X 8\n");
+		file.insert(file.end(), scanline);
+		return Decode(file, file.size(), EHDRTextureFormat::Half, decoded);
+	};
+
+	// The same counts that fit succeed
+	CHECK(DecodeScanline({ 2, 2, 0, 8, 136, 10, 136, 20, 136, 30, 4, 1, 2, 3, 4, 132, 128 }));
+	CHECK(DecodeScanline({ 10, 20, 30, 128, 1, 1, 1, 7 }));
+
+	// New scheme: a run, a literal or the line width past the 8 pixels, and a literal of nothing
+	CHECK(!DecodeScanline({ 2, 2, 0, 8, 137, 10, 136, 20, 136, 30, 136, 128 }));
+	CHECK(!DecodeScanline({ 2, 2, 0, 8, 136, 10, 136, 20, 136, 30, 9, 1, 2, 3, 4, 5, 6, 7, 8, 9 }));
+	CHECK(!DecodeScanline({ 2, 2, 0, 9, 136, 10, 136, 20, 136, 30, 136, 128 }));
+	CHECK(!DecodeScanline({ 2, 2, 0, 8, 0, 136, 10, 136, 20, 136, 30, 136, 128 }));
+
+	// Old scheme: a repeat at the start of the line, one past the end, and counts shifted until they overflow
+	CHECK(!DecodeScanline({ 1, 1, 1, 7, 10, 20, 30, 128 }));
+	CHECK(!DecodeScanline({ 10, 20, 30, 128, 1, 1, 1, 8 }));
+	CHECK(!DecodeScanline({ 10, 20, 30, 128, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1, 7 }));
+}
@@ -0,0 +1,329 @@
+#include "TestFramework.h"
+#include "../src/World/LooseOctree.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	// The scene index settings of World
+	const float TEST_ROOT_HALF_SIZE = 1024.0f;
+	const uint32_t TEST_MAX_DEPTH = 5;
+
+	struct TestObject
+	{
+		TVector3 center;
+		TVector3 halfExtent;
+		TVector3 velocity;
+		uint32_t octreeId = LOOSE_OCTREE_INVALID_ID;
+
+		TVector3 GetMin() const { return center - halfExtent; }
+		TVector3 GetMax() const { return center + halfExtent; }
+	};
+
+	// A flat scene like the test maps: small props, a few large ones, and some outside the root cell
+	std::vector<TestObject> MakeScene(uint32_t objectCount, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		std::vector<TestObject> objects(objectCount);
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			TestObject& object = objects[i];
+			object.center = TVector3(unit(random) * 1000.0f, unit(random) * 100.0f, unit(random) * 1000.0f);
+			const float size = i % 100 == 0 ? 40.0f : 1.5f + unit(random);
+			object.halfExtent = TVector3(size, size * 0.5f, size);
+			object.velocity = TVector3(unit(random) * 2.0f, 0.0f, unit(random) * 2.0f);
+
+			if (i % 5000 == 0)
+			{
+				object.center = TVector3(3000.0f, 0.0f, 0.0f);
+			}
+		}
+		return objects;
+	}
+
+	void AddAll(LooseOctree<TestObject>& octree, std::vector<TestObject>& objects)
+	{
+		for (TestObject& object : objects)
+		{
+			object.octreeId = octree.Add(&object, object.GetMin(), object.GetMax());
+		}
+	}
+
+	// Moves every object and bounces it back at the edge of the scene
+	void MoveAll(LooseOctree<TestObject>& octree, std::vector<TestObject>& objects)
+	{
+		for (TestObject& object : objects)
+		{
+			object.center += object.velocity;
+			if (std::abs(object.center.x) > 1100.0f)
+			{
+				object.velocity.x = -object.velocity.x;
+			}
+			if (std::abs(object.center.z) > 1100.0f)
+			{
+				object.velocity.z = -object.velocity.z;
+			}
+			octree.Update(object.octreeId, object.GetMin(), object.GetMax());
+		}
+	}
+
+	template<typename Test>
+	std::vector<TestObject*> QueryBruteForce(std::vector<TestObject>& objects, const Test& test)
+	{
+		std::vector<TestObject*> result;
+		for (TestObject& object : objects)
+		{
+			if (test(object.GetMin(), object.GetMax()))
+			{
+				result.push_back(&object);
+			}
+		}
+		return result;
+	}
+
+	bool IsSameSet(std::vector<TestObject*> a, std::vector<TestObject*> b)
+	{
+		std::sort(a.begin(), a.end());
+		std::sort(b.begin(), b.end());
+		return a == b;
+	}
+
+	bool SphereTouchesBox(const TVector3& center, float radius, const TVector3& boxMin, const TVector3& boxMax)
+	{
+		TVector3 nearest = center;
+		nearest.Clamp(boxMin, boxMax);
+		return TVector3::DistanceSquared(center, nearest) <= radius * radius;
+	}
+
+	bool BoxTouchesBox(const TVector3& aMin, const TVector3& aMax, const TVector3& bMin, const TVector3& bMax)
+	{
+		return aMin.x <= bMax.x && bMin.x <= aMax.x && aMin.y <= bMax.y && bMin.y <= aMax.y && aMin.z <= bMax.z && bMin.z <= aMax.z;
+	}
+
+	// Clips the segment against each slab without dividing by the direction, independent of QueryRay
+	bool RayTouchesBox(const Ray& ray, const TVector3& boxMin, const TVector3& boxMax)
+	{
+		float t0 = 0.0f;
+		float t1 = ray.maxDist;
+		for (int i = 0; i < 3; i++)
+		{
+			const float origin = ray.origin[i];
+			const float direction = ray.direction[i];
+			if (direction == 0.0f)
+			{
+				if (origin < boxMin[i] || origin > boxMax[i])
+				{
+					return false;
+				}
+				continue;
+			}
+
+			float tNear = (boxMin[i] - origin) / direction;
+			float tFar = (boxMax[i] - origin) / direction;
+			if (tNear > tFar)
+			{
+				std::swap(tNear, tFar);
+			}
+			t0 = (std::max)(t0, tNear);
+			t1 = (std::min)(t1, tFar);
+		}
+		return t0 <= t1;
+	}
+
+	TFrustum MakeCameraFrustum(const TVector3& eye, float yaw)
+	{
+		const TVector3 target = eye + TVector3(std::cos(yaw), -0.1f, std::sin(yaw));
+		const TMatrix view = TMatrix::CreateLookAt(eye, target, TVector3(0.0f, 1.0f, 0.0f));
+		const TMatrix proj = TMatrix::CreatePerspectiveFieldOfView(1.0f, 16.0f / 9.0f, 1.0f, 600.0f);
+		return TFrustum::FromViewProj(view * proj);
+	}
+}
+
+// Moving objects, removals and re-adds, every query returns exactly the objects a scan of all of them finds
+TEST_CASE(LooseOctree_QueriesMatchBruteForce)
+{
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<TestObject> objects = MakeScene(20000, random);
+	LooseOctree<TestObject> octree(TVector3::Zero, TEST_ROOT_HALF_SIZE, TEST_MAX_DEPTH);
+	AddAll(octree, objects);
+	CHECK(octree.GetObjectCount() == objects.size());
+
+	uint32_t mismatchCount = 0;
+	std::vector<TestObject*> result;
+	for (int frame = 0; frame < 30; frame++)
+	{
+		MoveAll(octree, objects);
+
+		for (int i = 0; i < 100; i++)
+		{
+			TestObject& object = objects[(frame * 977 + i * 131) % objects.size()];
+			octree.Remove(object.octreeId);
+			object.octreeId = octree.Add(&object, object.GetMin(), object.GetMax());
+		}
+
+		const TFrustum frustum = MakeCameraFrustum(TVector3(unit(random) * 500.0f, 20.0f, unit(random) * 500.0f), frame * 0.2f);
+		result.clear();
+		octree.QueryFrustum(frustum, result);
+		mismatchCount += !IsSameSet(result, QueryBruteForce(objects,
+			[&frustum](const TVector3& boxMin, const TVector3& boxMax) { return frustum.TestBox(boxMin, boxMax) >= 0; }));
+
+		const TVector3 sphereCenter(unit(random) * 800.0f, 0.0f, unit(random) * 800.0f);
+		result.clear();
+		octree.QuerySphere(sphereCenter, 60.0f, result);
+		mismatchCount += !IsSameSet(result, QueryBruteForce(objects,
+			[&sphereCenter](const TVector3& boxMin, const TVector3& boxMax) { return SphereTouchesBox(sphereCenter, 60.0f, boxMin, boxMax); }));
+
+		const TVector3 queryMin(unit(random) * 800.0f, -20.0f, unit(random) * 800.0f);
+		const TVector3 queryMax = queryMin + TVector3(100.0f, 40.0f, 100.0f);
+		result.clear();
+		octree.QueryBox(queryMin, queryMax, result);
+		mismatchCount += !IsSameSet(result, QueryBruteForce(objects,
+			[&](const TVector3& boxMin, const TVector3& boxMax) { return BoxTouchesBox(queryMin, queryMax, boxMin, boxMax); }));
+
+		TVector3 direction(unit(random) * 0.3f, 0.01f, 1.0f);
+		direction.Normalize();
+		const Ray ray(TVector3(unit(random) * 900.0f, 0.2f, -1050.0f), direction, 2100.0f);
+		result.clear();
+		octree.QueryRay(ray, result);
+		mismatchCount += !IsSameSet(result, QueryBruteForce(objects,
+			[&ray](const TVector3& boxMin, const TVector3& boxMax) { return RayTouchesBox(ray, boxMin, boxMax); }));
+	}
+	CHECK(mismatchCount == 0);
+
+	for (TestObject& object : objects)
+	{
+		octree.Remove(object.octreeId);
+	}
+	CHECK(octree.GetObjectCount() == 0);
+	CHECK(octree.GetNodeCount() == 1);
+}
+
+// Rays along the axes have zero direction components, of either sign. A box is hit when the origin lies in its
+// slab, including on a face.
+TEST_CASE(LooseOctree_AxisAlignedRays)
+{
+	std::vector<TestObject> objects(1);
+	objects[0].center = TVector3(10.5f, 20.5f, 30.5f);
+	objects[0].halfExtent = TVector3(0.5f);
+
+	LooseOctree<TestObject> octree(TVector3::Zero, 64.0f);
+	AddAll(octree, objects);
+
+	std::vector<TestObject*> result;
+	for (float zero : { 0.0f, -0.0f })
+	{
+		for (float x : { 10.0f, 10.5f, 11.0f })
+		{
+			for (float y : { 20.0f, 20.5f, 21.0f })
+			{
+				result.clear();
+				octree.QueryRay(Ray(TVector3(x, y, 0.0f), TVector3(zero, zero, 1.0f), 100.0f), result);
+				CHECK(result.size() == 1);
+
+				result.clear();
+				octree.QueryRay(Ray(TVector3(x, y, 60.0f), TVector3(zero, zero, -1.0f), 100.0f), result);
+				CHECK(result.size() == 1);
+			}
+		}
+
+		// Next to the slab, or stopping short of the box
+		result.clear();
+		octree.QueryRay(Ray(TVector3(11.01f, 20.5f, 0.0f), TVector3(zero, zero, 1.0f), 100.0f), result);
+		CHECK(result.empty());
+
+		result.clear();
+		octree.QueryRay(Ray(TVector3(10.5f, 20.5f, 0.0f), TVector3(zero, zero, 1.0f), 29.9f), result);
+		CHECK(result.empty());
+	}
+}
+
+// 100k moving objects: the update of every object per frame, and each query through the tree and over every object
+BENCHMARK_CASE(LooseOctree_QueriesVsBruteForce)
+{
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<TestObject> objects = MakeScene(100000, random);
+	LooseOctree<TestObject> octree(TVector3::Zero, TEST_ROOT_HALF_SIZE, TEST_MAX_DEPTH);
+
+	BenchmarkTimer addTimer;
+	AddAll(octree, objects);
+	const double addMs = addTimer.GetElapsedMs();
+
+	const int frameCount = 20;
+	double updateMs = 0.0;
+	double octreeMs[4] = {};
+	double bruteForceMs[4] = {};
+	size_t hitCount[4] = {};
+	uint32_t mismatchCount = 0;
+
+	std::vector<TestObject*> result;
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		BenchmarkTimer updateTimer;
+		MoveAll(octree, objects);
+		updateMs += updateTimer.GetElapsedMs();
+
+		const TFrustum frustum = MakeCameraFrustum(TVector3(unit(random) * 500.0f, 20.0f, unit(random) * 500.0f), frame * 0.3f);
+		const TVector3 sphereCenter(unit(random) * 800.0f, 0.0f, unit(random) * 800.0f);
+		const TVector3 queryMin(unit(random) * 800.0f, -20.0f, unit(random) * 800.0f);
+		const TVector3 queryMax = queryMin + TVector3(100.0f, 40.0f, 100.0f);
+		TVector3 direction(unit(random) * 0.3f, 0.01f, 1.0f);
+		direction.Normalize();
+		const Ray ray(TVector3(unit(random) * 900.0f, 0.2f, -1050.0f), direction, 2100.0f);
+
+		for (int query = 0; query < 4; query++)
+		{
+			result.clear();
+			BenchmarkTimer octreeTimer;
+			switch (query)
+			{
+			case 0: octree.QueryFrustum(frustum, result); break;
+			case 1: octree.QuerySphere(sphereCenter, 60.0f, result); break;
+			case 2: octree.QueryBox(queryMin, queryMax, result); break;
+			default: octree.QueryRay(ray, result); break;
+			}
+			octreeMs[query] += octreeTimer.GetElapsedMs();
+
+			std::vector<TestObject*> expected;
+			BenchmarkTimer bruteForceTimer;
+			switch (query)
+			{
+			case 0:
+				expected = QueryBruteForce(objects, [&frustum](const TVector3& boxMin, const TVector3& boxMax) { return frustum.TestBox(boxMin, boxMax) >= 0; });
+				break;
+			case 1:
+				expected = QueryBruteForce(objects, [&sphereCenter](const TVector3& boxMin, const TVector3& boxMax) { return SphereTouchesBox(sphereCenter, 60.0f, boxMin, boxMax); });
+				break;
+			case 2:
+				expected = QueryBruteForce(objects, [&](const TVector3& boxMin, const TVector3& boxMax) { return BoxTouchesBox(queryMin, queryMax, boxMin, boxMax); });
+				break;
+			default:
+				expected = QueryBruteForce(objects, [&ray](const TVector3& boxMin, const TVector3& boxMax) { return RayTouchesBox(ray, boxMin, boxMax); });
+				break;
+			}
+			bruteForceMs[query] += bruteForceTimer.GetElapsedMs();
+
+			hitCount[query] += result.size();
+			mismatchCount += !IsSameSet(result, expected);
+		}
+	}
+
+	CHECK(mismatchCount == 0);
+	std::printf("  %zu objects, %u nodes, add %.2f ms, update of every object %.2f ms per frame\n",
+		objects.size(), octree.GetNodeCount(), addMs, updateMs / frameCount);
+
+	const char* queryNames[4] = { "frustum", "sphere", "box", "ray" };
+	for (int query = 0; query < 4; query++)
+	{
+		std::printf("  %-8s %6zu hits: octree %.3f ms, brute force %.3f ms (%.0fx)\n", queryNames[query], hitCount[query] / frameCount,
+			octreeMs[query] / frameCount, bruteForceMs[query] / frameCount, bruteForceMs[query] / octreeMs[query]);
+	}
+
+	// The small queries touch a few cells, scanning every object is several times slower
+	CHECK(octreeMs[1] * 3.0 < bruteForceMs[1]);
+	CHECK(octreeMs[2] * 3.0 < bruteForceMs[2]);
+}
@@ -0,0 +1,214 @@
+#include "TestFramework.h"
+#include "../src/Mesh/MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+	struct TestMesh
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+	};
+
+	// Grid of quads where every quad has its own 4 vertices, like a mesh exported with split normals,
+	// and the triangles are shuffled so the original order has no locality at all
+	TestMesh MakeShuffledSplitGrid(uint32_t size, uint32_t seed)
+	{
+		TestMesh mesh;
+		for (uint32_t i = 0; i < size; i++)
+		{
+			for (uint32_t j = 0; j < size; j++)
+			{
+				const uint32_t base = (uint32_t)mesh.vertices.size();
+				for (uint32_t k = 0; k < 4; k++)
+				{
+					const float x = float(i + (k & 1));
+					const float y = float(j + (k >> 1));
+					mesh.vertices.push_back(Vertex(x, y, std::sin(x * 0.3f), 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, x / size, y / size));
+				}
+
+				const uint32_t quad[6] = { base, base + 1, base + 2, base + 2, base + 1, base + 3 };
+				mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+			}
+		}
+
+		std::vector<uint32_t> triangles(mesh.indices.size() / 3);
+		for (uint32_t t = 0; t < (uint32_t)triangles.size(); t++)
+		{
+			triangles[t] = t;
+		}
+		std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+
+		std::vector<uint32_t> shuffled;
+		for (uint32_t t : triangles)
+		{
+			shuffled.insert(shuffled.end(), mesh.indices.begin() + t * 3, mesh.indices.begin() + t * 3 + 3);
+		}
+		mesh.indices = shuffled;
+
+		return mesh;
+	}
+
+	// UV sphere with shared vertices, the procedural mesh case
+	TestMesh MakeSphere(uint32_t sliceCount, uint32_t stackCount)
+	{
+		const float pi = 3.1415926535f;
+
+		TestMesh mesh;
+		for (uint32_t stack = 0; stack <= stackCount; stack++)
+		{
+			const float phi = pi * stack / stackCount;
+			for (uint32_t slice = 0; slice <= sliceCount; slice++)
+			{
+				const float theta = 2.0f * pi * slice / sliceCount;
+				const float x = std::sin(phi) * std::cos(theta);
+				const float y = std::cos(phi);
+				const float z = std::sin(phi) * std::sin(theta);
+				mesh.vertices.push_back(Vertex(x, y, z, x, y, z, -std::sin(theta), 0.0f, std::cos(theta),
+					(float)slice / sliceCount, (float)stack / stackCount));
+			}
+		}
+
+		const uint32_t ringVertexCount = sliceCount + 1;
+		for (uint32_t stack = 0; stack < stackCount; stack++)
+		{
+			for (uint32_t slice = 0; slice < sliceCount; slice++)
+			{
+				const uint32_t a = stack * ringVertexCount + slice;
+				const uint32_t b = a + ringVertexCount;
+				const uint32_t quad[6] = { a, a + 1, b, b, a + 1, b + 1 };
+				mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+			}
+		}
+
+		return mesh;
+	}
+
+	// The steps of MeshOptimizer::Optimize on a single subset, the geometry must stay the same after each of them
+	void OptimizeAndCheckIdentity(TestMesh& mesh)
+	{
+		const TestMesh original = mesh;
+
+		MeshOptimizer::RemoveDuplicateVertices(mesh.vertices, mesh.indices);
+		CHECK(MeshOptimizer::IsGeometryEqual(original.vertices, original.indices, mesh.vertices, mesh.indices));
+
+		MeshOptimizer::OptimizeVertexCache(mesh.indices, (uint32_t)mesh.vertices.size());
+		CHECK(MeshOptimizer::IsGeometryEqual(original.vertices, original.indices, mesh.vertices, mesh.indices));
+
+		MeshOptimizer::OptimizeOverdraw(mesh.indices, mesh.vertices);
+		CHECK(MeshOptimizer::IsGeometryEqual(original.vertices, original.indices, mesh.vertices, mesh.indices));
+
+		MeshOptimizer::OptimizeVertexFetch(mesh.vertices, mesh.indices);
+		CHECK(MeshOptimizer::IsGeometryEqual(original.vertices, original.indices, mesh.vertices, mesh.indices));
+	}
+}
+
+TEST_CASE(MeshOptimizer_AnalyzeVertexCacheCountsFifoMisses)
+{
+	// Two triangles sharing an edge, 4 misses for 2 triangles
+	const std::vector<uint32_t> quad = { 0, 1, 2, 2, 1, 3 };
+	VertexCacheStats stats = MeshOptimizer::AnalyzeVertexCache(quad, 4);
+	CHECK_NEAR(stats.ACMR, 2.0f, 1e-6f);
+	CHECK_NEAR(stats.ATVR, 1.0f, 1e-6f);
+
+	// With a 3 entry FIFO vertex 0 is pushed out by 3 and must be transformed again
+	const std::vector<uint32_t> fan = { 0, 1, 2, 2, 3, 0 };
+	stats = MeshOptimizer::AnalyzeVertexCache(fan, 4, 3);
+	CHECK_NEAR(stats.ACMR, 2.5f, 1e-6f);
+	CHECK_NEAR(stats.ATVR, 1.25f, 1e-6f);
+}
+
+TEST_CASE(MeshOptimizer_IsGeometryEqualDetectsChanges)
+{
+	const TestMesh mesh = MakeSphere(8, 6);
+
+	// Rotating the corners of a triangle keeps it, reordering triangles keeps the mesh
+	TestMesh rotated = mesh;
+	std::rotate(rotated.indices.begin(), rotated.indices.begin() + 1, rotated.indices.begin() + 3);
+	std::swap_ranges(rotated.indices.begin(), rotated.indices.begin() + 3, rotated.indices.end() - 3);
+	CHECK(MeshOptimizer::IsGeometryEqual(mesh.vertices, mesh.indices, rotated.vertices, rotated.indices));
+
+	// Flipping the winding of one triangle changes the mesh
+	TestMesh flipped = mesh;
+	std::swap(flipped.indices[1], flipped.indices[2]);
+	CHECK(!MeshOptimizer::IsGeometryEqual(mesh.vertices, mesh.indices, flipped.vertices, flipped.indices));
+
+	TestMesh dropped = mesh;
+	dropped.indices.resize(dropped.indices.size() - 3);
+	CHECK(!MeshOptimizer::IsGeometryEqual(mesh.vertices, mesh.indices, dropped.vertices, dropped.indices));
+}
+
+TEST_CASE(MeshOptimizer_SplitGridKeepsGeometryAndWelds)
+{
+	const uint32_t size = 40;
+	TestMesh mesh = MakeShuffledSplitGrid(size, 1);
+	const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(mesh.indices, (uint32_t)mesh.vertices.size());
+
+	OptimizeAndCheckIdentity(mesh);
+
+	// Neighbouring quads share their corners after welding
+	CHECK(mesh.vertices.size() == (size + 1) * (size + 1));
+
+	const VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(mesh.indices, (uint32_t)mesh.vertices.size());
+	CHECK(after.ACMR < before.ACMR);
+	CHECK(after.ACMR < 0.8f);
+
+	// Vertex fetch order, every vertex is first used in index order
+	uint32_t nextVertex = 0;
+	for (uint32_t index : mesh.indices)
+	{
+		CHECK(index <= nextVertex);
+		nextVertex = (std::max)(nextVertex, index + 1);
+	}
+}
+
+TEST_CASE(MeshOptimizer_SphereKeepsGeometry)
+{
+	TestMesh mesh = MakeSphere(64, 32);
+	const size_t vertexCount = mesh.vertices.size();
+	const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(mesh.indices, (uint32_t)mesh.vertices.size());
+
+	OptimizeAndCheckIdentity(mesh);
+
+	// The seam vertices differ in uv and are kept
+	CHECK(mesh.vertices.size() <= vertexCount);
+
+	const VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(mesh.indices, (uint32_t)mesh.vertices.size());
+	CHECK(after.ACMR <= before.ACMR * 1.05f);
+}
+
+// ACMR and ATVR before and after, for the shuffled split grid and the sphere
+BENCHMARK_CASE(MeshOptimizer_ACMRReport)
+{
+	struct NamedMesh
+	{
+		const char* name;
+		TestMesh mesh;
+	};
+	NamedMesh meshes[] = {
+		{ "split grid 256x256", MakeShuffledSplitGrid(256, 3) },
+		{ "sphere 256x128", MakeSphere(256, 128) },
+	};
+
+	for (NamedMesh& namedMesh : meshes)
+	{
+		TestMesh& mesh = namedMesh.mesh;
+		const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(mesh.indices, (uint32_t)mesh.vertices.size());
+		const size_t triangleCount = mesh.indices.size() / 3;
+
+		BenchmarkTimer timer;
+		MeshOptimizer::RemoveDuplicateVertices(mesh.vertices, mesh.indices);
+		MeshOptimizer::OptimizeVertexCache(mesh.indices, (uint32_t)mesh.vertices.size());
+		MeshOptimizer::OptimizeOverdraw(mesh.indices, mesh.vertices);
+		MeshOptimizer::OptimizeVertexFetch(mesh.vertices, mesh.indices);
+		const double durationMs = timer.GetElapsedMs();
+
+		const VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(mesh.indices, (uint32_t)mesh.vertices.size());
+		std::printf("  %s, %zu triangles: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %.1f ms\n", namedMesh.name, triangleCount,
+			before.ACMR, after.ACMR, before.ATVR, after.ATVR, durationMs);
+
+		CHECK(after.ACMR <= before.ACMR * 1.05f);
+	}
+}
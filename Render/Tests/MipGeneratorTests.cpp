@@ -0,0 +1,274 @@
+#include "TestFramework.h"
+#include "../src/Texture/MipGenerator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	struct TestTexture
+	{
+		TextureInfo textureInfo = {};
+		std::vector<uint8_t> textureData;
+		std::vector<D3D12_SUBRESOURCE_DATA> initData;
+	};
+
+	TestTexture MakeTexture(uint32_t width, uint32_t height, DXGI_FORMAT format, uint32_t pixelSize)
+	{
+		TestTexture texture;
+		texture.textureInfo.textureType = ETextureType::TEXTURE_2D;
+		texture.textureInfo.dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		texture.textureInfo.width = width;
+		texture.textureInfo.height = height;
+		texture.textureInfo.depth = 1;
+		texture.textureInfo.arraySize = 1;
+		texture.textureInfo.mipCount = 1;
+		texture.textureInfo.format = format;
+		texture.textureData.resize((size_t)width * height * pixelSize);
+
+		D3D12_SUBRESOURCE_DATA subResource;
+		subResource.pData = texture.textureData.data();
+		subResource.RowPitch = (LONG_PTR)width * pixelSize;
+		subResource.SlicePitch = (LONG_PTR)texture.textureData.size();
+		texture.initData.push_back(subResource);
+
+		return texture;
+	}
+
+	const uint8_t* GetMipData(const TestTexture& texture, uint32_t mip)
+	{
+		return static_cast<const uint8_t*>(texture.initData[mip].pData);
+	}
+}
+
+TEST_CASE(MipGenerator_MipCount)
+{
+	CHECK(MipGenerator::GetMipCount(1, 1) == 1);
+	CHECK(MipGenerator::GetMipCount(2, 1) == 2);
+	CHECK(MipGenerator::GetMipCount(7, 5) == 3);
+	CHECK(MipGenerator::GetMipCount(2048, 1024) == 12);
+	CHECK(MipGenerator::GetMipCount(1, 1000) == 10);
+}
+
+// 4x4 R8 with known values, the box filter is the plain 2x2 average
+TEST_CASE(MipGenerator_BoxGoldenR8)
+{
+	TestTexture texture = MakeTexture(4, 4, DXGI_FORMAT_R8_UNORM, 1);
+	const uint8_t source[16] = {
+		0,   20,  100, 100,
+		40,  60,  100, 100,
+		255, 255, 10,  30,
+		255, 255, 50,  70,
+	};
+	std::copy(source, source + 16, texture.textureData.begin());
+
+	CHECK(MipGenerator::GenerateMips(texture.textureInfo, texture.textureData, texture.initData, MipGenerateSettings()));
+	CHECK(texture.textureInfo.mipCount == 3);
+	CHECK(texture.initData.size() == 3);
+	CHECK(texture.initData[1].RowPitch == 2 && texture.initData[1].SlicePitch == 4);
+	CHECK(texture.initData[2].RowPitch == 1 && texture.initData[2].SlicePitch == 1);
+
+	// Mip 0 is copied as is
+	CHECK(std::equal(source, source + 16, GetMipData(texture, 0)));
+
+	const uint8_t* mip1 = GetMipData(texture, 1);
+	CHECK(mip1[0] == 30 && mip1[1] == 100 && mip1[2] == 255 && mip1[3] == 40);
+
+	// (30 + 100 + 255 + 40) / 4 = 106.25, from the float level not the rounded one
+	const uint8_t* mip2 = GetMipData(texture, 2);
+	CHECK(mip2[0] == 106);
+}
+
+// Black and white pixels average to linear 0.5, which is 188 in sRGB and not 128
+TEST_CASE(MipGenerator_BoxGoldenSRGB)
+{
+	TestTexture texture = MakeTexture(2, 2, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 4);
+	const uint8_t source[16] = {
+		0,   0,   0,   255,   255, 255, 255, 255,
+		255, 255, 255, 255,   0,   0,   0,   255,
+	};
+	std::copy(source, source + 16, texture.textureData.begin());
+
+	CHECK(MipGenerator::GenerateMips(texture.textureInfo, texture.textureData, texture.initData, MipGenerateSettings()));
+	CHECK(texture.textureInfo.mipCount == 2);
+
+	const uint8_t* mip1 = GetMipData(texture, 1);
+	CHECK(mip1[0] == 188 && mip1[1] == 188 && mip1[2] == 188);
+	CHECK(mip1[3] == 255); // alpha is linear
+
+	// The same data as UNORM is averaged as is
+	texture = MakeTexture(2, 2, DXGI_FORMAT_R8G8B8A8_UNORM, 4);
+	std::copy(source, source + 16, texture.textureData.begin());
+	CHECK(MipGenerator::GenerateMips(texture.textureInfo, texture.textureData, texture.initData, MipGenerateSettings()));
+	CHECK(GetMipData(texture, 1)[0] == 128);
+}
+
+// 3x3 to 1x1, the box footprint covers all 9 pixels with equal area
+TEST_CASE(MipGenerator_BoxGoldenOddSize)
+{
+	TestTexture texture = MakeTexture(3, 3, DXGI_FORMAT_R32_FLOAT, 4);
+	float* pixels = reinterpret_cast<float*>(texture.textureData.data());
+	for (int i = 0; i < 9; i++)
+	{
+		pixels[i] = (float)i;
+	}
+
+	CHECK(MipGenerator::GenerateMips(texture.textureInfo, texture.textureData, texture.initData, MipGenerateSettings()));
+	CHECK(texture.textureInfo.mipCount == 2);
+	CHECK_NEAR(reinterpret_cast<const float*>(GetMipData(texture, 1))[0], 4.0f, 1e-5f);
+}
+
+// Both filters are normalized, a constant image stays constant in every mip including the edges
+TEST_CASE(MipGenerator_ConstantImageStaysConstant)
+{
+	for (EMipFilter filter : { EMipFilter::Box, EMipFilter::Kaiser })
+	{
+		TestTexture texture = MakeTexture(37, 20, DXGI_FORMAT_R32G32B32A32_FLOAT, 16);
+		float* pixels = reinterpret_cast<float*>(texture.textureData.data());
+		for (size_t i = 0; i < 37 * 20; i++)
+		{
+			pixels[i * 4 + 0] = 0.25f;
+			pixels[i * 4 + 1] = 0.5f;
+			pixels[i * 4 + 2] = 2.0f;
+			pixels[i * 4 + 3] = 1.0f;
+		}
+
+		MipGenerateSettings settings;
+		settings.filter = filter;
+		CHECK(MipGenerator::GenerateMips(texture.textureInfo, texture.textureData, texture.initData, settings));
+		CHECK(texture.textureInfo.mipCount == 6);
+
+		for (uint32_t mip = 1; mip < texture.textureInfo.mipCount; mip++)
+		{
+			const float* mipPixels = reinterpret_cast<const float*>(GetMipData(texture, mip));
+			const size_t pixelCount = texture.initData[mip].SlicePitch / 16;
+			for (size_t i = 0; i < pixelCount; i++)
+			{
+				CHECK_NEAR(mipPixels[i * 4 + 0], 0.25f, 1e-5f);
+				CHECK_NEAR(mipPixels[i * 4 + 1], 0.5f, 1e-5f);
+				CHECK_NEAR(mipPixels[i * 4 + 2], 2.0f, 1e-5f);
+			}
+		}
+	}
+}
+
+// A single bright pixel, the Kaiser lobes go negative around it but the output is clamped to zero
+TEST_CASE(MipGenerator_KaiserClampsNegativeLobes)
+{
+	TestTexture texture = MakeTexture(16, 16, DXGI_FORMAT_R32_FLOAT, 4);
+	reinterpret_cast<float*>(texture.textureData.data())[8 * 16 + 8] = 100.0f;
+
+	MipGenerateSettings settings;
+	settings.filter = EMipFilter::Kaiser;
+	CHECK(MipGenerator::GenerateMips(texture.textureInfo, texture.textureData, texture.initData, settings));
+
+	for (uint32_t mip = 1; mip < texture.textureInfo.mipCount; mip++)
+	{
+		const float* mipPixels = reinterpret_cast<const float*>(GetMipData(texture, mip));
+		for (size_t i = 0; i < (size_t)texture.initData[mip].SlicePitch / 4; i++)
+		{
+			CHECK(mipPixels[i] >= 0.0f);
+		}
+	}
+}
+
+// Foliage like cutout where a third of the texels pass the alpha test, a plain average drifts towards
+// the mean alpha and changes that, with the coverage reference every mip keeps it
+TEST_CASE(MipGenerator_AlphaCoveragePreserved)
+{
+	const uint32_t size = 128;
+	TestTexture texture = MakeTexture(size, size, DXGI_FORMAT_R8G8B8A8_UNORM, 4);
+	uint32_t coveredCount = 0;
+	for (uint32_t y = 0; y < size; y++)
+	{
+		for (uint32_t x = 0; x < size; x++)
+		{
+			const float alpha = 0.4f + 0.6f * std::sin(x * 0.9f) * std::sin(y * 0.55f);
+			uint8_t* pixel = &texture.textureData[(y * size + x) * 4];
+			pixel[0] = pixel[1] = pixel[2] = 128;
+			pixel[3] = (uint8_t)std::lround(std::clamp(alpha, 0.0f, 1.0f) * 255.0f);
+			coveredCount += pixel[3] > 127 ? 1 : 0;
+		}
+	}
+	const float sourceCoverage = (float)coveredCount / (size * size);
+
+	MipGenerateSettings settings;
+	settings.alphaCoverageRef = 0.5f;
+	CHECK(MipGenerator::GenerateMips(texture.textureInfo, texture.textureData, texture.initData, settings));
+
+	for (uint32_t mip = 1; mip < 4; mip++)
+	{
+		const uint8_t* mipPixels = GetMipData(texture, mip);
+		const size_t pixelCount = texture.initData[mip].SlicePitch / 4;
+		size_t mipCoveredCount = 0;
+		for (size_t i = 0; i < pixelCount; i++)
+		{
+			mipCoveredCount += mipPixels[i * 4 + 3] > 127 ? 1 : 0;
+		}
+
+		const float coverage = (float)mipCoveredCount / pixelCount;
+		CHECK_NEAR(coverage, sourceCoverage, 2.0f / std::sqrt((float)pixelCount));
+	}
+}
+
+TEST_CASE(MipGenerator_RejectsUnsupportedTextures)
+{
+	TestTexture texture = MakeTexture(8, 8, DXGI_FORMAT_BC1_UNORM, 1);
+	const TextureInfo textureInfo = texture.textureInfo;
+	CHECK(!MipGenerator::GenerateMips(texture.textureInfo, texture.textureData, texture.initData, MipGenerateSettings()));
+	CHECK(texture.textureInfo.mipCount == textureInfo.mipCount && texture.initData.size() == 1);
+
+	// Already has mips
+	texture = MakeTexture(8, 8, DXGI_FORMAT_R8_UNORM, 1);
+	texture.textureInfo.mipCount = 4;
+	CHECK(!MipGenerator::GenerateMips(texture.textureInfo, texture.textureData, texture.initData, MipGenerateSettings()));
+
+	// Nothing to generate
+	texture = MakeTexture(1, 1, DXGI_FORMAT_R8_UNORM, 1);
+	CHECK(!MipGenerator::GenerateMips(texture.textureInfo, texture.textureData, texture.initData, MipGenerateSettings()));
+}
+
+// Generated megapixels per second for a 4k sRGB color texture and a 2k float HDR texture
+BENCHMARK_CASE(MipGenerator_Throughput)
+{
+	struct BenchmarkTexture
+	{
+		const char* name;
+		uint32_t width;
+		uint32_t height;
+		DXGI_FORMAT format;
+		uint32_t pixelSize;
+	};
+	const BenchmarkTexture benchmarkTextures[] = {
+		{ "4096x4096 RGBA8 sRGB", 4096, 4096, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 4 },
+		{ "2048x1024 RGBA16F", 2048, 1024, DXGI_FORMAT_R16G16B16A16_FLOAT, 8 },
+	};
+
+	for (const BenchmarkTexture& benchmarkTexture : benchmarkTextures)
+	{
+		for (EMipFilter filter : { EMipFilter::Box, EMipFilter::Kaiser })
+		{
+			TestTexture texture = MakeTexture(benchmarkTexture.width, benchmarkTexture.height, benchmarkTexture.format, benchmarkTexture.pixelSize);
+			for (size_t i = 0; i < texture.textureData.size(); i++)
+			{
+				texture.textureData[i] = (uint8_t)(i * 2654435761u >> 24);
+			}
+			if (benchmarkTexture.format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+			{
+				// Keep the halfs finite, 0x3C00 is 1.0
+				uint16_t* halfs = reinterpret_cast<uint16_t*>(texture.textureData.data());
+				for (size_t i = 0; i < texture.textureData.size() / 2; i++)
+				{
+					halfs[i] = 0x3C00 | (halfs[i] & 0x03FF);
+				}
+			}
+
+			MipGenerateSettings settings;
+			settings.filter = filter;
+			MipGenerateStats stats;
+			CHECK(MipGenerator::GenerateMips(texture.textureInfo, texture.textureData, texture.initData, settings, &stats));
+
+			std::printf("  %s %s: %u mips in %.1f ms, %.1f MP/s\n", benchmarkTexture.name, filter == EMipFilter::Box ? "box" : "kaiser",
+				stats.mipCount, stats.durationMs, stats.megaPixelsPerSecond);
+		}
+	}
+}
@@ -0,0 +1,292 @@
+#include "TestFramework.h"
+#include "../src/Render/SVGFDenoiser.h"
+#include <cmath>
+#include <random>
+
+namespace
+{
+	const uint32_t TEST_WIDTH = 96;
+	const uint32_t TEST_HEIGHT = 64;
+
+	// The view of a frame. Moving cameraX pans the whole view, moving discX only moves the disc in front.
+	struct TestView
+	{
+		float cameraX = 0.0f;
+		float discX = -100.0f;
+	};
+
+	struct TestSurface
+	{
+		TVector3 normal;
+		float depth = 0.0f;
+		TVector3 albedo;
+		TVector3 illumination;
+	};
+
+	const float TEST_DISC_RADIUS = 10.0f;
+	const float TEST_DISC_Y = 32.0f;
+
+	bool IsOnDisc(const TestView& view, uint32_t x, uint32_t y)
+	{
+		const float discX = x + 0.5f - view.discX;
+		const float discY = y + 0.5f - TEST_DISC_Y;
+		return discX * discX + discY * discY < TEST_DISC_RADIUS * TEST_DISC_RADIUS;
+	}
+
+	// Sky along the top, a dark wall facing the camera, and a checkered floor lit with a shadow edge. A disc can float
+	// in front of them.
+	TestSurface GetSurface(const TestView& view, uint32_t x, uint32_t y)
+	{
+		const float worldX = x + 0.5f + view.cameraX;
+		const float worldY = y + 0.5f;
+
+		TestSurface surface;
+		if (IsOnDisc(view, x, y))
+		{
+			surface = { TVector3(0.0f, 0.0f, -1.0f), 2.0f, TVector3(0.8f, 0.2f, 0.2f), TVector3(0.6f) };
+		}
+		else if (worldY < 8.0f)
+		{
+			// Nothing hit, the radiance is the illumination
+			surface = { TVector3(0.0f), 0.0f, TVector3(0.0f), TVector3(0.3f, 0.5f, 0.9f) };
+		}
+		else if (worldX >= 40.0f && worldX < 70.0f)
+		{
+			surface = { TVector3(0.0f, 0.0f, -1.0f), 5.0f, TVector3(0.5f), TVector3(0.1f) };
+		}
+		else
+		{
+			const bool bLightTile = (((int)std::floor(worldX / 6.0f) + (int)std::floor(worldY / 6.0f)) & 1) != 0;
+			const float shadow = worldX + 0.5f * worldY > 100.0f ? 0.25f : 1.0f;
+			surface = { TVector3(0.0f, 1.0f, 0.0f), 3.0f + 0.1f * worldY, bLightTile ? TVector3(0.9f) : TVector3(0.2f, 0.4f, 0.2f),
+				TVector3(2.0f * shadow) };
+		}
+		return surface;
+	}
+
+	bool IsBackground(const SVGFFrameInput& frame, size_t index)
+	{
+		return frame.linearDepth[index] == 0.0f;
+	}
+
+	// One path per pixel: the radiance is the reference times exponential noise of mean one
+	void RenderFrame(const TestView& view, const TestView& prevView, bool bNoisy, std::mt19937& random, SVGFFrameInput& outFrame,
+		std::vector<TVector3>& outReference)
+	{
+		const size_t pixelCount = (size_t)TEST_WIDTH * TEST_HEIGHT;
+		outFrame.width = TEST_WIDTH;
+		outFrame.height = TEST_HEIGHT;
+		outFrame.radiance.resize(pixelCount);
+		outFrame.albedo.resize(pixelCount);
+		outFrame.normal.resize(pixelCount);
+		outFrame.linearDepth.resize(pixelCount);
+		outFrame.prevLinearDepth.resize(pixelCount);
+		outFrame.velocity.resize(pixelCount);
+		outReference.resize(pixelCount);
+
+		std::exponential_distribution<float> noise(1.0f);
+		for (uint32_t y = 0; y < TEST_HEIGHT; y++)
+		{
+			for (uint32_t x = 0; x < TEST_WIDTH; x++)
+			{
+				const size_t index = (size_t)y * TEST_WIDTH + x;
+				const TestSurface surface = GetSurface(view, x, y);
+
+				outFrame.normal[index] = surface.normal;
+				outFrame.linearDepth[index] = surface.depth;
+				outFrame.prevLinearDepth[index] = surface.depth;
+				outFrame.albedo[index] = surface.albedo;
+
+				outReference[index] = surface.depth == 0.0f ? surface.illumination : surface.albedo * surface.illumination;
+				outFrame.radiance[index] = bNoisy && surface.depth != 0.0f ? outReference[index] * noise(random) : outReference[index];
+
+				const float motionPixels = IsOnDisc(view, x, y) ? view.discX - prevView.discX : prevView.cameraX - view.cameraX;
+				outFrame.velocity[index] = TVector2(motionPixels / TEST_WIDTH, 0.0f);
+			}
+		}
+	}
+}
+
+// Without noise the denoiser converges to the input. The first frame takes its variance from the neighbourhood, where
+// the shadow edge looks like noise and is blurred a little.
+TEST_CASE(SVGFDenoiser_NoiseFreeInputPassesThrough)
+{
+	std::mt19937 random(7);
+	SVGFFrameInput frame;
+	std::vector<TVector3> reference, denoised;
+
+	const TestView view;
+	RenderFrame(view, view, false, random, frame, reference);
+
+	SVGFDenoiser denoiser;
+	denoiser.Denoise(frame, denoised);
+	const float firstFrameError = SVGFDenoiser::GetRelativeMSE(denoised, reference);
+	for (int i = 1; i < 60; i++)
+	{
+		denoiser.Denoise(frame, denoised);
+	}
+	const float lastFrameError = SVGFDenoiser::GetRelativeMSE(denoised, reference);
+
+	std::printf("  noise free relMSE: first frame %.6f, after 60 frames %.6f\n", firstFrameError, lastFrameError);
+	CHECK(firstFrameError < 0.05f);
+	CHECK(lastFrameError < 1e-6f);
+}
+
+// A still camera: the first frame is already filtered, and the error keeps falling as the history grows
+TEST_CASE(SVGFDenoiser_StaticScene)
+{
+	std::mt19937 random(7);
+	SVGFFrameInput frame;
+	std::vector<TVector3> reference, denoised;
+
+	const TestView view;
+	RenderFrame(view, view, true, random, frame, reference);
+	const float noisyError = SVGFDenoiser::GetRelativeMSE(frame.radiance, reference);
+
+	SVGFDenoiser denoiser;
+	denoiser.Denoise(frame, denoised);
+	const float firstFrameError = SVGFDenoiser::GetRelativeMSE(denoised, reference);
+	for (int i = 1; i < 30; i++)
+	{
+		RenderFrame(view, view, true, random, frame, reference);
+		denoiser.Denoise(frame, denoised);
+	}
+	const float lastFrameError = SVGFDenoiser::GetRelativeMSE(denoised, reference);
+
+	std::printf("  static relMSE: noisy %.4f, first frame %.4f, after 30 frames %.4f\n", noisyError, firstFrameError, lastFrameError);
+	CHECK(firstFrameError < 0.1f);
+	CHECK(lastFrameError < 0.03f);
+
+	uint32_t fullHistoryCount = 0;
+	for (size_t i = 0; i < denoiser.GetHistoryLength().size(); i++)
+	{
+		fullHistoryCount += !IsBackground(frame, i) && denoiser.GetHistoryLength()[i] >= 29.0f;
+	}
+	CHECK(fullHistoryCount > TEST_WIDTH * TEST_HEIGHT / 2);
+}
+
+// The dark wall next to the bright floor: the edge stopping keeps the floor from bleeding into the wall
+TEST_CASE(SVGFDenoiser_EdgeDoesNotBleed)
+{
+	std::mt19937 random(11);
+	SVGFFrameInput frame;
+	std::vector<TVector3> reference, denoised;
+
+	const TestView view;
+	SVGFDenoiser denoiser;
+	for (int i = 0; i < 30; i++)
+	{
+		RenderFrame(view, view, true, random, frame, reference);
+		denoiser.Denoise(frame, denoised);
+	}
+
+	// The first three wall columns, each one next to the floor
+	std::vector<TVector3> edgeDenoised, edgeReference;
+	for (uint32_t y = 10; y < TEST_HEIGHT; y++)
+	{
+		for (uint32_t x = 40; x < 43; x++)
+		{
+			const size_t index = (size_t)y * TEST_WIDTH + x;
+			if (frame.linearDepth[index] == 5.0f)
+			{
+				edgeDenoised.push_back(denoised[index]);
+				edgeReference.push_back(reference[index]);
+			}
+		}
+	}
+
+	const float edgeError = SVGFDenoiser::GetRelativeMSE(edgeDenoised, edgeReference);
+	std::printf("  wall edge relMSE %.4f over %zu pixels\n", edgeError, edgeDenoised.size());
+	CHECK(edgeDenoised.size() > 100);
+	CHECK(edgeError < 0.05f);
+}
+
+// A panning camera, slow to fast: the history follows the velocity and the error stays close to the static one
+TEST_CASE(SVGFDenoiser_CameraPan)
+{
+	for (float speed : { 0.5f, 2.0f, 5.0f })
+	{
+		std::mt19937 random(7);
+		SVGFFrameInput frame;
+		std::vector<TVector3> reference, denoised;
+
+		SVGFDenoiser denoiser;
+		TestView prevView;
+		float noisyError = 0.0f;
+		float denoisedError = 0.0f;
+		const int frameCount = 40;
+		const int warmupFrames = 10;
+		for (int i = 0; i < frameCount; i++)
+		{
+			TestView view;
+			view.cameraX = i * speed;
+			RenderFrame(view, i > 0 ? prevView : view, true, random, frame, reference);
+			denoiser.Denoise(frame, denoised);
+			prevView = view;
+
+			if (i >= warmupFrames)
+			{
+				noisyError += SVGFDenoiser::GetRelativeMSE(frame.radiance, reference);
+				denoisedError += SVGFDenoiser::GetRelativeMSE(denoised, reference);
+			}
+		}
+		noisyError /= frameCount - warmupFrames;
+		denoisedError /= frameCount - warmupFrames;
+
+		std::printf("  pan %.1f px per frame relMSE: noisy %.4f, denoised %.4f\n", speed, noisyError, denoisedError);
+		CHECK(denoisedError < 0.03f);
+	}
+}
+
+// The disc moving over the wall and floor: pixels it uncovers restart their history, the disc keeps its own, and the
+// uncovered pixels are still filtered
+TEST_CASE(SVGFDenoiser_Disocclusion)
+{
+	std::mt19937 random(7);
+	SVGFFrameInput frame;
+	std::vector<TVector3> reference, denoised;
+
+	SVGFDenoiser denoiser;
+	TestView prevView, view;
+	const float discSpeed = 3.0f;
+	for (int i = 0; i < 20; i++)
+	{
+		view.discX = 20.0f + i * discSpeed;
+		RenderFrame(view, i > 0 ? prevView : view, true, random, frame, reference);
+		denoiser.Denoise(frame, denoised);
+		prevView = view;
+	}
+
+	// Uncovered in the last frame, behind the trailing edge of the disc
+	TestView lastView = view;
+	lastView.discX -= discSpeed;
+
+	std::vector<TVector3> revealedDenoised, revealedReference, revealedNoisy;
+	uint32_t errorCount = 0;
+	for (uint32_t y = 0; y < TEST_HEIGHT; y++)
+	{
+		for (uint32_t x = 0; x < TEST_WIDTH; x++)
+		{
+			if (!IsOnDisc(lastView, x, y) || IsOnDisc(view, x, y))
+			{
+				continue;
+			}
+
+			const size_t index = (size_t)y * TEST_WIDTH + x;
+			errorCount += denoiser.GetHistoryLength()[index] > 1.0f;
+			revealedDenoised.push_back(denoised[index]);
+			revealedReference.push_back(reference[index]);
+			revealedNoisy.push_back(frame.radiance[index]);
+		}
+	}
+	CHECK(errorCount == 0);
+	CHECK(revealedDenoised.size() > 20);
+
+	const size_t discCenter = (size_t)TEST_DISC_Y * TEST_WIDTH + (size_t)view.discX;
+	CHECK(denoiser.GetHistoryLength()[discCenter] > 5.0f);
+
+	const float noisyError = SVGFDenoiser::GetRelativeMSE(revealedNoisy, revealedReference);
+	const float revealedError = SVGFDenoiser::GetRelativeMSE(revealedDenoised, revealedReference);
+	std::printf("  disoccluded relMSE over %zu pixels: noisy %.4f, denoised %.4f\n", revealedDenoised.size(), noisyError, revealedError);
+	CHECK(revealedError < noisyError * 0.3f);
+}
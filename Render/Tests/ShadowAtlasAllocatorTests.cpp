@@ -0,0 +1,239 @@
+#include "TestFramework.h"
+#include "../src/Render/ShadowAtlasAllocator.h"
+#include <algorithm>
+#include <functional>
+#include <random>
+
+namespace
+{
+	const uint32_t TEST_ATLAS_SIZE = 4096;
+	const uint32_t TEST_MIN_TILE_SIZE = 64;
+
+	// 64 to 1024 texels, the tile sizes ShadowAtlas asks for
+	const uint32_t TEST_SIZE_COUNT = 5;
+
+	bool IsOverlapping(const ShadowAtlasTile& a, const ShadowAtlasTile& b)
+	{
+		return a.x < b.x + b.size && b.x < a.x + a.size && a.y < b.y + b.size && b.y < a.y + a.size;
+	}
+
+	// Counts the errors: tiles out of the atlas, off their size grid, overlapping, or an allocated area that does not add up
+	uint32_t CheckTiles(const ShadowAtlasAllocator& allocator, const std::vector<ShadowAtlasTile>& tiles)
+	{
+		uint32_t errorCount = 0;
+		uint64_t area = 0;
+		for (size_t i = 0; i < tiles.size(); i++)
+		{
+			const ShadowAtlasTile& tile = tiles[i];
+			errorCount += tile.x % tile.size != 0 || tile.y % tile.size != 0;
+			errorCount += tile.x + tile.size > allocator.GetAtlasSize() || tile.y + tile.size > allocator.GetAtlasSize();
+			area += (uint64_t)tile.size * tile.size;
+
+			for (size_t j = i + 1; j < tiles.size(); j++)
+			{
+				errorCount += IsOverlapping(tile, tiles[j]);
+			}
+		}
+
+		errorCount += area != allocator.GetAllocatedArea();
+		errorCount += tiles.size() != allocator.GetAllocatedCount();
+		return errorCount;
+	}
+
+	void FreeAt(ShadowAtlasAllocator& allocator, std::vector<ShadowAtlasTile>& tiles, size_t index)
+	{
+		allocator.Free(tiles[index]);
+		tiles[index] = tiles.back();
+		tiles.pop_back();
+	}
+
+	double GetUtilisation(const ShadowAtlasAllocator& allocator)
+	{
+		return (double)allocator.GetAllocatedArea() / ((double)allocator.GetAtlasSize() * allocator.GetAtlasSize());
+	}
+}
+
+// Sizes round up to a power of two between the min tile size and the atlas
+TEST_CASE(ShadowAtlasAllocator_RoundsTileSizes)
+{
+	ShadowAtlasAllocator allocator(TEST_ATLAS_SIZE, TEST_MIN_TILE_SIZE);
+	CHECK(allocator.RoundTileSize(1) == 64);
+	CHECK(allocator.RoundTileSize(64) == 64);
+	CHECK(allocator.RoundTileSize(100) == 128);
+	CHECK(allocator.RoundTileSize(1024) == 1024);
+	CHECK(allocator.RoundTileSize(5000) == 4096);
+
+	ShadowAtlasTile tile;
+	CHECK(allocator.Allocate(300, tile) && tile.size == 512 && tile.IsValid());
+	allocator.Free(tile);
+	CHECK(!tile.IsValid());
+
+	// The atlas and the min tile are rounded up too
+	ShadowAtlasAllocator oddAllocator(3000, 50);
+	CHECK(oddAllocator.GetAtlasSize() == 4096 && oddAllocator.GetMinTileSize() == 64);
+}
+
+// A small tile splits its way down from the whole atlas, freeing it merges the buddies back up level by level
+TEST_CASE(ShadowAtlasAllocator_FreeMergesBuddies)
+{
+	ShadowAtlasAllocator allocator(TEST_ATLAS_SIZE, TEST_MIN_TILE_SIZE);
+	CHECK(allocator.GetLargestFreeSize() == TEST_ATLAS_SIZE);
+
+	ShadowAtlasTile small;
+	CHECK(allocator.Allocate(64, small));
+	CHECK(allocator.GetLargestFreeSize() == 2048);
+
+	// The next tiles come out of the split, not out of the untouched quarters
+	ShadowAtlasTile neighbour;
+	CHECK(allocator.Allocate(64, neighbour));
+	CHECK(neighbour.x < 128 && neighbour.y < 128);
+	ShadowAtlasTile medium;
+	CHECK(allocator.Allocate(1024, medium));
+	CHECK(medium.x < 2048 && medium.y < 2048);
+	CHECK(allocator.GetLargestFreeSize() == 2048);
+
+	allocator.Free(small);
+	allocator.Free(medium);
+	CHECK(allocator.GetLargestFreeSize() == 2048);
+	allocator.Free(neighbour);
+	CHECK(allocator.GetLargestFreeSize() == TEST_ATLAS_SIZE);
+	CHECK(allocator.GetAllocatedCount() == 0 && allocator.GetAllocatedArea() == 0);
+
+	// Filled with min tiles and freed in a shuffled order, the atlas ends whole again
+	std::vector<ShadowAtlasTile> tiles;
+	ShadowAtlasTile tile;
+	while (allocator.Allocate(TEST_MIN_TILE_SIZE, tile))
+	{
+		tiles.push_back(tile);
+	}
+	CHECK(tiles.size() == (TEST_ATLAS_SIZE / TEST_MIN_TILE_SIZE) * (TEST_ATLAS_SIZE / TEST_MIN_TILE_SIZE));
+	CHECK(allocator.GetLargestFreeSize() == 0);
+	CHECK(CheckTiles(allocator, tiles) == 0);
+
+	std::mt19937 random(11);
+	std::shuffle(tiles.begin(), tiles.end(), random);
+	for (size_t i = 0; i < tiles.size(); i++)
+	{
+		allocator.Free(tiles[i]);
+		if (i + 1 < tiles.size())
+		{
+			CHECK(allocator.GetLargestFreeSize() < TEST_ATLAS_SIZE);
+		}
+	}
+	CHECK(allocator.GetLargestFreeSize() == TEST_ATLAS_SIZE);
+
+	// Reset frees everything at once
+	CHECK(allocator.Allocate(128, tile));
+	allocator.Reset();
+	CHECK(allocator.GetLargestFreeSize() == TEST_ATLAS_SIZE && allocator.GetAllocatedCount() == 0);
+}
+
+// Lights coming and going with mixed tile sizes: tiles stay disjoint, and an allocation only fails once the atlas
+// is mostly full or no free tile of the size is left
+TEST_CASE(ShadowAtlasAllocator_MixedSizeChurn)
+{
+	std::mt19937 random(7);
+	ShadowAtlasAllocator allocator(TEST_ATLAS_SIZE, TEST_MIN_TILE_SIZE);
+	std::vector<ShadowAtlasTile> tiles;
+
+	uint32_t errorCount = 0;
+	uint32_t failureCount = 0;
+	double utilisationAtFailure = 0.0;
+	for (int step = 0; step < 200000; step++)
+	{
+		if (tiles.empty() || random() % 100 < 55)
+		{
+			const uint32_t size = TEST_MIN_TILE_SIZE << (random() % TEST_SIZE_COUNT);
+			ShadowAtlasTile tile;
+			if (allocator.Allocate(size, tile))
+			{
+				errorCount += tile.size != size;
+				tiles.push_back(tile);
+			}
+			else
+			{
+				failureCount++;
+				utilisationAtFailure += GetUtilisation(allocator);
+				errorCount += allocator.GetLargestFreeSize() >= size;
+
+				// Evicts a few lights to keep going
+				for (int i = 0; i < 8 && !tiles.empty(); i++)
+				{
+					FreeAt(allocator, tiles, random() % tiles.size());
+				}
+			}
+		}
+		else
+		{
+			FreeAt(allocator, tiles, random() % tiles.size());
+		}
+
+		if (step % 5000 == 0)
+		{
+			errorCount += CheckTiles(allocator, tiles);
+		}
+	}
+	CHECK(errorCount == 0);
+
+	utilisationAtFailure /= (std::max)(failureCount, 1u);
+	std::printf("  churn: %u failed allocations, mean utilisation at failure %.3f\n", failureCount, utilisationAtFailure);
+	CHECK(failureCount > 0);
+	CHECK(utilisationAtFailure > 0.85);
+
+	while (!tiles.empty())
+	{
+		FreeAt(allocator, tiles, tiles.size() - 1);
+	}
+	CHECK(allocator.GetLargestFreeSize() == TEST_ATLAS_SIZE);
+}
+
+// How much of the atlas is used when it first turns a tile down. Largest first packs it full, any order stays close.
+TEST_CASE(ShadowAtlasAllocator_PackingEfficiency)
+{
+	std::mt19937 random(3);
+
+	double minUtilisation = 1.0;
+	double sumUtilisation = 0.0;
+	const int trialCount = 50;
+	for (int trial = 0; trial < trialCount; trial++)
+	{
+		ShadowAtlasAllocator allocator(TEST_ATLAS_SIZE, TEST_MIN_TILE_SIZE);
+		ShadowAtlasTile tile;
+		while (allocator.Allocate(TEST_MIN_TILE_SIZE << (random() % TEST_SIZE_COUNT), tile))
+		{
+		}
+
+		const double utilisation = GetUtilisation(allocator);
+		minUtilisation = (std::min)(minUtilisation, utilisation);
+		sumUtilisation += utilisation;
+	}
+
+	std::printf("  random order fill: mean utilisation %.3f, worst %.3f\n", sumUtilisation / trialCount, minUtilisation);
+	CHECK(minUtilisation > 0.93);
+
+	// Largest first: every request fits until the atlas is full
+	std::vector<uint32_t> sizes;
+	uint64_t requestedArea = 0;
+	while (requestedArea < (uint64_t)TEST_ATLAS_SIZE * TEST_ATLAS_SIZE)
+	{
+		const uint32_t size = TEST_MIN_TILE_SIZE << (random() % TEST_SIZE_COUNT);
+		if (requestedArea + (uint64_t)size * size <= (uint64_t)TEST_ATLAS_SIZE * TEST_ATLAS_SIZE)
+		{
+			sizes.push_back(size);
+			requestedArea += (uint64_t)size * size;
+		}
+	}
+	std::sort(sizes.begin(), sizes.end(), std::greater<uint32_t>());
+
+	ShadowAtlasAllocator allocator(TEST_ATLAS_SIZE, TEST_MIN_TILE_SIZE);
+	std::vector<ShadowAtlasTile> tiles;
+	for (uint32_t size : sizes)
+	{
+		ShadowAtlasTile tile;
+		CHECK(allocator.Allocate(size, tile));
+		tiles.push_back(tile);
+	}
+	CHECK(GetUtilisation(allocator) == 1.0);
+	CHECK(allocator.GetLargestFreeSize() == 0);
+	CHECK(CheckTiles(allocator, tiles) == 0);
+}
@@ -0,0 +1,254 @@
+#include "TestFramework.h"
+#include "../src/Render/ShadowCascades.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	const float TEST_NEAR_Z = 0.1f;
+	const float TEST_FAR_Z = 1000.0f;
+	const float TEST_FOV_Y = 0.25f * 3.14159265f;
+	const float TEST_ASPECT = 16.0f / 9.0f;
+
+	TMatrix MakeCameraView(const TVector3& eye, float yaw, float pitch)
+	{
+		const TVector3 forward(std::cos(pitch) * std::sin(yaw), std::sin(pitch), std::cos(pitch) * std::cos(yaw));
+		return TMatrix::CreateLookAt(eye, eye + forward, TVector3(0.0f, 1.0f, 0.0f));
+	}
+
+	// The 8 corners of the camera frustum between two view depths, in view space
+	void GetSplitCorners(float splitNear, float splitFar, float tanHalfFovY, float aspect, TVector3* outCorners)
+	{
+		int cornerIndex = 0;
+		for (float z : { splitNear, splitFar })
+		{
+			for (float sx : { -1.0f, 1.0f })
+			{
+				for (float sy : { -1.0f, 1.0f })
+				{
+					outCorners[cornerIndex++] = TVector3(sx * z * tanHalfFovY * aspect, sy * z * tanHalfFovY, z);
+				}
+			}
+		}
+	}
+
+	// Shadow map texel coordinates of a world position in a cascade
+	void GetTexelCoords(const ShadowCascade& cascade, const TVector3& position, float& outX, float& outY)
+	{
+		TMatrix viewProj = cascade.viewProj;
+		const TVector3 ndc = viewProj.Transform(position);
+		outX = (ndc.x * 0.5f + 0.5f) * CSM_CASCADE_RESOLUTION;
+		outY = (ndc.y * 0.5f + 0.5f) * CSM_CASCADE_RESOLUTION;
+	}
+
+	float GetFraction(float value)
+	{
+		return value - std::floor(value);
+	}
+
+	// Distance between two fractions on the unit circle, 0.99 and 0.01 are close
+	float GetFractionDistance(float a, float b)
+	{
+		const float distance = std::abs(a - b);
+		return (std::min)(distance, 1.0f - distance);
+	}
+}
+
+// The splits grow from the near plane to the far plane. Lambda 0 is uniform and 1 is logarithmic.
+TEST_CASE(ShadowCascades_SplitsAreMonotoneAndCoverNearToFar)
+{
+	for (float nearZ : { 0.01f, 0.1f, 1.0f })
+	{
+		for (float farZ : { 10.0f, CSM_MAX_DISTANCE, 5000.0f })
+		{
+			for (float lambda : { 0.0f, 0.5f, CSM_SPLIT_LAMBDA, 1.0f })
+			{
+				float splits[CSM_CASCADE_COUNT + 1];
+				ShadowCascadeFitter::ComputeSplits(nearZ, farZ, lambda, splits);
+
+				CHECK(splits[0] == nearZ);
+				CHECK(splits[CSM_CASCADE_COUNT] == farZ);
+				for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+				{
+					CHECK(splits[i] < splits[i + 1]);
+				}
+			}
+		}
+	}
+
+	float uniformSplits[CSM_CASCADE_COUNT + 1];
+	float logSplits[CSM_CASCADE_COUNT + 1];
+	ShadowCascadeFitter::ComputeSplits(1.0f, 16.0f, 0.0f, uniformSplits);
+	ShadowCascadeFitter::ComputeSplits(1.0f, 16.0f, 1.0f, logSplits);
+	for (int i = 0; i <= CSM_CASCADE_COUNT; i++)
+	{
+		const float t = (float)i / CSM_CASCADE_COUNT;
+		CHECK_NEAR(uniformSplits[i], 1.0f + 15.0f * t, 1e-4f);
+		CHECK_NEAR(logSplits[i], std::pow(16.0f, t), 1e-4f);
+	}
+}
+
+// Every corner of a split is inside its sphere, and the sphere is tight: a corner lies on it
+TEST_CASE(ShadowCascades_SplitSphereContainsFrustumCorners)
+{
+	for (float fovY : { 0.5f, TEST_FOV_Y, 1.5f })
+	{
+		const float tanHalfFovY = std::tan(fovY * 0.5f);
+		for (float aspect : { 0.5f, 1.0f, TEST_ASPECT, 2.4f })
+		{
+			for (float splitNear : { 0.1f, 1.0f, 10.0f, 50.0f })
+			{
+				for (float splitFar : { 2.0f, 20.0f, 60.0f, 200.0f })
+				{
+					if (splitFar <= splitNear)
+					{
+						continue;
+					}
+
+					float centerDepth, radius;
+					ShadowCascadeFitter::ComputeSplitSphere(splitNear, splitFar, tanHalfFovY, aspect, centerDepth, radius);
+
+					TVector3 corners[8];
+					GetSplitCorners(splitNear, splitFar, tanHalfFovY, aspect, corners);
+
+					float farthest = 0.0f;
+					for (const TVector3& corner : corners)
+					{
+						const float distance = TVector3::Distance(corner, TVector3(0.0f, 0.0f, centerDepth));
+						CHECK(distance <= radius * 1.0001f);
+						farthest = (std::max)(farthest, distance);
+					}
+					CHECK(farthest >= radius * 0.9999f);
+				}
+			}
+		}
+	}
+}
+
+// A camera walking and looking around: every split stays inside its cascade sphere and shadow map tile, and a
+// cascade whose bit is not returned keeps its matrices
+TEST_CASE(ShadowCascades_FitCoversEverySplit)
+{
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	const TVector3 lightDirection(0.3f, -1.0f, 0.4f);
+	const float tanHalfFovY = std::tan(TEST_FOV_Y * 0.5f);
+
+	ShadowCascadeFitter fitter;
+	TVector3 eye(5.0f, 2.0f, -3.0f);
+	float yaw = 0.3f;
+	float pitch = -0.1f;
+	CHECK(fitter.Fit(MakeCameraView(eye, yaw, pitch), TEST_NEAR_Z, TEST_FAR_Z, TEST_FOV_Y, TEST_ASPECT, lightDirection) == (1u << CSM_CASCADE_COUNT) - 1);
+
+	uint32_t errorCount = 0;
+	int refitCount[CSM_CASCADE_COUNT] = {};
+	for (int frame = 0; frame < 1000; frame++)
+	{
+		eye += TVector3(unit(random), 0.1f * unit(random), unit(random)) * 0.05f + TVector3(0.02f, 0.0f, 0.01f);
+		yaw += 0.05f * unit(random);
+		pitch = std::clamp(pitch + 0.02f * unit(random), -1.2f, 1.2f);
+
+		ShadowCascade before[CSM_CASCADE_COUNT];
+		for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+		{
+			before[i] = fitter.GetCascade(i);
+		}
+
+		const TMatrix view = MakeCameraView(eye, yaw, pitch);
+		const uint32_t changedMask = fitter.Fit(view, TEST_NEAR_Z, TEST_FAR_Z, TEST_FOV_Y, TEST_ASPECT, lightDirection);
+
+		TMatrix invView = view.Invert();
+		for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+		{
+			const ShadowCascade& cascade = fitter.GetCascade(i);
+			const bool bChanged = (changedMask >> i) & 1;
+			refitCount[i] += bChanged;
+			errorCount += bChanged != (cascade.revision != before[i].revision);
+			errorCount += !bChanged && !(cascade.viewProj == before[i].viewProj);
+
+			TVector3 corners[8];
+			GetSplitCorners(cascade.splitNear, cascade.splitFar, tanHalfFovY, TEST_ASPECT, corners);
+			for (const TVector3& corner : corners)
+			{
+				const TVector3 worldCorner = invView.Transform(corner);
+				errorCount += TVector3::Distance(worldCorner, cascade.sphereCenter) > cascade.sphereRadius * 1.001f;
+
+				TMatrix viewProj = cascade.viewProj;
+				const TVector3 ndc = viewProj.Transform(worldCorner);
+				errorCount += std::abs(ndc.x) > 1.0f || std::abs(ndc.y) > 1.0f || ndc.z <= 0.0f || ndc.z >= 1.0f;
+			}
+		}
+	}
+	CHECK(errorCount == 0);
+
+	// The slack keeps the cascades through most of the walk
+	std::printf("  refits over 1000 frames:");
+	for (int count : refitCount)
+	{
+		CHECK(count < 250);
+		std::printf(" %d", count);
+	}
+	std::printf("\n");
+}
+
+// Moving the camera by less than a texel keeps every cascade, and a cascade fitted anywhere puts its texel edges at
+// the same world positions, so the shadow edges do not crawl when it is re-centered
+TEST_CASE(ShadowCascades_TexelSnappingKeepsTheShadowOriginStable)
+{
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	const TVector3 lightDirection(-0.4f, -1.0f, 0.2f);
+	const TVector3 startEye(12.0f, 3.0f, -7.0f);
+	const float yaw = 0.7f;
+	const float pitch = -0.2f;
+
+	ShadowCascadeFitter fitter;
+	fitter.Fit(MakeCameraView(startEye, yaw, pitch), TEST_NEAR_Z, TEST_FAR_Z, TEST_FOV_Y, TEST_ASPECT, lightDirection);
+
+	uint32_t revisions[CSM_CASCADE_COUNT];
+	for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+	{
+		revisions[i] = fitter.GetCascade(i).revision;
+	}
+
+	// Sub-texel jitter around the start, a tenth of the finest texel
+	const float jitter = 0.1f * fitter.GetCascade(0).texelSize;
+	for (int frame = 0; frame < 200; frame++)
+	{
+		const TVector3 eye = startEye + TVector3(unit(random), unit(random), unit(random)) * jitter;
+		CHECK(fitter.Fit(MakeCameraView(eye, yaw, pitch), TEST_NEAR_Z, TEST_FAR_Z, TEST_FOV_Y, TEST_ASPECT, lightDirection) == 0);
+	}
+	for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+	{
+		CHECK(fitter.GetCascade(i).revision == revisions[i]);
+	}
+
+	// Fresh fits from cameras a fraction of a texel to many texels apart: the texel grid stays in place in the world
+	const TVector3 probes[] = { TVector3(0.0f, 0.0f, 0.0f), TVector3(3.7f, -1.2f, 9.1f), TVector3(-25.3f, 4.4f, 60.8f) };
+	for (int move = 0; move < 100; move++)
+	{
+		const float distance = move < 50 ? 0.5f * jitter * move : 0.37f * (move - 49);
+		const TVector3 eye = startEye + TVector3(unit(random), 0.2f * unit(random), unit(random)) * distance;
+
+		ShadowCascadeFitter movedFitter;
+		movedFitter.Fit(MakeCameraView(eye, yaw, pitch), TEST_NEAR_Z, TEST_FAR_Z, TEST_FOV_Y, TEST_ASPECT, lightDirection);
+
+		for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+		{
+			const ShadowCascade& cascade = fitter.GetCascade(i);
+			const ShadowCascade& movedCascade = movedFitter.GetCascade(i);
+			CHECK(movedCascade.texelSize == cascade.texelSize);
+
+			for (const TVector3& probe : probes)
+			{
+				float x, y, movedX, movedY;
+				GetTexelCoords(cascade, probe, x, y);
+				GetTexelCoords(movedCascade, probe, movedX, movedY);
+				CHECK(GetFractionDistance(GetFraction(x), GetFraction(movedX)) < 0.02f);
+				CHECK(GetFractionDistance(GetFraction(y), GetFraction(movedY)) < 0.02f);
+			}
+		}
+	}
+}
@@ -0,0 +1,193 @@
+#include "TestFramework.h"
+#include "../src/Resource/SlotIndexAllocator.h"
+#include <atomic>
+#include <set>
+#include <thread>
+
+namespace
+{
+	// Churns a private set of slots, every slot it gets must not be held by any other thread at the same time
+	void ChurnSlots(SlotIndexAllocator& allocator, std::atomic<uint8_t>* owners, uint8_t threadId, uint32_t iterationCount,
+		uint32_t maxHeld, std::atomic<uint32_t>& errorCount)
+	{
+		std::vector<uint32_t> held;
+		for (uint32_t i = 0; i < iterationCount; i++)
+		{
+			// Grow to maxHeld, then alternate, with an occasional free from the front to mix the words
+			if (held.size() < maxHeld && (i % 3 != 0 || held.empty()))
+			{
+				const uint32_t index = allocator.Allocate();
+				if (index == SlotIndexAllocator::InvalidIndex)
+				{
+					errorCount++;
+					continue;
+				}
+
+				uint8_t expected = 0;
+				if (!owners[index].compare_exchange_strong(expected, threadId))
+				{
+					errorCount++;
+				}
+				held.push_back(index);
+			}
+			else
+			{
+				const uint32_t index = (i % 7 == 0) ? held.front() : held.back();
+				if (i % 7 == 0)
+				{
+					held.erase(held.begin());
+				}
+				else
+				{
+					held.pop_back();
+				}
+
+				uint8_t expected = threadId;
+				if (!owners[index].compare_exchange_strong(expected, 0))
+				{
+					errorCount++;
+				}
+				allocator.Free(index);
+			}
+		}
+
+		for (uint32_t index : held)
+		{
+			owners[index].store(0);
+			allocator.Free(index);
+		}
+	}
+}
+
+// 200 is not a multiple of 64, the tail bits of the last word must never be handed out
+TEST_CASE(SlotIndexAllocator_AllocatesEverySlotOnce)
+{
+	SlotIndexAllocator allocator(200);
+
+	std::set<uint32_t> indices;
+	for (uint32_t i = 0; i < 200; i++)
+	{
+		const uint32_t index = allocator.Allocate();
+		CHECK(index < 200);
+		CHECK(indices.insert(index).second);
+		CHECK(allocator.IsAllocated(index));
+	}
+
+	CHECK(allocator.GetAllocatedCount() == 200);
+	CHECK(allocator.Allocate() == SlotIndexAllocator::InvalidIndex);
+	CHECK(allocator.GetAllocatedCount() == 200);
+}
+
+TEST_CASE(SlotIndexAllocator_FreedSlotIsReusedFirst)
+{
+	SlotIndexAllocator allocator(200);
+	for (uint32_t i = 0; i < 200; i++)
+	{
+		allocator.Allocate();
+	}
+
+	allocator.Free(137);
+	CHECK(!allocator.IsAllocated(137));
+	CHECK(allocator.GetAllocatedCount() == 199);
+	CHECK(allocator.Allocate() == 137);
+
+	// With free slots in other words the search still starts at the word of the last free
+	allocator.Free(5);
+	allocator.Free(130);
+	CHECK(allocator.Allocate() == 130);
+	CHECK(allocator.Allocate() == 5);
+	CHECK(allocator.Allocate() == SlotIndexAllocator::InvalidIndex);
+}
+
+TEST_CASE(SlotIndexAllocator_ResetFreesEverySlot)
+{
+	SlotIndexAllocator allocator(70);
+	for (uint32_t i = 0; i < 70; i++)
+	{
+		allocator.Allocate();
+	}
+
+	allocator.Reset();
+	CHECK(allocator.GetAllocatedCount() == 0);
+	for (uint32_t i = 0; i < 70; i++)
+	{
+		CHECK(!allocator.IsAllocated(i));
+	}
+
+	std::set<uint32_t> indices;
+	for (uint32_t i = 0; i < 70; i++)
+	{
+		indices.insert(allocator.Allocate());
+	}
+	CHECK(indices.size() == 70 && *indices.rbegin() == 69);
+}
+
+// 8 threads each hold up to 100 of 1000 slots, no slot may ever be handed to two threads
+TEST_CASE(SlotIndexAllocator_ConcurrentAllocateAndFree)
+{
+	const uint32_t slotCount = 1000;
+	SlotIndexAllocator allocator(slotCount);
+	std::unique_ptr<std::atomic<uint8_t>[]> owners(new std::atomic<uint8_t>[slotCount]);
+	for (uint32_t i = 0; i < slotCount; i++)
+	{
+		owners[i].store(0);
+	}
+
+	std::atomic<uint32_t> errorCount = 0;
+	std::vector<std::thread> threads;
+	for (uint8_t t = 1; t <= 8; t++)
+	{
+		threads.emplace_back([&, t]() { ChurnSlots(allocator, owners.get(), t, 100000, 100, errorCount); });
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	CHECK(errorCount.load() == 0);
+	CHECK(allocator.GetAllocatedCount() == 0);
+	for (uint32_t i = 0; i < slotCount; i++)
+	{
+		CHECK(!allocator.IsAllocated(i));
+	}
+}
+
+// Allocate and free pairs per second on one thread and on 8, in a heap the size of the CBV/SRV/UAV pool
+BENCHMARK_CASE(SlotIndexAllocator_Throughput)
+{
+	const uint32_t slotCount = 65536;
+	const uint32_t iterationCount = 2000000;
+
+	for (uint32_t threadCount : { 1u, 8u })
+	{
+		SlotIndexAllocator allocator(slotCount);
+		std::unique_ptr<std::atomic<uint8_t>[]> owners(new std::atomic<uint8_t>[slotCount]);
+		for (uint32_t i = 0; i < slotCount; i++)
+		{
+			owners[i].store(0);
+		}
+
+		// Half the heap is in use, like a scene that streams views in and out
+		for (uint32_t i = 0; i < slotCount / 2; i++)
+		{
+			allocator.Allocate();
+		}
+
+		std::atomic<uint32_t> errorCount = 0;
+		BenchmarkTimer timer;
+		std::vector<std::thread> threads;
+		for (uint32_t t = 1; t <= threadCount; t++)
+		{
+			threads.emplace_back([&, t]() { ChurnSlots(allocator, owners.get(), (uint8_t)t, iterationCount / threadCount, 256, errorCount); });
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		const double durationMs = timer.GetElapsedMs();
+
+		CHECK(errorCount.load() == 0);
+		CHECK(allocator.GetAllocatedCount() == slotCount / 2);
+		std::printf("  %u thread(s): %.1f M operations/s\n", threadCount, iterationCount / (durationMs * 1000.0));
+	}
+}
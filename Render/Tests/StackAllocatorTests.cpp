@@ -0,0 +1,309 @@
+#include "TestFramework.h"
+#include "../src/Utility/StackAllocator.h"
+#include <map>
+#include <random>
+
+namespace
+{
+	// Hands out fake buffer handles and tracks what is alive
+	class FakeBufferVisitor : public IStackAllocVisitor
+	{
+	public:
+		uint64 Allocate(uint64 size) override
+		{
+			liveBuffers[nextHandle] = size;
+			liveBytes += size;
+			peakLiveBytes = (std::max)(peakLiveBytes, liveBytes);
+			allocationCount++;
+			return nextHandle++;
+		}
+
+		void DeAllocate(uint64 handle) override
+		{
+			auto Iter = liveBuffers.find(handle);
+			CHECK(Iter != liveBuffers.end());
+			if (Iter != liveBuffers.end())
+			{
+				liveBytes -= Iter->second;
+				liveBuffers.erase(Iter);
+			}
+		}
+
+		std::map<uint64, uint64> liveBuffers;
+		uint64 nextHandle = 1;
+		uint64 liveBytes = 0;
+		uint64 peakLiveBytes = 0;
+		uint64 allocationCount = 0;
+	};
+
+	// The StackAllocator this one replaced: every allocation scans all buffers for the best fit,
+	// capacity grows by 1.5x and nothing is ever given back. One instance per frame resource, cleared after its fence.
+	class BestFitStackAllocator
+	{
+	public:
+		BestFitStackAllocator(uint64 initCapacity, IStackAllocVisitor* inVisitor)
+			: visitor(inVisitor), capacity(initCapacity) {}
+
+		~BestFitStackAllocator()
+		{
+			for (const Buffer& buffer : allocatedBuffers)
+			{
+				visitor->DeAllocate(buffer.handle);
+			}
+		}
+
+		StackAllocator::Chunk Allocate(uint64 targetSize, uint64 align)
+		{
+			targetSize = (std::max)(targetSize, align);
+
+			Buffer* bestBuffer = nullptr;
+			uint64 bestOffset = 0;
+			uint64 minLeftSize = (std::numeric_limits<uint64>::max)();
+			for (Buffer& buffer : allocatedBuffers)
+			{
+				const uint64 offset = (buffer.fullSize - buffer.leftSize + align - 1) & ~(align - 1);
+				if (offset + targetSize > buffer.fullSize)
+				{
+					continue;
+				}
+
+				const uint64 leftSize = buffer.fullSize - offset - targetSize;
+				if (leftSize < minLeftSize)
+				{
+					minLeftSize = leftSize;
+					bestOffset = offset;
+					bestBuffer = &buffer;
+				}
+			}
+
+			if (bestBuffer)
+			{
+				bestBuffer->leftSize = minLeftSize;
+				return { bestBuffer->handle, bestOffset };
+			}
+
+			while (capacity < targetSize)
+			{
+				capacity = (std::max)(capacity + 1, (uint64)(capacity * 1.5));
+			}
+			const uint64 handle = visitor->Allocate(capacity);
+			allocatedBuffers.push_back({ handle, capacity, capacity - targetSize });
+			return { handle, 0 };
+		}
+
+		void Clear()
+		{
+			for (Buffer& buffer : allocatedBuffers)
+			{
+				buffer.leftSize = buffer.fullSize;
+			}
+		}
+
+	private:
+		struct Buffer
+		{
+			uint64 handle;
+			uint64 fullSize;
+			uint64 leftSize;
+		};
+
+		IStackAllocVisitor* visitor;
+		uint64 capacity;
+		std::vector<Buffer> allocatedBuffers;
+	};
+
+	struct TraceAllocation
+	{
+		uint64 size;
+		uint64 align;
+	};
+
+	// Upload sizes of a streaming scene: mostly constants and small buffers, some texture mips, rarely a 4 MB one,
+	// with a burst of three times the uploads every 300 frames
+	std::vector<std::vector<TraceAllocation>> MakeUploadTrace(uint32_t frameCount, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		std::vector<std::vector<TraceAllocation>> trace(frameCount);
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			const uint32_t uploadCount = 1500 + (frame % 300 < 30 ? 3000 : 0);
+			for (uint32_t i = 0; i < uploadCount; i++)
+			{
+				uint64 size = (random() % 100 < 95) ? 256 * (1 + random() % 16) : 65536 * (1 + random() % 8);
+				if (random() % 2000 == 0)
+				{
+					size = 4 << 20;
+				}
+				trace[frame].push_back({ size, random() % 3 == 0 ? 256u : 4u });
+			}
+		}
+		return trace;
+	}
+}
+
+TEST_CASE(StackAllocator_BumpsAlignedChunksInOnePage)
+{
+	FakeBufferVisitor visitor;
+	{
+		StackAllocator allocator(4096, &visitor);
+
+		uint64 end = 0;
+		uint64 handle = 0;
+		for (uint64 size : { 10u, 300u, 7u, 512u })
+		{
+			const StackAllocator::Chunk chunk = allocator.Allocate(size, 256);
+			CHECK(chunk.offset % 256 == 0);
+			CHECK(chunk.offset >= end);
+			CHECK(handle == 0 || chunk.handle == handle);
+			handle = chunk.handle;
+			end = chunk.offset + size;
+		}
+
+		CHECK(visitor.allocationCount == 1);
+		CHECK(allocator.GetStats().frameBytes == 10 + 300 + 7 + 512);
+
+		// The rest of the page is too small, the next chunk starts a new page at 0
+		const StackAllocator::Chunk chunk = allocator.Allocate(4000);
+		CHECK(chunk.handle != handle && chunk.offset == 0);
+		CHECK(visitor.allocationCount == 2);
+	}
+	CHECK(visitor.liveBuffers.empty());
+}
+
+TEST_CASE(StackAllocator_LargeAllocationGetsDedicatedPage)
+{
+	FakeBufferVisitor visitor;
+	StackAllocator allocator(4096, &visitor);
+
+	const StackAllocator::Chunk small = allocator.Allocate(100);
+	const StackAllocator::Chunk large = allocator.Allocate(10000);
+	CHECK(large.handle != small.handle && large.offset == 0);
+	CHECK(visitor.liveBuffers[large.handle] == 3 * 4096);
+
+	// Bumping goes on in the page before the dedicated one
+	const StackAllocator::Chunk next = allocator.Allocate(100);
+	CHECK(next.handle == small.handle && next.offset == 100);
+}
+
+TEST_CASE(StackAllocator_RecyclesPagesAfterTheirFence)
+{
+	FakeBufferVisitor visitor;
+	StackAllocator allocator(4096, &visitor);
+
+	const uint64 firstHandle = allocator.Allocate(1000).handle;
+	allocator.Retire(1);
+	CHECK(allocator.GetStats().inFlightBytes == 4096);
+
+	// Fence 1 is not done, the page may still be read
+	allocator.Recycle(0);
+	const uint64 secondHandle = allocator.Allocate(1000).handle;
+	CHECK(secondHandle != firstHandle);
+	allocator.Retire(2);
+
+	allocator.Recycle(1);
+	CHECK(allocator.GetStats().inFlightBytes == 4096);
+	CHECK(allocator.Allocate(1000).handle == firstHandle);
+	CHECK(visitor.allocationCount == 2);
+
+	CHECK(allocator.GetStats().reservedBytes == 2 * 4096);
+	CHECK(allocator.GetStats().peakReservedBytes == 2 * 4096);
+}
+
+TEST_CASE(StackAllocator_TrimsIdlePages)
+{
+	FakeBufferVisitor visitor;
+	const uint64 trimFrameCount = 8;
+	StackAllocator allocator(4096, &visitor, trimFrameCount);
+
+	// A burst frame needs 4 pages
+	for (int i = 0; i < 4; i++)
+	{
+		allocator.Allocate(4000);
+	}
+	allocator.Retire(1);
+	allocator.Recycle(1);
+	CHECK(allocator.GetStats().pageCount == 4);
+
+	// Then one page per frame is enough, the other three stay pooled until they are trimmed
+	uint64 fence = 1;
+	for (uint64 frame = 0; frame < trimFrameCount + 2; frame++)
+	{
+		allocator.Allocate(4000);
+		allocator.Retire(++fence);
+		allocator.Recycle(fence);
+	}
+
+	CHECK(allocator.GetStats().pageCount == 1);
+	CHECK(allocator.GetStats().reservedBytes == 4096);
+	CHECK(allocator.GetStats().peakReservedBytes == 4 * 4096);
+	CHECK(visitor.liveBuffers.size() == 1);
+}
+
+// The same synthetic upload trace through both allocators, 2000 frames with 3 in flight
+BENCHMARK_CASE(StackAllocator_PagedBumpVsBestFit)
+{
+	const uint32_t frameCount = 2000;
+	const uint32_t framesInFlight = 3;
+	const std::vector<std::vector<TraceAllocation>> trace = MakeUploadTrace(frameCount, 7);
+
+	size_t allocationCount = 0;
+	for (const auto& frame : trace)
+	{
+		allocationCount += frame.size();
+	}
+
+	FakeBufferVisitor bestFitVisitor;
+	double bestFitMs = 0.0;
+	{
+		std::vector<std::unique_ptr<BestFitStackAllocator>> frameAllocators;
+		for (uint32_t i = 0; i < framesInFlight; i++)
+		{
+			frameAllocators.push_back(std::make_unique<BestFitStackAllocator>(1 << 20, &bestFitVisitor));
+		}
+
+		BenchmarkTimer timer;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			BestFitStackAllocator& allocator = *frameAllocators[frame % framesInFlight];
+			allocator.Clear();
+			for (const TraceAllocation& allocation : trace[frame])
+			{
+				allocator.Allocate(allocation.size, allocation.align);
+			}
+		}
+		bestFitMs = timer.GetElapsedMs();
+	}
+
+	FakeBufferVisitor pagedVisitor;
+	double pagedMs = 0.0;
+	StackAllocator::Stats pagedStats;
+	{
+		StackAllocator allocator(1 << 20, &pagedVisitor, 64);
+
+		BenchmarkTimer timer;
+		uint64 fence = 0;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			allocator.Recycle(fence >= framesInFlight - 1 ? fence - (framesInFlight - 1) : 0);
+			for (const TraceAllocation& allocation : trace[frame])
+			{
+				const StackAllocator::Chunk chunk = allocator.Allocate(allocation.size, allocation.align);
+				CHECK(chunk.offset % allocation.align == 0);
+			}
+			allocator.Retire(++fence);
+		}
+		pagedMs = timer.GetElapsedMs();
+		pagedStats = allocator.GetStats();
+	}
+
+	std::printf("  %zu allocations\n", allocationCount);
+	std::printf("  best-fit scan: %.1f ns per allocation, peak reserved %.1f MB, %llu buffers created, nothing given back\n",
+		bestFitMs * 1e6 / allocationCount, bestFitVisitor.peakLiveBytes / (1024.0 * 1024.0), (unsigned long long)bestFitVisitor.allocationCount);
+	std::printf("  paged bump:    %.1f ns per allocation, peak reserved %.1f MB, %llu pages created, %.1f MB reserved at the end\n",
+		pagedMs * 1e6 / allocationCount, pagedStats.peakReservedBytes / (1024.0 * 1024.0), (unsigned long long)pagedVisitor.allocationCount,
+		pagedStats.reservedBytes / (1024.0 * 1024.0));
+
+	CHECK(pagedMs < bestFitMs);
+	CHECK(pagedStats.reservedBytes < pagedStats.peakReservedBytes);
+	CHECK(bestFitVisitor.liveBuffers.empty() && pagedVisitor.liveBuffers.empty());
+}
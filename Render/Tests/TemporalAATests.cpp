@@ -0,0 +1,231 @@
+#include "TestFramework.h"
+#include "../src/Render/TemporalAA.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const uint32_t TEST_WIDTH = 64;
+	const uint32_t TEST_HEIGHT = 64;
+
+	// Supersamples per pixel and axis of the reference image
+	const int TEST_REFERENCE_SAMPLES = 16;
+
+	// A slanted hard edge between a bright and a dark area, and a dim disc, shifted right by offsetX pixels
+	TVector3 GetSceneColor(float pixelX, float pixelY, float offsetX)
+	{
+		float value = pixelX - 0.3f * pixelY > 20.0f + offsetX ? 4.0f : 0.1f;
+
+		const float discX = pixelX - 40.0f - offsetX;
+		const float discY = pixelY - 40.0f;
+		if (discX * discX + discY * discY < 36.0f)
+		{
+			value = 0.5f;
+		}
+
+		return TVector3(value, 0.5f * value, 0.2f);
+	}
+
+	// One sample per pixel through a jittered projection. A jitter of +j in NDC moves the scene by j * width / 2
+	// pixels right and j * height / 2 pixels up.
+	void RenderScene(const TVector2& jitter, float offsetX, TAAColorImage& outImage)
+	{
+		outImage.Resize(TEST_WIDTH, TEST_HEIGHT);
+		for (uint32_t y = 0; y < TEST_HEIGHT; y++)
+		{
+			for (uint32_t x = 0; x < TEST_WIDTH; x++)
+			{
+				const float sampleX = x + 0.5f - jitter.x * TEST_WIDTH * 0.5f;
+				const float sampleY = y + 0.5f + jitter.y * TEST_HEIGHT * 0.5f;
+				outImage.pixels[(size_t)y * TEST_WIDTH + x] = GetSceneColor(sampleX, sampleY, offsetX);
+			}
+		}
+	}
+
+	void RenderReference(float offsetX, TAAColorImage& outImage)
+	{
+		outImage.Resize(TEST_WIDTH, TEST_HEIGHT);
+		for (uint32_t y = 0; y < TEST_HEIGHT; y++)
+		{
+			for (uint32_t x = 0; x < TEST_WIDTH; x++)
+			{
+				TVector3 sum = TVector3::Zero;
+				for (int sampleY = 0; sampleY < TEST_REFERENCE_SAMPLES; sampleY++)
+				{
+					for (int sampleX = 0; sampleX < TEST_REFERENCE_SAMPLES; sampleX++)
+					{
+						sum += GetSceneColor(x + (sampleX + 0.5f) / TEST_REFERENCE_SAMPLES, y + (sampleY + 0.5f) / TEST_REFERENCE_SAMPLES, offsetX);
+					}
+				}
+				outImage.pixels[(size_t)y * TEST_WIDTH + x] = sum / (float)(TEST_REFERENCE_SAMPLES * TEST_REFERENCE_SAMPLES);
+			}
+		}
+	}
+
+	// Mean absolute difference per pixel, summed over the channels
+	double GetImageError(const TAAColorImage& image, const TAAColorImage& reference)
+	{
+		double error = 0.0;
+		for (size_t i = 0; i < image.pixels.size(); i++)
+		{
+			const TVector3 difference = image.pixels[i] - reference.pixels[i];
+			error += std::abs(difference.x) + std::abs(difference.y) + std::abs(difference.z);
+		}
+		return error / image.pixels.size();
+	}
+
+	// Mean error of the resolved and of the aliased frames against the reference, every fourth frame of the second half
+	// of a run with the scene moving right at speed pixels per frame
+	void RunMovingScene(float speed, double& outResolvedError, double& outAliasedError)
+	{
+		const uint32_t frameCount = 48;
+		const std::vector<TVector2> velocity((size_t)TEST_WIDTH * TEST_HEIGHT, TVector2(speed / TEST_WIDTH, 0.0f));
+
+		TAAColorImage current, history, resolved, aliased, reference;
+		RenderScene(TVector2(0.0f), -20.0f, history);
+
+		outResolvedError = 0.0;
+		outAliasedError = 0.0;
+		int measuredCount = 0;
+		for (uint32_t frame = 1; frame < frameCount; frame++)
+		{
+			const float offsetX = frame * speed - 20.0f;
+			RenderScene(TemporalAA::GetJitter(frame, TEST_WIDTH, TEST_HEIGHT), offsetX, current);
+			TemporalAA::Resolve(current, history, velocity, true, resolved);
+			std::swap(history, resolved);
+
+			if (frame >= frameCount / 2 && frame % 4 == 0)
+			{
+				RenderReference(offsetX, reference);
+				RenderScene(TVector2(0.0f), offsetX, aliased);
+				outResolvedError += GetImageError(history, reference);
+				outAliasedError += GetImageError(aliased, reference);
+				measuredCount++;
+			}
+		}
+
+		outResolvedError /= measuredCount;
+		outAliasedError /= measuredCount;
+	}
+}
+
+// The color space round trip is exact, and clipping pulls a color outside the box onto its surface toward the center
+TEST_CASE(TemporalAA_YCoCgAndClipping)
+{
+	for (int i = 0; i < 100; i++)
+	{
+		const TVector3 color(i * 0.1f, (i % 7) * 0.3f, (i % 3) * 2.0f);
+		const TVector3 difference = TemporalAA::YCoCgToRGB(TemporalAA::RGBToYCoCg(color)) - color;
+		CHECK(std::abs(difference.x) + std::abs(difference.y) + std::abs(difference.z) < 1e-4f);
+	}
+
+	const TVector3 boxMin(0.0f, 0.0f, 0.0f);
+	const TVector3 boxMax(1.0f, 1.0f, 1.0f);
+	const TVector3 inside = TemporalAA::ClipToAABB(TVector3(0.5f, 0.2f, 0.9f), boxMin, boxMax);
+	CHECK(inside.x == 0.5f && inside.y == 0.2f && inside.z == 0.9f);
+
+	const TVector3 outside = TemporalAA::ClipToAABB(TVector3(3.0f, 0.5f, 0.5f), boxMin, boxMax);
+	CHECK_NEAR(outside.x, 1.0f, 1e-3f);
+	CHECK_NEAR(outside.y, 0.5f, 1e-3f);
+}
+
+// The jitter stays within half a pixel, and the history filter reproduces a linear ramp
+TEST_CASE(TemporalAA_JitterAndHistoryFilter)
+{
+	for (uint32_t frame = 0; frame < TAA_SAMPLE_COUNT; frame++)
+	{
+		const TVector2 jitter = TemporalAA::GetJitter(frame, TEST_WIDTH, TEST_HEIGHT);
+		CHECK(std::abs(jitter.x * TEST_WIDTH * 0.5f) <= 0.5f && std::abs(jitter.y * TEST_HEIGHT * 0.5f) <= 0.5f);
+	}
+
+	TAAColorImage ramp;
+	ramp.Resize(16, 16);
+	for (uint32_t y = 0; y < 16; y++)
+	{
+		for (uint32_t x = 0; x < 16; x++)
+		{
+			ramp.pixels[y * 16 + x] = TVector3((float)x, (float)y, 1.0f);
+		}
+	}
+
+	for (float u = 0.2f; u < 0.8f; u += 0.037f)
+	{
+		const TVector3 sample = TemporalAA::SampleHistory(ramp, TVector2(u, 1.0f - u));
+		CHECK_NEAR(sample.x, u * 16.0f - 0.5f, 0.02f);
+		CHECK_NEAR(sample.y, (1.0f - u) * 16.0f - 0.5f, 0.02f);
+		CHECK_NEAR(sample.z, 1.0f, 1e-4f);
+	}
+}
+
+// A static hard edge: accumulated over the jittered frames, the error against a 16x16 supersampled reference about
+// halves from the aliased frame
+TEST_CASE(TemporalAA_StaticSceneApproachesSupersampledReference)
+{
+	TAAColorImage reference;
+	RenderReference(0.0f, reference);
+
+	TAAColorImage current, history, resolved;
+	RenderScene(TVector2(0.0f), 0.0f, current);
+	const double aliasedError = GetImageError(current, reference);
+
+	const std::vector<TVector2> velocity((size_t)TEST_WIDTH * TEST_HEIGHT, TVector2(0.0f));
+	history = current;
+	for (uint32_t frame = 1; frame < 64; frame++)
+	{
+		RenderScene(TemporalAA::GetJitter(frame, TEST_WIDTH, TEST_HEIGHT), 0.0f, current);
+		TemporalAA::Resolve(current, history, velocity, true, resolved);
+		std::swap(history, resolved);
+	}
+	const double resolvedError = GetImageError(history, reference);
+
+	std::printf("  static edge: aliased error %.4f, resolved %.4f\n", aliasedError, resolvedError);
+	CHECK(resolvedError < aliasedError * 0.6);
+}
+
+// From a quarter pixel to a pixel and a half per frame, the reprojected resolve is never clearly worse than the aliased
+// frame. Around half a pixel the resampled history blurs about as much as the jitter gains.
+TEST_CASE(TemporalAA_MotionSweep)
+{
+	for (float speed : { 0.25f, 0.5f, 0.7f, 1.0f, 1.5f })
+	{
+		double resolvedError, aliasedError;
+		RunMovingScene(speed, resolvedError, aliasedError);
+
+		std::printf("  %.2f px per frame: aliased error %.4f, resolved %.4f\n", speed, aliasedError, resolvedError);
+		CHECK(resolvedError < aliasedError * 1.05);
+	}
+}
+
+// A bright sample in the history that is gone from the current frame is clipped out by the first resolve, it does
+// not fade over several frames
+TEST_CASE(TemporalAA_RemovedBrightSampleClippedInOneFrame)
+{
+	const TVector3 background(0.1f, 0.05f, 0.2f);
+	const size_t brightIndex = 32 * TEST_WIDTH + 32;
+
+	TAAColorImage current, history, resolved;
+	current.Resize(TEST_WIDTH, TEST_HEIGHT);
+	history.Resize(TEST_WIDTH, TEST_HEIGHT);
+	std::fill(current.pixels.begin(), current.pixels.end(), background);
+	std::fill(history.pixels.begin(), history.pixels.end(), background);
+	history.pixels[brightIndex] = TVector3(50.0f);
+
+	const std::vector<TVector2> velocity((size_t)TEST_WIDTH * TEST_HEIGHT, TVector2(0.0f));
+	TemporalAA::Resolve(current, history, velocity, true, resolved);
+
+	double maxError = 0.0;
+	for (const TVector3& pixel : resolved.pixels)
+	{
+		const TVector3 difference = pixel - background;
+		maxError = (std::max)(maxError, (double)(std::abs(difference.x) + std::abs(difference.y) + std::abs(difference.z)));
+	}
+	CHECK(maxError < 1e-3);
+
+	// Without a history, or reprojected from off screen, the current frame passes through
+	TemporalAA::Resolve(current, history, velocity, false, resolved);
+	CHECK(GetImageError(resolved, current) == 0.0);
+
+	const std::vector<TVector2> offScreenVelocity((size_t)TEST_WIDTH * TEST_HEIGHT, TVector2(2.0f, 0.0f));
+	TemporalAA::Resolve(current, history, offScreenVelocity, true, resolved);
+	CHECK(GetImageError(resolved, current) == 0.0);
+}
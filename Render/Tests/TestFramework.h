@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Minimal headless test runner for the CPU side units of the engine, nothing here needs a GPU or a window.
+// TEST_CASE bodies always run, BENCHMARK_CASE bodies only with --bench since they can take seconds.
+struct TestCase
+{
+	const char* name = nullptr;
+	void (*func)() = nullptr;
+	bool bBenchmark = false;
+};
+
+class TestRegistry
+{
+public:
+	static TestRegistry& Get()
+	{
+		static TestRegistry Instance;
+		return Instance;
+	}
+
+	void Add(const char* name, void (*func)(), bool bBenchmark)
+	{
+		testCases.push_back({ name, func, bBenchmark });
+	}
+
+	const std::vector<TestCase>& GetTestCases() const { return testCases; }
+
+	void ReportFailure(const char* file, int line, const char* expression)
+	{
+		std::printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+		failureCount++;
+	}
+
+	void ReportFailureNear(const char* file, int line, const char* expression, double value, double expected, double tolerance)
+	{
+		std::printf("  %s(%d): CHECK_NEAR(%s) failed, %g vs %g +- %g\n", file, line, expression, value, expected, tolerance);
+		failureCount++;
+	}
+
+	int GetFailureCount() const { return failureCount; }
+
+private:
+	std::vector<TestCase> testCases;
+
+	int failureCount = 0;
+};
+
+struct TestRegistrar
+{
+	TestRegistrar(const char* name, void (*func)(), bool bBenchmark)
+	{
+		TestRegistry::Get().Add(name, func, bBenchmark);
+	}
+};
+
+// Wall clock time of a benchmark section
+class BenchmarkTimer
+{
+public:
+	BenchmarkTimer() : startTime(std::chrono::high_resolution_clock::now()) {}
+
+	double GetElapsedMs() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+	}
+
+private:
+	std::chrono::high_resolution_clock::time_point startTime;
+};
+
+#define TEST_CASE(Name) \
+	static void Name(); \
+	static TestRegistrar Name##_Registrar(#Name, &Name, false); \
+	static void Name()
+
+#define BENCHMARK_CASE(Name) \
+	static void Name(); \
+	static TestRegistrar Name##_Registrar(#Name, &Name, true); \
+	static void Name()
+
+#define CHECK(Expression) \
+	do { if (!(Expression)) TestRegistry::Get().ReportFailure(__FILE__, __LINE__, #Expression); } while (0)
+
+#define CHECK_NEAR(Value, Expected, Tolerance) \
+	do { \
+		const double checkValue = (double)(Value); \
+		const double checkExpected = (double)(Expected); \
+		if (!(std::abs(checkValue - checkExpected) <= (double)(Tolerance))) \
+			TestRegistry::Get().ReportFailureNear(__FILE__, __LINE__, #Value ", " #Expected, checkValue, checkExpected, (double)(Tolerance)); \
+	} while (0)
@@ -0,0 +1,54 @@
+#include "TestFramework.h"
+#include <cstring>
+
+// Usage: Tests.exe [--bench] [name filter]
+// Runs every test whose name contains the filter, benchmarks are skipped unless --bench is given.
+int main(int argc, char** argv)
+{
+	bool bRunBenchmarks = false;
+	const char* filter = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--bench") == 0)
+		{
+			bRunBenchmarks = true;
+		}
+		else
+		{
+			filter = argv[i];
+		}
+	}
+
+	TestRegistry& registry = TestRegistry::Get();
+
+	int runCount = 0;
+	int failedCount = 0;
+	for (const TestCase& testCase : registry.GetTestCases())
+	{
+		if (testCase.bBenchmark && !bRunBenchmarks)
+		{
+			continue;
+		}
+		if (filter != nullptr && std::strstr(testCase.name, filter) == nullptr)
+		{
+			continue;
+		}
+
+		std::printf("[ RUN  ] %s\n", testCase.name);
+
+		const int failuresBefore = registry.GetFailureCount();
+		BenchmarkTimer timer;
+		testCase.func();
+		const bool bPassed = registry.GetFailureCount() == failuresBefore;
+
+		std::printf("[ %s ] %s (%.1f ms)\n", bPassed ? "PASS" : "FAIL", testCase.name, timer.GetElapsedMs());
+
+		runCount++;
+		failedCount += bPassed ? 0 : 1;
+	}
+
+	std::printf("%d run, %d failed\n", runCount, failedCount);
+
+	return failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+#include "TestFramework.h"
+#include "../src/Texture/TextureResidency.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	// RGBA8 mip chain of a square texture, the mip tail starts at 64x64 like TEXTURE_STREAMING_MIP_TAIL_SIZE
+	std::vector<uint64_t> MakeMipSizes(uint32_t size, uint32_t& outTailMip)
+	{
+		std::vector<uint64_t> mipSizes;
+		outTailMip = 0;
+		for (uint32_t mipSize = size; mipSize >= 1; mipSize /= 2)
+		{
+			if (mipSize > 64)
+			{
+				outTailMip++;
+			}
+			mipSizes.push_back((uint64_t)mipSize * mipSize * 4);
+		}
+		return mipSizes;
+	}
+
+	void ApplyChanges(TextureResidencyManager& manager, const std::vector<TextureResidencyManager::ResidencyChange>& changes)
+	{
+		for (const auto& change : changes)
+		{
+			if (change.IsLoad())
+			{
+				manager.OnLoadFinished(change.handle);
+			}
+		}
+	}
+}
+
+TEST_CASE(TextureResidency_LoadsRequestedMipsWithinBudget)
+{
+	TextureResidencyManager manager(0);
+
+	uint32_t tailMip = 0;
+	const std::vector<uint64_t> mipSizes = MakeMipSizes(1024, tailMip);
+	const uint32_t handle = manager.Register(mipSizes, tailMip);
+
+	CHECK(manager.GetResidentMip(handle) == tailMip);
+	CHECK(manager.GetResidentBytes() == manager.GetMipChainSize(handle, tailMip));
+
+	std::vector<TextureResidencyManager::ResidencyChange> changes;
+	manager.RequestMip(handle, 2, 1);
+	manager.RequestMip(handle, 1, 1); // the most detailed request of the frame wins
+	manager.Update(1, changes);
+
+	CHECK(changes.size() == 1);
+	CHECK(changes[0].IsLoad() && changes[0].fromMip == tailMip && changes[0].toMip == 1);
+	CHECK(manager.IsLoading(handle));
+	CHECK(manager.GetResidentBytes() == manager.GetMipChainSize(handle, 1));
+
+	// No second load while the first one is in flight
+	manager.RequestMip(handle, 0, 2);
+	manager.Update(2, changes);
+	CHECK(changes.empty());
+
+	manager.OnLoadFinished(handle);
+	manager.RequestMip(handle, 0, 3);
+	manager.Update(3, changes);
+	CHECK(changes.size() == 1 && changes[0].toMip == 0);
+}
+
+TEST_CASE(TextureResidency_EvictsLeastRecentlyUsedOverBudget)
+{
+	uint32_t tailMip = 0;
+	const std::vector<uint64_t> mipSizes = MakeMipSizes(1024, tailMip);
+
+	// Room for the tails and two full chains
+	TextureResidencyManager probe(0);
+	const uint32_t probeHandle = probe.Register(mipSizes, tailMip);
+	const uint64_t fullBytes = probe.GetMipChainSize(probeHandle, 0);
+	const uint64_t tailBytes = probe.GetMipChainSize(probeHandle, tailMip);
+
+	TextureResidencyManager manager(2 * fullBytes + tailBytes);
+	const uint32_t a = manager.Register(mipSizes, tailMip);
+	const uint32_t b = manager.Register(mipSizes, tailMip);
+	const uint32_t c = manager.Register(mipSizes, tailMip);
+
+	std::vector<TextureResidencyManager::ResidencyChange> changes;
+
+	manager.RequestMip(a, 0, 1);
+	manager.Update(1, changes);
+	ApplyChanges(manager, changes);
+
+	manager.RequestMip(b, 0, 2);
+	manager.Update(2, changes);
+	ApplyChanges(manager, changes);
+
+	CHECK(manager.GetResidentMip(a) == 0 && manager.GetResidentMip(b) == 0);
+	CHECK(manager.GetResidentBytes() == manager.GetBudget());
+
+	// c needs room, a was used longest ago so it loses its detail first, b is untouched
+	manager.RequestMip(b, 0, 3);
+	manager.RequestMip(c, 0, 3);
+	manager.Update(3, changes);
+	ApplyChanges(manager, changes);
+
+	CHECK(manager.GetResidentMip(a) == tailMip);
+	CHECK(manager.GetResidentMip(b) == 0);
+	CHECK(manager.GetResidentMip(c) == 0);
+	CHECK(manager.GetResidentBytes() <= manager.GetBudget());
+}
+
+TEST_CASE(TextureResidency_FallsBackToCoarserMipWhenNothingCanBeEvicted)
+{
+	uint32_t tailMip = 0;
+	const std::vector<uint64_t> mipSizes = MakeMipSizes(1024, tailMip);
+
+	TextureResidencyManager probe(0);
+	const uint32_t probeHandle = probe.Register(mipSizes, tailMip);
+
+	// Mip 0 is missing a few bytes, everything from mip 1 fits
+	TextureResidencyManager manager(probe.GetMipChainSize(probeHandle, 0) - 1);
+	const uint32_t handle = manager.Register(mipSizes, tailMip);
+
+	std::vector<TextureResidencyManager::ResidencyChange> changes;
+	manager.RequestMip(handle, 0, 1);
+	manager.Update(1, changes);
+
+	CHECK(changes.size() == 1 && changes[0].toMip == 1);
+	CHECK(manager.GetResidentBytes() <= manager.GetBudget());
+}
+
+TEST_CASE(TextureResidency_LoweredBudgetEvictsUnusedTextures)
+{
+	uint32_t tailMip = 0;
+	const std::vector<uint64_t> mipSizes = MakeMipSizes(512, tailMip);
+
+	TextureResidencyManager manager(0);
+	std::vector<uint32_t> handles;
+	for (int i = 0; i < 8; i++)
+	{
+		handles.push_back(manager.Register(mipSizes, tailMip));
+	}
+
+	std::vector<TextureResidencyManager::ResidencyChange> changes;
+	for (uint32_t handle : handles)
+	{
+		manager.RequestMip(handle, 0, 1);
+	}
+	manager.Update(1, changes);
+	ApplyChanges(manager, changes);
+
+	const uint64_t tailBytes = manager.GetMipChainSize(handles[0], tailMip) * handles.size();
+	manager.SetBudget(tailBytes + manager.GetMipChainSize(handles[0], 0));
+	manager.Update(2, changes);
+
+	CHECK(manager.GetResidentBytes() <= manager.GetBudget());
+	for (const auto& change : changes)
+	{
+		CHECK(!change.IsLoad());
+		CHECK(change.toMip <= tailMip);
+	}
+}
+
+// Random screen size requests against a budget a quarter of the full set, the budget must hold every frame
+// and a texture requested in a frame never loses detail in that same frame
+TEST_CASE(TextureResidency_SimulatedBudgetHoldsUnderRandomRequests)
+{
+	const uint32_t textureCount = 64;
+	const uint32_t frameCount = 500;
+
+	TextureResidencyManager manager(0);
+	std::vector<uint32_t> handles;
+	uint64_t fullBytes = 0;
+	uint64_t tailBytes = 0;
+	for (uint32_t i = 0; i < textureCount; i++)
+	{
+		uint32_t tailMip = 0;
+		const std::vector<uint64_t> mipSizes = MakeMipSizes(256u << (i % 4), tailMip);
+		const uint32_t handle = manager.Register(mipSizes, tailMip);
+		handles.push_back(handle);
+		fullBytes += manager.GetMipChainSize(handle, 0);
+		tailBytes += manager.GetMipChainSize(handle, tailMip);
+	}
+
+	const uint64_t budget = tailBytes + (fullBytes - tailBytes) / 4;
+	manager.SetBudget(budget);
+
+	std::mt19937 random(7);
+	std::vector<TextureResidencyManager::ResidencyChange> changes;
+	std::vector<uint32_t> requestedMips(textureCount, UINT32_MAX);
+	uint32_t loadCount = 0;
+	uint32_t evictionCount = 0;
+
+	for (uint64_t frame = 1; frame <= frameCount; frame++)
+	{
+		std::fill(requestedMips.begin(), requestedMips.end(), UINT32_MAX);
+		for (uint32_t i = 0; i < textureCount / 4; i++)
+		{
+			const uint32_t handle = handles[random() % textureCount];
+			const uint32_t mip = random() % 4;
+			manager.RequestMip(handle, mip, frame);
+			requestedMips[handle] = (std::min)(requestedMips[handle], mip);
+		}
+
+		std::vector<uint32_t> residentBefore(textureCount);
+		for (uint32_t handle : handles)
+		{
+			residentBefore[handle] = manager.GetResidentMip(handle);
+		}
+
+		manager.Update(frame, changes);
+
+		CHECK(manager.GetResidentBytes() <= budget);
+		for (const auto& change : changes)
+		{
+			if (change.IsLoad())
+			{
+				loadCount++;
+				CHECK(change.toMip >= requestedMips[change.handle]);
+			}
+			else
+			{
+				evictionCount++;
+				CHECK(requestedMips[change.handle] == UINT32_MAX);
+			}
+		}
+		for (uint32_t handle : handles)
+		{
+			if (requestedMips[handle] != UINT32_MAX)
+			{
+				CHECK(manager.GetResidentMip(handle) <= residentBefore[handle]);
+			}
+		}
+
+		// Loads finish before the next frame
+		ApplyChanges(manager, changes);
+	}
+
+	CHECK(loadCount > 0 && evictionCount > 0);
+	std::printf("  %u loads, %u evictions, %.1f of %.1f MB resident\n", loadCount, evictionCount,
+		manager.GetResidentBytes() / (1024.0 * 1024.0), budget / (1024.0 * 1024.0));
+}
@@ -0,0 +1,125 @@
+#include "TestFramework.h"
+#include "../src/Math/Transform.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+	float GetMatrixDifference(const TMatrix& a, const TMatrix& b)
+	{
+		const float* valuesA = &a._11;
+		const float* valuesB = &b._11;
+		float difference = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			difference = (std::max)(difference, std::abs(valuesA[i] - valuesB[i]));
+		}
+		return difference;
+	}
+
+	TTransform MakeTransform(const TVector3& location, const TRotator& rotation, const TVector3& scale)
+	{
+		TTransform transform;
+		transform.Location = location;
+		transform.Rotation = rotation;
+		transform.Scale = scale;
+		return transform;
+	}
+
+	// The largest matrix difference of a round trip through FromMatrix, relative to the largest scale
+	float GetRoundTripError(const TTransform& transform, TTransform* outResult = nullptr)
+	{
+		const TMatrix matrix = transform.GetTransformMatrix();
+		const TTransform result = TTransform::FromMatrix(matrix);
+		if (outResult)
+		{
+			*outResult = result;
+		}
+
+		const float maxScale = (std::max)({ std::abs(transform.Scale.x), std::abs(transform.Scale.y), std::abs(transform.Scale.z) });
+		return GetMatrixDifference(result.GetTransformMatrix(), matrix) / maxScale;
+	}
+}
+
+// Away from the poles FromMatrix gives back the angles, the scale and the location it was built from
+TEST_CASE(Transform_FromMatrixRoundTrip)
+{
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> angle(-179.0f, 179.0f);
+	std::uniform_real_distribution<float> pitch(-85.0f, 85.0f);
+	std::uniform_real_distribution<float> scale(0.1f, 10.0f);
+	std::uniform_real_distribution<float> location(-100.0f, 100.0f);
+
+	uint32_t errorCount = 0;
+	float maxError = 0.0f;
+	for (int i = 0; i < 1000; i++)
+	{
+		const TTransform transform = MakeTransform(TVector3(location(random), location(random), location(random)),
+			TRotator(angle(random), pitch(random), angle(random)), TVector3(scale(random), scale(random), scale(random)));
+
+		TTransform result;
+		maxError = (std::max)(maxError, GetRoundTripError(transform, &result));
+
+		errorCount += (result.Location - transform.Location).Length() > 1e-4f;
+		errorCount += std::abs(result.Scale.x - transform.Scale.x) > 1e-4f * transform.Scale.x;
+		errorCount += std::abs(result.Scale.y - transform.Scale.y) > 1e-4f * transform.Scale.y;
+		errorCount += std::abs(result.Scale.z - transform.Scale.z) > 1e-4f * transform.Scale.z;
+		errorCount += std::abs(result.Rotation.Roll - transform.Rotation.Roll) > 0.01f;
+		errorCount += std::abs(result.Rotation.Pitch - transform.Rotation.Pitch) > 0.01f;
+		errorCount += std::abs(result.Rotation.Yaw - transform.Rotation.Yaw) > 0.01f;
+	}
+
+	std::printf("  round trip: max matrix error %.2e\n", maxError);
+	CHECK(errorCount == 0);
+	CHECK(maxError < 1e-5f);
+}
+
+// A mirrored basis comes back with the mirror on x and the same matrix, however many axes were negative
+TEST_CASE(Transform_FromMatrixMirroredScale)
+{
+	const TRotator rotation(25.0f, -40.0f, 70.0f);
+	const TVector3 scales[] = { TVector3(-2.0f, 1.0f, 3.0f), TVector3(2.0f, -1.0f, 3.0f), TVector3(2.0f, 1.0f, -3.0f),
+		TVector3(-2.0f, -1.0f, -3.0f), TVector3(-1.0f, -1.0f, 1.0f) };
+
+	for (const TVector3& scale : scales)
+	{
+		TTransform result;
+		const float error = GetRoundTripError(MakeTransform(TVector3(1.0f, 2.0f, 3.0f), rotation, scale), &result);
+		const bool bMirrored = scale.x * scale.y * scale.z < 0.0f;
+
+		CHECK(error < 1e-5f);
+		CHECK((result.Scale.x < 0.0f) == bMirrored);
+		CHECK(result.Scale.y > 0.0f && result.Scale.z > 0.0f);
+		CHECK_NEAR(std::abs(result.Scale.x), std::abs(scale.x), 1e-4f);
+		CHECK_NEAR(result.Scale.y, std::abs(scale.y), 1e-4f);
+		CHECK_NEAR(result.Scale.z, std::abs(scale.z), 1e-4f);
+	}
+}
+
+// At and next to the poles yaw and roll turn around the same axis, the angles may differ but the matrix does not
+TEST_CASE(Transform_FromMatrixNearGimbalLock)
+{
+	uint32_t errorCount = 0;
+	float maxError = 0.0f;
+	for (float pitch : { 90.0f, -90.0f, 89.999f, -89.999f, 89.99f, 89.9f, 89.0f })
+	{
+		for (float yaw : { 0.0f, 30.0f, -135.0f })
+		{
+			for (float roll : { 0.0f, 60.0f, -170.0f })
+			{
+				for (const TVector3& scale : { TVector3(1.0f), TVector3(2.0f, 0.5f, 3.0f), TVector3(-1.0f, 2.0f, 1.0f) })
+				{
+					TTransform result;
+					const float error = GetRoundTripError(MakeTransform(TVector3(0.0f), TRotator(roll, pitch, yaw), scale), &result);
+					maxError = (std::max)(maxError, error);
+					errorCount += error > 1e-5f;
+					errorCount += std::abs(std::abs(result.Rotation.Pitch) - std::abs(pitch)) > 0.05f;
+				}
+			}
+		}
+	}
+
+	std::printf("  near gimbal lock: max matrix error %.2e\n", maxError);
+	CHECK(errorCount == 0);
+}
@@ -0,0 +1,465 @@
+#include "TestFramework.h"
+#include "../src/Mesh/TriangleBVH.h"
+#include "../src/Mesh/MeshSDFBaker.h"
+#include "../src/Utility/JobSystem.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <map>
+#include <random>
+
+namespace
+{
+	struct TestMesh
+	{
+		std::vector<TVector3> positions;
+		std::vector<uint32_t> indices;
+	};
+
+	TestMesh MakeTorus(float majorRadius, float minorRadius, uint32_t majorSegments, uint32_t minorSegments)
+	{
+		const float pi = 3.14159265f;
+
+		TestMesh mesh;
+		for (uint32_t a = 0; a < majorSegments; a++)
+		{
+			for (uint32_t b = 0; b < minorSegments; b++)
+			{
+				const float u = 2.0f * pi * a / majorSegments;
+				const float v = 2.0f * pi * b / minorSegments;
+				const float ringRadius = majorRadius + minorRadius * std::cos(v);
+				mesh.positions.push_back(TVector3(ringRadius * std::cos(u), minorRadius * std::sin(v), ringRadius * std::sin(u)));
+			}
+		}
+
+		for (uint32_t a = 0; a < majorSegments; a++)
+		{
+			for (uint32_t b = 0; b < minorSegments; b++)
+			{
+				const uint32_t i0 = a * minorSegments + b;
+				const uint32_t i1 = ((a + 1) % majorSegments) * minorSegments + b;
+				const uint32_t i2 = ((a + 1) % majorSegments) * minorSegments + (b + 1) % minorSegments;
+				const uint32_t i3 = a * minorSegments + (b + 1) % minorSegments;
+				mesh.indices.insert(mesh.indices.end(), { i0, i1, i2, i0, i2, i3 });
+			}
+		}
+		return mesh;
+	}
+
+	TestMesh MakeBox(float halfSize)
+	{
+		TestMesh mesh;
+		for (uint32_t corner = 0; corner < 8; corner++)
+		{
+			mesh.positions.push_back(TVector3(corner & 1 ? halfSize : -halfSize, corner & 2 ? halfSize : -halfSize, corner & 4 ? halfSize : -halfSize));
+		}
+		mesh.indices = { 0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1, 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3 };
+		return mesh;
+	}
+
+	// Subdivided icosahedron, every vertex on the sphere
+	TestMesh MakeSphere(float radius, uint32_t subdivisions)
+	{
+		const float t = (1.0f + std::sqrt(5.0f)) * 0.5f;
+		std::vector<TVector3> directions = { TVector3(-1, t, 0), TVector3(1, t, 0), TVector3(-1, -t, 0), TVector3(1, -t, 0),
+			TVector3(0, -1, t), TVector3(0, 1, t), TVector3(0, -1, -t), TVector3(0, 1, -t),
+			TVector3(t, 0, -1), TVector3(t, 0, 1), TVector3(-t, 0, -1), TVector3(-t, 0, 1) };
+		std::vector<uint32_t> indices = { 0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+			3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1 };
+
+		for (uint32_t level = 0; level < subdivisions; level++)
+		{
+			std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+			auto GetMidpoint = [&](uint32_t a, uint32_t b)
+			{
+				const std::pair<uint32_t, uint32_t> edge((std::min)(a, b), (std::max)(a, b));
+				auto Iter = midpoints.find(edge);
+				if (Iter != midpoints.end())
+				{
+					return Iter->second;
+				}
+				directions.push_back((directions[a] + directions[b]) * 0.5f);
+				midpoints[edge] = (uint32_t)directions.size() - 1;
+				return (uint32_t)directions.size() - 1;
+			};
+
+			std::vector<uint32_t> subdivided;
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				const uint32_t ab = GetMidpoint(indices[i], indices[i + 1]);
+				const uint32_t bc = GetMidpoint(indices[i + 1], indices[i + 2]);
+				const uint32_t ca = GetMidpoint(indices[i + 2], indices[i]);
+				subdivided.insert(subdivided.end(), { indices[i], ab, ca, ab, indices[i + 1], bc, ca, bc, indices[i + 2], ab, bc, ca });
+			}
+			indices.swap(subdivided);
+		}
+
+		TestMesh mesh;
+		for (TVector3 direction : directions)
+		{
+			direction.Normalize();
+			mesh.positions.push_back(direction * radius);
+		}
+		mesh.indices = indices;
+		return mesh;
+	}
+
+	float PointSegmentDistanceSquared(const TVector3& p, const TVector3& a, const TVector3& b)
+	{
+		const TVector3 ab = b - a;
+		const float t = std::clamp((p - a).Dot(ab) / (std::max)(ab.LengthSquared(), 1e-20f), 0.0f, 1.0f);
+		return (p - (a + ab * t)).LengthSquared();
+	}
+
+	// Projects onto the plane and falls back to the three edges, independent of the Voronoi region walk of TriangleBVH
+	float PointTriangleDistanceSquared(const TVector3& p, const TVector3& a, const TVector3& b, const TVector3& c)
+	{
+		const TVector3 normal = (b - a).Cross(c - a);
+		const float normalLengthSquared = normal.LengthSquared();
+		if (normalLengthSquared > 0.0f)
+		{
+			const float planeDistance = (p - a).Dot(normal) / std::sqrt(normalLengthSquared);
+			const TVector3 projected = p - normal * ((p - a).Dot(normal) / normalLengthSquared);
+
+			// Inside if the projection is on the inner side of all three edges
+			const bool bInside = (b - a).Cross(projected - a).Dot(normal) >= 0.0f
+				&& (c - b).Cross(projected - b).Dot(normal) >= 0.0f
+				&& (a - c).Cross(projected - c).Dot(normal) >= 0.0f;
+			if (bInside)
+			{
+				return planeDistance * planeDistance;
+			}
+		}
+
+		return (std::min)({ PointSegmentDistanceSquared(p, a, b), PointSegmentDistanceSquared(p, b, c), PointSegmentDistanceSquared(p, c, a) });
+	}
+
+	// Every triangle against the point, what the SDF baker would cost without the BVH
+	float ClosestDistanceBruteForce(const TestMesh& mesh, const TVector3& point)
+	{
+		float bestDistanceSquared = FLT_MAX;
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			bestDistanceSquared = (std::min)(bestDistanceSquared, PointTriangleDistanceSquared(point,
+				mesh.positions[mesh.indices[i]], mesh.positions[mesh.indices[i + 1]], mesh.positions[mesh.indices[i + 2]]));
+		}
+		return std::sqrt(bestDistanceSquared);
+	}
+
+	TVector3 RandomPoint(std::mt19937& random, float extent)
+	{
+		std::uniform_real_distribution<float> distribution(-extent, extent);
+		return TVector3(distribution(random), distribution(random), distribution(random));
+	}
+
+	// Solid angle of the triangle seen from the point, after Van Oosterom and Strackee
+	float SolidAngle(const TVector3& point, const TVector3& a, const TVector3& b, const TVector3& c)
+	{
+		const TVector3 pa = a - point;
+		const TVector3 pb = b - point;
+		const TVector3 pc = c - point;
+		const float la = pa.Length();
+		const float lb = pb.Length();
+		const float lc = pc.Length();
+		return 2.0f * std::atan2(pa.Dot(pb.Cross(pc)), la * lb * lc + pa.Dot(pb) * lc + pa.Dot(pc) * lb + pb.Dot(pc) * la);
+	}
+
+	// A closed mesh winds once around the points inside it, in either orientation. No rays, so no parity to get wrong.
+	bool IsInsideBruteForce(const TestMesh& mesh, const TVector3& point)
+	{
+		float solidAngle = 0.0f;
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			solidAngle += SolidAngle(point, mesh.positions[mesh.indices[i]], mesh.positions[mesh.indices[i + 1]], mesh.positions[mesh.indices[i + 2]]);
+		}
+		return std::abs(solidAngle) > 2.0f * 3.14159265f;
+	}
+
+	TVector3 GetVoxelCenter(const MeshSDFDescriptor& descriptor, uint32_t x, uint32_t y, uint32_t z)
+	{
+		const float voxelSize = 2.0f * descriptor.extent / descriptor.resolution;
+		return descriptor.center - TVector3(descriptor.extent) + TVector3(x + 0.5f, y + 0.5f, z + 0.5f) * voxelSize;
+	}
+
+	// The bake without the BVH, the coarse bricks or the ray sweeps: every triangle for the distance and the winding
+	// number for the sign. Only every sliceStep-th z slice is baked, the others stay FLT_MAX.
+	void BakeBruteForce(const TestMesh& mesh, const MeshSDFDescriptor& descriptor, uint32_t sliceStep, std::vector<float>& outDistances)
+	{
+		const uint32_t resolution = (uint32_t)descriptor.resolution;
+		const uint32_t sliceCount = (resolution + sliceStep - 1) / sliceStep;
+		outDistances.assign((size_t)resolution * resolution * resolution, FLT_MAX);
+
+		JobSystem::Get().ParallelFor("BakeMeshSDFBruteForce", sliceCount * resolution, 1, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t row = begin; row < end; row++)
+			{
+				const uint32_t y = row % resolution;
+				const uint32_t z = row / resolution * sliceStep;
+				for (uint32_t x = 0; x < resolution; x++)
+				{
+					const TVector3 point = GetVoxelCenter(descriptor, x, y, z);
+					const float distance = ClosestDistanceBruteForce(mesh, point);
+					outDistances[x + ((size_t)y + (size_t)z * resolution) * resolution] = IsInsideBruteForce(mesh, point) ? -distance : distance;
+				}
+			}
+		});
+	}
+
+	struct SDFComparison
+	{
+		uint32_t comparedCount = 0;
+		uint32_t signErrorCount = 0;       // Voxels more than half a voxel from the surface on the wrong side
+		uint32_t overestimateCount = 0;    // Voxels farther from the surface than the reference
+		float maxNarrowBandError = 0.0f;   // In voxels, over the voxels within narrowBandVoxels of the surface
+		float meanCoarseError = 0.0f;      // In voxels, how far the interpolated voxels fall short on average
+	};
+
+	// Compares the voxels the reference baked
+	SDFComparison CompareSDF(const std::vector<float>& distances, const std::vector<float>& reference, const MeshSDFDescriptor& descriptor,
+		const MeshSDFBakeSettings& settings)
+	{
+		const float voxelSize = 2.0f * descriptor.extent / descriptor.resolution;
+
+		SDFComparison comparison;
+		uint32_t coarseCount = 0;
+		for (size_t i = 0; i < reference.size(); i++)
+		{
+			if (reference[i] == FLT_MAX)
+			{
+				continue;
+			}
+
+			comparison.comparedCount++;
+			const float error = (std::abs(distances[i]) - std::abs(reference[i])) / voxelSize;
+			comparison.signErrorCount += (distances[i] < 0.0f) != (reference[i] < 0.0f) && std::abs(reference[i]) > 0.5f * voxelSize;
+			comparison.overestimateCount += error > 1e-3f;
+
+			if (std::abs(reference[i]) <= settings.narrowBandVoxels * voxelSize)
+			{
+				comparison.maxNarrowBandError = (std::max)(comparison.maxNarrowBandError, std::abs(error));
+			}
+			else
+			{
+				comparison.meanCoarseError -= error;
+				coarseCount++;
+			}
+		}
+		comparison.meanCoarseError /= (std::max)(coarseCount, 1u);
+		return comparison;
+	}
+
+	const uint32_t TEST_WORKER_COUNT = 3;
+}
+
+TEST_CASE(TriangleBVH_FindClosestMatchesBruteForce)
+{
+	const TestMesh torus = MakeTorus(1.0f, 0.35f, 48, 24);
+	TriangleBVH bvh;
+	bvh.Build(torus.positions, torus.indices);
+	CHECK(bvh.GetTriangleCount() == torus.indices.size() / 3);
+	CHECK(bvh.GetNodeCount() < 2 * bvh.GetTriangleCount());
+
+	std::mt19937 random(5);
+	for (int i = 0; i < 2000; i++)
+	{
+		const TVector3 point = RandomPoint(random, 1.6f);
+		const float expected = ClosestDistanceBruteForce(torus, point);
+
+		float distance = FLT_MAX;
+		CHECK(bvh.FindClosest(point, FLT_MAX, distance));
+		CHECK_NEAR(distance, expected, 1e-5f + expected * 1e-5f);
+
+		// A search radius short of the surface finds nothing, one past it finds the same triangle
+		float bounded = FLT_MAX;
+		CHECK(!bvh.FindClosest(point, expected * 0.99f - 1e-5f, bounded));
+		CHECK(bvh.FindClosest(point, expected * 1.01f + 1e-5f, bounded));
+		CHECK_NEAR(bounded, expected, 1e-5f + expected * 1e-5f);
+	}
+}
+
+// The sign sweep of the SDF baker counts crossings, a box crossed through the middle has exactly two
+TEST_CASE(TriangleBVH_IntersectAllFindsEveryCrossing)
+{
+	const TestMesh box = MakeBox(0.5f);
+	TriangleBVH bvh;
+	bvh.Build(box.positions, box.indices);
+
+	std::mt19937 random(9);
+	std::uniform_real_distribution<float> offset(-0.45f, 0.45f);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int i = 0; i < 100; i++)
+		{
+			TVector3 origin(offset(random), offset(random), offset(random));
+			origin[axis] = -2.0f;
+			TVector3 direction;
+			direction[axis] = 2.0f;
+
+			std::vector<float> hits;
+			bvh.IntersectAll(origin, direction, 10.0f, hits);
+			std::sort(hits.begin(), hits.end());
+			CHECK(hits.size() == 2);
+			if (hits.size() == 2)
+			{
+				CHECK_NEAR(hits[0], 0.75f, 1e-5f);
+				CHECK_NEAR(hits[1], 1.25f, 1e-5f);
+			}
+
+			// maxT cuts off the far side
+			hits.clear();
+			bvh.IntersectAll(origin, direction, 1.0f, hits);
+			CHECK(hits.size() == 1);
+		}
+	}
+
+	// A ray that misses the box
+	std::vector<float> hits;
+	bvh.IntersectAll(TVector3(-2.0f, 0.7f, 0.0f), TVector3(1.0f, 0.0f, 0.0f), 10.0f, hits);
+	CHECK(hits.empty());
+}
+
+TEST_CASE(TriangleBVH_EmptyMesh)
+{
+	TriangleBVH bvh;
+	bvh.Build({}, {});
+	CHECK(bvh.GetTriangleCount() == 0);
+
+	float distance = 0.0f;
+	CHECK(!bvh.FindClosest(TVector3(0.0f), FLT_MAX, distance));
+
+	std::vector<float> hits;
+	bvh.IntersectAll(TVector3(0.0f), TVector3(1.0f, 0.0f, 0.0f), 10.0f, hits);
+	CHECK(hits.empty());
+}
+
+
+// A cube against its analytic distance: every voxel on the right side, exact in the narrow band, and never farther than
+// the surface where the coarse bricks interpolate
+TEST_CASE(MeshSDFBaker_CubeMatchesAnalyticDistance)
+{
+	JobSystem::Get().Initialize(TEST_WORKER_COUNT);
+
+	const float halfSize = 0.5f;
+	const TestMesh box = MakeBox(halfSize);
+	MeshSDFBakeSettings settings;
+	settings.resolution = 40;
+
+	MeshSDFDescriptor descriptor;
+	std::vector<float> distances;
+	MeshSDFBakeStats stats;
+	MeshSDFBaker::Bake(box.positions, box.indices, settings, descriptor, distances, &stats);
+	CHECK(descriptor.resolution == 40);
+	CHECK_NEAR(descriptor.extent, halfSize * 1.1f, 1e-6f);
+	CHECK(stats.triangleCount == 12 && stats.exactBrickCount > 0 && stats.coarseBrickCount > 0);
+
+	std::vector<float> reference(distances.size());
+	for (uint32_t z = 0; z < settings.resolution; z++)
+	{
+		for (uint32_t y = 0; y < settings.resolution; y++)
+		{
+			for (uint32_t x = 0; x < settings.resolution; x++)
+			{
+				const TVector3 point = GetVoxelCenter(descriptor, x, y, z);
+				const TVector3 q(std::abs(point.x) - halfSize, std::abs(point.y) - halfSize, std::abs(point.z) - halfSize);
+				const float outside = TVector3::Max(q, TVector3(0.0f)).Length();
+				const float inside = (std::min)((std::max)((std::max)(q.x, q.y), q.z), 0.0f);
+				reference[x + ((size_t)y + (size_t)z * settings.resolution) * settings.resolution] = outside + inside;
+			}
+		}
+	}
+
+	const SDFComparison comparison = CompareSDF(distances, reference, descriptor, settings);
+	std::printf("  cube: %u exact and %u coarse bricks, narrow band error %.2e voxels, coarse voxels %.3f voxels short\n",
+		stats.exactBrickCount, stats.coarseBrickCount, comparison.maxNarrowBandError, comparison.meanCoarseError);
+	CHECK(comparison.comparedCount == distances.size());
+	CHECK(comparison.signErrorCount == 0);
+	CHECK(comparison.overestimateCount == 0);
+	CHECK(comparison.maxNarrowBandError < 1e-3f);
+	CHECK(comparison.meanCoarseError < 1.0f);
+
+	JobSystem::Get().Shutdown();
+}
+
+// A sphere against the brute force bake: the ray votes agree with the winding number, and with the analytic sphere
+// away from the facets
+TEST_CASE(MeshSDFBaker_SphereMatchesBruteForce)
+{
+	JobSystem::Get().Initialize(TEST_WORKER_COUNT);
+
+	const TestMesh sphere = MakeSphere(1.0f, 2);
+	MeshSDFBakeSettings settings;
+	settings.resolution = 24;
+
+	MeshSDFDescriptor descriptor;
+	std::vector<float> distances, reference;
+	MeshSDFBaker::Bake(sphere.positions, sphere.indices, settings, descriptor, distances);
+	BakeBruteForce(sphere, descriptor, 1, reference);
+
+	const SDFComparison comparison = CompareSDF(distances, reference, descriptor, settings);
+	std::printf("  sphere: narrow band error %.2e voxels, coarse voxels %.3f voxels short\n", comparison.maxNarrowBandError, comparison.meanCoarseError);
+	CHECK(comparison.comparedCount == distances.size());
+	CHECK(comparison.signErrorCount == 0);
+	CHECK(comparison.overestimateCount == 0);
+	CHECK(comparison.maxNarrowBandError < 1e-3f);
+
+	uint32_t analyticSignErrorCount = 0;
+	uint32_t insideCount = 0;
+	for (uint32_t z = 0; z < settings.resolution; z++)
+	{
+		for (uint32_t y = 0; y < settings.resolution; y++)
+		{
+			for (uint32_t x = 0; x < settings.resolution; x++)
+			{
+				const float radius = GetVoxelCenter(descriptor, x, y, z).Length();
+				const bool bInside = distances[x + ((size_t)y + (size_t)z * settings.resolution) * settings.resolution] < 0.0f;
+				analyticSignErrorCount += std::abs(radius - 1.0f) > 0.05f && bInside != (radius < 1.0f);
+				insideCount += bInside;
+			}
+		}
+	}
+	CHECK(analyticSignErrorCount == 0);
+	CHECK(insideCount > 0);
+
+	JobSystem::Get().Shutdown();
+}
+
+// The full bake of a 4k triangle torus at 64^3 and 128^3 against the brute force bake. The brute force bake runs on
+// four z slices and is scaled up, the whole volume would take minutes.
+BENCHMARK_CASE(MeshSDFBaker_BakeVsBruteForce)
+{
+	JobSystem::Get().Initialize();
+
+	const TestMesh torus = MakeTorus(1.0f, 0.35f, 64, 32);
+	for (uint32_t resolution : { 64u, 128u })
+	{
+		const uint32_t sliceStep = resolution / 4;
+		MeshSDFBakeSettings settings;
+		settings.resolution = resolution;
+
+		MeshSDFDescriptor descriptor;
+		std::vector<float> distances, reference;
+		MeshSDFBakeStats stats;
+		BenchmarkTimer bakeTimer;
+		MeshSDFBaker::Bake(torus.positions, torus.indices, settings, descriptor, distances, &stats);
+		const double bakeMs = bakeTimer.GetElapsedMs();
+
+		BenchmarkTimer bruteForceTimer;
+		BakeBruteForce(torus, descriptor, sliceStep, reference);
+		const double bruteForceMs = bruteForceTimer.GetElapsedMs() * sliceStep;
+
+		const SDFComparison comparison = CompareSDF(distances, reference, descriptor, settings);
+		std::printf("  %u^3, %u triangles, %u workers: bake %.1f ms (BVH %.1f, sign %.1f, distance %.1f), brute force about %.0f ms (%.0fx)\n",
+			resolution, stats.triangleCount, JobSystem::Get().GetWorkerCount(), bakeMs, stats.buildMs, stats.signMs, stats.distanceMs,
+			bruteForceMs, bruteForceMs / bakeMs);
+		std::printf("    %u exact and %u coarse bricks, %.2f queries per voxel, narrow band error %.2e voxels, coarse voxels %.3f voxels short\n",
+			stats.exactBrickCount, stats.coarseBrickCount, (double)stats.closestPointQueries / distances.size(), comparison.maxNarrowBandError,
+			comparison.meanCoarseError);
+
+		CHECK(comparison.signErrorCount == 0);
+		CHECK(comparison.overestimateCount == 0);
+		CHECK(comparison.maxNarrowBandError < 1e-3f);
+		CHECK(bakeMs * 10.0 < bruteForceMs);
+	}
+
+	JobSystem::Get().Shutdown();
+}
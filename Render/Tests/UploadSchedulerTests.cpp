@@ -0,0 +1,266 @@
+#include "TestFramework.h"
+#include "../src/Resource/UploadScheduler.h"
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+	// Stands in for the copy queue: Submit signals the next fence value, the GPU finishes them when told to
+	struct FakeCopyQueue
+	{
+		UploadScheduler& scheduler;
+		uint64_t currentFenceValue = 0;
+		uint64_t completedFenceValue = 0;
+
+		explicit FakeCopyQueue(UploadScheduler& inScheduler) : scheduler(inScheduler) {}
+
+		void Submit()
+		{
+			if (scheduler.HasRecordedChunks())
+			{
+				scheduler.Submit(++currentFenceValue);
+			}
+		}
+
+		void Complete(uint64_t fenceValue)
+		{
+			completedFenceValue = (std::max)(completedFenceValue, (std::min)(fenceValue, currentFenceValue));
+			scheduler.Retire(completedFenceValue);
+		}
+
+		// The loop of CopyQueueUploader::WaitOnQueue, with the CPU wait replaced by completing the oldest fence.
+		// Returns the number of iterations, or 0 when it did not finish.
+		uint32_t WaitFor(UploadTicket ticket, uint64_t& outFenceValue)
+		{
+			for (uint32_t iteration = 1; iteration <= 10000; iteration++)
+			{
+				if (scheduler.GetFenceValue(ticket, outFenceValue))
+				{
+					return iteration;
+				}
+
+				scheduler.Record(UINT64_MAX);
+				Submit();
+
+				if (!scheduler.GetFenceValue(ticket, outFenceValue))
+				{
+					Complete(scheduler.GetOldestFenceValue());
+				}
+			}
+			return 0;
+		}
+	};
+
+	struct RecordedChunk
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	UploadScheduler::Chunk MakeChunk(uint64_t size, uint64_t alignment, std::vector<RecordedChunk>& outRecorded)
+	{
+		UploadScheduler::Chunk chunk;
+		chunk.size = size;
+		chunk.alignment = alignment;
+		chunk.record = [&outRecorded, size](uint64_t stagingOffset) { outRecorded.push_back({ stagingOffset, size }); };
+		return chunk;
+	}
+}
+
+TEST_CASE(UploadScheduler_TicketsCompleteWithTheirFence)
+{
+	UploadScheduler scheduler(1024);
+	FakeCopyQueue queue(scheduler);
+	std::vector<RecordedChunk> recorded;
+
+	std::vector<UploadScheduler::Chunk> chunks;
+	chunks.push_back(MakeChunk(100, 16, recorded));
+	chunks.push_back(MakeChunk(100, 16, recorded));
+	const UploadTicket first = scheduler.Enqueue(std::move(chunks));
+
+	chunks.clear();
+	chunks.push_back(MakeChunk(300, 256, recorded));
+	const UploadTicket second = scheduler.Enqueue(std::move(chunks));
+	CHECK(first == 1 && second == 2 && scheduler.GetLastTicket() == 2);
+	CHECK(scheduler.GetStats().pendingBytes == 500);
+
+	// Nothing is submitted, there is no fence to wait on yet
+	uint64_t fenceValue = 0;
+	CHECK(!scheduler.GetFenceValue(first, fenceValue));
+
+	// The budget stops after the first ticket
+	CHECK(scheduler.Record(250) == 200);
+	queue.Submit();
+	CHECK(scheduler.GetFenceValue(first, fenceValue) && fenceValue == 1);
+	CHECK(!scheduler.GetFenceValue(second, fenceValue));
+
+	scheduler.Record(UINT64_MAX);
+	queue.Submit();
+	CHECK(scheduler.GetFenceValue(second, fenceValue) && fenceValue == 2);
+	CHECK(recorded.size() == 3 && recorded[1].offset == 112 && recorded[2].offset == 256);
+
+	queue.Complete(1);
+	CHECK(scheduler.IsComplete(first) && !scheduler.IsComplete(second));
+	CHECK(scheduler.GetFenceValue(first, fenceValue) && fenceValue == 0);
+
+	queue.Complete(2);
+	CHECK(scheduler.IsComplete(second));
+	CHECK(scheduler.GetStats().stagingBytes == 0 && scheduler.GetStats().pendingBytes == 0);
+}
+
+// A budget smaller than the first chunk still records it, otherwise nothing would ever move
+TEST_CASE(UploadScheduler_BudgetAlwaysRecordsOneChunk)
+{
+	UploadScheduler scheduler(4096);
+	std::vector<RecordedChunk> recorded;
+
+	std::vector<UploadScheduler::Chunk> chunks;
+	for (int i = 0; i < 4; i++)
+	{
+		chunks.push_back(MakeChunk(1000, 1, recorded));
+	}
+	scheduler.Enqueue(std::move(chunks));
+
+	CHECK(scheduler.Record(10) == 1000);
+	CHECK(scheduler.Record(2500) == 2000);
+	CHECK(scheduler.Record(0) == 1000);
+	CHECK(!scheduler.HasPendingChunks());
+}
+
+// Chunks in flight keep their ring space until their fence, new chunks wrap around them and never overlap
+TEST_CASE(UploadScheduler_RingNeverOverlapsChunksInFlight)
+{
+	const uint64_t capacity = 1 << 20;
+	UploadScheduler scheduler(capacity);
+	FakeCopyQueue queue(scheduler);
+	std::mt19937 random(1);
+
+	// Chunks of fence value i + 1 at i, back() is being recorded
+	std::vector<std::vector<RecordedChunk>> inFlight(1);
+	std::vector<UploadTicket> tickets;
+	uint32_t errorCount = 0;
+
+	for (int frame = 0; frame < 5000 || scheduler.HasPendingChunks(); frame++)
+	{
+		const int requestCount = frame < 5000 ? random() % 4 : 0;
+		for (int r = 0; r < requestCount; r++)
+		{
+			std::vector<UploadScheduler::Chunk> chunks;
+			const int chunkCount = 1 + random() % 5;
+			for (int c = 0; c < chunkCount; c++)
+			{
+				const uint64_t size = 1 + random() % (capacity / 6);
+				const uint64_t alignment = random() % 2 ? 512 : 1;
+
+				UploadScheduler::Chunk chunk;
+				chunk.size = size;
+				chunk.alignment = alignment;
+				chunk.record = [&, size, alignment](uint64_t stagingOffset)
+				{
+					if (stagingOffset % alignment != 0 || stagingOffset + size > capacity)
+					{
+						errorCount++;
+					}
+
+					for (size_t i = queue.completedFenceValue; i < inFlight.size(); i++)
+					{
+						for (const RecordedChunk& other : inFlight[i])
+						{
+							if (stagingOffset < other.offset + other.size && other.offset < stagingOffset + size)
+							{
+								errorCount++;
+							}
+						}
+					}
+					inFlight.back().push_back({ stagingOffset, size });
+				};
+				chunks.push_back(std::move(chunk));
+			}
+			tickets.push_back(scheduler.Enqueue(std::move(chunks), std::make_shared<int>(0)));
+		}
+
+		const bool bRecorded = scheduler.Record(capacity / 3) > 0;
+		if (bRecorded)
+		{
+			queue.Submit();
+			inFlight.emplace_back();
+		}
+
+		// The GPU runs two submissions behind, the CPU waits for all of them when the ring is full
+		if (!bRecorded && scheduler.HasPendingChunks())
+		{
+			queue.Complete(queue.currentFenceValue);
+		}
+		else if (queue.currentFenceValue >= 3)
+		{
+			queue.Complete(queue.currentFenceValue - 2);
+		}
+
+		for (UploadTicket ticket : tickets)
+		{
+			uint64_t fenceValue = 0;
+			if (scheduler.GetFenceValue(ticket, fenceValue) && !scheduler.IsComplete(ticket))
+			{
+				CHECK(fenceValue > queue.completedFenceValue && fenceValue <= queue.currentFenceValue);
+			}
+		}
+	}
+
+	for (UploadTicket ticket : tickets)
+	{
+		uint64_t fenceValue = 0;
+		CHECK(queue.WaitFor(ticket, fenceValue) > 0);
+	}
+	queue.Complete(queue.currentFenceValue);
+
+	CHECK(errorCount == 0);
+	CHECK(scheduler.IsComplete(tickets.back()));
+	CHECK(scheduler.GetStats().stagingBytes == 0 && scheduler.GetStats().pendingBytes == 0);
+	CHECK(scheduler.GetStats().peakStagingBytes <= capacity);
+	std::printf("  %zu tickets over %llu submissions, peak staging %llu of %llu bytes\n", tickets.size(),
+		(unsigned long long)queue.currentFenceValue, (unsigned long long)scheduler.GetStats().peakStagingBytes, (unsigned long long)capacity);
+}
+
+// A chunk larger than the ring would never be recorded and WaitOnQueue would loop forever on its ticket
+TEST_CASE(UploadScheduler_RejectsChunksLargerThanTheRing)
+{
+	UploadScheduler scheduler(4096);
+	FakeCopyQueue queue(scheduler);
+	std::vector<RecordedChunk> recorded;
+
+	std::vector<UploadScheduler::Chunk> chunks;
+	chunks.push_back(MakeChunk(100, 16, recorded));
+	chunks.push_back(MakeChunk(4097, 16, recorded));
+
+	bool bThrown = false;
+	try
+	{
+		scheduler.Enqueue(std::move(chunks));
+	}
+	catch (const std::runtime_error&)
+	{
+		bThrown = true;
+	}
+	CHECK(bThrown);
+
+	// Nothing of the request was kept, not even its small chunk or a ticket
+	CHECK(!scheduler.HasPendingChunks());
+	CHECK(scheduler.GetLastTicket() == 0);
+	CHECK(scheduler.GetStats().pendingBytes == 0);
+
+	// A chunk of the full ring fits once the ring drained, behind one that is still in flight
+	chunks.clear();
+	chunks.push_back(MakeChunk(1000, 16, recorded));
+	const UploadTicket small = scheduler.Enqueue(std::move(chunks));
+	scheduler.Record(UINT64_MAX);
+	queue.Submit();
+
+	chunks.clear();
+	chunks.push_back(MakeChunk(4096, 512, recorded));
+	const UploadTicket full = scheduler.Enqueue(std::move(chunks));
+
+	uint64_t fenceValue = 0;
+	CHECK(queue.WaitFor(full, fenceValue) > 0);
+	CHECK(scheduler.IsComplete(small));
+	CHECK(fenceValue == 2 && recorded.back().offset == 0);
+}
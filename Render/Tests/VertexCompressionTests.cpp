@@ -0,0 +1,132 @@
+#include "TestFramework.h"
+#include "../src/Mesh/VertexCompression.h"
+#include <random>
+
+namespace
+{
+	TVector3 RandomUnitVector(std::mt19937& random)
+	{
+		std::normal_distribution<float> gaussian(0.0f, 1.0f);
+		TVector3 v;
+		do
+		{
+			v = TVector3(gaussian(random), gaussian(random), gaussian(random));
+		} while (v.LengthSquared() < 1e-6f);
+
+		v.Normalize();
+		return v;
+	}
+
+	TBoundingBox MakeBounds(const TVector3& boxMin, const TVector3& boxMax)
+	{
+		TBoundingBox bounds;
+		bounds.boxMin = boxMin;
+		bounds.boxMax = boxMax;
+		bounds.bInit = true;
+		return bounds;
+	}
+}
+
+// 100k random vertices, the worst error must stay within what the formats can represent:
+// half a 16 bit step per position axis, the 8 bit octahedral grid for directions, half float for texcoords in [0, 1]
+TEST_CASE(VertexCompression_RandomVerticesStayWithinFormatError)
+{
+	const TBoundingBox bounds = MakeBounds(TVector3(-3.0f, 0.0f, -1.5f), TVector3(5.0f, 2.0f, 1.5f));
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	std::vector<Vertex> vertices(100000);
+	for (Vertex& vertex : vertices)
+	{
+		vertex.position = TVector3(-3.0f + 8.0f * unit(random), 2.0f * unit(random), -1.5f + 3.0f * unit(random));
+		vertex.normal = RandomUnitVector(random);
+		vertex.tangentU = RandomUnitVector(random);
+		vertex.texcoord = TVector2(unit(random), unit(random));
+	}
+
+	const VertexCompressionError error = VertexCompression::MeasureError(vertices, bounds);
+
+	const TVector3 step = bounds.GetSize() / 65535.0f;
+	const float maxPositionError = 0.5f * step.Length();
+	CHECK(error.maxPositionError <= maxPositionError * 1.01f);
+	CHECK(error.maxNormalAngle < 1.5f);
+	CHECK(error.maxTangentAngle < 1.5f);
+	CHECK(error.maxTexcoordError <= 1.0f / 4096.0f);
+
+	std::printf("  position %.6f (bound %.6f), normal %.3f deg, tangent %.3f deg, texcoord %.6f\n", error.maxPositionError,
+		maxPositionError, error.maxNormalAngle, error.maxTangentAngle, error.maxTexcoordError);
+}
+
+TEST_CASE(VertexCompression_ExactValuesRoundTrip)
+{
+	const TBoundingBox bounds = MakeBounds(TVector3(-1.0f, -2.0f, -4.0f), TVector3(1.0f, 2.0f, 4.0f));
+
+	// The box corners and the axes are on the quantization grids
+	const TVector3 axes[] = {
+		TVector3(1.0f, 0.0f, 0.0f), TVector3(-1.0f, 0.0f, 0.0f),
+		TVector3(0.0f, 1.0f, 0.0f), TVector3(0.0f, -1.0f, 0.0f),
+		TVector3(0.0f, 0.0f, 1.0f), TVector3(0.0f, 0.0f, -1.0f),
+	};
+	for (const TVector3& axis : axes)
+	{
+		Vertex vertex;
+		vertex.position = bounds.boxMin;
+		vertex.normal = axis;
+		vertex.tangentU = axis * -1.0f;
+		vertex.texcoord = TVector2(0.5f, 0.25f);
+
+		const Vertex decoded = VertexCompression::Decode(VertexCompression::Encode(vertex, bounds), bounds);
+		CHECK_NEAR((decoded.normal - axis).Length(), 0.0f, 1e-6f);
+		CHECK_NEAR((decoded.tangentU + axis).Length(), 0.0f, 1e-6f);
+		CHECK(decoded.position.x == bounds.boxMin.x && decoded.position.y == bounds.boxMin.y && decoded.position.z == bounds.boxMin.z);
+		CHECK(decoded.texcoord.x == 0.5f && decoded.texcoord.y == 0.25f);
+
+		vertex.position = bounds.boxMax;
+		const CompactVertex encoded = VertexCompression::Encode(vertex, bounds);
+		CHECK(encoded.position[0] == 65535 && encoded.position[1] == 65535 && encoded.position[2] == 65535);
+		CHECK(encoded.position[3] == 0);
+	}
+}
+
+TEST_CASE(VertexCompression_FlatAxisDecodesToBoxMin)
+{
+	// A plane, the y extent is zero
+	const TBoundingBox bounds = MakeBounds(TVector3(-1.0f, 0.5f, -1.0f), TVector3(1.0f, 0.5f, 1.0f));
+
+	Vertex vertex;
+	vertex.position = TVector3(0.25f, 0.5f, -0.75f);
+	vertex.normal = TVector3(0.0f, 1.0f, 0.0f);
+	vertex.tangentU = TVector3(1.0f, 0.0f, 0.0f);
+
+	const CompactVertex encoded = VertexCompression::Encode(vertex, bounds);
+	CHECK(encoded.position[1] == 0);
+
+	const Vertex decoded = VertexCompression::Decode(encoded, bounds);
+	CHECK(decoded.position.y == 0.5f);
+	CHECK_NEAR(decoded.position.x, 0.25f, 2.0f / 65535.0f);
+	CHECK_NEAR(decoded.position.z, -0.75f, 2.0f / 65535.0f);
+}
+
+TEST_CASE(VertexCompression_LowerHemisphereFoldsBack)
+{
+	// Directions just below the equator and around the south pole cross the octahedron fold
+	std::vector<Vertex> vertices;
+	for (int i = 0; i < 360; i++)
+	{
+		const float theta = i * 3.1415926535f / 180.0f;
+		for (float z : { -0.01f, -0.5f, -0.99f })
+		{
+			const float r = std::sqrt(1.0f - z * z);
+			Vertex vertex;
+			vertex.normal = TVector3(r * std::cos(theta), r * std::sin(theta), z);
+			vertex.tangentU = TVector3(-vertex.normal.x, -vertex.normal.y, -vertex.normal.z);
+			vertices.push_back(vertex);
+		}
+	}
+
+	const TBoundingBox bounds = MakeBounds(TVector3(0.0f, 0.0f, 0.0f), TVector3(1.0f, 1.0f, 1.0f));
+	const VertexCompressionError error = VertexCompression::MeasureError(vertices, bounds);
+	CHECK(error.maxNormalAngle < 1.5f);
+	CHECK(error.maxTangentAngle < 1.5f);
+}
@@ -1,10 +1,61 @@
 #include "Actor.h"
+#include "../Utility/JobSystem.h"
+
+// Actors ticked per job
+#define ACTOR_TICK_BATCH_SIZE 64
 
 Actor::Actor(const std::string& name)
 {
 	SetName(name);
 }
 
+void Actor::AddToRegistry(ClassRegistry& registry)
+{
+	classRegistry = &registry;
+
+	RegisterClassLists(registry);
+	for (const auto& component : components)
+	{
+		component->RegisterClassLists(registry);
+	}
+}
+
+void Actor::TickActors(const std::vector<std::unique_ptr<Actor>>& actors, float DeltaSeconds, std::vector<Actor*>& tickActors)
+{
+	// The parallel actors first, then the serial ones
+	tickActors.clear();
+	for (const auto& actor : actors)
+	{
+		if (actor->IsTickInParallel())
+		{
+			tickActors.push_back(actor.get());
+		}
+	}
+
+	const uint32_t parallelCount = static_cast<uint32_t>(tickActors.size());
+	for (const auto& actor : actors)
+	{
+		if (!actor->IsTickInParallel())
+		{
+			tickActors.push_back(actor.get());
+		}
+	}
+
+	JobSystem::Get().ParallelFor("ActorTick", parallelCount, ACTOR_TICK_BATCH_SIZE,
+		[&tickActors, DeltaSeconds](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				tickActors[i]->Tick(DeltaSeconds);
+			}
+		});
+
+	for (size_t i = parallelCount; i < tickActors.size(); i++)
+	{
+		tickActors[i]->Tick(DeltaSeconds);
+	}
+}
+
 void Actor::SetActorTransform(const TTransform& newTransform)
 {
 	rootComponent->SetWorldTransform(newTransform);
@@ -33,14 +84,4 @@ void Actor::SetActorRotation(const TRotator& newRotation)
 TRotator Actor::GetActorRotation() const
 {
 	return rootComponent->GetWorldRotation();
-}
-
-void Actor::SetActorPrevTransform(const TTransform& prevTransform)
-{
-	rootComponent->SetPrevWorldTransform(prevTransform);
-}
-
-TTransform Actor::GetActorPrevTransform() const
-{
-	return rootComponent->GetPrevWorldTransform();
 }
\ No newline at end of file
@@ -11,21 +11,50 @@ public:
 	Actor(const std::string& name);
 	virtual ~Actor() {}
 
+	// Lists the actor under its class and base classes, see DECLARE_CLASS
+	virtual void RegisterClassLists(ClassRegistry& registry) { registry.Add<Actor>(this); }
+
+	// Called by World::AddActor, lists the actor and its components. Components added later are listed by AddComponent.
+	void AddToRegistry(ClassRegistry& registry);
+
 protected:
 	std::string actorName;
 	std::vector <std::unique_ptr<Component>> components;
 	Component* rootComponent = nullptr;
 
+	ClassRegistry* classRegistry = nullptr;
+
+	bool bTickInParallel = false;
+
 public:
 	virtual void Tick(float DeltaSeconds) {}
 
+	// Parallel ticks run on the workers together with other actors, Tick may then only change this actor and its own
+	// components: no other actors, no world state such as debug drawing. Off by default.
+	void SetTickInParallel(bool bParallel) { bTickInParallel = bParallel; }
+	bool IsTickInParallel() const { return bTickInParallel; }
+
+	// Ticks the parallel actors on the job system, then the others in order on the calling thread, so serial ticks see
+	// the parallel ones done. The flags are read once per frame. tickActors is kept by the caller to avoid allocating.
+	static void TickActors(const std::vector<std::unique_ptr<Actor>>& actors, float DeltaSeconds, std::vector<Actor*>& tickActors);
+
+	// Whether the renderer draws the mesh components of this actor
+	virtual bool IsDrawMesh() { return true; }
+
 public:
 	template<typename T>
 	T* AddComponent()
 	{
 		auto newComponent = std::make_unique<T>();
 		T* result = newComponent.get();
+		result->SetOwner(this);
 		components.push_back(std::move(newComponent));
+
+		if (classRegistry)
+		{
+			result->RegisterClassLists(*classRegistry);
+		}
+
 		return result;
 	}
 
@@ -39,24 +68,34 @@ public:
 		return result;
 	}
 
-	template<typename T>
-	std::vector<T*> GetComponentsOfClass()
+	Component* GetRootComponent() const 
+	{
+		return rootComponent;
+	}
+
+	// Appends the components without a parent, the transform update pass starts from them
+	void GetUnattachedComponents(std::vector<Component*>& outComponents) const
 	{
-		std::vector<T*> result;
 		for (const auto& component : components)
 		{
-			T* componentOfClass = dynamic_cast<T*>(component.get());
-			if (componentOfClass)
+			if (!component->GetParent())
 			{
-				result.push_back(componentOfClass);
+				outComponents.push_back(component.get());
 			}
 		}
-		return result;
 	}
 
-	Component* GetRootComponent() const 
+	// Attaches the root component, the actor then moves with the parent.
+	// Moving either actor dirties the other one, so both tick serially from now on.
+	void AttachToComponent(Component* parent)
 	{
-		return rootComponent;
+		rootComponent->AttachTo(parent);
+
+		bTickInParallel = false;
+		if (parent && parent->GetOwner())
+		{
+			parent->GetOwner()->bTickInParallel = false;
+		}
 	}
 
 	virtual void SetActorTransform(const TTransform& newTransform);
@@ -68,9 +107,6 @@ public:
 	void SetActorRotation(const TRotator& newRotation);
 	TRotator GetActorRotation() const;
 
-	void SetActorPrevTransform(const TTransform& prevTransform);
-	TTransform GetActorPrevTransform() const;
-
 	void SetName(std::string name) { actorName = name; }
 	std::string GetName() const { return actorName; }
 };
\ No newline at end of file
@@ -5,6 +5,8 @@
 
 class TCameraActor : public Actor
 {
+	DECLARE_CLASS(TCameraActor, Actor)
+
 public:
 	TCameraActor(const std::string& name);
 	~TCameraActor();
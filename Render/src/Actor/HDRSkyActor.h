@@ -5,6 +5,8 @@
 
 class HDRSkyActor : public Actor
 {
+	DECLARE_CLASS(HDRSkyActor, Actor)
+
 public:
 	HDRSkyActor(const std::string& name);
 	~HDRSkyActor();
@@ -5,6 +5,8 @@
 
 class DirectionalLightActor : public LightActor
 {
+	DECLARE_CLASS(DirectionalLightActor, LightActor)
+
 public:
 	DirectionalLightActor(const std::string& Name);
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Actor.h"
+#include "../../World/LooseOctree.h"
 
 enum ELightType
 {
@@ -14,6 +15,8 @@ enum ELightType
 
 class LightActor : public Actor
 {
+	DECLARE_CLASS(LightActor, Actor)
+
 public:
 	LightActor(const std::string& name, ELightType inType);
 
@@ -55,7 +58,32 @@ public:
 		bDrawDebug = bDraw;
 	}
 
-	bool IsDrawMesh()
+	bool IsCastShadows() const
+	{
+		return bCastShadows;
+	}
+
+	void SetCastShadows(bool bCast)
+	{
+		bCastShadows = bCast;
+	}
+
+	// Scales the shadow map resolution of point and spot lights, and their priority when the shadow atlas is full
+	float GetShadowImportance() const
+	{
+		return shadowImportance;
+	}
+
+	void SetShadowImportance(float importance)
+	{
+		shadowImportance = importance;
+	}
+
+	// Entry in the light index of the world, LOOSE_OCTREE_INVALID_ID for directional lights
+	uint32_t GetSceneIndexId() const { return sceneIndexId; }
+	void SetSceneIndexId(uint32_t id) { sceneIndexId = id; }
+
+	virtual bool IsDrawMesh() override
 	{
 		return bDrawMesh;
 	}
@@ -73,6 +101,9 @@ protected:
 	float intensity = 10.0f;
 
 	bool bCastShadows = true;
+	float shadowImportance = 1.0f;
 	bool bDrawDebug = false;
 	bool bDrawMesh = false;
+
+	uint32_t sceneIndexId = LOOSE_OCTREE_INVALID_ID;
 };
@@ -5,6 +5,8 @@
 
 class PointLightActor : public LightActor
 {
+	DECLARE_CLASS(PointLightActor, LightActor)
+
 public:
 	PointLightActor(const std::string& Name);
 
@@ -5,6 +5,8 @@
 
 class SpotLightActor : public LightActor
 {
+	DECLARE_CLASS(SpotLightActor, LightActor)
+
 public:
 	SpotLightActor(const std::string& Name);
 
@@ -29,4 +29,9 @@ void StaticMeshActor::SetTextureScale(const TVector2& Scale)
 void StaticMeshActor::SetUseSDF(bool bUseSDF)
 {
 	StaticMeshComponent->bUseSDF = bUseSDF;
+}
+
+void StaticMeshActor::SetStatic(bool bStatic)
+{
+	StaticMeshComponent->bStatic = bStatic;
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 
 class StaticMeshActor : public Actor
 {
+	DECLARE_CLASS(StaticMeshActor, Actor)
+
 public:
 	StaticMeshActor(const std::string& Name);
 
@@ -18,6 +20,9 @@ public:
 
 	void SetUseSDF(bool bUseSDF);
 
+	// Meshes that never move should be static, see MeshComponent::bStatic
+	void SetStatic(bool bStatic);
+
 private:
 	MeshComponent* StaticMeshComponent = nullptr;
 };
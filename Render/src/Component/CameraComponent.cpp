@@ -11,7 +11,7 @@ CameraComponent::~CameraComponent()
 
 void CameraComponent::SetWorldLocation(const TVector3& Location)
 {
-	worldTransform.Location = Location;
+	Component::SetWorldLocation(Location);
 	viewDirty = true;
 }
 
@@ -83,7 +83,7 @@ void CameraComponent::LookAt(const TVector3& pos, const TVector3& target, const
 	R.Normalize();
 	TVector3 U = L.Cross(R);
 
-	worldTransform.Location = pos;
+	SetWorldLocation(pos);
 	look = L;
 	right = R;
 	this->up = U;
@@ -105,23 +105,17 @@ TMatrix CameraComponent::GetProj()const
 
 void CameraComponent::MoveRight(float dist)
 {
-	worldTransform.Location += dist * right;
-
-	viewDirty = true;
+	SetWorldLocation(GetWorldLocation() + dist * right);
 }
 
 void CameraComponent::MoveForward(float dist)
 {
-	worldTransform.Location += dist * look;
-
-	viewDirty = true;
+	SetWorldLocation(GetWorldLocation() + dist * look);
 }
 
 void CameraComponent::MoveUp(float dist)
 {
-	worldTransform.Location += dist * up;
-
-	viewDirty = true;
+	SetWorldLocation(GetWorldLocation() + dist * up);
 }
 
 void CameraComponent::Pitch(float degrees)
@@ -164,9 +158,10 @@ void CameraComponent::UpdateViewMatrix()
 		right = up.Cross(look);
 
 		// Fill in the view matrix entries.
-		float x = -worldTransform.Location.Dot(right);
-		float y = -worldTransform.Location.Dot(up);
-		float z = -worldTransform.Location.Dot(look);
+		TVector3 location = GetWorldLocation();
+		float x = -location.Dot(right);
+		float y = -location.Dot(up);
+		float z = -location.Dot(look);
 
 		view(0, 0) = right.x;
 		view(1, 0) = right.y;
@@ -4,6 +4,8 @@
 
 class CameraComponent : public Component
 {
+	DECLARE_CLASS(CameraComponent, Component)
+
 public:
 	CameraComponent();
 	~CameraComponent();
@@ -0,0 +1,189 @@
+#include "Component.h"
+#include <algorithm>
+#include <assert.h>
+
+Component::~Component()
+{
+	Detach();
+
+	for (Component* child : children)
+	{
+		child->parent = nullptr;
+		child->MarkTransformDirty();
+	}
+}
+
+void Component::AttachTo(Component* newParent)
+{
+	if (newParent == parent)
+	{
+		return;
+	}
+
+#ifdef _DEBUG
+	for (Component* ancestor = newParent; ancestor; ancestor = ancestor->parent)
+	{
+		assert(ancestor != this && "Attaching would create a cycle");
+	}
+#endif
+
+	Detach();
+
+	parent = newParent;
+	if (parent)
+	{
+		parent->children.push_back(this);
+	}
+
+	MarkTransformDirty();
+}
+
+void Component::Detach()
+{
+	if (!parent)
+	{
+		return;
+	}
+
+	auto& siblings = parent->children;
+	siblings.erase(std::find(siblings.begin(), siblings.end(), this));
+	parent = nullptr;
+
+	MarkTransformDirty();
+}
+
+void Component::SetWorldLocation(const TVector3& Location)
+{
+	if (parent)
+	{
+		relativeTransform.Location = parent->GetInvWorldMatrix().Transform(Location);
+	}
+	else
+	{
+		relativeTransform.Location = Location;
+	}
+
+	MarkLocalDirty();
+}
+
+TVector3 Component::GetWorldLocation() const
+{
+	return parent ? GetWorldMatrix().Translation() : relativeTransform.Location;
+}
+
+void Component::SetWorldRotation(const TRotator& Rotation)
+{
+	if (parent)
+	{
+		TTransform worldTransform = GetWorldTransform();
+		worldTransform.Rotation = Rotation;
+		SetWorldTransform(worldTransform);
+	}
+	else
+	{
+		relativeTransform.Rotation = Rotation;
+		MarkLocalDirty();
+	}
+}
+
+TRotator Component::GetWorldRotation() const
+{
+	return parent ? TTransform::FromMatrix(GetWorldMatrix()).Rotation : relativeTransform.Rotation;
+}
+
+void Component::SetWorldTransform(const TTransform& Transform)
+{
+	if (parent)
+	{
+		relativeTransform = TTransform::FromMatrix(Transform.GetTransformMatrix() * parent->GetInvWorldMatrix());
+	}
+	else
+	{
+		relativeTransform = Transform;
+	}
+
+	MarkLocalDirty();
+}
+
+TTransform Component::GetWorldTransform() const
+{
+	return parent ? TTransform::FromMatrix(GetWorldMatrix()) : relativeTransform;
+}
+
+TMatrix Component::GetWorldMatrix() const
+{
+	if (!bTransformDirty)
+	{
+		return worldMatrix;
+	}
+
+	TMatrix local = bLocalMatrixDirty ? relativeTransform.GetTransformMatrix() : localMatrix;
+	return parent ? local * parent->GetWorldMatrix() : local;
+}
+
+TMatrix Component::GetInvWorldMatrix() const
+{
+	return bTransformDirty ? GetWorldMatrix().Invert() : invWorldMatrix;
+}
+
+bool Component::UpdateWorldMatrix()
+{
+	assert(!parent || !parent->bTransformDirty);
+
+	bNeedsUpdate = false;
+	if (!bTransformDirty)
+	{
+		return false;
+	}
+
+	if (bLocalMatrixDirty)
+	{
+		localMatrix = relativeTransform.GetTransformMatrix();
+		bLocalMatrixDirty = false;
+	}
+
+	worldMatrix = parent ? localMatrix * parent->worldMatrix : localMatrix;
+	invWorldMatrix = worldMatrix.Invert();
+	bTransformDirty = false;
+
+	if (!bWorldMatrixValid)
+	{
+		prevWorldMatrix = worldMatrix;
+		bWorldMatrixValid = true;
+	}
+
+	return true;
+}
+
+void Component::MarkLocalDirty()
+{
+	bLocalMatrixDirty = true;
+	MarkTransformDirty();
+}
+
+void Component::MarkTransformDirty()
+{
+	MarkSubtreeDirty();
+
+	// The update pass walks down from the roots through flagged components only
+	for (Component* ancestor = parent; ancestor && !ancestor->bNeedsUpdate; ancestor = ancestor->parent)
+	{
+		ancestor->bNeedsUpdate = true;
+	}
+}
+
+void Component::MarkSubtreeDirty()
+{
+	// Only the update pass cleans matrices and it cleans whole subtrees, so below a dirty component everything is dirty
+	if (bTransformDirty)
+	{
+		return;
+	}
+
+	bTransformDirty = true;
+	bNeedsUpdate = true;
+	for (Component* child : children)
+	{
+		child->MarkSubtreeDirty();
+	}
+}
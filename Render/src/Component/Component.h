@@ -1,56 +1,120 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
 #include "../Math/Transform.h"
+#include "../World/ClassRegistry.h"
+#include "../World/LooseOctree.h"
 
+class Actor;
+
+// Components form a hierarchy, each one is placed by relativeTransform in its parent's space (world space without a parent).
+// The local-to-world matrix and its inverse are cached. Changing a transform marks the component and its subtree dirty
+// and flags the path up to the root, World::UpdateTransforms then rebuilds the dirty matrices once per frame,
+// breadth first from the roots so parents come before children. Unflagged subtrees are not visited.
 class Component
 {
 public:
 	Component() {}
-	virtual ~Component() {}
+	virtual ~Component();
+
+	// Lists the component under its class and base classes, see DECLARE_CLASS
+	virtual void RegisterClassLists(ClassRegistry& registry) { registry.Add<Component>(this); }
+
+	// Set by Actor::AddComponent
+	Actor* GetOwner() const { return owner; }
+	void SetOwner(Actor* newOwner) { owner = newOwner; }
+
+	// Entry in the scene index of the world, LOOSE_OCTREE_INVALID_ID for components it does not hold
+	uint32_t GetSceneIndexId() const { return sceneIndexId; }
+	void SetSceneIndexId(uint32_t id) { sceneIndexId = id; }
 
 public:
-	virtual void SetWorldLocation(const TVector3& Location)
-	{
-		worldTransform.Location = Location;
-	}
+	// The actor owns its components, attaching does not transfer ownership. The relative transform is kept.
+	void AttachTo(Component* newParent);
+	void Detach();
 
-	TVector3 GetWorldLocation() const
-	{
-		return worldTransform.Location;
-	}
+	Component* GetParent() const { return parent; }
+	const std::vector<Component*>& GetChildren() const { return children; }
 
-	virtual void SetWorldRotation(const TRotator& Rotation)
+	void SetRelativeTransform(const TTransform& Transform)
 	{
-		worldTransform.Rotation = Rotation;
+		relativeTransform = Transform;
+		MarkLocalDirty();
 	}
 
-	TRotator GetWorldRotation() const
-	{
-		return worldTransform.Rotation;
-	}
+	const TTransform& GetRelativeTransform() const { return relativeTransform; }
 
-	void SetWorldTransform(const TTransform& Transform)
+	void SetRelativeLocation(const TVector3& Location)
 	{
-		worldTransform = Transform;
+		relativeTransform.Location = Location;
+		MarkLocalDirty();
 	}
 
-	TTransform GetWorldTransform() const
+	void SetRelativeRotation(const TRotator& Rotation)
 	{
-		return worldTransform;
+		relativeTransform.Rotation = Rotation;
+		MarkLocalDirty();
 	}
 
-	void SetPrevWorldTransform(const TTransform& Transform)
-	{
-		prevWorldTransform = Transform;
-	}
+	// World space accessors, converted through the parent when there is one
+	virtual void SetWorldLocation(const TVector3& Location);
+	TVector3 GetWorldLocation() const;
 
-	TTransform GetPrevWorldTransform() const
-	{
-		return prevWorldTransform;
-	}
+	virtual void SetWorldRotation(const TRotator& Rotation);
+	TRotator GetWorldRotation() const;
+
+	void SetWorldTransform(const TTransform& Transform);
+	TTransform GetWorldTransform() const;
+
+	// Cached after the update pass. A component changed since then composes the matrix on the fly, so the result is
+	// always current, but only the pass writes the cache: reads are safe from any thread while nothing is changed.
+	TMatrix GetWorldMatrix() const;
+	TMatrix GetInvWorldMatrix() const;
+
+	// World matrix of the last frame, for motion vectors
+	const TMatrix& GetPrevWorldMatrix() const { return prevWorldMatrix; }
+	void SavePrevWorldMatrix() { prevWorldMatrix = worldMatrix; }
+
+	bool IsTransformDirty() const { return bTransformDirty; }
+
+	// This component or one below it is dirty
+	bool NeedsTransformUpdate() const { return bNeedsUpdate; }
+
+	// Rebuilds the matrices if they are dirty and clears the flags, returns true if they changed.
+	// The parent must be up to date, the update pass visits parents first.
+	bool UpdateWorldMatrix();
 
 protected:
-	TTransform relativeTransform; //TODO
-	TTransform worldTransform;
-	TTransform prevWorldTransform;
+	// The relative transform changed
+	void MarkLocalDirty();
+
+	// The world matrix is stale, so are the ones below
+	void MarkTransformDirty();
+
+private:
+	void MarkSubtreeDirty();
+
+protected:
+	TTransform relativeTransform;
+
+private:
+	Actor* owner = nullptr;
+
+	uint32_t sceneIndexId = LOOSE_OCTREE_INVALID_ID;
+
+	Component* parent = nullptr;
+	std::vector<Component*> children;
+
+	TMatrix localMatrix = TMatrix::Identity;
+	TMatrix worldMatrix = TMatrix::Identity;
+	TMatrix invWorldMatrix = TMatrix::Identity;
+	TMatrix prevWorldMatrix = TMatrix::Identity;
+
+	bool bLocalMatrixDirty = true;
+	bool bTransformDirty = true;
+	bool bNeedsUpdate = true;
+
+	// prevWorldMatrix starts as the first world matrix, not as the identity
+	bool bWorldMatrixValid = false;
 };
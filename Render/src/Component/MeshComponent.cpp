@@ -5,6 +5,9 @@
 void MeshComponent::SetMeshName(std::string inMeshName)
 {
 	meshName = inMeshName;
+
+	// The bounds changed, the scene index picks them up with the transforms
+	MarkTransformDirty();
 }
 
 std::string MeshComponent::GetMeshName() const
@@ -40,7 +43,7 @@ bool MeshComponent::GetWorldBoundingBox(TBoundingBox& outBox)
 
 	if (GetLocalBoundingBox(localBox))
 	{
-		outBox = localBox.Transform(worldTransform);
+		outBox = localBox.Transform(GetWorldMatrix());
 
 		return true;
 	}
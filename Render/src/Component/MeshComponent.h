@@ -7,6 +7,8 @@
 
 class MeshComponent : public Component
 {
+	DECLARE_CLASS(MeshComponent, Component)
+
 public:
 	void SetMeshName(std::string InMeshName);
 	std::string GetMeshName() const;
@@ -25,6 +27,10 @@ public:
 	// Flags
 	bool bUseSDF = false;
 
+	// Static meshes are drawn into the cached shadow maps, moving one redraws the caches.
+	// Off by default, a mesh that moves every frame would redraw the caches every frame.
+	bool bStatic = false;
+
 private:
 	std::string meshName;
 
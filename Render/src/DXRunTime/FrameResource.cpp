@@ -57,6 +57,12 @@ void FrameResource::Execute(ID3D12CommandQueue* queue, ID3D12Fence* fence, uint6
 	if (!populated)
 		return;
 	lastFenceIndex = ++fenceIndex;  //  lastFenceIndexͬ GPU ״̬
+
+	// The GPU reads this frame's temp pages until lastFenceIndex
+	ubAlloc.Retire(lastFenceIndex);
+	dbAlloc.Retire(lastFenceIndex);
+	rbAlloc.Retire(lastFenceIndex);
+
 	ID3D12CommandList* ppCommandLists[] = { cmdList.Get() };
 	queue->ExecuteCommandLists(array_count(ppCommandLists), ppCommandLists);
 }
@@ -84,11 +90,11 @@ void FrameResource::Sync(ID3D12Fence* fence)
 		i();
 	}
 
-	//  ubAllocdbAllocrbAllocͷŷĻ
+	//  ubAllocdbAllocrbAlloc  GPU ҳ
 	afterSyncEvents.clear();
-	ubAlloc.Clear();
-	dbAlloc.Clear();
-	rbAlloc.Clear();
+	ubAlloc.Recycle(lastFenceIndex);
+	dbAlloc.Recycle(lastFenceIndex);
+	rbAlloc.Recycle(lastFenceIndex);
 }
 
 CommandListHandle FrameResource::Command() 
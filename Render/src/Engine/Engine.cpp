@@ -5,6 +5,7 @@
 #include "../Material/MaterialRepository.h"
 #include "../Mesh/MeshRepository.h"
 #include "../World/World.h"
+#include "../Utility/JobSystem.h"
 #include "../../resource.h"
 
 LRESULT CALLBACK
@@ -52,6 +53,9 @@ bool Engine::Initialize(World* inWorld, const TRenderSettings& renderSettings)
 	d3d12RHI = std::make_unique<D3D12RHI>();
 	d3d12RHI->Initialize(mainWindowHandle, windowWidth, windowHeight);
 
+	// Texture decodes and model imports run on the workers, Render waits for them before uploading
+	JobSystem::Get().Initialize();
+
 	TextureRepository::Get().Load();
 	MaterialRepository::Get().Load();
 	MeshRepository::Get().Load();
@@ -63,6 +67,11 @@ bool Engine::Initialize(World* inWorld, const TRenderSettings& renderSettings)
 	if (!render->Initialize(windowWidth, windowHeight, d3d12RHI.get(), world.get(), renderSettings))
 		return false;
 
+	JobSystem::Get().LogTimings();
+	JobSystem::Get().SetRecordTimings(false);
+
+	framePipeline.Initialize(world.get(), render.get());
+
 	bInitialize = true;
 
 	return true;
@@ -92,8 +101,6 @@ int Engine::Run()
 				CalculateFrameStats();
 
 				Update(timer);
-
-				EndFrame(timer);
 			}
 			else
 			{
@@ -115,6 +122,8 @@ bool Engine::Destroy()
 	MaterialRepository::Get().Unload();
 	MeshRepository::Get().Unload();
 
+	JobSystem::Get().Shutdown();
+
 	d3d12RHI.reset();
 
 	return true;
@@ -330,9 +339,15 @@ void Engine::CalculateFrameStats()
 		std::wstring fpsStr = std::to_wstring(fps);
 		std::wstring mspfStr = std::to_wstring(mspf);
 
+		const FrameTimings& frameTimings = framePipeline.GetTimings();
+		std::wstring simulationStr = std::to_wstring(frameTimings.worldUpdateMs + frameTimings.extractMs + frameTimings.worldEndFrameMs);
+		std::wstring renderStr = std::to_wstring(frameTimings.renderMs);
+
 		std::wstring windowText = windowTile +
 			L"    fps: " + fpsStr +
-			L"   mspf: " + mspfStr;
+			L"   mspf: " + mspfStr +
+			L"   simulation: " + simulationStr +
+			L"   render: " + renderStr;
 
 		SetWindowText(mainWindowHandle, windowText.c_str());
 
@@ -344,14 +359,6 @@ void Engine::CalculateFrameStats()
 
 void Engine::Update(const GameTimer& gt)
 {
-	world->Update(timer);
-
-	render->Draw(timer);
-}
-
-void Engine::EndFrame(const GameTimer& gt)
-{
-	world->EndFrame(gt);
-
-	render->EndFrame();
+	// Draws the last frame while the world simulates the next one
+	framePipeline.RunFrame(gt);
 }
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "GameTimer.h"
+#include "FramePipeline.h"
 #include "../World/World.h"
 #include "../Render/Render.h"
 #include "../Resource/D3D12RHI.h"
@@ -34,7 +35,6 @@ private:
 
 protected:
 	void Update(const GameTimer& gt);
-	void EndFrame(const GameTimer& gt);
 
 	void OnMouseDown(WPARAM btnState, int x, int y) { world->OnMouseDown(btnState, x, y); }
 	void OnMouseUp(WPARAM btnState, int x, int y) { world->OnMouseUp(btnState, x, y); }
@@ -63,5 +63,7 @@ protected:
 	std::unique_ptr<D3D12RHI> d3d12RHI;
 	std::unique_ptr<World> world;
 	std::unique_ptr<Render> render;
+
+	FramePipeline framePipeline;
 };
 
@@ -0,0 +1,68 @@
+#include "FramePipeline.h"
+#include <chrono>
+
+void FramePipeline::Initialize(IFrameSimulation* inSimulation, IFrameRenderer* inRenderer)
+{
+	simulation = inSimulation;
+	renderer = inRenderer;
+}
+
+FramePipeline::SimulationJobs FramePipeline::ScheduleSimulation(const GameTimer& gt, RenderSnapshot& snapshot)
+{
+	const uint64_t snapshotFrameIndex = frameIndex++;
+
+	// The timer ticks on the main thread while the jobs run, they get a copy
+	SimulationJobs jobs;
+	jobs.worldUpdate = JobSystem::Get().Schedule("WorldUpdate", [this, gt]()
+		{
+			simulation->Update(gt);
+		});
+
+	jobs.extract = JobSystem::Get().Schedule("ExtractRenderData", [this, &snapshot, snapshotFrameIndex]()
+		{
+			simulation->ExtractRenderData(snapshot, snapshotFrameIndex);
+		}, { jobs.worldUpdate });
+
+	// Saves the previous transforms, the snapshot has copied them already
+	jobs.worldEndFrame = JobSystem::Get().Schedule("WorldEndFrame", [this, gt]()
+		{
+			simulation->EndFrame(gt);
+		}, { jobs.extract });
+
+	return jobs;
+}
+
+void FramePipeline::WaitSimulation(const SimulationJobs& jobs)
+{
+	JobSystem::Get().WaitAll({ jobs.worldUpdate, jobs.extract, jobs.worldEndFrame });
+
+	timings.worldUpdateMs = jobs.worldUpdate->GetDurationMs();
+	timings.extractMs = jobs.extract->GetDurationMs();
+	timings.worldEndFrameMs = jobs.worldEndFrame->GetDurationMs();
+}
+
+void FramePipeline::RunFrame(const GameTimer& gt)
+{
+	using Clock = std::chrono::high_resolution_clock;
+	auto frameStart = Clock::now();
+
+	SimulationJobs jobs = ScheduleSimulation(gt, snapshots[1 - renderIndex]);
+
+	// Nothing to draw on the first frame, its simulation is drawn by the next one
+	auto renderStart = Clock::now();
+	if (bHasSnapshot)
+	{
+		renderer->RenderFrame(snapshots[renderIndex], gt);
+	}
+	auto renderEnd = Clock::now();
+
+	WaitSimulation(jobs);
+	bHasSnapshot = true;
+	auto frameEnd = Clock::now();
+
+	timings.renderMs = std::chrono::duration<double, std::milli>(renderEnd - renderStart).count();
+	timings.waitMs = std::chrono::duration<double, std::milli>(frameEnd - renderEnd).count();
+	timings.frameMs = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+
+	renderIndex = 1 - renderIndex;
+}
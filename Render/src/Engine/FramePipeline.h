@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include "GameTimer.h"
+#include "../Render/RenderSnapshot.h"
+#include "../Utility/JobSystem.h"
+
+// Simulates the frames of a FramePipeline, World in the engine. The three calls of a frame run one after the other
+// on the workers, never two frames at once.
+class IFrameSimulation
+{
+public:
+	virtual ~IFrameSimulation() {}
+
+	virtual void Update(const GameTimer& gt) = 0;
+
+	// Copies what Render needs of the frame just updated
+	virtual void ExtractRenderData(RenderSnapshot& snapshot, uint64_t frameIndex) = 0;
+
+	virtual void EndFrame(const GameTimer& gt) = 0;
+};
+
+// Draws the snapshots of a FramePipeline
+class IFrameRenderer
+{
+public:
+	virtual ~IFrameRenderer() {}
+
+	// Called on the main thread, the snapshot does not change until it returns
+	virtual void RenderFrame(const RenderSnapshot& snapshot, const GameTimer& gt) = 0;
+};
+
+// Draws nothing, runs the pipeline without a device for tests and benchmarks
+class NullFrameRenderer : public IFrameRenderer
+{
+public:
+	virtual void RenderFrame(const RenderSnapshot& snapshot, const GameTimer& gt) override {}
+};
+
+// Milliseconds spent in each job of the last frame
+struct FrameTimings
+{
+	double worldUpdateMs = 0.0;     // Input, actor ticks, transforms
+	double extractMs = 0.0;         // Render snapshot
+	double worldEndFrameMs = 0.0;
+	double renderMs = 0.0;          // Main thread
+	double waitMs = 0.0;            // Main thread waiting for the simulation after rendering
+	double frameMs = 0.0;
+};
+
+// Runs a frame as a job graph:
+//   WorldUpdate -> ExtractRenderData -> WorldEndFrame    on the workers, simulates frame N + 1 into one snapshot
+//   RenderFrame                                          on the main thread, draws the snapshot of frame N
+// Rendering lags the simulation by one frame, the first frame only simulates. RunFrame returns once both are done,
+// so window messages, resizes and anything else touching the world run while no job does.
+class FramePipeline
+{
+public:
+	void Initialize(IFrameSimulation* inSimulation, IFrameRenderer* inRenderer);
+
+	void RunFrame(const GameTimer& gt);
+
+	const FrameTimings& GetTimings() const { return timings; }
+
+private:
+	struct SimulationJobs
+	{
+		JobRef worldUpdate;
+		JobRef extract;
+		JobRef worldEndFrame;
+	};
+
+	SimulationJobs ScheduleSimulation(const GameTimer& gt, RenderSnapshot& snapshot);
+
+	// Rethrows the exception of any of the jobs
+	void WaitSimulation(const SimulationJobs& jobs);
+
+private:
+	IFrameSimulation* simulation = nullptr;
+	IFrameRenderer* renderer = nullptr;
+
+	// The snapshot drawn this frame is snapshots[renderIndex], the simulation writes the other one
+	RenderSnapshot snapshots[2];
+	uint32_t renderIndex = 0;
+	bool bHasSnapshot = false;
+
+	uint64_t frameIndex = 0;
+
+	FrameTimings timings;
+};
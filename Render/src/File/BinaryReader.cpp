@@ -12,12 +12,28 @@
 
 
 #include "BinaryReader.h"
+#include <algorithm>
+#include <new>
 
 // Constructor reads from the filesystem.
-TBinaryReader::TBinaryReader(_In_z_ wchar_t const* fileName) noexcept(false) :
+TBinaryReader::TBinaryReader(_In_z_ wchar_t const* fileName, EBinaryReadMode mode) noexcept(false) :
 	mPos(nullptr),
 	mEnd(nullptr)
 {
+	if (mode == EBinaryReadMode::MemoryMapped)
+	{
+		mMappedFile = TMappedFile::Open(fileName);
+		if (!mMappedFile)
+		{
+			DebugTrace("ERROR: TBinaryReader failed to map '%ls'\n", fileName);
+			throw std::runtime_error("TBinaryReader");
+		}
+
+		mPos = mMappedFile->GetData();
+		mEnd = mMappedFile->GetData() + mMappedFile->GetSize();
+		return;
+	}
+
 	size_t dataSize;
 
 	HRESULT hr = ReadEntireFile(fileName, mOwnedData, &dataSize);
@@ -69,28 +85,36 @@ HRESULT TBinaryReader::ReadEntireFile(
 		return HRESULT_FROM_WIN32(GetLastError());
 	}
 
-	// File is too big for 32-bit allocation, so reject read.
-	if (fileInfo.EndOfFile.HighPart > 0)
+	// File is too big for the address space, so reject read.
+	const uint64_t fileSize = static_cast<uint64_t>(fileInfo.EndOfFile.QuadPart);
+	if (fileSize > SIZE_MAX)
 		return E_FAIL;
 
 	// Create enough space for the file data.
-	data.reset(new uint8_t[fileInfo.EndOfFile.LowPart]);
+	data.reset(new (std::nothrow) uint8_t[static_cast<size_t>(fileSize)]);
 
 	if (!data)
 		return E_OUTOFMEMORY;
 
-	// Read the data in.
-	DWORD bytesRead = 0;
-
-	if (!ReadFile(hFile.get(), data.get(), fileInfo.EndOfFile.LowPart, &bytesRead, nullptr))
+	// Read the data in, ReadFile takes at most 4 GB at a time.
+	size_t totalRead = 0;
+	while (totalRead < fileSize)
 	{
-		return HRESULT_FROM_WIN32(GetLastError());
-	}
+		const DWORD chunkSize = static_cast<DWORD>((std::min)(fileSize - totalRead, static_cast<uint64_t>(0x40000000)));
+		DWORD bytesRead = 0;
 
-	if (bytesRead < fileInfo.EndOfFile.LowPart)
-		return E_FAIL;
+		if (!ReadFile(hFile.get(), data.get() + totalRead, chunkSize, &bytesRead, nullptr))
+		{
+			return HRESULT_FROM_WIN32(GetLastError());
+		}
+
+		if (bytesRead < chunkSize)
+			return E_FAIL;
+
+		totalRead += bytesRead;
+	}
 
-	*dataSize = bytesRead;
+	*dataSize = totalRead;
 
 	return S_OK;
 }
@@ -13,13 +13,20 @@
 #pragma once
 
 #include "PlatformHelpers.h"
+#include "MappedFile.h"
 
 
+enum class EBinaryReadMode
+{
+	Buffered,     // the whole file is read into memory owned by the reader
+	MemoryMapped, // the reader points into a mapping of the file, nothing is copied
+};
+
 // Helper for reading binary data, either from the filesystem a memory buffer.
 class TBinaryReader
 {
 public:
-	explicit TBinaryReader(_In_z_ wchar_t const* fileName) noexcept(false);
+	explicit TBinaryReader(_In_z_ wchar_t const* fileName, EBinaryReadMode mode = EBinaryReadMode::Buffered) noexcept(false);
 	TBinaryReader(_In_reads_bytes_(dataSize) uint8_t const* dataBlob, size_t dataSize) noexcept;
 
 	TBinaryReader(TBinaryReader const&) = delete;
@@ -54,6 +61,14 @@ public:
 	}
 
 
+	// Bytes left to read.
+	size_t GetRemainingSize() const { return static_cast<size_t>(mEnd - mPos); }
+
+
+	// Pointers returned by Read point into the mapping in MemoryMapped mode,
+	// hold on to it to keep them valid after the reader is gone.
+	std::shared_ptr<TMappedFile> const& GetMappedFile() const { return mMappedFile; }
+
 	// Lower level helper reads directly from the filesystem into memory.
 	static HRESULT ReadEntireFile(_In_z_ wchar_t const* fileName, _Inout_ std::unique_ptr<uint8_t[]>& data, _Out_ size_t* dataSize);
 
@@ -64,4 +79,5 @@ private:
 	uint8_t const* mEnd;
 
 	std::unique_ptr<uint8_t[]> mOwnedData;
+	std::shared_ptr<TMappedFile> mMappedFile;
 };
\ No newline at end of file
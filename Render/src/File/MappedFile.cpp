@@ -0,0 +1,77 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include "PlatformHelpers.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <filesystem>
+#endif
+
+std::shared_ptr<TMappedFile> TMappedFile::Open(wchar_t const* fileName)
+{
+	if (!fileName)
+		return nullptr;
+
+	std::shared_ptr<TMappedFile> mappedFile(new TMappedFile());
+
+#ifdef _WIN32
+	ScopedHandle hFile(safe_handle(CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr)));
+	if (!hFile)
+		return nullptr;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile.get(), &fileSize) || fileSize.QuadPart == 0 || static_cast<uint64_t>(fileSize.QuadPart) > SIZE_MAX)
+		return nullptr;
+
+	// The view keeps the file open, both handles can be closed right away
+	ScopedHandle hMapping(CreateFileMappingW(hFile.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+	if (!hMapping)
+		return nullptr;
+
+	mappedFile->mData = static_cast<uint8_t const*>(MapViewOfFile(hMapping.get(), FILE_MAP_READ, 0, 0, 0));
+	if (!mappedFile->mData)
+		return nullptr;
+
+	mappedFile->mSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int fd = open(std::filesystem::path(fileName).c_str(), O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+	{
+		close(fd);
+		return nullptr;
+	}
+
+	// The mapping keeps the file open, the descriptor can be closed right away
+	void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED)
+		return nullptr;
+
+	madvise(view, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+
+	mappedFile->mData = static_cast<uint8_t const*>(view);
+	mappedFile->mSize = static_cast<size_t>(fileStat.st_size);
+#endif
+
+	return mappedFile;
+}
+
+TMappedFile::~TMappedFile()
+{
+	if (!mData)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mData);
+#else
+	munmap(const_cast<uint8_t*>(mData), mSize);
+#endif
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Read only view of a whole file, a Win32 file mapping or a POSIX mmap.
+// Pages are faulted in on first touch and dropped with the last reference,
+// so data pointing into the view must not outlive the shared_ptr.
+class TMappedFile
+{
+public:
+	// Returns nullptr if the file is missing, empty or can not be mapped
+	static std::shared_ptr<TMappedFile> Open(wchar_t const* fileName);
+
+	~TMappedFile();
+
+	TMappedFile(TMappedFile const&) = delete;
+	TMappedFile& operator= (TMappedFile const&) = delete;
+
+	uint8_t const* GetData() const { return mData; }
+	size_t GetSize() const { return mSize; }
+
+private:
+	TMappedFile() = default;
+
+	uint8_t const* mData = nullptr;
+	size_t mSize = 0;
+};
@@ -31,6 +31,7 @@ public:
 			auto gun = AddActor<StaticMeshActor>("Gun");
 			gun->SetMesh("Gun");
 			gun->SetMaterialInstance("GunInst");
+			gun->SetStatic(true);
 			TTransform transform;
 			transform.Location = TVector3(0.0f, 0.0f, 0.0f);
 			transform.Rotation = TRotator(0.0f, 0.0f, 90.0f);
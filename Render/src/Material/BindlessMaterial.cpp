@@ -0,0 +1,25 @@
+#include "BindlessMaterial.h"
+#include <algorithm>
+
+bool BindlessMaterial::ResolveTextureIndices(const std::vector<std::string>& textureSlots,
+	const std::unordered_map<std::string, std::string>& textureMap,
+	const std::function<uint32_t(const std::string& textureName)>& getTextureIndex,
+	uint32_t (&textureIndices)[MATERIAL_BINDLESS_TEXTURE_SLOTS])
+{
+	bool bChanged = false;
+
+	const size_t slotCount = (std::min)(textureSlots.size(), (size_t)MATERIAL_BINDLESS_TEXTURE_SLOTS);
+	for (size_t i = 0; i < slotCount; i++)
+	{
+		auto Iter = textureMap.find(textureSlots[i]);
+		uint32_t index = getTextureIndex(Iter != textureMap.end() ? Iter->second : "");
+
+		if (textureIndices[i] != index)
+		{
+			textureIndices[i] = index;
+			bChanged = true;
+		}
+	}
+
+	return bChanged;
+}
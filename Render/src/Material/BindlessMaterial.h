@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// MaterialData.TextureIndices is a uint4
+#define MATERIAL_BINDLESS_TEXTURE_SLOTS 4
+
+// Bindless side of a material, the texture parameters it reads by index and the indices packed for MaterialData.
+// Knows nothing about the RHI, so the packing can be tested headless.
+class BindlessMaterial
+{
+public:
+	// Writes the index of the texture bound to each of textureSlots, in order, to textureIndices.
+	// A slot without a texture gets getTextureIndex(""), slots past MATERIAL_BINDLESS_TEXTURE_SLOTS are ignored
+	// and the remaining indices keep their value.
+	// Returns true if an index changed, the constant buffer must be created again then.
+	static bool ResolveTextureIndices(const std::vector<std::string>& textureSlots,
+		const std::unordered_map<std::string, std::string>& textureMap,
+		const std::function<uint32_t(const std::string& textureName)>& getTextureIndex,
+		uint32_t (&textureIndices)[MATERIAL_BINDLESS_TEXTURE_SLOTS]);
+};
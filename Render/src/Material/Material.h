@@ -2,9 +2,11 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "../Utils/D3D12Utils.h"
 #include "../Shader/Shader.h"
 #include "../Math/Math.h"
+#include "BindlessMaterial.h"
 
 enum class EShadingMode
 {
@@ -45,6 +47,9 @@ public:
 	MaterialParameters parameters;
 	MaterialRenderState renderState;
 
+	// Texture parameters read through MaterialData.TextureIndices in bindless mode, in this order
+	std::vector<std::string> bindlessTextureSlots;
+
 private:
 	std::string shaderName;
 	std::unordered_map<ShaderDefines, std::unique_ptr<Shader>> shaderMap;
@@ -18,6 +18,11 @@ void MaterialInstance::SetTextureParamter(const std::string& parameter, const st
 	}
 }
 
+bool MaterialInstance::UpdateTextureIndices(const std::function<uint32_t(const std::string& textureName)>& getTextureIndex)
+{
+	return BindlessMaterial::ResolveTextureIndices(material->bindlessTextureSlots, parameters.textureMap, getTextureIndex, textureIndices);
+}
+
 void MaterialInstance::CreateMaterialConstantBuffer(D3D12RHI* D3D12RHI)
 {
 	MaterialConstants MatConst;
@@ -29,6 +34,10 @@ void MaterialInstance::CreateMaterialConstantBuffer(D3D12RHI* D3D12RHI)
 	MatConst.matTransform = parameters.matTransform;
 	MatConst.emissiveColor = parameters.emissiveColor;
 	MatConst.shadingModel = (UINT)material->shadingModel;
+	for (int i = 0; i < MATERIAL_BINDLESS_TEXTURE_SLOTS; i++)
+	{
+		MatConst.textureIndices[i] = textureIndices[i];
+	}
 
 	//Create ConstantBuffer
 	materialConstantBuffer = D3D12RHI->CreateConstantBuffer(&MatConst, sizeof(MatConst));
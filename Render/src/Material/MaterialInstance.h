@@ -2,6 +2,7 @@
 
 #include "Material.h"
 #include "../Resource/Buffer.h"
+#include <functional>
 
 class D3D12RHI;
 
@@ -15,6 +16,10 @@ public:
 
 	void CreateMaterialConstantBuffer(D3D12RHI* d3d12RHI);
 
+	// Resolve every bindless texture slot of the material, getTextureIndex maps a texture name to its BindlessTable index.
+	// Returns true if an index changed, the constant buffer must be created again then.
+	bool UpdateTextureIndices(const std::function<uint32_t(const std::string& textureName)>& getTextureIndex);
+
 public:
 	Material* material = nullptr;
 
@@ -23,4 +28,6 @@ public:
 	MaterialParameters parameters;
 
 	ConstantBufferRef materialConstantBuffer = nullptr;
+
+	uint32_t textureIndices[MATERIAL_BINDLESS_TEXTURE_SLOTS] = { 0 };
 };
\ No newline at end of file
@@ -18,6 +18,7 @@ void MaterialRepository::Load()
 		parameters.textureMap.emplace("NormalTexture", "NullTex");
 		parameters.textureMap.emplace("MetallicTexture", "NullTex");
 		parameters.textureMap.emplace("RoughnessTexture", "NullTex");
+		defaultMat->bindlessTextureSlots = { "BaseColorTexture", "NormalTexture", "MetallicTexture", "RoughnessTexture" };
 
 		// MaterialInstances
 		CreateDefaultMaterialInstance(defaultMat);
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Math.h"
+
+// Six planes of a view frustum, a point p is inside when Dot(normal, p) + distance >= 0 for all of them.
+// Built from a row vector view-projection matrix with a D3D depth range, in the space the matrix transforms from.
+struct TFrustum
+{
+	enum EPlane
+	{
+		Left,
+		Right,
+		Bottom,
+		Top,
+		Near,
+		Far,
+		PlaneCount
+	};
+
+	static TFrustum FromViewProj(const TMatrix& M)
+	{
+		TFrustum frustum;
+		frustum.SetPlane(Left,   M._14 + M._11, M._24 + M._21, M._34 + M._31, M._44 + M._41);
+		frustum.SetPlane(Right,  M._14 - M._11, M._24 - M._21, M._34 - M._31, M._44 - M._41);
+		frustum.SetPlane(Bottom, M._14 + M._12, M._24 + M._22, M._34 + M._32, M._44 + M._42);
+		frustum.SetPlane(Top,    M._14 - M._12, M._24 - M._22, M._34 - M._32, M._44 - M._42);
+		frustum.SetPlane(Near,   M._13, M._23, M._33, M._43);
+		frustum.SetPlane(Far,    M._14 - M._13, M._24 - M._23, M._34 - M._33, M._44 - M._43);
+
+		return frustum;
+	}
+
+	// -1 outside, 0 intersecting, 1 inside. Conservative: a box near a frustum corner can be reported as intersecting.
+	int TestBox(const TVector3& boxMin, const TVector3& boxMax) const
+	{
+		TVector3 center = (boxMin + boxMax) * 0.5f;
+		TVector3 extent = (boxMax - boxMin) * 0.5f;
+
+		int result = 1;
+		for (int i = 0; i < PlaneCount; i++)
+		{
+			const TVector3& n = normals[i];
+			float centerDistance = n.x * center.x + n.y * center.y + n.z * center.z + distances[i];
+			float radius = std::abs(n.x) * extent.x + std::abs(n.y) * extent.y + std::abs(n.z) * extent.z;
+
+			if (centerDistance < -radius)
+			{
+				return -1;
+			}
+
+			if (centerDistance < radius)
+			{
+				result = 0;
+			}
+		}
+
+		return result;
+	}
+
+	bool IntersectsSphere(const TVector3& center, float radius) const
+	{
+		for (int i = 0; i < PlaneCount; i++)
+		{
+			const TVector3& n = normals[i];
+			if (n.x * center.x + n.y * center.y + n.z * center.z + distances[i] < -radius)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+private:
+	void SetPlane(int index, float a, float b, float c, float d)
+	{
+		float length = std::sqrt(a * a + b * b + c * c);
+		normals[index] = TVector3(a / length, b / length, c / length);
+		distances[index] = d / length;
+	}
+
+public:
+	TVector3 normals[PlaneCount];
+	float distances[PlaneCount] = {};
+};
@@ -1,3 +1,47 @@
 #include "Transform.h"
+#include <cfloat>
+#include <cmath>
 
-const TRotator TRotator::Zero = { 0.f, 0.f, 0.f };
\ No newline at end of file
+const TRotator TRotator::Zero = { 0.f, 0.f, 0.f };
+
+TTransform TTransform::FromMatrix(const TMatrix& M)
+{
+	TTransform result;
+	result.Location = M.Translation();
+
+	TVector3 axisX(M._11, M._12, M._13);
+	TVector3 axisY(M._21, M._22, M._23);
+	TVector3 axisZ(M._31, M._32, M._33);
+
+	result.Scale = TVector3(axisX.Length(), axisY.Length(), axisZ.Length());
+
+	// A mirrored basis keeps a negative scale on x
+	if (axisX.Cross(axisY).Dot(axisZ) < 0.0f)
+	{
+		result.Scale.x = -result.Scale.x;
+	}
+
+	if (result.Scale.x != 0.0f) axisX /= result.Scale.x;
+	if (result.Scale.y != 0.0f) axisY /= result.Scale.y;
+	if (result.Scale.z != 0.0f) axisZ /= result.Scale.z;
+
+	// R = Rz(roll) * Rx(pitch) * Ry(yaw), see XMMatrixRotationRollPitchYaw
+	float pitch, yaw, roll;
+	const float cosPitch = std::sqrt(axisZ.z * axisZ.z + axisZ.x * axisZ.x);
+	pitch = std::atan2(-axisZ.y, cosPitch);
+	if (cosPitch > 16.0f * FLT_EPSILON)
+	{
+		yaw = std::atan2(axisZ.x, axisZ.z);
+		roll = std::atan2(axisX.y, axisY.y);
+	}
+	else
+	{
+		// Gimbal lock, yaw and roll turn around the same axis
+		yaw = 0.0f;
+		roll = std::atan2(-axisY.x, axisX.x);
+	}
+
+	result.Rotation = TRotator(roll * 180.0f / TMath::Pi, pitch * 180.0f / TMath::Pi, yaw * 180.0f / TMath::Pi);
+
+	return result;
+}
@@ -29,15 +29,24 @@ public:
 		Scale = TVector3::One;
 	}
 
+	// S * R * T, built without the two matrix products: the rows of R scaled by S, then the translation row
 	TMatrix GetTransformMatrix() const
 	{
-		TMatrix S = TMatrix::CreateScale(Scale);
-		TMatrix R = TMatrix::CreateFromYawPitchRoll(Rotation.Yaw * TMath::Pi / 180.0f, Rotation.Pitch * TMath::Pi / 180.0f, Rotation.Roll * TMath::Pi / 180.0f);
-		TMatrix T = TMatrix::CreateTranslation(Location);
-
-		return S * R * T;
+		using namespace DirectX;
+		XMMATRIX M = XMMatrixRotationRollPitchYaw(Rotation.Pitch * TMath::Pi / 180.0f, Rotation.Yaw * TMath::Pi / 180.0f, Rotation.Roll * TMath::Pi / 180.0f);
+		M.r[0] = XMVectorScale(M.r[0], Scale.x);
+		M.r[1] = XMVectorScale(M.r[1], Scale.y);
+		M.r[2] = XMVectorScale(M.r[2], Scale.z);
+		M.r[3] = XMVectorSetW(XMLoadFloat3(&Location), 1.0f);
+
+		TMatrix result;
+		XMStoreFloat4x4(&result, M);
+		return result;
 	}
 
+	// Inverse of GetTransformMatrix. Shear from non-uniform scale under a rotated parent can not be expressed and is dropped.
+	static TTransform FromMatrix(const TMatrix& M);
+
 public:
 	TVector3 Location;
 	TRotator Rotation;
@@ -30,7 +30,7 @@ void TBoundingBox::Init(std::vector<Vertex> vertices)
 	}
 }
 
-DirectX::BoundingBox TBoundingBox::GetD3DBox()
+DirectX::BoundingBox TBoundingBox::GetD3DBox() const
 {
 	DirectX::BoundingBox d3dBox;
 
@@ -106,6 +106,11 @@ TBoundingBox TBoundingBox::Union(const TBoundingBox& box, const TVector3& point)
 }
 
 TBoundingBox TBoundingBox::Transform(const TTransform& T)
+{
+	return Transform(T.GetTransformMatrix());
+}
+
+TBoundingBox TBoundingBox::Transform(const TMatrix& InM)
 {
 	TBoundingBox box;
 
@@ -114,7 +119,7 @@ TBoundingBox TBoundingBox::Transform(const TTransform& T)
 		box.bInit = true;
 
 		// Transform eight corner points, and calculate new AABB
-		TMatrix M = T.GetTransformMatrix();
+		TMatrix M = InM;
 
 		box = Union(box, M.Transform(TVector3(boxMin.x, boxMin.y, boxMin.z)));
 		box = Union(box, M.Transform(TVector3(boxMax.x, boxMin.y, boxMin.z)));
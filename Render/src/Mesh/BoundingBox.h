@@ -24,11 +24,12 @@ public:
 	static TBoundingBox Union(const TBoundingBox& box, const TVector3& point);
 
 	TBoundingBox Transform(const TTransform& T);
+	TBoundingBox Transform(const TMatrix& M);
 
 	// If the rays origin is inside the box, 0 is returned for Dist0
 	bool Intersect(const Ray& ray, float& dist0, float& dist1);
 
-	DirectX::BoundingBox GetD3DBox();
+	DirectX::BoundingBox GetD3DBox() const;
 
 public:
 	bool bInit = false;
@@ -0,0 +1,83 @@
+#include "DebugDrawBuffer.h"
+
+void DebugDrawBuffer::AddPoint(const TVector3& point, const Color& color, EDebugDepthMode depthMode)
+{
+	PrimitiveVertex* out = Append(EDebugTopology::Point, depthMode, 1);
+	out[0] = PrimitiveVertex(point, color);
+}
+
+void DebugDrawBuffer::AddLine(const TVector3& pointA, const TVector3& pointB, const Color& color, EDebugDepthMode depthMode)
+{
+	PrimitiveVertex* out = Append(EDebugTopology::Line, depthMode, 2);
+	out[0] = PrimitiveVertex(pointA, color);
+	out[1] = PrimitiveVertex(pointB, color);
+}
+
+void DebugDrawBuffer::AddTriangle(const TVector3& pointA, const TVector3& pointB, const TVector3& pointC, const Color& color, EDebugDepthMode depthMode)
+{
+	PrimitiveVertex* out = Append(EDebugTopology::Triangle, depthMode, 3);
+	out[0] = PrimitiveVertex(pointA, color);
+	out[1] = PrimitiveVertex(pointB, color);
+	out[2] = PrimitiveVertex(pointC, color);
+}
+
+void DebugDrawBuffer::AddBox(const TVector3& boxMin, const TVector3& boxMax, const Color& color, EDebugDepthMode depthMode)
+{
+	// Corner i takes max on x for bit 0, y for bit 1 and z for bit 2
+	TVector3 corners[8];
+	for (int i = 0; i < 8; i++)
+	{
+		corners[i] = TVector3((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z);
+	}
+
+	// Edges join corners that differ in one bit
+	static const int edges[12][2] =
+	{
+		{ 0, 4 }, { 2, 6 }, { 1, 5 }, { 3, 7 },
+		{ 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+		{ 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 }
+	};
+
+	PrimitiveVertex* out = Append(EDebugTopology::Line, depthMode, 24);
+	for (int i = 0; i < 12; i++)
+	{
+		out[2 * i] = PrimitiveVertex(corners[edges[i][0]], color);
+		out[2 * i + 1] = PrimitiveVertex(corners[edges[i][1]], color);
+	}
+}
+
+size_t DebugDrawBuffer::GetVertexCount() const
+{
+	size_t count = 0;
+	for (const auto& topologyLists : vertices)
+	{
+		for (const auto& list : topologyLists)
+		{
+			count += list.size();
+		}
+	}
+
+	return count;
+}
+
+void DebugDrawBuffer::Clear()
+{
+	for (auto& topologyLists : vertices)
+	{
+		for (auto& list : topologyLists)
+		{
+			list.clear();
+		}
+	}
+}
+
+void DebugDrawBuffer::Swap(DebugDrawBuffer& other)
+{
+	for (int topology = 0; topology < (int)EDebugTopology::Count; topology++)
+	{
+		for (int depthMode = 0; depthMode < (int)EDebugDepthMode::Count; depthMode++)
+		{
+			vertices[topology][depthMode].swap(other.vertices[topology][depthMode]);
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+enum class EDebugTopology : uint8_t
+{
+	Point,
+	Line,
+	Triangle,
+	Count
+};
+
+enum class EDebugDepthMode : uint8_t
+{
+	DepthTest,
+	AlwaysOnTop,   // No depth test or write
+	Count
+};
+
+// Debug primitives of one frame as flat vertex lists, one per topology and depth mode, so each list is one draw call
+// and is copied to the GPU as is. Lines add two vertices and triangles three. Not thread safe.
+class DebugDrawBuffer
+{
+public:
+	void AddPoint(const TVector3& point, const Color& color, EDebugDepthMode depthMode = EDebugDepthMode::DepthTest);
+
+	void AddLine(const TVector3& pointA, const TVector3& pointB, const Color& color, EDebugDepthMode depthMode = EDebugDepthMode::DepthTest);
+
+	void AddTriangle(const TVector3& pointA, const TVector3& pointB, const TVector3& pointC, const Color& color,
+		EDebugDepthMode depthMode = EDebugDepthMode::DepthTest);
+
+	// The 12 edges as lines
+	void AddBox(const TVector3& boxMin, const TVector3& boxMax, const Color& color, EDebugDepthMode depthMode = EDebugDepthMode::DepthTest);
+
+	const std::vector<PrimitiveVertex>& GetVertices(EDebugTopology topology, EDebugDepthMode depthMode) const
+	{
+		return vertices[(int)topology][(int)depthMode];
+	}
+
+	size_t GetVertexCount() const;
+
+	// Keeps the capacity
+	void Clear();
+
+	void Swap(DebugDrawBuffer& other);
+
+private:
+	// Room for count vertices at the end of a list
+	PrimitiveVertex* Append(EDebugTopology topology, EDebugDepthMode depthMode, size_t count)
+	{
+		std::vector<PrimitiveVertex>& list = vertices[(int)topology][(int)depthMode];
+		size_t offset = list.size();
+		list.resize(offset + count);
+
+		return list.data() + offset;
+	}
+
+private:
+	std::vector<PrimitiveVertex> vertices[(int)EDebugTopology::Count][(int)EDebugDepthMode::Count];
+};
@@ -1,4 +1,5 @@
 #include "Mesh.h"
+#include "MeshOptimizer.h"
 #include "../File/FileHelpers.h"
 #include <fstream>
 
@@ -284,6 +285,8 @@ void Mesh::CreateSphere(float radius, uint32 sliceCount, uint32 stackCount)
 		indices32.push_back(baseIndex + i + 1);
 	}
 
+	MeshOptimizer::Optimize(*this);
+
 	GenerateIndices16();
 }
 
@@ -374,6 +377,8 @@ void Mesh::CreateCylinder(float bottomRadius, float topRadius, float height, uin
 	BuildCylinderTopCap(bottomRadius, topRadius, height, sliceCount, stackCount);
 	BuildCylinderBottomCap(bottomRadius, topRadius, height, sliceCount, stackCount);
 
+	MeshOptimizer::Optimize(*this);
+
 	GenerateIndices16();
 }
 
@@ -510,6 +515,8 @@ void Mesh::CreateGrid(float width, float depth, uint32 m, uint32 n)
 		}
 	}
 
+	MeshOptimizer::Optimize(*this);
+
 	GenerateIndices16();
 }
 
@@ -19,6 +19,15 @@ struct MeshSDFDescriptor
 	int pad3;
 };
 
+// A range of the index buffer that came from one source mesh (e.g. one aiMesh of a model)
+struct MeshSubset
+{
+	uint32_t startIndex = 0;
+	uint32_t indexCount = 0;
+	uint32_t baseVertex = 0;
+	uint32_t vertexCount = 0;
+};
+
 class Mesh
 {
 public:
@@ -53,6 +62,10 @@ public:
 
 	const std::vector<uint16>& GetIndices16() const;
 	std::string GetInputLayoutName() const;
+
+	// Upload as CompactVertex, positions are quantized in boundingBox so it must be generated first
+	void UseCompactVertex() { inputLayoutName = "CompactInputLayout"; }
+	bool IsCompactVertex() const { return inputLayoutName == "CompactInputLayout"; }
 	void GenerateIndices16();
 
 public:
@@ -87,6 +100,7 @@ public:
 	std::vector<Vertex> vertices;
 	std::vector<uint32> indices32;
 	std::vector<uint16> indices16;
+	std::vector<MeshSubset> subsets;
 	std::string inputLayoutName;
 	TBoundingBox boundingBox;
 
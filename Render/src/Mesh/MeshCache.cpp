@@ -0,0 +1,164 @@
+#include "MeshCache.h"
+#include "../File/BinaryReader.h"
+#include "../File/BinarySaver.h"
+#include "../File/FileHelpers.h"
+#include "../Utility/Hash.h"
+#include <filesystem>
+#include <iostream>
+
+namespace
+{
+	size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+std::wstring MeshCache::GetCachePath(const std::wstring& modelName)
+{
+	return L"Resources\\Cache\\Models\\" + modelName + L".tmesh";
+}
+
+bool MeshCache::BuildHeader(const std::wstring& sourcePath, uint32_t importFlags, MeshCacheHeader& outHeader)
+{
+	std::error_code errorCode;
+	auto writeTime = std::filesystem::last_write_time(sourcePath, errorCode);
+	if (errorCode)
+	{
+		return false;
+	}
+
+	outHeader = MeshCacheHeader();
+	outHeader.sourcePathHash = xxh::xxhash_gethash(sourcePath.data(), sourcePath.size() * sizeof(wchar_t));
+	outHeader.sourceWriteTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+	outHeader.importFlagsHash = GetHash(importFlags);
+
+	return true;
+}
+
+bool MeshCache::IsLayoutValid(const MeshCacheHeader& header, uint64_t fileSize)
+{
+	// The counts are 32 bit, so the blob sizes below cannot overflow 64 bits
+	uint64_t subsetEnd = header.subsetOffset + sizeof(MeshSubset) * (uint64_t)header.subsetCount;
+	uint64_t vertexEnd = header.vertexOffset + sizeof(Vertex) * (uint64_t)header.vertexCount;
+	uint64_t indexEnd = header.indexOffset + sizeof(uint32_t) * (uint64_t)header.indexCount;
+
+	return header.fileSize == fileSize
+		&& header.subsetOffset == sizeof(MeshCacheHeader)
+		&& header.vertexOffset >= subsetEnd && header.vertexOffset <= fileSize
+		&& header.indexOffset >= vertexEnd && header.indexOffset <= fileSize
+		&& indexEnd <= fileSize;
+}
+
+bool MeshCache::Load(const std::wstring& sourcePath, const std::wstring& cachePath, uint32_t importFlags, Mesh& outMesh)
+{
+	if (!TFileHelpers::IsFileExit(cachePath))
+	{
+		return false;
+	}
+
+	MeshCacheHeader expected;
+	if (!BuildHeader(sourcePath, importFlags, expected))
+	{
+		return false;
+	}
+
+	try
+	{
+		// The file is mapped, everything below is pointer arithmetic on the view and one copy into the mesh.
+		TBinaryReader reader(cachePath.c_str(), EBinaryReadMode::MemoryMapped);
+
+		const MeshCacheHeader& header = reader.Read<MeshCacheHeader>();
+		uint64_t fileSize = sizeof(MeshCacheHeader) + reader.GetRemainingSize();
+		if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION || header.vertexStride != sizeof(Vertex))
+		{
+			return false;
+		}
+
+		if (header.sourcePathHash != expected.sourcePathHash ||
+			header.sourceWriteTime != expected.sourceWriteTime ||
+			header.importFlagsHash != expected.importFlagsHash)
+		{
+			return false;
+		}
+
+		// Checked before any offset is subtracted, a corrupt header would wrap around
+		if (!IsLayoutValid(header, fileSize))
+		{
+			return false;
+		}
+
+		size_t offset = sizeof(MeshCacheHeader);
+
+		const MeshSubset* subsets = reader.ReadArray<MeshSubset>(header.subsetCount);
+		offset += sizeof(MeshSubset) * header.subsetCount;
+
+		reader.ReadArray<uint8_t>(header.vertexOffset - offset);
+		const Vertex* vertices = reader.ReadArray<Vertex>(header.vertexCount);
+		offset = header.vertexOffset + sizeof(Vertex) * header.vertexCount;
+
+		reader.ReadArray<uint8_t>(header.indexOffset - offset);
+		const uint32_t* indices = reader.ReadArray<uint32_t>(header.indexCount);
+
+		outMesh.subsets.assign(subsets, subsets + header.subsetCount);
+		outMesh.vertices.assign(vertices, vertices + header.vertexCount);
+		outMesh.indices32.assign(indices, indices + header.indexCount);
+
+		outMesh.boundingBox.bInit = header.vertexCount > 0;
+		outMesh.boundingBox.boxMin = TVector3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+		outMesh.boundingBox.boxMax = TVector3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "MeshCache: failed to read cache, " << e.what() << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshCache::Save(const std::wstring& sourcePath, const std::wstring& cachePath, uint32_t importFlags, const Mesh& mesh)
+{
+	MeshCacheHeader header;
+	if (!BuildHeader(sourcePath, importFlags, header))
+	{
+		return false;
+	}
+
+	header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+	header.indexCount = static_cast<uint32_t>(mesh.indices32.size());
+	header.subsetCount = static_cast<uint32_t>(mesh.subsets.size());
+
+	const TBoundingBox& bounds = mesh.boundingBox;
+	header.boundsMin[0] = bounds.boxMin.x; header.boundsMin[1] = bounds.boxMin.y; header.boundsMin[2] = bounds.boxMin.z;
+	header.boundsMax[0] = bounds.boxMax.x; header.boundsMax[1] = bounds.boxMax.y; header.boundsMax[2] = bounds.boxMax.z;
+
+	header.subsetOffset = sizeof(MeshCacheHeader);
+	header.vertexOffset = AlignUp(header.subsetOffset + sizeof(MeshSubset) * header.subsetCount, MESH_CACHE_ALIGNMENT);
+	header.indexOffset = AlignUp(header.vertexOffset + sizeof(Vertex) * header.vertexCount, MESH_CACHE_ALIGNMENT);
+	header.fileSize = header.indexOffset + sizeof(uint32_t) * header.indexCount;
+
+	// Assemble the file in memory, then write it with a single call
+	std::vector<uint8_t> fileData(header.fileSize, 0);
+	memcpy(fileData.data(), &header, sizeof(header));
+	if (header.subsetCount > 0)
+	{
+		memcpy(fileData.data() + header.subsetOffset, mesh.subsets.data(), sizeof(MeshSubset) * header.subsetCount);
+	}
+	if (header.vertexCount > 0)
+	{
+		memcpy(fileData.data() + header.vertexOffset, mesh.vertices.data(), sizeof(Vertex) * header.vertexCount);
+	}
+	if (header.indexCount > 0)
+	{
+		memcpy(fileData.data() + header.indexOffset, mesh.indices32.data(), sizeof(uint32_t) * header.indexCount);
+	}
+
+	// TBinarySaver appends, so remove the stale file first
+	std::error_code errorCode;
+	std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), errorCode);
+	std::filesystem::remove(cachePath, errorCode);
+
+	TBinarySaver saver(cachePath);
+	return saver.SaveArray(fileData.data(), fileData.size());
+}
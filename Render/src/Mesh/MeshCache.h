@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "Mesh.h"
+
+// Binary mesh cache, written after the first Assimp import so that later launches can skip it.
+//
+// File layout (all blobs start at a MESH_CACHE_ALIGNMENT boundary):
+//   MeshCacheHeader
+//   MeshSubset[subsetCount]
+//   Vertex[vertexCount]
+//   uint32_t[indexCount]
+#define MESH_CACHE_MAGIC 0x48534D54 // "TMSH"
+#define MESH_CACHE_VERSION 2
+#define MESH_CACHE_ALIGNMENT 16
+
+struct MeshCacheHeader
+{
+	uint32_t magic = MESH_CACHE_MAGIC;
+	uint32_t version = MESH_CACHE_VERSION;
+
+	// Cache key, the cache is stale if any of them changes
+	uint64_t sourcePathHash = 0;
+	int64_t sourceWriteTime = 0;
+	uint64_t importFlagsHash = 0;
+
+	uint32_t vertexStride = sizeof(Vertex);
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	uint32_t subsetCount = 0;
+
+	float boundsMin[3] = { 0.0f, 0.0f, 0.0f };
+	float boundsMax[3] = { 0.0f, 0.0f, 0.0f };
+	uint32_t pad0 = 0;
+	uint32_t pad1 = 0;
+
+	uint64_t subsetOffset = 0;
+	uint64_t vertexOffset = 0;
+	uint64_t indexOffset = 0;
+	uint64_t fileSize = 0;
+};
+static_assert(sizeof(MeshCacheHeader) % MESH_CACHE_ALIGNMENT == 0, "header must keep the blobs aligned");
+
+class MeshCache
+{
+public:
+	// Cache file for a model in Resources\Models, e.g. "gun.fbx" -> Resources\Cache\Models\gun.fbx.tmesh
+	static std::wstring GetCachePath(const std::wstring& modelName);
+
+	// Returns false if the cache is missing, corrupted or out of date.
+	static bool Load(const std::wstring& sourcePath, const std::wstring& cachePath, uint32_t importFlags, Mesh& outMesh);
+
+	static bool Save(const std::wstring& sourcePath, const std::wstring& cachePath, uint32_t importFlags, const Mesh& mesh);
+
+private:
+	static bool BuildHeader(const std::wstring& sourcePath, uint32_t importFlags, MeshCacheHeader& outHeader);
+
+	// The blobs must follow each other in order and end within the file
+	static bool IsLayoutValid(const MeshCacheHeader& header, uint64_t fileSize);
+};
@@ -1,4 +1,6 @@
 #include "MeshLoader.h"
+#include "MeshOptimizer.h"
+#include "../Utils/Logger.h"
 #include <iostream>
 
 void MeshLoader::Init()
@@ -13,13 +15,16 @@ bool MeshLoader::LoadModel(const std::wstring& modelName, Mesh& mesh)
 	std::wstring modelPath = modelDir + modelName;
 	std::string modelPath_UTF8(modelPath.begin(), modelPath.end());
 
+	// Try binary cache first, it skips Assimp entirely
+	std::wstring cachePath = MeshCache::GetCachePath(modelName);
+	if (m_bUseMeshCache && MeshCache::Load(modelPath, cachePath, ImportFlags, mesh))
+	{
+		mesh.GenerateIndices16();
+		return true;
+	}
+
 	// load models
-	const aiScene* scene = m_importer.ReadFile(
-		modelPath_UTF8,
-		aiProcess_Triangulate |
-		aiProcess_GenNormals |
-		aiProcess_CalcTangentSpace |
-		aiProcess_FlipUVs);
+	const aiScene* scene = m_importer.ReadFile(modelPath_UTF8, ImportFlags);
 
 	if (!scene || !scene->mRootNode || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE)
 	{
@@ -39,7 +44,32 @@ bool MeshLoader::LoadModel(const std::wstring& modelName, Mesh& mesh)
 	assert(mesh.vertices.size() > 0 && "model vertex is 0");
 	assert(mesh.indices32.size() > 0 && "model index is 0");
 
+#ifdef _DEBUG
+	std::vector<Vertex> importedVertices = mesh.vertices;
+	std::vector<uint32_t> importedIndices = mesh.indices32;
+#endif
+
+	// Reorder for the vertex cache and overdraw, the cache below stores the optimized mesh
+	MeshOptimizeStats optimizeStats;
+	MeshOptimizer::Optimize(mesh, &optimizeStats);
+
+#ifdef _DEBUG
+	assert(MeshOptimizer::IsGeometryEqual(importedVertices, importedIndices, mesh.vertices, mesh.indices32) && "mesh optimizer changed the geometry");
+#endif
+
+	char statsText[256];
+	sprintf_s(statsText, "MeshOptimizer: %s removed %u vertices, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+		modelPath_UTF8.c_str(), optimizeStats.removedVertexCount,
+		optimizeStats.before.ACMR, optimizeStats.after.ACMR, optimizeStats.before.ATVR, optimizeStats.after.ATVR);
+	TLogger::LogToOutput(statsText);
+
 	mesh.GenerateIndices16();
+	mesh.GenerateBoundingBox();
+
+	if (m_bUseMeshCache && !MeshCache::Save(modelPath, cachePath, ImportFlags, mesh))
+	{
+		std::cerr << "MeshCache: failed to write " << std::string(cachePath.begin(), cachePath.end()) << std::endl;
+	}
 
 	// Debug print nodes
 	if (m_bDebugMode)
@@ -82,6 +112,11 @@ bool MeshLoader::ProcessMesh(const aiMesh* assimpMesh, Mesh& mesh, const aiMatri
 	}
 
 	const uint32_t BaseVertex = static_cast<uint32_t>(mesh.vertices.size());
+	const uint32_t StartIndex = static_cast<uint32_t>(mesh.indices32.size());
+
+	mesh.vertices.reserve(mesh.vertices.size() + assimpMesh->mNumVertices);
+	mesh.indices32.reserve(mesh.indices32.size() + assimpMesh->mNumFaces * 3);
+
 	for (unsigned int v = 0; v < assimpMesh->mNumVertices; v++) {
 		Vertex vertex;
 
@@ -118,6 +153,13 @@ bool MeshLoader::ProcessMesh(const aiMesh* assimpMesh, Mesh& mesh, const aiMatri
 		}
 	}
 
+	MeshSubset subset;
+	subset.startIndex = StartIndex;
+	subset.indexCount = static_cast<uint32_t>(mesh.indices32.size()) - StartIndex;
+	subset.baseVertex = BaseVertex;
+	subset.vertexCount = assimpMesh->mNumVertices;
+	mesh.subsets.push_back(subset);
+
 	return true;
 }
 
@@ -6,6 +6,7 @@
 #include <memory>
 #include <string>
 #include "Mesh.h"
+#include "MeshCache.h"
 
 class MeshLoader
 {
@@ -13,6 +14,15 @@ public:
 	void Init();
 	bool LoadModel(const std::wstring& modelName, Mesh& mesh);
 
+	void SetUseMeshCache(bool bUse) { m_bUseMeshCache = bUse; }
+
+public:
+	static const unsigned int ImportFlags =
+		aiProcess_Triangulate |
+		aiProcess_GenNormals |
+		aiProcess_CalcTangentSpace |
+		aiProcess_FlipUVs;
+
 private:
 	bool ProcessMesh(const aiMesh* assimpMesh, Mesh& mesh, const aiMatrix4x4& vertexTransform, const aiMatrix4x4& normalTransform);
 	void ProcessNode(const aiNode* node, Mesh& mesh, const aiMatrix4x4& parentVertexTransform, const aiMatrix4x4& parentNormalTransform);
@@ -24,4 +34,5 @@ private:
 private:
 	Assimp::Importer m_importer;
 	bool m_bDebugMode = false;
+	bool m_bUseMeshCache = true;
 };
\ No newline at end of file
@@ -0,0 +1,517 @@
+#include "MeshOptimizer.h"
+#include "../Utility/Hash.h"
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+	const uint32_t ForsythCacheSize = 32;
+
+	float ForsythVertexScore(int cachePosition, uint32_t remainingTriangles)
+	{
+		// No triangle left to use it
+		if (remainingTriangles == 0)
+		{
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// The last triangle's vertices get a fixed score so the next triangle does not reuse them all
+			if (cachePosition < 3)
+			{
+				score = 0.75f;
+			}
+			else
+			{
+				float scaler = 1.0f - (float)(cachePosition - 3) / (ForsythCacheSize - 3);
+				score = std::pow(scaler, 1.5f);
+			}
+		}
+
+		// Prefer vertices with few triangles left, so they get out of the way
+		score += 2.0f / std::sqrt((float)remainingTriangles);
+
+		return score;
+	}
+
+	struct VertexHasher
+	{
+		size_t operator()(const Vertex& v) const
+		{
+			return xxh::xxhash_gethash(&v, sizeof(Vertex));
+		}
+	};
+
+	struct VertexEqual
+	{
+		bool operator()(const Vertex& a, const Vertex& b) const
+		{
+			return memcmp(&a, &b, sizeof(Vertex)) == 0;
+		}
+	};
+}
+
+void MeshOptimizer::Optimize(Mesh& mesh, MeshOptimizeStats* outStats)
+{
+	if (mesh.indices32.empty())
+	{
+		return;
+	}
+
+	MeshOptimizeStats stats;
+	stats.before = AnalyzeVertexCache(mesh.indices32, (uint32_t)mesh.vertices.size());
+
+	// A mesh without subsets is one subset, its indices only reference its own vertex range
+	std::vector<MeshSubset> subsets = mesh.subsets;
+	if (subsets.empty())
+	{
+		MeshSubset subset;
+		subset.indexCount = (uint32_t)mesh.indices32.size();
+		subset.vertexCount = (uint32_t)mesh.vertices.size();
+		subsets.push_back(subset);
+	}
+
+	std::vector<Vertex> newVertices;
+	std::vector<uint32_t> newIndices;
+	newVertices.reserve(mesh.vertices.size());
+	newIndices.reserve(mesh.indices32.size());
+
+	for (MeshSubset& subset : subsets)
+	{
+		std::vector<Vertex> vertices(mesh.vertices.begin() + subset.baseVertex,
+			mesh.vertices.begin() + subset.baseVertex + subset.vertexCount);
+
+		std::vector<uint32_t> indices(subset.indexCount);
+		for (uint32_t i = 0; i < subset.indexCount; i++)
+		{
+			indices[i] = mesh.indices32[subset.startIndex + i] - subset.baseVertex;
+		}
+
+		stats.removedVertexCount += RemoveDuplicateVertices(vertices, indices);
+		OptimizeVertexCache(indices, (uint32_t)vertices.size());
+		OptimizeOverdraw(indices, vertices);
+		OptimizeVertexFetch(vertices, indices);
+
+		subset.startIndex = (uint32_t)newIndices.size();
+		subset.baseVertex = (uint32_t)newVertices.size();
+		subset.vertexCount = (uint32_t)vertices.size();
+
+		for (uint32_t index : indices)
+		{
+			newIndices.push_back(index + subset.baseVertex);
+		}
+		newVertices.insert(newVertices.end(), vertices.begin(), vertices.end());
+	}
+
+	mesh.vertices.swap(newVertices);
+	mesh.indices32.swap(newIndices);
+	if (!mesh.subsets.empty())
+	{
+		mesh.subsets = subsets;
+	}
+
+	stats.after = AnalyzeVertexCache(mesh.indices32, (uint32_t)mesh.vertices.size());
+
+	if (outStats)
+	{
+		*outStats = stats;
+	}
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStats stats;
+	if (indices.empty() || vertexCount == 0)
+	{
+		return stats;
+	}
+
+	// A vertex is in the FIFO if it was inserted less than cacheSize misses ago
+	std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+	std::vector<bool> bReferenced(vertexCount, false);
+	uint32_t timestamp = cacheSize + 1;
+	uint32_t misses = 0;
+	uint32_t uniqueVertexCount = 0;
+
+	for (uint32_t index : indices)
+	{
+		if (timestamp - cacheTimestamps[index] > cacheSize)
+		{
+			cacheTimestamps[index] = timestamp++;
+			misses++;
+		}
+
+		if (!bReferenced[index])
+		{
+			bReferenced[index] = true;
+			uniqueVertexCount++;
+		}
+	}
+
+	stats.ACMR = (float)misses / (float)(indices.size() / 3);
+	stats.ATVR = (float)misses / (float)uniqueVertexCount;
+
+	return stats;
+}
+
+bool MeshOptimizer::IsGeometryEqual(const std::vector<Vertex>& verticesA, const std::vector<uint32_t>& indicesA,
+	const std::vector<Vertex>& verticesB, const std::vector<uint32_t>& indicesB)
+{
+	typedef std::array<Vertex, 3> Triangle;
+
+	auto BuildTriangles = [](const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+		{
+			std::vector<Triangle> triangles(indices.size() / 3);
+			for (size_t t = 0; t < triangles.size(); t++)
+			{
+				Triangle& triangle = triangles[t];
+				for (size_t k = 0; k < 3; k++)
+				{
+					triangle[k] = vertices[indices[t * 3 + k]];
+				}
+
+				// Rotate the smallest vertex first, keeps the winding
+				size_t first = 0;
+				for (size_t k = 1; k < 3; k++)
+				{
+					if (memcmp(&triangle[k], &triangle[first], sizeof(Vertex)) < 0)
+					{
+						first = k;
+					}
+				}
+				std::rotate(triangle.begin(), triangle.begin() + first, triangle.end());
+			}
+
+			std::sort(triangles.begin(), triangles.end(), [](const Triangle& x, const Triangle& y)
+				{
+					return memcmp(x.data(), y.data(), sizeof(Triangle)) < 0;
+				});
+
+			return triangles;
+		};
+
+	std::vector<Triangle> trianglesA = BuildTriangles(verticesA, indicesA);
+	std::vector<Triangle> trianglesB = BuildTriangles(verticesB, indicesB);
+
+	return trianglesA.size() == trianglesB.size() &&
+		(trianglesA.empty() || memcmp(trianglesA.data(), trianglesB.data(), sizeof(Triangle) * trianglesA.size()) == 0);
+}
+
+uint32_t MeshOptimizer::RemoveDuplicateVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::unordered_map<Vertex, uint32_t, VertexHasher, VertexEqual> uniqueVertices;
+	uniqueVertices.reserve(vertices.size());
+
+	std::vector<uint32_t> remap(vertices.size());
+	std::vector<Vertex> newVertices;
+	newVertices.reserve(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		auto result = uniqueVertices.emplace(vertices[i], (uint32_t)newVertices.size());
+		if (result.second)
+		{
+			newVertices.push_back(vertices[i]);
+		}
+
+		remap[i] = result.first->second;
+	}
+
+	for (uint32_t& index : indices)
+	{
+		index = remap[index];
+	}
+
+	uint32_t removedCount = (uint32_t)(vertices.size() - newVertices.size());
+	vertices.swap(newVertices);
+
+	return removedCount;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+	const uint32_t triangleCount = (uint32_t)indices.size() / 3;
+	if (triangleCount < 2)
+	{
+		return;
+	}
+
+	// Triangles using each vertex, the first remainingTriangles[v] of them are not emitted yet
+	std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+	for (uint32_t index : indices)
+	{
+		remainingTriangles[index]++;
+	}
+
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingTriangles[v];
+	}
+
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t v = indices[t * 3 + k];
+				adjacency[fillOffsets[v]++] = t;
+			}
+		}
+	}
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = ForsythVertexScore(-1, remainingTriangles[v]);
+	}
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> bEmitted(triangleCount, false);
+	uint32_t bestTriangle = 0;
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		if (triangleScores[t] > triangleScores[bestTriangle])
+		{
+			bestTriangle = t;
+		}
+	}
+
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> newCache;
+	cache.reserve(ForsythCacheSize + 3);
+	newCache.reserve(ForsythCacheSize + 3);
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	uint32_t searchCursor = 0;
+
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		if (bestTriangle == UINT32_MAX)
+		{
+			// Nothing in the cache is usable any more, restart from the next triangle in the input order
+			while (bEmitted[searchCursor])
+			{
+				searchCursor++;
+			}
+			bestTriangle = searchCursor;
+		}
+
+		bEmitted[bestTriangle] = true;
+		const uint32_t triangle[3] = { indices[bestTriangle * 3], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2] };
+
+		newCache.clear();
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			uint32_t v = triangle[k];
+			result.push_back(v);
+
+			// Move the emitted triangle to the end of the vertex's live range
+			uint32_t* begin = adjacency.data() + adjacencyOffsets[v];
+			uint32_t* end = begin + remainingTriangles[v];
+			uint32_t* found = std::find(begin, end, bestTriangle);
+			std::swap(*found, *(end - 1));
+			remainingTriangles[v]--;
+
+			if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+			{
+				newCache.push_back(v);
+			}
+		}
+
+		for (uint32_t v : cache)
+		{
+			if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+			{
+				newCache.push_back(v);
+			}
+		}
+
+		// Update scores of every vertex whose cache position changed, including the ones pushed out
+		for (uint32_t position = 0; position < (uint32_t)newCache.size(); position++)
+		{
+			uint32_t v = newCache[position];
+			cachePositions[v] = position < ForsythCacheSize ? (int)position : -1;
+
+			float newScore = ForsythVertexScore(cachePositions[v], remainingTriangles[v]);
+			float delta = newScore - vertexScores[v];
+			vertexScores[v] = newScore;
+
+			for (uint32_t a = 0; a < remainingTriangles[v]; a++)
+			{
+				triangleScores[adjacency[adjacencyOffsets[v] + a]] += delta;
+			}
+		}
+
+		if (newCache.size() > ForsythCacheSize)
+		{
+			newCache.resize(ForsythCacheSize);
+		}
+		cache.swap(newCache);
+
+		// Next triangle is the best one touching the cache
+		bestTriangle = UINT32_MAX;
+		float bestScore = -FLT_MAX;
+		for (uint32_t v : cache)
+		{
+			for (uint32_t a = 0; a < remainingTriangles[v]; a++)
+			{
+				uint32_t t = adjacency[adjacencyOffsets[v] + a];
+				if (triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					bestTriangle = t;
+				}
+			}
+		}
+	}
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold)
+{
+	const uint32_t triangleCount = (uint32_t)indices.size() / 3;
+	const uint32_t vertexCount = (uint32_t)vertices.size();
+	if (triangleCount < 2)
+	{
+		return;
+	}
+
+	const uint32_t cacheSize = 16;
+	VertexCacheStats originalStats = AnalyzeVertexCache(indices, vertexCount, cacheSize);
+
+	// Split at hard boundaries, triangles where the cache starts over (all three vertices miss)
+	std::vector<uint32_t> clusterStarts;
+	{
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = cacheSize + 1;
+
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			uint32_t misses = 0;
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t v = indices[t * 3 + k];
+				if (timestamp - cacheTimestamps[v] > cacheSize)
+				{
+					cacheTimestamps[v] = timestamp++;
+					misses++;
+				}
+			}
+
+			if (t == 0 || misses == 3)
+			{
+				clusterStarts.push_back(t);
+			}
+		}
+	}
+
+	const uint32_t clusterCount = (uint32_t)clusterStarts.size();
+	if (clusterCount < 2)
+	{
+		return;
+	}
+	clusterStarts.push_back(triangleCount);
+
+	// Clusters facing away from the mesh center go first, they are likely to occlude the rest
+	TVector3 meshCentroid = TVector3::Zero;
+	float meshArea = 0.0f;
+
+	std::vector<TVector3> clusterCentroids(clusterCount, TVector3::Zero);
+	std::vector<TVector3> clusterNormals(clusterCount, TVector3::Zero);
+
+	for (uint32_t c = 0; c < clusterCount; c++)
+	{
+		float clusterArea = 0.0f;
+
+		for (uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+		{
+			const TVector3& p0 = vertices[indices[t * 3]].position;
+			const TVector3& p1 = vertices[indices[t * 3 + 1]].position;
+			const TVector3& p2 = vertices[indices[t * 3 + 2]].position;
+
+			TVector3 normal = (p1 - p0).Cross(p2 - p0);
+			float area = normal.Length();
+			TVector3 centroid = (p0 + p1 + p2) / 3.0f;
+
+			clusterCentroids[c] += centroid * area;
+			clusterNormals[c] += normal;
+			clusterArea += area;
+		}
+
+		meshCentroid += clusterCentroids[c];
+		meshArea += clusterArea;
+
+		if (clusterArea > 0.0f)
+		{
+			clusterCentroids[c] /= clusterArea;
+		}
+		clusterNormals[c].Normalize();
+	}
+
+	if (meshArea > 0.0f)
+	{
+		meshCentroid /= meshArea;
+	}
+
+	std::vector<float> sortKeys(clusterCount);
+	std::vector<uint32_t> clusterOrder(clusterCount);
+	for (uint32_t c = 0; c < clusterCount; c++)
+	{
+		sortKeys[c] = (clusterCentroids[c] - meshCentroid).Dot(clusterNormals[c]);
+		clusterOrder[c] = c;
+	}
+
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32_t a, uint32_t b)
+		{
+			return sortKeys[a] > sortKeys[b];
+		});
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (uint32_t c : clusterOrder)
+	{
+		result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+	}
+
+	// Keep the cache friendly order if the new one costs too much
+	VertexCacheStats newStats = AnalyzeVertexCache(result, vertexCount, cacheSize);
+	if (newStats.ACMR <= originalStats.ACMR * threshold)
+	{
+		indices.swap(result);
+	}
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	// Store vertices in the order they are first used, unused vertices are dropped
+	std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+	std::vector<Vertex> newVertices;
+	newVertices.reserve(vertices.size());
+
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == UINT32_MAX)
+		{
+			remap[index] = (uint32_t)newVertices.size();
+			newVertices.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices.swap(newVertices);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Mesh.h"
+
+struct VertexCacheStats
+{
+	float ACMR = 0.0f; // average cache miss ratio, transformed vertices per triangle
+	float ATVR = 0.0f; // average transformed vertex ratio, transformed vertices per unique vertex
+};
+
+struct MeshOptimizeStats
+{
+	uint32_t removedVertexCount = 0;
+	VertexCacheStats before;
+	VertexCacheStats after;
+};
+
+// Post-import mesh optimization, run per subset:
+//   1. Remove duplicated vertices
+//   2. Vertex cache reordering (Forsyth, "Linear-Speed Vertex Cache Optimisation")
+//   3. Overdraw aware cluster ordering (Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+//   4. Vertex fetch reordering, vertices are stored in first use order
+// Triangles keep their winding and the rendered geometry is unchanged.
+class MeshOptimizer
+{
+public:
+	static void Optimize(Mesh& mesh, MeshOptimizeStats* outStats = nullptr);
+
+	// Simulates a FIFO post transform cache
+	static VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+	// Checks that both index buffers draw the same set of triangles, used to validate the optimizer.
+	static bool IsGeometryEqual(const std::vector<Vertex>& verticesA, const std::vector<uint32_t>& indicesA,
+		const std::vector<Vertex>& verticesB, const std::vector<uint32_t>& indicesB);
+
+	static uint32_t RemoveDuplicateVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	static void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+	// threshold: how much ACMR may grow for the sake of overdraw, 1.05 allows 5%
+	static void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f);
+
+	static void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+};
@@ -2,8 +2,6 @@
 
 MeshRepository::MeshRepository()
 {
-	meshLoader = std::make_unique<MeshLoader>();
-	meshLoader->Init();
 }
 
 MeshRepository& MeshRepository::Get()
@@ -14,15 +12,13 @@ MeshRepository& MeshRepository::Get()
 
 void MeshRepository::Load()
 {
+	std::vector<JobRef> modelJobs;
+
 	Mesh gunMesh;
-	gunMesh.meshName = "Gun";
-	meshLoader->LoadModel(L"gun.fbx", gunMesh);
-	meshMap.emplace("Gun", std::move(gunMesh));
+	modelJobs.push_back(ScheduleModelLoad("Gun", L"gun.fbx", gunMesh));
 
 // 	Mesh personMesh;
-// 	personMesh.meshName = "test";
-// 	meshLoader->LoadModel(L"test.fbx", personMesh);
-// 	meshMap.emplace("test", std::move(personMesh));
+// 	modelJobs.push_back(ScheduleModelLoad("test", L"test.fbx", personMesh));
 
 	Mesh boxMesh;
 	boxMesh.CreateBox(1.0f, 1.0f, 1.0f, 3);
@@ -42,6 +38,24 @@ void MeshRepository::Load()
 	sphereMesh.GenerateBoundingBox();
 	meshMap.emplace("SphereMesh", std::move(sphereMesh));
 
+	// The procedural meshes above were built while the models were importing
+	JobSystem::Get().WaitAll(modelJobs);
+
+	gunMesh.UseCompactVertex();
+	meshMap.emplace("Gun", std::move(gunMesh));
+// 	meshMap.emplace("test", std::move(personMesh));
+}
+
+JobRef MeshRepository::ScheduleModelLoad(const std::string& meshName, const std::wstring& modelName, Mesh& outMesh)
+{
+	outMesh.meshName = meshName;
+
+	return JobSystem::Get().Schedule("Import " + meshName, [modelName, &outMesh]()
+		{
+			MeshLoader meshLoader;
+			meshLoader.Init();
+			meshLoader.LoadModel(modelName, outMesh);
+		});
 }
 
 void MeshRepository::Unload()
@@ -4,6 +4,7 @@
 #include <string>
 #include "Mesh.h"
 #include "MeshLoader.h"
+#include "../Utility/JobSystem.h"
 
 class MeshRepository
 {
@@ -17,5 +18,6 @@ public:
 	std::unordered_map<std::string, Mesh> meshMap;
 
 private:
-	std::unique_ptr<MeshLoader> meshLoader;
+	// Imports a model on the job system, Assimp::Importer is not thread safe so each job gets its own loader
+	JobRef ScheduleModelLoad(const std::string& meshName, const std::wstring& modelName, Mesh& outMesh);
 };
\ No newline at end of file
@@ -0,0 +1,297 @@
+#include "MeshSDFBaker.h"
+#include "../Utility/JobSystem.h"
+#include <algorithm>
+#include <assert.h>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	double MillisecondsSince(std::chrono::high_resolution_clock::time_point startTime)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+	}
+
+	TVector3 GetVoxelCenter(const MeshSDFDescriptor& descriptor, float voxelSize, uint32_t x, uint32_t y, uint32_t z)
+	{
+		return TVector3(
+			descriptor.center.x - descriptor.extent + (x + 0.5f) * voxelSize,
+			descriptor.center.y - descriptor.extent + (y + 0.5f) * voxelSize,
+			descriptor.center.z - descriptor.extent + (z + 0.5f) * voxelSize);
+	}
+
+	float Lerp(float a, float b, float t)
+	{
+		return a + (b - a) * t;
+	}
+
+	// Pulls indices from a shared counter so lanes that drew cheap bricks take more of them.
+	// ParallelFor alone hands out equal ranges, but near-surface bricks cost far more than empty space.
+	void ParallelForBalanced(const std::string& name, uint32_t count, const std::function<void(uint32_t)>& func)
+	{
+		std::atomic<uint32_t> nextIndex = 0;
+		const uint32_t laneCount = JobSystem::Get().GetWorkerCount() + 1;
+
+		JobSystem::Get().ParallelFor(name, laneCount, 1, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t lane = begin; lane < end; lane++)
+			{
+				for (uint32_t index = nextIndex++; index < count; index = nextIndex++)
+				{
+					func(index);
+				}
+			}
+		});
+	}
+}
+
+void MeshSDFBaker::Bake(const std::vector<TVector3>& positions, const std::vector<uint32_t>& indices, const MeshSDFBakeSettings& settings,
+	MeshSDFDescriptor& outDescriptor, std::vector<float>& outDistances, MeshSDFBakeStats* outStats)
+{
+	assert(settings.resolution > 0 && settings.brickSize > 0);
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	TriangleBVH bvh;
+	bvh.Build(positions, indices);
+
+	MeshSDFBakeStats stats;
+	stats.triangleCount = bvh.GetTriangleCount();
+	stats.buildMs = MillisecondsSince(startTime);
+
+	const MeshSDFDescriptor descriptor = ComputeVolume(positions, settings);
+	const uint32_t resolution = settings.resolution;
+	const float voxelSize = 2.0f * descriptor.extent / resolution;
+
+	startTime = std::chrono::high_resolution_clock::now();
+
+	std::vector<uint8_t> insideVotes;
+	ComputeInsideVotes(bvh, descriptor, insideVotes);
+
+	stats.signMs = MillisecondsSince(startTime);
+	startTime = std::chrono::high_resolution_clock::now();
+
+	outDistances.assign((size_t)resolution * resolution * resolution, FLT_MAX);
+
+	const uint32_t brickSize = settings.brickSize;
+	const uint32_t bricksPerSide = (resolution + brickSize - 1) / brickSize;
+	const uint32_t brickCount = bricksPerSide * bricksPerSide * bricksPerSide;
+	const float narrowBand = settings.narrowBandVoxels * voxelSize;
+
+	std::atomic<uint32_t> exactBrickCount = 0;
+	std::atomic<uint64_t> closestPointQueries = 0;
+
+	if (bvh.GetTriangleCount() > 0)
+	{
+		ParallelForBalanced("BakeMeshSDF", brickCount, [&](uint32_t brickIndex)
+		{
+			const uint32_t brickX = brickIndex % bricksPerSide;
+			const uint32_t brickY = (brickIndex / bricksPerSide) % bricksPerSide;
+			const uint32_t brickZ = brickIndex / (bricksPerSide * bricksPerSide);
+
+			// Voxel range [first, last] of the brick
+			const uint32_t first[3] = { brickX * brickSize, brickY * brickSize, brickZ * brickSize };
+			const uint32_t last[3] = {
+				(std::min)(first[0] + brickSize, resolution) - 1,
+				(std::min)(first[1] + brickSize, resolution) - 1,
+				(std::min)(first[2] + brickSize, resolution) - 1 };
+
+			const TVector3 firstCenter = GetVoxelCenter(descriptor, voxelSize, first[0], first[1], first[2]);
+			const TVector3 lastCenter = GetVoxelCenter(descriptor, voxelSize, last[0], last[1], last[2]);
+			const TVector3 brickCenter = (firstCenter + lastCenter) * 0.5f;
+			const float halfDiagonal = (lastCenter - firstCenter).Length() * 0.5f;
+
+			float centerDistance = FLT_MAX;
+			bvh.FindClosest(brickCenter, FLT_MAX, centerDistance);
+			uint64_t queryCount = 1;
+
+			// Every voxel of the brick is at most this far from the surface, with some slack for rounding
+			const float brickMaxDistance = (centerDistance + halfDiagonal) * 1.001f + voxelSize * 0.01f;
+
+			auto QueryDistance = [&](const TVector3& point, float maxDistance)
+			{
+				float distance = FLT_MAX;
+				if (!bvh.FindClosest(point, maxDistance, distance))
+				{
+					bvh.FindClosest(point, FLT_MAX, distance);
+					queryCount++;
+				}
+				queryCount++;
+				return distance;
+			};
+
+			if (centerDistance - halfDiagonal > narrowBand)
+			{
+				// Coarse brick. d^2(p) - |p|^2 is a minimum of functions linear in p, so it is concave and its trilinear
+				// interpolation from the corners never lies above it. The result never overestimates the distance,
+				// sphere tracing through the brick can not step past the surface.
+				// Around a peak of the distance, deep inside a sphere, the interpolation drops to zero. The distance from
+				// the brick center minus the offset is a bound as well and stays above the narrow band.
+				float corners[8];
+				for (uint32_t c = 0; c < 8; c++)
+				{
+					const TVector3 corner = GetVoxelCenter(descriptor, voxelSize,
+						(c & 1) ? last[0] : first[0], (c & 2) ? last[1] : first[1], (c & 4) ? last[2] : first[2]);
+					const float distance = QueryDistance(corner, brickMaxDistance);
+					corners[c] = distance * distance - (corner - brickCenter).LengthSquared();
+				}
+
+				for (uint32_t z = first[2]; z <= last[2]; z++)
+				{
+					const float tz = last[2] > first[2] ? (float)(z - first[2]) / (last[2] - first[2]) : 0.0f;
+					for (uint32_t y = first[1]; y <= last[1]; y++)
+					{
+						const float ty = last[1] > first[1] ? (float)(y - first[1]) / (last[1] - first[1]) : 0.0f;
+						const float edge0 = Lerp(Lerp(corners[0], corners[2], ty), Lerp(corners[4], corners[6], ty), tz);
+						const float edge1 = Lerp(Lerp(corners[1], corners[3], ty), Lerp(corners[5], corners[7], ty), tz);
+
+						for (uint32_t x = first[0]; x <= last[0]; x++)
+						{
+							const float tx = last[0] > first[0] ? (float)(x - first[0]) / (last[0] - first[0]) : 0.0f;
+							const float offsetSquared = (GetVoxelCenter(descriptor, voxelSize, x, y, z) - brickCenter).LengthSquared();
+							const float interpolated = std::sqrt((std::max)(Lerp(edge0, edge1, tx) + offsetSquared, 0.0f));
+							outDistances[x + ((size_t)y + (size_t)z * resolution) * resolution] = (std::max)(interpolated, centerDistance - std::sqrt(offsetSquared));
+						}
+					}
+				}
+			}
+			else
+			{
+				exactBrickCount++;
+
+				for (uint32_t z = first[2]; z <= last[2]; z++)
+				{
+					for (uint32_t y = first[1]; y <= last[1]; y++)
+					{
+						// A neighbour is one voxel away, so its distance plus a voxel bounds the search
+						float previousDistance = FLT_MAX;
+						for (uint32_t x = first[0]; x <= last[0]; x++)
+						{
+							const float maxDistance = (std::min)(brickMaxDistance, previousDistance * 1.001f + voxelSize * 1.01f);
+							const float distance = QueryDistance(GetVoxelCenter(descriptor, voxelSize, x, y, z), maxDistance);
+							outDistances[x + ((size_t)y + (size_t)z * resolution) * resolution] = distance;
+							previousDistance = distance;
+						}
+					}
+				}
+			}
+
+			closestPointQueries += queryCount;
+		});
+	}
+
+	for (size_t i = 0; i < outDistances.size(); i++)
+	{
+		if (insideVotes[i] >= 2)
+		{
+			outDistances[i] = -outDistances[i];
+		}
+	}
+
+	stats.exactBrickCount = exactBrickCount;
+	stats.coarseBrickCount = brickCount - stats.exactBrickCount;
+	stats.closestPointQueries = closestPointQueries;
+	stats.distanceMs = MillisecondsSince(startTime);
+
+	outDescriptor = descriptor;
+	if (outStats)
+	{
+		*outStats = stats;
+	}
+}
+
+MeshSDFDescriptor MeshSDFBaker::ComputeVolume(const std::vector<TVector3>& positions, const MeshSDFBakeSettings& settings)
+{
+	TVector3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+	for (const TVector3& position : positions)
+	{
+		boundsMin = TVector3::Min(boundsMin, position);
+		boundsMax = TVector3::Max(boundsMax, position);
+	}
+
+	MeshSDFDescriptor descriptor = {};
+	descriptor.resolution = (int)settings.resolution;
+
+	if (positions.empty())
+	{
+		descriptor.extent = 1.0f;
+		return descriptor;
+	}
+
+	const TVector3 halfSize = (boundsMax - boundsMin) * 0.5f;
+	const float maxHalfSize = (std::max)((std::max)(halfSize.x, halfSize.y), halfSize.z);
+
+	descriptor.center = (boundsMin + boundsMax) * 0.5f;
+	descriptor.extent = maxHalfSize > 0.0f ? maxHalfSize * (1.0f + settings.boundsPadding) : 1.0f;
+
+	return descriptor;
+}
+
+void MeshSDFBaker::ComputeInsideVotes(const TriangleBVH& bvh, const MeshSDFDescriptor& descriptor, std::vector<uint8_t>& outVotes)
+{
+	const uint32_t resolution = (uint32_t)descriptor.resolution;
+	const float voxelSize = 2.0f * descriptor.extent / resolution;
+
+	outVotes.assign((size_t)resolution * resolution * resolution, 0);
+
+	if (bvh.GetTriangleCount() == 0)
+	{
+		return;
+	}
+
+	// Rays start one voxel outside the volume. The small offset keeps them off the edges and vertices of
+	// grid aligned meshes, where one crossing would be counted twice.
+	const float startOffset = voxelSize;
+	const float jitter[3] = { 0.00137f * voxelSize, 0.00271f * voxelSize, 0.00419f * voxelSize };
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const int axisU = (axis + 1) % 3;
+		const int axisV = (axis + 2) % 3;
+
+		// Rows of one axis write disjoint voxels
+		JobSystem::Get().ParallelFor("MeshSDFInsideVotes", resolution * resolution, 16, [&](uint32_t begin, uint32_t end)
+		{
+			std::vector<float> hits;
+			for (uint32_t row = begin; row < end; row++)
+			{
+				const uint32_t u = row % resolution;
+				const uint32_t v = row / resolution;
+
+				TVector3 origin = descriptor.center - TVector3(descriptor.extent);
+				origin[axis] -= startOffset;
+				origin[axisU] += (u + 0.5f) * voxelSize + jitter[axisU];
+				origin[axisV] += (v + 0.5f) * voxelSize + jitter[axisV];
+
+				TVector3 direction;
+				direction[axis] = 1.0f;
+
+				hits.clear();
+				bvh.IntersectAll(origin, direction, 2.0f * (descriptor.extent + startOffset), hits);
+				std::sort(hits.begin(), hits.end());
+
+				uint32_t voxel[3];
+				voxel[axisU] = u;
+				voxel[axisV] = v;
+
+				size_t hitIndex = 0;
+				for (uint32_t i = 0; i < resolution; i++)
+				{
+					const float t = startOffset + (i + 0.5f) * voxelSize;
+					while (hitIndex < hits.size() && hits[hitIndex] < t)
+					{
+						hitIndex++;
+					}
+
+					if (hitIndex & 1)
+					{
+						voxel[axis] = i;
+						outVotes[voxel[0] + ((size_t)voxel[1] + (size_t)voxel[2] * resolution) * resolution]++;
+					}
+				}
+			}
+		});
+	}
+}
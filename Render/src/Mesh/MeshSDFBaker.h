@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Mesh.h"
+#include "TriangleBVH.h"
+
+struct MeshSDFBakeSettings
+{
+	uint32_t resolution = 64;        // Voxels per side, the volume is a cube around the bounding box
+	float boundsPadding = 0.1f;      // Added on every side, relative to the largest half size of the bounding box
+	uint32_t brickSize = 8;          // Voxels per brick side, bricks are the unit of work
+	float narrowBandVoxels = 4.0f;   // Bricks this close to the surface get exact distances, the others interpolate their corners
+};
+
+struct MeshSDFBakeStats
+{
+	uint32_t triangleCount = 0;
+	uint32_t exactBrickCount = 0;
+	uint32_t coarseBrickCount = 0;
+	uint64_t closestPointQueries = 0;
+	double buildMs = 0.0;      // Triangle BVH
+	double signMs = 0.0;       // Ray parity sweeps
+	double distanceMs = 0.0;
+};
+
+// CPU signed distance field baker for Mesh::SDFTexture, runs on the job system.
+//   1. Builds a TriangleBVH over the mesh.
+//   2. Sign: every voxel row is swept by a ray along x, y and z, a voxel is inside if an odd number of triangles
+//      lies in front of it. The three axes vote so a crack or a grazing hit flips one vote only.
+//   3. Distance: the volume is split into bricks. Bricks within narrowBandVoxels of the surface query the BVH per voxel,
+//      bricks farther away query their 8 corners and fill the rest trilinearly, in a form that never overestimates
+//      the distance. The distance of the brick center minus the offset to it is a floor under the interpolation.
+// Distances are in mesh space, negative inside. Voxel (x, y, z) is at x + (y + z * resolution) * resolution.
+class MeshSDFBaker
+{
+public:
+	static void Bake(const std::vector<TVector3>& positions, const std::vector<uint32_t>& indices, const MeshSDFBakeSettings& settings,
+		MeshSDFDescriptor& outDescriptor, std::vector<float>& outDistances, MeshSDFBakeStats* outStats = nullptr);
+
+	// Fills SDFDescriptor and SDFTexture (R16_FLOAT), call CreateTexture on the result to upload it.
+	// In MeshSDFBakerTexture.cpp, Bake does not depend on the renderer.
+	static void BakeMesh(Mesh& mesh, const MeshSDFBakeSettings& settings, MeshSDFBakeStats* outStats = nullptr);
+
+private:
+	static MeshSDFDescriptor ComputeVolume(const std::vector<TVector3>& positions, const MeshSDFBakeSettings& settings);
+
+	// One vote per axis that saw the voxel inside
+	static void ComputeInsideVotes(const TriangleBVH& bvh, const MeshSDFDescriptor& descriptor, std::vector<uint8_t>& outVotes);
+};
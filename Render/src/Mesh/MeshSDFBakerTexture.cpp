@@ -0,0 +1,42 @@
+#include "MeshSDFBaker.h"
+#include <DirectXPackedVector.h>
+
+// Kept apart from the bake, which the tests link without the renderer
+void MeshSDFBaker::BakeMesh(Mesh& mesh, const MeshSDFBakeSettings& settings, MeshSDFBakeStats* outStats)
+{
+	std::vector<TVector3> positions(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		positions[i] = mesh.vertices[i].position;
+	}
+
+	std::vector<float> distances;
+	Bake(positions, mesh.indices32, settings, mesh.SDFDescriptor, distances, outStats);
+
+	// Half floats keep about 3 significant digits, plenty for sphere tracing
+	const size_t resolution = settings.resolution;
+	std::vector<uint8_t> textureData(distances.size() * sizeof(uint16_t));
+	uint16_t* halfDistances = reinterpret_cast<uint16_t*>(textureData.data());
+	for (size_t i = 0; i < distances.size(); i++)
+	{
+		halfDistances[i] = DirectX::PackedVector::XMConvertFloatToHalf(distances[i]);
+	}
+
+	TextureInfo textureInfo = {};
+	textureInfo.textureType = ETextureType::TEXTURE_3D;
+	textureInfo.dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+	textureInfo.width = resolution;
+	textureInfo.height = resolution;
+	textureInfo.depth = resolution;
+	textureInfo.arraySize = 1;
+	textureInfo.mipCount = 1;
+	textureInfo.format = DXGI_FORMAT_R16_FLOAT;
+
+	D3D12_SUBRESOURCE_DATA initData = {};
+	initData.RowPitch = resolution * sizeof(uint16_t);
+	initData.SlicePitch = resolution * resolution * sizeof(uint16_t);
+
+	std::unique_ptr<Texture3D> sdfTexture = std::make_unique<Texture3D>(mesh.meshName + "_SDF", false, L"");
+	sdfTexture->SetTextureResourceDirectly(textureInfo, textureData, initData);
+	mesh.SetSDFTexture(sdfTexture);
+}
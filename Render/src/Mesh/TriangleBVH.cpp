@@ -0,0 +1,420 @@
+#include "TriangleBVH.h"
+#include <algorithm>
+#include <assert.h>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	float SurfaceArea(const TVector3& boundsMin, const TVector3& boundsMax)
+	{
+		const TVector3 size = boundsMax - boundsMin;
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	void GrowBounds(TVector3& boundsMin, TVector3& boundsMax, const TVector3& point)
+	{
+		boundsMin = TVector3::Min(boundsMin, point);
+		boundsMax = TVector3::Max(boundsMax, point);
+	}
+
+	struct Bin
+	{
+		TVector3 boundsMin = TVector3(FLT_MAX);
+		TVector3 boundsMax = TVector3(-FLT_MAX);
+		uint32_t count = 0;
+	};
+}
+
+void TriangleBVH::Build(const std::vector<TVector3>& positions, const std::vector<uint32_t>& indices)
+{
+	nodes.clear();
+	triangles.clear();
+
+	const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	std::vector<Triangle> sourceTriangles(triangleCount);
+	std::vector<TVector3> centroids(triangleCount);
+	std::vector<uint32_t> order(triangleCount);
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		Triangle& triangle = sourceTriangles[i];
+		triangle.v0 = positions[indices[i * 3 + 0]];
+		triangle.v1 = positions[indices[i * 3 + 1]];
+		triangle.v2 = positions[indices[i * 3 + 2]];
+
+		centroids[i] = (triangle.v0 + triangle.v1 + triangle.v2) * (1.0f / 3.0f);
+		order[i] = i;
+	}
+
+	nodes.reserve((size_t)triangleCount * 2);
+	nodes.emplace_back();
+	nodes[0].leftOrFirst = 0;
+	nodes[0].triangleCount = triangleCount;
+
+	struct BuildItem
+	{
+		uint32_t nodeIndex;
+		uint32_t depth;
+	};
+	std::vector<BuildItem> buildStack = { { 0, 1 } };
+
+	while (!buildStack.empty())
+	{
+		const BuildItem item = buildStack.back();
+		buildStack.pop_back();
+
+		const uint32_t first = nodes[item.nodeIndex].leftOrFirst;
+		const uint32_t count = nodes[item.nodeIndex].triangleCount;
+
+		TVector3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+		TVector3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			const Triangle& triangle = sourceTriangles[order[i]];
+			GrowBounds(boundsMin, boundsMax, triangle.v0);
+			GrowBounds(boundsMin, boundsMax, triangle.v1);
+			GrowBounds(boundsMin, boundsMax, triangle.v2);
+			GrowBounds(centroidMin, centroidMax, centroids[order[i]]);
+		}
+		nodes[item.nodeIndex].boundsMin = boundsMin;
+		nodes[item.nodeIndex].boundsMax = boundsMax;
+
+		if (count <= TRIANGLE_BVH_MAX_LEAF_SIZE || item.depth >= TRIANGLE_BVH_MAX_DEPTH)
+		{
+			continue;
+		}
+
+		// Binned SAH over the centroids, the cost of a split is the child areas weighted by their triangle counts
+		int bestAxis = -1;
+		uint32_t bestSplit = 0;
+		float bestCost = FLT_MAX;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const float extent = centroidMax[axis] - centroidMin[axis];
+			if (extent <= 0.0f)
+			{
+				continue;
+			}
+
+			Bin bins[TRIANGLE_BVH_BIN_COUNT];
+			const float scale = TRIANGLE_BVH_BIN_COUNT / extent;
+			for (uint32_t i = first; i < first + count; i++)
+			{
+				const uint32_t b = (std::min)((uint32_t)((centroids[order[i]][axis] - centroidMin[axis]) * scale), (uint32_t)TRIANGLE_BVH_BIN_COUNT - 1);
+				const Triangle& triangle = sourceTriangles[order[i]];
+				GrowBounds(bins[b].boundsMin, bins[b].boundsMax, triangle.v0);
+				GrowBounds(bins[b].boundsMin, bins[b].boundsMax, triangle.v1);
+				GrowBounds(bins[b].boundsMin, bins[b].boundsMax, triangle.v2);
+				bins[b].count++;
+			}
+
+			// leftCost[s] covers bins [0, s), the sweep from the right adds bins [s, BIN_COUNT)
+			float leftCost[TRIANGLE_BVH_BIN_COUNT];
+			{
+				TVector3 leftMin(FLT_MAX), leftMax(-FLT_MAX);
+				uint32_t leftCount = 0;
+				for (uint32_t s = 1; s < TRIANGLE_BVH_BIN_COUNT; s++)
+				{
+					leftMin = TVector3::Min(leftMin, bins[s - 1].boundsMin);
+					leftMax = TVector3::Max(leftMax, bins[s - 1].boundsMax);
+					leftCount += bins[s - 1].count;
+					leftCost[s] = leftCount > 0 ? SurfaceArea(leftMin, leftMax) * leftCount : 0.0f;
+				}
+			}
+
+			TVector3 rightMin(FLT_MAX), rightMax(-FLT_MAX);
+			uint32_t rightCount = 0;
+			for (uint32_t s = TRIANGLE_BVH_BIN_COUNT - 1; s > 0; s--)
+			{
+				rightMin = TVector3::Min(rightMin, bins[s].boundsMin);
+				rightMax = TVector3::Max(rightMax, bins[s].boundsMax);
+				rightCount += bins[s].count;
+
+				if (rightCount == 0 || rightCount == count)
+				{
+					continue;
+				}
+
+				const float cost = leftCost[s] + SurfaceArea(rightMin, rightMax) * rightCount;
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = s;
+				}
+			}
+		}
+
+		uint32_t middle = first;
+		if (bestAxis >= 0)
+		{
+			const float scale = TRIANGLE_BVH_BIN_COUNT / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+			middle = (uint32_t)(std::partition(order.begin() + first, order.begin() + first + count, [&](uint32_t triangleIndex)
+			{
+				const uint32_t b = (std::min)((uint32_t)((centroids[triangleIndex][bestAxis] - centroidMin[bestAxis]) * scale), (uint32_t)TRIANGLE_BVH_BIN_COUNT - 1);
+				return b < bestSplit;
+			}) - order.begin());
+		}
+
+		if (middle == first || middle == first + count)
+		{
+			// Every centroid in one spot, split by count so the leaves stay small
+			middle = first + count / 2;
+		}
+
+		const uint32_t leftIndex = (uint32_t)nodes.size();
+		nodes.emplace_back();
+		nodes.emplace_back();
+
+		nodes[leftIndex].leftOrFirst = first;
+		nodes[leftIndex].triangleCount = middle - first;
+		nodes[leftIndex + 1].leftOrFirst = middle;
+		nodes[leftIndex + 1].triangleCount = first + count - middle;
+
+		nodes[item.nodeIndex].leftOrFirst = leftIndex;
+		nodes[item.nodeIndex].triangleCount = 0;
+
+		buildStack.push_back({ leftIndex + 1, item.depth + 1 });
+		buildStack.push_back({ leftIndex, item.depth + 1 });
+	}
+
+	triangles.resize(triangleCount);
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		triangles[i] = sourceTriangles[order[i]];
+	}
+}
+
+bool TriangleBVH::FindClosest(const TVector3& point, float maxDistance, float& outDistance) const
+{
+	if (nodes.empty())
+	{
+		return false;
+	}
+
+	float bestDistanceSquared = maxDistance * maxDistance;
+	bool bFound = false;
+
+	struct StackItem
+	{
+		uint32_t nodeIndex;
+		float distanceSquared;
+	};
+	StackItem stack[TRIANGLE_BVH_MAX_DEPTH + 1];
+	uint32_t stackSize = 0;
+
+	const float rootDistanceSquared = PointBoxDistanceSquared(point, nodes[0]);
+	if (rootDistanceSquared > bestDistanceSquared)
+	{
+		return false;
+	}
+	stack[stackSize++] = { 0, rootDistanceSquared };
+
+	while (stackSize > 0)
+	{
+		const StackItem item = stack[--stackSize];
+
+		// The best distance may have shrunk since the node was pushed
+		if (item.distanceSquared > bestDistanceSquared)
+		{
+			continue;
+		}
+
+		const Node& node = nodes[item.nodeIndex];
+		if (node.triangleCount > 0)
+		{
+			for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.triangleCount; i++)
+			{
+				const float distanceSquared = PointTriangleDistanceSquared(point, triangles[i]);
+				if (distanceSquared <= bestDistanceSquared)
+				{
+					bestDistanceSquared = distanceSquared;
+					bFound = true;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first, it is pushed last
+		StackItem left = { node.leftOrFirst, PointBoxDistanceSquared(point, nodes[node.leftOrFirst]) };
+		StackItem right = { node.leftOrFirst + 1, PointBoxDistanceSquared(point, nodes[node.leftOrFirst + 1]) };
+		if (left.distanceSquared < right.distanceSquared)
+		{
+			std::swap(left, right);
+		}
+
+		if (left.distanceSquared <= bestDistanceSquared)
+		{
+			stack[stackSize++] = left;
+		}
+		if (right.distanceSquared <= bestDistanceSquared)
+		{
+			stack[stackSize++] = right;
+		}
+	}
+
+	if (bFound)
+	{
+		outDistance = std::sqrt(bestDistanceSquared);
+	}
+
+	return bFound;
+}
+
+void TriangleBVH::IntersectAll(const TVector3& origin, const TVector3& direction, float maxT, std::vector<float>& outHits) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	const TVector3 invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+	uint32_t stack[TRIANGLE_BVH_MAX_DEPTH + 1];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = nodes[stack[--stackSize]];
+
+		// Slab test
+		float tMin = 0.0f;
+		float tMax = maxT;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float t0 = (node.boundsMin[axis] - origin[axis]) * invDirection[axis];
+			float t1 = (node.boundsMax[axis] - origin[axis]) * invDirection[axis];
+			if (t0 > t1)
+			{
+				std::swap(t0, t1);
+			}
+			tMin = (std::max)(tMin, t0);
+			tMax = (std::min)(tMax, t1);
+		}
+		if (tMin > tMax)
+		{
+			continue;
+		}
+
+		if (node.triangleCount == 0)
+		{
+			stack[stackSize++] = node.leftOrFirst;
+			stack[stackSize++] = node.leftOrFirst + 1;
+			continue;
+		}
+
+		// Moller-Trumbore, both windings count
+		for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.triangleCount; i++)
+		{
+			const Triangle& triangle = triangles[i];
+			const TVector3 edge1 = triangle.v1 - triangle.v0;
+			const TVector3 edge2 = triangle.v2 - triangle.v0;
+			const TVector3 p = direction.Cross(edge2);
+			const float det = edge1.Dot(p);
+			if (det == 0.0f)
+			{
+				continue;
+			}
+
+			const float invDet = 1.0f / det;
+			const TVector3 s = origin - triangle.v0;
+			const float u = s.Dot(p) * invDet;
+			if (u < 0.0f || u > 1.0f)
+			{
+				continue;
+			}
+
+			const TVector3 q = s.Cross(edge1);
+			const float v = direction.Dot(q) * invDet;
+			if (v < 0.0f || u + v > 1.0f)
+			{
+				continue;
+			}
+
+			const float t = edge2.Dot(q) * invDet;
+			if (t > 0.0f && t < maxT)
+			{
+				outHits.push_back(t);
+			}
+		}
+	}
+}
+
+float TriangleBVH::PointTriangleDistanceSquared(const TVector3& p, const Triangle& triangle)
+{
+	// Ericson, "Real-Time Collision Detection" 5.1.5, finds the Voronoi region of p
+	const TVector3& a = triangle.v0;
+	const TVector3& b = triangle.v1;
+	const TVector3& c = triangle.v2;
+
+	const TVector3 ab = b - a;
+	const TVector3 ac = c - a;
+	const TVector3 ap = p - a;
+	const float d1 = ab.Dot(ap);
+	const float d2 = ac.Dot(ap);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+	{
+		return ap.LengthSquared();
+	}
+
+	const TVector3 bp = p - b;
+	const float d3 = ab.Dot(bp);
+	const float d4 = ac.Dot(bp);
+	if (d3 >= 0.0f && d4 <= d3)
+	{
+		return bp.LengthSquared();
+	}
+
+	const float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		const float v = d1 / (d1 - d3);
+		return (ap - ab * v).LengthSquared();
+	}
+
+	const TVector3 cp = p - c;
+	const float d5 = ab.Dot(cp);
+	const float d6 = ac.Dot(cp);
+	if (d6 >= 0.0f && d5 <= d6)
+	{
+		return cp.LengthSquared();
+	}
+
+	const float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		const float w = d2 / (d2 - d6);
+		return (ap - ac * w).LengthSquared();
+	}
+
+	const float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+		const float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		return (bp - (c - b) * w).LengthSquared();
+	}
+
+	// Inside the face
+	const float denom = 1.0f / (va + vb + vc);
+	const float v = vb * denom;
+	const float w = vc * denom;
+	return (ap - ab * v - ac * w).LengthSquared();
+}
+
+float TriangleBVH::PointBoxDistanceSquared(const TVector3& p, const Node& node)
+{
+	float distanceSquared = 0.0f;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float d = (std::max)((std::max)(node.boundsMin[axis] - p[axis], 0.0f), p[axis] - node.boundsMax[axis]);
+		distanceSquared += d * d;
+	}
+
+	return distanceSquared;
+}
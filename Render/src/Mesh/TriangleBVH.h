@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../Math/Vector3.h"
+
+// Leaves hold at most this many triangles, unless the tree reached TRIANGLE_BVH_MAX_DEPTH
+#define TRIANGLE_BVH_MAX_LEAF_SIZE 4
+
+// Bounds the traversal stacks
+#define TRIANGLE_BVH_MAX_DEPTH 64
+
+// SAH bins per axis
+#define TRIANGLE_BVH_BIN_COUNT 16
+
+// Bounding volume hierarchy over the triangles of one mesh, built with binned SAH.
+// Unlike BVHAccelerator (which sorts mesh components of the scene) this one answers per-triangle queries
+// for CPU bakers. Nodes and triangles are flattened into arrays, the two children of a node are adjacent.
+// Read only after Build, so queries may run on any number of threads.
+class TriangleBVH
+{
+public:
+	// Triangles are copied, the source arrays may be released afterwards
+	void Build(const std::vector<TVector3>& positions, const std::vector<uint32_t>& indices);
+
+	// Distance to the closest point on any triangle, searched within maxDistance only.
+	// Returns false if no triangle is that close.
+	bool FindClosest(const TVector3& point, float maxDistance, float& outDistance) const;
+
+	// Appends the ray parameter of every triangle crossed in (0, maxT), unsorted.
+	// direction does not need to be normalized, the parameters are in its units.
+	void IntersectAll(const TVector3& origin, const TVector3& direction, float maxT, std::vector<float>& outHits) const;
+
+	uint32_t GetTriangleCount() const { return (uint32_t)triangles.size(); }
+	uint32_t GetNodeCount() const { return (uint32_t)nodes.size(); }
+
+	TVector3 GetBoundsMin() const { return nodes.empty() ? TVector3() : nodes[0].boundsMin; }
+	TVector3 GetBoundsMax() const { return nodes.empty() ? TVector3() : nodes[0].boundsMax; }
+
+private:
+	struct Node
+	{
+		TVector3 boundsMin;
+		uint32_t leftOrFirst = 0;    // Left child for inner nodes, the right one follows it. First triangle for leaves.
+		TVector3 boundsMax;
+		uint32_t triangleCount = 0;  // 0 for inner nodes
+	};
+
+	struct Triangle
+	{
+		TVector3 v0;
+		TVector3 v1;
+		TVector3 v2;
+	};
+
+	static float PointTriangleDistanceSquared(const TVector3& p, const Triangle& triangle);
+	static float PointBoxDistanceSquared(const TVector3& p, const Node& node);
+
+private:
+	std::vector<Node> nodes;
+	std::vector<Triangle> triangles;
+};
@@ -62,4 +62,17 @@ struct SpriteVertex
 
 	TVector3 Position;
 	TVector2 TexC;
-};
\ No newline at end of file
+};
+
+// 16 byte vertex for the compact stream, see VertexCompression.h
+//   position: 16 bit unorm inside the mesh bounding box (w unused)
+//   normal, tangent: octahedral encoded, 8 bit snorm per component
+//   texcoord: half float
+struct CompactVertex
+{
+	uint16_t position[4];
+	int8_t normal[2];
+	int8_t tangent[2];
+	uint16_t texcoord[2];
+};
+static_assert(sizeof(CompactVertex) == 16, "CompactVertex must match CompactInputLayout");
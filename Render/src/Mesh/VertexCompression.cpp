@@ -0,0 +1,154 @@
+#include "VertexCompression.h"
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	uint16_t QuantizeUnorm16(float v)
+	{
+		v = std::clamp(v, 0.0f, 1.0f);
+		return (uint16_t)std::lround(v * 65535.0f);
+	}
+
+	int8_t QuantizeSnorm8(float v)
+	{
+		v = std::clamp(v, -1.0f, 1.0f);
+		return (int8_t)std::lround(v * 127.0f);
+	}
+
+	// Same rule as the R8_SNORM input assembler conversion, -128 maps to -1
+	float DequantizeSnorm8(int8_t v)
+	{
+		return (std::max)(v / 127.0f, -1.0f);
+	}
+
+	float AngleBetween(TVector3 a, TVector3 b)
+	{
+		a.Normalize();
+		b.Normalize();
+		float cosAngle = std::clamp(a.Dot(b), -1.0f, 1.0f);
+		return std::acos(cosAngle) * 180.0f / TMath::Pi;
+	}
+}
+
+TVector3 VertexCompression::GetPositionScale(const TBoundingBox& bounds)
+{
+	return bounds.GetSize();
+}
+
+TVector2 VertexCompression::OctEncode(TVector3 n)
+{
+	float l1Norm = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	if (l1Norm <= 0.0f)
+	{
+		return TVector2(0.0f, 0.0f);
+	}
+
+	n /= l1Norm;
+
+	// Fold the lower hemisphere over the diagonals
+	if (n.z < 0.0f)
+	{
+		float x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+		float y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+		return TVector2(x, y);
+	}
+
+	return TVector2(n.x, n.y);
+}
+
+TVector3 VertexCompression::OctDecode(TVector2 e)
+{
+	TVector3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+
+	float t = std::clamp(-n.z, 0.0f, 1.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	n.Normalize();
+
+	return n;
+}
+
+CompactVertex VertexCompression::Encode(const Vertex& vertex, const TBoundingBox& bounds)
+{
+	CompactVertex result;
+
+	TVector3 scale = GetPositionScale(bounds);
+	const float* position = &vertex.position.x;
+	const float* boxMin = &bounds.boxMin.x;
+	const float* boxScale = &scale.x;
+	for (int i = 0; i < 3; i++)
+	{
+		// Flat axis, every vertex sits on boxMin
+		float unorm = boxScale[i] > 0.0f ? (position[i] - boxMin[i]) / boxScale[i] : 0.0f;
+		result.position[i] = QuantizeUnorm16(unorm);
+	}
+	result.position[3] = 0;
+
+	TVector2 normal = OctEncode(vertex.normal);
+	result.normal[0] = QuantizeSnorm8(normal.x);
+	result.normal[1] = QuantizeSnorm8(normal.y);
+
+	TVector2 tangent = OctEncode(vertex.tangentU);
+	result.tangent[0] = QuantizeSnorm8(tangent.x);
+	result.tangent[1] = QuantizeSnorm8(tangent.y);
+
+	result.texcoord[0] = XMConvertFloatToHalf(vertex.texcoord.x);
+	result.texcoord[1] = XMConvertFloatToHalf(vertex.texcoord.y);
+
+	return result;
+}
+
+Vertex VertexCompression::Decode(const CompactVertex& vertex, const TBoundingBox& bounds)
+{
+	Vertex result;
+
+	TVector3 scale = GetPositionScale(bounds);
+	result.position = TVector3(
+		bounds.boxMin.x + vertex.position[0] / 65535.0f * scale.x,
+		bounds.boxMin.y + vertex.position[1] / 65535.0f * scale.y,
+		bounds.boxMin.z + vertex.position[2] / 65535.0f * scale.z);
+
+	result.normal = OctDecode(TVector2(DequantizeSnorm8(vertex.normal[0]), DequantizeSnorm8(vertex.normal[1])));
+	result.tangentU = OctDecode(TVector2(DequantizeSnorm8(vertex.tangent[0]), DequantizeSnorm8(vertex.tangent[1])));
+
+	result.texcoord = TVector2(XMConvertHalfToFloat(vertex.texcoord[0]), XMConvertHalfToFloat(vertex.texcoord[1]));
+
+	return result;
+}
+
+void VertexCompression::Compress(const std::vector<Vertex>& vertices, const TBoundingBox& bounds, std::vector<CompactVertex>& outVertices)
+{
+	outVertices.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		outVertices[i] = Encode(vertices[i], bounds);
+	}
+}
+
+VertexCompressionError VertexCompression::MeasureError(const std::vector<Vertex>& vertices, const TBoundingBox& bounds)
+{
+	VertexCompressionError error;
+
+	for (const Vertex& vertex : vertices)
+	{
+		Vertex decoded = Decode(Encode(vertex, bounds), bounds);
+
+		error.maxPositionError = (std::max)(error.maxPositionError, (decoded.position - vertex.position).Length());
+		if (vertex.normal.LengthSquared() > 0.0f)
+		{
+			error.maxNormalAngle = (std::max)(error.maxNormalAngle, AngleBetween(decoded.normal, vertex.normal));
+		}
+		if (vertex.tangentU.LengthSquared() > 0.0f)
+		{
+			error.maxTangentAngle = (std::max)(error.maxTangentAngle, AngleBetween(decoded.tangentU, vertex.tangentU));
+		}
+		error.maxTexcoordError = (std::max)(error.maxTexcoordError, (std::max)(
+			std::abs(decoded.texcoord.x - vertex.texcoord.x), std::abs(decoded.texcoord.y - vertex.texcoord.y)));
+	}
+
+	return error;
+}
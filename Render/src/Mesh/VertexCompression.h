@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include "Vertex.h"
+#include "BoundingBox.h"
+
+struct VertexCompressionError
+{
+	float maxPositionError = 0.0f; // in mesh units
+	float maxNormalAngle = 0.0f;   // in degrees
+	float maxTangentAngle = 0.0f;  // in degrees
+	float maxTexcoordError = 0.0f;
+};
+
+// Encode/decode of the compact vertex stream, the decode mirrors DecodeVertex in BasePassDefault.hlsl.
+class VertexCompression
+{
+public:
+	static CompactVertex Encode(const Vertex& vertex, const TBoundingBox& bounds);
+
+	static Vertex Decode(const CompactVertex& vertex, const TBoundingBox& bounds);
+
+	static void Compress(const std::vector<Vertex>& vertices, const TBoundingBox& bounds, std::vector<CompactVertex>& outVertices);
+
+	// Round trips every vertex and reports the worst error
+	static VertexCompressionError MeasureError(const std::vector<Vertex>& vertices, const TBoundingBox& bounds);
+
+	// Scale that takes the unorm position back to mesh space, posL = boundsMin + unorm * scale
+	static TVector3 GetPositionScale(const TBoundingBox& bounds);
+
+private:
+	static TVector2 OctEncode(TVector3 n);
+	static TVector3 OctDecode(TVector2 e);
+};
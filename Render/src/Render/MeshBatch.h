@@ -4,7 +4,7 @@
 #include <string>
 #include <unordered_map>
 
-class MeshComponent;
+struct MeshRenderData;
 
 struct MeshBatch
 {
@@ -12,7 +12,7 @@ struct MeshBatch
 	std::string inputLayoutName;
 
 	ConstantBufferRef objConstantBuffer = nullptr;
-	MeshComponent* meshComponent = nullptr;
+	const MeshRenderData* meshData = nullptr;  // In the snapshot of the frame
 
 	// Flags
 	bool bUseSDF = false;
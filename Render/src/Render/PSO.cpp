@@ -31,7 +31,13 @@ void GraphicsPSOManager::CreatePSO(const GraphicsPSODescriptor& descriptor)
 	auto rootSignature = shader->rootSignature;
 	psoDesc.pRootSignature = rootSignature.Get();
 	psoDesc.VS = CD3DX12_SHADER_BYTECODE(shader->shaderPass.at("VS")->GetBufferPointer(), shader->shaderPass.at("VS")->GetBufferSize());
-	psoDesc.PS = CD3DX12_SHADER_BYTECODE(shader->shaderPass.at("PS")->GetBufferPointer(), shader->shaderPass.at("PS")->GetBufferSize());
+
+	// Depth only passes have no pixel shader
+	auto psIter = shader->shaderPass.find("PS");
+	if (psIter != shader->shaderPass.end())
+	{
+		psoDesc.PS = CD3DX12_SHADER_BYTECODE(psIter->second->GetBufferPointer(), psIter->second->GetBufferSize());
+	}
 
 	psoDesc.RasterizerState = descriptor.rasterizerDesc;
 	psoDesc.BlendState = descriptor.blendDesc;
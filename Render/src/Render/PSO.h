@@ -17,6 +17,9 @@ struct GraphicsPSODescriptor
 			&& other.shader == shader
 			&& other.primitiveTopologyType == primitiveTopologyType
 			&& other.rasterizerDesc.CullMode == rasterizerDesc.CullMode
+			&& other.rasterizerDesc.DepthBias == rasterizerDesc.DepthBias
+			&& other.rasterizerDesc.SlopeScaledDepthBias == rasterizerDesc.SlopeScaledDepthBias
+			&& other.rasterizerDesc.DepthClipEnable == rasterizerDesc.DepthClipEnable
 			&& other.depthStencilDesc.DepthFunc == depthStencilDesc.DepthFunc;
 	}
 
@@ -6,7 +6,8 @@ struct PrimitiveBatch
 {
 	D3D12_PRIMITIVE_TOPOLOGY primitiveType = D3D_PRIMITIVE_TOPOLOGY_LINELIST;
 
-	VertexBufferRef vertexBufferRef = nullptr;
+	// In the primitive vertex ring, valid for the frame being recorded
+	D3D12_GPU_VIRTUAL_ADDRESS vertexBufferAddress = 0;
 
 	int currentVertexNum = 0;
 };
@@ -8,14 +8,18 @@
 #include "../Material/MaterialRepository.h"
 #include "../Mesh/MeshRepository.h"
 #include "../Mesh/KdTree.h"
+#include "../Mesh/VertexCompression.h"
+#include "../Mesh/MeshSDFBaker.h"
 #include "../Texture/TextureInfo.h"
 #include "../Utils/Logger.h"
 #include <fstream>
 #include <algorithm>
+#include <unordered_set>
+#include <psapi.h>
 #include "../File/FileHelpers.h"
 #include "../File/BinarySaver.h"
 #include "../File/BinaryReader.h"
-#include "Sampler.h"
+#include "../Utility/Hash.h"
 
 using namespace DirectX;
 
@@ -116,12 +120,19 @@ void Render::CreateRenderResource()
 		CreateSceneCaptureCube();
 	}
 
+	CreateShadowMaps();
 	CreateMeshProxys();
+	CreateMeshSDFs();
 	CreateInputLayouts();
 	CreateGlobalShaders();
 	CreateGlobalPSO();
 	CreateComputePSO();
 
+	primitiveVertexRing = std::make_unique<FrameRingBuffer>(d3d12RHI, PRIMITIVE_VERTEX_RING_SIZE);
+
+	// Textures are uploaded on the copy queue, the GPU waits for them before the initialization commands
+	d3d12RHI->WaitForUpload(d3d12RHI->GetLastUploadTicket());
+
 	// Execute the initialization commands.
 	d3d12RHI->ExecuteCommandLists();
 	// Wait until initialization is complete.
@@ -175,11 +186,37 @@ void Render::CreateTextures()
 {
 	const auto& TextureMap = TextureRepository::Get().textureMap;
 
-	// create textures in reposity
+	if (renderSettings.bEnableTextureStreaming)
+	{
+		uint64_t budgetBytes = (uint64_t)renderSettings.textureStreamingBudgetMB * 1024 * 1024;
+		textureStreamer = std::make_unique<TextureStreamer>(d3d12RHI, budgetBytes);
+	}
+
+	// create textures in reposity, the uploads go through the copy queue
 	for (const auto& TexturePair : TextureMap)
 	{
-		TexturePair.second->LoadTextureResourceFromFlie(d3d12RHI);
-		TexturePair.second->CreateTexture(d3d12RHI);
+		const auto& texture = TexturePair.second;
+		JobSystem::Get().Wait(texture->loadJob);
+
+		// Streaming textures start with their mip tail only
+		if (textureStreamer && texture->IsStreaming() && texture->textureType == ETextureType::TEXTURE_2D && texture->GetMipCount() > 1)
+		{
+			textureStreamer->AddTexture(texture);
+		}
+		else
+		{
+			texture->CreateTexture(d3d12RHI);
+		}
+	}
+
+	// Every texture was decoded by now and waits in the copy queue uploader, so this is the load peak
+	PROCESS_MEMORY_COUNTERS memoryCounters = {};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+	{
+		char statsText[256];
+		sprintf_s(statsText, "Textures: %zu loaded, peak working set %.1f MB\n", TextureMap.size(),
+			memoryCounters.PeakWorkingSetSize / (1024.0 * 1024.0));
+		TLogger::LogToOutput(statsText);
 	}
 }
 
@@ -226,7 +263,22 @@ void Render::CreateColorTextures()
 
 	colorTexture = d3d12RHI->CreateTexture(textureInfo, TexCreate_SRV | TexCreate_RTV);
 	cacheColorTexture = d3d12RHI->CreateTexture(textureInfo, TexCreate_SRV);
-	prevColorTexture = d3d12RHI->CreateTexture(textureInfo, TexCreate_SRV);
+	prevColorTexture = d3d12RHI->CreateTexture(textureInfo, TexCreate_SRV | TexCreate_UAV);
+	resolvedColorTexture = d3d12RHI->CreateTexture(textureInfo, TexCreate_SRV | TexCreate_UAV);
+
+	// The new history holds nothing yet
+	bTAAHistoryValid = false;
+}
+
+void Render::CreateShadowMaps()
+{
+	UINT width = CSM_CASCADE_RESOLUTION * CSM_ATLAS_COLUMNS;
+	UINT height = CSM_CASCADE_RESOLUTION * CSM_ATLAS_ROWS;
+
+	cascadeShadowMap = std::make_unique<RenderTarget2D>(d3d12RHI, true, width, height, DXGI_FORMAT_R24G8_TYPELESS);
+	cascadeStaticShadowMap = std::make_unique<RenderTarget2D>(d3d12RHI, true, width, height, DXGI_FORMAT_R24G8_TYPELESS);
+
+	shadowAtlasMap = std::make_unique<RenderTarget2D>(d3d12RHI, true, SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE, DXGI_FORMAT_R24G8_TYPELESS);
 }
 
 void Render::CreateMeshProxys()
@@ -240,16 +292,39 @@ void Render::CreateMeshProxys()
 		// ------------------------------------------------------------------
 		// 1. vertex buffer
 		// ------------------------------------------------------------------
-		const UINT vbByteSize = static_cast<UINT>(mesh.vertices.size() * sizeof(Vertex));
-
 		MeshProxy& meshProxy = meshProxyMap
 			.emplace(mesh.meshName, MeshProxy{})
 			.first->second;
 
-		meshProxy.vertexBufferRef = d3d12RHI->CreateVertexBuffer(
-			mesh.vertices.data(), vbByteSize);
-		meshProxy.vertexByteStride = sizeof(Vertex);
-		meshProxy.vertexBufferByteSize = vbByteSize;
+		if (mesh.IsCompactVertex())
+		{
+			assert(mesh.boundingBox.bInit);
+
+			std::vector<CompactVertex> compactVertices;
+			VertexCompression::Compress(mesh.vertices, mesh.boundingBox, compactVertices);
+
+#ifdef _DEBUG
+			VertexCompressionError error = VertexCompression::MeasureError(mesh.vertices, mesh.boundingBox);
+			char errorText[256];
+			sprintf_s(errorText, "CompactVertex %s: position %f, normal %f deg, tangent %f deg, texcoord %f\n", mesh.meshName.c_str(),
+				error.maxPositionError, error.maxNormalAngle, error.maxTangentAngle, error.maxTexcoordError);
+			TLogger::LogToOutput(errorText);
+#endif
+
+			const UINT vbByteSize = static_cast<UINT>(compactVertices.size() * sizeof(CompactVertex));
+			meshProxy.vertexBufferRef = d3d12RHI->CreateVertexBuffer(
+				compactVertices.data(), vbByteSize);
+			meshProxy.vertexByteStride = sizeof(CompactVertex);
+			meshProxy.vertexBufferByteSize = vbByteSize;
+		}
+		else
+		{
+			const UINT vbByteSize = static_cast<UINT>(mesh.vertices.size() * sizeof(Vertex));
+			meshProxy.vertexBufferRef = d3d12RHI->CreateVertexBuffer(
+				mesh.vertices.data(), vbByteSize);
+			meshProxy.vertexByteStride = sizeof(Vertex);
+			meshProxy.vertexBufferByteSize = vbByteSize;
+		}
 
 		// ------------------------------------------------------------------
 		// 2. choose indices for 16 or 32
@@ -298,6 +373,43 @@ void Render::CreateMeshProxys()
 }
 
 
+void Render::CreateMeshSDFs()
+{
+	// Only meshes drawn with bUseSDF, or every mesh for the SDF debug view
+	std::unordered_set<std::string> sdfMeshNames;
+	for (MeshComponent* meshComponent : world->GetAllComponentsOfClass<MeshComponent>())
+	{
+		if (meshComponent->IsMeshValid() && (meshComponent->bUseSDF || renderSettings.bDebugSDFScene))
+		{
+			sdfMeshNames.insert(meshComponent->GetMeshName());
+		}
+	}
+
+	MeshSDFBakeSettings settings;
+	settings.resolution = renderSettings.meshSDFResolution;
+
+	for (const std::string& meshName : sdfMeshNames)
+	{
+		Mesh& mesh = MeshRepository::Get().meshMap.at(meshName);
+		if (mesh.GetSDFTexture())
+		{
+			continue;
+		}
+
+		MeshSDFBakeStats stats;
+		MeshSDFBaker::BakeMesh(mesh, settings, &stats);
+
+		// Uploaded on the copy queue like the other textures
+		mesh.GetSDFTexture()->CreateTexture(d3d12RHI);
+
+		char text[256];
+		sprintf_s(text, "MeshSDF %s: %u^3, %u triangles, %u exact and %u coarse bricks, bvh %.2f ms, sign %.2f ms, distance %.2f ms\n",
+			meshName.c_str(), settings.resolution, stats.triangleCount, stats.exactBrickCount, stats.coarseBrickCount,
+			stats.buildMs, stats.signMs, stats.distanceMs);
+		TLogger::LogToOutput(text);
+	}
+}
+
 void Render::CreateInputLayouts()
 {
 	// DefaultInputLayout
@@ -311,6 +423,16 @@ void Render::CreateInputLayouts()
 
 	inputLayoutManager.AddInputLayout("DefaultInputLayout", DefaultInputLayout);
 
+	// CompactInputLayout, matches CompactVertex
+	std::vector<D3D12_INPUT_ELEMENT_DESC>  CompactInputLayout =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R8G8B8A8_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+
+	inputLayoutManager.AddInputLayout("CompactInputLayout", CompactInputLayout);
+
 
 	// PositionColorInputLayout
 	std::vector<D3D12_INPUT_ELEMENT_DESC>  PositionColorInputLayout =
@@ -389,6 +511,18 @@ void Render::CreateGlobalShaders()
 		postProcessShader = std::make_unique<Shader>(shaderInfo, d3d12RHI);
 	}
 
+	// Depth only
+	{
+		ShaderInfo shaderInfo;
+		shaderInfo.shaderName = "ShadowDepth";
+		shaderInfo.fileName = "ShadowDepth";
+		shaderInfo.bCreateVS = true;
+		shadowDepthShader = std::make_unique<Shader>(shaderInfo, d3d12RHI);
+
+		shaderInfo.shaderDefines.SetDefine("COMPACT_VERTEX", "1");
+		shadowDepthCompactShader = std::make_unique<Shader>(shaderInfo, d3d12RHI);
+	}
+
 	// Compute Shader
 	{
 		ShaderInfo shaderInfo;
@@ -444,6 +578,14 @@ void Render::CreateGlobalShaders()
 		temporalAccumShader = std::make_unique<Shader>(shaderInfo, d3d12RHI);
 	}
 
+	{
+		ShaderInfo shaderInfo;
+		shaderInfo.shaderName = "SVGFTemporalAccumCS";
+		shaderInfo.fileName = "SVGFTemporalAccumCS";
+		shaderInfo.bCreateCS = true;
+		SVGFTemporalAccumShader = std::make_unique<Shader>(shaderInfo, d3d12RHI);
+	}
+
 	{
 		ShaderInfo shaderInfo;
 		shaderInfo.shaderName = "VarianceCS";
@@ -566,6 +708,47 @@ void Render::CreateGlobalPSO()
 
 		graphicsPSOManager->TryCreatePSO(postProcessPSODescriptor);
 	}
+
+	// ShadowDepth
+	{
+		auto rasterizer = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+		// Meshes are not always closed, both sides cast
+		rasterizer.CullMode = D3D12_CULL_MODE_NONE;
+		rasterizer.DepthBias = SHADOW_DEPTH_BIAS;
+		rasterizer.SlopeScaledDepthBias = SHADOW_SLOPE_SCALED_DEPTH_BIAS;
+		// Casters in front of the near plane are flattened onto it instead of clipped
+		rasterizer.DepthClipEnable = false;
+
+		shadowDepthPSODescriptor.inputLayoutName = std::string("DefaultInputLayout");
+		shadowDepthPSODescriptor.shader = shadowDepthShader.get();
+		shadowDepthPSODescriptor.rasterizerDesc = rasterizer;
+		shadowDepthPSODescriptor.RTVFormats[0] = DXGI_FORMAT_UNKNOWN;
+		shadowDepthPSODescriptor.numRenderTargets = 0;
+		shadowDepthPSODescriptor.depthStencilFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
+
+		graphicsPSOManager->TryCreatePSO(shadowDepthPSODescriptor);
+
+		shadowDepthCompactPSODescriptor = shadowDepthPSODescriptor;
+		shadowDepthCompactPSODescriptor.inputLayoutName = std::string("CompactInputLayout");
+		shadowDepthCompactPSODescriptor.shader = shadowDepthCompactShader.get();
+
+		graphicsPSOManager->TryCreatePSO(shadowDepthCompactPSODescriptor);
+
+		// Point and spot lights have a perspective projection, their casters are clipped at the near plane
+		rasterizer.DepthBias = LOCAL_SHADOW_DEPTH_BIAS;
+		rasterizer.SlopeScaledDepthBias = LOCAL_SHADOW_SLOPE_SCALED_DEPTH_BIAS;
+		rasterizer.DepthClipEnable = true;
+
+		localShadowDepthPSODescriptor = shadowDepthPSODescriptor;
+		localShadowDepthPSODescriptor.rasterizerDesc = rasterizer;
+
+		graphicsPSOManager->TryCreatePSO(localShadowDepthPSODescriptor);
+
+		localShadowDepthCompactPSODescriptor = shadowDepthCompactPSODescriptor;
+		localShadowDepthCompactPSODescriptor.rasterizerDesc = rasterizer;
+
+		graphicsPSOManager->TryCreatePSO(localShadowDepthCompactPSODescriptor);
+	}
 }
 
 void Render::CreateComputePSO()
@@ -600,7 +783,11 @@ void Render::CreateComputePSO()
 	temporalAccumPSODescriptor.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
 	computePSOManager->TryCreatePSO(temporalAccumPSODescriptor);
 
-	// SVFG
+	// SVGF
+	SVGFTemporalAccumPSODescriptor.shader = SVGFTemporalAccumShader.get();
+	SVGFTemporalAccumPSODescriptor.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+	computePSOManager->TryCreatePSO(SVGFTemporalAccumPSODescriptor);
+
 	variancePSODescriptor.shader = varianceShader.get();
 	variancePSODescriptor.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
 	computePSOManager->TryCreatePSO(variancePSODescriptor);
@@ -612,13 +799,56 @@ void Render::CreateComputePSO()
 
 void Render::CreateComputeShaderResource()
 {
+	TextureInfo textureInfo;
+	textureInfo.textureType = ETextureType::TEXTURE_2D;
+	textureInfo.dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	textureInfo.width = windowWidth;
+	textureInfo.height = windowHeight;
+	textureInfo.depth = 1;
+	textureInfo.arraySize = 1;
+	textureInfo.mipCount = 1;
+	textureInfo.InitState = D3D12_RESOURCE_STATE_COMMON;
+
+	// SVGF, eight screen sized textures nobody reads while it is off
+	if (renderSettings.bEnableSVGF)
+	{
+		// Unit normals, a depth compared within SVGF_REPROJECT_DEPTH_TOLERANCE, a history length of at most
+		// SVGF_MAX_HISTORY_LENGTH and the luminance moments of the lit scene fit in half floats. The second moment would
+		// only overflow past a luminance of 256.
+		textureInfo.format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+		for (int i = 0; i < 2; i++)
+		{
+			svgfSurfaceTextures[i] = d3d12RHI->CreateTexture(textureInfo, TexCreate_SRV | TexCreate_UAV);
+			svgfMomentsTextures[i] = d3d12RHI->CreateTexture(textureInfo, TexCreate_SRV | TexCreate_UAV);
+		}
 
+		textureInfo.format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+		for (int i = 0; i < 2; i++)
+		{
+			svgfFilterTextures[i] = d3d12RHI->CreateTexture(textureInfo, TexCreate_SRV | TexCreate_UAV);
+		}
+		svgfColorHistoryTexture = d3d12RHI->CreateTexture(textureInfo, TexCreate_SRV | TexCreate_UAV);
+		svgfOutputTexture = d3d12RHI->CreateTexture(textureInfo, TexCreate_SRV | TexCreate_UAV);
+	}
+
+	// The new history holds nothing yet
+	bSVGFHistoryValid = false;
+}
+
+void Render::RenderFrame(const RenderSnapshot& inSnapshot, const GameTimer& gt)
+{
+	snapshot = &inSnapshot;
+
+	Draw(gt);
+	EndFrame();
+
+	snapshot = nullptr;
 }
 
 void Render::Draw(const GameTimer& gt)
 {
-	d3d12RHI->ResetCommandAllocator();
-	d3d12RHI->ResetCommandList();
+	// Only waits when the GPU is FRAME_RESOURCE_COUNT frames behind
+	d3d12RHI->BeginFrame();
 
 	SetDescriptorHeaps();
 
@@ -631,15 +861,23 @@ void Render::Draw(const GameTimer& gt)
 	}
 
 	GatherAllMeshBatchs();
+	UpdateTextureStreaming();
+	UpdateLocalShadows();
 	UpdateLightData();
+	ShadowPass();
+	LocalShadowPass();
 	BasePass();
  	PrimitivesPass();
 	DeferredLightingPass();
+	IntegratePass();
+	SVGFTemporalAccumPass();
+	SVGFVariancePass();
+	SVGFSpatFilterPass();
+	TemporalAccumPass();
  	PostProcessPass();
 
 	d3d12RHI->ExecuteCommandLists();
 	d3d12RHI->Present();
-	d3d12RHI->FlushCommandQueue();
 }
 
 void Render::EndFrame()
@@ -657,7 +895,7 @@ void Render::SetDescriptorHeaps()
 
 void Render::GetSkyInfo()
 {
-	auto hdrSkyActors = world->GetAllActorsOfClass<HDRSkyActor>();
+	const auto& hdrSkyActors = world->GetAllActorsOfClass<HDRSkyActor>();
 
 	if (hdrSkyActors.size() > 0)
 	{
@@ -1165,91 +1403,130 @@ void Render::GatherAllMeshBatchs()
 {
 	meshBatchs.clear();
 
-	// Get all mesh components in world
-	auto actors = world->GetActors();
-	std::vector<MeshComponent*> allMeshComponents;
+	// Calculate BoundingFrustum in view space
+	TMatrix ViewToWorld = snapshot->camera.view.Invert();
 
-	for (auto actor : actors)
-	{
-		auto Light = dynamic_cast<LightActor*>(actor);
-		if (Light && !Light->IsDrawMesh())
-		{
-			continue;
-		}
+	BoundingFrustum ViewSpaceFrustum;
+	BoundingFrustum::CreateFromMatrix(ViewSpaceFrustum, snapshot->camera.proj);
+
+	// Cull on the job system, every mesh writes its own flag
+	const auto& meshes = snapshot->meshes;
+	meshVisibility.resize(meshes.size());
 
-		auto meshComponents = actor->GetComponentsOfClass<MeshComponent>();
-		for (auto meshComponent : meshComponents)
+	JobSystem::Get().ParallelFor("FrustumCulling", (uint32_t)meshes.size(), CULLING_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
 		{
-			if (meshComponent->IsMeshValid())
+			for (uint32_t i = begin; i < end; i++)
 			{
-				allMeshComponents.push_back(meshComponent);
+				const MeshRenderData& meshData = meshes[i];
+				if (!meshData.bInCameraFrustum)
+				{
+					meshVisibility[i] = 0;
+					continue;
+				}
+
+				if (!bEnableFrustumCulling || !meshData.bHasBoundingBox)
+				{
+					meshVisibility[i] = 1;
+					continue;
+				}
+
+				TMatrix ViewToLocal = ViewToWorld * meshData.invWorldMatrix;
+
+				// Transform the frustum from view space to the object's local space.
+				BoundingFrustum LocalSpaceFrustum;
+
+				// Note: BoundingFrustum::Transform( BoundingFrustum& Out, FXMMATRIX M) cannot contain a scale transform.
+				// Ref: https://docs.microsoft.com/en-us/windows/win32/api/directxcollision/nf-directxcollision-boundingfrustum-transform
+				// So it will have problems when actor has scale transform !!!
+				// TODO: fix it
+				ViewSpaceFrustum.Transform(LocalSpaceFrustum, ViewToLocal);
+
+				meshVisibility[i] = LocalSpaceFrustum.Contains(meshData.localBoundingBox.GetD3DBox()) != DirectX::DISJOINT;
 			}
+		});
+
+	// Generate MeshBatchs
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		if (!meshVisibility[i])
+		{
+			continue;
 		}
+
+		const MeshRenderData& meshData = meshes[i];
+		const Mesh& mesh = MeshRepository::Get().meshMap.at(meshData.meshName);
+
+		MeshBatch meshBatch;
+		meshBatch.meshName = meshData.meshName;
+		meshBatch.inputLayoutName = mesh.GetInputLayoutName();
+		meshBatch.objConstantBuffer = CreateObjectConstantBuffer(meshData);
+
+		meshBatch.meshData = &meshData;
+		meshBatch.bUseSDF = meshData.bUseSDF;
+
+		//Add to list
+		meshBatchs.emplace_back(meshBatch);
 	}
+}
 
-	// Calculate BoundingFrustum in view space
-	CameraComponent* cameraComponent = world->GetCameraComponent();
-	TMatrix ViewToWorld = cameraComponent->GetView().Invert();
+ConstantBufferRef Render::CreateObjectConstantBuffer(const MeshRenderData& meshData)
+{
+	const Mesh& mesh = MeshRepository::Get().meshMap.at(meshData.meshName);
 
-	BoundingFrustum ViewSpaceFrustum;
-	BoundingFrustum::CreateFromMatrix(ViewSpaceFrustum, cameraComponent->GetProj());
+	ObjectConstants objConst;
+	objConst.World = meshData.worldMatrix.Transpose();
+	objConst.PrevWorld = meshData.prevWorldMatrix.Transpose();
+	objConst.TexTransform = meshData.texTransform.Transpose();
+	if (mesh.IsCompactVertex())
+	{
+		objConst.PositionQuantizeMin = mesh.boundingBox.boxMin;
+		objConst.PositionQuantizeScale = VertexCompression::GetPositionScale(mesh.boundingBox);
+	}
 
+	return d3d12RHI->CreateConstantBuffer(&objConst, sizeof(objConst));
+}
 
-	std::vector<MeshComponent*> MeshComponentsAfterCulling;
-	for (auto meshComponent : allMeshComponents)
+void Render::UpdateTextureStreaming()
+{
+	if (!textureStreamer)
 	{
-		TMatrix WorldToLocal = meshComponent->GetWorldTransform().GetTransformMatrix().Invert();
-		TMatrix ViewToLocal = ViewToWorld * WorldToLocal;
+		return;
+	}
 
-		// Transform the frustum from view space to the object's local space.
-		BoundingFrustum LocalSpaceFrustum;
+	const CameraRenderData& camera = snapshot->camera;
 
-		// Note: BoundingFrustum::Transform( BoundingFrustum& Out, FXMMATRIX M) cannot contain a scale transform.
-		// Ref: https://docs.microsoft.com/en-us/windows/win32/api/directxcollision/nf-directxcollision-boundingfrustum-transform
-		// So it will have problems when actor has scale transform !!!
-		// TODO: fix it
-		ViewSpaceFrustum.Transform(LocalSpaceFrustum, ViewToLocal);
+	// Pixels covered by one world unit at distance one
+	float screenScale = windowHeight / (2.0f * std::tan(camera.fovY * 0.5f));
 
-		TBoundingBox BoundingBox;
-		if (bEnableFrustumCulling && meshComponent->GetLocalBoundingBox(BoundingBox))
-		{
-			if (LocalSpaceFrustum.Contains(BoundingBox.GetD3DBox()) != DirectX::DISJOINT)
-			{
-				MeshComponentsAfterCulling.push_back(meshComponent);
-			}
-		}
-		else
+	for (const MeshBatch& meshBatch : meshBatchs)
+	{
+		const MeshRenderData& meshData = *meshBatch.meshData;
+		if (!meshData.bHasBoundingBox)
 		{
-			MeshComponentsAfterCulling.push_back(meshComponent);
+			continue;
 		}
-	}
-
-	// Generate MeshBatchs
-	for (auto meshComponent : MeshComponentsAfterCulling)
-	{
-		std::string meshName = meshComponent->GetMeshName();
-
-		MeshBatch meshBatch;
-		meshBatch.meshName = meshName;
-		meshBatch.inputLayoutName = MeshRepository::Get().meshMap.at(meshName).GetInputLayoutName();
 
-		//Create Object ConstantBuffer		
-		TMatrix World = meshComponent->GetWorldTransform().GetTransformMatrix();
-		TMatrix PrevWorld = meshComponent->GetPrevWorldTransform().GetTransformMatrix();
-		TMatrix TexTransform = meshComponent->TexTransform;
+		const TBoundingBox& boundingBox = meshData.localBoundingBox;
 
-		ObjectConstants objConst;
-		objConst.World = World.Transpose();
-		objConst.PrevWorld = PrevWorld.Transpose();
-		objConst.TexTransform = TexTransform.Transpose();
-		meshBatch.objConstantBuffer = d3d12RHI->CreateConstantBuffer(&objConst, sizeof(objConst));
+		// Project the bounding sphere of the mesh
+		TMatrix worldMatrix = meshData.worldMatrix;
+		float maxScaleSquared = (std::max)({
+			TVector3(worldMatrix._11, worldMatrix._12, worldMatrix._13).LengthSquared(),
+			TVector3(worldMatrix._21, worldMatrix._22, worldMatrix._23).LengthSquared(),
+			TVector3(worldMatrix._31, worldMatrix._32, worldMatrix._33).LengthSquared() });
+		float radius = boundingBox.GetExtend().Length() * std::sqrt(maxScaleSquared);
 
-		meshBatch.meshComponent = meshComponent;
-		meshBatch.bUseSDF = meshComponent->bUseSDF;
+		TVector3 center = worldMatrix.Transform(boundingBox.GetCenter());
+		float distance = (std::max)((center - camera.location).Length() - radius, camera.nearZ);
+		float screenSize = 2.0f * radius * screenScale / distance;
 
-		//Add to list
-		meshBatchs.emplace_back(meshBatch);
+		for (const auto& Pair : meshData.materialInstance->parameters.textureMap)
+		{
+			textureStreamer->RequestScreenSize(Pair.second, screenSize, frameCount);
+		}
 	}
+
+	textureStreamer->Update(frameCount);
 }
 
 TMatrix Render::TextureTransform()
@@ -1267,54 +1544,43 @@ void Render::UpdateLightData()
 {
 	std::vector<LightShaderParameters> lightShaderParametersArray;
 
-	auto Lights = world->GetAllActorsOfClass<LightActor>();
-
-	for (UINT LightIdx = 0; LightIdx < Lights.size(); LightIdx++)
+	for (size_t i = 0; i < snapshot->lights.size(); i++)
 	{
-		auto Light = Lights[LightIdx];
-
-		if (Light->GetType() == ELightType::DirectionalLight)
+		const LightRenderData& light = snapshot->lights[i];
+		if (light.lightType == ELightType::DirectionalLight)
 		{
-			auto DirectionalLight = dynamic_cast<DirectionalLightActor*>(Light);
-			assert(DirectionalLight);
-
 			LightShaderParameters lightShaderParameter;
-			lightShaderParameter.color = DirectionalLight->GetLightColor();
-			lightShaderParameter.intensity = DirectionalLight->GetLightIntensity();
-			lightShaderParameter.position = DirectionalLight->GetActorLocation();
-			lightShaderParameter.direction = DirectionalLight->GetLightDirection();
+			lightShaderParameter.color = light.color;
+			lightShaderParameter.intensity = light.intensity;
+			lightShaderParameter.position = light.position;
+			lightShaderParameter.direction = light.direction;
 			lightShaderParameter.lightType = ELightType::DirectionalLight;
 
 			lightShaderParametersArray.push_back(lightShaderParameter);
 		}
-		else if (Light->GetType() == ELightType::PointLight)
+		else if (light.lightType == ELightType::PointLight)
 		{
-			auto PointLight = dynamic_cast<PointLightActor*>(Light);
-			assert(PointLight);
-
 			LightShaderParameters lightShaderParameter;
-			lightShaderParameter.color = PointLight->GetLightColor();
-			lightShaderParameter.intensity = PointLight->GetLightIntensity();
-			lightShaderParameter.position = PointLight->GetActorLocation();
-			lightShaderParameter.range = PointLight->GetAttenuationRange();
+			lightShaderParameter.color = light.color;
+			lightShaderParameter.intensity = light.intensity;
+			lightShaderParameter.position = light.position;
+			lightShaderParameter.range = light.range;
 			lightShaderParameter.lightType = ELightType::PointLight;
+			lightShaderParameter.shadowMapIdx = localShadowFaceIndices[i];
 
 			lightShaderParametersArray.push_back(lightShaderParameter);
 		}
-		else if (Light->GetType() == ELightType::SpotLight)
+		else if (light.lightType == ELightType::SpotLight)
 		{
-			auto SpotLight = dynamic_cast<SpotLightActor*>(Light);
-			assert(SpotLight);
-
 			LightShaderParameters lightShaderParameter;
-			lightShaderParameter.color = SpotLight->GetLightColor();
-			lightShaderParameter.intensity = SpotLight->GetLightIntensity();
-			lightShaderParameter.position = SpotLight->GetActorLocation();
-			lightShaderParameter.range = SpotLight->GetAttenuationRange();
-			lightShaderParameter.direction = SpotLight->GetLightDirection();
-
-			float ClampedInnerConeAngle = std::clamp(SpotLight->GetInnerConeAngle(), 0.0f, 89.0f);
-			float ClampedOuterConeAngle = std::clamp(SpotLight->GetOuterConeAngle(), ClampedInnerConeAngle + 0.001f, 89.0f + 0.001f);
+			lightShaderParameter.color = light.color;
+			lightShaderParameter.intensity = light.intensity;
+			lightShaderParameter.position = light.position;
+			lightShaderParameter.range = light.range;
+			lightShaderParameter.direction = light.direction;
+
+			float ClampedInnerConeAngle = std::clamp(light.innerConeAngle, 0.0f, 89.0f);
+			float ClampedOuterConeAngle = std::clamp(light.outerConeAngle, ClampedInnerConeAngle + 0.001f, 89.0f + 0.001f);
 			ClampedInnerConeAngle *= (TMath::Pi / 180.0f);
 			ClampedOuterConeAngle *= (TMath::Pi / 180.0f);
 			float CosInnerCone = cos(ClampedInnerConeAngle);
@@ -1322,8 +1588,9 @@ void Render::UpdateLightData()
 			float InvCosConeDifference = 1.0f / (CosInnerCone - CosOuterCone);
 
 			lightShaderParameter.spotAngles = TVector2(CosOuterCone, InvCosConeDifference);
-			lightShaderParameter.spotRadius = SpotLight->GetBottomRadius();
+			lightShaderParameter.spotRadius = light.bottomRadius;
 			lightShaderParameter.lightType = ELightType::SpotLight;
+			lightShaderParameter.shadowMapIdx = localShadowFaceIndices[i];
 
 			lightShaderParametersArray.push_back(lightShaderParameter);
 		}
@@ -1368,25 +1635,24 @@ void Render::UpdateLightData()
 
 void Render::UpdateBasePassCB()
 {
-	CameraComponent* cameraComponent = world->GetCameraComponent();
+	const CameraRenderData& camera = snapshot->camera;
 
-	TMatrix View = cameraComponent->GetView();
-	TMatrix Proj = cameraComponent->GetProj();
+	TMatrix View = camera.view;
+	TMatrix Proj = camera.proj;
 
+	TVector2 Jitter(0.0f, 0.0f);
 	if (renderSettings.bEnableTAA)
 	{
-		UINT SampleIdx = frameCount % TAA_SAMPLE_COUNT;
-		double JitterX = Halton_2[SampleIdx] / (double)windowWidth;
-		double JitterY = Halton_3[SampleIdx] / (double)windowHeight;
-		Proj(2, 0) += (float)JitterX;
-		Proj(2, 1) += (float)JitterY;
+		Jitter = TemporalAA::GetJitter(frameCount, windowWidth, windowHeight);
+		Proj(2, 0) += Jitter.x;
+		Proj(2, 1) += Jitter.y;
 	}
 
 	TMatrix ViewProj = View * Proj;
 	TMatrix InvView = View.Invert();
 	TMatrix InvProj = Proj.Invert();
 	TMatrix InvViewProj = ViewProj.Invert();
-	TMatrix PrevViewProj = cameraComponent->GetPrevViewProj();
+	TMatrix PrevViewProj = camera.prevViewProj;
 
 	PassConstants BasePassCB;
 	BasePassCB.View = View.Transpose();
@@ -1396,11 +1662,12 @@ void Render::UpdateBasePassCB()
 	BasePassCB.InvProj = InvProj.Transpose();
 	BasePassCB.InvViewProj = InvViewProj.Transpose();
 	BasePassCB.PrevViewProj = PrevViewProj.Transpose();
-	BasePassCB.EyePosW = cameraComponent->GetWorldLocation();
+	BasePassCB.EyePosW = camera.location;
 	BasePassCB.RenderTargetSize = TVector2((float)windowWidth, (float)windowHeight);
 	BasePassCB.InvRenderTargetSize = TVector2(1.0f / windowWidth, 1.0f / windowHeight);
-	BasePassCB.NearZ = cameraComponent->GetNearZ();
-	BasePassCB.FarZ = cameraComponent->GetFarZ();
+	BasePassCB.NearZ = camera.nearZ;
+	BasePassCB.FarZ = camera.farZ;
+	BasePassCB.Jitter = Jitter;
 
 	basePassCBRef = d3d12RHI->CreateConstantBuffer(&BasePassCB, sizeof(BasePassCB));
 }
@@ -1415,8 +1682,25 @@ void Render::GetBasePassMeshCommandMap()
 		MeshCommand meshCommand;
 		meshCommand.meshName = meshBatch.meshName;
 
-		auto materialInstance = meshBatch.meshComponent->GetMaterialInstance();
-		meshCommand.renderState = materialInstance->material->renderState;
+		auto materialInstance = meshBatch.meshData->materialInstance;
+		Material* material = materialInstance->material;
+		meshCommand.renderState = material->renderState;
+
+		// Bindless materials carry texture indices in the constant buffer instead of SRV parameters
+		const bool bBindless = renderSettings.bEnableBindless && !material->bindlessTextureSlots.empty();
+		if (bBindless)
+		{
+			// Indices change when a texture is replaced, e.g. by streaming
+			bool bIndicesChanged = materialInstance->UpdateTextureIndices([this](const std::string& textureName)
+				{
+					return GetBindlessTextureIndex(textureName);
+				});
+
+			if (bIndicesChanged)
+			{
+				materialInstance->materialConstantBuffer = nullptr;
+			}
+		}
 
 		// Get material constanct buffer
 		if (materialInstance->materialConstantBuffer == nullptr)
@@ -1428,21 +1712,24 @@ void Render::GetBasePassMeshCommandMap()
 		meshCommand.SetShaderParameter("cbMaterialData", materialInstance->materialConstantBuffer);
 		meshCommand.SetShaderParameter("cbPass", basePassCBRef);
 		meshCommand.SetShaderParameter("cbPerObject", meshBatch.objConstantBuffer);
-		for (const auto& Pair : materialInstance->parameters.textureMap)
+		if (!bBindless)
 		{
-			std::string TextureName = Pair.second;
-			ShaderResourceView* SRV = nullptr;
-
-			if (TextureName == skyCubeTextureName)
+			for (const auto& Pair : materialInstance->parameters.textureMap)
 			{
-				SRV = IBLEnvironmentMap->GetRTCube()->GetSRV();
-			}
-			else
-			{
-				SRV = TextureRepository::Get().textureMap[TextureName]->GetD3DTexture()->GetSRV();
-			}
+				std::string TextureName = Pair.second;
+				ShaderResourceView* SRV = nullptr;
 
-			meshCommand.SetShaderParameter(Pair.first, SRV);
+				if (TextureName == skyCubeTextureName)
+				{
+					SRV = IBLEnvironmentMap->GetRTCube()->GetSRV();
+				}
+				else
+				{
+					SRV = TextureRepository::Get().textureMap[TextureName]->GetD3DTexture()->GetSRV();
+				}
+
+				meshCommand.SetShaderParameter(Pair.first, SRV);
+			}
 		}
 
 		// Get PSO descriptor of this mesh
@@ -1451,9 +1738,16 @@ void Render::GetBasePassMeshCommandMap()
 		Descriptor.rasterizerDesc.CullMode = meshCommand.renderState.cullMode;
 		Descriptor.depthStencilDesc.DepthFunc = meshCommand.renderState.depthFunc;
 
-		Material* material = materialInstance->material;
-		ShaderDefines EmptyShaderDefines;
-		Descriptor.shader = material->GetShader(EmptyShaderDefines, d3d12RHI);
+		ShaderDefines MeshShaderDefines;
+		if (meshBatch.inputLayoutName == "CompactInputLayout")
+		{
+			MeshShaderDefines.SetDefine("COMPACT_VERTEX", "1");
+		}
+		if (bBindless)
+		{
+			MeshShaderDefines.SetDefine("BINDLESS", "1");
+		}
+		Descriptor.shader = material->GetShader(MeshShaderDefines, d3d12RHI);
 
 		// GBuffer PSO common settings
 		Descriptor.RTVFormats[0] = GBufferBaseColor->GetFormat();
@@ -1475,6 +1769,413 @@ void Render::GetBasePassMeshCommandMap()
 	}
 }
 
+uint32_t Render::GetBindlessTextureIndex(const std::string& textureName)
+{
+	// Same substitution as the SRV path, the sky reads the captured cube instead of the equirectangular source.
+	// Slots without a texture ask for "", which must still get NullTex in a scene without a sky.
+	if (!skyCubeTextureName.empty() && textureName == skyCubeTextureName && IBLEnvironmentMap)
+	{
+		return IBLEnvironmentMap->GetRTCube()->GetSRV()->GetBindlessIndex();
+	}
+
+	auto& textureMap = TextureRepository::Get().textureMap;
+
+	auto Iter = textureMap.find(textureName);
+	if (Iter == textureMap.end() || Iter->second->GetD3DTexture() == nullptr)
+	{
+		Iter = textureMap.find("NullTex");
+	}
+
+	return Iter->second->GetD3DTexture()->GetSRV()->GetBindlessIndex();
+}
+
+void Render::UpdateCascadedShadowCB(bool bEnableShadows)
+{
+	CascadedShadowConstants shadowConstants;
+
+	if (bEnableShadows)
+	{
+		const CascadedShadowRenderData& cascadedShadow = snapshot->cascadedShadow;
+
+		const float tileScaleU = 1.0f / CSM_ATLAS_COLUMNS;
+		const float tileScaleV = 1.0f / CSM_ATLAS_ROWS;
+
+		for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+		{
+			const ShadowCascade& cascade = cascadedShadow.cascades[i];
+
+			// From NDC to the uv of the tile
+			float column = (float)(i % CSM_ATLAS_COLUMNS);
+			float row = (float)(i / CSM_ATLAS_COLUMNS);
+			TMatrix tileTransform(
+				0.5f * tileScaleU, 0.0f, 0.0f, 0.0f,
+				0.0f, -0.5f * tileScaleV, 0.0f, 0.0f,
+				0.0f, 0.0f, 1.0f, 0.0f,
+				(column + 0.5f) * tileScaleU, (row + 0.5f) * tileScaleV, 0.0f, 1.0f);
+
+			TMatrix shadowTransform = cascade.viewProj * tileTransform;
+			shadowConstants.shadowTransforms[i] = shadowTransform.Transpose();
+
+			float filterRadius = cascade.sphereRadius - cascade.texelSize * CSM_FILTER_MARGIN_TEXELS;
+			shadowConstants.cascadeSpheres[i] = TVector4(cascade.sphereCenter.x, cascade.sphereCenter.y, cascade.sphereCenter.z, filterRadius);
+			shadowConstants.cascadeTexelSizes[i] = TVector4(cascade.texelSize, 0.0f, 0.0f, 0.0f);
+		}
+
+		shadowConstants.shadowMapInvSize = TVector2(1.0f / (CSM_CASCADE_RESOLUTION * CSM_ATLAS_COLUMNS), 1.0f / (CSM_CASCADE_RESOLUTION * CSM_ATLAS_ROWS));
+		shadowConstants.cascadeCount = CSM_CASCADE_COUNT;
+	}
+
+	cascadedShadowCBRef = d3d12RHI->CreateConstantBuffer(&shadowConstants, sizeof(shadowConstants));
+}
+
+void Render::ShadowPass()
+{
+	const CascadedShadowRenderData& cascadedShadow = snapshot->cascadedShadow;
+	const bool bEnableShadows = renderSettings.bEnableShadows && cascadedShadow.bEnable;
+
+	UpdateCascadedShadowCB(bEnableShadows);
+
+	// Shared with LocalShadowPass
+	shadowObjConstantBuffers.assign(snapshot->meshes.size(), nullptr);
+
+	if (!bEnableShadows)
+	{
+		return;
+	}
+
+	for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+	{
+		const ShadowCascade& cascade = cascadedShadow.cascades[i];
+
+		PassConstants cascadePassCB;
+		cascadePassCB.View = cascade.view.Transpose();
+		cascadePassCB.Proj = cascade.proj.Transpose();
+		cascadePassCB.ViewProj = cascade.viewProj.Transpose();
+		cascadePassCB.EyePosW = cascade.sphereCenter;
+		cascadePassCB.RenderTargetSize = TVector2((float)CSM_CASCADE_RESOLUTION, (float)CSM_CASCADE_RESOLUTION);
+		cascadePassCB.InvRenderTargetSize = TVector2(1.0f / CSM_CASCADE_RESOLUTION, 1.0f / CSM_CASCADE_RESOLUTION);
+
+		cascadeShadowPassCBRefs[i] = d3d12RHI->CreateConstantBuffer(&cascadePassCB, sizeof(cascadePassCB));
+	}
+
+	// Static casters are only drawn again when their cascade moved or a static mesh changed
+	bool bCacheUpdated = false;
+	for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+	{
+		const ShadowCascade& cascade = cascadedShadow.cascades[i];
+		if (bCascadeCacheValid[i] && cachedCascadeRevisions[i] == cascade.revision && cachedStaticMeshVersions[i] == cascadedShadow.staticMeshVersion)
+		{
+			continue;
+		}
+
+		if (!bCacheUpdated)
+		{
+			d3d12RHI->TransitionResource(cascadeStaticShadowMap->GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
+			bCacheUpdated = true;
+		}
+
+		DrawShadowCasters(cascadeStaticShadowMap.get(), i, true);
+
+		bCascadeCacheValid[i] = true;
+		cachedCascadeRevisions[i] = cascade.revision;
+		cachedStaticMeshVersions[i] = cascadedShadow.staticMeshVersion;
+	}
+
+	bool bHasDynamicCasters = false;
+	for (int i = 0; i < CSM_CASCADE_COUNT && !bHasDynamicCasters; i++)
+	{
+		for (uint32_t meshIndex : cascadedShadow.casters[i])
+		{
+			if (!snapshot->meshes[meshIndex].bStatic)
+			{
+				bHasDynamicCasters = true;
+				break;
+			}
+		}
+	}
+
+	// The dynamic casters are drawn over a copy of the cache, the copy is skipped while the shadow map already matches it
+	if (bCacheUpdated || bHasDynamicCasters || bShadowMapHasDynamicCasters)
+	{
+		d3d12RHI->TransitionResource(cascadeStaticShadowMap->GetResource(), D3D12_RESOURCE_STATE_COPY_SOURCE);
+		d3d12RHI->TransitionResource(cascadeShadowMap->GetResource(), D3D12_RESOURCE_STATE_COPY_DEST);
+		d3d12RHI->CopyResource(cascadeShadowMap->GetResource(), cascadeStaticShadowMap->GetResource());
+	}
+
+	if (bHasDynamicCasters)
+	{
+		d3d12RHI->TransitionResource(cascadeShadowMap->GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+		for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+		{
+			DrawShadowCasters(cascadeShadowMap.get(), i, false);
+		}
+	}
+	bShadowMapHasDynamicCasters = bHasDynamicCasters;
+
+	d3d12RHI->TransitionResource(cascadeShadowMap->GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+}
+
+void Render::DrawShadowCasters(RenderTarget2D* shadowMap, int cascadeIndex, bool bStatic)
+{
+	// The tile of the cascade, the static casters start from a cleared one
+	UINT tileX = cascadeIndex % CSM_ATLAS_COLUMNS * CSM_CASCADE_RESOLUTION;
+	UINT tileY = cascadeIndex / CSM_ATLAS_COLUMNS * CSM_CASCADE_RESOLUTION;
+	BeginShadowTile(shadowMap, tileX, tileY, CSM_CASCADE_RESOLUTION, bStatic);
+
+	const GraphicsPSODescriptor* boundDescriptor = nullptr;
+	for (uint32_t meshIndex : snapshot->cascadedShadow.casters[cascadeIndex])
+	{
+		if (snapshot->meshes[meshIndex].bStatic == bStatic)
+		{
+			DrawShadowCaster(meshIndex, cascadeShadowPassCBRefs[cascadeIndex], false, boundDescriptor);
+		}
+	}
+}
+
+void Render::BeginShadowTile(RenderTarget2D* shadowMap, UINT x, UINT y, UINT size, bool bClear)
+{
+	D3D12_VIEWPORT viewport;
+	viewport.TopLeftX = (float)x;
+	viewport.TopLeftY = (float)y;
+	viewport.Width = (float)size;
+	viewport.Height = (float)size;
+	viewport.MinDepth = 0.0f;
+	viewport.MaxDepth = 1.0f;
+
+	D3D12_RECT tileRect;
+	tileRect.left = (LONG)x;
+	tileRect.top = (LONG)y;
+	tileRect.right = (LONG)(x + size);
+	tileRect.bottom = (LONG)(y + size);
+
+	d3dCommandList->RSSetViewports(1, &viewport);
+	d3dCommandList->RSSetScissorRects(1, &tileRect);
+
+	auto dsv = shadowMap->GetDSV()->GetDescriptorHandle();
+	if (bClear)
+	{
+		d3dCommandList->ClearDepthStencilView(dsv, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 1, &tileRect);
+	}
+	d3dCommandList->OMSetRenderTargets(0, nullptr, false, &dsv);
+}
+
+void Render::DrawShadowCaster(uint32_t meshIndex, const ConstantBufferRef& passCB, bool bLocalLight, const GraphicsPSODescriptor*& boundDescriptor)
+{
+	const MeshRenderData& meshData = snapshot->meshes[meshIndex];
+	const Mesh& mesh = MeshRepository::Get().meshMap.at(meshData.meshName);
+
+	const GraphicsPSODescriptor* descriptor;
+	if (bLocalLight)
+	{
+		descriptor = mesh.IsCompactVertex() ? &localShadowDepthCompactPSODescriptor : &localShadowDepthPSODescriptor;
+	}
+	else
+	{
+		descriptor = mesh.IsCompactVertex() ? &shadowDepthCompactPSODescriptor : &shadowDepthPSODescriptor;
+	}
+
+	Shader* shader = descriptor->shader;
+	if (descriptor != boundDescriptor)
+	{
+		d3dCommandList->SetPipelineState(graphicsPSOManager->GetPSO(*descriptor));
+		d3dCommandList->SetGraphicsRootSignature(shader->rootSignature.Get());
+		boundDescriptor = descriptor;
+	}
+
+	// A mesh in several shadow maps shares its constants
+	if (shadowObjConstantBuffers[meshIndex] == nullptr)
+	{
+		shadowObjConstantBuffers[meshIndex] = CreateObjectConstantBuffer(meshData);
+	}
+
+	shader->SetParameter("cbPass", passCB);
+	shader->SetParameter("cbPerObject", shadowObjConstantBuffers[meshIndex]);
+	shader->BindParameters();
+
+	const MeshProxy& meshProxy = meshProxyMap.at(meshData.meshName);
+
+	d3d12RHI->SetVertexBuffer(meshProxy.vertexBufferRef, 0, meshProxy.vertexByteStride, meshProxy.vertexBufferByteSize);
+	d3d12RHI->SetIndexBuffer(meshProxy.indexBufferRef, 0, meshProxy.indexFormat, meshProxy.indexBufferByteSize);
+	d3dCommandList->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	auto& subMesh = meshProxy.subMeshs.at("Default");
+	d3dCommandList->DrawIndexedInstanced(subMesh.indexCount, 1, subMesh.startIndexLocation, subMesh.baseVertexLocation, 0);
+}
+
+void Render::UpdateLocalShadows()
+{
+	localShadowFaceIndices.assign(snapshot->lights.size(), -1);
+	shadowAtlasRequests.clear();
+	shadowAtlasRequestLights.clear();
+
+	if (renderSettings.bEnableShadows)
+	{
+		const CameraRenderData& camera = snapshot->camera;
+		const float tanHalfFovY = std::tan(camera.fovY * 0.5f);
+
+		for (uint32_t i = 0; i < (uint32_t)snapshot->lights.size(); i++)
+		{
+			const LightRenderData& light = snapshot->lights[i];
+			bool bLocalLight = light.lightType == ELightType::PointLight || light.lightType == ELightType::SpotLight;
+			if (!bLocalLight || !light.bCastShadows || light.shadowCasterCount == 0)
+			{
+				continue;
+			}
+
+			ShadowAtlasRequest request;
+			request.lightId = light.lightId;
+
+			if (light.lightType == ELightType::PointLight)
+			{
+				request.faceCount = 6;
+				for (uint32_t face = 0; face < request.faceCount; face++)
+				{
+					request.faceViewProjs[face] = ShadowAtlas::GetPointLightFaceViewProj(light.position, light.range, face);
+				}
+			}
+			else
+			{
+				request.faceCount = 1;
+				request.faceViewProjs[0] = ShadowAtlas::GetSpotLightViewProj(light.position, light.direction, light.range, light.outerConeAngle);
+			}
+
+			// Part of the half screen height covered by the range of the light, 1 from inside it
+			float distance = TVector3::Distance(light.position, camera.location);
+			float coverage = distance > light.range ? (std::min)(light.range / (distance * tanHalfFovY), 1.0f) : 1.0f;
+
+			request.desiredSize = coverage * light.shadowImportance * SHADOW_ATLAS_MAX_TILE_SIZE;
+			request.priority = coverage * light.shadowImportance;
+			request.contentHash = GetLocalShadowHash(request, light);
+
+			shadowAtlasRequests.push_back(request);
+			shadowAtlasRequestLights.push_back(i);
+		}
+	}
+
+	shadowAtlas.Update(shadowAtlasRequests, renderSettings.shadowAtlasFaceBudget, shadowAtlasAllocations);
+
+	std::vector<LocalShadowFaceParameters> faceParametersArray;
+	const float atlasTexelSize = 1.0f / SHADOW_ATLAS_SIZE;
+
+	for (size_t i = 0; i < shadowAtlasAllocations.size(); i++)
+	{
+		const ShadowAtlasAllocation& allocation = shadowAtlasAllocations[i];
+		if (!allocation.bDrawn)
+		{
+			continue;
+		}
+
+		localShadowFaceIndices[shadowAtlasRequestLights[i]] = (int)faceParametersArray.size();
+
+		// Point light faces are 90 degrees wide
+		const LightRenderData& light = snapshot->lights[shadowAtlasRequestLights[i]];
+		float tanHalfAngle = 1.0f;
+		if (light.lightType == ELightType::SpotLight)
+		{
+			tanHalfAngle = std::tan(std::clamp(light.outerConeAngle, 1.0f, LOCAL_SHADOW_MAX_SPOT_ANGLE) * (TMath::Pi / 180.0f));
+		}
+
+		for (uint32_t face = 0; face < allocation.faceCount; face++)
+		{
+			const ShadowAtlasTile& tile = allocation.faces[face];
+
+			// From NDC to the uv of the tile, applied before the divide by w
+			float tileScale = tile.size * atlasTexelSize;
+			TMatrix tileTransform(
+				0.5f * tileScale, 0.0f, 0.0f, 0.0f,
+				0.0f, -0.5f * tileScale, 0.0f, 0.0f,
+				0.0f, 0.0f, 1.0f, 0.0f,
+				tile.x * atlasTexelSize + 0.5f * tileScale, tile.y * atlasTexelSize + 0.5f * tileScale, 0.0f, 1.0f);
+
+			float margin = SHADOW_ATLAS_FILTER_MARGIN_TEXELS * atlasTexelSize;
+
+			LocalShadowFaceParameters faceParameters;
+			faceParameters.shadowTransform = (allocation.faceViewProjs[face] * tileTransform).Transpose();
+			faceParameters.uvBounds = TVector4(tile.x * atlasTexelSize + margin, tile.y * atlasTexelSize + margin,
+				(tile.x + tile.size) * atlasTexelSize - margin, (tile.y + tile.size) * atlasTexelSize - margin);
+			faceParameters.texelAngle = 2.0f * tanHalfAngle / tile.size;
+
+			faceParametersArray.push_back(faceParameters);
+		}
+	}
+
+	if (!faceParametersArray.empty())
+	{
+		localShadowFacesBuffer = d3d12RHI->CreateStructuredBuffer(faceParametersArray.data(),
+			(uint32_t)(sizeof(LocalShadowFaceParameters)), (uint32_t)(faceParametersArray.size()));
+	}
+	else
+	{
+		localShadowFacesBuffer = nullptr;
+	}
+}
+
+uint64_t Render::GetLocalShadowHash(const ShadowAtlasRequest& request, const LightRenderData& light) const
+{
+	// The faces cover the position, direction, range and cone of the light
+	uint64_t hashValue = xxh::xxhash_gethash(request.faceViewProjs, sizeof(TMatrix) * request.faceCount);
+
+	for (uint32_t i = light.firstShadowCaster; i < light.firstShadowCaster + light.shadowCasterCount; i++)
+	{
+		const MeshRenderData& meshData = snapshot->meshes[snapshot->localShadowCasters[i]];
+
+		hashValue ^= xxh::xxhash_gethash(&meshData.worldMatrix, sizeof(TMatrix)) + 0x9e3779b9 + (hashValue << 6) + (hashValue >> 2);
+		hashValue ^= std::hash<std::string>()(meshData.meshName) + 0x9e3779b9 + (hashValue << 6) + (hashValue >> 2);
+	}
+
+	return hashValue;
+}
+
+void Render::LocalShadowPass()
+{
+	bool bHasDraws = false;
+	for (const ShadowAtlasAllocation& allocation : shadowAtlasAllocations)
+	{
+		bHasDraws |= allocation.bDrawThisFrame;
+	}
+
+	if (bHasDraws)
+	{
+		d3d12RHI->TransitionResource(shadowAtlasMap->GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+		for (size_t i = 0; i < shadowAtlasAllocations.size(); i++)
+		{
+			const ShadowAtlasAllocation& allocation = shadowAtlasAllocations[i];
+			if (!allocation.bDrawThisFrame)
+			{
+				continue;
+			}
+
+			const LightRenderData& light = snapshot->lights[shadowAtlasRequestLights[i]];
+			for (uint32_t face = 0; face < allocation.faceCount; face++)
+			{
+				DrawLocalShadowCasters(light, allocation.faces[face], allocation.faceViewProjs[face]);
+			}
+		}
+	}
+
+	d3d12RHI->TransitionResource(shadowAtlasMap->GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+}
+
+void Render::DrawLocalShadowCasters(const LightRenderData& light, const ShadowAtlasTile& tile, const TMatrix& viewProj)
+{
+	PassConstants facePassCB;
+	facePassCB.ViewProj = viewProj.Transpose();
+	facePassCB.EyePosW = light.position;
+	facePassCB.RenderTargetSize = TVector2((float)tile.size, (float)tile.size);
+	facePassCB.InvRenderTargetSize = TVector2(1.0f / tile.size, 1.0f / tile.size);
+	ConstantBufferRef facePassCBRef = d3d12RHI->CreateConstantBuffer(&facePassCB, sizeof(facePassCB));
+
+	BeginShadowTile(shadowAtlasMap.get(), tile.x, tile.y, tile.size, true);
+
+	const GraphicsPSODescriptor* boundDescriptor = nullptr;
+	for (uint32_t i = light.firstShadowCaster; i < light.firstShadowCaster + light.shadowCasterCount; i++)
+	{
+		DrawShadowCaster(snapshot->localShadowCasters[i], facePassCBRef, true, boundDescriptor);
+	}
+}
+
 void Render::BasePass()
 {
  	UpdateBasePassCB();
@@ -1574,27 +2275,21 @@ void Render::BasePass()
 	d3d12RHI->TransitionResource(GBufferEmissive->GetTexture()->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
 }
 
-void Render::GatherLightDebugPrimitives(std::vector<Line>& outLines)
+void Render::GatherLightDebugPrimitives(DebugDrawBuffer& outDebugDraw)
 {
 	// Lights debug primitives
 	{
-		auto lights = world->GetAllActorsOfClass<LightActor>();
-		for (UINT lightIdx = 0; lightIdx < lights.size(); lightIdx++)
+		for (const LightRenderData& light : snapshot->lights)
 		{
-			auto light = lights[lightIdx];
-
-			if (!light->IsDrawDebug())
+			if (!light.bDrawDebug)
 			{
 				continue;
 			}
 
-			if (light->GetType() == ELightType::DirectionalLight)
+			if (light.lightType == ELightType::DirectionalLight)
 			{
-				auto directionalLight = dynamic_cast<DirectionalLightActor*>(light);
-				assert(directionalLight);
-
-				TVector3 direction = directionalLight->GetLightDirection();
-				TVector3 startPos = directionalLight->GetActorLocation();
+				TVector3 direction = light.direction;
+				TVector3 startPos = light.position;
 				float debugLength = 3.0f;
 				TVector3 endPos = startPos + direction * debugLength;
 
@@ -1602,18 +2297,15 @@ void Render::GatherLightDebugPrimitives(std::vector<Line>& outLines)
 				v1.Normalize();
 				TVector3 Offset = v1 * 0.5f;
 
-				outLines.push_back(Line(startPos - Offset, endPos - Offset, Color::White));
-				outLines.push_back(Line(startPos, endPos, Color::White));
-				outLines.push_back(Line(startPos + Offset, endPos + Offset, Color::White));
+				outDebugDraw.AddLine(startPos - Offset, endPos - Offset, Color::White);
+				outDebugDraw.AddLine(startPos, endPos, Color::White);
+				outDebugDraw.AddLine(startPos + Offset, endPos + Offset, Color::White);
 
 			}
-			else if (light->GetType() == ELightType::PointLight)
+			else if (light.lightType == ELightType::PointLight)
 			{
-				auto pointLight = dynamic_cast<PointLightActor*>(light);
-				assert(pointLight);
-
-				TVector3 centerPos = pointLight->GetActorLocation();
-				float radius = pointLight->GetAttenuationRange();
+				TVector3 centerPos = light.position;
+				float radius = light.range;
 				TVector3 v1 = TVector3(1.0f, 0.0f, 0.0f);
 				TVector3 v2 = TVector3(0.0f, 0.0f, 1.0f);
 				TVector3 v3 = TVector3(0.0f, 1.0f, 0.0f);
@@ -1632,7 +2324,7 @@ void Render::GatherLightDebugPrimitives(std::vector<Line>& outLines)
 					}
 					else
 					{
-						outLines.push_back(Line(lastPoint, point, Color::Yellow));
+						outDebugDraw.AddLine(lastPoint, point, Color::Yellow);
 					}
 
 					lastPoint = point;
@@ -1652,26 +2344,23 @@ void Render::GatherLightDebugPrimitives(std::vector<Line>& outLines)
 					}
 					else
 					{
-						outLines.push_back(Line(lastPoint, point, Color::Yellow));
+						outDebugDraw.AddLine(lastPoint, point, Color::Yellow);
 					}
 
 					lastPoint = point;
 				}
 
 			}
-			else if (light->GetType() == ELightType::SpotLight)
+			else if (light.lightType == ELightType::SpotLight)
 			{
-				auto spotLight = dynamic_cast<SpotLightActor*>(light);
-				assert(spotLight);
-
-				TVector3 tipPos = spotLight->GetActorLocation();
-				float height = spotLight->GetAttenuationRange();
-				TVector3 direction = spotLight->GetLightDirection();
+				TVector3 tipPos = light.position;
+				float height = light.range;
+				TVector3 direction = light.direction;
 				TVector3 directionEnd = tipPos + height * direction;
-				float bottomRadius = spotLight->GetBottomRadius();
+				float bottomRadius = light.bottomRadius;
 
 				// Direction line
-				outLines.push_back(Line(tipPos, directionEnd, Color::White));
+				outDebugDraw.AddLine(tipPos, directionEnd, Color::White);
 
 				// Slant lines
 				TVector3 v1 = direction.Cross(TVector3::Up);
@@ -1684,7 +2373,7 @@ void Render::GatherLightDebugPrimitives(std::vector<Line>& outLines)
 					float radian = deltaAngle * (TMath::Pi / 180.0f);
 					TVector3 slantPoint = directionEnd + (v1 * sin(radian) + v2 * cos(radian)) * bottomRadius;
 
-					outLines.push_back(Line(tipPos, slantPoint, Color::Yellow));
+					outDebugDraw.AddLine(tipPos, slantPoint, Color::Yellow);
 				}
 			}
 		}
@@ -1695,63 +2384,58 @@ void Render::GatherAllPrimitiveBatchs()
 {
 	psoPrimitiveBatchMap.clear();
 
-	// Points
-	{
-		// Get all points
-		std::vector<PrimitiveVertex> vertices;
-		const auto& points = world->GetPoints();
-		for (const auto& point : points)
-		{
-			vertices.push_back(PrimitiveVertex(point.point, point.color));
-		}
+	primitiveVertexRing->BeginFrame();
 
-		GatherPrimitiveBatchs(vertices, D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT);
-	}
+	lightDebugDraw.Clear();
+	GatherLightDebugPrimitives(lightDebugDraw);
 
-	// Lines
+	for (int topology = 0; topology < (int)EDebugTopology::Count; topology++)
 	{
-		// Get all lines
-		std::vector<Line> lines;
-		const auto& worldLines = world->GetLines();
-		lines.insert(lines.end(), worldLines.begin(), worldLines.end());
-
-		std::vector<Line> lightDebugLines;
-		GatherLightDebugPrimitives(lightDebugLines);
-		lines.insert(lines.end(), lightDebugLines.begin(), lightDebugLines.end());
-
-		std::vector<PrimitiveVertex> vertices;
-		for (const auto& line : lines)
+		for (int depthMode = 0; depthMode < (int)EDebugDepthMode::Count; depthMode++)
 		{
-			vertices.push_back(PrimitiveVertex(line.pointA, line.color));
-			vertices.push_back(PrimitiveVertex(line.pointB, line.color));
+			GatherPrimitiveBatch((EDebugTopology)topology, (EDebugDepthMode)depthMode);
 		}
-
-		GatherPrimitiveBatchs(vertices, D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE);
 	}
+}
 
+void Render::GatherPrimitiveBatch(EDebugTopology topology, EDebugDepthMode depthMode)
+{
+	const std::vector<PrimitiveVertex>& worldVertices = snapshot->debugDraw.GetVertices(topology, depthMode);
+	const std::vector<PrimitiveVertex>& lightVertices = lightDebugDraw.GetVertices(topology, depthMode);
 
-	// Triangles
+	const size_t vertexNum = worldVertices.size() + lightVertices.size();
+	if (vertexNum == 0)
 	{
-		// Get all triangles
-		std::vector<PrimitiveVertex> vertices;
-		const auto& Triangles = world->GetTriangles();
-		for (const auto& triangle : Triangles) {
-			vertices.push_back(PrimitiveVertex(triangle.pointA, triangle.color));
-			vertices.push_back(PrimitiveVertex(triangle.pointB, triangle.color));
-			vertices.push_back(PrimitiveVertex(triangle.pointC, triangle.color));
-		}
-
-		GatherPrimitiveBatchs(vertices, D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE);
+		return;
 	}
-}
 
-void Render::GatherPrimitiveBatchs(const std::vector<PrimitiveVertex>& vertices, D3D12_PRIMITIVE_TOPOLOGY_TYPE primitiveType)
-{
 	// Primitive PSO
 	GraphicsPSODescriptor psoDescriptor;
 	psoDescriptor.inputLayoutName = std::string("PositionColorInputLayout");
 	psoDescriptor.shader = primitiveShader.get();
-	psoDescriptor.primitiveTopologyType = primitiveType;
+
+	PrimitiveBatch primitiveBatch;
+	if (topology == EDebugTopology::Point)
+	{
+		psoDescriptor.primitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT;
+		primitiveBatch.primitiveType = D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
+	}
+	else if (topology == EDebugTopology::Line)
+	{
+		psoDescriptor.primitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE;
+		primitiveBatch.primitiveType = D3D_PRIMITIVE_TOPOLOGY_LINELIST;
+	}
+	else
+	{
+		psoDescriptor.primitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+		primitiveBatch.primitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	}
+
+	if (depthMode == EDebugDepthMode::AlwaysOnTop)
+	{
+		psoDescriptor.depthStencilDesc.DepthFunc = D3D12_COMPARISON_FUNC_ALWAYS;
+		psoDescriptor.depthStencilDesc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+	}
 
 	// GBuffer PSO common settings
 	psoDescriptor.RTVFormats[0] = GBufferBaseColor->GetFormat();
@@ -1764,45 +2448,26 @@ void Render::GatherPrimitiveBatchs(const std::vector<PrimitiveVertex>& vertices,
 	psoDescriptor.depthStencilFormat = d3d12RHI->GetViewportInfo().depthStencilFormat;
 	psoDescriptor._4xMsaaState = false; //can't use msaa in deferred rendering.
 
-	// If don't find this PSO, create new PSO and PrimitiveBatch
 	graphicsPSOManager->TryCreatePSO(psoDescriptor);
 
-	if (psoPrimitiveBatchMap.find(psoDescriptor) == psoPrimitiveBatchMap.end())
-	{
-		psoPrimitiveBatchMap.emplace(std::make_pair(psoDescriptor, PrimitiveBatch()));
-		PrimitiveBatch& primitiveBatch = psoPrimitiveBatchMap[psoDescriptor];
-
-		if (primitiveType == D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT)
-		{
-			primitiveBatch.primitiveType = D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
-		}
-		else if (primitiveType == D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE)
-		{
-			primitiveBatch.primitiveType = D3D_PRIMITIVE_TOPOLOGY_LINELIST;
-		}
-		else if (primitiveType == D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE)
-		{
-			primitiveBatch.primitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-		}
-		else
-		{
-			assert(0);
-		}
-	}
-
-	// Update vertex buffer
-	PrimitiveBatch& primitiveBatch = psoPrimitiveBatchMap[psoDescriptor];
-	primitiveBatch.currentVertexNum = (int)vertices.size();
+	// One copy per list into this frame's region of the ring, no buffer is created
+	const size_t worldBytes = worldVertices.size() * sizeof(PrimitiveVertex);
+	const size_t lightBytes = lightVertices.size() * sizeof(PrimitiveVertex);
 
-	if (primitiveBatch.currentVertexNum > 0)
+	uint8_t* mappedData = static_cast<uint8_t*>(primitiveVertexRing->Allocate((uint32_t)(worldBytes + lightBytes), sizeof(PrimitiveVertex),
+		primitiveBatch.vertexBufferAddress));
+	if (worldBytes > 0)
 	{
-		const UINT VbByteSize = (UINT)vertices.size() * sizeof(PrimitiveVertex);
-		primitiveBatch.vertexBufferRef = d3d12RHI->CreateVertexBuffer(vertices.data(), VbByteSize);
+		memcpy(mappedData, worldVertices.data(), worldBytes);
 	}
-	else
+	if (lightBytes > 0)
 	{
-		primitiveBatch.vertexBufferRef = nullptr;
+		memcpy(mappedData + worldBytes, lightVertices.data(), lightBytes);
 	}
+
+	primitiveBatch.currentVertexNum = (int)vertexNum;
+
+	psoPrimitiveBatchMap.emplace(psoDescriptor, primitiveBatch);
 }
 
 void Render::PrimitivesPass()
@@ -1856,7 +2521,7 @@ void Render::PrimitivesPass()
 			shader->BindParameters();
 
 			// Set vertex buffer
-			d3d12RHI->SetVertexBuffer(primitiveBatch.vertexBufferRef, 0, sizeof(PrimitiveVertex), primitiveBatch.currentVertexNum * sizeof(PrimitiveVertex));
+			d3d12RHI->SetVertexBuffer(primitiveBatch.vertexBufferAddress, sizeof(PrimitiveVertex), primitiveBatch.currentVertexNum * sizeof(PrimitiveVertex));
 
 			d3dCommandList->IASetPrimitiveTopology(primitiveBatch.primitiveType);
 
@@ -1915,6 +2580,26 @@ void Render::DeferredLightingPass()
 	shader->SetParameter("WorldPosGbuffer", GBufferWorldPos->GetTexture()->GetSRV());
 	shader->SetParameter("OrmGbuffer", GBufferORM->GetTexture()->GetSRV());
 	shader->SetParameter("EmissiveGbuffer", GBufferEmissive->GetTexture()->GetSRV());
+	shader->SetParameter("cbCascadedShadow", cascadedShadowCBRef);
+
+	if (renderSettings.bEnableShadows && snapshot->cascadedShadow.bEnable)
+	{
+		shader->SetParameter("CascadeShadowMap", cascadeShadowMap->GetSRV());
+	}
+	else
+	{
+		shader->SetParameter("CascadeShadowMap", texture2DNullDescriptor.get());
+	}
+
+	shader->SetParameter("ShadowAtlas", shadowAtlasMap->GetSRV());
+	if (localShadowFacesBuffer)
+	{
+		shader->SetParameter("LocalShadowFaces", localShadowFacesBuffer->GetSRV());
+	}
+	else
+	{
+		shader->SetParameter("LocalShadowFaces", structuredBufferNullDescriptor.get());
+	}
 
 	if (lightCount > 0)
 	{
@@ -1978,9 +2663,204 @@ void Render::DeferredLightingPass()
 	d3d12RHI->TransitionResource(colorTexture->GetResource(), D3D12_RESOURCE_STATE_PRESENT);
 }
 
-void Render::PostProcessPass()
+void Render::TemporalAccumPass()
+{
+	if (!renderSettings.bEnableTAA)
+	{
+		bTAAHistoryValid = false;
+		return;
+	}
+
+	d3d12RHI->TransitionResource(GetLightingOutputTexture()->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+	d3d12RHI->TransitionResource(prevColorTexture->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+	d3d12RHI->TransitionResource(resolvedColorTexture->GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+	TemporalAAConstants temporalAAConstants;
+	temporalAAConstants.historyValid = bTAAHistoryValid ? 1 : 0;
+	auto cbTemporalAA = d3d12RHI->CreateConstantBuffer(&temporalAAConstants, sizeof(temporalAAConstants));
+
+	// Set PSO
+	d3dCommandList->SetPipelineState(computePSOManager->GetPSO(temporalAccumPSODescriptor));
+	// Set RootSignature
+	auto shader = temporalAccumPSODescriptor.shader;
+	d3dCommandList->SetComputeRootSignature(shader->rootSignature.Get()); // should before binding
+
+	shader->SetParameter("cbTemporalAA", cbTemporalAA);
+	shader->SetParameter("ColorTexture", GetLightingOutputTexture()->GetSRV());
+	shader->SetParameter("HistoryTexture", prevColorTexture->GetSRV());
+	shader->SetParameter("VelocityGbuffer", GBufferVelocity->GetTexture()->GetSRV());
+	shader->SetParameter("ResolvedTexture", resolvedColorTexture->GetUAV());
+
+	// Bind parameters
+	shader->BindParameters();
+
+	// Dispatch (88 group)
+	UINT gx = (UINT)ceilf(windowWidth / 8.0f);
+	UINT gy = (UINT)ceilf(windowHeight / 8.0f);
+	d3dCommandList->Dispatch(gx, gy, 1);
+
+	d3d12RHI->TransitionResource(resolvedColorTexture->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	// The resolve is the history of the next frame
+	std::swap(prevColorTexture, resolvedColorTexture);
+	bTAAHistoryValid = true;
+}
+
+D3D12TextureRef Render::GetLightingOutputTexture() const
+{
+	return renderSettings.bEnableSVGF ? svgfOutputTexture : colorTexture;
+}
+
+void Render::SVGFTemporalAccumPass()
 {
+	if (!renderSettings.bEnableSVGF)
+	{
+		bSVGFHistoryValid = false;
+		return;
+	}
+
+	UINT current = svgfFrameIndex;
+	UINT previous = 1 - svgfFrameIndex;
+
+	// IntegratePass does not trace yet, the deferred lighting is the image to denoise
 	d3d12RHI->TransitionResource(colorTexture->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+	d3d12RHI->TransitionResource(svgfSurfaceTextures[previous]->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+	d3d12RHI->TransitionResource(svgfMomentsTextures[previous]->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+	d3d12RHI->TransitionResource(svgfColorHistoryTexture->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+	d3d12RHI->TransitionResource(svgfSurfaceTextures[current]->GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	d3d12RHI->TransitionResource(svgfMomentsTextures[current]->GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	d3d12RHI->TransitionResource(svgfFilterTextures[0]->GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+	SVGFConstants svgfConstants;
+	svgfConstants.historyValid = bSVGFHistoryValid ? 1 : 0;
+	auto cbSVGF = d3d12RHI->CreateConstantBuffer(&svgfConstants, sizeof(svgfConstants));
+
+	// Set PSO
+	d3dCommandList->SetPipelineState(computePSOManager->GetPSO(SVGFTemporalAccumPSODescriptor));
+	// Set RootSignature
+	auto shader = SVGFTemporalAccumPSODescriptor.shader;
+	d3dCommandList->SetComputeRootSignature(shader->rootSignature.Get()); // should before binding
+
+	shader->SetParameter("cbPass", basePassCBRef);
+	shader->SetParameter("cbSVGF", cbSVGF);
+	shader->SetParameter("NoisyTexture", colorTexture->GetSRV());
+	shader->SetParameter("BaseColorGbuffer", GBufferBaseColor->GetTexture()->GetSRV());
+	shader->SetParameter("NormalGbuffer", GBufferNormal->GetTexture()->GetSRV());
+	shader->SetParameter("WorldPosGbuffer", GBufferWorldPos->GetTexture()->GetSRV());
+	shader->SetParameter("VelocityGbuffer", GBufferVelocity->GetTexture()->GetSRV());
+	shader->SetParameter("PrevSurfaceTexture", svgfSurfaceTextures[previous]->GetSRV());
+	shader->SetParameter("PrevMomentsTexture", svgfMomentsTextures[previous]->GetSRV());
+	shader->SetParameter("ColorHistoryTexture", svgfColorHistoryTexture->GetSRV());
+	shader->SetParameter("SurfaceTexture", svgfSurfaceTextures[current]->GetUAV());
+	shader->SetParameter("MomentsTexture", svgfMomentsTextures[current]->GetUAV());
+	shader->SetParameter("IlluminationTexture", svgfFilterTextures[0]->GetUAV());
+
+	// Bind parameters
+	shader->BindParameters();
+
+	UINT gx = (UINT)ceilf(windowWidth / 8.0f);
+	UINT gy = (UINT)ceilf(windowHeight / 8.0f);
+	d3dCommandList->Dispatch(gx, gy, 1);
+
+	d3d12RHI->TransitionResource(svgfSurfaceTextures[current]->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+	d3d12RHI->TransitionResource(svgfMomentsTextures[current]->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+	d3d12RHI->TransitionResource(svgfFilterTextures[0]->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+}
+
+void Render::SVGFVariancePass()
+{
+	if (!renderSettings.bEnableSVGF)
+	{
+		return;
+	}
+
+	d3d12RHI->TransitionResource(svgfFilterTextures[1]->GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+	// Set PSO
+	d3dCommandList->SetPipelineState(computePSOManager->GetPSO(variancePSODescriptor));
+	// Set RootSignature
+	auto shader = variancePSODescriptor.shader;
+	d3dCommandList->SetComputeRootSignature(shader->rootSignature.Get()); // should before binding
+
+	shader->SetParameter("IlluminationTexture", svgfFilterTextures[0]->GetSRV());
+	shader->SetParameter("MomentsTexture", svgfMomentsTextures[svgfFrameIndex]->GetSRV());
+	shader->SetParameter("SurfaceTexture", svgfSurfaceTextures[svgfFrameIndex]->GetSRV());
+	shader->SetParameter("FilteredTexture", svgfFilterTextures[1]->GetUAV());
+
+	// Bind parameters
+	shader->BindParameters();
+
+	UINT gx = (UINT)ceilf(windowWidth / 8.0f);
+	UINT gy = (UINT)ceilf(windowHeight / 8.0f);
+	d3dCommandList->Dispatch(gx, gy, 1);
+
+	d3d12RHI->TransitionResource(svgfFilterTextures[1]->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+}
+
+void Render::SVGFSpatFilterPass()
+{
+	if (!renderSettings.bEnableSVGF)
+	{
+		return;
+	}
+
+	// Set PSO
+	d3dCommandList->SetPipelineState(computePSOManager->GetPSO(SVGFSpatFilterPSODescriptor));
+	// Set RootSignature
+	auto shader = SVGFSpatFilterPSODescriptor.shader;
+	d3dCommandList->SetComputeRootSignature(shader->rootSignature.Get()); // should before binding
+
+	// The first iteration writes the color history of the next frame, the last one the remodulated output
+	D3D12TextureRef source = svgfFilterTextures[1];
+	for (int i = 0; i < SVGF_ATROUS_ITERATIONS; i++)
+	{
+		D3D12TextureRef target = svgfFilterTextures[i % 2 == 1 ? 0 : 1];
+		if (i == 0)
+		{
+			target = svgfColorHistoryTexture;
+		}
+		else if (i == SVGF_ATROUS_ITERATIONS - 1)
+		{
+			target = svgfOutputTexture;
+		}
+
+		d3d12RHI->TransitionResource(source->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+		d3d12RHI->TransitionResource(target->GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+		SVGFConstants svgfConstants;
+		svgfConstants.stepSize = 1 << i;
+		svgfConstants.remodulate = (i == SVGF_ATROUS_ITERATIONS - 1) ? 1 : 0;
+		auto cbSVGF = d3d12RHI->CreateConstantBuffer(&svgfConstants, sizeof(svgfConstants));
+
+		shader->SetParameter("cbSVGF", cbSVGF);
+		shader->SetParameter("IlluminationTexture", source->GetSRV());
+		shader->SetParameter("SurfaceTexture", svgfSurfaceTextures[svgfFrameIndex]->GetSRV());
+		shader->SetParameter("BaseColorGbuffer", GBufferBaseColor->GetTexture()->GetSRV());
+		shader->SetParameter("FilteredTexture", target->GetUAV());
+
+		// Bind parameters
+		shader->BindParameters();
+
+		UINT gx = (UINT)ceilf(windowWidth / 8.0f);
+		UINT gy = (UINT)ceilf(windowHeight / 8.0f);
+		d3dCommandList->Dispatch(gx, gy, 1);
+
+		source = target;
+	}
+
+	d3d12RHI->TransitionResource(svgfOutputTexture->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	// This frame's surface and moments are the history of the next one
+	svgfFrameIndex = 1 - svgfFrameIndex;
+	bSVGFHistoryValid = true;
+}
+
+void Render::PostProcessPass()
+{
+	// With TAA the resolve was swapped into prevColorTexture
+	D3D12TextureRef sceneColorTexture = renderSettings.bEnableTAA ? prevColorTexture : GetLightingOutputTexture();
+
+	d3d12RHI->TransitionResource(sceneColorTexture->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ);
 
 	d3d12RHI->TransitionResource(CurrentBackBuffer(), D3D12_RESOURCE_STATE_RENDER_TARGET);
 
@@ -2006,7 +2886,7 @@ void Render::PostProcessPass()
 	d3dCommandList->SetGraphicsRootSignature(postProcessShader->rootSignature.Get()); //should before binding
 
 	// Set paramters
-	postProcessShader->SetParameter("ColorTexture", colorTexture->GetSRV());
+	postProcessShader->SetParameter("ColorTexture", sceneColorTexture->GetSRV());
 
 	// Bind paramters
 	postProcessShader->BindParameters();
@@ -10,8 +10,10 @@
 #include "../Component/MeshComponent.h"
 #include "../Component/CameraComponent.h"
 #include "../Texture/Texture.h"
+#include "../Texture/TextureStreamer.h"
 #include "../Material/Material.h"
 #include "../Engine/GameTimer.h"
+#include "../Engine/FramePipeline.h"
 #include "RenderProxy.h"
 #include "InputLayout.h"
 #include "PSO.h"
@@ -21,14 +23,36 @@
 #include "SpriteFont.h"
 #include "RenderTarget.h"
 #include "SceneCaptureCube.h"
+#include "ShadowAtlas.h"
+#include "TemporalAA.h"
+#include "SVGFDenoiser.h"
 #include "../Resource/D3D12RHI.h"
+#include "../Resource/FrameRingBuffer.h"
 
 // Link necessary d3d12 libraries.
 #pragma comment(lib,"d3dcompiler.lib")
 #pragma comment(lib, "D3D12.lib")
 #pragma comment(lib, "dxgi.lib")
 
-#define TAA_SAMPLE_COUNT 8
+// Meshes tested per frustum culling job
+#define CULLING_BATCH_SIZE 256
+
+// Initial bytes per frame of the debug primitive vertex ring, it grows when a frame draws more
+#define PRIMITIVE_VERTEX_RING_SIZE (4 * 1024 * 1024)
+
+// Rasterizer bias of the shadow depth passes, in D24 depth units
+#define SHADOW_DEPTH_BIAS 10000
+#define SHADOW_SLOPE_SCALED_DEPTH_BIAS 1.5f
+
+// Cascade spheres are shrunk by this many texels for the lighting pass, so the filter stays inside a tile
+#define CSM_FILTER_MARGIN_TEXELS 3.0f
+
+// Perspective depth is denser near the light, the point and spot light shadows need less constant bias
+#define LOCAL_SHADOW_DEPTH_BIAS 1000
+#define LOCAL_SHADOW_SLOPE_SCALED_DEPTH_BIAS 2.0f
+
+// Shadow atlas tiles are sampled this many texels inside their edges, the neighbour tiles belong to other lights
+#define SHADOW_ATLAS_FILTER_MARGIN_TEXELS 1.5f
 
 enum class ERenderPass
 {
@@ -53,10 +77,17 @@ struct TRenderSettings
 	bool bEnableSSR = false;
 	bool bEnableSSAO = false;
 	bool bDebugSDFScene = false;
+	uint32_t meshSDFResolution = 64;    // Meshes drawn with bUseSDF get a distance field of this size, see MeshSDFBaker
 	bool bDrawDebugText = false;
+	bool bEnableTextureStreaming = false;
+	uint32_t textureStreamingBudgetMB = 256;
+	bool bEnableBindless = false;
+	bool bEnableShadows = true;   // Cascaded shadows of the first directional light, shadow atlas of the point and spot lights
+	uint32_t shadowAtlasFaceBudget = 12;   // Point and spot light shadow map faces redrawn per frame, a point light has 6
+	bool bEnableSVGF = false;   // Denoises the lit scene color before TAA and the post process, see SVGFDenoiser
 };
 
-class Render
+class Render : public IFrameRenderer
 {
 public:
 	Render();
@@ -65,9 +96,14 @@ public:
 	bool IsInitialize();
 	bool Initialize(int windowWidth, int windowHeight, D3D12RHI* inD3D12RHI, World* inWorld, const TRenderSettings& settings);
 	void OnResize(int newWidth, int newHeight);
+	void OnDestroy();
+
+	// Draws the snapshot, the world is not read during a frame
+	virtual void RenderFrame(const RenderSnapshot& inSnapshot, const GameTimer& gt) override;
+
+private:
 	void Draw(const GameTimer& gt);
 	void EndFrame();
-	void OnDestroy();
 
 private:
 	float AspectRatio() const;
@@ -83,7 +119,9 @@ private:
 	void CreateSceneCaptureCube();  // for IBL
 	void CreateGBuffers();
 	void CreateColorTextures();
+	void CreateShadowMaps();
 	void CreateMeshProxys();
+	void CreateMeshSDFs();
 	void CreateInputLayouts();
 	void CreateGlobalShaders();
 	void CreateGlobalPSO();
@@ -103,20 +141,43 @@ private:
 	// Monte Carlo
 	void CreateEnviromentCDF();
 	void IntegratePass();
-	// TAA
+	// TAA, resolves the lighting output against the history
 	void TemporalAccumPass();
-	// SVGF
+	// SVGF, denoises colorTexture into svgfOutputTexture
+	void SVGFTemporalAccumPass();
+	void SVGFVariancePass();
 	void SVGFSpatFilterPass();
+	// Lit scene the TAA and the post process start from
+	D3D12TextureRef GetLightingOutputTexture() const;
 	// mesh
 	void GatherAllMeshBatchs();
+	ConstantBufferRef CreateObjectConstantBuffer(const MeshRenderData& meshData);
+	void UpdateTextureStreaming();
 	TMatrix TextureTransform();
  	void UpdateLightData();
  	void UpdateBasePassCB();
  	void GetBasePassMeshCommandMap();
+
+	// BindlessTable index of a texture, missing textures fall back to NullTex
+	uint32_t GetBindlessTextureIndex(const std::string& textureName);
+	// Cascaded shadows
+	void UpdateCascadedShadowCB(bool bEnableShadows);
+	void ShadowPass();
+	// Draws the static or the dynamic casters of a cascade into its tile of shadowMap, the static ones into a cleared tile
+	void DrawShadowCasters(RenderTarget2D* shadowMap, int cascadeIndex, bool bStatic);
+	// Viewport, scissor and depth target of one tile of a shadow map
+	void BeginShadowTile(RenderTarget2D* shadowMap, UINT x, UINT y, UINT size, bool bClear);
+	void DrawShadowCaster(uint32_t meshIndex, const ConstantBufferRef& passCB, bool bLocalLight, const GraphicsPSODescriptor*& boundDescriptor);
+	// Point and spot light shadows, UpdateLocalShadows assigns the atlas tiles before UpdateLightData needs them
+	void UpdateLocalShadows();
+	uint64_t GetLocalShadowHash(const ShadowAtlasRequest& request, const LightRenderData& light) const;
+	void LocalShadowPass();
+	void DrawLocalShadowCasters(const LightRenderData& light, const ShadowAtlasTile& tile, const TMatrix& viewProj);
 	void BasePass();
- 	void GatherLightDebugPrimitives(std::vector<Line>& outLines);
+ 	void GatherLightDebugPrimitives(DebugDrawBuffer& outDebugDraw);
  	void GatherAllPrimitiveBatchs();
- 	void GatherPrimitiveBatchs(const std::vector<PrimitiveVertex>& vertices, D3D12_PRIMITIVE_TOPOLOGY_TYPE primitiveType);
+	// Copies the vertices of the world and of the renderer for one topology and depth mode into the ring, one batch
+	void GatherPrimitiveBatch(EDebugTopology topology, EDebugDepthMode depthMode);
  	void PrimitivesPass();
 	void DeferredLightingPass();
 	void PostProcessPass();
@@ -130,6 +191,9 @@ private:
 
 	World* world;
 
+	// Set during RenderFrame
+	const RenderSnapshot* snapshot = nullptr;
+
 	ID3D12Device5* d3dDevice;
 	ID3D12GraphicsCommandList4* d3dCommandList;
 
@@ -152,7 +216,19 @@ private:
 
 	D3D12TextureRef colorTexture = nullptr;
 	D3D12TextureRef cacheColorTexture = nullptr;
+	// TAA history ping-pong, the resolve reads prevColorTexture and writes resolvedColorTexture, then they swap
 	D3D12TextureRef prevColorTexture = nullptr;
+	D3D12TextureRef resolvedColorTexture = nullptr;
+	bool bTAAHistoryValid = false;
+	// SVGF, created in CreateComputeShaderResource when bEnableSVGF is set. The surface and moments textures are
+	// ping-pong pairs, the current frame writes svgfFrameIndex and reads the other one.
+	D3D12TextureRef svgfSurfaceTextures[2];             // Normal and linear depth
+	D3D12TextureRef svgfMomentsTextures[2];             // Luminance moments and history length
+	D3D12TextureRef svgfColorHistoryTexture = nullptr;  // Illumination after the first a-trous iteration
+	D3D12TextureRef svgfFilterTextures[2];              // Illumination and variance
+	D3D12TextureRef svgfOutputTexture = nullptr;
+	UINT svgfFrameIndex = 0;
+	bool bSVGFHistoryValid = false;
 	std::unique_ptr<RenderTarget2D> backDepth = nullptr;
 
 	UINT frameCount = 0;
@@ -169,7 +245,7 @@ private:
 	ConstantBufferRef IBLIrradiancePassCBRef[6];
 	const static UINT IBLPrefilterMaxMipLevel = 5;
 	ConstantBufferRef IBLPrefilterEnvPassCBRef[IBLPrefilterMaxMipLevel * 6];
-	ConstantBufferRef shadowPassCBRef = nullptr;
+	ConstantBufferRef cascadeShadowPassCBRefs[CSM_CASCADE_COUNT];
 	ConstantBufferRef basePassCBRef = nullptr;
 	ConstantBufferRef deferredLightPassCBRef;
 
@@ -180,6 +256,8 @@ private:
 	std::unique_ptr<Shader> deferredLightingShader = nullptr;
 	std::unique_ptr<Shader> primitiveShader = nullptr;
 	std::unique_ptr<Shader> postProcessShader = nullptr;
+	std::unique_ptr<Shader> shadowDepthShader = nullptr;
+	std::unique_ptr<Shader> shadowDepthCompactShader = nullptr;  // COMPACT_VERTEX
 	// Mento Carlo shader
 	std::unique_ptr<Shader> localCondCDFShader = nullptr;       // for EnvCDF
 	std::unique_ptr<Shader> globalCondCDFShader = nullptr;       // for EnvCDF
@@ -189,6 +267,7 @@ private:
 	std::unique_ptr<Shader> resultCDFShader = nullptr;       // for EnvCDF
 	std::unique_ptr<Shader> IntegrateShader = nullptr;
 	std::unique_ptr<Shader> temporalAccumShader = nullptr;
+	std::unique_ptr<Shader> SVGFTemporalAccumShader = nullptr;
 	std::unique_ptr<Shader> SVGFSpatFilterShader = nullptr;
 	std::unique_ptr<Shader> varianceShader = nullptr;
 
@@ -199,6 +278,10 @@ private:
 	std::unique_ptr<GraphicsPSOManager> graphicsPSOManager;
 	GraphicsPSODescriptor deferredLightingPSODescriptor;
 	GraphicsPSODescriptor postProcessPSODescriptor;
+	GraphicsPSODescriptor shadowDepthPSODescriptor;
+	GraphicsPSODescriptor shadowDepthCompactPSODescriptor;
+	GraphicsPSODescriptor localShadowDepthPSODescriptor;
+	GraphicsPSODescriptor localShadowDepthCompactPSODescriptor;
 	// Mento Carlo PSO
 	std::unique_ptr<ComputePSOManager> computePSOManager;
 	ComputePSODescriptor localCondCDFPSODescriptor;             // for EnvCDF
@@ -209,22 +292,50 @@ private:
 	ComputePSODescriptor resultCDFPSODescriptor;             // for EnvCDF
 	ComputePSODescriptor integratePSODescriptor;
 	ComputePSODescriptor temporalAccumPSODescriptor;
+	ComputePSODescriptor SVGFTemporalAccumPSODescriptor;
 	ComputePSODescriptor SVGFSpatFilterPSODescriptor;
 	ComputePSODescriptor variancePSODescriptor;
 
 	// MeshBatch and MeshCommand
 	std::vector<MeshBatch> meshBatchs;
+	std::vector<uint8_t> meshVisibility;  // Culling result per snapshot mesh
 	std::unordered_map<GraphicsPSODescriptor, MeshCommandList> baseMeshCommandMap;
 	const int maxRenderMeshCount = 100;
 
 	// PrimitiveBatchs
 	std::unordered_map<GraphicsPSODescriptor, PrimitiveBatch> psoPrimitiveBatchMap;
+	std::unique_ptr<FrameRingBuffer> primitiveVertexRing;
+	DebugDrawBuffer lightDebugDraw;
 
 	// Light
 	StructuredBufferRef lightShaderParametersBuffer = nullptr;
 	ConstantBufferRef lightCommonDataBuffer = nullptr;
 	UINT lightCount = 0;
 
+	// Cascaded shadows, each cascade is a tile of the shadow map
+	std::unique_ptr<RenderTarget2D> cascadeShadowMap;
+	// Static casters only, copied into cascadeShadowMap before the dynamic casters are drawn
+	std::unique_ptr<RenderTarget2D> cascadeStaticShadowMap;
+	ConstantBufferRef cascadedShadowCBRef = nullptr;
+	// Per snapshot mesh, created for the casters drawn this frame
+	std::vector<ConstantBufferRef> shadowObjConstantBuffers;
+	// What the tiles of cascadeStaticShadowMap were drawn for
+	bool bCascadeCacheValid[CSM_CASCADE_COUNT] = {};
+	uint32_t cachedCascadeRevisions[CSM_CASCADE_COUNT] = {};
+	uint64_t cachedStaticMeshVersions[CSM_CASCADE_COUNT] = {};
+	bool bShadowMapHasDynamicCasters = false;
+
+	// Point and spot light shadows, each face is a tile of the atlas
+	std::unique_ptr<RenderTarget2D> shadowAtlasMap;
+	ShadowAtlas shadowAtlas;
+	std::vector<ShadowAtlasRequest> shadowAtlasRequests;
+	std::vector<ShadowAtlasAllocation> shadowAtlasAllocations;
+	// Snapshot light of each request
+	std::vector<uint32_t> shadowAtlasRequestLights;
+	// First face in localShadowFacesBuffer per snapshot light, -1 for the lights without a shadow map
+	std::vector<int> localShadowFaceIndices;
+	StructuredBufferRef localShadowFacesBuffer = nullptr;
+
 	// hdrSky
 	MeshComponent* skyMeshComponent = nullptr;
 	std::string skyCubeTextureName;
@@ -241,6 +352,9 @@ private:
 	// Culling
 	bool bEnableFrustumCulling = false;
 
+	// Texture streaming
+	std::unique_ptr<TextureStreamer> textureStreamer = nullptr;
+
 	// D3D12RHI
 	D3D12RHI* d3d12RHI = nullptr;
 
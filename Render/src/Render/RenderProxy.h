@@ -6,6 +6,8 @@
 #include "../Resource/Resource.h"
 #include "../Resource/View.h"
 #include "../Math/Math.h"
+#include "../Material/Material.h"
+#include "ShadowCascades.h"
 
 struct MaterialConstants
 {
@@ -19,7 +21,11 @@ public:
 
 	TVector3 emissiveColor;
 	UINT shadingModel;
+
+	// BindlessTable indices of Material::bindlessTextureSlots
+	UINT textureIndices[MATERIAL_BINDLESS_TEXTURE_SLOTS] = { 0 };
 };
+static_assert(offsetof(MaterialConstants, textureIndices) % 16 == 0, "TextureIndices is a uint4, it must start a register");
 
 // Defines a subrange of geometry in a TMeshProxy.  This is for when multiple
 // geometries are stored in one vertex and index buffer.  It provides the offsets
@@ -76,7 +82,7 @@ struct LightShaderParameters
 	float    spotRadius;  // Spot light only
 	TVector2 spotAngles;  // Spot light only
 	UINT     lightType;
-	INT      shadowMapIdx = 0;
+	INT      shadowMapIdx = -1;  // First face in LocalShadowFaces, -1 for lights without a shadow map
 
 	TMatrix lightProj = TMatrix::Identity;
 	TMatrix  shadowTransform = TMatrix::Identity;
@@ -89,6 +95,65 @@ struct LightCommonData
 	UINT lightCount = 0;
 };
 
+// LocalShadowFaces in Shadows.hlsl, one per face of a shadowed point or spot light
+struct LocalShadowFaceParameters
+{
+	// World space to shadow atlas uv and depth, before the divide by w
+	TMatrix shadowTransform = TMatrix::Identity;
+
+	// Tile of the face in atlas uv, min in xy and max in zw, less the filter footprint
+	TVector4 uvBounds;
+
+	// World units per texel at unit distance from the light
+	float texelAngle = 0.0f;
+	float faceShadowPad0 = 0.0f;
+	float faceShadowPad1 = 0.0f;
+	float faceShadowPad2 = 0.0f;
+};
+static_assert(sizeof(LocalShadowFaceParameters) % 16 == 0, "must be 16-byte aligned");
+
+// cbCascadedShadow in Shadows.hlsl
+struct CascadedShadowConstants
+{
+	// World space to shadow map uv and depth
+	TMatrix shadowTransforms[CSM_CASCADE_COUNT];
+
+	// xyz center, w radius less the filter footprint. A point is shadowed by the first cascade whose sphere holds it.
+	TVector4 cascadeSpheres[CSM_CASCADE_COUNT];
+
+	// x world units per texel
+	TVector4 cascadeTexelSizes[CSM_CASCADE_COUNT];
+
+	TVector2 shadowMapInvSize = TVector2(0.0f, 0.0f);
+
+	// 0 without shadows
+	UINT cascadeCount = 0;
+	float cbShadowPad0 = 0.0f;
+};
+static_assert(sizeof(CascadedShadowConstants) % 16 == 0, "must be 16-byte aligned");
+
+// cbTemporalAA in TemporalAccumCS.hlsl
+struct TemporalAAConstants
+{
+	// 0 when the history holds nothing of this view, the current frame is taken as it is
+	UINT historyValid = 0;
+	float cbTemporalAAPad0 = 0.0f;
+	float cbTemporalAAPad1 = 0.0f;
+	float cbTemporalAAPad2 = 0.0f;
+};
+
+// cbSVGF in SVGFCommon.hlsl
+struct SVGFConstants
+{
+	// 0 when the history holds nothing of this view, every pixel starts over
+	UINT historyValid = 0;
+	// Pixels between the a-trous taps
+	INT stepSize = 1;
+	// The last a-trous iteration multiplies the albedo back in
+	UINT remodulate = 0;
+	float cbSVGFPad0 = 0.0f;
+};
+
 #define MAX_LIGHT_COUNT_IN_TILE 500
 
 struct PassConstants
@@ -108,6 +173,8 @@ struct PassConstants
 	float FarZ = 0.0f;
 	float TotalTime = 0.0f;
 	float DeltaTime = 0.0f;
+	TVector2 Jitter = { 0.0f, 0.0f };  // TAA offset of Proj in NDC
+	TVector2 cbPassPad3;
 
 	TVector4 FogColor = { 0.7f, 0.7f, 0.7f, 1.0f };
 	float gFogStart = 5.0f;
@@ -120,6 +187,12 @@ struct ObjectConstants
 	TMatrix World = TMatrix::Identity;
 	TMatrix PrevWorld = TMatrix::Identity;
 	TMatrix TexTransform = TMatrix::Identity;
+
+	// Dequantize CompactVertex positions, posL = min + unorm * scale
+	TVector3 PositionQuantizeMin = TVector3::Zero;
+	float cbObjectPad0 = 0.0f;
+	TVector3 PositionQuantizeScale = TVector3::One;
+	float cbObjectPad1 = 0.0f;
 };
 
 struct PrefilterEnvironmentConstant
@@ -0,0 +1,271 @@
+#include "RenderSnapshot.h"
+#include "../World/World.h"
+#include "../Component/MeshComponent.h"
+#include "../Actor/Light/DirectionalLightActor.h"
+#include "../Actor/Light/PointLightActor.h"
+#include "../Actor/Light/SpotLightActor.h"
+#include "../Utility/JobSystem.h"
+#include "../Math/Frustum.h"
+#include "ShadowAtlas.h"
+#include <algorithm>
+
+// Mesh components copied per job
+#define SNAPSHOT_MESH_BATCH_SIZE 512
+
+#define SNAPSHOT_INVALID_MESH 0xffffffff
+
+void RenderSnapshot::Extract(World& world, uint64_t inFrameIndex)
+{
+	frameIndex = inFrameIndex;
+
+	// Camera
+	CameraComponent* cameraComponent = world.GetCameraComponent();
+	camera.view = cameraComponent->GetView();
+	camera.proj = cameraComponent->GetProj();
+	camera.prevViewProj = cameraComponent->GetPrevViewProj();
+	camera.location = cameraComponent->GetWorldLocation();
+	camera.nearZ = cameraComponent->GetNearZ();
+	camera.farZ = cameraComponent->GetFarZ();
+	camera.fovY = cameraComponent->GetFovY();
+
+	TFrustum frustum = TFrustum::FromViewProj(camera.view * camera.proj);
+
+	// Meshes whose world bounds touch the frustum
+	cameraMeshComponents.clear();
+	world.GetMeshOctree().QueryFrustum(frustum, cameraMeshComponents);
+	std::sort(cameraMeshComponents.begin(), cameraMeshComponents.end());
+
+	meshComponents.assign(cameraMeshComponents.begin(), cameraMeshComponents.end());
+
+	cascadedShadow.bEnable = world.HasShadowCascades();
+	if (cascadedShadow.bEnable)
+	{
+		QueryShadowCasters(world);
+	}
+
+	ExtractLights(world, frustum);
+
+	// Most casters are in the camera frustum or cast into several shadow maps
+	std::sort(meshComponents.begin(), meshComponents.end());
+	meshComponents.erase(std::unique(meshComponents.begin(), meshComponents.end()), meshComponents.end());
+
+	// Every entry is written by one job only
+	meshes.resize(meshComponents.size());
+
+	JobSystem::Get().ParallelFor("ExtractMeshes", static_cast<uint32_t>(meshComponents.size()), SNAPSHOT_MESH_BATCH_SIZE,
+		[this](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				MeshComponent* meshComponent = meshComponents[i];
+				MeshRenderData& mesh = meshes[i];
+
+				mesh.bDraw = meshComponent->IsMeshValid() && meshComponent->GetOwner()->IsDrawMesh();
+				if (!mesh.bDraw)
+				{
+					continue;
+				}
+
+				mesh.meshName = meshComponent->GetMeshName();
+				mesh.materialInstance = meshComponent->GetMaterialInstance();
+				mesh.worldMatrix = meshComponent->GetWorldMatrix();
+				mesh.invWorldMatrix = meshComponent->GetInvWorldMatrix();
+				mesh.prevWorldMatrix = meshComponent->GetPrevWorldMatrix();
+				mesh.texTransform = meshComponent->TexTransform;
+				mesh.bHasBoundingBox = meshComponent->GetLocalBoundingBox(mesh.localBoundingBox);
+				mesh.bUseSDF = meshComponent->bUseSDF;
+				mesh.bStatic = meshComponent->bStatic;
+				mesh.bInCameraFrustum = std::binary_search(cameraMeshComponents.begin(), cameraMeshComponents.end(), meshComponent);
+			}
+		});
+
+	// Remove the meshes not drawn, the shadow casters refer to the others by index
+	meshIndices.resize(meshes.size());
+
+	uint32_t meshCount = 0;
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		if (!meshes[i].bDraw)
+		{
+			meshIndices[i] = SNAPSHOT_INVALID_MESH;
+			continue;
+		}
+
+		if (i != meshCount)
+		{
+			meshes[meshCount] = std::move(meshes[i]);
+		}
+		meshIndices[i] = meshCount++;
+	}
+	meshes.resize(meshCount);
+
+	if (cascadedShadow.bEnable)
+	{
+		ResolveShadowCasters();
+	}
+	else
+	{
+		for (std::vector<uint32_t>& casters : cascadedShadow.casters)
+		{
+			casters.clear();
+		}
+	}
+
+	ResolveLocalShadowCasters();
+
+	// Debug primitives
+	world.TakeDebugDraw(debugDraw);
+}
+
+void RenderSnapshot::ExtractLights(World& world, const TFrustum& frustum)
+{
+	localCasterComponents.clear();
+
+	// Directional lights reach everything, the others are culled by their range
+	const auto& directionalLights = world.GetAllActorsOfClass<DirectionalLightActor>();
+	visibleLights.assign(directionalLights.begin(), directionalLights.end());
+	world.GetLightOctree().QueryFrustum(frustum, visibleLights);
+
+	lights.clear();
+	for (LightActor* light : visibleLights)
+	{
+		LightRenderData lightData;
+		lightData.lightType = light->GetType();
+		lightData.color = light->GetLightColor();
+		lightData.intensity = light->GetLightIntensity();
+		lightData.position = light->GetActorLocation();
+		lightData.lightId = light->GetSceneIndexId();
+		lightData.bCastShadows = light->IsCastShadows();
+		lightData.shadowImportance = light->GetShadowImportance();
+		lightData.bDrawDebug = light->IsDrawDebug();
+
+		if (lightData.lightType == ELightType::DirectionalLight)
+		{
+			auto directionalLight = static_cast<DirectionalLightActor*>(light);
+			lightData.direction = directionalLight->GetLightDirection();
+		}
+		else if (lightData.lightType == ELightType::PointLight)
+		{
+			auto pointLight = static_cast<PointLightActor*>(light);
+			lightData.range = pointLight->GetAttenuationRange();
+		}
+		else if (lightData.lightType == ELightType::SpotLight)
+		{
+			auto spotLight = static_cast<SpotLightActor*>(light);
+			lightData.direction = spotLight->GetLightDirection();
+			lightData.range = spotLight->GetAttenuationRange();
+			lightData.innerConeAngle = spotLight->GetInnerConeAngle();
+			lightData.outerConeAngle = spotLight->GetOuterConeAngle();
+			lightData.bottomRadius = spotLight->GetBottomRadius();
+		}
+
+		if (lightData.bCastShadows && lightData.lightType != ELightType::DirectionalLight)
+		{
+			QueryLocalShadowCasters(world, light, lightData);
+		}
+
+		lights.push_back(lightData);
+	}
+}
+
+void RenderSnapshot::QueryShadowCasters(World& world)
+{
+	const ShadowCascadeFitter& cascades = world.GetShadowCascades();
+	cascadedShadow.staticMeshVersion = world.GetStaticMeshVersion();
+
+	for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+	{
+		const ShadowCascade& cascade = cascades.GetCascade(i);
+		cascadedShadow.cascades[i] = cascade;
+
+		// The cascade volume reaches CSM_CASTER_DISTANCE towards the light, so casters outside the camera frustum are found
+		TFrustum cascadeFrustum = TFrustum::FromViewProj(cascade.viewProj);
+
+		std::vector<MeshComponent*>& casters = cascadeCasterComponents[i];
+		casters.clear();
+		world.GetMeshOctree().QueryFrustum(cascadeFrustum, casters);
+		std::sort(casters.begin(), casters.end());
+
+		meshComponents.insert(meshComponents.end(), casters.begin(), casters.end());
+	}
+}
+
+void RenderSnapshot::QueryLocalShadowCasters(World& world, LightActor* light, LightRenderData& lightData)
+{
+	const size_t first = localCasterComponents.size();
+
+	if (lightData.lightType == ELightType::SpotLight)
+	{
+		TMatrix viewProj = ShadowAtlas::GetSpotLightViewProj(lightData.position, lightData.direction, lightData.range, lightData.outerConeAngle);
+		world.GetMeshOctree().QueryFrustum(TFrustum::FromViewProj(viewProj), localCasterComponents);
+	}
+	else
+	{
+		world.GetMeshOctree().QuerySphere(lightData.position, lightData.range, localCasterComponents);
+	}
+
+	// The mesh of the light itself would hide it
+	auto casters = localCasterComponents.begin() + first;
+	localCasterComponents.erase(std::remove_if(casters, localCasterComponents.end(),
+		[light](MeshComponent* meshComponent) { return meshComponent->GetOwner() == light; }), localCasterComponents.end());
+
+	casters = localCasterComponents.begin() + first;
+	std::sort(casters, localCasterComponents.end());
+
+	lightData.firstShadowCaster = (uint32_t)first;
+	lightData.shadowCasterCount = (uint32_t)(localCasterComponents.size() - first);
+
+	meshComponents.insert(meshComponents.end(), casters, localCasterComponents.end());
+}
+
+void RenderSnapshot::ResolveShadowCasters()
+{
+	for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+	{
+		std::vector<uint32_t>& casters = cascadedShadow.casters[i];
+		casters.clear();
+
+		// Both lists are sorted, so the search starts where the last one ended
+		auto searchBegin = meshComponents.begin();
+		for (MeshComponent* meshComponent : cascadeCasterComponents[i])
+		{
+			searchBegin = std::lower_bound(searchBegin, meshComponents.end(), meshComponent);
+
+			uint32_t meshIndex = meshIndices[searchBegin - meshComponents.begin()];
+			if (meshIndex != SNAPSHOT_INVALID_MESH)
+			{
+				casters.push_back(meshIndex);
+			}
+		}
+	}
+}
+
+void RenderSnapshot::ResolveLocalShadowCasters()
+{
+	localShadowCasters.clear();
+
+	for (LightRenderData& light : lights)
+	{
+		if (light.shadowCasterCount == 0)
+		{
+			continue;
+		}
+
+		const uint32_t first = (uint32_t)localShadowCasters.size();
+
+		auto searchBegin = meshComponents.begin();
+		for (uint32_t i = light.firstShadowCaster; i < light.firstShadowCaster + light.shadowCasterCount; i++)
+		{
+			searchBegin = std::lower_bound(searchBegin, meshComponents.end(), localCasterComponents[i]);
+
+			uint32_t meshIndex = meshIndices[searchBegin - meshComponents.begin()];
+			if (meshIndex != SNAPSHOT_INVALID_MESH)
+			{
+				localShadowCasters.push_back(meshIndex);
+			}
+		}
+
+		light.firstShadowCaster = first;
+		light.shadowCasterCount = (uint32_t)localShadowCasters.size() - first;
+	}
+}
\ No newline at end of file
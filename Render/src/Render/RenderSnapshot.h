@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Math/Transform.h"
+#include "../Mesh/BoundingBox.h"
+#include "../Mesh/DebugDrawBuffer.h"
+#include "../Actor/Light/LightActor.h"
+#include "ShadowCascades.h"
+
+class World;
+class MeshComponent;
+class MaterialInstance;
+struct TFrustum;
+
+struct MeshRenderData
+{
+	std::string meshName;
+	MaterialInstance* materialInstance = nullptr;
+
+	TMatrix worldMatrix = TMatrix::Identity;
+	TMatrix invWorldMatrix = TMatrix::Identity;
+	TMatrix prevWorldMatrix = TMatrix::Identity;
+	TMatrix texTransform = TMatrix::Identity;
+
+	TBoundingBox localBoundingBox;
+	bool bHasBoundingBox = false;
+
+	bool bUseSDF = false;
+	bool bStatic = false;
+
+	// Shadow casters outside the camera frustum are not drawn in the base pass
+	bool bInCameraFrustum = false;
+
+	// Cleared for components that are not drawn, they are removed at the end of the extraction
+	bool bDraw = false;
+};
+
+struct LightRenderData
+{
+	ELightType lightType = ELightType::None;
+
+	TVector3 color = TVector3::One;
+	float intensity = 0.0f;
+	TVector3 position = TVector3::Zero;
+	TVector3 direction = TVector3::Zero;
+
+	// Point and spot lights
+	float range = 0.0f;
+
+	// Spot lights, in degrees
+	float innerConeAngle = 0.0f;
+	float outerConeAngle = 0.0f;
+	float bottomRadius = 0.0f;
+
+	// The scene index id of point and spot lights, the same every frame
+	uint32_t lightId = LOOSE_OCTREE_INVALID_ID;
+
+	bool bCastShadows = false;
+	float shadowImportance = 1.0f;
+
+	// Shadowed point and spot lights, range of RenderSnapshot::localShadowCasters
+	uint32_t firstShadowCaster = 0;
+	uint32_t shadowCasterCount = 0;
+
+	bool bDrawDebug = false;
+};
+
+struct CameraRenderData
+{
+	TMatrix view = TMatrix::Identity;
+	TMatrix proj = TMatrix::Identity;
+	TMatrix prevViewProj = TMatrix::Identity;
+	TVector3 location = TVector3::Zero;
+	float nearZ = 0.0f;
+	float farZ = 0.0f;
+	float fovY = 0.0f;
+};
+
+struct CascadedShadowRenderData
+{
+	bool bEnable = false;
+
+	ShadowCascade cascades[CSM_CASCADE_COUNT];
+
+	// Meshes in the volume of each cascade, indices into RenderSnapshot::meshes
+	std::vector<uint32_t> casters[CSM_CASCADE_COUNT];
+
+	uint64_t staticMeshVersion = 0;
+};
+
+// Everything Render reads from the world for one frame. It is copied once the world has updated, so the next frame
+// can be simulated while this one is drawn: Render reads the snapshot only and never the world during a frame.
+class RenderSnapshot
+{
+public:
+	// Copies the render data of the meshes and lights in the camera frustum, found through the scene index of the world,
+	// and of the meshes casting into the shadow cascades or the range of a shadowed light. The mesh components are copied
+	// on the job system.
+	// Takes the debug primitives drawn this frame out of the world.
+	void Extract(World& world, uint64_t inFrameIndex);
+
+private:
+	// Adds the casters of every cascade to meshComponents
+	void QueryShadowCasters(World& world);
+
+	// Lights in the frustum, with the casters of the shadowed point and spot lights
+	void ExtractLights(World& world, const TFrustum& frustum);
+
+	// Adds the casters of a point or spot light to meshComponents
+	void QueryLocalShadowCasters(World& world, LightActor* light, LightRenderData& lightData);
+
+	// Turns the caster components into indices of the extracted meshes
+	void ResolveShadowCasters();
+	void ResolveLocalShadowCasters();
+
+public:
+	uint64_t frameIndex = 0;
+
+	CameraRenderData camera;
+
+	std::vector<MeshRenderData> meshes;
+	std::vector<LightRenderData> lights;
+
+	CascadedShadowRenderData cascadedShadow;
+
+	// Meshes in the range of the shadowed point and spot lights, indices into meshes
+	std::vector<uint32_t> localShadowCasters;
+
+	DebugDrawBuffer debugDraw;
+
+private:
+	// Scene index query results, kept so extraction does not allocate. The mesh components are sorted and unique.
+	std::vector<MeshComponent*> cameraMeshComponents;
+	std::vector<MeshComponent*> meshComponents;
+	std::vector<MeshComponent*> cascadeCasterComponents[CSM_CASCADE_COUNT];
+	std::vector<LightActor*> visibleLights;
+
+	// Casters of the shadowed lights one after the other, sorted per light. Resolved into localShadowCasters.
+	std::vector<MeshComponent*> localCasterComponents;
+
+	// Index of each entry of meshComponents in meshes, SNAPSHOT_INVALID_MESH for the ones not drawn
+	std::vector<uint32_t> meshIndices;
+};
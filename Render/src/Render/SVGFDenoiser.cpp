@@ -0,0 +1,379 @@
+#include "SVGFDenoiser.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	// 5x5 B3 spline of the a-trous filter, separable
+	const float ATrousKernel[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+	// 3x3 Gaussian the variance is prefiltered with, separable
+	const float VarianceKernel[2] = { 1.0f / 2.0f, 1.0f / 4.0f };
+
+	float NormalWeight(const TVector3& centerNormal, const TVector3& normal)
+	{
+		return std::pow((std::max)(centerNormal.Dot(normal), 0.0f), SVGF_PHI_NORMAL);
+	}
+
+	// The depth difference is measured against what the plane through the center would give at that offset
+	float DepthWeight(float centerDepth, float depth, const TVector2& depthGradient, float offsetX, float offsetY)
+	{
+		float planeDifference = std::fabs(depthGradient.x * offsetX + depthGradient.y * offsetY);
+
+		return std::exp(-std::fabs(centerDepth - depth) / (SVGF_PHI_DEPTH * planeDifference + 1e-3f * centerDepth));
+	}
+}
+
+void SVGFDenoiser::Reset()
+{
+	bHistoryValid = false;
+}
+
+float SVGFDenoiser::Luminance(const TVector3& color)
+{
+	return 0.2126f * color.x + 0.7152f * color.y + 0.0722f * color.z;
+}
+
+float SVGFDenoiser::GetRelativeMSE(const std::vector<TVector3>& image, const std::vector<TVector3>& reference)
+{
+	if (image.empty() || image.size() != reference.size())
+	{
+		return 0.0f;
+	}
+
+	double error = 0.0;
+	for (size_t i = 0; i < image.size(); i++)
+	{
+		const TVector3& a = image[i];
+		const TVector3& b = reference[i];
+
+		error += (a.x - b.x) * (a.x - b.x) / (b.x * b.x + 1e-2f);
+		error += (a.y - b.y) * (a.y - b.y) / (b.y * b.y + 1e-2f);
+		error += (a.z - b.z) * (a.z - b.z) / (b.z * b.z + 1e-2f);
+	}
+
+	return (float)(error / (3.0 * image.size()));
+}
+
+void SVGFDenoiser::Denoise(const SVGFFrameInput& frame, std::vector<TVector3>& outColor)
+{
+	if (frame.width != width || frame.height != height)
+	{
+		width = frame.width;
+		height = frame.height;
+
+		size_t pixelCount = (size_t)width * height;
+		prevNormal.assign(pixelCount, TVector3::Zero);
+		prevDepth.assign(pixelCount, 0.0f);
+		colorHistory.assign(pixelCount, TVector3::Zero);
+		momentsHistory.assign(pixelCount, TVector2(0.0f, 0.0f));
+		prevHistoryLength.assign(pixelCount, 0.0f);
+		illumination.assign(pixelCount, TVector3::Zero);
+		moments.assign(pixelCount, TVector2(0.0f, 0.0f));
+		historyLength.assign(pixelCount, 0.0f);
+		variance.assign(pixelCount, 0.0f);
+		for (int i = 0; i < 2; i++)
+		{
+			filterIllumination[i].assign(pixelCount, TVector3::Zero);
+			filterVariance[i].assign(pixelCount, 0.0f);
+		}
+
+		bHistoryValid = false;
+	}
+
+	TemporalAccumulate(frame);
+
+	EstimateVariance(frame);
+
+	// The variance pass writes the second buffer, iteration i reads the other one of the pair it writes
+	for (int i = 0; i < SVGF_ATROUS_ITERATIONS; i++)
+	{
+		int src = (i + 1) % 2;
+		int dst = i % 2;
+		FilterIteration(frame, 1 << i, filterIllumination[src], filterVariance[src], filterIllumination[dst], filterVariance[dst]);
+
+		// Lightly filtered illumination is accumulated next frame, more would blur the history over time
+		if (i == 0)
+		{
+			colorHistory = filterIllumination[dst];
+		}
+	}
+
+	const std::vector<TVector3>& filtered = filterIllumination[(SVGF_ATROUS_ITERATIONS - 1) % 2];
+
+	outColor.resize((size_t)width * height);
+	for (size_t i = 0; i < outColor.size(); i++)
+	{
+		outColor[i] = IsBackground(frame.normal[i]) ? frame.radiance[i] : filtered[i] * (frame.albedo[i] + TVector3(SVGF_ALBEDO_EPSILON));
+	}
+
+	prevNormal = frame.normal;
+	prevDepth = frame.linearDepth;
+	momentsHistory = moments;
+	prevHistoryLength = historyLength;
+	bHistoryValid = true;
+}
+
+void SVGFDenoiser::TemporalAccumulate(const SVGFFrameInput& frame)
+{
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			size_t index = (size_t)y * width + x;
+			const TVector3& normal = frame.normal[index];
+
+			if (IsBackground(normal))
+			{
+				float luminance = Luminance(frame.radiance[index]);
+				illumination[index] = frame.radiance[index];
+				moments[index] = TVector2(luminance, luminance * luminance);
+				historyLength[index] = 0.0f;
+				continue;
+			}
+
+			TVector3 currentIllumination = frame.radiance[index] / (frame.albedo[index] + TVector3(SVGF_ALBEDO_EPSILON));
+			float luminance = Luminance(currentIllumination);
+			TVector2 currentMoments(luminance, luminance * luminance);
+
+			// Bilinear footprint of the pixel in the previous frame, taps of other surfaces are dropped
+			TVector3 prevIllumination = TVector3::Zero;
+			TVector2 prevMoments(0.0f, 0.0f);
+			float prevLength = 0.0f;
+			float totalWeight = 0.0f;
+
+			if (bHistoryValid)
+			{
+				const TVector2& velocity = frame.velocity[index];
+				float prevX = ((x + 0.5f) / width - velocity.x) * width - 0.5f;
+				float prevY = ((y + 0.5f) / height - velocity.y) * height - 0.5f;
+
+				float floorX = std::floor(prevX);
+				float floorY = std::floor(prevY);
+				float fracX = prevX - floorX;
+				float fracY = prevY - floorY;
+
+				float expectedDepth = frame.prevLinearDepth[index];
+
+				for (int tap = 0; tap < 4; tap++)
+				{
+					int tapX = (int)floorX + (tap & 1);
+					int tapY = (int)floorY + (tap >> 1);
+					if (tapX < 0 || tapY < 0 || tapX >= (int)width || tapY >= (int)height)
+					{
+						continue;
+					}
+
+					size_t tapIndex = (size_t)tapY * width + tapX;
+					if (prevNormal[tapIndex].Dot(normal) < SVGF_REPROJECT_NORMAL_THRESHOLD
+						|| std::fabs(prevDepth[tapIndex] - expectedDepth) > SVGF_REPROJECT_DEPTH_TOLERANCE * expectedDepth)
+					{
+						continue;
+					}
+
+					float weight = ((tap & 1) ? fracX : 1.0f - fracX) * ((tap >> 1) ? fracY : 1.0f - fracY);
+					prevIllumination += colorHistory[tapIndex] * weight;
+					prevMoments.x += momentsHistory[tapIndex].x * weight;
+					prevMoments.y += momentsHistory[tapIndex].y * weight;
+					prevLength += prevHistoryLength[tapIndex] * weight;
+					totalWeight += weight;
+				}
+			}
+
+			// Disoccluded, the pixel starts over
+			if (totalWeight < 0.01f)
+			{
+				illumination[index] = currentIllumination;
+				moments[index] = currentMoments;
+				historyLength[index] = 1.0f;
+				continue;
+			}
+
+			prevIllumination = prevIllumination / totalWeight;
+			prevMoments = prevMoments / totalWeight;
+			float length = (std::min)(prevLength / totalWeight + 1.0f, SVGF_MAX_HISTORY_LENGTH);
+
+			// A plain average until the history is long enough for the exponential one
+			float colorAlpha = (std::max)(SVGF_COLOR_ALPHA, 1.0f / length);
+			float momentsAlpha = (std::max)(SVGF_MOMENTS_ALPHA, 1.0f / length);
+
+			illumination[index] = TVector3::Lerp(prevIllumination, currentIllumination, colorAlpha);
+			moments[index] = TVector2(
+				prevMoments.x + (currentMoments.x - prevMoments.x) * momentsAlpha,
+				prevMoments.y + (currentMoments.y - prevMoments.y) * momentsAlpha);
+			historyLength[index] = length;
+		}
+	}
+}
+
+void SVGFDenoiser::EstimateVariance(const SVGFFrameInput& frame)
+{
+	std::vector<TVector3>& outIllumination = filterIllumination[1];
+	std::vector<float>& outVariance = filterVariance[1];
+
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			size_t index = (size_t)y * width + x;
+			const TVector3& normal = frame.normal[index];
+
+			if (IsBackground(normal) || historyLength[index] >= SVGF_VARIANCE_HISTORY_FRAMES)
+			{
+				const TVector2& m = moments[index];
+				outIllumination[index] = illumination[index];
+				outVariance[index] = (std::max)(m.y - m.x * m.x, 0.0f);
+				variance[index] = outVariance[index];
+				continue;
+			}
+
+			// Too few frames for the temporal moments, the surface around the pixel stands in for them
+			float depth = frame.linearDepth[index];
+			TVector2 depthGradient = GetDepthGradient(frame, x, y);
+
+			TVector3 sumIllumination = TVector3::Zero;
+			TVector2 sumMoments(0.0f, 0.0f);
+			float sumWeight = 0.0f;
+
+			for (int offsetY = -3; offsetY <= 3; offsetY++)
+			{
+				for (int offsetX = -3; offsetX <= 3; offsetX++)
+				{
+					int sampleX = (int)x + offsetX;
+					int sampleY = (int)y + offsetY;
+					if (sampleX < 0 || sampleY < 0 || sampleX >= (int)width || sampleY >= (int)height)
+					{
+						continue;
+					}
+
+					size_t sampleIndex = (size_t)sampleY * width + sampleX;
+					float weight = NormalWeight(normal, frame.normal[sampleIndex])
+						* DepthWeight(depth, frame.linearDepth[sampleIndex], depthGradient, (float)offsetX, (float)offsetY);
+
+					sumIllumination += illumination[sampleIndex] * weight;
+					sumMoments.x += moments[sampleIndex].x * weight;
+					sumMoments.y += moments[sampleIndex].y * weight;
+					sumWeight += weight;
+				}
+			}
+
+			sumIllumination = sumIllumination / sumWeight;
+			sumMoments = sumMoments / sumWeight;
+
+			// Scaled up while the history is short, the first frames are the noisiest
+			outIllumination[index] = sumIllumination;
+			outVariance[index] = (std::max)(sumMoments.y - sumMoments.x * sumMoments.x, 0.0f) * SVGF_VARIANCE_HISTORY_FRAMES / historyLength[index];
+			variance[index] = outVariance[index];
+		}
+	}
+}
+
+void SVGFDenoiser::FilterIteration(const SVGFFrameInput& frame, int stepSize, const std::vector<TVector3>& inIllumination,
+	const std::vector<float>& inVariance, std::vector<TVector3>& outIllumination, std::vector<float>& outVariance) const
+{
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			size_t index = (size_t)y * width + x;
+			const TVector3& normal = frame.normal[index];
+
+			if (IsBackground(normal))
+			{
+				outIllumination[index] = inIllumination[index];
+				outVariance[index] = inVariance[index];
+				continue;
+			}
+
+			// Prefiltered, a single noisy variance would let the noise through
+			float filteredVariance = 0.0f;
+			for (int offsetY = -1; offsetY <= 1; offsetY++)
+			{
+				for (int offsetX = -1; offsetX <= 1; offsetX++)
+				{
+					int sampleX = std::clamp((int)x + offsetX, 0, (int)width - 1);
+					int sampleY = std::clamp((int)y + offsetY, 0, (int)height - 1);
+					filteredVariance += inVariance[(size_t)sampleY * width + sampleX] * VarianceKernel[std::abs(offsetX)] * VarianceKernel[std::abs(offsetY)];
+				}
+			}
+
+			float depth = frame.linearDepth[index];
+			TVector2 depthGradient = GetDepthGradient(frame, x, y);
+			float luminance = Luminance(inIllumination[index]);
+			float luminanceScale = SVGF_PHI_COLOR * std::sqrt((std::max)(filteredVariance, 0.0f)) + 1e-10f;
+
+			TVector3 sumIllumination = TVector3::Zero;
+			float sumVariance = 0.0f;
+			float sumWeight = 0.0f;
+
+			for (int tapY = -2; tapY <= 2; tapY++)
+			{
+				for (int tapX = -2; tapX <= 2; tapX++)
+				{
+					int offsetX = tapX * stepSize;
+					int offsetY = tapY * stepSize;
+					int sampleX = (int)x + offsetX;
+					int sampleY = (int)y + offsetY;
+					if (sampleX < 0 || sampleY < 0 || sampleX >= (int)width || sampleY >= (int)height)
+					{
+						continue;
+					}
+
+					size_t sampleIndex = (size_t)sampleY * width + sampleX;
+					const TVector3& sampleIllumination = inIllumination[sampleIndex];
+
+					float weight = ATrousKernel[std::abs(tapX)] * ATrousKernel[std::abs(tapY)]
+						* NormalWeight(normal, frame.normal[sampleIndex])
+						* DepthWeight(depth, frame.linearDepth[sampleIndex], depthGradient, (float)offsetX, (float)offsetY)
+						* std::exp(-std::fabs(luminance - Luminance(sampleIllumination)) / luminanceScale);
+
+					sumIllumination += sampleIllumination * weight;
+					sumVariance += inVariance[sampleIndex] * weight * weight;
+					sumWeight += weight;
+				}
+			}
+
+			// The center tap always has a weight
+			outIllumination[index] = sumIllumination / sumWeight;
+			outVariance[index] = sumVariance / (sumWeight * sumWeight);
+		}
+	}
+}
+
+TVector2 SVGFDenoiser::GetDepthGradient(const SVGFFrameInput& frame, int x, int y) const
+{
+	float depth = frame.linearDepth[(size_t)y * width + x];
+
+	auto axisGradient = [&](int stepX, int stepY)
+	{
+		float gradient = 0.0f;
+		float smallest = FLT_MAX;
+		for (int sign = -1; sign <= 1; sign += 2)
+		{
+			int sampleX = x + sign * stepX;
+			int sampleY = y + sign * stepY;
+			if (sampleX < 0 || sampleY < 0 || sampleX >= (int)width || sampleY >= (int)height)
+			{
+				continue;
+			}
+
+			size_t sampleIndex = (size_t)sampleY * width + sampleX;
+			if (IsBackground(frame.normal[sampleIndex]))
+			{
+				continue;
+			}
+
+			float difference = (frame.linearDepth[sampleIndex] - depth) * sign;
+			if (std::fabs(difference) < smallest)
+			{
+				smallest = std::fabs(difference);
+				gradient = difference;
+			}
+		}
+
+		return gradient;
+	};
+
+	return TVector2(axisGradient(1, 0), axisGradient(0, 1));
+}
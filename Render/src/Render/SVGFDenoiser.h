@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../Math/Math.h"
+
+// The constants below are mirrored in SVGFCommon.hlsl
+
+// Blend weight of the current frame once the history is long enough, for the illumination and for its moments
+#define SVGF_COLOR_ALPHA 0.2f
+#define SVGF_MOMENTS_ALPHA 0.2f
+
+// History lengths are counted up to this many frames
+#define SVGF_MAX_HISTORY_LENGTH 32.0f
+
+// Below this many frames of history the variance comes from the 7x7 neighbourhood instead of the temporal moments
+#define SVGF_VARIANCE_HISTORY_FRAMES 4.0f
+
+// A history sample is kept when its normal and its depth match the current surface
+#define SVGF_REPROJECT_NORMAL_THRESHOLD 0.9f
+#define SVGF_REPROJECT_DEPTH_TOLERANCE 0.1f    // relative to the depth
+
+// A-trous wavelet iterations, the step doubles every iteration
+#define SVGF_ATROUS_ITERATIONS 5
+
+// Edge stopping functions of the filter
+#define SVGF_PHI_COLOR 4.0f
+#define SVGF_PHI_NORMAL 128.0f
+#define SVGF_PHI_DEPTH 1.0f
+
+// Added to the albedo before the illumination is demodulated, so black surfaces keep their radiance
+#define SVGF_ALBEDO_EPSILON 0.001f
+
+// One frame of the noisy integrator output and the G-buffer it was traced from, row major
+struct SVGFFrameInput
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+
+	std::vector<TVector3> radiance;
+
+	std::vector<TVector3> albedo;
+
+	// World space, unit length. Zero where nothing was hit, those pixels are passed through.
+	std::vector<TVector3> normal;
+
+	// View space depth of the surface, and of the same point seen from the previous camera
+	std::vector<float> linearDepth;
+	std::vector<float> prevLinearDepth;
+
+	// uv motion since the previous frame, as written to GBufferVelocity
+	std::vector<TVector2> velocity;
+};
+
+// Spatiotemporal variance-guided filtering of a low sample count path traced image, the CPU version of the
+// SVGFTemporalAccumCS, VarianceCS and SVGFSpatFilterCS passes. It keeps the same history as the GPU passes between
+// calls, so sequences of frames can be denoised and compared with a reference without a GPU:
+// - the albedo is divided out and the illumination is accumulated over time with its first two luminance moments
+// - young histories get their variance from the neighbourhood instead
+// - an edge-aware a-trous wavelet filter driven by that variance runs SVGF_ATROUS_ITERATIONS times, and the output
+//   of its first iteration is the history of the next frame
+class SVGFDenoiser
+{
+public:
+	// Drops the history, the next frame starts from scratch
+	void Reset();
+
+	void Denoise(const SVGFFrameInput& frame, std::vector<TVector3>& outColor);
+
+	// Frames accumulated per pixel of the last frame
+	const std::vector<float>& GetHistoryLength() const { return historyLength; }
+
+	// Luminance variance per pixel of the last frame, before the filter
+	const std::vector<float>& GetVariance() const { return variance; }
+
+	// Relative mean squared error, the usual denoiser metric, dark pixels do not dominate it
+	static float GetRelativeMSE(const std::vector<TVector3>& image, const std::vector<TVector3>& reference);
+
+	static float Luminance(const TVector3& color);
+
+private:
+	void TemporalAccumulate(const SVGFFrameInput& frame);
+	void EstimateVariance(const SVGFFrameInput& frame);
+	void FilterIteration(const SVGFFrameInput& frame, int stepSize, const std::vector<TVector3>& inIllumination,
+		const std::vector<float>& inVariance, std::vector<TVector3>& outIllumination, std::vector<float>& outVariance) const;
+
+	// Depth change per pixel in x and y, from the smaller one sided difference so edges do not widen it
+	TVector2 GetDepthGradient(const SVGFFrameInput& frame, int x, int y) const;
+
+	static bool IsBackground(const TVector3& normal) { return normal.x == 0.0f && normal.y == 0.0f && normal.z == 0.0f; }
+
+private:
+	uint32_t width = 0;
+	uint32_t height = 0;
+	bool bHistoryValid = false;
+
+	// History
+	std::vector<TVector3> prevNormal;
+	std::vector<float> prevDepth;
+	std::vector<TVector3> colorHistory;
+	std::vector<TVector2> momentsHistory;
+	std::vector<float> prevHistoryLength;
+
+	// Current frame
+	std::vector<TVector3> illumination;
+	std::vector<TVector2> moments;
+	std::vector<float> historyLength;
+	std::vector<float> variance;
+
+	// A-trous ping-pong
+	std::vector<TVector3> filterIllumination[2];
+	std::vector<float> filterVariance[2];
+};
@@ -0,0 +1,354 @@
+#include "ShadowAtlas.h"
+#include <algorithm>
+#include <cmath>
+
+ShadowAtlas::ShadowAtlas(uint32_t atlasSize, uint32_t inMinTileSize, uint32_t inMaxTileSize)
+	:allocator(atlasSize, inMinTileSize)
+{
+	minTileSize = allocator.RoundTileSize(inMinTileSize);
+	maxTileSize = (std::max)(allocator.RoundTileSize(inMaxTileSize), minTileSize);
+}
+
+void ShadowAtlas::Update(const std::vector<ShadowAtlasRequest>& requests, uint32_t faceBudget, std::vector<ShadowAtlasAllocation>& outAllocations)
+{
+	frameIndex++;
+
+	requestEntries.resize(requests.size());
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		const ShadowAtlasRequest& request = requests[i];
+
+		Entry& entry = entries[request.lightId];
+		if (entry.faceCount != request.faceCount)
+		{
+			// The light changed its type
+			FreeTiles(entry);
+			entry.faceCount = request.faceCount;
+		}
+
+		entry.lastRequestFrame = frameIndex;
+		entry.priority = request.priority;
+
+		requestEntries[i] = &entry;
+	}
+
+	// Lights that are gone or no longer shadowed
+	for (auto iter = entries.begin(); iter != entries.end();)
+	{
+		if (iter->second.lastRequestFrame != frameIndex)
+		{
+			FreeTiles(iter->second);
+			iter = entries.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+
+	targetSizes.resize(requests.size());
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		Entry& entry = *requestEntries[i];
+		targetSizes[i] = GetTargetSize(entry, requests[i].desiredSize);
+	}
+
+	FitTargetSizes(requests);
+
+	// Shrinking first leaves room for the lights that grow
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		Entry& entry = *requestEntries[i];
+		if (entry.tileSize > targetSizes[i])
+		{
+			FreeTiles(entry);
+			AllocateLargestTiles(entry, targetSizes[i], minTileSize);
+		}
+	}
+
+	order.resize(requests.size());
+	for (uint32_t i = 0; i < (uint32_t)order.size(); i++)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&requests](uint32_t a, uint32_t b) { return requests[a].priority > requests[b].priority; });
+
+	for (uint32_t requestIndex : order)
+	{
+		Entry& entry = *requestEntries[requestIndex];
+		const uint32_t targetSize = targetSizes[requestIndex];
+
+		if (entry.tileSize >= targetSize)
+		{
+			continue;
+		}
+
+		if (entry.tileSize > 0)
+		{
+			// Grow into new tiles if any larger size fits, the old ones are kept otherwise
+			Entry grown = entry;
+			if (AllocateLargestTiles(grown, targetSize, entry.tileSize * 2))
+			{
+				FreeTiles(entry);
+				entry = grown;
+			}
+			continue;
+		}
+
+		// A light without tiles takes them from the lower priority ones
+		while (!AllocateLargestTiles(entry, targetSize, minTileSize))
+		{
+			if (!EvictBelow(entry.priority, entry))
+			{
+				break;
+			}
+		}
+	}
+
+	// Redraws, lights without a shadow map first and then the ones that waited longest for their priority
+	order.clear();
+	for (uint32_t i = 0; i < (uint32_t)requests.size(); i++)
+	{
+		Entry& entry = *requestEntries[i];
+		if (entry.tileSize > 0 && (!entry.bDrawn || entry.drawnHash != requests[i].contentHash))
+		{
+			order.push_back(i);
+		}
+		else
+		{
+			entry.staleFrames = 0;
+		}
+	}
+
+	auto drawUrgency = [this](uint32_t requestIndex)
+		{
+			const Entry& entry = *requestEntries[requestIndex];
+			return entry.priority * (float)(entry.staleFrames + 1);
+		};
+	std::stable_sort(order.begin(), order.end(), [this, &drawUrgency](uint32_t a, uint32_t b)
+		{
+			if (requestEntries[a]->bDrawn != requestEntries[b]->bDrawn)
+			{
+				return !requestEntries[a]->bDrawn;
+			}
+			return drawUrgency(a) > drawUrgency(b);
+		});
+
+	outAllocations.resize(requests.size());
+	for (ShadowAtlasAllocation& allocation : outAllocations)
+	{
+		allocation.bDrawThisFrame = false;
+	}
+
+	uint32_t remainingFaces = faceBudget;
+	for (uint32_t requestIndex : order)
+	{
+		Entry& entry = *requestEntries[requestIndex];
+		if (entry.faceCount > remainingFaces)
+		{
+			entry.staleFrames++;
+			continue;
+		}
+
+		const ShadowAtlasRequest& request = requests[requestIndex];
+		std::copy(request.faceViewProjs, request.faceViewProjs + entry.faceCount, entry.drawnViewProjs);
+		entry.drawnHash = request.contentHash;
+		entry.bDrawn = true;
+		entry.staleFrames = 0;
+
+		outAllocations[requestIndex].bDrawThisFrame = true;
+		remainingFaces -= entry.faceCount;
+	}
+
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		const Entry& entry = *requestEntries[i];
+		ShadowAtlasAllocation& allocation = outAllocations[i];
+
+		allocation.faceCount = entry.tileSize > 0 ? entry.faceCount : 0;
+		allocation.bDrawn = entry.tileSize > 0 && entry.bDrawn;
+		std::copy(entry.tiles, entry.tiles + allocation.faceCount, allocation.faces);
+		std::copy(entry.drawnViewProjs, entry.drawnViewProjs + allocation.faceCount, allocation.faceViewProjs);
+	}
+}
+
+uint32_t ShadowAtlas::GetTargetSize(const Entry& entry, float desiredSize) const
+{
+	auto roundSize = [this](float size)
+		{
+			uint32_t texels = (uint32_t)std::ceil(std::clamp(size, (float)minTileSize, (float)maxTileSize));
+			return allocator.RoundTileSize(texels);
+		};
+
+	uint32_t targetSize = roundSize(desiredSize);
+
+	if (entry.tileSize > targetSize && roundSize(desiredSize * SHADOW_ATLAS_SHRINK_SLACK) >= entry.tileSize)
+	{
+		return entry.tileSize;
+	}
+
+	return targetSize;
+}
+
+void ShadowAtlas::FitTargetSizes(const std::vector<ShadowAtlasRequest>& requests)
+{
+	const uint64_t atlasArea = (uint64_t)allocator.GetAtlasSize() * allocator.GetAtlasSize();
+
+	uint64_t totalArea = 0;
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		totalArea += (uint64_t)requests[i].faceCount * targetSizes[i] * targetSizes[i];
+	}
+
+	// Halve the light with the most texels for its priority until everything fits, every light keeps a shadow
+	while (totalArea > atlasArea)
+	{
+		size_t largest = requests.size();
+		float largestTexelsPerPriority = 0.0f;
+		for (size_t i = 0; i < requests.size(); i++)
+		{
+			if (targetSizes[i] <= minTileSize)
+			{
+				continue;
+			}
+
+			float texelsPerPriority = (float)targetSizes[i] / (std::max)(requests[i].priority, 1e-6f);
+			if (largest == requests.size() || texelsPerPriority > largestTexelsPerPriority)
+			{
+				largest = i;
+				largestTexelsPerPriority = texelsPerPriority;
+			}
+		}
+
+		// Only min size tiles left, the lowest priority lights go without
+		if (largest == requests.size())
+		{
+			break;
+		}
+
+		uint64_t size = targetSizes[largest];
+		totalArea -= requests[largest].faceCount * (size * size - size * size / 4);
+		targetSizes[largest] /= 2;
+	}
+}
+
+bool ShadowAtlas::AllocateTiles(Entry& entry, uint32_t size)
+{
+	for (uint32_t face = 0; face < entry.faceCount; face++)
+	{
+		if (!allocator.Allocate(size, entry.tiles[face]))
+		{
+			for (uint32_t allocatedFace = 0; allocatedFace < face; allocatedFace++)
+			{
+				allocator.Free(entry.tiles[allocatedFace]);
+			}
+			return false;
+		}
+	}
+
+	entry.tileSize = size;
+
+	// New tiles hold nothing yet
+	entry.bDrawn = false;
+
+	return true;
+}
+
+void ShadowAtlas::FreeTiles(Entry& entry)
+{
+	if (entry.tileSize == 0)
+	{
+		return;
+	}
+
+	for (uint32_t face = 0; face < entry.faceCount; face++)
+	{
+		allocator.Free(entry.tiles[face]);
+	}
+
+	entry.tileSize = 0;
+	entry.bDrawn = false;
+}
+
+bool ShadowAtlas::AllocateLargestTiles(Entry& entry, uint32_t maxSize, uint32_t minSize)
+{
+	// Skips the sizes larger than any free tile
+	uint32_t size = (std::min)(maxSize, allocator.GetLargestFreeSize());
+	for (; size >= minSize && size > 0; size /= 2)
+	{
+		if (AllocateTiles(entry, size))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ShadowAtlas::EvictBelow(float priority, const Entry& exclude)
+{
+	Entry* victim = nullptr;
+	for (auto& [lightId, entry] : entries)
+	{
+		if (&entry != &exclude && entry.tileSize > 0 && entry.priority < priority && (!victim || entry.priority < victim->priority))
+		{
+			victim = &entry;
+		}
+	}
+
+	if (!victim)
+	{
+		return false;
+	}
+
+	FreeTiles(*victim);
+
+	return true;
+}
+
+TMatrix ShadowAtlas::GetSpotLightViewProj(const TVector3& position, const TVector3& direction, float range, float outerConeAngle)
+{
+	TVector3 forward = direction;
+	forward.Normalize();
+
+	TVector3 up = std::abs(forward.y) < 0.99f ? TVector3(0.0f, 1.0f, 0.0f) : TVector3(1.0f, 0.0f, 0.0f);
+
+	float halfAngle = std::clamp(outerConeAngle, 1.0f, LOCAL_SHADOW_MAX_SPOT_ANGLE) * (TMath::Pi / 180.0f);
+	float nearZ = (std::min)(LOCAL_SHADOW_NEAR_Z, range * 0.5f);
+
+	TMatrix view = TMatrix::CreateLookAt(position, position + forward, up);
+	TMatrix proj = TMatrix::CreatePerspectiveFieldOfView(2.0f * halfAngle, 1.0f, nearZ, range);
+
+	return view * proj;
+}
+
+TMatrix ShadowAtlas::GetPointLightFaceViewProj(const TVector3& position, float range, uint32_t face)
+{
+	// Same faces as SceneCaptureCube, Shadows.hlsl picks them by the major axis of the direction from the light
+	static const TVector3 directions[6] =
+	{
+		TVector3(1.0f,  0.0f,  0.0f),
+		TVector3(-1.0f, 0.0f,  0.0f),
+		TVector3(0.0f,  1.0f,  0.0f),
+		TVector3(0.0f, -1.0f,  0.0f),
+		TVector3(0.0f,  0.0f,  1.0f),
+		TVector3(0.0f,  0.0f, -1.0f)
+	};
+
+	static const TVector3 ups[6] =
+	{
+		TVector3(0.0f, 1.0f,  0.0f),
+		TVector3(0.0f, 1.0f,  0.0f),
+		TVector3(0.0f, 0.0f, -1.0f),
+		TVector3(0.0f, 0.0f,  1.0f),
+		TVector3(0.0f, 1.0f,  0.0f),
+		TVector3(0.0f, 1.0f,  0.0f)
+	};
+
+	float nearZ = (std::min)(LOCAL_SHADOW_NEAR_Z, range * 0.5f);
+
+	TMatrix view = TMatrix::CreateLookAt(position, position + directions[face], ups[face]);
+	TMatrix proj = TMatrix::CreatePerspectiveFieldOfView(0.5f * TMath::Pi, 1.0f, nearZ, range);
+
+	return view * proj;
+}
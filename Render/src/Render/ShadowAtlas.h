@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "../Math/Math.h"
+#include "ShadowAtlasAllocator.h"
+
+// Shadow maps of the point and spot lights share one depth texture of this size, mirrored in Shadows.hlsl
+#define SHADOW_ATLAS_SIZE 4096
+
+// Texels per side of a face, a point light has six faces of the same size
+#define SHADOW_ATLAS_MIN_TILE_SIZE 64
+#define SHADOW_ATLAS_MAX_TILE_SIZE 1024
+
+// A tile only shrinks once the light wants less than the smaller size divided by this, so it does not flip every frame
+#define SHADOW_ATLAS_SHRINK_SLACK 1.5f
+
+#define LOCAL_SHADOW_MAX_FACES 6
+#define LOCAL_SHADOW_NEAR_Z 0.05f
+
+// Wider spot cones are cut to this half angle in degrees, the projection degenerates towards 90
+#define LOCAL_SHADOW_MAX_SPOT_ANGLE 80.0f
+
+struct ShadowAtlasRequest
+{
+	// Identifies the light between frames
+	uint32_t lightId = 0;
+
+	// 6 for point lights, 1 for spot lights
+	uint32_t faceCount = 1;
+
+	// Texels per face side the light would like, from its screen coverage
+	float desiredSize = 0.0f;
+
+	// Higher ones get their tiles and their redraws first
+	float priority = 0.0f;
+
+	// Light and casters, tiles drawn for another hash are redrawn
+	uint64_t contentHash = 0;
+
+	TMatrix faceViewProjs[LOCAL_SHADOW_MAX_FACES];
+};
+
+struct ShadowAtlasAllocation
+{
+	// 0 when the light got no tiles
+	uint32_t faceCount = 0;
+	ShadowAtlasTile faces[LOCAL_SHADOW_MAX_FACES];
+
+	// What the tiles hold, older than the request while its redraw waits for the budget
+	TMatrix faceViewProjs[LOCAL_SHADOW_MAX_FACES];
+
+	// The tiles hold a shadow map, lights without one are not shadowed
+	bool bDrawn = false;
+
+	// The caller draws the faces this frame
+	bool bDrawThisFrame = false;
+};
+
+// Decides which tiles of the shadow atlas each shadowed point and spot light gets and which ones are drawn this frame.
+// Tiles are kept while their light is requested and only redrawn when its content hash changes, at most a budget of
+// faces per frame. Lights that got no tile take the tiles of lower priority ones.
+// Only works on sizes and matrices, so it runs without a GPU.
+class ShadowAtlas
+{
+public:
+	ShadowAtlas(uint32_t atlasSize = SHADOW_ATLAS_SIZE, uint32_t inMinTileSize = SHADOW_ATLAS_MIN_TILE_SIZE,
+		uint32_t inMaxTileSize = SHADOW_ATLAS_MAX_TILE_SIZE);
+
+	// Call once per frame with every light that should be shadowed, lights missing from requests give their tiles back.
+	// outAllocations has one entry per request.
+	void Update(const std::vector<ShadowAtlasRequest>& requests, uint32_t faceBudget, std::vector<ShadowAtlasAllocation>& outAllocations);
+
+	const ShadowAtlasAllocator& GetAllocator() const { return allocator; }
+
+	// Row vector view-projection matrices of the faces, with a D3D depth range
+	static TMatrix GetSpotLightViewProj(const TVector3& position, const TVector3& direction, float range, float outerConeAngle);
+	static TMatrix GetPointLightFaceViewProj(const TVector3& position, float range, uint32_t face);
+
+private:
+	struct Entry
+	{
+		uint32_t faceCount = 0;
+
+		// 0 while the light has no tiles
+		uint32_t tileSize = 0;
+		ShadowAtlasTile tiles[LOCAL_SHADOW_MAX_FACES];
+
+		TMatrix drawnViewProjs[LOCAL_SHADOW_MAX_FACES];
+		uint64_t drawnHash = 0;
+		bool bDrawn = false;
+
+		// Frames the tiles waited for a redraw, so low priority lights are not starved
+		uint32_t staleFrames = 0;
+
+		uint64_t lastRequestFrame = 0;
+		float priority = 0.0f;
+	};
+
+	uint32_t GetTargetSize(const Entry& entry, float desiredSize) const;
+
+	// Shrinks targetSizes until the tiles of all requests fit in the atlas together
+	void FitTargetSizes(const std::vector<ShadowAtlasRequest>& requests);
+
+	// All faces or none
+	bool AllocateTiles(Entry& entry, uint32_t size);
+	void FreeTiles(Entry& entry);
+
+	// Tries the sizes from maxSize down to minSize
+	bool AllocateLargestTiles(Entry& entry, uint32_t maxSize, uint32_t minSize);
+
+	// Frees the tiles of the lowest priority light below priority, false when there is none
+	bool EvictBelow(float priority, const Entry& exclude);
+
+private:
+	ShadowAtlasAllocator allocator;
+	uint32_t minTileSize = 0;
+	uint32_t maxTileSize = 0;
+
+	std::unordered_map<uint32_t, Entry> entries;
+	uint64_t frameIndex = 0;
+
+	// Kept between frames so Update does not allocate
+	std::vector<Entry*> requestEntries;
+	std::vector<uint32_t> targetSizes;
+	std::vector<uint32_t> order;
+};
@@ -0,0 +1,211 @@
+#include "ShadowAtlasAllocator.h"
+#include <assert.h>
+#include <algorithm>
+#include <bit>
+
+ShadowAtlasAllocator::ShadowAtlasAllocator(uint32_t inAtlasSize, uint32_t inMinTileSize)
+	:atlasSize(std::bit_ceil(inAtlasSize)),
+	minTileSize((std::min)(std::bit_ceil(inMinTileSize), std::bit_ceil(inAtlasSize)))
+{
+	levelCount = (uint32_t)std::countr_zero(atlasSize / minTileSize) + 1;
+
+	uint32_t nodeCount = 0;
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		levelOffsets.push_back(nodeCount);
+		nodeCount += GetLevelWidth(level) * GetLevelWidth(level);
+	}
+
+	states.resize(nodeCount);
+	freeNodes.resize(levelCount);
+
+	Reset();
+}
+
+void ShadowAtlasAllocator::Reset()
+{
+	std::fill(states.begin(), states.end(), ENodeState::Unused);
+	for (std::vector<uint32_t>& levelFreeNodes : freeNodes)
+	{
+		levelFreeNodes.clear();
+	}
+
+	PushFree(0, 0);
+
+	allocatedCount = 0;
+	allocatedArea = 0;
+}
+
+uint32_t ShadowAtlasAllocator::RoundTileSize(uint32_t size) const
+{
+	return std::clamp(std::bit_ceil(size), minTileSize, atlasSize);
+}
+
+uint32_t ShadowAtlasAllocator::GetLevel(uint32_t size) const
+{
+	return (uint32_t)std::countr_zero(atlasSize / RoundTileSize(size));
+}
+
+bool ShadowAtlasAllocator::Allocate(uint32_t size, ShadowAtlasTile& outTile)
+{
+	const uint32_t targetLevel = GetLevel(size);
+
+	// Smallest free tile that holds the request
+	int32_t level = (int32_t)targetLevel;
+	while (level >= 0 && freeNodes[level].empty())
+	{
+		level--;
+	}
+
+	if (level < 0)
+	{
+		return false;
+	}
+
+	// The free tile with the fewest free siblings, so the parents that are nearly free can still merge
+	std::vector<uint32_t>& levelFreeNodes = freeNodes[level];
+	size_t bestIndex = 0;
+	uint32_t bestFreeSiblings = UINT32_MAX;
+	for (size_t i = 0; i < levelFreeNodes.size() && bestFreeSiblings > 0; i++)
+	{
+		uint32_t freeSiblings = CountFreeSiblings(level, levelFreeNodes[i]);
+		if (freeSiblings < bestFreeSiblings)
+		{
+			bestIndex = i;
+			bestFreeSiblings = freeSiblings;
+		}
+	}
+
+	uint32_t node = levelFreeNodes[bestIndex];
+	levelFreeNodes[bestIndex] = levelFreeNodes.back();
+	levelFreeNodes.pop_back();
+
+	// Split down to the requested size, the first child is kept and its siblings become free
+	for (; (uint32_t)level < targetLevel; level++)
+	{
+		GetState(level, node) = ENodeState::Split;
+
+		const uint32_t width = GetLevelWidth(level);
+		const uint32_t childX = (node % width) * 2;
+		const uint32_t childY = (node / width) * 2;
+		const uint32_t childWidth = width * 2;
+
+		node = childY * childWidth + childX;
+		PushFree(level + 1, node + 1);
+		PushFree(level + 1, node + childWidth);
+		PushFree(level + 1, node + childWidth + 1);
+	}
+
+	GetState(targetLevel, node) = ENodeState::Allocated;
+
+	const uint32_t width = GetLevelWidth(targetLevel);
+	outTile.size = GetLevelSize(targetLevel);
+	outTile.x = (node % width) * outTile.size;
+	outTile.y = (node / width) * outTile.size;
+	outTile.level = targetLevel;
+	outTile.node = node;
+
+	allocatedCount++;
+	allocatedArea += (uint64_t)outTile.size * outTile.size;
+
+	return true;
+}
+
+void ShadowAtlasAllocator::Free(ShadowAtlasTile& tile)
+{
+	assert(tile.IsValid() && GetState(tile.level, tile.node) == ENodeState::Allocated && "tile freed twice");
+
+	allocatedCount--;
+	allocatedArea -= (uint64_t)tile.size * tile.size;
+
+	uint32_t level = tile.level;
+	uint32_t node = tile.node;
+	GetState(level, node) = ENodeState::Unused;
+
+	// Merge while the three siblings are free too
+	while (level > 0 && CountFreeSiblings(level, node) == 3)
+	{
+		uint32_t siblings[4];
+		GetSiblings(level, node, siblings);
+
+		for (uint32_t sibling : siblings)
+		{
+			if (sibling != node)
+			{
+				RemoveFree(level, sibling);
+			}
+		}
+
+		const uint32_t width = GetLevelWidth(level);
+		const uint32_t parentWidth = width / 2;
+		node = (node / width) / 2 * parentWidth + (node % width) / 2;
+		level--;
+
+		GetState(level, node) = ENodeState::Unused;
+	}
+
+	PushFree(level, node);
+
+	tile = ShadowAtlasTile();
+}
+
+void ShadowAtlasAllocator::GetSiblings(uint32_t level, uint32_t node, uint32_t outSiblings[4]) const
+{
+	const uint32_t width = GetLevelWidth(level);
+	const uint32_t firstSibling = (node / width) / 2 * 2 * width + (node % width) / 2 * 2;
+
+	outSiblings[0] = firstSibling;
+	outSiblings[1] = firstSibling + 1;
+	outSiblings[2] = firstSibling + width;
+	outSiblings[3] = firstSibling + width + 1;
+}
+
+uint32_t ShadowAtlasAllocator::CountFreeSiblings(uint32_t level, uint32_t node) const
+{
+	if (level == 0)
+	{
+		return 0;
+	}
+
+	uint32_t siblings[4];
+	GetSiblings(level, node, siblings);
+
+	uint32_t freeCount = 0;
+	for (uint32_t sibling : siblings)
+	{
+		freeCount += sibling != node && states[levelOffsets[level] + sibling] == ENodeState::Free;
+	}
+
+	return freeCount;
+}
+
+uint32_t ShadowAtlasAllocator::GetLargestFreeSize() const
+{
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		if (!freeNodes[level].empty())
+		{
+			return GetLevelSize(level);
+		}
+	}
+
+	return 0;
+}
+
+void ShadowAtlasAllocator::PushFree(uint32_t level, uint32_t node)
+{
+	GetState(level, node) = ENodeState::Free;
+	freeNodes[level].push_back(node);
+}
+
+void ShadowAtlasAllocator::RemoveFree(uint32_t level, uint32_t node)
+{
+	GetState(level, node) = ENodeState::Unused;
+
+	std::vector<uint32_t>& levelFreeNodes = freeNodes[level];
+	auto iter = std::find(levelFreeNodes.begin(), levelFreeNodes.end(), node);
+	assert(iter != levelFreeNodes.end());
+
+	*iter = levelFreeNodes.back();
+	levelFreeNodes.pop_back();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct ShadowAtlasTile
+{
+	// Texels, from the top left corner of the atlas
+	uint32_t x = 0;
+	uint32_t y = 0;
+	uint32_t size = 0;
+
+	// Quadtree level and node index in the level, needed to free the tile
+	uint32_t level = 0;
+	uint32_t node = UINT32_MAX;
+
+	bool IsValid() const { return node != UINT32_MAX; }
+};
+
+// Square power of two tiles in a square power of two atlas. The atlas is a quadtree: a free tile is cut into four when
+// a smaller one is needed, and four free siblings merge back into their parent. A tile always comes from the smallest
+// free tile that holds it, so the free space stays in as few large tiles as possible.
+// Knows nothing about textures, so it runs without a GPU.
+class ShadowAtlasAllocator
+{
+public:
+	ShadowAtlasAllocator(uint32_t inAtlasSize, uint32_t inMinTileSize);
+
+	ShadowAtlasAllocator(const ShadowAtlasAllocator& Other) = delete;
+	ShadowAtlasAllocator& operator=(const ShadowAtlasAllocator& Other) = delete;
+
+	// size is rounded up to a power of two of at least the min tile size. False when no free tile is large enough.
+	bool Allocate(uint32_t size, ShadowAtlasTile& outTile);
+
+	void Free(ShadowAtlasTile& tile);
+
+	// Frees every tile
+	void Reset();
+
+	// Largest tile Allocate would succeed with, 0 when the atlas is full
+	uint32_t GetLargestFreeSize() const;
+
+	uint32_t GetAtlasSize() const { return atlasSize; }
+	uint32_t GetMinTileSize() const { return minTileSize; }
+	uint32_t GetAllocatedCount() const { return allocatedCount; }
+	uint64_t GetAllocatedArea() const { return allocatedArea; }
+
+	// Power of two tile size for size texels, clamped to the atlas
+	uint32_t RoundTileSize(uint32_t size) const;
+
+private:
+	enum class ENodeState : uint8_t
+	{
+		Unused,    // inside a free or an allocated tile of a lower level
+		Free,
+		Split,
+		Allocated,
+	};
+
+	uint32_t GetLevel(uint32_t size) const;
+	uint32_t GetLevelSize(uint32_t level) const { return atlasSize >> level; }
+	uint32_t GetLevelWidth(uint32_t level) const { return 1u << level; }
+
+	ENodeState& GetState(uint32_t level, uint32_t node) { return states[levelOffsets[level] + node]; }
+
+	// The four children of the parent of node, node included
+	void GetSiblings(uint32_t level, uint32_t node, uint32_t outSiblings[4]) const;
+	uint32_t CountFreeSiblings(uint32_t level, uint32_t node) const;
+
+	void PushFree(uint32_t level, uint32_t node);
+	void RemoveFree(uint32_t level, uint32_t node);
+
+private:
+	uint32_t atlasSize = 0;
+	uint32_t minTileSize = 0;
+
+	// Level 0 is the whole atlas, each level halves the tile size. Nodes of a level are row major.
+	uint32_t levelCount = 0;
+	std::vector<uint32_t> levelOffsets;
+	std::vector<ENodeState> states;
+
+	// Free tiles per level
+	std::vector<std::vector<uint32_t>> freeNodes;
+
+	uint32_t allocatedCount = 0;
+	uint64_t allocatedArea = 0;
+};
@@ -0,0 +1,122 @@
+#include "ShadowCascades.h"
+#include <algorithm>
+#include <cmath>
+
+uint32_t ShadowCascadeFitter::Fit(const TMatrix& cameraView, float nearZ, float farZ, float fovY, float aspect, const TVector3& inLightDirection)
+{
+	TVector3 direction = inLightDirection;
+	direction.Normalize();
+
+	// Turning the light moves every cascade
+	bool bLightChanged = !bFitted || direction != lightDirection;
+	if (bLightChanged)
+	{
+		lightDirection = direction;
+		GetLightBasis(lightDirection, lightRight, lightUp);
+	}
+
+	TMatrix invView = cameraView.Invert();
+	TVector3 cameraPosition(invView._41, invView._42, invView._43);
+	TVector3 cameraForward(invView._31, invView._32, invView._33);
+
+	float splits[CSM_CASCADE_COUNT + 1];
+	float shadowFarZ = (std::max)((std::min)(farZ, CSM_MAX_DISTANCE), nearZ * 2.0f);
+	ComputeSplits(nearZ, shadowFarZ, CSM_SPLIT_LAMBDA, splits);
+
+	float tanHalfFovY = std::tan(fovY * 0.5f);
+
+	uint32_t changedMask = 0;
+	for (int i = 0; i < CSM_CASCADE_COUNT; i++)
+	{
+		float centerDepth, radius;
+		ComputeSplitSphere(splits[i], splits[i + 1], tanHalfFovY, aspect, centerDepth, radius);
+
+		TVector3 center = cameraPosition + cameraForward * centerDepth;
+		float paddedRadius = radius * (1.0f + CSM_RECENTER_SLACK);
+
+		ShadowCascade& cascade = cascades[i];
+		cascade.splitNear = splits[i];
+		cascade.splitFar = splits[i + 1];
+
+		// The radius only changes with the lens, the old sphere is kept while it contains the new one
+		if (!bLightChanged && cascade.sphereRadius == paddedRadius
+			&& TVector3::Distance(center, cascade.sphereCenter) + radius <= paddedRadius)
+		{
+			continue;
+		}
+
+		FitCascade(cascade, center, paddedRadius);
+		cascade.revision++;
+
+		changedMask |= 1u << i;
+	}
+
+	bFitted = true;
+
+	return changedMask;
+}
+
+void ShadowCascadeFitter::FitCascade(ShadowCascade& cascade, const TVector3& center, float radius)
+{
+	cascade.sphereRadius = radius;
+	cascade.texelSize = 2.0f * radius / CSM_CASCADE_RESOLUTION;
+
+	// Texel edges are at whole multiples of the texel size along the light axes, for every center
+	float x = std::floor(center.Dot(lightRight) / cascade.texelSize) * cascade.texelSize;
+	float y = std::floor(center.Dot(lightUp) / cascade.texelSize) * cascade.texelSize;
+	float z = center.Dot(lightDirection);
+	cascade.sphereCenter = lightRight * x + lightUp * y + lightDirection * z;
+
+	// The near plane is pulled towards the light so casters outside the sphere are kept
+	TVector3 eye = cascade.sphereCenter - lightDirection * CSM_CASTER_DISTANCE;
+	cascade.view = TMatrix::CreateLookAt(eye, cascade.sphereCenter, lightUp);
+	cascade.proj = TMatrix::CreateOrthographicOffCenter(-radius, radius, -radius, radius, 0.0f, CSM_CASTER_DISTANCE + radius);
+	cascade.viewProj = cascade.view * cascade.proj;
+}
+
+void ShadowCascadeFitter::ComputeSplits(float nearZ, float farZ, float lambda, float* outSplits)
+{
+	for (int i = 0; i <= CSM_CASCADE_COUNT; i++)
+	{
+		float t = (float)i / CSM_CASCADE_COUNT;
+		float logSplit = nearZ * std::pow(farZ / nearZ, t);
+		float uniformSplit = nearZ + (farZ - nearZ) * t;
+
+		outSplits[i] = lambda * logSplit + (1.0f - lambda) * uniformSplit;
+	}
+
+	outSplits[0] = nearZ;
+	outSplits[CSM_CASCADE_COUNT] = farZ;
+}
+
+void ShadowCascadeFitter::ComputeSplitSphere(float splitNear, float splitFar, float tanHalfFovY, float aspect, float& outCenterDepth, float& outRadius)
+{
+	// Squared distance of a frustum corner from the view axis, per squared view depth
+	float cornerSlope2 = tanHalfFovY * tanHalfFovY * (1.0f + aspect * aspect);
+
+	// Equally far from the near and the far corners
+	float centerDepth = 0.5f * (splitNear + splitFar) * (1.0f + cornerSlope2);
+
+	// Wide splits are bounded by their far face alone
+	if (centerDepth >= splitFar)
+	{
+		outCenterDepth = splitFar;
+		outRadius = splitFar * std::sqrt(cornerSlope2);
+	}
+	else
+	{
+		float farDistance = splitFar - centerDepth;
+		outCenterDepth = centerDepth;
+		outRadius = std::sqrt(farDistance * farDistance + cornerSlope2 * splitFar * splitFar);
+	}
+}
+
+void ShadowCascadeFitter::GetLightBasis(const TVector3& lightDirection, TVector3& outRight, TVector3& outUp)
+{
+	// Same axes as TMatrix::CreateLookAt, with any up that is not parallel to the light
+	TVector3 worldUp = std::abs(lightDirection.y) < 0.99f ? TVector3(0.0f, 1.0f, 0.0f) : TVector3(1.0f, 0.0f, 0.0f);
+
+	outRight = worldUp.Cross(lightDirection);
+	outRight.Normalize();
+	outUp = lightDirection.Cross(outRight);
+}
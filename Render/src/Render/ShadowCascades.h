@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include "../Math/Math.h"
+
+#define CSM_CASCADE_COUNT 4
+
+// Texels per side of one cascade, the cascades are tiles of one shadow map CSM_ATLAS_COLUMNS wide
+#define CSM_CASCADE_RESOLUTION 2048
+#define CSM_ATLAS_COLUMNS 2
+#define CSM_ATLAS_ROWS ((CSM_CASCADE_COUNT + CSM_ATLAS_COLUMNS - 1) / CSM_ATLAS_COLUMNS)
+
+// Shadows end here even when the camera sees farther
+#define CSM_MAX_DISTANCE 200.0f
+
+// Blend between logarithmic (1) and uniform (0) split distances
+#define CSM_SPLIT_LAMBDA 0.8f
+
+// Cascades are enlarged by this fraction of their radius, the camera moves that far before a cascade is re-centered
+#define CSM_RECENTER_SLACK 0.1f
+
+// Casters this far towards the light from a cascade still shadow it
+#define CSM_CASTER_DISTANCE 500.0f
+
+struct ShadowCascade
+{
+	TMatrix view = TMatrix::Identity;
+	TMatrix proj = TMatrix::Identity;
+	TMatrix viewProj = TMatrix::Identity;
+
+	// View depth range of the camera covered by the cascade
+	float splitNear = 0.0f;
+	float splitFar = 0.0f;
+
+	// Covers the split and the slack, the shadow map tile is the square around it
+	TVector3 sphereCenter = TVector3::Zero;
+	float sphereRadius = 0.0f;
+
+	// World units per shadow map texel
+	float texelSize = 0.0f;
+
+	// Changes whenever the matrices do, shadow maps cached for an older revision are stale
+	uint32_t revision = 0;
+};
+
+// Fits the directional light cascades to the camera. The fit is stable: a cascade is a sphere around its split of the
+// camera frustum, so rotating the camera does not resize it, and its center is snapped to whole shadow map texels in
+// light space, so moving the camera does not make the shadow edges crawl. A cascade keeps its matrices while the
+// sphere still contains its split.
+class ShadowCascadeFitter
+{
+public:
+	// cameraView is a row vector view matrix with +z forward. Returns a bit per cascade whose matrices changed.
+	uint32_t Fit(const TMatrix& cameraView, float nearZ, float farZ, float fovY, float aspect, const TVector3& lightDirection);
+
+	const ShadowCascade& GetCascade(int index) const { return cascades[index]; }
+
+	// Practical split scheme, CSM_CASCADE_COUNT + 1 view depths from nearZ to farZ
+	static void ComputeSplits(float nearZ, float farZ, float lambda, float* outSplits);
+
+	// Smallest sphere around the part of the camera frustum between two view depths, its center is on the view axis
+	static void ComputeSplitSphere(float splitNear, float splitFar, float tanHalfFovY, float aspect, float& outCenterDepth, float& outRadius);
+
+	// Light space axes, the same for every cascade so snapping is consistent between them
+	static void GetLightBasis(const TVector3& lightDirection, TVector3& outRight, TVector3& outUp);
+
+private:
+	void FitCascade(ShadowCascade& cascade, const TVector3& center, float radius);
+
+private:
+	ShadowCascade cascades[CSM_CASCADE_COUNT];
+
+	TVector3 lightDirection = TVector3::Zero;
+	TVector3 lightRight = TVector3::Zero;
+	TVector3 lightUp = TVector3::Zero;
+
+	bool bFitted = false;
+};
@@ -0,0 +1,189 @@
+#include "TemporalAA.h"
+#include "Sampler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+void TAAColorImage::Resize(uint32_t inWidth, uint32_t inHeight)
+{
+	width = inWidth;
+	height = inHeight;
+	pixels.assign((size_t)width * height, TVector3::Zero);
+}
+
+const TVector3& TAAColorImage::Load(int x, int y) const
+{
+	x = std::clamp(x, 0, (int)width - 1);
+	y = std::clamp(y, 0, (int)height - 1);
+
+	return pixels[(size_t)y * width + x];
+}
+
+TVector3 TAAColorImage::SampleBilinear(const TVector2& uv) const
+{
+	// Texel centers are at half texels
+	float texelX = uv.x * width - 0.5f;
+	float texelY = uv.y * height - 0.5f;
+
+	float floorX = std::floor(texelX);
+	float floorY = std::floor(texelY);
+	float fracX = texelX - floorX;
+	float fracY = texelY - floorY;
+
+	int x0 = (int)floorX;
+	int y0 = (int)floorY;
+
+	TVector3 top = TVector3::Lerp(Load(x0, y0), Load(x0 + 1, y0), fracX);
+	TVector3 bottom = TVector3::Lerp(Load(x0, y0 + 1), Load(x0 + 1, y0 + 1), fracX);
+
+	return TVector3::Lerp(top, bottom, fracY);
+}
+
+TVector2 TemporalAA::GetJitter(uint32_t frameIndex, uint32_t width, uint32_t height)
+{
+	uint32_t sampleIndex = frameIndex % TAA_SAMPLE_COUNT;
+
+	// NDC spans two pixels per pixel, the Halton points are within (-1, 1)
+	return TVector2((float)(Halton_2[sampleIndex] / (double)width), (float)(Halton_3[sampleIndex] / (double)height));
+}
+
+TVector3 TemporalAA::RGBToYCoCg(const TVector3& color)
+{
+	return TVector3(
+		0.25f * color.x + 0.5f * color.y + 0.25f * color.z,
+		0.5f * color.x - 0.5f * color.z,
+		-0.25f * color.x + 0.5f * color.y - 0.25f * color.z);
+}
+
+TVector3 TemporalAA::YCoCgToRGB(const TVector3& color)
+{
+	return TVector3(
+		color.x + color.y - color.z,
+		color.x + color.z,
+		color.x - color.y - color.z);
+}
+
+TVector3 TemporalAA::ClipToAABB(const TVector3& color, const TVector3& boxMin, const TVector3& boxMax)
+{
+	TVector3 center = 0.5f * (boxMax + boxMin);
+	TVector3 extents = 0.5f * (boxMax - boxMin) + TVector3(1e-5f);
+
+	// Offset from the center in box half sizes, the largest one tells how far outside the box the color is
+	TVector3 offset = color - center;
+	TVector3 units = offset / extents;
+	float maxUnit = (std::max)({ std::abs(units.x), std::abs(units.y), std::abs(units.z) });
+
+	if (maxUnit > 1.0f)
+	{
+		return center + offset / maxUnit;
+	}
+
+	return color;
+}
+
+TVector3 TemporalAA::SampleHistory(const TAAColorImage& history, const TVector2& uv)
+{
+	const TVector2 size((float)history.width, (float)history.height);
+
+	TVector2 samplePos = uv * size;
+	TVector2 texPos1(std::floor(samplePos.x - 0.5f) + 0.5f, std::floor(samplePos.y - 0.5f) + 0.5f);
+	TVector2 f = samplePos - texPos1;
+
+	// Catmull-Rom weights of the four texels per axis
+	TVector2 w0 = f * (TVector2(-0.5f) + f * (TVector2(1.0f) - 0.5f * f));
+	TVector2 w1 = TVector2(1.0f) + f * f * (TVector2(-2.5f) + 1.5f * f);
+	TVector2 w2 = f * (TVector2(0.5f) + f * (TVector2(2.0f) - 1.5f * f));
+	TVector2 w3 = f * f * (TVector2(-0.5f) + 0.5f * f);
+
+	// The two middle texels are one bilinear fetch
+	TVector2 w12 = w1 + w2;
+	TVector2 texPos0 = (texPos1 - TVector2(1.0f)) / size;
+	TVector2 texPos3 = (texPos1 + TVector2(2.0f)) / size;
+	TVector2 texPos12 = (texPos1 + w2 / w12) / size;
+
+	TVector3 result = TVector3::Zero;
+	result += history.SampleBilinear(TVector2(texPos12.x, texPos0.y)) * (w12.x * w0.y);
+	result += history.SampleBilinear(TVector2(texPos0.x, texPos12.y)) * (w0.x * w12.y);
+	result += history.SampleBilinear(TVector2(texPos12.x, texPos12.y)) * (w12.x * w12.y);
+	result += history.SampleBilinear(TVector2(texPos3.x, texPos12.y)) * (w3.x * w12.y);
+	result += history.SampleBilinear(TVector2(texPos12.x, texPos3.y)) * (w12.x * w3.y);
+
+	float totalWeight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+
+	// The negative lobes can ring below zero
+	return TVector3::Max(result / totalWeight, TVector3::Zero);
+}
+
+TVector3 TemporalAA::ResolvePixel(const TAAColorImage& current, const TAAColorImage& history, const std::vector<TVector2>& velocity,
+	uint32_t x, uint32_t y, bool bHistoryValid)
+{
+	const TVector3& currentColor = current.Load((int)x, (int)y);
+
+	if (!bHistoryValid)
+	{
+		return currentColor;
+	}
+
+	const TVector2& pixelVelocity = velocity[(size_t)y * current.width + x];
+	TVector2 uv(((float)x + 0.5f) / current.width, ((float)y + 0.5f) / current.height);
+	TVector2 prevUV = uv - pixelVelocity;
+
+	// Nothing to reproject from off screen
+	if (prevUV.x < 0.0f || prevUV.x > 1.0f || prevUV.y < 0.0f || prevUV.y > 1.0f)
+	{
+		return currentColor;
+	}
+
+	// Mean and variance of the neighbourhood
+	TVector3 moment1 = TVector3::Zero;
+	TVector3 moment2 = TVector3::Zero;
+	TVector3 neighbourMin(FLT_MAX);
+	TVector3 neighbourMax(-FLT_MAX);
+	for (int offsetY = -1; offsetY <= 1; offsetY++)
+	{
+		for (int offsetX = -1; offsetX <= 1; offsetX++)
+		{
+			TVector3 neighbour = RGBToYCoCg(current.Load((int)x + offsetX, (int)y + offsetY));
+			moment1 += neighbour;
+			moment2 += neighbour * neighbour;
+			neighbourMin = TVector3::Min(neighbourMin, neighbour);
+			neighbourMax = TVector3::Max(neighbourMax, neighbour);
+		}
+	}
+
+	TVector3 mean = moment1 / 9.0f;
+	TVector3 variance = TVector3::Max(moment2 / 9.0f - mean * mean, TVector3::Zero);
+	TVector3 sigma(std::sqrt(variance.x), std::sqrt(variance.y), std::sqrt(variance.z));
+
+	TVector3 boxMin = TVector3::Max(mean - TAA_VARIANCE_CLIP_GAMMA * sigma, neighbourMin);
+	TVector3 boxMax = TVector3::Min(mean + TAA_VARIANCE_CLIP_GAMMA * sigma, neighbourMax);
+
+	TVector3 historyColor = ClipToAABB(RGBToYCoCg(SampleHistory(history, prevUV)), boxMin, boxMax);
+	TVector3 currentYCoCg = RGBToYCoCg(currentColor);
+
+	TVector2 motion = pixelVelocity * TVector2((float)current.width, (float)current.height);
+	float motionPixels = std::sqrt(motion.x * motion.x + motion.y * motion.y);
+	float blendWeight = TAA_CURRENT_FRAME_WEIGHT + TAA_MOTION_FRAME_WEIGHT * (std::min)(motionPixels, 1.0f);
+
+	// Weighting by inverse luma keeps single bright samples from flickering
+	float currentWeight = blendWeight / (1.0f + (std::max)(currentYCoCg.x, 0.0f));
+	float historyWeight = (1.0f - blendWeight) / (1.0f + (std::max)(historyColor.x, 0.0f));
+
+	TVector3 resolved = (currentYCoCg * currentWeight + historyColor * historyWeight) / (currentWeight + historyWeight);
+
+	return TVector3::Max(YCoCgToRGB(resolved), TVector3::Zero);
+}
+
+void TemporalAA::Resolve(const TAAColorImage& current, const TAAColorImage& history, const std::vector<TVector2>& velocity,
+	bool bHistoryValid, TAAColorImage& outResolved)
+{
+	outResolved.Resize(current.width, current.height);
+
+	for (uint32_t y = 0; y < current.height; y++)
+	{
+		for (uint32_t x = 0; x < current.width; x++)
+		{
+			outResolved.pixels[(size_t)y * current.width + x] = ResolvePixel(current, history, velocity, x, y, bHistoryValid);
+		}
+	}
+}
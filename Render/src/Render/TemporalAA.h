@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../Math/Math.h"
+
+// Jittered frames the resolve cycles through, see Halton_2 and Halton_3
+#define TAA_SAMPLE_COUNT 8
+
+// Weight of the current frame in the resolve, mirrored in TemporalAccumCS.hlsl
+#define TAA_CURRENT_FRAME_WEIGHT 0.1f
+
+// Added to the current frame weight at a motion of one pixel per frame or more, the resampled history blurs.
+// Mirrored in TemporalAccumCS.hlsl
+#define TAA_MOTION_FRAME_WEIGHT 0.2f
+
+// History is clipped to the neighbourhood mean plus or minus this many standard deviations, mirrored in TemporalAccumCS.hlsl
+#define TAA_VARIANCE_CLIP_GAMMA 1.0f
+
+// Linear color image of the CPU resolve, row major
+struct TAAColorImage
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<TVector3> pixels;
+
+	void Resize(uint32_t inWidth, uint32_t inHeight);
+
+	// Clamped to the edges, like gsamPointClamp
+	const TVector3& Load(int x, int y) const;
+
+	// Bilinear with clamped edges, like gsamLinearClamp
+	TVector3 SampleBilinear(const TVector2& uv) const;
+};
+
+// Resolve math of TemporalAccumCS.hlsl. The CPU version runs the same steps on images, so the resolve can be checked
+// without a GPU:
+// - the 3x3 neighbourhood of the current frame gives a mean and variance in YCoCg
+// - the history is fetched where the pixel was last frame, from GBufferVelocity, with a Catmull-Rom filter
+// - the history is clipped to the variance box and blended with the current frame
+class TemporalAA
+{
+public:
+	// Sub pixel offset of the projection in NDC for a frame, within half a pixel
+	static TVector2 GetJitter(uint32_t frameIndex, uint32_t width, uint32_t height);
+
+	static TVector3 RGBToYCoCg(const TVector3& color);
+	static TVector3 YCoCgToRGB(const TVector3& color);
+
+	// Moves color along the line to the box center until it is inside the box
+	static TVector3 ClipToAABB(const TVector3& color, const TVector3& boxMin, const TVector3& boxMax);
+
+	// Catmull-Rom filter from five bilinear fetches, the corner texels are dropped
+	static TVector3 SampleHistory(const TAAColorImage& history, const TVector2& uv);
+
+	// velocity is the uv motion since the previous frame per pixel, as written to GBufferVelocity.
+	// Without a valid history the current frame is returned as it is.
+	static TVector3 ResolvePixel(const TAAColorImage& current, const TAAColorImage& history, const std::vector<TVector2>& velocity,
+		uint32_t x, uint32_t y, bool bHistoryValid);
+
+	static void Resolve(const TAAColorImage& current, const TAAColorImage& history, const std::vector<TVector2>& velocity,
+		bool bHistoryValid, TAAColorImage& outResolved);
+};
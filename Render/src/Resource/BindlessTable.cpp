@@ -0,0 +1,36 @@
+#include "BindlessTable.h"
+
+BindlessTable::BindlessTable(uint32_t capacity)
+	:slots(capacity)
+{
+}
+
+void BindlessTable::SetDescriptorHeap(ID3D12Device* inDevice, ID3D12DescriptorHeap* inHeap, uint32_t inFirstDescriptor)
+{
+	d3dDevice = inDevice;
+	descriptorSize = d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	cpuBase = CD3DX12_CPU_DESCRIPTOR_HANDLE(inHeap->GetCPUDescriptorHandleForHeapStart(), inFirstDescriptor, descriptorSize);
+	gpuBase = CD3DX12_GPU_DESCRIPTOR_HANDLE(inHeap->GetGPUDescriptorHandleForHeapStart(), inFirstDescriptor, descriptorSize);
+}
+
+uint32_t BindlessTable::Register(D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor)
+{
+	const uint32_t index = slots.Allocate();
+	assert(index != InvalidIndex && "BindlessTable is full, raise BINDLESS_TABLE_SIZE");
+
+	if (index != InvalidIndex && d3dDevice)
+	{
+		CD3DX12_CPU_DESCRIPTOR_HANDLE dstDescriptor(cpuBase, index, descriptorSize);
+		d3dDevice->CopyDescriptorsSimple(1, dstDescriptor, srcDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	}
+
+	return index;
+}
+
+void BindlessTable::Unregister(uint32_t index)
+{
+	if (index != InvalidIndex)
+	{
+		slots.Free(index);
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../Utils/D3D12Utils.h"
+#include "SlotIndexAllocator.h"
+#include "DeferredDeletionQueue.h"
+
+// Keep in sync with Shaders/Bindless.hlsl
+#define BINDLESS_TABLE_SIZE 4096
+#define BINDLESS_REGISTER_SPACE 1
+
+// Persistent SRV slots in the shader visible heap of the DescriptorCache.
+// Every ShaderResourceView registers itself on creation, shaders read the table as
+// Texture2D BindlessTextures[BINDLESS_TABLE_SIZE] : register(t0, space1) and index it with integers from constant buffers.
+// Without a heap only the indices are managed, that is all the table needs to be tested headless.
+class BindlessTable : public IDeferredDeletionVisitor
+{
+public:
+	static const uint32_t InvalidIndex = SlotIndexAllocator::InvalidIndex;
+
+	BindlessTable(uint32_t capacity = BINDLESS_TABLE_SIZE);
+
+	// The table takes descriptors [firstDescriptor, firstDescriptor + capacity) of heap
+	void SetDescriptorHeap(ID3D12Device* inDevice, ID3D12DescriptorHeap* inHeap, uint32_t inFirstDescriptor);
+
+	// Allocates an index and copies srcDescriptor there, srcDescriptor may live in a non shader visible heap.
+	// Thread safe, views are created from loader jobs.
+	uint32_t Register(D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor);
+
+	// The GPU must be done with the descriptor, the next Register can reuse the index
+	void Unregister(uint32_t index);
+
+	// IDeferredDeletionVisitor, handle is the index
+	void Delete(uint64_t handle, void* object) override { Unregister((uint32_t)handle); }
+
+	bool IsRegistered(uint32_t index) const { return index < slots.GetSlotCount() && slots.IsAllocated(index); }
+	uint32_t GetCapacity() const { return slots.GetSlotCount(); }
+	uint32_t GetRegisteredCount() const { return slots.GetAllocatedCount(); }
+
+	// Bound as the space 1 SRV table of shaders that use the table
+	D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle() const { return gpuBase; }
+
+private:
+	SlotIndexAllocator slots;
+
+	ID3D12Device* d3dDevice = nullptr;
+	D3D12_CPU_DESCRIPTOR_HANDLE cpuBase = { 0 };
+	D3D12_GPU_DESCRIPTOR_HANDLE gpuBase = { 0 };
+	uint32_t descriptorSize = 0;
+};
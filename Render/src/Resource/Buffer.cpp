@@ -133,6 +133,8 @@ ReadBackBufferRef D3D12RHI::CreateReadBackBuffer(uint32_t size)
 	Resource* newResource = new Resource(D3DResource, D3D12_RESOURCE_STATE_COPY_DEST);
 	readBackBufferRef->resourceLocation.underlyingResource = newResource;
 	readBackBufferRef->resourceLocation.SetType(ResourceLocation::EResourceLocationType::StandAlone);
+	readBackBufferRef->resourceLocation.deletionQueue = GetDevice()->GetDeferredDeletionQueue();
+	readBackBufferRef->resourceLocation.allocationSize = GetDevice()->GetD3DDevice()->GetResourceAllocationInfo(0, 1, &resourceDescBuffer).SizeInBytes;
 
 	return readBackBufferRef;
 }
@@ -6,6 +6,7 @@ CommandContext::CommandContext(Device* InDevice)
 {
 	CreateCommandContext();
 	descriptorCache = std::make_unique<DescriptorCache>(device);
+	frameResources = std::make_unique<FrameResourceRing>(FRAME_RESOURCE_COUNT);
 }
 
 CommandContext::~CommandContext()
@@ -24,11 +25,14 @@ void CommandContext::CreateCommandContext()
 	queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
 	ThrowIfFailed(device->GetD3DDevice()->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&commandQueue)));
 
-	//Create direct type commandAllocator
-	ThrowIfFailed(device->GetD3DDevice()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(commandListAlloc.GetAddressOf())));
+	//Create direct type commandAllocators, one per frame in flight
+	for (UINT i = 0; i < FRAME_RESOURCE_COUNT; i++)
+	{
+		ThrowIfFailed(device->GetD3DDevice()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(commandListAllocs[i].GetAddressOf())));
+	}
 
 	//Create direct type commandList
-	ThrowIfFailed(device->GetD3DDevice()->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandListAlloc.Get(),
+	ThrowIfFailed(device->GetD3DDevice()->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandListAllocs[0].Get(),
 		nullptr, IID_PPV_ARGS(commandList.GetAddressOf())));
 
 	// Start off in a closed state. 
@@ -39,15 +43,23 @@ void CommandContext::CreateCommandContext()
 
 void CommandContext::DestroyCommandContext()
 {
-	//Don't need to do anything
-	//Microsoft::WRL::ComPtr will destroy resource automatically
+	// Delay disposed resources may be in use until the queue is idle
+	FlushCommandQueue();
+	frameResources = nullptr;
 }
 
-void CommandContext::ResetCommandAllocator()
+void CommandContext::BeginFrame()
 {
 	// Command list allocators can only be reset when the associated command lists have finished execution on the GPU.
-	// So we should use fences to determine GPU execution progress(see FlushCommandQueue()).
-	ThrowIfFailed(commandListAlloc->Reset());
+	// The slot was last used FRAME_RESOURCE_COUNT frames ago, usually its fence passed long before.
+	WaitForFence(frameResources->GetWaitFenceValue());
+
+	frameResources->BeginFrame(fence->GetCompletedValue());
+
+	ThrowIfFailed(commandListAllocs[frameResources->GetFrameIndex()]->Reset());
+	ResetCommandList();
+
+	descriptorCache->Reset(frameResources->GetFrameIndex());
 }
 
 void CommandContext::ResetCommandList()
@@ -56,7 +68,7 @@ void CommandContext::ResetCommandList()
 	// A command list can be reset after it has been added to the command queue via ExecuteCommandList.
 	// Before an app calls Reset, the command list must be in the "closed" state. 
 	// After Reset succeeds, the command list is left in the "recording" state. 
-	ThrowIfFailed(commandList->Reset(commandListAlloc.Get(), nullptr));
+	ThrowIfFailed(commandList->Reset(commandListAllocs[frameResources->GetFrameIndex()].Get(), nullptr));
 }
 
 void CommandContext::ExecuteCommandLists()
@@ -80,21 +92,40 @@ void CommandContext::FlushCommandQueue()
 	ThrowIfFailed(commandQueue->Signal(fence.Get(), currentFenceValue));
 
 	// Wait until the GPU has completed commands up to this fence point.
-	if (fence->GetCompletedValue() < currentFenceValue)
+	WaitForFence(currentFenceValue);
+
+	// Every ended frame is done, the one being recorded keeps its resources
+	if (frameResources)
+	{
+		frameResources->Retire(currentFenceValue);
+	}
+
+	device->GetDeferredDeletionQueue()->Retire(currentFenceValue, UINT32_MAX);
+}
+
+UINT64 CommandContext::EndFrame()
+{
+	// No wait, the CPU goes on with the next frame while the GPU runs this one
+	currentFenceValue++;
+	ThrowIfFailed(commandQueue->Signal(fence.Get(), currentFenceValue));
+
+	frameResources->EndFrame(currentFenceValue);
+
+	return currentFenceValue;
+}
+
+void CommandContext::WaitForFence(UINT64 fenceValue)
+{
+	if (fence->GetCompletedValue() < fenceValue)
 	{
 		HANDLE eventHandle = CreateEvent(nullptr, false, false, nullptr);
 
-		// Fire event when GPU hits current fence.  
-		ThrowIfFailed(fence->SetEventOnCompletion(currentFenceValue, eventHandle));
+		// Fire event when GPU hits the fence.
+		ThrowIfFailed(fence->SetEventOnCompletion(fenceValue, eventHandle));
 
-		// Wait until the GPU hits current fence event is fired.
+		// Wait until the GPU hits the fence event is fired.
 		WaitForSingleObject(eventHandle, INFINITE);
 		CloseHandle(eventHandle);
 	}
 }
 
-void CommandContext::EndFrame()
-{
-	descriptorCache->Reset();
-}
-
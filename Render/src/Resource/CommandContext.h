@@ -2,6 +2,7 @@
 
 #include "../Utils/D3D12Utils.h"
 #include "DescriptorCache.h"
+#include "FrameResourceRing.h"
 
 class Device;
 
@@ -17,19 +18,29 @@ public:
 	ID3D12CommandQueue* GetCommandQueue() { return commandQueue.Get(); }
 	ID3D12GraphicsCommandList4* GetCommandList() { return commandList.Get(); }
 	DescriptorCache* GetDescriptorCache() { return descriptorCache.get(); }
+	FrameResourceRing* GetFrameResources() { return frameResources.get(); }
 
-	void ResetCommandAllocator();
+	// Waits until the GPU is done with the frame that used the current slot FRAME_RESOURCE_COUNT frames ago,
+	// then resets its allocator and descriptors and opens the command list
+	void BeginFrame();
 	void ResetCommandList();
 	void ExecuteCommandLists();
 	void FlushCommandQueue();
-	void EndFrame();
+	// Signals the end of the frame on the queue and moves to the next slot, returns the signaled value
+	UINT64 EndFrame();
+
+	UINT64 GetCompletedFenceValue() { return fence->GetCompletedValue(); }
 
 private:
 	Device* device = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandListAlloc = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandListAllocs[FRAME_RESOURCE_COUNT];
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> commandList = nullptr;
 	std::unique_ptr<DescriptorCache> descriptorCache = nullptr;
+	std::unique_ptr<FrameResourceRing> frameResources = nullptr;
+
+private:
+	void WaitForFence(UINT64 fenceValue);
 
 private:
 	Microsoft::WRL::ComPtr<ID3D12Fence> fence = nullptr;
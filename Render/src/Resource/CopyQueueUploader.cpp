@@ -0,0 +1,229 @@
+#include "CopyQueueUploader.h"
+#include <algorithm>
+
+using Microsoft::WRL::ComPtr;
+
+CopyQueueUploader::CopyQueueUploader(ID3D12Device5* inDevice, uint64_t stagingSize, uint64_t inFrameBudget)
+	:d3dDevice(inDevice), scheduler(stagingSize), frameBudget(inFrameBudget),
+	maxChunkSize((std::min)(stagingSize, (uint64_t)COPY_QUEUE_MAX_CHUNK_SIZE))
+{
+	ThrowIfFailed(d3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
+
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	ThrowIfFailed(d3dDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&copyQueue)));
+	SetDebugName(copyQueue.Get(), L"CopyQueueUploader copyQueue");
+
+	auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(stagingSize);
+	ThrowIfFailed(d3dDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&stagingBuffer)));
+	SetDebugName(stagingBuffer.Get(), L"CopyQueueUploader stagingBuffer");
+
+	ThrowIfFailed(stagingBuffer->Map(0, nullptr, reinterpret_cast<void**>(&stagingData)));
+}
+
+CopyQueueUploader::~CopyQueueUploader()
+{
+	Flush();
+
+	stagingBuffer->Unmap(0, nullptr);
+}
+
+UploadTicket CopyQueueUploader::UploadBuffer(Resource* dst, uint64_t dstOffset, const void* data, uint64_t size, std::shared_ptr<const void> keepAlive)
+{
+	ComPtr<ID3D12Resource> dstResource = dst->D3DResource;
+
+	std::vector<UploadScheduler::Chunk> chunks;
+	for (uint64_t chunkOffset = 0; chunkOffset < size; chunkOffset += maxChunkSize)
+	{
+		UploadScheduler::Chunk chunk;
+		chunk.size = (std::min)(size - chunkOffset, maxChunkSize);
+		chunk.alignment = 16;
+		chunk.record = [this, dstResource, dstOffset, data, chunkOffset, chunkSize = chunk.size](uint64_t stagingOffset)
+		{
+			memcpy(stagingData + stagingOffset, static_cast<const uint8_t*>(data) + chunkOffset, chunkSize);
+			commandList->CopyBufferRegion(dstResource.Get(), dstOffset + chunkOffset, stagingBuffer.Get(), stagingOffset, chunkSize);
+		};
+
+		chunks.push_back(std::move(chunk));
+	}
+
+	return scheduler.Enqueue(std::move(chunks), std::move(keepAlive));
+}
+
+UploadTicket CopyQueueUploader::UploadTexture(Resource* dst, const std::vector<D3D12_SUBRESOURCE_DATA>& initData, std::shared_ptr<const void> keepAlive)
+{
+	ComPtr<ID3D12Resource> dstResource = dst->D3DResource;
+	D3D12_RESOURCE_DESC texDesc = dstResource->GetDesc();
+
+	//GetCopyableFootprints
+	const UINT numSubresources = (UINT)initData.size();
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(numSubresources);
+	std::vector<UINT> numRows(numSubresources);
+	std::vector<UINT64> rowSizesInBytes(numSubresources);
+	d3dDevice->GetCopyableFootprints(&texDesc, 0, numSubresources, 0, layouts.data(), numRows.data(), rowSizesInBytes.data(), nullptr);
+
+	std::vector<UploadScheduler::Chunk> chunks;
+	for (UINT subresource = 0; subresource < numSubresources; subresource++)
+	{
+		const D3D12_SUBRESOURCE_FOOTPRINT footprint = layouts[subresource].Footprint;
+		const D3D12_SUBRESOURCE_DATA srcData = initData[subresource];
+		const UINT subresourceRows = numRows[subresource];
+		const SIZE_T rowSize = (SIZE_T)rowSizesInBytes[subresource];
+
+		// Split into bands of rows, a row of blocks for compressed formats, slices of a volume stay together
+		const UINT64 bandRowBytes = (UINT64)footprint.RowPitch * footprint.Depth;
+		const UINT rowsPerChunk = (UINT)(std::max)((UINT64)1, maxChunkSize / bandRowBytes);
+		const UINT blockHeight = (footprint.Height + subresourceRows - 1) / subresourceRows;
+
+		for (UINT firstRow = 0; firstRow < subresourceRows; firstRow += rowsPerChunk)
+		{
+			const UINT rowCount = (std::min)(rowsPerChunk, subresourceRows - firstRow);
+
+			UploadScheduler::Chunk chunk;
+			chunk.size = bandRowBytes * rowCount;
+			chunk.alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+			chunk.record = [=, this](uint64_t stagingOffset)
+			{
+				for (UINT z = 0; z < footprint.Depth; z++)
+				{
+					for (UINT row = 0; row < rowCount; row++)
+					{
+						memcpy(stagingData + stagingOffset + ((UINT64)z * rowCount + row) * footprint.RowPitch,
+							static_cast<const uint8_t*>(srcData.pData) + z * srcData.SlicePitch + (firstRow + row) * srcData.RowPitch, rowSize);
+					}
+				}
+
+				D3D12_PLACED_SUBRESOURCE_FOOTPRINT srcLayout;
+				srcLayout.Offset = stagingOffset;
+				srcLayout.Footprint = footprint;
+				srcLayout.Footprint.Height = rowCount * blockHeight;
+
+				CD3DX12_TEXTURE_COPY_LOCATION Src(stagingBuffer.Get(), srcLayout);
+				CD3DX12_TEXTURE_COPY_LOCATION Dst(dstResource.Get(), subresource);
+				commandList->CopyTextureRegion(&Dst, 0, firstRow * blockHeight, 0, &Src, nullptr);
+			};
+
+			chunks.push_back(std::move(chunk));
+		}
+	}
+
+	return scheduler.Enqueue(std::move(chunks), std::move(keepAlive));
+}
+
+void CopyQueueUploader::Update()
+{
+	scheduler.Retire(fence->GetCompletedValue());
+
+	RecordAndSubmit(frameBudget);
+}
+
+bool CopyQueueUploader::IsComplete(UploadTicket ticket)
+{
+	scheduler.Retire(fence->GetCompletedValue());
+
+	return scheduler.IsComplete(ticket);
+}
+
+void CopyQueueUploader::WaitOnQueue(ID3D12CommandQueue* queue, UploadTicket ticket)
+{
+	uint64_t fenceValue = 0;
+	while (!scheduler.GetFenceValue(ticket, fenceValue))
+	{
+		RecordAndSubmit(UINT64_MAX);
+
+		// Staging ring is full, wait for the oldest copies on the CPU
+		if (!scheduler.GetFenceValue(ticket, fenceValue))
+		{
+			WaitForFence(scheduler.GetOldestFenceValue());
+		}
+	}
+
+	if (fenceValue > 0)
+	{
+		ThrowIfFailed(queue->Wait(fence.Get(), fenceValue));
+	}
+}
+
+void CopyQueueUploader::Flush()
+{
+	while (scheduler.HasPendingChunks() || scheduler.HasRecordedChunks())
+	{
+		RecordAndSubmit(UINT64_MAX);
+		WaitForFence(currentFenceValue);
+	}
+
+	WaitForFence(currentFenceValue);
+}
+
+void CopyQueueUploader::RecordAndSubmit(uint64_t budgetBytes)
+{
+	if (!scheduler.HasPendingChunks())
+	{
+		return;
+	}
+
+	// Open the command list with a free allocator
+	if (recordingAllocator == -1)
+	{
+		const uint64_t completedFenceValue = fence->GetCompletedValue();
+
+		auto Iter = std::find_if(commandAllocators.begin(), commandAllocators.end(),
+			[completedFenceValue](const CommandAllocator& allocator) { return allocator.fenceValue <= completedFenceValue; });
+
+		if (Iter == commandAllocators.end())
+		{
+			CommandAllocator allocator;
+			ThrowIfFailed(d3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator.allocator)));
+			commandAllocators.push_back(allocator);
+			Iter = commandAllocators.end() - 1;
+		}
+
+		recordingAllocator = (int)(Iter - commandAllocators.begin());
+		ThrowIfFailed(Iter->allocator->Reset());
+
+		if (commandList == nullptr)
+		{
+			ThrowIfFailed(d3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, Iter->allocator.Get(), nullptr, IID_PPV_ARGS(&commandList)));
+		}
+		else
+		{
+			ThrowIfFailed(commandList->Reset(Iter->allocator.Get(), nullptr));
+		}
+	}
+
+	scheduler.Record(budgetBytes);
+
+	// Keep the list open if the ring was full
+	if (!scheduler.HasRecordedChunks())
+	{
+		return;
+	}
+
+	ThrowIfFailed(commandList->Close());
+	ID3D12CommandList* cmdsLists[] = { commandList.Get() };
+	copyQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+
+	currentFenceValue++;
+	ThrowIfFailed(copyQueue->Signal(fence.Get(), currentFenceValue));
+
+	commandAllocators[recordingAllocator].fenceValue = currentFenceValue;
+	recordingAllocator = -1;
+
+	scheduler.Submit(currentFenceValue);
+}
+
+void CopyQueueUploader::WaitForFence(uint64_t fenceValue)
+{
+	if (fence->GetCompletedValue() < fenceValue)
+	{
+		HANDLE eventHandle = CreateEvent(nullptr, false, false, nullptr);
+		ThrowIfFailed(fence->SetEventOnCompletion(fenceValue, eventHandle));
+		WaitForSingleObject(eventHandle, INFINITE);
+		CloseHandle(eventHandle);
+	}
+
+	scheduler.Retire(fence->GetCompletedValue());
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../Utils/D3D12Utils.h"
+#include "Resource.h"
+#include "UploadScheduler.h"
+
+#define COPY_QUEUE_STAGING_SIZE (64 * 1024 * 1024)
+#define COPY_QUEUE_FRAME_BUDGET (16 * 1024 * 1024)
+#define COPY_QUEUE_MAX_CHUNK_SIZE (4 * 1024 * 1024)
+
+// Uploads buffers and textures on a copy queue with its own fence, so loads overlap with rendering.
+// Large uploads are split into chunks no larger than the staging ring and at most frameBudget bytes go through it per Update.
+// A texture row that alone does not fit the ring throws std::runtime_error.
+// Destination resources must be in the COMMON state, they decay back to it when the copy queue is done.
+class CopyQueueUploader
+{
+public:
+	CopyQueueUploader(ID3D12Device5* inDevice, uint64_t stagingSize = COPY_QUEUE_STAGING_SIZE, uint64_t inFrameBudget = COPY_QUEUE_FRAME_BUDGET);
+	~CopyQueueUploader();
+
+	// The source data is read when a chunk is recorded, keepAlive must own it unless the caller keeps it until the ticket completes
+	UploadTicket UploadBuffer(Resource* dst, uint64_t dstOffset, const void* data, uint64_t size, std::shared_ptr<const void> keepAlive = nullptr);
+	UploadTicket UploadTexture(Resource* dst, const std::vector<D3D12_SUBRESOURCE_DATA>& initData, std::shared_ptr<const void> keepAlive = nullptr);
+
+	// Once per frame, submits the next chunks within the frame budget
+	void Update();
+
+	// No CPU wait, polls the fence
+	bool IsComplete(UploadTicket ticket);
+
+	// GPU side wait of queue until ticket completed, chunks of the ticket that are still pending are submitted right away
+	void WaitOnQueue(ID3D12CommandQueue* queue, UploadTicket ticket);
+
+	// CPU wait for every upload
+	void Flush();
+
+	UploadTicket GetLastTicket() const { return scheduler.GetLastTicket(); }
+	const UploadScheduler::Stats& GetStats() const { return scheduler.GetStats(); }
+
+private:
+	void RecordAndSubmit(uint64_t budgetBytes);
+	void WaitForFence(uint64_t fenceValue);
+
+private:
+	struct CommandAllocator
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+		uint64_t fenceValue = 0;
+	};
+
+	ID3D12Device5* d3dDevice = nullptr;
+
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> copyQueue = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList = nullptr;
+	std::vector<CommandAllocator> commandAllocators;
+	int recordingAllocator = -1;
+
+	Microsoft::WRL::ComPtr<ID3D12Fence> fence = nullptr;
+	uint64_t currentFenceValue = 0;
+
+	// Persistently mapped
+	Microsoft::WRL::ComPtr<ID3D12Resource> stagingBuffer = nullptr;
+	uint8_t* stagingData = nullptr;
+
+	UploadScheduler scheduler;
+	uint64_t frameBudget = 0;
+	uint64_t maxChunkSize = 0;
+};
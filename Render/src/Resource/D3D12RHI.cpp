@@ -211,14 +211,39 @@ void D3D12RHI::ExecuteCommandLists()
 	GetDevice()->GetCommandContext()->ExecuteCommandLists();
 }
 
+bool D3D12RHI::IsUploadComplete(UploadTicket ticket)
+{
+	return GetDevice()->GetCopyQueueUploader()->IsComplete(ticket);
+}
+
+void D3D12RHI::WaitForUpload(UploadTicket ticket)
+{
+	GetDevice()->GetCopyQueueUploader()->WaitOnQueue(GetDevice()->GetCommandQueue(), ticket);
+}
+
+UploadTicket D3D12RHI::GetLastUploadTicket()
+{
+	return GetDevice()->GetCopyQueueUploader()->GetLastTicket();
+}
+
 void D3D12RHI::ResetCommandList()
 {
 	GetDevice()->GetCommandContext()->ResetCommandList();
 }
 
-void D3D12RHI::ResetCommandAllocator()
+void D3D12RHI::BeginFrame()
+{
+	GetDevice()->GetCommandContext()->BeginFrame();
+}
+
+uint32_t D3D12RHI::GetFrameResourceIndex()
 {
-	GetDevice()->GetCommandContext()->ResetCommandAllocator();
+	return GetDevice()->GetCommandContext()->GetFrameResources()->GetFrameIndex();
+}
+
+void D3D12RHI::AddDelayDisposeResource(std::shared_ptr<const void> resource)
+{
+	GetDevice()->GetCommandContext()->GetFrameResources()->AddDelayDisposeResource(std::move(resource));
 }
 
 void D3D12RHI::Present()
@@ -274,6 +299,15 @@ void D3D12RHI::SetVertexBuffer(const VertexBufferRef& VertexBuffer, UINT Offset,
 	GetDevice()->GetCommandList()->IASetVertexBuffers(0, 1, &VBV);
 }
 
+void D3D12RHI::SetVertexBuffer(D3D12_GPU_VIRTUAL_ADDRESS address, UINT stride, UINT size)
+{
+	D3D12_VERTEX_BUFFER_VIEW VBV;
+	VBV.BufferLocation = address;
+	VBV.StrideInBytes = stride;
+	VBV.SizeInBytes = size;
+	GetDevice()->GetCommandList()->IASetVertexBuffers(0, 1, &VBV);
+}
+
 void D3D12RHI::SetIndexBuffer(const IndexBufferRef& IndexBuffer, UINT Offset, DXGI_FORMAT Format, UINT Size)
 {
 	// Transition resource state
@@ -291,13 +325,16 @@ void D3D12RHI::SetIndexBuffer(const IndexBufferRef& IndexBuffer, UINT Offset, DX
 
 void D3D12RHI::EndFrame()
 {
-	// Clean memory allocations
-	GetDevice()->GetUploadBufferAllocator()->CleanUpAllocations();
-
-	GetDevice()->GetDefaultBufferAllocator()->CleanUpAllocations();
-
-	GetDevice()->GetTextureResourceAllocator()->CleanUpAllocations();
-
-	// CommandContext
-	GetDevice()->GetCommandContext()->EndFrame();
+	// CommandContext, the GPU runs this frame while the CPU records the next ones
+	CommandContext* commandContext = GetDevice()->GetCommandContext();
+	const UINT64 fenceValue = commandContext->EndFrame();
+	const UINT64 completedFenceValue = commandContext->GetCompletedFenceValue();
+
+	// Clean memory allocations, everything released this frame waits for its fence
+	DeferredDeletionQueue* deletionQueue = GetDevice()->GetDeferredDeletionQueue();
+	deletionQueue->Submit(fenceValue);
+	deletionQueue->Retire(completedFenceValue);
+
+	// Next chunks of the copy queue uploads
+	GetDevice()->GetCopyQueueUploader()->Update();
 }
\ No newline at end of file
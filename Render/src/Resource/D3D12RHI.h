@@ -33,7 +33,10 @@ public:
 	void FlushCommandQueue();
 	void ExecuteCommandLists();
 	void ResetCommandList();
-	void ResetCommandAllocator();
+	// Waits for the frame slot FRAME_RESOURCE_COUNT frames back and opens the command list, see FrameResourceRing
+	void BeginFrame();
+	// Slot of the frame being recorded, in [0, FRAME_RESOURCE_COUNT)
+	uint32_t GetFrameResourceIndex();
 	void Present();
 	void ResizeViewport(int newWidth, int newHeight);
 	void TransitionResource(Resource* resource, D3D12_RESOURCE_STATES stateAfter);
@@ -50,6 +53,8 @@ public:
 	ReadBackBufferRef CreateReadBackBuffer(uint32_t size);
 	ASBufferRef CreateTopLevelAccelerationStructure(UINT64 tlasSizeInBytes,const std::wstring& tlasName = L"TLAS");
 	void SetVertexBuffer(const VertexBufferRef& vertexBuffer, UINT offset, UINT stride, UINT size);
+	// Upload heap memory such as a FrameRingBuffer allocation, it stays in the generic read state
+	void SetVertexBuffer(D3D12_GPU_VIRTUAL_ADDRESS address, UINT stride, UINT size);
 	void SetIndexBuffer(const IndexBufferRef& indexBuffer, UINT offset, DXGI_FORMAT format, UINT size);
 
 	// D3D12Texture.cpp
@@ -57,6 +62,17 @@ public:
 	// Use D3DResource to create texture, texture will manage this D3DResource
 	D3D12TextureRef CreateTexture(Microsoft::WRL::ComPtr<ID3D12Resource> D3DResource, TextureInfo& textureInfo, uint32_t createFlags);
 	void UploadTextureData(D3D12TextureRef texture, const std::vector<D3D12_SUBRESOURCE_DATA>& InitData);
+	// Upload on the copy queue, the texture must not be used before the ticket completed or WaitForUpload was called
+	UploadTicket UploadTextureDataAsync(D3D12TextureRef texture, const std::vector<D3D12_SUBRESOURCE_DATA>& InitData, std::shared_ptr<const void> keepAlive);
+
+	// CopyQueueUploader tickets
+	bool IsUploadComplete(UploadTicket ticket);
+	// GPU side wait of the command queue, call before executing the first command list that uses the upload
+	void WaitForUpload(UploadTicket ticket);
+	UploadTicket GetLastUploadTicket();
+
+	// Kept alive until the GPU finished the frame being recorded
+	void AddDelayDisposeResource(std::shared_ptr<const void> resource);
 
 	void EndFrame();
 
@@ -13,6 +13,7 @@ D3D12TextureRef D3D12RHI::CreateTexture(Microsoft::WRL::ComPtr<ID3D12Resource> D
 {
 	D3D12TextureRef textureRef = std::make_shared<D3D12Texture>();
 
+	// Swap chain buffers are not deferred, ResizeBuffers needs them released after the flush
 	Resource* NewResource = new Resource(D3DResource, textureInfo.InitState);
 	textureRef->resourceLocation.underlyingResource = NewResource;
 	textureRef->resourceLocation.SetType(ResourceLocation::EResourceLocationType::StandAlone);
@@ -108,6 +109,8 @@ D3D12TextureRef D3D12RHI::CreateTextureResource(const TextureInfo& textureInfo,
 		Resource* newResource = new Resource(d3dResource, textureInfo.InitState);
 		textureRef->resourceLocation.underlyingResource = newResource;
 		textureRef->resourceLocation.SetType(ResourceLocation::EResourceLocationType::StandAlone);
+		textureRef->resourceLocation.deletionQueue = GetDevice()->GetDeferredDeletionQueue();
+		textureRef->resourceLocation.allocationSize = GetDevice()->GetD3DDevice()->GetResourceAllocationInfo(0, 1, &texDesc).SizeInBytes;
 	}
 
 	return textureRef;
@@ -315,4 +318,13 @@ void D3D12RHI::UploadTextureData(D3D12TextureRef texture, const std::vector<D3D1
 	}
 
 	TransitionResource(textureResource, D3D12_RESOURCE_STATE_COMMON);
+}
+
+UploadTicket D3D12RHI::UploadTextureDataAsync(D3D12TextureRef texture, const std::vector<D3D12_SUBRESOURCE_DATA>& InitData, std::shared_ptr<const void> keepAlive)
+{
+	// The copy queue can not transition, the texture must still be in its initial state
+	Resource* textureResource = texture->GetResource();
+	assert(textureResource->currentState == D3D12_RESOURCE_STATE_COMMON);
+
+	return GetDevice()->GetCopyQueueUploader()->UploadTexture(textureResource, InitData, std::move(keepAlive));
 }
\ No newline at end of file
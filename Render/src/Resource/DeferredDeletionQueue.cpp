@@ -0,0 +1,96 @@
+#include "DeferredDeletionQueue.h"
+#include <algorithm>
+#include <assert.h>
+
+DeferredDeletionQueue::DeferredDeletionQueue()
+{
+}
+
+DeferredDeletionQueue::~DeferredDeletionQueue()
+{
+	assert(pendingEntries.empty() && batches.empty() && "Flush the queue while the visitors are alive");
+}
+
+void DeferredDeletionQueue::Enqueue(IDeferredDeletionVisitor* visitor, uint64_t handle, void* object, uint64_t bytes)
+{
+	assert(visitor != nullptr);
+
+	Entry entry;
+	entry.visitor = visitor;
+	entry.handle = handle;
+	entry.object = object;
+	entry.bytes = bytes;
+	pendingEntries.push_back(entry);
+
+	stats.pendingBytes += bytes;
+	stats.inFlightBytes += bytes;
+	stats.inFlightCount++;
+	stats.peakInFlightBytes = (std::max)(stats.peakInFlightBytes, stats.inFlightBytes);
+}
+
+void DeferredDeletionQueue::Submit(uint64_t fenceValue)
+{
+	if (pendingEntries.empty())
+	{
+		return;
+	}
+
+	assert(batches.empty() || batches.back().fenceValue <= fenceValue);
+
+	Batch batch;
+	batch.fenceValue = fenceValue;
+	batch.entries.swap(pendingEntries);
+	batches.push_back(std::move(batch));
+
+	if (!freeEntryArrays.empty())
+	{
+		pendingEntries.swap(freeEntryArrays.back());
+		freeEntryArrays.pop_back();
+	}
+
+	stats.pendingBytes = 0;
+}
+
+uint32_t DeferredDeletionQueue::Retire(uint64_t completedFenceValue, uint32_t maxCount)
+{
+	uint32_t count = 0;
+	while (!batches.empty() && batches.front().fenceValue <= completedFenceValue && count < maxCount)
+	{
+		Batch& batch = batches.front();
+
+		const size_t lastEntry = (std::min)(batch.entries.size(), batch.nextEntry + (maxCount - count));
+		for (; batch.nextEntry < lastEntry; batch.nextEntry++)
+		{
+			Release(batch.entries[batch.nextEntry]);
+			count++;
+		}
+
+		if (batch.nextEntry < batch.entries.size())
+		{
+			break;
+		}
+
+		// Keep the capacity
+		batch.entries.clear();
+		freeEntryArrays.push_back(std::move(batch.entries));
+		batches.pop_front();
+	}
+
+	return count;
+}
+
+void DeferredDeletionQueue::Flush()
+{
+	Submit(batches.empty() ? 0 : batches.back().fenceValue);
+
+	Retire(UINT64_MAX, UINT32_MAX);
+}
+
+void DeferredDeletionQueue::Release(const Entry& entry)
+{
+	entry.visitor->Delete(entry.handle, entry.object);
+
+	stats.inFlightBytes -= entry.bytes;
+	stats.inFlightCount--;
+	stats.deletedBytes += entry.bytes;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Most released objects per Retire, the rest waits for the next frame
+#define DEFERRED_DELETION_MAX_RELEASES_PER_FRAME 4096
+
+// Frees the memory or object behind a handle once the GPU is done with it
+class IDeferredDeletionVisitor
+{
+public:
+	virtual void Delete(uint64_t handle, void* object) = 0;
+};
+
+// Fence keyed retirement of GPU memory, shared by the buddy allocators, standalone resources and bindless slots.
+// Entries released while a frame is recorded wait in a batch that Submit tags with the fence signaled at
+// the end of that frame. Retire hands the batches whose fence completed back to their visitors.
+// Entries are plain data, so releasing costs a push_back until the batch is retired.
+// Knows nothing about queues, a counter works as well. Not thread safe, release from the render thread.
+class DeferredDeletionQueue
+{
+public:
+	struct Stats
+	{
+		uint64_t pendingBytes = 0;    // Released since the last Submit
+		uint64_t inFlightBytes = 0;   // Waiting for a fence, pending bytes included
+		uint64_t peakInFlightBytes = 0;
+		uint64_t inFlightCount = 0;
+		uint64_t deletedBytes = 0;    // Handed back to the visitors since the start
+	};
+
+public:
+	DeferredDeletionQueue();
+	~DeferredDeletionQueue();
+
+	DeferredDeletionQueue(const DeferredDeletionQueue& Other) = delete;
+	DeferredDeletionQueue& operator=(const DeferredDeletionQueue& Other) = delete;
+
+	// bytes only feeds the stats
+	void Enqueue(IDeferredDeletionVisitor* visitor, uint64_t handle, void* object, uint64_t bytes);
+
+	// Everything enqueued since the last Submit is released once fenceValue completes
+	void Submit(uint64_t fenceValue);
+
+	// Hands at most maxCount entries of completed batches back, oldest first. Returns the count.
+	uint32_t Retire(uint64_t completedFenceValue, uint32_t maxCount = DEFERRED_DELETION_MAX_RELEASES_PER_FRAME);
+
+	// The GPU must be idle, releases every entry, pending ones included
+	void Flush();
+
+	const Stats& GetStats() const { return stats; }
+
+private:
+	struct Entry
+	{
+		IDeferredDeletionVisitor* visitor = nullptr;
+		uint64_t handle = 0;
+		void* object = nullptr;
+		uint64_t bytes = 0;
+	};
+
+	struct Batch
+	{
+		uint64_t fenceValue = 0;
+		std::vector<Entry> entries;
+		size_t nextEntry = 0;
+	};
+
+	void Release(const Entry& entry);
+
+private:
+	std::vector<Entry> pendingEntries;
+	std::deque<Batch> batches;
+
+	// Retired entry arrays, reused so a steady frame does not allocate
+	std::vector<std::vector<Entry>> freeEntryArrays;
+
+	Stats stats;
+};
@@ -18,7 +18,7 @@ void DescriptorCache::CreateCacheCbvSrvUavDescriptorHeap()
 {
 	// Create the descriptor heap.
 	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-	srvHeapDesc.NumDescriptors = maxCbvSrvUavDescripotrCount;
+	srvHeapDesc.NumDescriptors = maxCbvSrvUavDescripotrCount * FRAME_RESOURCE_COUNT + BINDLESS_TABLE_SIZE;
 	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
 	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 
@@ -26,6 +26,9 @@ void DescriptorCache::CreateCacheCbvSrvUavDescriptorHeap()
 	SetDebugName(cacheCbvSrvUavDescriptorHeap.Get(), L"DescriptorCache cacheCbvSrvUavDescriptorHeap");
 
 	cbvSrvUavDescriptorSize = device->GetD3DDevice()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	bindlessTable = std::make_unique<BindlessTable>(BINDLESS_TABLE_SIZE);
+	bindlessTable->SetDescriptorHeap(device->GetD3DDevice(), cacheCbvSrvUavDescriptorHeap.Get(), maxCbvSrvUavDescripotrCount * FRAME_RESOURCE_COUNT);
 }
 
 
@@ -33,7 +36,7 @@ CD3DX12_GPU_DESCRIPTOR_HANDLE DescriptorCache::AppendCbvSrvUavDescriptors(const
 {
 	// Append to heap
 	uint32_t slotsNeeded = (uint32_t)srcDescriptors.size();
-	assert(cbvSrvUavDescriptorOffset + slotsNeeded < maxCbvSrvUavDescripotrCount);
+	assert(cbvSrvUavDescriptorOffset + slotsNeeded < cbvSrvUavDescriptorBase + maxCbvSrvUavDescripotrCount);
 
 	auto cpuDescriptorHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(cacheCbvSrvUavDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), cbvSrvUavDescriptorOffset, cbvSrvUavDescriptorSize);
 	device->GetD3DDevice()->CopyDescriptors(1, &cpuDescriptorHandle, &slotsNeeded, slotsNeeded, srcDescriptors.data(), nullptr, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
@@ -49,7 +52,7 @@ CD3DX12_GPU_DESCRIPTOR_HANDLE DescriptorCache::AppendCbvSrvUavDescriptors(const
 
 void DescriptorCache::ResetCacheCbvSrvUavDescriptorHeap()
 {
-	cbvSrvUavDescriptorOffset = 0;
+	cbvSrvUavDescriptorOffset = cbvSrvUavDescriptorBase;
 }
 
 void DescriptorCache::CreateCacheRtvDescriptorHeap()
@@ -88,8 +91,11 @@ void DescriptorCache::ResetCacheRtvDescriptorHeap()
 	rtvDescriptorOffset = 0;
 }
 
-void DescriptorCache::Reset()
+void DescriptorCache::Reset(uint32_t frameIndex)
 {
+	assert(frameIndex < FRAME_RESOURCE_COUNT);
+	cbvSrvUavDescriptorBase = frameIndex * maxCbvSrvUavDescripotrCount;
+
 	ResetCacheCbvSrvUavDescriptorHeap();
 
 	ResetCacheRtvDescriptorHeap();
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../Utils/D3D12Utils.h"
+#include "BindlessTable.h"
+#include "FrameResourceRing.h"
 
 class Device;
 using Microsoft::WRL::ComPtr;
@@ -19,7 +21,11 @@ public:
 
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> GetCacheRtvDescriptorHeap() { return cacheRtvDescriptorHeap; }
 	void AppendRtvDescriptors(const std::vector<D3D12_CPU_DESCRIPTOR_HANDLE>& rtvDescriptors, CD3DX12_GPU_DESCRIPTOR_HANDLE& outGpuHandle, CD3DX12_CPU_DESCRIPTOR_HANDLE& outCpuHandle);
-	void Reset();  // per frame
+	// per frame, the GPU may still read the descriptors of the other frames in flight
+	void Reset(uint32_t frameIndex);
+
+	// Lives behind the per frame partitions in cacheCbvSrvUavDescriptorHeap, so both can be bound at once
+	BindlessTable* GetBindlessTable() { return bindlessTable.get(); }
 
 private:
 	void CreateCacheCbvSrvUavDescriptorHeap();
@@ -32,9 +38,11 @@ private:
 	Device* device = nullptr;
 	ComPtr<ID3D12DescriptorHeap> cacheCbvSrvUavDescriptorHeap = nullptr;
 	UINT cbvSrvUavDescriptorSize;
-	static const int maxCbvSrvUavDescripotrCount = 2048;
+	static const int maxCbvSrvUavDescripotrCount = 2048;  // per frame
 
+	uint32_t cbvSrvUavDescriptorBase = 0;
 	uint32_t cbvSrvUavDescriptorOffset = 0;
+	std::unique_ptr<BindlessTable> bindlessTable = nullptr;
 	ComPtr<ID3D12DescriptorHeap> cacheRtvDescriptorHeap = nullptr;
 	UINT rtvDescriptorSize;
 	static const int maxRtvDescriptorCount = 1024;
@@ -3,7 +3,7 @@
 #include "../Common/d3dx12.h"
 #include "../Common/DXHelper.h"
 #include "Resource.h"
-#include <mutex>
+#include "SlotIndexAllocator.h"
 
 class DescriptorHeap final :public Resource 
 {
@@ -14,8 +14,7 @@ private:
 	D3D12_GPU_DESCRIPTOR_HANDLE hGPUHeapStart;
 	uint HandleIncrementSize;
 	uint64 numDescriptors;    // е
-	std::vector<uint> allocatePool;   // أڹѷ
-	std::mutex heapMtx;   // ߳ͬ
+	SlotIndexAllocator slots; // same lock free allocator as HeapSlotAllocator
 
 public:
 	uint64 Length() const { return numDescriptors; }
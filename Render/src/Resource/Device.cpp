@@ -11,7 +11,10 @@ Device::Device(D3D12RHI* InD3D12RHI)
 
 Device::~Device()
 {
+	// Delay disposed resources free into the allocators, release them while those still exist
+	commandContext->DestroyCommandContext();
 
+	deferredDeletionQueue->Flush();
 }
 
 void Device::Initialize()
@@ -28,18 +31,24 @@ void Device::Initialize()
 		ThrowIfFailed(D3D12CreateDevice(WarpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&d3dDevice)));
 	}
 
+	//Create deferred deletion queue, before anything that frees through it
+	deferredDeletionQueue = std::make_unique<DeferredDeletionQueue>();
+
 	//Create CommandContext
 	commandContext = std::make_unique<CommandContext>(this);
 
 	//Create memory allocator
-	uploadBufferAllocator = std::make_unique<UploadBufferAllocator>(d3dDevice.Get());
-	defaultBufferAllocator = std::make_unique<DefaultBufferAllocator>(d3dDevice.Get());
-	textureResourceAllocator = std::make_unique<TextureResourceAllocator>(d3dDevice.Get());
+	uploadBufferAllocator = std::make_unique<UploadBufferAllocator>(d3dDevice.Get(), deferredDeletionQueue.get());
+	defaultBufferAllocator = std::make_unique<DefaultBufferAllocator>(d3dDevice.Get(), deferredDeletionQueue.get());
+	textureResourceAllocator = std::make_unique<TextureResourceAllocator>(d3dDevice.Get(), deferredDeletionQueue.get());
 
 	//Create heapSlot allocator
 	RTVHeapSlotAllocator = std::make_unique<HeapSlotAllocator>(d3dDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 200);
 	DSVHeapSlotAllocator = std::make_unique<HeapSlotAllocator>(d3dDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 200);
 	SRVHeapSlotAllocator = std::make_unique<HeapSlotAllocator>(d3dDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 200);
+
+	//Create copy queue uploader
+	copyQueueUploader = std::make_unique<CopyQueueUploader>(d3dDevice.Get());
 }
 
 HeapSlotAllocator* Device::GetHeapSlotAllocator(D3D12_DESCRIPTOR_HEAP_TYPE heapType)
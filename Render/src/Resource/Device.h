@@ -3,6 +3,7 @@
 #include "CommandContext.h"
 #include "MemoryAllocator.h"
 #include "HeapSlotAllocator.h"
+#include "CopyQueueUploader.h"
 
 class D3D12RHI;
 
@@ -22,6 +23,8 @@ public:
 	TextureResourceAllocator* GetTextureResourceAllocator() { return textureResourceAllocator.get(); }
 	DXRResourceAllocator* GetDXRResourceAllocator() { return m_dxrResourceAllocator.get(); }
 	HeapSlotAllocator* GetHeapSlotAllocator(D3D12_DESCRIPTOR_HEAP_TYPE HeapType);
+	CopyQueueUploader* GetCopyQueueUploader() { return copyQueueUploader.get(); }
+	DeferredDeletionQueue* GetDeferredDeletionQueue() { return deferredDeletionQueue.get(); }
 
 private:
 	void Initialize();
@@ -29,6 +32,8 @@ private:
 private:
 	D3D12RHI* d3d12RHI = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12Device5> d3dDevice = nullptr;
+	// Every allocator frees through it, declared first so it is destroyed last
+	std::unique_ptr<DeferredDeletionQueue> deferredDeletionQueue = nullptr;
 	std::unique_ptr<CommandContext> commandContext = nullptr;
 
 private:
@@ -39,4 +44,6 @@ private:
 	std::unique_ptr<HeapSlotAllocator> RTVHeapSlotAllocator = nullptr;
 	std::unique_ptr<HeapSlotAllocator> DSVHeapSlotAllocator = nullptr;
 	std::unique_ptr<HeapSlotAllocator> SRVHeapSlotAllocator = nullptr;
+
+	std::unique_ptr<CopyQueueUploader> copyQueueUploader = nullptr;
 };
\ No newline at end of file
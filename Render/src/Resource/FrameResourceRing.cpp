@@ -0,0 +1,106 @@
+#include "FrameResourceRing.h"
+#include <algorithm>
+#include <assert.h>
+
+FrameResourceRing::FrameResourceRing(uint32_t inFrameCount)
+	:frames(inFrameCount)
+{
+	assert(inFrameCount > 0);
+}
+
+FrameResourceRing::~FrameResourceRing()
+{
+	// The owner flushed the queue, nothing is in use anymore
+	for (uint32_t i = 0; i < (uint32_t)frames.size(); i++)
+	{
+		ReleaseFrame(frames[(frameIndex + i) % frames.size()]);
+	}
+
+	ReleaseFrame(recordingFrame);
+}
+
+void FrameResourceRing::BeginFrame(uint64_t completedFenceValue)
+{
+	assert(GetWaitFenceValue() <= completedFenceValue && "Frame slot is still in use by the GPU");
+
+	Retire(completedFenceValue);
+}
+
+void FrameResourceRing::AddDelayDisposeResource(std::shared_ptr<const void> resource)
+{
+	if (resource)
+	{
+		recordingFrame.delayDisposeResources.push_back(std::move(resource));
+	}
+}
+
+void FrameResourceRing::AddAfterSyncEvent(std::function<void()> event)
+{
+	recordingFrame.afterSyncEvents.push_back(std::move(event));
+}
+
+void FrameResourceRing::EndFrame(uint64_t fenceValue)
+{
+	Frame& frame = frames[frameIndex];
+	assert(fenceValue >= frame.fenceValue);
+
+	frame.fenceValue = fenceValue;
+
+	// The slot is empty unless the caller skipped BeginFrame, then its old content waits for the newer fence
+	for (auto& resource : recordingFrame.delayDisposeResources)
+	{
+		frame.delayDisposeResources.push_back(std::move(resource));
+	}
+	for (auto& event : recordingFrame.afterSyncEvents)
+	{
+		frame.afterSyncEvents.push_back(std::move(event));
+	}
+	recordingFrame.delayDisposeResources.clear();
+	recordingFrame.afterSyncEvents.clear();
+
+	frameIndex = (frameIndex + 1) % (uint32_t)frames.size();
+}
+
+void FrameResourceRing::Retire(uint64_t completedFenceValue)
+{
+	lastCompletedFenceValue = (std::max)(lastCompletedFenceValue, completedFenceValue);
+
+	// Oldest first, the current slot ended longest ago
+	for (uint32_t i = 0; i < (uint32_t)frames.size(); i++)
+	{
+		Frame& frame = frames[(frameIndex + i) % frames.size()];
+		if (frame.fenceValue <= lastCompletedFenceValue)
+		{
+			ReleaseFrame(frame);
+		}
+	}
+}
+
+uint32_t FrameResourceRing::GetFramesInFlight() const
+{
+	uint32_t count = 0;
+	for (const Frame& frame : frames)
+	{
+		if (frame.fenceValue > lastCompletedFenceValue)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+void FrameResourceRing::ReleaseFrame(Frame& frame)
+{
+	// Events may hand new work to the recording frame, never to this one
+	std::vector<std::function<void()>> events;
+	events.swap(frame.afterSyncEvents);
+
+	for (auto& event : events)
+	{
+		event();
+	}
+
+	// Keep the capacity
+	frame.delayDisposeResources.clear();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Frames the CPU may record ahead of the GPU, also the swap chain buffer count
+#define FRAME_RESOURCE_COUNT 3
+
+// Ring of per-frame slots, tagged with the fence value signaled at the end of their frame.
+// A slot is recorded again only once the GPU passed its fence. Resources and events handed over while a frame
+// is recorded belong to that frame and are released once its fence completed.
+// Knows nothing about queues, CommandContext drives it with the direct queue fence, a counter works as well.
+class FrameResourceRing
+{
+public:
+	FrameResourceRing(uint32_t inFrameCount = FRAME_RESOURCE_COUNT);
+	~FrameResourceRing();
+
+	// Fence value the current slot waits for before it is recorded again, 0 if it is free
+	uint64_t GetWaitFenceValue() const { return frames[frameIndex].fenceValue; }
+
+	// The GPU must have passed GetWaitFenceValue
+	void BeginFrame(uint64_t completedFenceValue);
+
+	// Released once the GPU is done with the current frame
+	void AddDelayDisposeResource(std::shared_ptr<const void> resource);
+	void AddAfterSyncEvent(std::function<void()> event);
+
+	// fenceValue is signaled after the frame's command lists, moves to the next slot
+	void EndFrame(uint64_t fenceValue);
+
+	// Release every ended frame whose fence completed, the frame being recorded is kept
+	void Retire(uint64_t completedFenceValue);
+
+	uint32_t GetFrameIndex() const { return frameIndex; }
+	uint32_t GetFrameCount() const { return (uint32_t)frames.size(); }
+
+	// Ended frames the GPU has not finished as of the last Retire
+	uint32_t GetFramesInFlight() const;
+
+private:
+	struct Frame
+	{
+		uint64_t fenceValue = 0;
+		std::vector<std::shared_ptr<const void>> delayDisposeResources;
+		std::vector<std::function<void()>> afterSyncEvents;
+	};
+
+	void ReleaseFrame(Frame& frame);
+
+private:
+	std::vector<Frame> frames;
+	uint32_t frameIndex = 0;
+
+	// Handed over since the last EndFrame
+	Frame recordingFrame;
+
+	uint64_t lastCompletedFenceValue = 0;
+};
@@ -0,0 +1,72 @@
+#include "FrameRingBuffer.h"
+#include "D3D12RHI.h"
+#include "FrameResourceRing.h"
+#include <algorithm>
+#include <assert.h>
+
+FrameRingBuffer::FrameRingBuffer(D3D12RHI* inD3D12RHI, uint32_t inFrameSize)
+	:d3d12RHI(inD3D12RHI)
+{
+	assert(inFrameSize > 0);
+
+	CreateBuffer(inFrameSize);
+}
+
+void FrameRingBuffer::CreateBuffer(uint32_t inFrameSize)
+{
+	frameSize = inFrameSize;
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> D3DResource;
+
+	auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer((UINT64)frameSize * FRAME_RESOURCE_COUNT);
+	ThrowIfFailed(d3d12RHI->GetDevice()->GetD3DDevice()->CreateCommittedResource(
+		&heapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&resourceDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&D3DResource)));
+
+	// Releasing the old location hands its resource to the deferred deletion queue
+	bufferLocation = std::make_unique<ResourceLocation>();
+	bufferLocation->SetType(ResourceLocation::EResourceLocationType::StandAlone);
+	bufferLocation->deletionQueue = d3d12RHI->GetDevice()->GetDeferredDeletionQueue();
+	bufferLocation->allocationSize = d3d12RHI->GetDevice()->GetD3DDevice()->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes;
+	bufferLocation->underlyingResource = new Resource(D3DResource, D3D12_RESOURCE_STATE_GENERIC_READ);
+	bufferLocation->underlyingResource->Map();
+	bufferLocation->virtualAddressGPU = bufferLocation->underlyingResource->virtualAddressGPU;
+	bufferLocation->mappedAddress = bufferLocation->underlyingResource->mappedBaseAddress;
+
+	regionOffset = d3d12RHI->GetFrameResourceIndex() * frameSize;
+	usedSize = 0;
+}
+
+void FrameRingBuffer::BeginFrame()
+{
+	regionOffset = d3d12RHI->GetFrameResourceIndex() * frameSize;
+	usedSize = 0;
+}
+
+void* FrameRingBuffer::Allocate(uint32_t size, uint32_t alignment, D3D12_GPU_VIRTUAL_ADDRESS& outGPUAddress)
+{
+	uint32_t offset = (usedSize + alignment - 1) / alignment * alignment;
+
+	if (offset + size > frameSize)
+	{
+		// Allocations made before in this frame keep pointing into the old buffer
+		uint32_t newFrameSize = frameSize;
+		while (newFrameSize < size + alignment)
+		{
+			newFrameSize *= 2;
+		}
+
+		CreateBuffer((std::max)(newFrameSize, frameSize * 2));
+		offset = 0;
+	}
+
+	usedSize = offset + size;
+
+	outGPUAddress = bufferLocation->virtualAddressGPU + regionOffset + offset;
+	return static_cast<uint8_t*>(bufferLocation->mappedAddress) + regionOffset + offset;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include "Resource.h"
+
+class D3D12RHI;
+
+// Persistently mapped upload buffer with one region per frame slot, for data rewritten every frame.
+// A slot is recorded again only after the GPU finished it, so its region is reused without waiting or copying.
+// Running out of room replaces the buffer by a larger one, the old one goes to the deferred deletion queue
+// and stays alive until the frames reading it are done.
+class FrameRingBuffer
+{
+public:
+	FrameRingBuffer(D3D12RHI* inD3D12RHI, uint32_t inFrameSize);
+
+	// Starts over in the region of the current frame slot, call once per frame after D3D12RHI::BeginFrame
+	void BeginFrame();
+
+	// CPU address for size bytes, the GPU reads them at outGPUAddress in the frame being recorded
+	void* Allocate(uint32_t size, uint32_t alignment, D3D12_GPU_VIRTUAL_ADDRESS& outGPUAddress);
+
+	uint32_t GetFrameSize() const { return frameSize; }
+
+private:
+	void CreateBuffer(uint32_t inFrameSize);
+
+private:
+	D3D12RHI* d3d12RHI = nullptr;
+
+	std::unique_ptr<ResourceLocation> bufferLocation;
+	uint32_t frameSize = 0;
+
+	// Region of the current frame and the bytes used in it
+	uint32_t regionOffset = 0;
+	uint32_t usedSize = 0;
+};
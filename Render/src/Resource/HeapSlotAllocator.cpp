@@ -28,104 +28,78 @@ D3D12_DESCRIPTOR_HEAP_DESC HeapSlotAllocator::CreateHeapDesc(D3D12_DESCRIPTOR_HE
 
 void HeapSlotAllocator::AllocateHeap()
 {
-	// Create a new descriptorHeap
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap;
-	ThrowIfFailed(d3dDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap)));
-	SetDebugName(heap.Get(), L"HeapSlotAllocator Descriptor Heap");
+	const uint32_t heapIndex = heapCount.load(std::memory_order_relaxed);
+	if (heapIndex >= MaxHeapCount)
+	{
+		throw std::runtime_error("HeapSlotAllocator: out of descriptor heaps");
+	}
 
-	// Add an entry covering the entire heap.
-	DescriptorHandle heapBase = heap->GetCPUDescriptorHandleForHeapStart();
-	assert(heapBase.ptr != 0);
+	// Create a new descriptorHeap
+	auto entry = std::make_unique<HeapEntry>(heapDesc.NumDescriptors);
+	ThrowIfFailed(d3dDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&entry->heap)));
+	SetDebugName(entry->heap.Get(), L"HeapSlotAllocator Descriptor Heap");
 
-	HeapEntry entry;
-	entry.heap = heap;
-	entry.freeList.push_back({ heapBase.ptr, heapBase.ptr + (SIZE_T)heapDesc.NumDescriptors * descriptorSize });
+	entry->heapBase = entry->heap->GetCPUDescriptorHandleForHeapStart();
+	assert(entry->heapBase.ptr != 0);
 
-	// Add the entry to HeapMap
-	heapMap.push_back(entry);
+	// Publish the entry, allocators that see the new count also see the entry
+	heapMap[heapIndex] = std::move(entry);
+	heapCount.store(heapIndex + 1, std::memory_order_release);
 }
 
-HeapSlotAllocator::HeapSlot HeapSlotAllocator::AllocateHeapSlot()
+bool HeapSlotAllocator::TryAllocateHeapSlot(uint32_t count, HeapSlot& outSlot)
 {
-	// Find the entry with free list
-	int entryIndex = -1;
-	for (int i = 0; i < heapMap.size(); i++)
+	if (count == 0)
 	{
-		if (heapMap[i].freeList.size() > 0)
-		{
-			entryIndex = i;
-			break;
-		}
+		return false;
 	}
 
-	// If all entries are full, create a new one
-	if (entryIndex == -1)
+	// Start with the heap of the last allocation, the others only when it is full
+	const uint32_t firstHeap = currentHeap.load(std::memory_order_relaxed) % count;
+	for (uint32_t i = 0; i < count; i++)
 	{
-		AllocateHeap();
+		const uint32_t heapIndex = (firstHeap + i) % count;
+		HeapEntry& entry = *heapMap[heapIndex];
 
-		entryIndex = int(heapMap.size() - 1);
-	}
-
-	HeapEntry& entry = heapMap[entryIndex];
-	assert(entry.freeList.size() > 0);
-
-	// Allocate  a slot
-	FreeRange& range = entry.freeList.front();
-	HeapSlot slot = { (uint32_t)entryIndex, range.start };
+		const uint32_t slotIndex = entry.slots.Allocate();
+		if (slotIndex != SlotIndexAllocator::InvalidIndex)
+		{
+			currentHeap.store(heapIndex, std::memory_order_relaxed);
 
-	// Remove this range if all slot has been allocated.
-	range.start += descriptorSize;
-	if (range.start == range.end)
-	{
-		entry.freeList.pop_front();
+			outSlot.heapIndex = heapIndex;
+			outSlot.slotIndex = slotIndex;
+			outSlot.handle.ptr = entry.heapBase.ptr + (SIZE_T)slotIndex * descriptorSize;
+			return true;
+		}
 	}
 
-	return slot;
+	return false;
 }
 
-void HeapSlotAllocator::FreeHeapSlot(const HeapSlot& slot)
+HeapSlotAllocator::HeapSlot HeapSlotAllocator::AllocateHeapSlot()
 {
-	assert(slot.heapIndex < heapMap.size());
-	HeapEntry& entry = heapMap[slot.heapIndex];
-
-	FreeRange newRange =
-	{
-		slot.handle.ptr,
-		slot.handle.ptr + descriptorSize
-	};
-
-	bool bFound = false;
-	for (auto node = entry.freeList.begin(); node != entry.freeList.end() && !bFound; node++)
+	HeapSlot slot;
+	if (TryAllocateHeapSlot(heapCount.load(std::memory_order_acquire), slot))
 	{
-		FreeRange& range = *node;
-		assert(range.start < range.end);
-
-		if (range.start == newRange.end) //Merge NewRange and Range
-		{
-			range.start = newRange.start;
-			bFound = true;
-		}
-		else if (range.end == newRange.start) // Merge Range and NewRange
-		{
-			range.end = newRange.end;
-			bFound = true;
-		}
-		else
-		{
-			assert(range.end < newRange.start || range.start > newRange.start);
-			if (range.start > newRange.start) // Insert NewRange before Range
-			{
-				entry.freeList.insert(node, newRange);
-				bFound = true;
-			}
-		}
+		return slot;
 	}
 
-	if (!bFound)
+	// All heaps are full, one thread creates the next one while the others wait and retry
+	std::lock_guard<std::mutex> lock(growMutex);
+
+	while (!TryAllocateHeapSlot(heapCount.load(std::memory_order_acquire), slot))
 	{
-		// Add  NewRange to tail
-		entry.freeList.push_back(newRange);
+		AllocateHeap();
 	}
+
+	return slot;
 }
 
+void HeapSlotAllocator::FreeHeapSlot(const HeapSlot& slot)
+{
+	assert(slot.heapIndex < heapCount.load(std::memory_order_acquire));
+	HeapEntry& entry = *heapMap[slot.heapIndex];
 
+	assert(slot.handle.ptr == entry.heapBase.ptr + (SIZE_T)slot.slotIndex * descriptorSize);
+	entry.slots.Free(slot.slotIndex);
+}
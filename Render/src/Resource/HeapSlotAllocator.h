@@ -1,50 +1,58 @@
 #pragma once
 
 #include "../Utils/D3D12Utils.h"
-#include <list>
+#include "SlotIndexAllocator.h"
+#include <mutex>
 
 // CPU only
 class HeapSlotAllocator
 {
 public:
 	typedef D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHandle;
-	typedef decltype(DescriptorHandle::ptr) DescriptorHandleRaw;
 
 	struct HeapSlot
 	{
-		uint32_t heapIndex;
-		D3D12_CPU_DESCRIPTOR_HANDLE handle;
+		uint32_t heapIndex = 0;
+		uint32_t slotIndex = SlotIndexAllocator::InvalidIndex;
+		D3D12_CPU_DESCRIPTOR_HANDLE handle = { 0 };
 	};
 
-private:
-	struct FreeRange
-	{
-		DescriptorHandleRaw start;
-		DescriptorHandleRaw end;
-	};
+	// Heaps are never released, so their entries can be read without a lock
+	static const uint32_t MaxHeapCount = 64;
 
+private:
 	struct HeapEntry
 	{
 		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap = nullptr;
-		std::list<HeapSlotAllocator::FreeRange> freeList;
+		DescriptorHandle heapBase = { 0 };
+		SlotIndexAllocator slots;
 
-		HeapEntry() { }
+		HeapEntry(uint32_t numDescriptors) :slots(numDescriptors) { }
 	};
 
 public:
 	HeapSlotAllocator(ID3D12Device5* inDevice, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerHeap);
 	~HeapSlotAllocator();
 
+	// Thread safe, only creating a new heap takes a lock
 	HeapSlot AllocateHeapSlot();
 	void FreeHeapSlot(const HeapSlot& slot);
 
 private:
 	D3D12_DESCRIPTOR_HEAP_DESC CreateHeapDesc(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerHeap);
 	void AllocateHeap();
+	bool TryAllocateHeapSlot(uint32_t heapCount, HeapSlot& outSlot);
 
 private:
 	ID3D12Device5* d3dDevice;
 	const D3D12_DESCRIPTOR_HEAP_DESC heapDesc;
 	const uint32_t descriptorSize;
-	std::vector<HeapEntry> heapMap;
-};
\ No newline at end of file
+
+	std::unique_ptr<HeapEntry> heapMap[MaxHeapCount];
+	std::atomic<uint32_t> heapCount = 0;
+
+	// Heap the last allocation came from, searches start there
+	std::atomic<uint32_t> currentHeap = 0;
+
+	std::mutex growMutex;
+};
@@ -218,20 +218,28 @@ uint32_t BuddyAllocator::AllocateBlock(uint32_t order)
 
 void BuddyAllocator::Deallocate(ResourceLocation& resourceLocation)
 {
-	deferredDeletionQueue.push_back(resourceLocation.blockData);
-}
+	const BuddyBlockData& block = resourceLocation.blockData;
 
-void BuddyAllocator::CleanUpAllocations()
-{
-	for (int32_t i = 0; i < deferredDeletionQueue.size(); i++)
+	if (initData.deletionQueue)
+	{
+		// Frames in flight may still use the block
+		const uint64_t handle = ((uint64_t)block.order << 32) | block.offset;
+		initData.deletionQueue->Enqueue(this, handle, block.placedResource, (uint64_t)OrderToUnitSize(block.order) * minBlockSize);
+	}
+	else
 	{
-		const BuddyBlockData& block = deferredDeletionQueue[i];
-
 		DeallocateInternal(block);
 	}
+}
 
-	// clear out all of the released blocks, don't allow the array to shrink
-	deferredDeletionQueue.clear();
+void BuddyAllocator::Delete(uint64_t handle, void* object)
+{
+	BuddyBlockData block;
+	block.offset = (uint32_t)handle;
+	block.order = (uint32_t)(handle >> 32);
+	block.placedResource = static_cast<Resource*>(object);
+
+	DeallocateInternal(block);
 }
 
 void BuddyAllocator::DeallocateInternal(const BuddyBlockData& block)
@@ -302,20 +310,13 @@ bool MultiBuddyAllocator::AllocResource(uint32_t size, uint32_t alignment, Resou
 	return true;
 }
 
-void MultiBuddyAllocator::CleanUpAllocations()
-{
-	for (auto& allocator : allocators)
-	{
-		allocator->CleanUpAllocations();
-	}
-}
-
-UploadBufferAllocator::UploadBufferAllocator(ID3D12Device5* InDevice)
+UploadBufferAllocator::UploadBufferAllocator(ID3D12Device5* InDevice, DeferredDeletionQueue* deletionQueue)
 {
 	BuddyAllocator::AllocatorInitData initData;
 	initData.allocationStrategy = BuddyAllocator::EAllocationStrategy::ManualSubAllocation;
 	initData.heapType = D3D12_HEAP_TYPE_UPLOAD;
 	initData.resourceFlags = D3D12_RESOURCE_FLAG_NONE;
+	initData.deletionQueue = deletionQueue;
 
 	allocator = std::make_unique<MultiBuddyAllocator>(InDevice, initData);
 
@@ -329,20 +330,16 @@ void* UploadBufferAllocator::AllocUploadResource(uint32_t size, uint32_t alignme
 	return resourceLocation.mappedAddress;
 }
 
-void UploadBufferAllocator::CleanUpAllocations()
-{
-	allocator->CleanUpAllocations();
-}
 
 
-
-DefaultBufferAllocator::DefaultBufferAllocator(ID3D12Device5* InDevice)
+DefaultBufferAllocator::DefaultBufferAllocator(ID3D12Device5* InDevice, DeferredDeletionQueue* deletionQueue)
 {
 	{
 		BuddyAllocator::AllocatorInitData initData;
 		initData.allocationStrategy = BuddyAllocator::EAllocationStrategy::ManualSubAllocation;
 		initData.heapType = D3D12_HEAP_TYPE_DEFAULT;
 		initData.resourceFlags = D3D12_RESOURCE_FLAG_NONE;
+		initData.deletionQueue = deletionQueue;
 
 		allocator = std::make_unique<MultiBuddyAllocator>(InDevice, initData);
 	}
@@ -352,6 +349,7 @@ DefaultBufferAllocator::DefaultBufferAllocator(ID3D12Device5* InDevice)
 		initData.allocationStrategy = BuddyAllocator::EAllocationStrategy::ManualSubAllocation;
 		initData.heapType = D3D12_HEAP_TYPE_DEFAULT;
 		initData.resourceFlags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+		initData.deletionQueue = deletionQueue;
 
 		uavAllocator = std::make_unique<MultiBuddyAllocator>(InDevice, initData);
 	}
@@ -371,19 +369,15 @@ void DefaultBufferAllocator::AllocDefaultResource(const D3D12_RESOURCE_DESC& res
 	}
 }
 
-void DefaultBufferAllocator::CleanUpAllocations()
-{
-	allocator->CleanUpAllocations();
-}
-
 
 
-TextureResourceAllocator::TextureResourceAllocator(ID3D12Device5* inDevice)
+TextureResourceAllocator::TextureResourceAllocator(ID3D12Device5* inDevice, DeferredDeletionQueue* deletionQueue)
 {
 	BuddyAllocator::AllocatorInitData initData;
 	initData.allocationStrategy = BuddyAllocator::EAllocationStrategy::PlacedResource;
 	initData.heapType = D3D12_HEAP_TYPE_DEFAULT;
 	initData.heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+	initData.deletionQueue = deletionQueue;
 
 	allocator = std::make_unique<MultiBuddyAllocator>(inDevice, initData);
 
@@ -409,12 +403,7 @@ void TextureResourceAllocator::AllocTextureResource(const D3D12_RESOURCE_STATES&
 	}
 }
 
-void TextureResourceAllocator::CleanUpAllocations()
-{
-	allocator->CleanUpAllocations();
-}
-
-DXRResourceAllocator::DXRResourceAllocator(ID3D12Device5* inDevice)
+DXRResourceAllocator::DXRResourceAllocator(ID3D12Device5* inDevice, DeferredDeletionQueue* deletionQueue)
     : d3dDevice(inDevice)
 {
     BuddyAllocator::AllocatorInitData initData;
@@ -423,6 +412,7 @@ DXRResourceAllocator::DXRResourceAllocator(ID3D12Device5* inDevice)
     // DXR Acceleration Structures are buffers, so this heap flag is appropriate.
     initData.heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
     initData.resourceFlags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+    initData.deletionQueue = deletionQueue;
 
     allocator = std::make_unique<MultiBuddyAllocator>(inDevice, initData);
 }
@@ -521,11 +511,3 @@ void DXRResourceAllocator::AllocScratchResource(
     resourceLocation.underlyingResource = newUnderlyingResource;
     resourceLocation.blockData.placedResource = newUnderlyingResource;
 }
-
-void DXRResourceAllocator::CleanUpAllocations()
-{
-    if (allocator)
-    {
-        allocator->CleanUpAllocations();
-    }
-}
\ No newline at end of file
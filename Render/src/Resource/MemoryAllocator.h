@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Resource.h"
+#include "DeferredDeletionQueue.h"
 #include <stdint.h>
 #include <set>
 
@@ -9,7 +10,7 @@
 #define DEFAULT_RESOURCE_ALIGNMENT 4
 #define UPLOAD_RESOURCE_ALIGNMENT 256
 
-class BuddyAllocator
+class BuddyAllocator : public IDeferredDeletionVisitor
 {
 public:
 	enum class EAllocationStrategy
@@ -24,6 +25,7 @@ public:
 		D3D12_HEAP_TYPE heapType;
 		D3D12_HEAP_FLAGS heapFlags = D3D12_HEAP_FLAG_NONE;    // only for PlacedResource
 		D3D12_RESOURCE_FLAGS resourceFlags = D3D12_RESOURCE_FLAG_NONE;    // only for ManualSubAllocation
+		DeferredDeletionQueue* deletionQueue = nullptr;    // blocks are freed right away without one
 	};
 
 public:
@@ -31,8 +33,11 @@ public:
 	~BuddyAllocator();
 
 	bool AllocResource(uint32_t size, uint32_t alignment, ResourceLocation& resourceLocation);
+	// The block goes back to the free lists once the GPU passed the current frame, see DeferredDeletionQueue
 	void Deallocate(ResourceLocation& resourceLocation);
-	void CleanUpAllocations();
+
+	// IDeferredDeletionVisitor
+	void Delete(uint64_t handle, void* object) override;
 
 	ID3D12Heap* GetBackingHeap() { return backingHeap; }
 	EAllocationStrategy GetAllocationStrategy() { return initData.allocationStrategy; }
@@ -64,7 +69,6 @@ private:
 	uint32_t maxOrder;
 	uint32_t totalAllocSize = 0;
 	std::vector<std::set<uint32_t>> freeBlocks;
-	std::vector<BuddyBlockData> deferredDeletionQueue;
 	ID3D12Device5* d3dDevice;
 	Resource* backingResource = nullptr;
 	ID3D12Heap* backingHeap = nullptr;
@@ -76,7 +80,6 @@ public:
 	MultiBuddyAllocator(ID3D12Device5* device, const BuddyAllocator::AllocatorInitData& initData);
 	~MultiBuddyAllocator();
 	bool AllocResource(uint32_t size, uint32_t alignment, ResourceLocation& resourceLocation);
-	void CleanUpAllocations();
 
 private:
 	std::vector<std::shared_ptr<BuddyAllocator>> allocators;
@@ -87,9 +90,8 @@ private:
 class UploadBufferAllocator
 {
 public:
-	UploadBufferAllocator(ID3D12Device5* InDevice);
+	UploadBufferAllocator(ID3D12Device5* InDevice, DeferredDeletionQueue* deletionQueue);
 	void* AllocUploadResource(uint32_t size, uint32_t alignment, ResourceLocation& resourceLocation);
-	void CleanUpAllocations();
 
 private:
 	std::unique_ptr<MultiBuddyAllocator> allocator = nullptr;
@@ -99,9 +101,8 @@ private:
 class DefaultBufferAllocator
 {
 public:
-	DefaultBufferAllocator(ID3D12Device5* InDevice);
+	DefaultBufferAllocator(ID3D12Device5* InDevice, DeferredDeletionQueue* deletionQueue);
 	void AllocDefaultResource(const D3D12_RESOURCE_DESC& resourceDesc, uint32_t alignment, ResourceLocation& resourceLocation);
-	void CleanUpAllocations();
 
 private:
 	std::unique_ptr<MultiBuddyAllocator> allocator = nullptr;
@@ -112,9 +113,8 @@ private:
 class TextureResourceAllocator
 {
 public:
-	TextureResourceAllocator(ID3D12Device5* InDevice);
+	TextureResourceAllocator(ID3D12Device5* InDevice, DeferredDeletionQueue* deletionQueue);
 	void AllocTextureResource(const D3D12_RESOURCE_STATES& resourceState, const D3D12_RESOURCE_DESC& resourceDesc, ResourceLocation& resourceLocation);
-	void CleanUpAllocations();
 
 private:
 	std::unique_ptr<MultiBuddyAllocator> allocator = nullptr;
@@ -124,11 +124,9 @@ private:
 class DXRResourceAllocator
 {
 public:
-	DXRResourceAllocator(ID3D12Device5* InDevice);
+	DXRResourceAllocator(ID3D12Device5* InDevice, DeferredDeletionQueue* deletionQueue);
 	void AllocAccelerationStructureResource(UINT64 sizeInBytes, const std::wstring& resourceName, ResourceLocation& resourceLocation);
 	void AllocScratchResource(UINT64 sizeInBytes, const std::wstring& resourceName, ResourceLocation& resourceLocation);
-	
-	void CleanUpAllocations();
 
 private:
 	std::unique_ptr<MultiBuddyAllocator> allocator = nullptr;
@@ -1,6 +1,21 @@
 #include "Resource.h"
 #include "MemoryAllocator.h"
 
+namespace
+{
+	// StandAlone resources own their D3D resource, the handle is unused
+	class StandAloneResourceDeleter : public IDeferredDeletionVisitor
+	{
+	public:
+		void Delete(uint64_t handle, void* object) override
+		{
+			delete static_cast<Resource*>(object);
+		}
+	};
+
+	StandAloneResourceDeleter standAloneResourceDeleter;
+}
+
 Resource::Resource(Microsoft::WRL::ComPtr<ID3D12Resource> InD3DResource, D3D12_RESOURCE_STATES InitState)
 	:D3DResource(InD3DResource), currentState(InitState)
 {
@@ -32,7 +47,15 @@ void ResourceLocation::ReleaseResource()
 
 	case ResourceLocation::EResourceLocationType::StandAlone:
 	{
-		delete underlyingResource;
+		if (deletionQueue && underlyingResource)
+		{
+			// Frames in flight may still use the resource
+			deletionQueue->Enqueue(&standAloneResourceDeleter, 0, underlyingResource, allocationSize);
+		}
+		else
+		{
+			delete underlyingResource;
+		}
 		break;
 	}
 
@@ -2,6 +2,7 @@
 #include "../Utils/D3D12Utils.h"
 
 class BuddyAllocator;
+class DeferredDeletionQueue;
 
 class Resource
 {
@@ -51,6 +52,8 @@ public:
 	BuddyBlockData blockData;
 	// StandAlone resource 
 	Resource* underlyingResource = nullptr;
+	DeferredDeletionQueue* deletionQueue = nullptr;  // StandAlone resources are deleted right away without one
+	uint64_t allocationSize = 0;                     // Set with deletionQueue, the bytes the queue holds until the delete
 
 	union
 	{
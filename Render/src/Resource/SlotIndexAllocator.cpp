@@ -0,0 +1,80 @@
+#include "SlotIndexAllocator.h"
+#include <assert.h>
+#include <bit>
+
+SlotIndexAllocator::SlotIndexAllocator(uint32_t inSlotCount)
+	:slotCount(inSlotCount),
+	wordCount((inSlotCount + 63) / 64),
+	words(new std::atomic<uint64_t>[(inSlotCount + 63) / 64])
+{
+	Reset();
+}
+
+void SlotIndexAllocator::Reset()
+{
+	for (uint32_t i = 0; i < wordCount; i++)
+	{
+		words[i].store(0, std::memory_order_relaxed);
+	}
+
+	const uint32_t tailBits = slotCount % 64;
+	if (tailBits != 0)
+	{
+		words[wordCount - 1].store(~0ull << tailBits, std::memory_order_relaxed);
+	}
+
+	searchWord.store(0, std::memory_order_relaxed);
+	allocatedCount.store(0, std::memory_order_release);
+}
+
+uint32_t SlotIndexAllocator::Allocate()
+{
+	// Full pools fail without touching the bitmap
+	if (allocatedCount.load(std::memory_order_relaxed) >= slotCount)
+	{
+		return InvalidIndex;
+	}
+
+	const uint32_t firstWord = searchWord.load(std::memory_order_relaxed);
+	for (uint32_t i = 0; i < wordCount; i++)
+	{
+		const uint32_t wordIndex = (firstWord + i) % wordCount;
+		std::atomic<uint64_t>& word = words[wordIndex];
+
+		uint64_t bits = word.load(std::memory_order_relaxed);
+		while (bits != ~0ull)
+		{
+			// Lowest free bit, retried if another thread took a bit of this word first
+			const uint32_t bit = (uint32_t)std::countr_one(bits);
+			if (word.compare_exchange_weak(bits, bits | (1ull << bit), std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				searchWord.store(wordIndex, std::memory_order_relaxed);
+				allocatedCount.fetch_add(1, std::memory_order_relaxed);
+				return wordIndex * 64 + bit;
+			}
+		}
+	}
+
+	return InvalidIndex;
+}
+
+void SlotIndexAllocator::Free(uint32_t index)
+{
+	assert(index < slotCount);
+
+	const uint64_t mask = 1ull << (index % 64);
+	const uint64_t oldBits = words[index / 64].fetch_and(~mask, std::memory_order_release);
+	assert((oldBits & mask) != 0 && "slot freed twice");
+	(void)oldBits;
+
+	allocatedCount.fetch_sub(1, std::memory_order_relaxed);
+
+	// The next allocation reuses this slot while its descriptor is still in cache
+	searchWord.store(index / 64, std::memory_order_relaxed);
+}
+
+bool SlotIndexAllocator::IsAllocated(uint32_t index) const
+{
+	assert(index < slotCount);
+	return (words[index / 64].load(std::memory_order_acquire) & (1ull << (index % 64))) != 0;
+}
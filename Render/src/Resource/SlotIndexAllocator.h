@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Fixed size pool of slot indices, one bit per slot.
+// Allocate and Free are lock free, so views can be created from loader jobs while the render thread does the same.
+// Knows nothing about descriptors, HeapSlotAllocator turns the indices into handles.
+class SlotIndexAllocator
+{
+public:
+	static const uint32_t InvalidIndex = UINT32_MAX;
+
+	explicit SlotIndexAllocator(uint32_t inSlotCount);
+
+	SlotIndexAllocator(const SlotIndexAllocator& Other) = delete;
+	SlotIndexAllocator& operator=(const SlotIndexAllocator& Other) = delete;
+
+	// Returns InvalidIndex when every slot is in use
+	uint32_t Allocate();
+
+	void Free(uint32_t index);
+
+	// Frees every slot, not safe while other threads allocate
+	void Reset();
+
+	bool IsAllocated(uint32_t index) const;
+	uint32_t GetSlotCount() const { return slotCount; }
+	uint32_t GetAllocatedCount() const { return allocatedCount.load(std::memory_order_relaxed); }
+
+private:
+	const uint32_t slotCount;
+	const uint32_t wordCount;
+
+	// Set bits are allocated, the bits past slotCount in the last word stay set
+	std::unique_ptr<std::atomic<uint64_t>[]> words;
+
+	// Word the last allocation or free touched, searches start there
+	std::atomic<uint32_t> searchWord = 0;
+
+	std::atomic<uint32_t> allocatedCount = 0;
+};
@@ -0,0 +1,183 @@
+#include "UploadScheduler.h"
+#include <algorithm>
+#include <assert.h>
+#include <stdexcept>
+
+UploadScheduler::UploadScheduler(uint64_t inStagingCapacity)
+	:stagingCapacity(inStagingCapacity)
+{
+}
+
+UploadTicket UploadScheduler::Enqueue(std::vector<Chunk>&& chunks, std::shared_ptr<const void> keepAlive)
+{
+	// An empty ring takes any chunk up to its capacity at offset 0, a larger one would never be recorded
+	// and everyone waiting on its ticket would wait forever
+	for (const Chunk& chunk : chunks)
+	{
+		if (chunk.size > stagingCapacity)
+		{
+			throw std::runtime_error("UploadScheduler: upload chunk is larger than the staging ring");
+		}
+	}
+
+	Request request;
+	request.ticket = nextTicket++;
+	request.chunks = std::move(chunks);
+	request.keepAlive = std::move(keepAlive);
+
+	for (const Chunk& chunk : request.chunks)
+	{
+		stats.pendingBytes += chunk.size;
+	}
+
+	requests.push_back(std::move(request));
+
+	return nextTicket - 1;
+}
+
+bool UploadScheduler::AllocateStaging(uint64_t size, uint64_t alignment, uint64_t& outOffset)
+{
+	auto Align = [](uint64_t value, uint64_t alignment) { return (value + alignment - 1) / alignment * alignment; };
+
+	if (stats.stagingBytes == 0)
+	{
+		head = tail = 0;
+	}
+
+	uint64_t offset = Align(head, alignment);
+	uint64_t padding = 0;
+
+	if (head > tail || stats.stagingBytes == 0)
+	{
+		// Free space is [head, capacity) and [0, tail)
+		if (offset + size > stagingCapacity)
+		{
+			if (size > tail)
+			{
+				return false;
+			}
+
+			// Skip the end of the ring
+			padding = stagingCapacity - head;
+			offset = 0;
+		}
+	}
+	else if (offset + size > tail)
+	{
+		// Free space is [head, tail)
+		return false;
+	}
+
+	const uint64_t usedBytes = padding + (offset + size - (padding > 0 ? 0 : head));
+	head = offset + size;
+
+	stats.stagingBytes += usedBytes;
+	stats.peakStagingBytes = (std::max)(stats.peakStagingBytes, stats.stagingBytes);
+	recordedStagingBytes += usedBytes;
+
+	outOffset = offset;
+	return true;
+}
+
+uint64_t UploadScheduler::Record(uint64_t budgetBytes)
+{
+	uint64_t recordedBytes = 0;
+
+	while (!requests.empty())
+	{
+		Request& request = requests.front();
+
+		if (request.nextChunk < request.chunks.size())
+		{
+			Chunk& chunk = request.chunks[request.nextChunk];
+			if (recordedBytes > 0 && recordedBytes + chunk.size > budgetBytes)
+			{
+				break;
+			}
+
+			uint64_t stagingOffset = 0;
+			if (!AllocateStaging(chunk.size, chunk.alignment, stagingOffset))
+			{
+				break;
+			}
+
+			chunk.record(stagingOffset);
+			chunk.record = nullptr;
+
+			recordedBytes += chunk.size;
+			stats.pendingBytes -= chunk.size;
+			request.nextChunk++;
+		}
+
+		if (request.nextChunk == request.chunks.size())
+		{
+			// The source data was copied to the ring, the caller may drop it
+			recordedTickets.push_back(request.ticket);
+			requests.pop_front();
+		}
+	}
+
+	stats.recordedBytes += recordedBytes;
+
+	return recordedBytes;
+}
+
+void UploadScheduler::Submit(uint64_t fenceValue)
+{
+	if (!HasRecordedChunks())
+	{
+		return;
+	}
+
+	assert(submissions.empty() || submissions.back().fenceValue < fenceValue);
+
+	Submission submission;
+	submission.fenceValue = fenceValue;
+	submission.stagingEnd = head;
+	submission.stagingBytes = recordedStagingBytes;
+	submission.tickets = std::move(recordedTickets);
+	submissions.push_back(std::move(submission));
+
+	recordedTickets.clear();
+	recordedStagingBytes = 0;
+	stats.recordedBytes = 0;
+}
+
+void UploadScheduler::Retire(uint64_t completedFenceValue)
+{
+	while (!submissions.empty() && submissions.front().fenceValue <= completedFenceValue)
+	{
+		const Submission& submission = submissions.front();
+
+		tail = submission.stagingEnd;
+		stats.stagingBytes -= submission.stagingBytes;
+
+		if (!submission.tickets.empty())
+		{
+			completedTicket = submission.tickets.back();
+		}
+
+		submissions.pop_front();
+	}
+}
+
+bool UploadScheduler::GetFenceValue(UploadTicket ticket, uint64_t& outFenceValue) const
+{
+	outFenceValue = 0;
+	if (IsComplete(ticket))
+	{
+		return true;
+	}
+
+	// Tickets finish in order, so the first submission that finishes a later ticket covers it too
+	for (const Submission& submission : submissions)
+	{
+		if (!submission.tickets.empty() && submission.tickets.back() >= ticket)
+		{
+			outFenceValue = submission.fenceValue;
+			return true;
+		}
+	}
+
+	return false;
+}
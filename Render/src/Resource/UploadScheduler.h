@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Returned by uploads, larger tickets were enqueued later. 0 is never used, it means nothing to wait for.
+typedef uint64_t UploadTicket;
+
+// Schedules upload chunks into a staging ring, without knowing about queues or resources.
+// Requests are recorded in order, at most a budget of bytes per Record call. Submit tags what was recorded
+// with a fence value and Retire frees the ring and completes tickets once that fence passed.
+// CopyQueueUploader drives it with the copy queue fence, a counter works as well.
+class UploadScheduler
+{
+public:
+	struct Chunk
+	{
+		uint64_t size = 0;
+		uint64_t alignment = 1;
+
+		// Write the data to the staging ring at stagingOffset and record the copy from there
+		std::function<void(uint64_t stagingOffset)> record;
+	};
+
+	struct Stats
+	{
+		uint64_t pendingBytes = 0;   // Enqueued but not recorded
+		uint64_t stagingBytes = 0;   // Ring bytes in use, padding included
+		uint64_t peakStagingBytes = 0;
+		uint64_t recordedBytes = 0;  // Since the last Submit
+	};
+
+public:
+	UploadScheduler(uint64_t inStagingCapacity);
+
+	// keepAlive owns the source data of the chunks until the last of them is recorded.
+	// Throws std::runtime_error without enqueueing anything if a chunk is larger than the staging ring.
+	UploadTicket Enqueue(std::vector<Chunk>&& chunks, std::shared_ptr<const void> keepAlive = nullptr);
+
+	// Record chunks in order until budgetBytes are recorded or the ring is full.
+	// The first chunk is always recorded if it fits, so a budget smaller than a chunk still makes progress.
+	uint64_t Record(uint64_t budgetBytes);
+
+	// Everything recorded since the last Submit is done once fenceValue completes
+	void Submit(uint64_t fenceValue);
+
+	void Retire(uint64_t completedFenceValue);
+
+	bool IsComplete(UploadTicket ticket) const { return ticket <= completedTicket; }
+
+	// Fence value that completes ticket, 0 if it is complete already.
+	// Returns false while chunks of the ticket are not submitted yet.
+	bool GetFenceValue(UploadTicket ticket, uint64_t& outFenceValue) const;
+
+	// Fence of the oldest submission still holding ring space, 0 if none
+	uint64_t GetOldestFenceValue() const { return submissions.empty() ? 0 : submissions.front().fenceValue; }
+
+	UploadTicket GetLastTicket() const { return nextTicket - 1; }
+	bool HasPendingChunks() const { return !requests.empty(); }
+	bool HasRecordedChunks() const { return stats.recordedBytes > 0 || !recordedTickets.empty(); }
+	uint64_t GetStagingCapacity() const { return stagingCapacity; }
+	const Stats& GetStats() const { return stats; }
+
+private:
+	bool AllocateStaging(uint64_t size, uint64_t alignment, uint64_t& outOffset);
+
+private:
+	struct Request
+	{
+		UploadTicket ticket = 0;
+		std::vector<Chunk> chunks;
+		size_t nextChunk = 0;
+		std::shared_ptr<const void> keepAlive;
+	};
+
+	struct Submission
+	{
+		uint64_t fenceValue = 0;
+		uint64_t stagingEnd = 0;    // Ring head after the submission
+		uint64_t stagingBytes = 0;  // Padding included
+		std::vector<UploadTicket> tickets; // Finished by this submission
+	};
+
+	std::deque<Request> requests;
+
+	// Tickets whose last chunk was recorded since the last Submit
+	std::vector<UploadTicket> recordedTickets;
+	uint64_t recordedStagingBytes = 0;
+
+	std::deque<Submission> submissions;
+
+	UploadTicket nextTicket = 1;
+	UploadTicket completedTicket = 0;
+
+	// Ring, [tail, head) is in use
+	uint64_t stagingCapacity = 0;
+	uint64_t head = 0;
+	uint64_t tail = 0;
+
+	Stats stats;
+};
@@ -33,11 +33,17 @@ ShaderResourceView::ShaderResourceView(Device* InDevice, const D3D12_SHADER_RESO
 	:View(InDevice, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, InResource)
 {
 	CreateShaderResourceView(desc);
+
+	bindlessIndex = device->GetCommandContext()->GetDescriptorCache()->GetBindlessTable()->Register(heapSlot.handle);
 }
 
 ShaderResourceView::~ShaderResourceView()
 {
-
+	// Frames in flight may still index the slot
+	if (bindlessIndex != BindlessTable::InvalidIndex)
+	{
+		device->GetDeferredDeletionQueue()->Enqueue(device->GetCommandContext()->GetDescriptorCache()->GetBindlessTable(), bindlessIndex, nullptr, 0);
+	}
 }
 
 void ShaderResourceView::CreateShaderResourceView(const D3D12_SHADER_RESOURCE_VIEW_DESC& desc)
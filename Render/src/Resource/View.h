@@ -1,6 +1,7 @@
 #pragma once
 
 #include "HeapSlotAllocator.h"
+#include "BindlessTable.h"
 
 class Device;
 
@@ -28,8 +29,14 @@ public:
 	ShaderResourceView(Device* inDevice, const D3D12_SHADER_RESOURCE_VIEW_DESC& desc, ID3D12Resource* inResource);
 	virtual ~ShaderResourceView();
 
+	// Index of this view in the BindlessTable, valid as long as the view lives
+	uint32_t GetBindlessIndex() const { return bindlessIndex; }
+
 protected:
 	void CreateShaderResourceView(const D3D12_SHADER_RESOURCE_VIEW_DESC& desc);
+
+private:
+	uint32_t bindlessIndex = BindlessTable::InvalidIndex;
 };
 
 class RenderTargetView : public View
@@ -2,6 +2,7 @@
 
 #include "../Utils/D3D12Utils.h"
 #include "D3D12Texture.h"
+#include "FrameResourceRing.h"
 
 class D3D12RHI;
 
@@ -46,7 +47,8 @@ private:
 	int viewportWidth = 0;
 	int viewportHeight = 0;
 
-	static const int swapChainBufferCount = 2;
+	// One back buffer per frame in flight, Present never blocks on a buffer the GPU still renders to
+	static const int swapChainBufferCount = FRAME_RESOURCE_COUNT;
 	Microsoft::WRL::ComPtr<IDXGISwapChain> swapChain = nullptr;
 	int currBackBuffer = 0;
 	D3D12TextureRef renderTargetTextures[swapChainBufferCount];
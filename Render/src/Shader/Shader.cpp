@@ -1,5 +1,6 @@
 #include "Shader.h"
 #include "../File/FileHelpers.h"
+#include "../Resource/BindlessTable.h"
 #include <d3d12shader.h>
 
 void ShaderDefines::GetD3DShaderMacro(std::vector<D3D_SHADER_MACRO>& OutMacros) const
@@ -148,6 +149,11 @@ void Shader::GetShaderParameters(ComPtr<ID3DBlob> passBlob, EShaderType shaderTy
 
 			cbvParams.push_back(param);
 		}
+		else if ((resourceType == D3D_SHADER_INPUT_TYPE::D3D_SIT_STRUCTURED
+			|| resourceType == D3D_SHADER_INPUT_TYPE::D3D_SIT_TEXTURE) && registerSpace == BINDLESS_REGISTER_SPACE)
+		{
+			bUseBindlessTable = true;
+		}
 		else if (resourceType == D3D_SHADER_INPUT_TYPE::D3D_SIT_STRUCTURED
 			|| resourceType == D3D_SHADER_INPUT_TYPE::D3D_SIT_TEXTURE)
 		{
@@ -359,6 +365,19 @@ void Shader::CreateRootSignature()
 		}
 	}
 
+	// Bindless
+	if (bUseBindlessTable)
+	{
+		bindlessSignatureBindSlot = (UINT)slotRootParameter.size();
+
+		CD3DX12_DESCRIPTOR_RANGE bindlessTable;
+		bindlessTable.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, BINDLESS_TABLE_SIZE, 0, BINDLESS_REGISTER_SPACE);
+
+		CD3DX12_ROOT_PARAMETER rootParam;
+		rootParam.InitAsDescriptorTable(1, &bindlessTable, D3D12_SHADER_VISIBILITY_ALL);
+		slotRootParameter.push_back(rootParam);
+	}
+
 	// Sampler
 	// TODO
 	auto staticSamplers = CreateStaticSamplers();
@@ -535,6 +554,21 @@ void Shader::BindParameters()
 		}
 	}
 
+	// Bindless table, persistent so nothing is copied
+	if (bindlessSignatureBindSlot != -1)
+	{
+		auto gpuDescriptorHandle = descriptorCache->GetBindlessTable()->GetGPUHandle();
+
+		if (bComputeShader)
+		{
+			commandList->SetComputeRootDescriptorTable(bindlessSignatureBindSlot, gpuDescriptorHandle);
+		}
+		else
+		{
+			commandList->SetGraphicsRootDescriptorTable(bindlessSignatureBindSlot, gpuDescriptorHandle);
+		}
+	}
+
 	ClearBindings();
 }
 
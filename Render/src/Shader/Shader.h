@@ -133,6 +133,9 @@ public:
 	int uavSignatureBindSlot = -1;
 	UINT uavCount = 0;
 	int samplerSignatureBindSlot = -1;
+	// SRVs in BINDLESS_REGISTER_SPACE are not parameters, the whole BindlessTable is bound there
+	int bindlessSignatureBindSlot = -1;
+	bool bUseBindlessTable = false;
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> shaderPass;
 	ComPtr<ID3D12RootSignature> rootSignature;
 
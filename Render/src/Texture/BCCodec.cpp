@@ -0,0 +1,825 @@
+#include "BCCodec.h"
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	const uint32_t BlockPixelCount = 16;
+
+	// Interpolation weights of the 4 bit index modes, shared by BC6H and BC7
+	const int Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	class BlockBitWriter
+	{
+	public:
+		BlockBitWriter(uint8_t* InData, uint32_t size)
+			:data(InData)
+		{
+			memset(data, 0, size);
+		}
+
+		void Write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t i = 0; i < bitCount; i++, bitPos++)
+			{
+				if ((value >> i) & 1)
+				{
+					data[bitPos >> 3] |= 1 << (bitPos & 7);
+				}
+			}
+		}
+
+	private:
+		uint8_t* data;
+		uint32_t bitPos = 0;
+	};
+
+	class BlockBitReader
+	{
+	public:
+		BlockBitReader(const uint8_t* InData)
+			:data(InData)
+		{}
+
+		uint32_t Read(uint32_t bitCount)
+		{
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < bitCount; i++, bitPos++)
+			{
+				value |= ((data[bitPos >> 3] >> (bitPos & 7)) & 1) << i;
+			}
+			return value;
+		}
+
+	private:
+		const uint8_t* data;
+		uint32_t bitPos = 0;
+	};
+
+	int RoundClamp(float value, int maxValue)
+	{
+		return std::clamp((int)std::lround(value), 0, maxValue);
+	}
+
+	float GetChannel(FXMVECTOR v, uint32_t channel)
+	{
+		return XMVectorGetByIndex(v, channel);
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Endpoint fitting shared by every codec, only the channels in mask take part.
+	//------------------------------------------------------------------------------------------
+
+	// Endpoints at the extremes of the principal axis, Fast uses the bounding box
+	void FindEndpoints(const XMFLOAT4A* pixels, FXMVECTOR mask, EBCQuality quality, XMVECTOR& outE0, XMVECTOR& outE1)
+	{
+		XMVECTOR minValue = XMVectorReplicate(FLT_MAX);
+		XMVECTOR maxValue = XMVectorReplicate(-FLT_MAX);
+		XMVECTOR mean = XMVectorZero();
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			XMVECTOR p = XMVectorMultiply(XMLoadFloat4A(&pixels[i]), mask);
+			minValue = XMVectorMin(minValue, p);
+			maxValue = XMVectorMax(maxValue, p);
+			mean = XMVectorAdd(mean, p);
+		}
+		mean = XMVectorScale(mean, 1.0f / BlockPixelCount);
+
+		// Pick the bounding box diagonal that follows the data, channels that fall while the widest one rises are flipped
+		XMFLOAT4A range;
+		XMStoreFloat4A(&range, XMVectorSubtract(maxValue, minValue));
+		uint32_t widest = 0;
+		for (uint32_t c = 1; c < 4; c++)
+		{
+			widest = (&range.x)[c] > (&range.x)[widest] ? c : widest;
+		}
+
+		XMVECTOR covariance = XMVectorZero();
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			XMVECTOR d = XMVectorSubtract(XMVectorMultiply(XMLoadFloat4A(&pixels[i]), mask), mean);
+			covariance = XMVectorMultiplyAdd(d, XMVectorReplicate(GetChannel(d, widest)), covariance);
+		}
+
+		XMVECTOR bFlip = XMVectorLess(covariance, XMVectorZero());
+		outE0 = XMVectorSelect(minValue, maxValue, bFlip);
+		outE1 = XMVectorSelect(maxValue, minValue, bFlip);
+		if (quality == EBCQuality::Fast)
+		{
+			return;
+		}
+
+		// Power iteration on the covariance, Cov * a = sum(d * dot(d, a))
+		XMVECTOR axis = XMVectorSubtract(outE1, outE0);
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			XMVECTOR next = XMVectorZero();
+			for (uint32_t i = 0; i < BlockPixelCount; i++)
+			{
+				XMVECTOR d = XMVectorSubtract(XMVectorMultiply(XMLoadFloat4A(&pixels[i]), mask), mean);
+				next = XMVectorMultiplyAdd(d, XMVector4Dot(d, axis), next);
+			}
+
+			if (XMVectorGetX(XMVector4LengthSq(next)) < 1e-12f)
+			{
+				break;
+			}
+			axis = XMVector4Normalize(next);
+		}
+
+		if (XMVectorGetX(XMVector4LengthSq(axis)) < 1e-12f)
+		{
+			outE0 = outE1 = mean;
+			return;
+		}
+		axis = XMVector4Normalize(axis);
+
+		float minT = FLT_MAX;
+		float maxT = -FLT_MAX;
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			XMVECTOR d = XMVectorSubtract(XMVectorMultiply(XMLoadFloat4A(&pixels[i]), mask), mean);
+			float t = XMVectorGetX(XMVector4Dot(d, axis));
+			minT = (std::min)(minT, t);
+			maxT = (std::max)(maxT, t);
+		}
+
+		outE0 = XMVectorClamp(XMVectorMultiplyAdd(axis, XMVectorReplicate(minT), mean), minValue, maxValue);
+		outE1 = XMVectorClamp(XMVectorMultiplyAdd(axis, XMVectorReplicate(maxT), mean), minValue, maxValue);
+	}
+
+	// Nearest palette entry for every pixel, returns the summed squared error
+	float SelectIndices(const XMFLOAT4A* pixels, FXMVECTOR mask, const XMVECTOR* palette, uint32_t paletteSize, uint8_t* outIndices)
+	{
+		float totalError = 0.0f;
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			XMVECTOR p = XMLoadFloat4A(&pixels[i]);
+
+			float bestError = FLT_MAX;
+			for (uint32_t j = 0; j < paletteSize; j++)
+			{
+				XMVECTOR d = XMVectorMultiply(XMVectorSubtract(p, palette[j]), mask);
+				float error = XMVectorGetX(XMVector4LengthSq(d));
+				if (error < bestError)
+				{
+					bestError = error;
+					outIndices[i] = (uint8_t)j;
+				}
+			}
+			totalError += bestError;
+		}
+
+		return totalError;
+	}
+
+	// Least squares endpoints for fixed indices, weights[index] is the share of e1 in that palette entry
+	bool SolveEndpoints(const XMFLOAT4A* pixels, FXMVECTOR mask, const uint8_t* indices, const float* weights, XMVECTOR& outE0, XMVECTOR& outE1)
+	{
+		float a = 0.0f, b = 0.0f, c = 0.0f;
+		XMVECTOR x0 = XMVectorZero();
+		XMVECTOR x1 = XMVectorZero();
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			float t = weights[indices[i]];
+			float s = 1.0f - t;
+			a += s * s;
+			b += s * t;
+			c += t * t;
+
+			XMVECTOR p = XMVectorMultiply(XMLoadFloat4A(&pixels[i]), mask);
+			x0 = XMVectorMultiplyAdd(p, XMVectorReplicate(s), x0);
+			x1 = XMVectorMultiplyAdd(p, XMVectorReplicate(t), x1);
+		}
+
+		float det = a * c - b * b;
+		if (std::abs(det) < 1e-6f)
+		{
+			return false;
+		}
+
+		float invDet = 1.0f / det;
+		outE0 = XMVectorScale(XMVectorSubtract(XMVectorScale(x0, c), XMVectorScale(x1, b)), invDet);
+		outE1 = XMVectorScale(XMVectorSubtract(XMVectorScale(x1, a), XMVectorScale(x0, b)), invDet);
+		return true;
+	}
+
+	int GetRefineCount(EBCQuality quality)
+	{
+		return quality == EBCQuality::Fast ? 0 : (quality == EBCQuality::Normal ? 1 : 4);
+	}
+
+	// Fit, then refine while the error keeps dropping.
+	// Evaluate(e0, e1, result) quantizes the endpoints, picks indices and returns the error.
+	template<typename ResultType, typename EvaluateFunc>
+	ResultType EncodeEndpoints(const XMFLOAT4A* pixels, FXMVECTOR mask, EBCQuality quality, const float* weights, EvaluateFunc evaluate)
+	{
+		XMVECTOR e0, e1;
+		FindEndpoints(pixels, mask, quality, e0, e1);
+
+		ResultType best;
+		float bestError = evaluate(e0, e1, best);
+
+		for (int iteration = 0; iteration < GetRefineCount(quality) && bestError > 0.0f; iteration++)
+		{
+			if (!SolveEndpoints(pixels, mask, best.indices, weights, e0, e1))
+			{
+				break;
+			}
+
+			ResultType result;
+			float error = evaluate(e0, e1, result);
+			if (error >= bestError)
+			{
+				break;
+			}
+			best = result;
+			bestError = error;
+		}
+
+		return best;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// BC1 color block, always written in 4 color mode
+	//------------------------------------------------------------------------------------------
+
+	const float BC1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	struct BC1Result
+	{
+		uint16_t color0 = 0;
+		uint16_t color1 = 0;
+		uint8_t indices[16] = {};
+	};
+
+	uint16_t PackRGB565(FXMVECTOR color)
+	{
+		int r = RoundClamp(XMVectorGetX(color) * 31.0f / 255.0f, 31);
+		int g = RoundClamp(XMVectorGetY(color) * 63.0f / 255.0f, 63);
+		int b = RoundClamp(XMVectorGetZ(color) * 31.0f / 255.0f, 31);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	void UnpackRGB565(uint16_t color, int outRGB[3])
+	{
+		int r = (color >> 11) & 31;
+		int g = (color >> 5) & 63;
+		int b = color & 31;
+		outRGB[0] = (r << 3) | (r >> 2);
+		outRGB[1] = (g << 2) | (g >> 4);
+		outRGB[2] = (b << 3) | (b >> 2);
+	}
+
+	// BC2/BC3 color blocks always use 4 colors
+	void GetBC1Palette(uint16_t color0, uint16_t color1, bool bForceFourColor, XMVECTOR outPalette[4])
+	{
+		int c0[3], c1[3];
+		UnpackRGB565(color0, c0);
+		UnpackRGB565(color1, c1);
+
+		outPalette[0] = XMVectorSet((float)c0[0], (float)c0[1], (float)c0[2], 255.0f);
+		outPalette[1] = XMVectorSet((float)c1[0], (float)c1[1], (float)c1[2], 255.0f);
+		if (color0 > color1 || bForceFourColor)
+		{
+			outPalette[2] = XMVectorSet((float)((2 * c0[0] + c1[0]) / 3), (float)((2 * c0[1] + c1[1]) / 3), (float)((2 * c0[2] + c1[2]) / 3), 255.0f);
+			outPalette[3] = XMVectorSet((float)((c0[0] + 2 * c1[0]) / 3), (float)((c0[1] + 2 * c1[1]) / 3), (float)((c0[2] + 2 * c1[2]) / 3), 255.0f);
+		}
+		else
+		{
+			outPalette[2] = XMVectorSet((float)((c0[0] + c1[0]) / 2), (float)((c0[1] + c1[1]) / 2), (float)((c0[2] + c1[2]) / 2), 255.0f);
+			outPalette[3] = XMVectorZero();
+		}
+	}
+
+	void EncodeBC1Color(const XMFLOAT4A* pixels, EBCQuality quality, uint8_t* outBlock)
+	{
+		const XMVECTOR mask = XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f);
+
+		BC1Result best = EncodeEndpoints<BC1Result>(pixels, mask, quality, BC1Weights, [&](FXMVECTOR e0, FXMVECTOR e1, BC1Result& result)
+			{
+				// 4 color mode needs color0 > color1, equal colors only use index 0
+				result.color0 = PackRGB565(e0);
+				result.color1 = PackRGB565(e1);
+				if (result.color0 < result.color1)
+				{
+					std::swap(result.color0, result.color1);
+				}
+
+				XMVECTOR palette[4];
+				GetBC1Palette(result.color0, result.color1, true, palette);
+				return SelectIndices(pixels, mask, palette, result.color0 == result.color1 ? 1 : 4, result.indices);
+			});
+
+		BlockBitWriter writer(outBlock, 8);
+		writer.Write(best.color0, 16);
+		writer.Write(best.color1, 16);
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			writer.Write(best.indices[i], 2);
+		}
+	}
+
+	void DecodeBC1Color(const uint8_t* block, bool bForceFourColor, XMFLOAT4A* outPixels)
+	{
+		BlockBitReader reader(block);
+		uint16_t color0 = (uint16_t)reader.Read(16);
+		uint16_t color1 = (uint16_t)reader.Read(16);
+
+		XMVECTOR palette[4];
+		GetBC1Palette(color0, color1, bForceFourColor, palette);
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			XMStoreFloat4A(&outPixels[i], palette[reader.Read(2)]);
+		}
+	}
+
+	//------------------------------------------------------------------------------------------
+	// BC4 single channel block, also the alpha of BC3 and both halves of BC5
+	//------------------------------------------------------------------------------------------
+
+	const float BC4Weights[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+
+	struct BC4Result
+	{
+		uint8_t value0 = 0;
+		uint8_t value1 = 0;
+		uint8_t indices[16] = {};
+	};
+
+	void GetBC4Palette(int value0, int value1, uint32_t channel, XMVECTOR outPalette[8])
+	{
+		int values[8] = { value0, value1 };
+		if (value0 > value1)
+		{
+			for (int i = 2; i < 8; i++)
+			{
+				values[i] = ((8 - i) * value0 + (i - 1) * value1) / 7;
+			}
+		}
+		else
+		{
+			for (int i = 2; i < 6; i++)
+			{
+				values[i] = ((6 - i) * value0 + (i - 1) * value1) / 5;
+			}
+			values[6] = 0;
+			values[7] = 255;
+		}
+
+		for (int i = 0; i < 8; i++)
+		{
+			outPalette[i] = XMVectorSetByIndex(XMVectorZero(), (float)values[i], channel);
+		}
+	}
+
+	void EncodeBC4Channel(const XMFLOAT4A* pixels, uint32_t channel, EBCQuality quality, uint8_t* outBlock)
+	{
+		const XMVECTOR mask = XMVectorSetByIndex(XMVectorZero(), 1.0f, channel);
+
+		BC4Result best = EncodeEndpoints<BC4Result>(pixels, mask, quality, BC4Weights, [&](FXMVECTOR e0, FXMVECTOR e1, BC4Result& result)
+			{
+				// 8 value mode needs value0 > value1
+				int value0 = RoundClamp(GetChannel(e0, channel), 255);
+				int value1 = RoundClamp(GetChannel(e1, channel), 255);
+				if (value0 < value1)
+				{
+					std::swap(value0, value1);
+				}
+				result.value0 = (uint8_t)value0;
+				result.value1 = (uint8_t)value1;
+
+				XMVECTOR palette[8];
+				GetBC4Palette(value0, value1, channel, palette);
+				return SelectIndices(pixels, mask, palette, value0 == value1 ? 1 : 8, result.indices);
+			});
+
+		BlockBitWriter writer(outBlock, 8);
+		writer.Write(best.value0, 8);
+		writer.Write(best.value1, 8);
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			writer.Write(best.indices[i], 3);
+		}
+	}
+
+	void DecodeBC4Channel(const uint8_t* block, uint32_t channel, XMFLOAT4A* outPixels)
+	{
+		BlockBitReader reader(block);
+		int value0 = (int)reader.Read(8);
+		int value1 = (int)reader.Read(8);
+
+		XMVECTOR palette[8];
+		GetBC4Palette(value0, value1, channel, palette);
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			float value = GetChannel(palette[reader.Read(3)], channel);
+			(&outPixels[i].x)[channel] = value;
+		}
+	}
+
+	//------------------------------------------------------------------------------------------
+	// BC7 mode 6: one subset, RGBA 7 bit endpoints with a p-bit each, 4 bit indices
+	//------------------------------------------------------------------------------------------
+
+	const uint32_t BC7Mode6 = 6;
+
+	struct BC7Result
+	{
+		uint8_t endpoints[2][4] = {};
+		uint8_t pbits[2] = {};
+		uint8_t indices[16] = {};
+	};
+
+	float GetWeights4Float(int index)
+	{
+		return Weights4[index] / 64.0f;
+	}
+
+	void QuantizeBC7Endpoint(FXMVECTOR endpoint, uint32_t pbit, uint8_t outEndpoint[4])
+	{
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			outEndpoint[c] = (uint8_t)RoundClamp((GetChannel(endpoint, c) - pbit) * 0.5f, 127);
+		}
+	}
+
+	// Squared error of an endpoint after quantizing with the given p-bit
+	float GetBC7EndpointError(FXMVECTOR endpoint, uint32_t pbit)
+	{
+		uint8_t quantized[4];
+		QuantizeBC7Endpoint(endpoint, pbit, quantized);
+
+		float error = 0.0f;
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			float d = GetChannel(endpoint, c) - ((quantized[c] << 1) | pbit);
+			error += d * d;
+		}
+		return error;
+	}
+
+	void GetBC7Palette(const uint8_t endpoints[2][4], const uint8_t pbits[2], XMVECTOR outPalette[16])
+	{
+		int e0[4], e1[4];
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			e0[c] = (endpoints[0][c] << 1) | pbits[0];
+			e1[c] = (endpoints[1][c] << 1) | pbits[1];
+		}
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			int w = Weights4[i];
+			outPalette[i] = XMVectorSet(
+				(float)(((64 - w) * e0[0] + w * e1[0] + 32) >> 6),
+				(float)(((64 - w) * e0[1] + w * e1[1] + 32) >> 6),
+				(float)(((64 - w) * e0[2] + w * e1[2] + 32) >> 6),
+				(float)(((64 - w) * e0[3] + w * e1[3] + 32) >> 6));
+		}
+	}
+
+	void EncodeBC7Block(const XMFLOAT4A* pixels, EBCQuality quality, uint8_t* outBlock)
+	{
+		const XMVECTOR mask = XMVectorReplicate(1.0f);
+
+		float weights[16];
+		for (int i = 0; i < 16; i++)
+		{
+			weights[i] = GetWeights4Float(i);
+		}
+
+		BC7Result best = EncodeEndpoints<BC7Result>(pixels, mask, quality, weights, [&](FXMVECTOR e0, FXMVECTOR e1, BC7Result& result)
+			{
+				// High tries all four p-bit pairs, otherwise each endpoint takes the p-bit that quantizes it best
+				uint32_t pbitPairs[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } };
+				uint32_t pairCount = 4;
+				if (quality != EBCQuality::High)
+				{
+					pbitPairs[0][0] = GetBC7EndpointError(e0, 1) < GetBC7EndpointError(e0, 0) ? 1 : 0;
+					pbitPairs[0][1] = GetBC7EndpointError(e1, 1) < GetBC7EndpointError(e1, 0) ? 1 : 0;
+					pairCount = 1;
+				}
+
+				float bestError = FLT_MAX;
+				for (uint32_t pair = 0; pair < pairCount; pair++)
+				{
+					BC7Result candidate;
+					candidate.pbits[0] = (uint8_t)pbitPairs[pair][0];
+					candidate.pbits[1] = (uint8_t)pbitPairs[pair][1];
+					QuantizeBC7Endpoint(e0, candidate.pbits[0], candidate.endpoints[0]);
+					QuantizeBC7Endpoint(e1, candidate.pbits[1], candidate.endpoints[1]);
+
+					XMVECTOR palette[16];
+					GetBC7Palette(candidate.endpoints, candidate.pbits, palette);
+					float error = SelectIndices(pixels, mask, palette, 16, candidate.indices);
+					if (error < bestError)
+					{
+						bestError = error;
+						result = candidate;
+					}
+				}
+
+				return bestError;
+			});
+
+		// The anchor index drops its top bit, swap the endpoints if it is set
+		if (best.indices[0] >= 8)
+		{
+			std::swap(best.endpoints[0], best.endpoints[1]);
+			std::swap(best.pbits[0], best.pbits[1]);
+			for (uint32_t i = 0; i < BlockPixelCount; i++)
+			{
+				best.indices[i] = 15 - best.indices[i];
+			}
+		}
+
+		BlockBitWriter writer(outBlock, 16);
+		writer.Write(1 << BC7Mode6, BC7Mode6 + 1);
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			writer.Write(best.endpoints[0][c], 7);
+			writer.Write(best.endpoints[1][c], 7);
+		}
+		writer.Write(best.pbits[0], 1);
+		writer.Write(best.pbits[1], 1);
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			writer.Write(best.indices[i], i == 0 ? 3 : 4);
+		}
+	}
+
+	bool DecodeBC7Block(const uint8_t* block, XMFLOAT4A* outPixels)
+	{
+		BlockBitReader reader(block);
+		if (reader.Read(BC7Mode6 + 1) != (1u << BC7Mode6))
+		{
+			return false;
+		}
+
+		uint8_t endpoints[2][4];
+		uint8_t pbits[2];
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			endpoints[0][c] = (uint8_t)reader.Read(7);
+			endpoints[1][c] = (uint8_t)reader.Read(7);
+		}
+		pbits[0] = (uint8_t)reader.Read(1);
+		pbits[1] = (uint8_t)reader.Read(1);
+
+		XMVECTOR palette[16];
+		GetBC7Palette(endpoints, pbits, palette);
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			XMStoreFloat4A(&outPixels[i], palette[reader.Read(i == 0 ? 3 : 4)]);
+		}
+		return true;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// BC6H mode 11 (unsigned): one region, 10 bit RGB endpoints, 4 bit indices.
+	// The hardware interpolates the unquantized endpoints and then scales by 31/64 to get half
+	// bits, so the encoder works on half bits * 64/31, which is close to logarithmic.
+	//------------------------------------------------------------------------------------------
+
+	const uint32_t BC6HMode11 = 0x03;
+	const uint32_t BC6HEndpointBits = 10;
+
+	struct BC6HResult
+	{
+		uint16_t endpoints[2][3] = {};
+		uint8_t indices[16] = {};
+	};
+
+	float ToBC6HDomain(float value)
+	{
+		// Largest finite half, negative and NaN values map to zero
+		HALF half = XMConvertFloatToHalf(value > 0.0f ? (std::min)(value, 65504.0f) : 0.0f);
+		return half * 64.0f / 31.0f;
+	}
+
+	int UnquantizeBC6H(int value)
+	{
+		const int maxValue = (1 << BC6HEndpointBits) - 1;
+		if (value == 0)
+		{
+			return 0;
+		}
+		if (value == maxValue)
+		{
+			return 0xFFFF;
+		}
+		return ((value << 16) + 0x8000) >> BC6HEndpointBits;
+	}
+
+	void GetBC6HPalette(const uint16_t endpoints[2][3], int outPalette[16][3])
+	{
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			int e0 = UnquantizeBC6H(endpoints[0][c]);
+			int e1 = UnquantizeBC6H(endpoints[1][c]);
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				int w = Weights4[i];
+				outPalette[i][c] = ((64 - w) * e0 + w * e1 + 32) >> 6;
+			}
+		}
+	}
+
+	void EncodeBC6HBlock(const XMFLOAT4A* pixels, EBCQuality quality, uint8_t* outBlock)
+	{
+		const XMVECTOR mask = XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f);
+
+		XMFLOAT4A domainPixels[16];
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			domainPixels[i] = XMFLOAT4A(ToBC6HDomain(pixels[i].x), ToBC6HDomain(pixels[i].y), ToBC6HDomain(pixels[i].z), 0.0f);
+		}
+
+		float weights[16];
+		for (int i = 0; i < 16; i++)
+		{
+			weights[i] = GetWeights4Float(i);
+		}
+
+		BC6HResult best = EncodeEndpoints<BC6HResult>(domainPixels, mask, quality, weights, [&](FXMVECTOR e0, FXMVECTOR e1, BC6HResult& result)
+			{
+				// Inverse of UnquantizeBC6H away from the ends of the range
+				const int maxValue = (1 << BC6HEndpointBits) - 1;
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					result.endpoints[0][c] = (uint16_t)RoundClamp((GetChannel(e0, c) - 32.0f) / 64.0f, maxValue);
+					result.endpoints[1][c] = (uint16_t)RoundClamp((GetChannel(e1, c) - 32.0f) / 64.0f, maxValue);
+				}
+
+				int paletteValues[16][3];
+				GetBC6HPalette(result.endpoints, paletteValues);
+
+				XMVECTOR palette[16];
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					palette[i] = XMVectorSet((float)paletteValues[i][0], (float)paletteValues[i][1], (float)paletteValues[i][2], 0.0f);
+				}
+				return SelectIndices(domainPixels, mask, palette, 16, result.indices);
+			});
+
+		if (best.indices[0] >= 8)
+		{
+			std::swap(best.endpoints[0], best.endpoints[1]);
+			for (uint32_t i = 0; i < BlockPixelCount; i++)
+			{
+				best.indices[i] = 15 - best.indices[i];
+			}
+		}
+
+		BlockBitWriter writer(outBlock, 16);
+		writer.Write(BC6HMode11, 5);
+		for (uint32_t endpoint = 0; endpoint < 2; endpoint++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				writer.Write(best.endpoints[endpoint][c], BC6HEndpointBits);
+			}
+		}
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			writer.Write(best.indices[i], i == 0 ? 3 : 4);
+		}
+	}
+
+	bool DecodeBC6HBlock(const uint8_t* block, XMFLOAT4A* outPixels)
+	{
+		BlockBitReader reader(block);
+		if (reader.Read(5) != BC6HMode11)
+		{
+			return false;
+		}
+
+		uint16_t endpoints[2][3];
+		for (uint32_t endpoint = 0; endpoint < 2; endpoint++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				endpoints[endpoint][c] = (uint16_t)reader.Read(BC6HEndpointBits);
+			}
+		}
+
+		int palette[16][3];
+		GetBC6HPalette(endpoints, palette);
+		for (uint32_t i = 0; i < BlockPixelCount; i++)
+		{
+			const int* value = palette[reader.Read(i == 0 ? 3 : 4)];
+
+			// Finish unquantize, the result is the bit pattern of a half
+			outPixels[i] = XMFLOAT4A(
+				XMConvertHalfToFloat((HALF)((value[0] * 31) >> 6)),
+				XMConvertHalfToFloat((HALF)((value[1] * 31) >> 6)),
+				XMConvertHalfToFloat((HALF)((value[2] * 31) >> 6)),
+				1.0f);
+		}
+		return true;
+	}
+}
+
+bool BCCodec::IsSupported(DXGI_FORMAT format)
+{
+	return GetBlockSize(format) > 0;
+}
+
+bool BCCodec::IsFloatFormat(DXGI_FORMAT format)
+{
+	return format == DXGI_FORMAT_BC6H_UF16;
+}
+
+uint32_t BCCodec::GetBlockSize(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_UNORM:
+		return 8;
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+void BCCodec::EncodeBlock(DXGI_FORMAT format, const XMFLOAT4A* pixels, EBCQuality quality, uint8_t* outBlock)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+		EncodeBC1Color(pixels, quality, outBlock);
+		break;
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+		EncodeBC4Channel(pixels, 3, quality, outBlock);
+		EncodeBC1Color(pixels, quality, outBlock + 8);
+		break;
+	case DXGI_FORMAT_BC4_UNORM:
+		EncodeBC4Channel(pixels, 0, quality, outBlock);
+		break;
+	case DXGI_FORMAT_BC5_UNORM:
+		EncodeBC4Channel(pixels, 0, quality, outBlock);
+		EncodeBC4Channel(pixels, 1, quality, outBlock + 8);
+		break;
+	case DXGI_FORMAT_BC6H_UF16:
+		EncodeBC6HBlock(pixels, quality, outBlock);
+		break;
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		EncodeBC7Block(pixels, quality, outBlock);
+		break;
+	default:
+		break;
+	}
+}
+
+bool BCCodec::DecodeBlock(DXGI_FORMAT format, const uint8_t* block, XMFLOAT4A* outPixels)
+{
+	for (uint32_t i = 0; i < BlockPixelCount; i++)
+	{
+		outPixels[i] = XMFLOAT4A(0.0f, 0.0f, 0.0f, 255.0f);
+	}
+
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+		DecodeBC1Color(block, false, outPixels);
+		return true;
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+		DecodeBC1Color(block + 8, true, outPixels);
+		DecodeBC4Channel(block, 3, outPixels);
+		return true;
+	case DXGI_FORMAT_BC4_UNORM:
+		DecodeBC4Channel(block, 0, outPixels);
+		return true;
+	case DXGI_FORMAT_BC5_UNORM:
+		DecodeBC4Channel(block, 0, outPixels);
+		DecodeBC4Channel(block + 8, 1, outPixels);
+		return true;
+	case DXGI_FORMAT_BC6H_UF16:
+		return DecodeBC6HBlock(block, outPixels);
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return DecodeBC7Block(block, outPixels);
+	default:
+		return false;
+	}
+}
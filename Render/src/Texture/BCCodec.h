@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <DirectXMath.h>
+#include <dxgiformat.h>
+
+enum class EBCQuality
+{
+	Fast,   // bounding box endpoints
+	Normal, // principal axis endpoints refined by one least squares pass
+	High,   // more least squares passes, BC7 also tries every p-bit pair
+};
+
+// Single 4x4 block encoders and decoders, pixels are in row order.
+// BC1/BC3/BC4/BC5/BC7 work on values in [0, 255], BC6H on linear float RGB.
+// BC4 reads the red channel, BC5 red and green.
+// The encoders write BC7 mode 6 and BC6H mode 11 only, the decoders handle what the encoders write.
+class BCCodec
+{
+public:
+	static bool IsSupported(DXGI_FORMAT format);
+
+	static bool IsFloatFormat(DXGI_FORMAT format);
+
+	static uint32_t GetBlockSize(DXGI_FORMAT format);
+
+	static void EncodeBlock(DXGI_FORMAT format, const DirectX::XMFLOAT4A* pixels, EBCQuality quality, uint8_t* outBlock);
+
+	// Returns false for block modes the encoder never writes
+	static bool DecodeBlock(DXGI_FORMAT format, const uint8_t* block, DirectX::XMFLOAT4A* outPixels);
+};
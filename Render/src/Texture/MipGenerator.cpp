@@ -0,0 +1,509 @@
+#include "MipGenerator.h"
+#include "../Utility/JobSystem.h"
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	enum class EChannelType
+	{
+		UNorm8,
+		UNorm16,
+		Half,
+		Float,
+		SharedExp, // R9G9B9E5, one 32 bit word for all three channels
+	};
+
+	struct PixelLayout
+	{
+		EChannelType channelType;
+		uint32_t channelCount;
+		bool bHasAlpha;
+		bool bSRGB;
+
+		uint32_t GetPixelSize() const
+		{
+			if (channelType == EChannelType::SharedExp)
+			{
+				return 4;
+			}
+
+			uint32_t channelSize = channelType == EChannelType::UNorm8 ? 1 : (channelType == EChannelType::Float ? 4 : 2);
+			return channelSize * channelCount;
+		}
+	};
+
+	bool GetPixelLayout(DXGI_FORMAT format, PixelLayout& outLayout)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+			outLayout = { EChannelType::UNorm8, 4, true, false };
+			return true;
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			outLayout = { EChannelType::UNorm8, 4, true, true };
+			return true;
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+			outLayout = { EChannelType::UNorm8, 4, false, false };
+			return true;
+		case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+			outLayout = { EChannelType::UNorm8, 4, false, true };
+			return true;
+		case DXGI_FORMAT_R8G8_UNORM:
+			outLayout = { EChannelType::UNorm8, 2, false, false };
+			return true;
+		case DXGI_FORMAT_R8_UNORM:
+			outLayout = { EChannelType::UNorm8, 1, false, false };
+			return true;
+		case DXGI_FORMAT_R16G16B16A16_UNORM:
+			outLayout = { EChannelType::UNorm16, 4, true, false };
+			return true;
+		case DXGI_FORMAT_R16_UNORM:
+			outLayout = { EChannelType::UNorm16, 1, false, false };
+			return true;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+			outLayout = { EChannelType::Half, 4, true, false };
+			return true;
+		case DXGI_FORMAT_R16_FLOAT:
+			outLayout = { EChannelType::Half, 1, false, false };
+			return true;
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+			outLayout = { EChannelType::Float, 4, true, false };
+			return true;
+		case DXGI_FORMAT_R32G32B32_FLOAT:
+			outLayout = { EChannelType::Float, 3, false, false };
+			return true;
+		case DXGI_FORMAT_R32_FLOAT:
+			outLayout = { EChannelType::Float, 1, false, false };
+			return true;
+		case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+			outLayout = { EChannelType::SharedExp, 3, false, false };
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	XMVECTOR DecodePixel(const uint8_t* src, const PixelLayout& layout)
+	{
+		if (layout.channelType == EChannelType::SharedExp)
+		{
+			return XMVectorSetW(XMLoadFloat3SE(reinterpret_cast<const XMFLOAT3SE*>(src)), 1.0f);
+		}
+
+		XMFLOAT4A channels(0.0f, 0.0f, 0.0f, 1.0f);
+		float* dst = &channels.x;
+		for (uint32_t c = 0; c < layout.channelCount; c++)
+		{
+			switch (layout.channelType)
+			{
+			case EChannelType::UNorm8:
+				dst[c] = src[c] / 255.0f;
+				break;
+			case EChannelType::UNorm16:
+				dst[c] = reinterpret_cast<const uint16_t*>(src)[c] / 65535.0f;
+				break;
+			case EChannelType::Half:
+				dst[c] = XMConvertHalfToFloat(reinterpret_cast<const HALF*>(src)[c]);
+				break;
+			case EChannelType::Float:
+				dst[c] = reinterpret_cast<const float*>(src)[c];
+				break;
+			}
+		}
+
+		XMVECTOR value = XMLoadFloat4A(&channels);
+		return layout.bSRGB ? XMColorSRGBToRGB(value) : value;
+	}
+
+	void EncodePixel(FXMVECTOR value, uint8_t* dst, const PixelLayout& layout)
+	{
+		XMVECTOR encoded = layout.bSRGB ? XMColorRGBToSRGB(value) : value;
+
+		XMFLOAT4A channels;
+		switch (layout.channelType)
+		{
+		case EChannelType::UNorm8:
+			XMStoreFloat4A(&channels, XMVectorRound(XMVectorScale(XMVectorSaturate(encoded), 255.0f)));
+			for (uint32_t c = 0; c < layout.channelCount; c++)
+			{
+				dst[c] = static_cast<uint8_t>((&channels.x)[c]);
+			}
+			break;
+		case EChannelType::UNorm16:
+			XMStoreFloat4A(&channels, XMVectorRound(XMVectorScale(XMVectorSaturate(encoded), 65535.0f)));
+			for (uint32_t c = 0; c < layout.channelCount; c++)
+			{
+				reinterpret_cast<uint16_t*>(dst)[c] = static_cast<uint16_t>((&channels.x)[c]);
+			}
+			break;
+		case EChannelType::Half:
+		case EChannelType::Float:
+			// Color data is never negative, the Kaiser lobes can be
+			XMStoreFloat4A(&channels, XMVectorMax(encoded, XMVectorZero()));
+			for (uint32_t c = 0; c < layout.channelCount; c++)
+			{
+				if (layout.channelType == EChannelType::Half)
+				{
+					reinterpret_cast<HALF*>(dst)[c] = XMConvertFloatToHalf((&channels.x)[c]);
+				}
+				else
+				{
+					reinterpret_cast<float*>(dst)[c] = (&channels.x)[c];
+				}
+			}
+			break;
+		case EChannelType::SharedExp:
+			XMStoreFloat3SE(reinterpret_cast<XMFLOAT3SE*>(dst), XMVectorMax(encoded, XMVectorZero()));
+			break;
+		}
+	}
+
+	// Separable 1D kernel, output i reads source pixels [first[i], first[i] + count[i])
+	// with weights[i * maxTaps + k]. Taps outside the image are folded into the edge pixel.
+	struct FilterKernel
+	{
+		uint32_t maxTaps = 0;
+		std::vector<uint32_t> first;
+		std::vector<uint32_t> count;
+		std::vector<float> weights;
+	};
+
+	float BesselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		for (int k = 1; k < 32; k++)
+		{
+			float t = x / (2.0f * k);
+			term *= t * t;
+			sum += term;
+			if (term < sum * 1e-7f)
+			{
+				break;
+			}
+		}
+
+		return sum;
+	}
+
+	float Sinc(float x)
+	{
+		if (std::abs(x) < 1e-5f)
+		{
+			return 1.0f;
+		}
+
+		x *= XM_PI;
+		return std::sin(x) / x;
+	}
+
+	// x in destination pixels
+	float KaiserWeight(float x)
+	{
+		const float width = 3.0f;
+		const float alpha = 4.0f;
+
+		float t = x / width;
+		if (t * t >= 1.0f)
+		{
+			return 0.0f;
+		}
+
+		return Sinc(x) * BesselI0(alpha * std::sqrt(1.0f - t * t)) / BesselI0(alpha);
+	}
+
+	FilterKernel BuildKernel(uint32_t srcSize, uint32_t dstSize, EMipFilter filter)
+	{
+		const float ratio = (float)srcSize / dstSize;
+		const float radius = (filter == EMipFilter::Box ? 0.5f : 3.0f) * ratio; // in source pixels
+
+		FilterKernel kernel;
+		kernel.maxTaps = (uint32_t)std::ceil(radius * 2.0f) + 2;
+		kernel.first.resize(dstSize);
+		kernel.count.resize(dstSize);
+		kernel.weights.assign((size_t)dstSize * kernel.maxTaps, 0.0f);
+
+		for (uint32_t i = 0; i < dstSize; i++)
+		{
+			const float center = (i + 0.5f) * ratio;
+			const int start = (int)std::floor(center - radius);
+			const int end = (int)std::ceil(center + radius) - 1;
+			const int first = std::clamp(start, 0, (int)srcSize - 1);
+			const int last = std::clamp(end, 0, (int)srcSize - 1);
+
+			float* weights = &kernel.weights[(size_t)i * kernel.maxTaps];
+			float weightSum = 0.0f;
+			for (int j = start; j <= end; j++)
+			{
+				float weight;
+				if (filter == EMipFilter::Box)
+				{
+					// Overlap of source pixel [j, j + 1] with the footprint of the output pixel
+					weight = (std::max)(0.0f, (std::min)(j + 1.0f, center + radius) - (std::max)((float)j, center - radius));
+				}
+				else
+				{
+					weight = KaiserWeight((j + 0.5f - center) / ratio);
+				}
+
+				weights[std::clamp(j, 0, (int)srcSize - 1) - first] += weight;
+				weightSum += weight;
+			}
+
+			for (int k = 0; k <= last - first; k++)
+			{
+				weights[k] /= weightSum;
+			}
+
+			kernel.first[i] = first;
+			kernel.count[i] = last - first + 1;
+		}
+
+		return kernel;
+	}
+
+	// Splits [0, rowCount) into bands on the JobSystem, small levels stay on the calling thread
+	void ParallelForRows(uint32_t rowCount, uint32_t rowWidth, const std::function<void(uint32_t, uint32_t)>& func)
+	{
+		const uint32_t minPixelsPerBand = 64 * 1024;
+		JobSystem::Get().ParallelFor("Mip rows", rowCount, (std::max)(minPixelsPerBand / rowWidth, 1u), func);
+	}
+
+	// Horizontal pass into (dstWidth x srcHeight), then vertical pass into (dstWidth x dstHeight)
+	void Downsample(const std::vector<XMFLOAT4A>& src, uint32_t srcWidth, uint32_t srcHeight,
+		std::vector<XMFLOAT4A>& dst, uint32_t dstWidth, uint32_t dstHeight, EMipFilter filter)
+	{
+		const FilterKernel kernelX = BuildKernel(srcWidth, dstWidth, filter);
+		const FilterKernel kernelY = BuildKernel(srcHeight, dstHeight, filter);
+
+		std::vector<XMFLOAT4A> temp((size_t)dstWidth * srcHeight);
+		ParallelForRows(srcHeight, dstWidth, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t y = begin; y < end; y++)
+				{
+					const XMFLOAT4A* srcRow = &src[(size_t)y * srcWidth];
+					XMFLOAT4A* tempRow = &temp[(size_t)y * dstWidth];
+
+					for (uint32_t x = 0; x < dstWidth; x++)
+					{
+						const float* weights = &kernelX.weights[(size_t)x * kernelX.maxTaps];
+						const XMFLOAT4A* taps = srcRow + kernelX.first[x];
+
+						XMVECTOR sum = XMVectorZero();
+						for (uint32_t k = 0; k < kernelX.count[x]; k++)
+						{
+							sum = XMVectorMultiplyAdd(XMLoadFloat4A(&taps[k]), XMVectorReplicate(weights[k]), sum);
+						}
+						XMStoreFloat4A(&tempRow[x], sum);
+					}
+				}
+			});
+
+		dst.resize((size_t)dstWidth * dstHeight);
+		ParallelForRows(dstHeight, dstWidth, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t y = begin; y < end; y++)
+				{
+					const float* weights = &kernelY.weights[(size_t)y * kernelY.maxTaps];
+					XMFLOAT4A* dstRow = &dst[(size_t)y * dstWidth];
+
+					// Accumulate whole rows so that the reads stay linear
+					for (uint32_t x = 0; x < dstWidth; x++)
+					{
+						XMStoreFloat4A(&dstRow[x], XMVectorZero());
+					}
+
+					for (uint32_t k = 0; k < kernelY.count[y]; k++)
+					{
+						const XMFLOAT4A* tempRow = &temp[(size_t)(kernelY.first[y] + k) * dstWidth];
+						const XMVECTOR weight = XMVectorReplicate(weights[k]);
+
+						for (uint32_t x = 0; x < dstWidth; x++)
+						{
+							XMStoreFloat4A(&dstRow[x], XMVectorMultiplyAdd(XMLoadFloat4A(&tempRow[x]), weight, XMLoadFloat4A(&dstRow[x])));
+						}
+					}
+				}
+			});
+	}
+
+	float ComputeAlphaCoverage(const std::vector<XMFLOAT4A>& pixels, float alphaRef)
+	{
+		size_t coveredCount = 0;
+		for (const XMFLOAT4A& pixel : pixels)
+		{
+			if (pixel.w > alphaRef)
+			{
+				coveredCount++;
+			}
+		}
+
+		return (float)coveredCount / pixels.size();
+	}
+
+	// Castano, "Computing Alpha Mipmaps": search the reference that gives the wanted coverage,
+	// then scale alpha so that this reference maps to the real one.
+	float FindAlphaScale(const std::vector<XMFLOAT4A>& pixels, float alphaRef, float targetCoverage)
+	{
+		float low = 0.0f;
+		float high = 1.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			float mid = (low + high) * 0.5f;
+			if (ComputeAlphaCoverage(pixels, mid) > targetCoverage)
+			{
+				low = mid;
+			}
+			else
+			{
+				high = mid;
+			}
+		}
+
+		const float bestRef = (std::max)((low + high) * 0.5f, 1e-3f);
+		return alphaRef / bestRef;
+	}
+}
+
+bool MipGenerator::IsFormatSupported(DXGI_FORMAT format)
+{
+	PixelLayout layout;
+	return GetPixelLayout(format, layout);
+}
+
+uint32_t MipGenerator::GetMipCount(size_t width, size_t height)
+{
+	uint32_t mipCount = 1;
+	while (width > 1 || height > 1)
+	{
+		width = (std::max)(width / 2, (size_t)1);
+		height = (std::max)(height / 2, (size_t)1);
+		mipCount++;
+	}
+
+	return mipCount;
+}
+
+bool MipGenerator::GenerateMips(TextureInfo& textureInfo, std::vector<uint8_t>& textureData,
+	std::vector<D3D12_SUBRESOURCE_DATA>& initData, const MipGenerateSettings& settings, MipGenerateStats* outStats)
+{
+	PixelLayout layout;
+	if (textureInfo.dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D || textureInfo.arraySize != 1 || textureInfo.mipCount != 1
+		|| initData.size() != 1 || !GetPixelLayout(textureInfo.format, layout))
+	{
+		return false;
+	}
+
+	const uint32_t mipCount = GetMipCount(textureInfo.width, textureInfo.height);
+	if (mipCount == 1)
+	{
+		return false;
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	const uint32_t pixelSize = layout.GetPixelSize();
+
+	// Tightly packed chain
+	std::vector<size_t> mipOffsets(mipCount);
+	size_t totalSize = 0;
+	for (uint32_t mip = 0; mip < mipCount; mip++)
+	{
+		mipOffsets[mip] = totalSize;
+		totalSize += (std::max)(textureInfo.width >> mip, (size_t)1) * (std::max)(textureInfo.height >> mip, (size_t)1) * pixelSize;
+	}
+
+	std::vector<uint8_t> mipData(totalSize);
+
+	// Mip 0 is kept as is, the loaded rows may be padded
+	uint32_t srcWidth = (uint32_t)textureInfo.width;
+	uint32_t srcHeight = (uint32_t)textureInfo.height;
+	const uint8_t* loadedData = static_cast<const uint8_t*>(initData[0].pData);
+	for (uint32_t y = 0; y < srcHeight; y++)
+	{
+		memcpy(&mipData[(size_t)y * srcWidth * pixelSize], loadedData + y * initData[0].RowPitch, (size_t)srcWidth * pixelSize);
+	}
+
+	// Filtering works on linear float4 levels
+	std::vector<XMFLOAT4A> srcLevel((size_t)srcWidth * srcHeight);
+	std::vector<XMFLOAT4A> dstLevel;
+	ParallelForRows(srcHeight, srcWidth, [&](uint32_t begin, uint32_t end)
+		{
+			for (size_t i = (size_t)begin * srcWidth; i < (size_t)end * srcWidth; i++)
+			{
+				XMStoreFloat4A(&srcLevel[i], DecodePixel(&mipData[i * pixelSize], layout));
+			}
+		});
+
+	const bool bPreserveCoverage = layout.bHasAlpha && settings.alphaCoverageRef > 0.0f;
+	const float targetCoverage = bPreserveCoverage ? ComputeAlphaCoverage(srcLevel, settings.alphaCoverageRef) : 0.0f;
+
+	uint64_t generatedPixels = 0;
+	for (uint32_t mip = 1; mip < mipCount; mip++)
+	{
+		const uint32_t dstWidth = (std::max)(srcWidth / 2, 1u);
+		const uint32_t dstHeight = (std::max)(srcHeight / 2, 1u);
+
+		Downsample(srcLevel, srcWidth, srcHeight, dstLevel, dstWidth, dstHeight, settings.filter);
+
+		// The scaled alpha is only written out, the next level filters the unscaled one
+		const float alphaScale = bPreserveCoverage ? FindAlphaScale(dstLevel, settings.alphaCoverageRef, targetCoverage) : 1.0f;
+
+		uint8_t* dstData = &mipData[mipOffsets[mip]];
+		ParallelForRows(dstHeight, dstWidth, [&](uint32_t begin, uint32_t end)
+			{
+				for (size_t i = (size_t)begin * dstWidth; i < (size_t)end * dstWidth; i++)
+				{
+					XMVECTOR value = XMLoadFloat4A(&dstLevel[i]);
+					if (alphaScale != 1.0f)
+					{
+						value = XMVectorSetW(value, (std::min)(XMVectorGetW(value) * alphaScale, 1.0f));
+					}
+					EncodePixel(value, dstData + i * pixelSize, layout);
+				}
+			});
+
+		generatedPixels += (uint64_t)dstWidth * dstHeight;
+		srcLevel.swap(dstLevel);
+		srcWidth = dstWidth;
+		srcHeight = dstHeight;
+	}
+
+	textureData.swap(mipData);
+
+	initData.clear();
+	for (uint32_t mip = 0; mip < mipCount; mip++)
+	{
+		const size_t width = (std::max)(textureInfo.width >> mip, (size_t)1);
+		const size_t height = (std::max)(textureInfo.height >> mip, (size_t)1);
+
+		D3D12_SUBRESOURCE_DATA subResource;
+		subResource.pData = textureData.data() + mipOffsets[mip];
+		subResource.RowPitch = static_cast<LONG_PTR>(width * pixelSize);
+		subResource.SlicePitch = static_cast<LONG_PTR>(width * height * pixelSize);
+		initData.push_back(subResource);
+	}
+
+	textureInfo.mipCount = mipCount;
+
+	if (outStats)
+	{
+		auto endTime = std::chrono::high_resolution_clock::now();
+
+		outStats->mipCount = mipCount;
+		outStats->durationMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+		outStats->megaPixelsPerSecond = outStats->durationMs > 0.0 ? generatedPixels / (outStats->durationMs * 1000.0) : 0.0;
+	}
+
+	return true;
+}
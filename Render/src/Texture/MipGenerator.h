@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "TextureInfo.h"
+
+enum class EMipFilter
+{
+	Box,    // area average, also handles odd sizes
+	Kaiser, // Kaiser windowed sinc, sharper but can ring
+};
+
+struct MipGenerateSettings
+{
+	EMipFilter filter = EMipFilter::Box;
+
+	// Alpha test reference of a cutout texture, every mip keeps the coverage of mip 0 at this value.
+	// 0 disables coverage preservation.
+	float alphaCoverageRef = 0.0f;
+};
+
+struct MipGenerateStats
+{
+	uint32_t mipCount = 0;
+	double durationMs = 0.0;
+	double megaPixelsPerSecond = 0.0; // generated pixels, mip 0 excluded
+};
+
+// CPU mip chain generation for single-mip 2D textures (WIC and HDR loads).
+// Filtering runs in linear float, sRGB formats are decoded before and encoded after.
+// Every level is split into row bands on the JobSystem.
+class MipGenerator
+{
+public:
+	static bool IsFormatSupported(DXGI_FORMAT format);
+
+	static uint32_t GetMipCount(size_t width, size_t height);
+
+	// Replaces the single mip in textureData/initData by the full chain and updates textureInfo.mipCount.
+	// Returns false and leaves everything untouched if the texture is not supported.
+	static bool GenerateMips(TextureInfo& textureInfo, std::vector<uint8_t>& textureData,
+		std::vector<D3D12_SUBRESOURCE_DATA>& initData, const MipGenerateSettings& settings, MipGenerateStats* outStats = nullptr);
+};
@@ -2,22 +2,64 @@
 #include "../TextureLoader/DDSTextureLoader.h"
 #include "../TextureLoader/WICTextureLoader.h"
 #include "../TextureLoader/HDRTextureLoader.h"
-#include "../Utils/FormatConvert.h"
+#include "../Utils/Logger.h"
+#include <algorithm>
+#include <chrono>
 
-void Texture::LoadTextureResourceFromFlie(D3D12RHI* d3d12RHI)
+void Texture::LoadTextureResourceFromFlie()
 {
-	std::wstring ext = GetExtension(filePath);
-	if (ext == L"dds")
+	textureResource.initData.clear();
+
+	// An up to date bake replaces the source file
+	const std::wstring bakedPath = bBake ? TextureBaker::GetCachePath(filePath) : L"";
+	if (bBake && TextureBaker::IsCacheValid(filePath, bakedPath, bakeSettings, bSRGB))
 	{
-		LoadDDSTexture(d3d12RHI->GetDevice());
+		LoadDDSTexture(bakedPath);
 	}
-	else if (ext == L"png" || ext == L"jpg")
+	else
 	{
-		LoadWICTexture(d3d12RHI->GetDevice());
+		std::wstring ext = GetExtension(filePath);
+		if (ext == L"dds")
+		{
+			LoadDDSTexture(filePath);
+		}
+		else if (ext == L"png" || ext == L"jpg")
+		{
+			LoadWICTexture();
+		}
+		else if (ext == L"hdr")
+		{
+			LoadHDRTexture();
+		}
+
+		if (bGenerateMips && textureResource.textureInfo.mipCount == 1)
+		{
+			GenerateMips();
+		}
+
+		if (bBake)
+		{
+			BakeTexture(bakedPath);
+		}
 	}
-	else if (ext == L"hdr")
+
+	// Streaming reloads the same file from a job while the render thread reads these, so only fill them once
+	if (!mipSizes.empty())
+	{
+		return;
+	}
+
+	fullTextureInfo = textureResource.textureInfo;
+	fullTextureInfo.textureType = textureType;
+
+	const size_t mipCount = fullTextureInfo.mipCount;
+	if (mipCount > 0 && textureResource.initData.size() % mipCount == 0)
 	{
-		LoadHDRTexture(d3d12RHI->GetDevice());
+		mipSizes.assign(mipCount, 0);
+		for (size_t i = 0; i < textureResource.initData.size(); i++)
+		{
+			mipSizes[i % mipCount] += textureResource.initData[i].SlicePitch;
+		}
 	}
 }
 
@@ -29,13 +71,22 @@ std::wstring Texture::GetExtension(std::wstring path)
 		return L"";
 }
 
-void Texture::LoadDDSTexture(Device* device)
+void Texture::LoadDDSTexture(const std::wstring& path)
 {
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile(filePath.c_str(), textureResource.textureInfo,
-		textureResource.initData, textureResource.textureData, bSRGB));
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	ThrowIfFailed(DirectX::CreateDDSTextureFromFile(path.c_str(), textureResource.textureInfo,
+		textureResource.initData, textureResource.mappedFile, bSRGB));
+
+	double durationMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	char statsText[256];
+	sprintf_s(statsText, "DDSTextureLoader: %s %zu subresources, %.2f MB mapped in %.2f ms\n", name.c_str(),
+		textureResource.initData.size(), textureResource.mappedFile->GetSize() / (1024.0 * 1024.0), durationMs);
+	TLogger::LogToOutput(statsText);
 }
 
-void Texture::LoadWICTexture(Device* device)
+void Texture::LoadWICTexture()
 {
 	D3D12_SUBRESOURCE_DATA InitData;
 
@@ -55,15 +106,51 @@ void Texture::LoadWICTexture(Device* device)
 	textureResource.initData.push_back(InitData);
 }
 
-void Texture::LoadHDRTexture(Device* device)
+void Texture::LoadHDRTexture()
 {
 	D3D12_SUBRESOURCE_DATA InitData;
 
-	CreateHDRTextureFromFile(FormatConvert::WStrToStr(filePath), textureResource.textureInfo, InitData, textureResource.textureData);
+	if (!CreateHDRTextureFromFile(filePath, textureResource.textureInfo, InitData, textureResource.textureData, hdrSettings))
+	{
+		char errorText[256];
+		sprintf_s(errorText, "HDRTextureLoader: failed to load %s\n", name.c_str());
+		TLogger::LogToOutput(errorText);
+		return;
+	}
 
 	textureResource.initData.push_back(InitData);
 }
 
+void Texture::GenerateMips()
+{
+	MipGenerateStats stats;
+	if (!MipGenerator::GenerateMips(textureResource.textureInfo, textureResource.textureData, textureResource.initData, mipSettings, &stats))
+	{
+		return;
+	}
+
+	char statsText[256];
+	sprintf_s(statsText, "MipGenerator: %s %zux%zu, %u mips in %.2f ms, %.1f MP/s\n", name.c_str(),
+		textureResource.textureInfo.width, textureResource.textureInfo.height, stats.mipCount, stats.durationMs, stats.megaPixelsPerSecond);
+	TLogger::LogToOutput(statsText);
+}
+
+void Texture::BakeTexture(const std::wstring& bakedPath)
+{
+	TextureBakeStats stats;
+	if (!TextureBaker::Compress(textureResource.textureInfo, textureResource.textureData, textureResource.initData, bakeSettings, bSRGB, &stats))
+	{
+		return;
+	}
+
+	TextureBaker::SaveDDS(filePath, bakedPath, bakeSettings, bSRGB, textureResource.textureInfo, textureResource.textureData);
+
+	char statsText[256];
+	sprintf_s(statsText, "TextureBaker: %s to %s in %.2f ms, PSNR %.2f dB, %.2f MB -> %.2f MB\n", name.c_str(),
+		TextureBaker::GetFormatName(stats.format), stats.durationMs, stats.psnr, stats.sourceBytes / (1024.0 * 1024.0), stats.bakedBytes / (1024.0 * 1024.0));
+	TLogger::LogToOutput(statsText);
+}
+
 void Texture::SetTextureResourceDirectly(const TextureInfo& InTextureInfo, const std::vector<uint8_t>& InTextureData, const D3D12_SUBRESOURCE_DATA& InInitData)
 {
 	textureResource.textureInfo = InTextureInfo;
@@ -86,8 +173,121 @@ void Texture::CreateTexture(D3D12RHI* d3d12RHI)
 	TextureInfo.textureType = textureType;
 	d3dTexture = d3d12RHI->CreateTexture(TextureInfo, TexCreate_SRV);
 
-	//Upload InitData
-	d3d12RHI->UploadTextureData(d3dTexture, textureResource.initData);
+	//Upload InitData, the uploader owns the CPU data until it was copied to the staging ring
+	std::vector<D3D12_SUBRESOURCE_DATA> initData = textureResource.initData;
+	uploadTicket = d3d12RHI->UploadTextureDataAsync(d3dTexture, initData, DetachTextureResource());
+	residentMip = 0;
+}
+
+std::shared_ptr<const void> Texture::DetachTextureResource()
+{
+	// Moving keeps the buffers and the mapping, so initData stays valid
+	auto detached = std::make_shared<TextureResource>(std::move(textureResource));
+	textureResource = TextureResource();
+	textureResource.textureInfo = detached->textureInfo;
+
+	return detached;
+}
+
+TextureInfo Texture::GetMipTextureInfo(uint32_t firstMip) const
+{
+	TextureInfo info = fullTextureInfo;
+	info.width = (std::max)(fullTextureInfo.width >> firstMip, (size_t)1);
+	info.height = (std::max)(fullTextureInfo.height >> firstMip, (size_t)1);
+	info.mipCount = fullTextureInfo.mipCount - firstMip;
+
+	return info;
+}
+
+std::vector<D3D12_SUBRESOURCE_DATA> Texture::GetMipInitData(uint32_t firstMip) const
+{
+	const uint32_t fullMipCount = (uint32_t)fullTextureInfo.mipCount;
+	const uint32_t arraySize = (uint32_t)fullTextureInfo.arraySize;
+	assert(textureResource.initData.size() == (size_t)fullMipCount * arraySize);
+
+	std::vector<D3D12_SUBRESOURCE_DATA> initData;
+	for (uint32_t slice = 0; slice < arraySize; slice++)
+	{
+		for (uint32_t mip = firstMip; mip < fullMipCount; mip++)
+		{
+			initData.push_back(textureResource.initData[slice * fullMipCount + mip]);
+		}
+	}
+
+	return initData;
+}
+
+D3D12TextureRef Texture::CreateTextureFromMip(D3D12RHI* d3d12RHI, uint32_t firstMip)
+{
+	const uint32_t fullMipCount = (uint32_t)fullTextureInfo.mipCount;
+	const uint32_t arraySize = (uint32_t)fullTextureInfo.arraySize;
+	assert(textureType == ETextureType::TEXTURE_2D && firstMip < fullMipCount);
+
+	D3D12TextureRef oldTexture = d3dTexture;
+	D3D12TextureRef newTexture = d3d12RHI->CreateTexture(GetMipTextureInfo(firstMip), TexCreate_SRV);
+
+	if (oldTexture == nullptr || firstMip < residentMip)
+	{
+		// Gaining detail, everything comes from the CPU data
+		d3d12RHI->UploadTextureData(newTexture, GetMipInitData(firstMip));
+	}
+	else
+	{
+		// Dropping detail, the remaining mips are already on the GPU
+		const uint32_t oldMipCount = fullMipCount - residentMip;
+		const uint32_t newMipCount = fullMipCount - firstMip;
+
+		d3d12RHI->TransitionResource(oldTexture->GetResource(), D3D12_RESOURCE_STATE_COPY_SOURCE);
+		d3d12RHI->TransitionResource(newTexture->GetResource(), D3D12_RESOURCE_STATE_COPY_DEST);
+
+		for (uint32_t slice = 0; slice < arraySize; slice++)
+		{
+			for (uint32_t mip = firstMip; mip < fullMipCount; mip++)
+			{
+				CD3DX12_TEXTURE_COPY_LOCATION Src(oldTexture->GetD3DResource(), slice * oldMipCount + (mip - residentMip));
+				CD3DX12_TEXTURE_COPY_LOCATION Dst(newTexture->GetD3DResource(), slice * newMipCount + (mip - firstMip));
+				d3d12RHI->CopyTextureRegion(&Dst, 0, 0, 0, &Src, nullptr);
+			}
+		}
+
+		d3d12RHI->TransitionResource(oldTexture->GetResource(), D3D12_RESOURCE_STATE_COMMON);
+		d3d12RHI->TransitionResource(newTexture->GetResource(), D3D12_RESOURCE_STATE_COMMON);
+	}
+
+	d3dTexture = newTexture;
+	residentMip = firstMip;
+
+	return oldTexture;
+}
+
+D3D12TextureRef Texture::UploadTextureFromMipAsync(D3D12RHI* d3d12RHI, uint32_t firstMip, UploadTicket& outTicket)
+{
+	assert(textureType == ETextureType::TEXTURE_2D && firstMip < fullTextureInfo.mipCount);
+
+	D3D12TextureRef newTexture = d3d12RHI->CreateTexture(GetMipTextureInfo(firstMip), TexCreate_SRV);
+
+	std::vector<D3D12_SUBRESOURCE_DATA> initData = GetMipInitData(firstMip);
+	outTicket = d3d12RHI->UploadTextureDataAsync(newTexture, initData, DetachTextureResource());
+
+	return newTexture;
+}
+
+D3D12TextureRef Texture::CommitTextureFromMip(D3D12TextureRef newTexture, uint32_t firstMip)
+{
+	D3D12TextureRef oldTexture = d3dTexture;
+
+	d3dTexture = newTexture;
+	residentMip = firstMip;
+
+	return oldTexture;
+}
+
+void Texture::ReleaseTextureResource()
+{
+	textureResource.textureData.clear();
+	textureResource.textureData.shrink_to_fit();
+	textureResource.initData.clear();
+	textureResource.mappedFile = nullptr;
 }
 
 
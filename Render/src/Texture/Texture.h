@@ -2,14 +2,22 @@
 
 #include <string>
 #include "TextureInfo.h"
+#include "MipGenerator.h"
+#include "TextureBaker.h"
+#include "../TextureLoader/HDRTextureLoader.h"
+#include "../File/MappedFile.h"
 #include "../Resource/D3D12Texture.h"
 #include "../Resource/D3D12RHI.h"
+#include "../Utility/JobSystem.h"
 
 struct TextureResource
 {
 	TextureInfo textureInfo;
 	std::vector<uint8_t> textureData;
 	std::vector<D3D12_SUBRESOURCE_DATA> initData;
+
+	// DDS files are mapped, initData points into the mapping until mips or a bake replace it
+	std::shared_ptr<TMappedFile> mappedFile;
 };
 
 class Texture
@@ -27,18 +35,59 @@ public:
 	Texture& operator=(const Texture& Other) = delete;
 
 public:
-	void LoadTextureResourceFromFlie(D3D12RHI* d3d12RHI);
+	// CPU only, safe to call from a job
+	void LoadTextureResourceFromFlie();
 	void SetTextureResourceDirectly(const TextureInfo& InTextureInfo, const std::vector<uint8_t>& InTextureData,
 		const D3D12_SUBRESOURCE_DATA& InInitData);
+	// Uploads on the copy queue, see GetUploadTicket
 	void CreateTexture(D3D12RHI* d3d12RHI);
 	D3D12TextureRef GetD3DTexture() { return d3dTexture; }
+	UploadTicket GetUploadTicket() const { return uploadTicket; }
+
+	// WIC and HDR files hold a single mip, build the rest of the chain on load
+	void SetGenerateMips(const MipGenerateSettings& settings) { bGenerateMips = true; mipSettings = settings; }
+
+	// Block compress on load and keep the result in Resources\Cache\Textures, see TextureBaker
+	void SetBake(const TextureBakeSettings& settings) { bBake = true; bakeSettings = settings; }
+
+	// Streaming textures keep only part of the mip chain on the GPU, see TextureStreamer
+	void SetStreaming(bool bInStreaming) { bStreaming = bInStreaming; }
+	bool IsStreaming() const { return bStreaming; }
+	uint32_t GetMipCount() const { return (uint32_t)fullTextureInfo.mipCount; }
+	uint32_t GetResidentMip() const { return residentMip; }
+	size_t GetWidth() const { return fullTextureInfo.width; }
+
+	// Size of every mip over all array slices, valid after the texture was loaded once
+	const std::vector<uint64_t>& GetMipSizes() const { return mipSizes; }
+
+	// Replace the GPU texture by one that holds mips [firstMip, mipCount).
+	// New detail mips are uploaded from the loaded CPU data, dropped mips are copied from the old texture.
+	// Returns the old texture, it must stay alive until the GPU is done with the copy.
+	D3D12TextureRef CreateTextureFromMip(D3D12RHI* d3d12RHI, uint32_t firstMip);
+
+	// Gaining detail without a stall: the new texture is uploaded from the loaded CPU data on the copy queue and returned.
+	// It becomes the GPU texture with CommitTextureFromMip once outTicket completed.
+	D3D12TextureRef UploadTextureFromMipAsync(D3D12RHI* d3d12RHI, uint32_t firstMip, UploadTicket& outTicket);
+	// Returns the old texture
+	D3D12TextureRef CommitTextureFromMip(D3D12TextureRef newTexture, uint32_t firstMip);
+
+	// Free the CPU copy once it is on the GPU, also unmaps a DDS file
+	void ReleaseTextureResource();
 
 private:
 	static std::wstring GetExtension(std::wstring path);
 
-	void LoadDDSTexture(Device* device);
-	void LoadWICTexture(Device* device);
-	void LoadHDRTexture(Device* device);
+	TextureInfo GetMipTextureInfo(uint32_t firstMip) const;
+	std::vector<D3D12_SUBRESOURCE_DATA> GetMipInitData(uint32_t firstMip) const;
+
+	// Moves the CPU data out, the copy queue reads it after this returns
+	std::shared_ptr<const void> DetachTextureResource();
+
+	void LoadDDSTexture(const std::wstring& path);
+	void LoadWICTexture();
+	void LoadHDRTexture();
+	void GenerateMips();
+	void BakeTexture(const std::wstring& bakedPath);
 
 public:
 	std::string name;
@@ -47,6 +96,23 @@ public:
 	bool bSRGB = true;
 	TextureResource textureResource;
 	D3D12TextureRef d3dTexture = nullptr;
+	UploadTicket uploadTicket = 0;
+
+	HDRLoadSettings hdrSettings;
+
+	bool bGenerateMips = false;
+	MipGenerateSettings mipSettings;
+
+	bool bBake = false;
+	TextureBakeSettings bakeSettings;
+
+	bool bStreaming = false;
+	uint32_t residentMip = 0;
+	TextureInfo fullTextureInfo = {};
+	std::vector<uint64_t> mipSizes;
+
+	// Decode job scheduled by TextureRepository, CreateTexture waits for it
+	JobRef loadJob = nullptr;
 };
 
 class Texture2D : public Texture
@@ -0,0 +1,434 @@
+#include "TextureBaker.h"
+#include "../TextureLoader/DDS.h"
+#include "../File/BinarySaver.h"
+#include "../File/FileHelpers.h"
+#include "../Utility/Hash.h"
+#include "../Utility/JobSystem.h"
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cwctype>
+#include <filesystem>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	const uint32_t BakeKeySize = 8;
+
+	// Bytes per source pixel, 0 if the bake can not read the format
+	uint32_t GetSourcePixelSize(DXGI_FORMAT format, bool& bOutFloat)
+	{
+		bOutFloat = false;
+		switch (format)
+		{
+		case DXGI_FORMAT_R8_UNORM:
+			return 1;
+		case DXGI_FORMAT_R8G8_UNORM:
+		case DXGI_FORMAT_R16_UNORM:
+			return 2;
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+		case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+			return 4;
+		case DXGI_FORMAT_R16G16B16A16_UNORM:
+			return 8;
+		case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+			bOutFloat = true;
+			return 4;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+			bOutFloat = true;
+			return 8;
+		case DXGI_FORMAT_R32G32B32_FLOAT:
+			bOutFloat = true;
+			return 12;
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+			bOutFloat = true;
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	// Unorm formats are read in [0, 255], float formats as they are
+	XMFLOAT4A ReadSourcePixel(const uint8_t* src, DXGI_FORMAT format)
+	{
+		const uint16_t* src16 = reinterpret_cast<const uint16_t*>(src);
+		const float* src32 = reinterpret_cast<const float*>(src);
+
+		switch (format)
+		{
+		case DXGI_FORMAT_R8_UNORM:
+			return XMFLOAT4A(src[0], 0.0f, 0.0f, 255.0f);
+		case DXGI_FORMAT_R8G8_UNORM:
+			return XMFLOAT4A(src[0], src[1], 0.0f, 255.0f);
+		case DXGI_FORMAT_R16_UNORM:
+			return XMFLOAT4A(src16[0] / 257.0f, 0.0f, 0.0f, 255.0f);
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			return XMFLOAT4A(src[0], src[1], src[2], src[3]);
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			return XMFLOAT4A(src[2], src[1], src[0], src[3]);
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+		case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+			return XMFLOAT4A(src[2], src[1], src[0], 255.0f);
+		case DXGI_FORMAT_R16G16B16A16_UNORM:
+			return XMFLOAT4A(src16[0] / 257.0f, src16[1] / 257.0f, src16[2] / 257.0f, src16[3] / 257.0f);
+		case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+		{
+			XMFLOAT4A value;
+			XMStoreFloat4A(&value, XMVectorSetW(XMLoadFloat3SE(reinterpret_cast<const XMFLOAT3SE*>(src)), 1.0f));
+			return value;
+		}
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+			return XMFLOAT4A(XMConvertHalfToFloat(src16[0]), XMConvertHalfToFloat(src16[1]), XMConvertHalfToFloat(src16[2]), XMConvertHalfToFloat(src16[3]));
+		case DXGI_FORMAT_R32G32B32_FLOAT:
+			return XMFLOAT4A(src32[0], src32[1], src32[2], 1.0f);
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+			return XMFLOAT4A(src32[0], src32[1], src32[2], src32[3]);
+		default:
+			return XMFLOAT4A(0.0f, 0.0f, 0.0f, 0.0f);
+		}
+	}
+
+	// Blocks that hang over the edge of a small mip repeat the last row and column
+	void ReadSourceBlock(const D3D12_SUBRESOURCE_DATA& subResource, DXGI_FORMAT format, uint32_t pixelSize,
+		uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, XMFLOAT4A outPixels[16])
+	{
+		const uint8_t* data = static_cast<const uint8_t*>(subResource.pData);
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			uint32_t pixelY = (std::min)(blockY * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				uint32_t pixelX = (std::min)(blockX * 4 + x, width - 1);
+				outPixels[y * 4 + x] = ReadSourcePixel(data + pixelY * subResource.RowPitch + pixelX * pixelSize, format);
+			}
+		}
+	}
+
+	// Channels the format stores, only these count for the PSNR
+	uint32_t GetChannelCount(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC4_UNORM:
+			return 1;
+		case DXGI_FORMAT_BC5_UNORM:
+			return 2;
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC6H_UF16:
+			return 3;
+		default:
+			return 4;
+		}
+	}
+
+	// Same file, same string: "a/../B.png" and "b.png" name the same source on Windows
+	std::wstring NormalizeSourcePath(const std::wstring& sourcePath)
+	{
+		std::wstring normalized = std::filesystem::path(sourcePath).lexically_normal().make_preferred().wstring();
+		std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](wchar_t c) { return (wchar_t)std::towlower(c); });
+		return normalized;
+	}
+
+	DXGI_FORMAT MakeSRGB(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+			return DXGI_FORMAT_BC1_UNORM_SRGB;
+		case DXGI_FORMAT_BC3_UNORM:
+			return DXGI_FORMAT_BC3_UNORM_SRGB;
+		case DXGI_FORMAT_BC7_UNORM:
+			return DXGI_FORMAT_BC7_UNORM_SRGB;
+		default:
+			return format;
+		}
+	}
+}
+
+std::wstring TextureBaker::GetCachePath(const std::wstring& sourcePath)
+{
+	// The file name alone is not unique, two folders can both hold a "Normal.png"
+	const std::wstring normalizedPath = NormalizeSourcePath(sourcePath);
+	const uint64_t pathHash = xxh::xxhash_gethash(normalizedPath.data(), normalizedPath.size() * sizeof(wchar_t));
+
+	wchar_t hashText[17];
+	swprintf(hashText, 17, L"%016llx", (unsigned long long)pathHash);
+
+	return L"Resources\\Cache\\Textures\\" + std::filesystem::path(sourcePath).filename().wstring() + L"." + hashText + L".dds";
+}
+
+DXGI_FORMAT TextureBaker::GetBakeFormat(const TextureBakeSettings& settings, bool bSRGB)
+{
+	DXGI_FORMAT format = settings.format;
+	if (format == DXGI_FORMAT_UNKNOWN)
+	{
+		switch (settings.role)
+		{
+		case ETextureRole::BaseColor:
+			format = DXGI_FORMAT_BC7_UNORM;
+			break;
+		case ETextureRole::Normal:
+			format = DXGI_FORMAT_BC5_UNORM;
+			break;
+		case ETextureRole::Mask:
+			format = DXGI_FORMAT_BC4_UNORM;
+			break;
+		case ETextureRole::HDR:
+			format = DXGI_FORMAT_BC6H_UF16;
+			break;
+		}
+	}
+
+	return bSRGB ? MakeSRGB(format) : format;
+}
+
+const char* TextureBaker::GetFormatName(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM: return "BC1";
+	case DXGI_FORMAT_BC1_UNORM_SRGB: return "BC1_SRGB";
+	case DXGI_FORMAT_BC3_UNORM: return "BC3";
+	case DXGI_FORMAT_BC3_UNORM_SRGB: return "BC3_SRGB";
+	case DXGI_FORMAT_BC4_UNORM: return "BC4";
+	case DXGI_FORMAT_BC5_UNORM: return "BC5";
+	case DXGI_FORMAT_BC6H_UF16: return "BC6H";
+	case DXGI_FORMAT_BC7_UNORM: return "BC7";
+	case DXGI_FORMAT_BC7_UNORM_SRGB: return "BC7_SRGB";
+	default: return "Unknown";
+	}
+}
+
+bool TextureBaker::BuildBakeKey(const std::wstring& sourcePath, const TextureBakeSettings& settings, bool bSRGB, uint32_t outKey[8])
+{
+	std::error_code errorCode;
+	auto writeTime = std::filesystem::last_write_time(sourcePath, errorCode);
+	if (errorCode)
+	{
+		return false;
+	}
+
+	// Copies and version control checkouts can keep the write time of a changed file
+	const uint64_t sourceSize = static_cast<uint64_t>(std::filesystem::file_size(sourcePath, errorCode));
+	if (errorCode)
+	{
+		return false;
+	}
+
+	const uint64_t sourceWriteTime = static_cast<uint64_t>(writeTime.time_since_epoch().count());
+
+	outKey[0] = TEXTURE_BAKE_MAGIC;
+	outKey[1] = TEXTURE_BAKE_VERSION;
+	outKey[2] = static_cast<uint32_t>(sourceWriteTime);
+	outKey[3] = static_cast<uint32_t>(sourceWriteTime >> 32);
+	outKey[4] = static_cast<uint32_t>(GetBakeFormat(settings, bSRGB));
+	outKey[5] = static_cast<uint32_t>(settings.quality);
+	outKey[6] = static_cast<uint32_t>(sourceSize);
+	outKey[7] = static_cast<uint32_t>(sourceSize >> 32);
+
+	return true;
+}
+
+bool TextureBaker::IsCacheValid(const std::wstring& sourcePath, const std::wstring& cachePath, const TextureBakeSettings& settings, bool bSRGB)
+{
+	if (!TFileHelpers::IsFileExit(cachePath))
+	{
+		return false;
+	}
+
+	uint32_t expectedKey[BakeKeySize];
+	if (!BuildBakeKey(sourcePath, settings, bSRGB, expectedKey))
+	{
+		return false;
+	}
+
+	// Only the header is needed, the texture itself is read by CreateDDSTextureFromFile
+	FILE* fp = _wfopen(cachePath.c_str(), L"rb");
+	if (!fp)
+	{
+		return false;
+	}
+
+	uint32_t magic = 0;
+	DDS_HEADER header = {};
+	bool bRead = fread(&magic, sizeof(magic), 1, fp) == 1 && fread(&header, sizeof(header), 1, fp) == 1;
+	fclose(fp);
+
+	return bRead && magic == DDS_MAGIC && memcmp(header.reserved1, expectedKey, sizeof(expectedKey)) == 0;
+}
+
+bool TextureBaker::Compress(TextureInfo& textureInfo, std::vector<uint8_t>& textureData, std::vector<D3D12_SUBRESOURCE_DATA>& initData,
+	const TextureBakeSettings& settings, bool bSRGB, TextureBakeStats* outStats)
+{
+	const DXGI_FORMAT bakeFormat = GetBakeFormat(settings, bSRGB);
+
+	bool bFloatSource = false;
+	const uint32_t pixelSize = GetSourcePixelSize(textureInfo.format, bFloatSource);
+	if (pixelSize == 0 || bFloatSource != BCCodec::IsFloatFormat(bakeFormat) || !BCCodec::IsSupported(bakeFormat))
+	{
+		return false;
+	}
+
+	// D3D12 wants the top level of a BC texture to be made of whole blocks
+	if (textureInfo.dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D || textureInfo.arraySize != 1
+		|| initData.size() != textureInfo.mipCount || textureInfo.width % 4 != 0 || textureInfo.height % 4 != 0)
+	{
+		return false;
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	const uint32_t blockSize = BCCodec::GetBlockSize(bakeFormat);
+	const uint32_t mipCount = (uint32_t)textureInfo.mipCount;
+
+	std::vector<size_t> mipOffsets(mipCount);
+	size_t totalSize = 0;
+	for (uint32_t mip = 0; mip < mipCount; mip++)
+	{
+		size_t blocksX = ((std::max)(textureInfo.width >> mip, (size_t)1) + 3) / 4;
+		size_t blocksY = ((std::max)(textureInfo.height >> mip, (size_t)1) + 3) / 4;
+		mipOffsets[mip] = totalSize;
+		totalSize += blocksX * blocksY * blockSize;
+	}
+
+	std::vector<uint8_t> blockData(totalSize);
+
+	// Mip 0 is decoded again right after encoding, per block row so that the jobs never share a sum
+	const uint32_t channelCount = GetChannelCount(bakeFormat);
+	std::vector<double> rowErrors((textureInfo.height + 3) / 4, 0.0);
+	std::vector<float> rowPeaks((textureInfo.height + 3) / 4, 0.0f);
+
+	for (uint32_t mip = 0; mip < mipCount; mip++)
+	{
+		const uint32_t width = (uint32_t)(std::max)(textureInfo.width >> mip, (size_t)1);
+		const uint32_t height = (uint32_t)(std::max)(textureInfo.height >> mip, (size_t)1);
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+		uint8_t* mipBlocks = &blockData[mipOffsets[mip]];
+
+		JobSystem::Get().ParallelFor("Encode blocks", blocksY, (std::max)(256u / blocksX, 1u), [&](uint32_t begin, uint32_t end)
+			{
+				XMFLOAT4A pixels[16];
+				XMFLOAT4A decoded[16];
+				for (uint32_t blockY = begin; blockY < end; blockY++)
+				{
+					for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+					{
+						uint8_t* block = mipBlocks + ((size_t)blockY * blocksX + blockX) * blockSize;
+
+						ReadSourceBlock(initData[mip], textureInfo.format, pixelSize, width, height, blockX, blockY, pixels);
+						BCCodec::EncodeBlock(bakeFormat, pixels, settings.quality, block);
+
+						if (mip == 0 && BCCodec::DecodeBlock(bakeFormat, block, decoded))
+						{
+							for (uint32_t i = 0; i < 16; i++)
+							{
+								for (uint32_t c = 0; c < channelCount; c++)
+								{
+									float source = (&pixels[i].x)[c];
+									float d = (&decoded[i].x)[c] - source;
+									rowErrors[blockY] += d * d;
+									rowPeaks[blockY] = (std::max)(rowPeaks[blockY], source);
+								}
+							}
+						}
+					}
+				}
+			});
+	}
+
+	if (outStats)
+	{
+		double totalError = 0.0;
+		for (double error : rowErrors)
+		{
+			totalError += error;
+		}
+
+		// Unorm data peaks at 255, HDR data at its brightest texel
+		double peak = bFloatSource ? (std::max)(*std::max_element(rowPeaks.begin(), rowPeaks.end()), 1e-6f) : 255.0;
+		double mse = totalError / ((double)textureInfo.width * textureInfo.height * channelCount);
+
+		auto endTime = std::chrono::high_resolution_clock::now();
+
+		outStats->format = bakeFormat;
+		outStats->durationMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+		outStats->psnr = mse > 0.0 ? 10.0 * std::log10(peak * peak / mse) : 99.0;
+		outStats->sourceBytes = textureData.size();
+		outStats->bakedBytes = blockData.size();
+	}
+
+	textureData.swap(blockData);
+
+	initData.clear();
+	for (uint32_t mip = 0; mip < mipCount; mip++)
+	{
+		const size_t blocksX = ((std::max)(textureInfo.width >> mip, (size_t)1) + 3) / 4;
+		const size_t blocksY = ((std::max)(textureInfo.height >> mip, (size_t)1) + 3) / 4;
+
+		D3D12_SUBRESOURCE_DATA subResource;
+		subResource.pData = textureData.data() + mipOffsets[mip];
+		subResource.RowPitch = static_cast<LONG_PTR>(blocksX * blockSize);
+		subResource.SlicePitch = static_cast<LONG_PTR>(blocksX * blocksY * blockSize);
+		initData.push_back(subResource);
+	}
+
+	textureInfo.format = bakeFormat;
+
+	return true;
+}
+
+bool TextureBaker::SaveDDS(const std::wstring& sourcePath, const std::wstring& cachePath, const TextureBakeSettings& settings, bool bSRGB,
+	const TextureInfo& textureInfo, const std::vector<uint8_t>& textureData)
+{
+	DDS_HEADER header = {};
+	header.size = sizeof(DDS_HEADER);
+	header.flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_LINEARSIZE | (textureInfo.mipCount > 1 ? DDS_HEADER_FLAGS_MIPMAP : 0);
+	header.height = static_cast<uint32_t>(textureInfo.height);
+	header.width = static_cast<uint32_t>(textureInfo.width);
+	header.pitchOrLinearSize = static_cast<uint32_t>(((textureInfo.width + 3) / 4) * ((textureInfo.height + 3) / 4) * BCCodec::GetBlockSize(textureInfo.format));
+	header.mipMapCount = static_cast<uint32_t>(textureInfo.mipCount);
+	header.ddspf = DDSPF_DX10;
+	header.caps = DDS_SURFACE_FLAGS_TEXTURE | (textureInfo.mipCount > 1 ? DDS_SURFACE_FLAGS_MIPMAP : 0);
+
+	if (!BuildBakeKey(sourcePath, settings, bSRGB, header.reserved1))
+	{
+		return false;
+	}
+
+	DDS_HEADER_DXT10 headerDX10 = {};
+	headerDX10.dxgiFormat = textureInfo.format;
+	headerDX10.resourceDimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	headerDX10.arraySize = 1;
+
+	// Assemble the file in memory, then write it with a single call
+	std::vector<uint8_t> fileData(sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10) + textureData.size());
+	uint8_t* dst = fileData.data();
+	memcpy(dst, &DDS_MAGIC, sizeof(uint32_t));
+	dst += sizeof(uint32_t);
+	memcpy(dst, &header, sizeof(header));
+	dst += sizeof(header);
+	memcpy(dst, &headerDX10, sizeof(headerDX10));
+	dst += sizeof(headerDX10);
+	memcpy(dst, textureData.data(), textureData.size());
+
+	// TBinarySaver appends, so remove the stale file first
+	std::error_code errorCode;
+	std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), errorCode);
+	std::filesystem::remove(cachePath, errorCode);
+
+	TBinarySaver saver(cachePath);
+	return saver.SaveArray(fileData.data(), fileData.size());
+}
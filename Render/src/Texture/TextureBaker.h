@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "TextureInfo.h"
+#include "BCCodec.h"
+
+enum class ETextureRole
+{
+	BaseColor, // BC7
+	Normal,    // BC5, the base pass rebuilds Z
+	Mask,      // BC4, single channel data such as roughness or metallic
+	HDR,       // BC6H
+};
+
+struct TextureBakeSettings
+{
+	ETextureRole role = ETextureRole::BaseColor;
+	EBCQuality quality = EBCQuality::Normal;
+
+	// DXGI_FORMAT_UNKNOWN takes the format of the role
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+};
+
+struct TextureBakeStats
+{
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	double durationMs = 0.0;
+	double psnr = 0.0; // mip 0 decoded again and compared to the source, in dB
+	size_t sourceBytes = 0;
+	size_t bakedBytes = 0;
+};
+
+// Bake stage for textures loaded from WIC and HDR files.
+// Every mip is block compressed on the JobSystem and saved as a DDS that CreateDDSTextureFromFile loads
+// directly, the bake key (source write time and size, format, quality) lives in the reserved words of the DDS header.
+#define TEXTURE_BAKE_MAGIC 0x4B414254 // "TBAK"
+#define TEXTURE_BAKE_VERSION 2
+
+class TextureBaker
+{
+public:
+	// Baked file of a source texture, named after the file and a hash of its normalized path,
+	// e.g. "Resources\Textures\Gun_Normal.png" -> Resources\Cache\Textures\Gun_Normal.png.<hash>.dds
+	static std::wstring GetCachePath(const std::wstring& sourcePath);
+
+	static DXGI_FORMAT GetBakeFormat(const TextureBakeSettings& settings, bool bSRGB);
+
+	static const char* GetFormatName(DXGI_FORMAT format);
+
+	// Returns false if the DDS is missing, or was baked from another version of the source or with other settings.
+	static bool IsCacheValid(const std::wstring& sourcePath, const std::wstring& cachePath, const TextureBakeSettings& settings, bool bSRGB);
+
+	// Compresses every mip in place, textureInfo/textureData/initData describe the BC texture afterwards.
+	// Returns false and leaves everything untouched if the source format does not fit the bake format.
+	static bool Compress(TextureInfo& textureInfo, std::vector<uint8_t>& textureData, std::vector<D3D12_SUBRESOURCE_DATA>& initData,
+		const TextureBakeSettings& settings, bool bSRGB, TextureBakeStats* outStats = nullptr);
+
+	// textureData holds the mips back to back, as written by Compress
+	static bool SaveDDS(const std::wstring& sourcePath, const std::wstring& cachePath, const TextureBakeSettings& settings, bool bSRGB,
+		const TextureInfo& textureInfo, const std::vector<uint8_t>& textureData);
+
+private:
+	static bool BuildBakeKey(const std::wstring& sourcePath, const TextureBakeSettings& settings, bool bSRGB, uint32_t outKey[8]);
+};
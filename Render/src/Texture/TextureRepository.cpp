@@ -1,5 +1,9 @@
 #include "TextureRepository.h"
 #include "../File/FileHelpers.h"
+#include "../Utility/JobSystem.h"
+#include "../Utils/D3D12Utils.h"
+#include "../Utils/FormatConvert.h"
+#include "../Utils/Logger.h"
 
 TextureRepository& TextureRepository::Get()
 {
@@ -19,17 +23,78 @@ void TextureRepository::Load()
 	textureMap.emplace("Gun_Roughness", std::make_shared<Texture2D>("Gun_Roughness", false, TextureDir + L"Gun_Roughness.png"));
 	textureMap.emplace("Gun_Metallic", std::make_shared<Texture2D>("Gun_Metallic", false, TextureDir + L"Gun_Metallic.png"));
 
+	// Material textures are baked to BC formats and can be streamed, LUTs and noise must stay fully resident
+	const std::pair<const char*, ETextureRole> materialTextures[] = {
+		{ "Gun_BaseColor", ETextureRole::BaseColor },
+		{ "Gun_Normal", ETextureRole::Normal },
+		{ "Gun_Roughness", ETextureRole::Mask },
+		{ "Gun_Metallic", ETextureRole::Mask },
+	};
+	for (const auto& [name, role] : materialTextures)
+	{
+		TextureBakeSettings bakeSettings;
+		bakeSettings.role = role;
+
+		textureMap[name]->SetGenerateMips(MipGenerateSettings());
+		textureMap[name]->SetBake(bakeSettings);
+		textureMap[name]->SetStreaming(true);
+	}
+
 	// LUT
 	textureMap.emplace("IBL_BRDF_LUT", std::make_shared<Texture2D>("IBL_BRDF_LUT", false, TextureDir + L"IBL_BRDF_LUT.png"));
 	// HDR
 	//textureMap.emplace("bloem_hill", std::make_shared<Texture2D>("bloem_hill", false, TextureDir + L"bloem_hill_01_2k.hdr"));
 	textureMap.emplace("poolbeg_2k", std::make_shared<Texture2D>("poolbeg_2k", false, TextureDir + L"poolbeg_2k.hdr"));
+	MipGenerateSettings skyMipSettings;
+	skyMipSettings.filter = EMipFilter::Kaiser;
+	textureMap["poolbeg_2k"]->SetGenerateMips(skyMipSettings);
+	TextureBakeSettings skyBakeSettings;
+	skyBakeSettings.role = ETextureRole::HDR;
+	textureMap["poolbeg_2k"]->SetBake(skyBakeSettings);
 
 	// Blue Noise
 	textureMap.emplace("SRBN_RG", std::make_shared<Texture2D>("SRBN_RG", false, TextureDir + L"stbn_RG.dds"));
+
+	// Decode on the job system, the GPU upload happens in Render::CreateTextures
+	for (const auto& TexturePair : textureMap)
+	{
+		std::shared_ptr<Texture> texture = TexturePair.second;
+		texture->loadJob = JobSystem::Get().Schedule("Decode " + texture->name, [texture]()
+			{
+				texture->LoadTextureResourceFromFlie();
+			});
+	}
 }
 
 void TextureRepository::Unload()
 {
+	for (const auto& TexturePair : textureMap)
+	{
+		// A failed decode that nobody waited on yet must not throw out of shutdown
+		try
+		{
+			JobSystem::Get().Wait(TexturePair.second->loadJob);
+		}
+		catch (const std::exception& e)
+		{
+			char errorText[512];
+			sprintf_s(errorText, "TextureRepository: decode of %s failed, %s\n", TexturePair.first.c_str(), e.what());
+			TLogger::LogToOutput(errorText);
+		}
+		catch (const DxException& e)
+		{
+			// ThrowIfFailed, not a std::exception
+			char errorText[512];
+			sprintf_s(errorText, "TextureRepository: decode of %s failed, %s\n", TexturePair.first.c_str(), FormatConvert::WStrToStr(e.ToString()).c_str());
+			TLogger::LogToOutput(errorText);
+		}
+		catch (...)
+		{
+			char errorText[512];
+			sprintf_s(errorText, "TextureRepository: decode of %s failed\n", TexturePair.first.c_str());
+			TLogger::LogToOutput(errorText);
+		}
+	}
+
 	textureMap.clear();
 }
\ No newline at end of file
@@ -10,6 +10,7 @@ class TextureRepository
 public:
 	static TextureRepository& Get();
 
+	// Registers all textures and schedules their decode jobs
 	void Load();
 
 	void Unload();
@@ -0,0 +1,172 @@
+#include "TextureResidency.h"
+#include <algorithm>
+#include <cassert>
+
+TextureResidencyManager::TextureResidencyManager(uint64_t inBudgetBytes)
+	:budgetBytes(inBudgetBytes)
+{
+}
+
+uint32_t TextureResidencyManager::Register(const std::vector<uint64_t>& mipSizes, uint32_t tailMip)
+{
+	assert(!mipSizes.empty());
+
+	Entry entry;
+	entry.mipSizes = mipSizes;
+	entry.tailMip = std::min(tailMip, (uint32_t)mipSizes.size() - 1);
+	entry.residentMip = entry.tailMip;
+	entry.requestedMip = entry.tailMip;
+
+	entries.push_back(entry);
+
+	uint32_t handle = (uint32_t)entries.size() - 1;
+	residentBytes += GetMipChainSize(handle, entry.tailMip);
+
+	return handle;
+}
+
+uint64_t TextureResidencyManager::GetMipChainSize(uint32_t handle, uint32_t firstMip) const
+{
+	const Entry& entry = entries[handle];
+
+	uint64_t size = 0;
+	for (size_t mip = firstMip; mip < entry.mipSizes.size(); mip++)
+	{
+		size += entry.mipSizes[mip];
+	}
+
+	return size;
+}
+
+void TextureResidencyManager::RequestMip(uint32_t handle, uint32_t mip, uint64_t frame)
+{
+	Entry& entry = entries[handle];
+	mip = std::min(mip, entry.tailMip);
+
+	if (entry.requestFrame != frame)
+	{
+		entry.requestFrame = frame;
+		entry.lastUsedFrame = frame;
+		entry.requestedMip = mip;
+	}
+	else
+	{
+		entry.requestedMip = std::min(entry.requestedMip, mip);
+	}
+}
+
+void TextureResidencyManager::Update(uint64_t frame, std::vector<ResidencyChange>& outChanges)
+{
+	outChanges.clear();
+
+	// The budget may have been lowered
+	if (budgetBytes > 0 && residentBytes > budgetBytes)
+	{
+		MakeRoom(0, frame, UINT32_MAX, outChanges);
+	}
+
+	std::vector<uint32_t> candidates;
+	for (uint32_t handle = 0; handle < (uint32_t)entries.size(); handle++)
+	{
+		const Entry& entry = entries[handle];
+		if (entry.requestFrame == frame && !entry.bLoading && entry.requestedMip < entry.residentMip)
+		{
+			candidates.push_back(handle);
+		}
+	}
+
+	// Largest missing detail first
+	std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+		{
+			return entries[a].residentMip - entries[a].requestedMip > entries[b].residentMip - entries[b].requestedMip;
+		});
+
+	for (uint32_t handle : candidates)
+	{
+		Entry& entry = entries[handle];
+
+		// Fall back to a coarser mip if the requested one does not fit
+		for (uint32_t targetMip = entry.requestedMip; targetMip < entry.residentMip; targetMip++)
+		{
+			uint64_t extraBytes = GetMipChainSize(handle, targetMip) - GetMipChainSize(handle, entry.residentMip);
+
+			bool bFit = budgetBytes == 0 || residentBytes + extraBytes <= budgetBytes;
+			if (!bFit)
+			{
+				bFit = MakeRoom(extraBytes, frame, handle, outChanges);
+			}
+
+			if (bFit)
+			{
+				ResidencyChange change;
+				change.handle = handle;
+				change.fromMip = entry.residentMip;
+				change.toMip = targetMip;
+				outChanges.push_back(change);
+
+				residentBytes += extraBytes;
+				entry.residentMip = targetMip;
+				entry.bLoading = true;
+				break;
+			}
+		}
+	}
+}
+
+bool TextureResidencyManager::MakeRoom(uint64_t bytesNeeded, uint64_t frame, uint32_t excludeHandle, std::vector<ResidencyChange>& outChanges)
+{
+	std::vector<uint32_t> evictable;
+	uint64_t evictableBytes = 0;
+
+	for (uint32_t handle = 0; handle < (uint32_t)entries.size(); handle++)
+	{
+		const Entry& entry = entries[handle];
+		if (handle != excludeHandle && entry.requestFrame != frame && !entry.bLoading && entry.residentMip < entry.tailMip)
+		{
+			evictable.push_back(handle);
+			evictableBytes += GetMipChainSize(handle, entry.residentMip) - GetMipChainSize(handle, entry.tailMip);
+		}
+	}
+
+	// Check first so that a failed attempt does not evict anything
+	if (residentBytes + bytesNeeded > budgetBytes + evictableBytes)
+	{
+		return false;
+	}
+
+	std::sort(evictable.begin(), evictable.end(), [this](uint32_t a, uint32_t b)
+		{
+			return entries[a].lastUsedFrame < entries[b].lastUsedFrame;
+		});
+
+	for (uint32_t handle : evictable)
+	{
+		if (residentBytes + bytesNeeded <= budgetBytes)
+		{
+			break;
+		}
+
+		Entry& entry = entries[handle];
+
+		ResidencyChange change;
+		change.handle = handle;
+		change.fromMip = entry.residentMip;
+
+		// One mip at a time, so a texture keeps as much detail as the budget allows
+		while (entry.residentMip < entry.tailMip && residentBytes + bytesNeeded > budgetBytes)
+		{
+			residentBytes -= entry.mipSizes[entry.residentMip];
+			entry.residentMip++;
+		}
+
+		change.toMip = entry.residentMip;
+		outChanges.push_back(change);
+	}
+
+	return true;
+}
+
+void TextureResidencyManager::OnLoadFinished(uint32_t handle)
+{
+	entries[handle].bLoading = false;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Decides which mips of the streamed textures should be resident.
+// It only works on byte sizes, so it runs without a GPU (the budget can be any simulated value).
+class TextureResidencyManager
+{
+public:
+	struct ResidencyChange
+	{
+		uint32_t handle = 0;
+		uint32_t fromMip = 0; // most detailed resident mip before the change
+		uint32_t toMip = 0;   // most detailed resident mip after the change
+		bool IsLoad() const { return toMip < fromMip; }
+	};
+
+public:
+	TextureResidencyManager(uint64_t inBudgetBytes = 0);
+
+	// mipSizes[i] is the size of mip i over all array slices, tailMip is the first mip that always stays resident.
+	uint32_t Register(const std::vector<uint64_t>& mipSizes, uint32_t tailMip);
+
+	void SetBudget(uint64_t inBudgetBytes) { budgetBytes = inBudgetBytes; }
+	uint64_t GetBudget() const { return budgetBytes; }
+
+	// Ask for mip to be resident, the most detailed request of the frame wins.
+	void RequestMip(uint32_t handle, uint32_t mip, uint64_t frame);
+
+	// Compute the loads and evictions for this frame. Loads are committed right away,
+	// the caller must call OnLoadFinished once the data is on the GPU.
+	void Update(uint64_t frame, std::vector<ResidencyChange>& outChanges);
+
+	void OnLoadFinished(uint32_t handle);
+
+	uint32_t GetResidentMip(uint32_t handle) const { return entries[handle].residentMip; }
+	bool IsLoading(uint32_t handle) const { return entries[handle].bLoading; }
+	uint64_t GetResidentBytes() const { return residentBytes; }
+
+	uint64_t GetMipChainSize(uint32_t handle, uint32_t firstMip) const;
+
+private:
+	struct Entry
+	{
+		std::vector<uint64_t> mipSizes;
+		uint32_t tailMip = 0;
+		uint32_t residentMip = 0;
+		uint32_t requestedMip = 0;
+		uint64_t lastUsedFrame = 0;
+		uint64_t requestFrame = UINT64_MAX; // frame of requestedMip, never requested yet by default
+		bool bLoading = false;
+	};
+
+	// Drop least recently used mips until bytesNeeded fit, never touches textures used in this frame.
+	bool MakeRoom(uint64_t bytesNeeded, uint64_t frame, uint32_t excludeHandle, std::vector<ResidencyChange>& outChanges);
+
+private:
+	std::vector<Entry> entries;
+
+	uint64_t budgetBytes = 0;
+
+	// Includes the loads that are still in flight
+	uint64_t residentBytes = 0;
+};
@@ -0,0 +1,114 @@
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <cmath>
+
+TextureStreamer::TextureStreamer(D3D12RHI* inD3D12RHI, uint64_t budgetBytes)
+	:d3d12RHI(inD3D12RHI), residencyManager(budgetBytes)
+{
+}
+
+uint32_t TextureStreamer::GetTailMip(const Texture& texture)
+{
+	const TextureInfo& info = texture.fullTextureInfo;
+
+	uint32_t mip = 0;
+	while (mip + 1 < info.mipCount &&
+		((info.width >> mip) > TEXTURE_STREAMING_MIP_TAIL_SIZE || (info.height >> mip) > TEXTURE_STREAMING_MIP_TAIL_SIZE))
+	{
+		mip++;
+	}
+
+	return mip;
+}
+
+void TextureStreamer::AddTexture(const std::shared_ptr<Texture>& texture)
+{
+	assert(texture->textureType == ETextureType::TEXTURE_2D);
+	assert(!texture->GetMipSizes().empty());
+
+	uint32_t tailMip = GetTailMip(*texture);
+	uint32_t handle = residencyManager.Register(texture->GetMipSizes(), tailMip);
+
+	handleMap.emplace(texture->name, handle);
+
+	StreamingTexture streamingTexture;
+	streamingTexture.texture = texture;
+	streamingTextures.push_back(streamingTexture);
+
+	d3d12RHI->AddDelayDisposeResource(texture->CreateTextureFromMip(d3d12RHI, tailMip));
+	texture->ReleaseTextureResource();
+}
+
+void TextureStreamer::RequestScreenSize(const std::string& textureName, float screenSize, uint64_t frame)
+{
+	auto iter = handleMap.find(textureName);
+	if (iter == handleMap.end())
+	{
+		return;
+	}
+
+	const Texture& texture = *streamingTextures[iter->second].texture;
+
+	// One texel per pixel if the texture covers the surface once
+	uint32_t mip = 0;
+	if (screenSize > 1.0f && texture.GetWidth() > screenSize)
+	{
+		mip = (uint32_t)std::floor(std::log2((float)texture.GetWidth() / screenSize));
+	}
+	else if (screenSize <= 1.0f)
+	{
+		mip = texture.GetMipCount() - 1;
+	}
+
+	residencyManager.RequestMip(iter->second, mip, frame);
+}
+
+void TextureStreamer::Update(uint64_t frame)
+{
+	for (uint32_t handle = 0; handle < (uint32_t)streamingTextures.size(); handle++)
+	{
+		StreamingTexture& streamingTexture = streamingTextures[handle];
+		Texture* texture = streamingTexture.texture.get();
+
+		// Swap in the uploads the copy queue finished, the load stays in flight until then
+		if (streamingTexture.uploadingTexture && d3d12RHI->IsUploadComplete(streamingTexture.uploadTicket))
+		{
+			// Frames in flight may still sample the old texture
+			d3d12RHI->AddDelayDisposeResource(texture->CommitTextureFromMip(streamingTexture.uploadingTexture, residencyManager.GetResidentMip(handle)));
+			streamingTexture.uploadingTexture = nullptr;
+
+			residencyManager.OnLoadFinished(handle);
+		}
+
+		// Upload the mips loaded since the last frame
+		if (streamingTexture.loadJob == nullptr || !streamingTexture.loadJob->IsFinished())
+		{
+			continue;
+		}
+
+		JobSystem::Get().Wait(streamingTexture.loadJob);
+		streamingTexture.loadJob = nullptr;
+
+		streamingTexture.uploadingTexture = texture->UploadTextureFromMipAsync(d3d12RHI, residencyManager.GetResidentMip(handle), streamingTexture.uploadTicket);
+	}
+
+	residencyManager.Update(frame, changes);
+
+	for (const auto& change : changes)
+	{
+		StreamingTexture& streamingTexture = streamingTextures[change.handle];
+
+		if (change.IsLoad())
+		{
+			std::shared_ptr<Texture> texture = streamingTexture.texture;
+			streamingTexture.loadJob = JobSystem::Get().Schedule("Stream " + texture->name, [texture]()
+				{
+					texture->LoadTextureResourceFromFlie();
+				});
+		}
+		else if (change.toMip != change.fromMip)
+		{
+			d3d12RHI->AddDelayDisposeResource(streamingTexture.texture->CreateTextureFromMip(d3d12RHI, change.toMip));
+		}
+	}
+}
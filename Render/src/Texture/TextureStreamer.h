@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Texture.h"
+#include "TextureResidency.h"
+#include "../Utility/JobSystem.h"
+
+// Mips with both sides at most this size are never evicted
+#define TEXTURE_STREAMING_MIP_TAIL_SIZE 64
+
+// Keeps streaming textures within a VRAM budget.
+// Only the mip tail is created at startup, higher mips are loaded on the job system when
+// the projected screen size asks for them and least recently used mips are dropped when over budget.
+class TextureStreamer
+{
+public:
+	TextureStreamer(D3D12RHI* inD3D12RHI, uint64_t budgetBytes);
+
+	// The texture must have been loaded once, only its mip tail stays on the GPU
+	void AddTexture(const std::shared_ptr<Texture>& texture);
+
+	bool IsStreaming(const std::string& textureName) const { return handleMap.count(textureName) > 0; }
+
+	// screenSize is the projected size in pixels of the surface using the texture
+	void RequestScreenSize(const std::string& textureName, float screenSize, uint64_t frame);
+
+	// Swap in finished uploads, apply evictions and kick new loads.
+	// Loaded mips go through the copy queue, evictions are recorded into the current command list.
+	void Update(uint64_t frame);
+
+	void SetBudget(uint64_t budgetBytes) { residencyManager.SetBudget(budgetBytes); }
+
+	const TextureResidencyManager& GetResidencyManager() const { return residencyManager; }
+
+private:
+	struct StreamingTexture
+	{
+		std::shared_ptr<Texture> texture;
+		JobRef loadJob = nullptr;
+
+		// Copy queue upload of the loaded mips, replaces the GPU texture once the ticket completed
+		D3D12TextureRef uploadingTexture = nullptr;
+		UploadTicket uploadTicket = 0;
+	};
+
+	static uint32_t GetTailMip(const Texture& texture);
+
+private:
+	D3D12RHI* d3d12RHI = nullptr;
+
+	TextureResidencyManager residencyManager;
+
+	std::unordered_map<std::string, uint32_t> handleMap;
+
+	std::vector<StreamingTexture> streamingTextures;
+
+	std::vector<TextureResidencyManager::ResidencyChange> changes;
+};
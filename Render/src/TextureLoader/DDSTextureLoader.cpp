@@ -63,11 +63,70 @@ namespace
 
 };
 
+//--------------------------------------------------------------------------------------
+static HRESULT ParseDDSData(_In_reads_bytes_(ddsSize) const uint8_t* ddsData,
+	size_t ddsSize,
+	const DDS_HEADER** header,
+	const uint8_t** bitData,
+	size_t* bitSize
+)
+{
+	if (!header || !bitData || !bitSize)
+	{
+		return E_POINTER;
+	}
+
+	// Need at least enough data to fill the header and magic number to be a valid DDS
+	if (ddsSize < (sizeof(DDS_HEADER) + sizeof(uint32_t)))
+	{
+		return E_FAIL;
+	}
+
+	// DDS files always start with the same magic number ("DDS ")
+	uint32_t dwMagicNumber = *(const uint32_t*)(ddsData);
+	if (dwMagicNumber != DDS_MAGIC)
+	{
+		return E_FAIL;
+	}
+
+	auto hdr = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
+
+	// Verify header to validate DDS file
+	if (hdr->size != sizeof(DDS_HEADER) ||
+		hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
+	{
+		return E_FAIL;
+	}
+
+	// Check for DX10 extension
+	bool bDXT10Header = false;
+	if ((hdr->ddspf.flags & DDS_FOURCC) &&
+		(MAKEFOURCC('D', 'X', '1', '0') == hdr->ddspf.fourCC))
+	{
+		// Must be long enough for both headers and magic value
+		if (ddsSize < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
+		{
+			return E_FAIL;
+		}
+
+		bDXT10Header = true;
+	}
+
+	// setup the pointers in the process request
+	*header = hdr;
+	ptrdiff_t offset = sizeof(uint32_t) + sizeof(DDS_HEADER)
+		+ (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0);
+	*bitData = ddsData + offset;
+	*bitSize = ddsSize - offset;
+
+	return S_OK;
+}
+
 //--------------------------------------------------------------------------------------
 static HRESULT LoadTextureDataFromFile(_In_z_ const wchar_t* fileName,
 	std::vector<uint8_t>& ddsData,
-	DDS_HEADER** header,
-	uint8_t** bitData,
+	const DDS_HEADER** header,
+	const uint8_t** bitData,
 	size_t* bitSize
 )
 {
@@ -149,44 +208,7 @@ static HRESULT LoadTextureDataFromFile(_In_z_ const wchar_t* fileName,
 		return E_FAIL;
 	}
 
-	// DDS files always start with the same magic number ("DDS ")
-	uint32_t dwMagicNumber = *(const uint32_t*)(ddsData.data());
-	if (dwMagicNumber != DDS_MAGIC)
-	{
-		return E_FAIL;
-	}
-
-	auto hdr = reinterpret_cast<DDS_HEADER*>(ddsData.data() + sizeof(uint32_t));
-
-	// Verify header to validate DDS file
-	if (hdr->size != sizeof(DDS_HEADER) ||
-		hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
-	{
-		return E_FAIL;
-	}
-
-	// Check for DX10 extension
-	bool bDXT10Header = false;
-	if ((hdr->ddspf.flags & DDS_FOURCC) &&
-		(MAKEFOURCC('D', 'X', '1', '0') == hdr->ddspf.fourCC))
-	{
-		// Must be long enough for both headers and magic value
-		if (FileSize.LowPart < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
-		{
-			return E_FAIL;
-		}
-
-		bDXT10Header = true;
-	}
-
-	// setup the pointers in the process request
-	*header = hdr;
-	ptrdiff_t offset = sizeof(uint32_t) + sizeof(DDS_HEADER)
-		+ (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0);
-	*bitData = ddsData.data() + offset;
-	*bitSize = FileSize.LowPart - offset;
-
-	return S_OK;
+	return ParseDDSData(ddsData.data(), ddsData.size(), header, bitData, bitSize);
 }
 
 
@@ -1160,8 +1182,8 @@ HRESULT DirectX::CreateDDSTextureFromFile(
 		return E_INVALIDARG;
 	}
 
-	DDS_HEADER* header = nullptr;
-	uint8_t* bitData = nullptr;
+	const DDS_HEADER* header = nullptr;
+	const uint8_t* bitData = nullptr;
 	size_t bitSize = 0;
 
 	//std::unique_ptr<uint8_t[]> ddsData;
@@ -1181,3 +1203,54 @@ HRESULT DirectX::CreateDDSTextureFromFile(
 
 	return hr;
 }
+
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTextureFromFile(
+	const wchar_t* szFileName,
+	TextureInfo& textureInfo,
+	std::vector<D3D12_SUBRESOURCE_DATA>& initData,
+	std::shared_ptr<TMappedFile>& mappedFile,
+	bool forceSRGB,
+	size_t maxsize,
+	DDS_ALPHA_MODE* alphaMode)
+{
+	if (alphaMode)
+	{
+		*alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+	}
+
+	if (!szFileName)
+	{
+		return E_INVALIDARG;
+	}
+
+	std::shared_ptr<TMappedFile> file = TMappedFile::Open(szFileName);
+	if (!file)
+	{
+		return E_FAIL;
+	}
+
+	const DDS_HEADER* header = nullptr;
+	const uint8_t* bitData = nullptr;
+	size_t bitSize = 0;
+
+	HRESULT hr = ParseDDSData(file->GetData(), file->GetSize(), &header, &bitData, &bitSize);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	// initData points into the view, nothing is copied
+	hr = CreateTextureInitData(header, bitData, bitSize, maxsize, forceSRGB, textureInfo, initData);
+
+	if (SUCCEEDED(hr))
+	{
+		mappedFile = file;
+
+		if (alphaMode)
+			*alphaMode = GetAlphaMode(header);
+	}
+
+	return hr;
+}
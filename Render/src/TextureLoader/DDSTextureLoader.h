@@ -22,6 +22,7 @@
 #include <wrl.h>
 #include <d3d11_1.h>
 #include "../Texture/TextureInfo.h"
+#include "../File/MappedFile.h"
 
 #pragma warning(push)
 #pragma warning(disable : 4005)
@@ -61,4 +62,14 @@ namespace DirectX
 		_In_ size_t maxsize = 0,
 		_Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
 	);
+
+	// Same as above, but initData points into a mapping of the file that stays alive as long as mappedFile
+	HRESULT CreateDDSTextureFromFile(_In_z_ const wchar_t* szFileName,
+		_Out_ TextureInfo& textureInfo,
+		_Out_ std::vector<D3D12_SUBRESOURCE_DATA>& initData,
+		_Out_ std::shared_ptr<TMappedFile>& mappedFile,
+		_In_ bool forceSRGB,
+		_In_ size_t maxsize = 0,
+		_Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+	);
 }
\ No newline at end of file
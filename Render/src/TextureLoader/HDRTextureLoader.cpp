@@ -1,46 +1,295 @@
 #include "HDRTextureLoader.h"
+#include "../File/BinaryReader.h"
+#include <DirectXPackedVector.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	// Reads one '\n' terminated header line, returns false at the end of the data
+	bool ReadLine(const uint8_t*& pos, const uint8_t* end, std::string& outLine)
+	{
+		outLine.clear();
+		while (pos < end)
+		{
+			char c = static_cast<char>(*pos++);
+			if (c == '\n')
+				return true;
+
+			if (c != '\r')
+				outLine.push_back(c);
+		}
+
+		return false;
+	}
+
+	bool ReadHeader(const uint8_t*& pos, const uint8_t* end, uint32_t& outWidth, uint32_t& outHeight, bool& bOutTopDown)
+	{
+		std::string line;
+		if (!ReadLine(pos, end, line) || line.compare(0, 2, "#?") != 0)
+			return false;
+
+		// Variables end at an empty line
+		while (true)
+		{
+			if (!ReadLine(pos, end, line))
+				return false;
+
+			if (line.empty())
+				break;
+
+			if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe")
+				return false;
+		}
+
+		// Only the usual orientations, X always runs left to right
+		if (!ReadLine(pos, end, line))
+			return false;
+
+		char yAxis = 0;
+		int height = 0, width = 0;
+		if (sscanf_s(line.c_str(), "%cY %d +X %d", &yAxis, 1, &height, &width) != 3 || (yAxis != '-' && yAxis != '+')
+			|| width <= 0 || height <= 0 || width > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION || height > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+			return false;
+
+		outWidth = static_cast<uint32_t>(width);
+		outHeight = static_cast<uint32_t>(height);
+		bOutTopDown = yAxis == '-';
+
+		return true;
+	}
+
+	// Flat pixels, with the old run length scheme where (1, 1, 1, n) repeats the previous pixel
+	bool ReadFlatScanline(const uint8_t*& pos, const uint8_t* end, uint32_t width, uint8_t* outRGBE)
+	{
+		uint32_t shift = 0;
+		uint32_t x = 0;
+		while (x < width)
+		{
+			if (end - pos < 4)
+				return false;
+
+			if (pos[0] == 1 && pos[1] == 1 && pos[2] == 1)
+			{
+				// A fourth count in a row is past any width, and would shift by 32
+				if (x == 0 || shift > 16)
+					return false;
+
+				uint32_t count = static_cast<uint32_t>(pos[3]) << shift;
+				if (count > width - x)
+					return false;
+
+				for (uint32_t i = 0; i < count; i++, x++)
+				{
+					memcpy(outRGBE + x * 4, outRGBE + (x - 1) * 4, 4);
+				}
+				shift += 8;
+			}
+			else
+			{
+				memcpy(outRGBE + x * 4, pos, 4);
+				x++;
+				shift = 0;
+			}
+
+			pos += 4;
+		}
+
+		return true;
+	}
+
+	bool ReadScanline(const uint8_t*& pos, const uint8_t* end, uint32_t width, uint8_t* outRGBE)
+	{
+		// Run length encoded scanlines start with (2, 2, width), each channel is stored on its own
+		if (width < 8 || width > 0x7fff || end - pos < 4 || pos[0] != 2 || pos[1] != 2 || (pos[2] & 0x80))
+			return ReadFlatScanline(pos, end, width, outRGBE);
+
+		if (((static_cast<uint32_t>(pos[2]) << 8) | pos[3]) != width)
+			return false;
+
+		pos += 4;
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			uint32_t x = 0;
+			while (x < width)
+			{
+				if (pos >= end)
+					return false;
+
+				uint32_t count = *pos++;
+				if (count > 128)
+				{
+					// Run of one value
+					count -= 128;
+					if (count > width - x || pos >= end)
+						return false;
+
+					uint8_t value = *pos++;
+					for (uint32_t i = 0; i < count; i++, x++)
+					{
+						outRGBE[x * 4 + c] = value;
+					}
+				}
+				else
+				{
+					// Literal values
+					if (count == 0 || count > width - x || static_cast<size_t>(end - pos) < count)
+						return false;
+
+					for (uint32_t i = 0; i < count; i++, x++)
+					{
+						outRGBE[x * 4 + c] = *pos++;
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// Same scale as stbi_loadf, value = mantissa * 2^(exponent - 136)
+	void RGBEToFloat(const uint8_t* rgbe, uint32_t width, float* outRGBA)
+	{
+		for (uint32_t x = 0; x < width; x++, rgbe += 4, outRGBA += 4)
+		{
+			float scale = rgbe[3] ? std::ldexp(1.0f, static_cast<int>(rgbe[3]) - 136) : 0.0f;
+
+			XMVECTOR color = XMVectorMultiply(XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(rgbe)), XMVectorReplicate(scale));
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(outRGBA), XMVectorSetW(color, 1.0f));
+		}
+	}
+
+	// Both formats share one exponent over RGB, so the 8 bit mantissas move over without rounding
+	// as long as the exponent fits in 5 bits
+	void RGBEToSharedExp(const uint8_t* rgbe, uint32_t width, XMFLOAT3SE* outTexels)
+	{
+		for (uint32_t x = 0; x < width; x++, rgbe += 4)
+		{
+			const int exponent = static_cast<int>(rgbe[3]) - 113;
+			if (rgbe[3] == 0 || exponent < -8)
+			{
+				outTexels[x].v = 0;
+			}
+			else if (exponent > 31)
+			{
+				// Brighter than R9G9B9E5 can hold, let DirectXMath clamp it
+				float scale = std::ldexp(1.0f, static_cast<int>(rgbe[3]) - 136);
+				XMStoreFloat3SE(&outTexels[x], XMVectorScale(XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(rgbe)), scale));
+			}
+			else
+			{
+				// Too dark for the smallest exponent, shift the mantissas down instead
+				const uint32_t shift = exponent < 0 ? static_cast<uint32_t>(-exponent) : 0;
+				outTexels[x].xm = (static_cast<uint32_t>(rgbe[0]) << 1) >> shift;
+				outTexels[x].ym = (static_cast<uint32_t>(rgbe[1]) << 1) >> shift;
+				outTexels[x].zm = (static_cast<uint32_t>(rgbe[2]) << 1) >> shift;
+				outTexels[x].e = exponent < 0 ? 0 : static_cast<uint32_t>(exponent);
+			}
+		}
+	}
+}
 
 bool CreateHDRTextureFromFile(
-	std::string FileName,
+	const std::wstring& FileName,
 	TextureInfo& textureInfo,
 	D3D12_SUBRESOURCE_DATA& SubResource,
-	std::vector<uint8_t>& DecodedData)
+	std::vector<uint8_t>& DecodedData,
+	const HDRLoadSettings& Settings)
 {
-	stbi_set_flip_vertically_on_load(true);
-	int Width, Height, Components;
-	float* Data = stbi_loadf(FileName.c_str(), &Width, &Height, &Components, 0);
-	assert(Components == 3);
+	// Input, only the compressed file is held in memory
+	std::shared_ptr<TMappedFile> mappedFile = Settings.bMemoryMap ? TMappedFile::Open(FileName.c_str()) : nullptr;
+	std::unique_ptr<uint8_t[]> fileData;
+	const uint8_t* pos = nullptr;
+	size_t fileSize = 0;
 
-	if (Data)
+	if (mappedFile)
+	{
+		pos = mappedFile->GetData();
+		fileSize = mappedFile->GetSize();
+	}
+	else if (SUCCEEDED(TBinaryReader::ReadEntireFile(FileName.c_str(), fileData, &fileSize)))
 	{
-		LONG RowBytes = Width * Components * sizeof(float);
-		LONG NumBytes = Width * Height * Components * sizeof(float);
+		pos = fileData.get();
+	}
+	else
+	{
+		return false;
+	}
+
+	return CreateHDRTextureFromMemory(pos, fileSize, textureInfo, SubResource, DecodedData, Settings);
+}
 
-		// DecodedData
-		DecodedData.resize(NumBytes);
-		memcpy_s(DecodedData.data(), NumBytes, Data, NumBytes);
+bool CreateHDRTextureFromMemory(
+	const uint8_t* Data,
+	size_t DataSize,
+	TextureInfo& textureInfo,
+	D3D12_SUBRESOURCE_DATA& SubResource,
+	std::vector<uint8_t>& DecodedData,
+	const HDRLoadSettings& Settings)
+{
+	const uint8_t* pos = Data;
+	const uint8_t* end = Data + DataSize;
 
-		stbi_image_free(Data);
+	uint32_t Width = 0, Height = 0;
+	bool bTopDown = true;
+	if (!ReadHeader(pos, end, Width, Height, bTopDown))
+		return false;
 
-		// SubResource
-		SubResource.pData = DecodedData.data();
-		SubResource.RowPitch = static_cast<LONG>(RowBytes);
-		SubResource.SlicePitch = static_cast<LONG>(NumBytes);
+	// Every encoding takes at least one 4 byte pixel per scanline, a truncated file fails before the image is allocated
+	if (static_cast<size_t>(end - pos) / 4 < Height)
+		return false;
 
-		// TextureInfo
-		textureInfo.arraySize = 1;
-		textureInfo.format = DXGI_FORMAT_R32G32B32_FLOAT;
-		textureInfo.width = Width;
-		textureInfo.height = Height;
-		textureInfo.depth = 1;
-		textureInfo.mipCount = 1;
-		textureInfo.dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	const bool bHalf = Settings.format == EHDRTextureFormat::Half;
+	const size_t TexelSize = bHalf ? 4 * sizeof(HALF) : sizeof(XMFLOAT3SE);
+	const size_t RowBytes = Width * TexelSize;
+	const size_t NumBytes = RowBytes * Height;
 
-		return true;
+	// DecodedData, the only full size allocation
+	DecodedData.resize(NumBytes);
+
+	std::vector<uint8_t> ScanlineRGBE(Width * 4);
+	std::vector<float> ScanlineFloat(bHalf ? Width * 4 : 0);
+
+	for (uint32_t Line = 0; Line < Height; Line++)
+	{
+		if (!ReadScanline(pos, end, Width, ScanlineRGBE.data()))
+		{
+			DecodedData.clear();
+			return false;
+		}
+
+		// Bottom row first
+		const uint32_t Row = bTopDown ? Height - 1 - Line : Line;
+		uint8_t* Dest = DecodedData.data() + Row * RowBytes;
+
+		if (bHalf)
+		{
+			RGBEToFloat(ScanlineRGBE.data(), Width, ScanlineFloat.data());
+			XMConvertFloatToHalfStream(reinterpret_cast<HALF*>(Dest), sizeof(HALF), ScanlineFloat.data(), sizeof(float), ScanlineFloat.size());
+		}
+		else
+		{
+			RGBEToSharedExp(ScanlineRGBE.data(), Width, reinterpret_cast<XMFLOAT3SE*>(Dest));
+		}
 	}
 
-	return false;
-}
\ No newline at end of file
+	// SubResource
+	SubResource.pData = DecodedData.data();
+	SubResource.RowPitch = static_cast<LONG_PTR>(RowBytes);
+	SubResource.SlicePitch = static_cast<LONG_PTR>(NumBytes);
+
+	// TextureInfo
+	textureInfo.arraySize = 1;
+	textureInfo.format = bHalf ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R9G9B9E5_SHAREDEXP;
+	textureInfo.width = Width;
+	textureInfo.height = Height;
+	textureInfo.depth = 1;
+	textureInfo.mipCount = 1;
+	textureInfo.dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+
+	return true;
+}
@@ -3,8 +3,34 @@
 #include <string>
 #include "../Texture/TextureInfo.h"
 
+enum class EHDRTextureFormat
+{
+	Half,      // DXGI_FORMAT_R16G16B16A16_FLOAT, can have mips generated and be baked to BC6H
+	SharedExp, // DXGI_FORMAT_R9G9B9E5_SHAREDEXP, half the size, sample only
+};
+
+struct HDRLoadSettings
+{
+	EHDRTextureFormat format = EHDRTextureFormat::Half;
+
+	// Decode from a view of the file instead of reading it into memory first
+	bool bMemoryMap = true;
+};
+
+// Radiance RGBE (.hdr) loader. Scanlines are decoded one at a time straight into DecodedData,
+// the image is stored bottom row first like the stb loader it replaces.
 bool CreateHDRTextureFromFile(
-	std::string FileName,
+	const std::wstring& FileName,
+	TextureInfo& textureInfo,
+	D3D12_SUBRESOURCE_DATA& SubResource,
+	std::vector<uint8_t>& DecodedData,
+	const HDRLoadSettings& Settings = HDRLoadSettings());
+
+// The same on a whole .hdr file in memory, nothing past Data + DataSize is read. Settings.bMemoryMap is not used.
+bool CreateHDRTextureFromMemory(
+	const uint8_t* Data,
+	size_t DataSize,
 	TextureInfo& textureInfo,
 	D3D12_SUBRESOURCE_DATA& SubResource,
-	std::vector<uint8_t>& DecodedData);
+	std::vector<uint8_t>& DecodedData,
+	const HDRLoadSettings& Settings = HDRLoadSettings());
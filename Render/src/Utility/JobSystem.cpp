@@ -0,0 +1,298 @@
+#include "JobSystem.h"
+#include "../Common/stdafx.h"
+#include "../Utils/Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <objbase.h>
+
+namespace
+{
+	// Index of the queue owned by the current thread
+	thread_local uint32_t currentQueueIndex = 0;
+}
+
+JobSystem& JobSystem::Get()
+{
+	static JobSystem Instance;
+	return Instance;
+}
+
+void JobSystem::Initialize(uint32_t numWorkers)
+{
+	if (!workers.empty())
+	{
+		return;
+	}
+
+	if (numWorkers == 0)
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	bStop = false;
+
+	queues.clear();
+	for (uint32_t i = 0; i < numWorkers + 1; i++)
+	{
+		queues.push_back(std::make_unique<WorkerQueue>());
+	}
+
+	for (uint32_t i = 0; i < numWorkers; i++)
+	{
+		workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+	}
+}
+
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		bStop = true;
+	}
+	wakeCondition.notify_all();
+
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	workers.clear();
+	queues.clear();
+}
+
+void JobSystem::WorkerLoop(uint32_t queueIndex)
+{
+	currentQueueIndex = queueIndex;
+
+	// WIC decoding needs COM on every thread that uses it
+	HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+	while (true)
+	{
+		if (TryRunOne())
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		wakeCondition.wait(lock, [this]() { return bStop || queuedJobCount.load() > 0; });
+
+		if (bStop)
+		{
+			break;
+		}
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		CoUninitialize();
+	}
+}
+
+JobRef JobSystem::Schedule(const std::string& name, std::function<void()> func, const std::vector<JobRef>& dependencies)
+{
+	JobRef job = std::make_shared<Job>(name, std::move(func));
+
+	for (const JobRef& dependency : dependencies)
+	{
+		if (!dependency)
+		{
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(dependency->dependentsMutex);
+		if (!dependency->IsFinished())
+		{
+			job->pendingDependencies++;
+			dependency->dependents.push_back(job);
+		}
+	}
+
+	// Release the initial reference, queue now if nothing is pending
+	if (--job->pendingDependencies == 0)
+	{
+		Enqueue(job);
+	}
+
+	return job;
+}
+
+void JobSystem::Enqueue(const JobRef& job)
+{
+	// Without workers run inline, so the loaders still work single threaded
+	if (queues.empty())
+	{
+		Execute(job);
+		return;
+	}
+
+	uint32_t queueIndex = currentQueueIndex;
+	if (queueIndex == 0)
+	{
+		// Spread jobs from the main thread over the workers
+		queueIndex = 1 + nextQueue.fetch_add(1) % static_cast<uint32_t>(workers.size());
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+		queues[queueIndex]->jobs.push_back(job);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		queuedJobCount++;
+	}
+	wakeCondition.notify_one();
+}
+
+bool JobSystem::TryRunOne()
+{
+	JobRef job = nullptr;
+
+	// Own queue first, LIFO keeps the caches warm
+	{
+		WorkerQueue& ownQueue = *queues[currentQueueIndex];
+		std::lock_guard<std::mutex> lock(ownQueue.mutex);
+		if (!ownQueue.jobs.empty())
+		{
+			job = ownQueue.jobs.back();
+			ownQueue.jobs.pop_back();
+		}
+	}
+
+	// Steal the oldest job from someone else
+	const uint32_t queueCount = static_cast<uint32_t>(queues.size());
+	for (uint32_t i = 1; i < queueCount && !job; i++)
+	{
+		WorkerQueue& otherQueue = *queues[(currentQueueIndex + i) % queueCount];
+		std::lock_guard<std::mutex> lock(otherQueue.mutex);
+		if (!otherQueue.jobs.empty())
+		{
+			job = otherQueue.jobs.front();
+			otherQueue.jobs.pop_front();
+		}
+	}
+
+	if (!job)
+	{
+		return false;
+	}
+
+	queuedJobCount--;
+	Execute(job);
+
+	return true;
+}
+
+void JobSystem::Execute(const JobRef& job)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	try
+	{
+		job->func();
+	}
+	catch (...)
+	{
+		job->exception = std::current_exception();
+	}
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	job->durationMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+	job->func = nullptr;
+
+	if (bRecordTimings)
+	{
+		std::lock_guard<std::mutex> lock(timingsMutex);
+		timings.emplace_back(job->name, job->durationMs);
+	}
+
+	std::vector<JobRef> dependents;
+	{
+		std::lock_guard<std::mutex> lock(job->dependentsMutex);
+		job->bFinished.store(true, std::memory_order_release);
+		dependents.swap(job->dependents);
+	}
+
+	for (const JobRef& dependent : dependents)
+	{
+		if (--dependent->pendingDependencies == 0)
+		{
+			Enqueue(dependent);
+		}
+	}
+}
+
+void JobSystem::Wait(const JobRef& job)
+{
+	if (!job)
+	{
+		return;
+	}
+
+	while (!job->IsFinished())
+	{
+		if (queues.empty() || !TryRunOne())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	if (job->exception)
+	{
+		std::rethrow_exception(job->exception);
+	}
+}
+
+void JobSystem::WaitAll(const std::vector<JobRef>& jobs)
+{
+	for (const JobRef& job : jobs)
+	{
+		Wait(job);
+	}
+}
+
+void JobSystem::ParallelFor(const std::string& name, uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t, uint32_t)>& func)
+{
+	uint32_t batchCount = count / (minBatchSize > 0 ? minBatchSize : 1);
+	batchCount = batchCount < GetWorkerCount() + 1 ? batchCount : GetWorkerCount() + 1;
+	if (batchCount <= 1)
+	{
+		if (count > 0)
+		{
+			func(0, count);
+		}
+		return;
+	}
+
+	const uint32_t batchSize = (count + batchCount - 1) / batchCount;
+
+	std::vector<JobRef> jobs;
+	for (uint32_t begin = 0; begin < count; begin += batchSize)
+	{
+		uint32_t end = begin + batchSize < count ? begin + batchSize : count;
+		jobs.push_back(Schedule(name, [&func, begin, end]()
+			{
+				func(begin, end);
+			}));
+	}
+
+	WaitAll(jobs);
+}
+
+void JobSystem::LogTimings()
+{
+	std::vector<std::pair<std::string, double>> finishedJobs;
+	{
+		std::lock_guard<std::mutex> lock(timingsMutex);
+		finishedJobs.swap(timings);
+	}
+
+	char text[256];
+	for (const auto& timing : finishedJobs)
+	{
+		sprintf_s(text, "[JobSystem] %s: %.2f ms\n", timing.first.c_str(), timing.second);
+		TLogger::LogToOutput(text);
+	}
+}
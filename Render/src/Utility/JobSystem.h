@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Job;
+typedef std::shared_ptr<Job> JobRef;
+
+class Job
+{
+public:
+	Job(const std::string& InName, std::function<void()>&& InFunc)
+		:name(InName), func(std::move(InFunc))
+	{}
+
+	bool IsFinished() const { return bFinished.load(std::memory_order_acquire); }
+
+	double GetDurationMs() const { return durationMs; }
+
+public:
+	std::string name;
+
+private:
+	friend class JobSystem;
+
+	std::function<void()> func;
+
+	// Jobs are queued once this drops to zero
+	std::atomic<uint32_t> pendingDependencies = 1;
+
+	std::mutex dependentsMutex;
+	std::vector<JobRef> dependents;
+
+	std::atomic<bool> bFinished = false;
+	std::exception_ptr exception = nullptr;
+	double durationMs = 0.0;
+};
+
+// Small work-stealing job system used for loading assets.
+// Each worker owns a queue, pops from its back and steals from the front of the others.
+class JobSystem
+{
+public:
+	static JobSystem& Get();
+
+	// numWorkers == 0 uses one worker per hardware thread, minus the calling thread.
+	void Initialize(uint32_t numWorkers = 0);
+
+	void Shutdown();
+
+	// The job starts once all dependencies have finished.
+	JobRef Schedule(const std::string& name, std::function<void()> func, const std::vector<JobRef>& dependencies = {});
+
+	// Runs other jobs while waiting, rethrows the exception thrown by the job if any.
+	void Wait(const JobRef& job);
+
+	void WaitAll(const std::vector<JobRef>& jobs);
+
+	// Splits [0, count) into batches of at least minBatchSize, runs them as jobs and waits.
+	// Ranges too small to split run on the calling thread.
+	void ParallelFor(const std::string& name, uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t, uint32_t)>& func);
+
+	uint32_t GetWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+	// Print the time of every finished job since the last call to the debug output
+	void LogTimings();
+
+	// Per frame jobs would grow the list forever, the engine stops recording once loading is done.
+	// Job::GetDurationMs is always set.
+	void SetRecordTimings(bool bRecord) { bRecordTimings = bRecord; }
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<JobRef> jobs;
+	};
+
+	void WorkerLoop(uint32_t queueIndex);
+
+	void Enqueue(const JobRef& job);
+
+	bool TryRunOne();
+
+	void Execute(const JobRef& job);
+
+private:
+	std::vector<std::thread> workers;
+
+	// Queue 0 belongs to threads that are not workers (e.g. the main thread)
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+	std::atomic<uint32_t> nextQueue = 0;
+
+	std::atomic<int> queuedJobCount = 0;
+
+	std::mutex wakeMutex;
+	std::condition_variable wakeCondition;
+	bool bStop = false;
+
+	std::atomic<bool> bRecordTimings = true;
+	std::mutex timingsMutex;
+	std::vector<std::pair<std::string, double>> timings;
+};
@@ -1,133 +1,166 @@
 #pragma vengine_package vengine_dll
 #include "StackAllocator.h"
-#include <optional>
+#include <algorithm>
+#include <limits>
 
-StackAllocator::StackAllocator(uint64 initCapacity,
-	IStackAllocVisitor* visitor)
-	: capacity(initCapacity),
-	  visitor(visitor){}
+StackAllocator::StackAllocator(uint64 pageSize,
+	IStackAllocVisitor* visitor,
+	uint64 trimFrameCount)
+	: visitor(visitor),
+	  pageSize(pageSize),
+	  trimFrameCount(trimFrameCount){}
 
 StackAllocator::Chunk StackAllocator::Allocate(uint64 targetSize)
 {
-	Buffer* bf = nullptr;
-	uint64 minSize = std::numeric_limits<uint64>::max();
-	//  allocatedBuffersҵһ targetSize buffer
-	for (auto&& i : allocatedBuffers )
-	{
-		// ʹСʣռBuffer
-		if (i.leftSize >= targetSize && i.leftSize < minSize)
-		{
-			minSize = i.leftSize;
-			bf = &i;
-		}
-	}
-	// ҵ˺ʵ Buffer
-	if (bf)
-	{
-		// ƫ fullSize - leftSize ʼ䣩
-		auto ofst = bf->fullSize - bf->leftSize;
+	return Allocate(targetSize, 1);
+}
 
-		//  leftSizeʹõĿռ
-		bf->leftSize -= targetSize;
-		return
-		{
-			bf->handle,
-			ofst
-		};
-	}
+StackAllocator::Chunk StackAllocator::Allocate(uint64 targetSize, uint64 align)
+{
+	// 루ȡ align 
+	align = std::max<uint64>(align, 1);
+	auto CalcAlign = [](uint64 value, uint64 align) -> uint64 {
+		return (value + (align - 1)) & ~(align - 1);
+	};
+
+	Buffer* bf = activeBuffers.empty() ? nullptr : &activeBuffers.back();
+	uint64 offset = bf ? CalcAlign(bf->usedSize, align) : 0;
 
-	// Ҳʵ Buffer ʹµ
-	// û㹻 Buffer ʱ̬ capacity
-	while (capacity < targetSize)
+	// Only the newest page is tried, the rest of a full page is left unused
+	if (!bf || offset + targetSize > bf->fullSize)
 	{
-		capacity = std::max<uint64>(capacity + 1, capacity * 1.5);
+		bf = &AcquireBuffer(targetSize);
+		offset = 0;
 	}
-	//  visitor->Allocate(capacity) µ GPU Դ
-	auto newHandle = visitor->Allocate(capacity);
-	// · Buffer ӵ allocatedBuffersľƫ
-	allocatedBuffers.push_back(Buffer{
-		newHandle,
-		capacity,
-		capacity - targetSize });
+
+	bf->usedSize = offset + targetSize;
+
+	stats.frameBytes += targetSize;
+	stats.peakFrameBytes = std::max(stats.peakFrameBytes, stats.frameBytes);
+
 	return
 	{
-		newHandle,
-		0
+		bf->handle,
+		offset
 	};
 }
 
-StackAllocator::Chunk StackAllocator::Allocate(uint64 targetSize, uint64 align)
+StackAllocator::Buffer& StackAllocator::AcquireBuffer(uint64 size)
 {
-	// 
-	targetSize = std::max(targetSize, align);
-	Buffer* bf = nullptr;
-	uint64 offset = 0;
-	uint64 minLeftSize = std::numeric_limits<uint64>::max();
-	// ƫȡ align 
-	auto CalcAlign = [](uint64 value, uint64 align) -> uint64 {
-		return (value + (align - 1)) & ~(align - 1);
-	};
-	struct Result
-	{
-		uint64 offset;
-		uint64 leftSize;
-	};
-	// λãȷ targetSize Ȼ fullSize Χ
-	auto GetLeftSize = [&](uint64 leftSize, uint64 size) -> std::optional<Result>
+	const bool bLarge = size > pageSize;
+
+	Buffer buffer;
+	if (!bLarge && !freeBuffers.empty())
 	{
-		uint64 offset = size - leftSize;
-		uint64 alignedOffset = CalcAlign(offset, align);
-		uint64 afterAllocSize = targetSize + alignedOffset;
-		if (afterAllocSize > size) return {};
-		return Result{ alignedOffset, size - afterAllocSize };
-	};
-	//  allocatedBuffersҵʵ Buffer
-	for (auto&& i:allocatedBuffers)
+		buffer = freeBuffers.back();
+		freeBuffers.pop_back();
+	}
+	else
 	{
-		auto result = GetLeftSize(i.leftSize, i.fullSize);
-		if(!result.has_value()) continue;
-		auto resultValue = result.value();
-		if (resultValue.leftSize < minLeftSize)
+		// Large pages are rare, a scan of their pool is fine
+		auto iter = bLarge ? std::find_if(freeLargeBuffers.begin(), freeLargeBuffers.end(),
+			[size](const Buffer& b) { return b.fullSize >= size; }) : freeLargeBuffers.end();
+
+		if (iter != freeLargeBuffers.end())
 		{
-			minLeftSize = resultValue.leftSize;
-			offset = resultValue.offset;
-			bf = &i;
+			buffer = *iter;
+			*iter = freeLargeBuffers.back();
+			freeLargeBuffers.pop_back();
+		}
+		else
+		{
+			//  visitor->Allocate µ GPU Դķ䰴 pageSize ȡ
+			const uint64 fullSize = bLarge ? (size + pageSize - 1) / pageSize * pageSize : pageSize;
+			buffer = Buffer{ visitor->Allocate(fullSize), fullSize, 0, 0, 0 };
+
+			stats.reservedBytes += fullSize;
+			stats.peakReservedBytes = std::max(stats.peakReservedBytes, stats.reservedBytes);
+			stats.pageCount++;
 		}
 	}
-	if (bf)
+
+	buffer.usedSize = 0;
+	activeBuffers.push_back(buffer);
+
+	// A dedicated page is full right away, keep bumping in the previous one
+	if (bLarge && activeBuffers.size() > 1)
 	{
-		bf->leftSize = minLeftSize;   // ȷ´ηڴʱ㹻ռ
-		return{
-			bf->handle,
-			offset };
+		std::swap(activeBuffers.back(), activeBuffers[activeBuffers.size() - 2]);
+		return activeBuffers[activeBuffers.size() - 2];
 	}
-	while (capacity < targetSize)
+
+	return activeBuffers.back();
+}
+
+void StackAllocator::ReleaseBuffer(const Buffer& buffer)
+{
+	visitor->DeAllocate(buffer.handle);
+
+	stats.reservedBytes -= buffer.fullSize;
+	stats.pageCount--;
+}
+
+void StackAllocator::Retire(uint64 fenceValue)
+{
+	for (auto&& i : activeBuffers)
 	{
-		capacity = std::max<uint64>(capacity + 1, capacity * 1.5);
+		i.fenceValue = fenceValue;
+		stats.inFlightBytes += i.fullSize;
+		retiredBuffers.push_back(i);
 	}
-	auto newHandle = visitor->Allocate(capacity);
-	allocatedBuffers.push_back(Buffer{
-		newHandle,
-		capacity,
-		capacity - targetSize });
-	return{
-		newHandle,
-		0
-	};
+
+	activeBuffers.clear();
+	stats.frameBytes = 0;
 }
 
-void StackAllocator::Clear()
+void StackAllocator::Recycle(uint64 completedFenceValue)
 {
-	for (auto&& i : allocatedBuffers)
+	frameIndex++;
+
+	while (!retiredBuffers.empty() && retiredBuffers.front().fenceValue <= completedFenceValue)
 	{
-		i.leftSize = i.fullSize;
+		Buffer& buffer = retiredBuffers.front();
+		buffer.lastUsedFrame = frameIndex;
+		stats.inFlightBytes -= buffer.fullSize;
+
+		(buffer.fullSize > pageSize ? freeLargeBuffers : freeBuffers).push_back(buffer);
+		retiredBuffers.pop_front();
 	}
+
+	// Trim pages that were not needed for trimFrameCount frames
+	auto Trim = [this](std::vector<Buffer>& pool)
+	{
+		auto iter = std::remove_if(pool.begin(), pool.end(), [this](const Buffer& b)
+		{
+			if (frameIndex - b.lastUsedFrame <= trimFrameCount)
+				return false;
+
+			ReleaseBuffer(b);
+			return true;
+		});
+		pool.erase(iter, pool.end());
+	};
+	Trim(freeBuffers);
+	Trim(freeLargeBuffers);
+}
+
+void StackAllocator::Clear()
+{
+	Retire(0);
+	Recycle((std::numeric_limits<uint64>::max)());
 }
 
 StackAllocator::~StackAllocator()
 {
-	for (auto&& i : allocatedBuffers)
+	for (auto* pool : { &activeBuffers, &freeBuffers, &freeLargeBuffers })
+	{
+		for (auto&& i : *pool)
+		{
+			visitor->DeAllocate(i.handle);
+		}
+	}
+	for (auto&& i : retiredBuffers)
 	{
 		visitor->DeAllocate(i.handle);
 	}
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "../Common/stdafx.h"
+#include <deque>
 
 // Դ𴴽Buffer
 class IStackAllocVisitor
@@ -10,30 +11,69 @@ public:
 };
 
 // ڴ
+// Frame pipelined linear allocator over pages of one size class.
+// Allocate bumps a pointer in the current page. Retire tags every page used since the last Retire
+// with the fence of that frame, Recycle moves them back to the free pool once the GPU passed the fence.
+// Pages that stay in the pool for trimFrameCount frames are given back to the visitor.
 class StackAllocator
 {
 	struct Buffer
 	{
 		uint64 handle;     // ԴGPU Դ ID
 		uint64 fullSize;   // ԴܴС
-		uint64 leftSize;   // ʣÿռ
+		uint64 usedSize;   // Bump pointer
+		uint64 fenceValue; // Recyclable once the GPU passed it
+		uint64 lastUsedFrame;
 	};
 
 	IStackAllocVisitor* visitor;    // ʽӿڣײ GPU Դķͷ
-	uint64 capacity;                // ڴصǰ
-	std::vector<Buffer> allocatedBuffers; // ¼ѷ GPU Դ
+	uint64 pageSize;
+	uint64 trimFrameCount;
+	uint64 frameIndex = 0;
+
+	std::vector<Buffer> activeBuffers;      // Used this frame, back() is the bump target
+	std::deque<Buffer> retiredBuffers;      // Waiting for their fence, in fence order
+	std::vector<Buffer> freeBuffers;        // pageSize pages
+	std::vector<Buffer> freeLargeBuffers;   // Dedicated pages of allocations larger than pageSize
 
 public:
-	StackAllocator(uint64 initCapacity, 
-		IStackAllocVisitor* visitor);
+	struct Stats
+	{
+		uint64 frameBytes = 0;          // Handed out since the last Retire
+		uint64 peakFrameBytes = 0;
+		uint64 reservedBytes = 0;       // All pages, active, in flight or pooled
+		uint64 peakReservedBytes = 0;
+		uint64 inFlightBytes = 0;       // Retired pages the GPU may still read
+		uint64 pageCount = 0;
+	};
+
+	StackAllocator(uint64 pageSize,
+		IStackAllocVisitor* visitor,
+		uint64 trimFrameCount = 64);
 	~StackAllocator();
+	StackAllocator(const StackAllocator&) = delete;
+	StackAllocator& operator=(const StackAllocator&) = delete;
+
 	struct Chunk
 	{
 		uint64 handle;
 		uint64 offset;
 	};
-	// еBufferﻮֿռ
 	Chunk Allocate(uint64 targetSize);  // ڴ棨Ƕ룩
 	Chunk Allocate(uint64 targetSize, uint64 align);  // ڴ
+
+	// End of the CPU frame, the pages used so far are read by the GPU until fenceValue
+	void Retire(uint64 fenceValue);
+	// Start of the CPU frame, reuse every page whose fence is done and trim idle ones
+	void Recycle(uint64 completedFenceValue);
+	// Everything at once, only when the GPU is idle
 	void Clear();
+
+	const Stats& GetStats() const { return stats; }
+
+private:
+	Buffer& AcquireBuffer(uint64 size);
+	void ReleaseBuffer(const Buffer& buffer);
+
+	Stats stats;
 };
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Dense per-class lists of the objects in a world, replacing dynamic_cast scans over every actor.
+// An object is listed under its own class and every base class that uses DECLARE_CLASS, so iterating
+// a class is a linear walk over a contiguous array of pointers, without RTTI or allocation.
+// Class indices are assigned on first use and shared by all registries.
+class ClassRegistry
+{
+public:
+	template<typename T>
+	void Add(T* object)
+	{
+		uint32_t classIndex = GetClassIndex<T>();
+		if (classIndex >= classLists.size())
+		{
+			classLists.resize(classIndex + 1);
+		}
+
+		if (!classLists[classIndex])
+		{
+			classLists[classIndex] = std::make_unique<ClassList<T>>();
+		}
+
+		static_cast<ClassList<T>*>(classLists[classIndex].get())->objects.push_back(object);
+	}
+
+	// Objects in the order they were added, empty if none of the class was ever added
+	template<typename T>
+	const std::vector<T*>& Get() const
+	{
+		uint32_t classIndex = GetClassIndex<T>();
+		if (classIndex < classLists.size() && classLists[classIndex])
+		{
+			return static_cast<const ClassList<T>*>(classLists[classIndex].get())->objects;
+		}
+
+		static const std::vector<T*> emptyList;
+		return emptyList;
+	}
+
+private:
+	struct IClassList
+	{
+		virtual ~IClassList() {}
+	};
+
+	template<typename T>
+	struct ClassList : public IClassList
+	{
+		std::vector<T*> objects;
+	};
+
+	static uint32_t NextClassIndex()
+	{
+		static uint32_t classCount = 0;
+		return classCount++;
+	}
+
+	template<typename T>
+	static uint32_t GetClassIndex()
+	{
+		static const uint32_t classIndex = NextClassIndex();
+		return classIndex;
+	}
+
+private:
+	std::vector<std::unique_ptr<IClassList>> classLists;
+};
+
+// Put at the top of every Actor and Component subclass, a class without it is listed under its base only
+#define DECLARE_CLASS(ClassName, SuperClass) \
+public: \
+	using Super = SuperClass; \
+	virtual void RegisterClassLists(ClassRegistry& registry) override \
+	{ \
+		Super::RegisterClassLists(registry); \
+		registry.Add<ClassName>(this); \
+	} \
+private:
@@ -0,0 +1,433 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "../Math/Frustum.h"
+#include "../Mesh/Ray.h"
+
+#define LOOSE_OCTREE_INVALID_ID 0xffffffff
+#define LOOSE_OCTREE_MAX_DEPTH 10
+
+// Dynamic scene index over axis aligned boxes.
+// Cells halve per level and the loose bounds of a node are its cell grown to twice the size, so an object lives in the
+// deepest node whose cell contains its center and whose half size is at least the largest half extent of the object.
+// Moving an object usually keeps it in its node, otherwise it is moved by one root to leaf walk.
+// Objects outside the root cell or larger than it stay in the root, whose objects are always tested.
+// Nodes are created on demand and recycled once their subtree is empty.
+// Queries are const and may run concurrently, Add, Update and Remove may not.
+template<typename T>
+class LooseOctree
+{
+public:
+	LooseOctree(const TVector3& inRootCenter = TVector3::Zero, float inRootHalfSize = 1024.0f, uint32_t inMaxDepth = LOOSE_OCTREE_MAX_DEPTH)
+		:maxDepth(inMaxDepth < LOOSE_OCTREE_MAX_DEPTH ? inMaxDepth : LOOSE_OCTREE_MAX_DEPTH)
+	{
+		Node root;
+		root.center = inRootCenter;
+		root.halfSize = inRootHalfSize;
+		nodes.push_back(root);
+	}
+
+	// Returns the id used by Update and Remove
+	uint32_t Add(T* object, const TVector3& boxMin, const TVector3& boxMax)
+	{
+		uint32_t id;
+		if (!freeEntries.empty())
+		{
+			id = freeEntries.back();
+			freeEntries.pop_back();
+		}
+		else
+		{
+			id = static_cast<uint32_t>(entries.size());
+			entries.emplace_back();
+		}
+
+		Entry& entry = entries[id];
+		entry.object = object;
+		entry.boxMin = boxMin;
+		entry.boxMax = boxMax;
+
+		InsertIntoNode(FindNode(boxMin, boxMax), id);
+		objectCount++;
+
+		return id;
+	}
+
+	void Update(uint32_t id, const TVector3& boxMin, const TVector3& boxMax)
+	{
+		Entry& entry = entries[id];
+		entry.boxMin = boxMin;
+		entry.boxMax = boxMax;
+
+		if (FitsNode(entry.node, boxMin, boxMax))
+		{
+			return;
+		}
+
+		// Insert first, so the common ancestors are not recycled and created again
+		int32_t oldNode = entry.node;
+		uint32_t oldSlot = entry.slot;
+		InsertIntoNode(FindNode(boxMin, boxMax), id);
+		RemoveFromNode(oldNode, oldSlot);
+	}
+
+	void Remove(uint32_t id)
+	{
+		Entry& entry = entries[id];
+		RemoveFromNode(entry.node, entry.slot);
+
+		entry.object = nullptr;
+		freeEntries.push_back(id);
+		objectCount--;
+	}
+
+	void QueryFrustum(const TFrustum& frustum, std::vector<T*>& outObjects) const
+	{
+		Query(outObjects,
+			[&frustum](const TVector3& boxMin, const TVector3& boxMax) { return frustum.TestBox(boxMin, boxMax); });
+	}
+
+	void QuerySphere(const TVector3& center, float radius, std::vector<T*>& outObjects) const
+	{
+		Query(outObjects, [&center, radius](const TVector3& boxMin, const TVector3& boxMax)
+			{
+				// Squared distance from the center to the box, and to its farthest corner
+				float nearest = 0.0f;
+				float farthest = 0.0f;
+				for (int i = 0; i < 3; i++)
+				{
+					float c = (&center.x)[i];
+					float lo = (&boxMin.x)[i];
+					float hi = (&boxMax.x)[i];
+					float d = c < lo ? lo - c : (c > hi ? c - hi : 0.0f);
+					float f = (std::max)(c - lo, hi - c);
+					nearest += d * d;
+					farthest += f * f;
+				}
+
+				float radiusSquared = radius * radius;
+				return nearest > radiusSquared ? -1 : (farthest <= radiusSquared ? 1 : 0);
+			});
+	}
+
+	void QueryBox(const TVector3& queryMin, const TVector3& queryMax, std::vector<T*>& outObjects) const
+	{
+		Query(outObjects, [&queryMin, &queryMax](const TVector3& boxMin, const TVector3& boxMax)
+			{
+				if (boxMax.x < queryMin.x || boxMin.x > queryMax.x || boxMax.y < queryMin.y || boxMin.y > queryMax.y ||
+					boxMax.z < queryMin.z || boxMin.z > queryMax.z)
+				{
+					return -1;
+				}
+
+				bool bInside = boxMin.x >= queryMin.x && boxMax.x <= queryMax.x && boxMin.y >= queryMin.y && boxMax.y <= queryMax.y &&
+					boxMin.z >= queryMin.z && boxMax.z <= queryMax.z;
+				return bInside ? 1 : 0;
+			});
+	}
+
+	// Objects whose box the ray enters before ray.maxDist, unsorted
+	void QueryRay(const Ray& ray, std::vector<T*>& outObjects) const
+	{
+		TVector3 invDirection(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+
+		Query(outObjects, [&ray, &invDirection](const TVector3& boxMin, const TVector3& boxMax)
+			{
+				// Slabs, pbrt style
+				float t0 = 0.0f;
+				float t1 = ray.maxDist;
+				for (int i = 0; i < 3; i++)
+				{
+					float origin = (&ray.origin.x)[i];
+
+					// Parallel to the slab, the box is hit only from inside it. Tested explicitly, the slab distances
+					// would be 0 * inf = NaN for an origin on a face.
+					if ((&ray.direction.x)[i] == 0.0f)
+					{
+						if (origin < (&boxMin.x)[i] || origin > (&boxMax.x)[i])
+						{
+							return -1;
+						}
+						continue;
+					}
+
+					float invDir = (&invDirection.x)[i];
+					float tNear = ((&boxMin.x)[i] - origin) * invDir;
+					float tFar = ((&boxMax.x)[i] - origin) * invDir;
+					if (tNear > tFar)
+					{
+						std::swap(tNear, tFar);
+					}
+
+					t0 = tNear > t0 ? tNear : t0;
+					t1 = tFar < t1 ? tFar : t1;
+					if (t0 > t1)
+					{
+						return -1;
+					}
+				}
+
+				return 0;
+			});
+	}
+
+	// func(cellCenter, cellHalfSize, depth, objectCount) for every node in use, for debug drawing
+	template<typename Func>
+	void ForEachNode(Func&& func) const
+	{
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			const Node& node = nodes[i];
+			if (i == 0 || node.subtreeCount > 0)
+			{
+				func(node.center, node.halfSize, node.depth, static_cast<uint32_t>(node.objects.size()));
+			}
+		}
+	}
+
+	uint32_t GetObjectCount() const { return objectCount; }
+
+	uint32_t GetNodeCount() const { return static_cast<uint32_t>(nodes.size() - freeNodes.size()); }
+
+private:
+	struct Node
+	{
+		TVector3 center = TVector3::Zero;
+		float halfSize = 0.0f;
+		uint32_t depth = 0;
+
+		int32_t parent = -1;
+		int32_t children[8] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+
+		// Objects in this node and below it, only the root is kept when empty
+		uint32_t subtreeCount = 0;
+
+		std::vector<uint32_t> objects;
+	};
+
+	struct Entry
+	{
+		T* object = nullptr;
+		TVector3 boxMin = TVector3::Zero;
+		TVector3 boxMax = TVector3::Zero;
+
+		int32_t node = -1;
+		uint32_t slot = 0;
+	};
+
+	static float MaxHalfExtent(const TVector3& boxMin, const TVector3& boxMax)
+	{
+		return 0.5f * (std::max)({ boxMax.x - boxMin.x, boxMax.y - boxMin.y, boxMax.z - boxMin.z });
+	}
+
+	static bool CellContains(const Node& node, const TVector3& point)
+	{
+		return std::abs(point.x - node.center.x) <= node.halfSize && std::abs(point.y - node.center.y) <= node.halfSize &&
+			std::abs(point.z - node.center.z) <= node.halfSize;
+	}
+
+	// The node Add would choose, without creating any
+	bool FitsNode(int32_t nodeIndex, const TVector3& boxMin, const TVector3& boxMax) const
+	{
+		const Node& node = nodes[nodeIndex];
+		TVector3 center = (boxMin + boxMax) * 0.5f;
+		float halfExtent = MaxHalfExtent(boxMin, boxMax);
+
+		bool bFitsCell = CellContains(node, center) && halfExtent <= node.halfSize;
+		bool bFitsChild = node.depth < maxDepth && halfExtent <= node.halfSize * 0.5f;
+
+		return nodeIndex == 0 ? !(bFitsCell && bFitsChild) : (bFitsCell && !bFitsChild);
+	}
+
+	int32_t FindNode(const TVector3& boxMin, const TVector3& boxMax)
+	{
+		TVector3 center = (boxMin + boxMax) * 0.5f;
+		float halfExtent = MaxHalfExtent(boxMin, boxMax);
+
+		if (!CellContains(nodes[0], center) || halfExtent > nodes[0].halfSize)
+		{
+			return 0;
+		}
+
+		int32_t nodeIndex = 0;
+		while (nodes[nodeIndex].depth < maxDepth && halfExtent <= nodes[nodeIndex].halfSize * 0.5f)
+		{
+			const Node& node = nodes[nodeIndex];
+			int octant = (center.x >= node.center.x ? 1 : 0) | (center.y >= node.center.y ? 2 : 0) | (center.z >= node.center.z ? 4 : 0);
+
+			int32_t child = node.children[octant];
+			if (child < 0)
+			{
+				child = CreateChild(nodeIndex, octant);
+			}
+
+			nodeIndex = child;
+		}
+
+		return nodeIndex;
+	}
+
+	int32_t CreateChild(int32_t parentIndex, int octant)
+	{
+		int32_t childIndex;
+		if (!freeNodes.empty())
+		{
+			childIndex = freeNodes.back();
+			freeNodes.pop_back();
+		}
+		else
+		{
+			childIndex = static_cast<int32_t>(nodes.size());
+			nodes.emplace_back();
+		}
+
+		Node& parent = nodes[parentIndex];
+		Node& child = nodes[childIndex];
+
+		float quarter = parent.halfSize * 0.5f;
+		child.center = TVector3(
+			parent.center.x + ((octant & 1) ? quarter : -quarter),
+			parent.center.y + ((octant & 2) ? quarter : -quarter),
+			parent.center.z + ((octant & 4) ? quarter : -quarter));
+		child.halfSize = quarter;
+		child.depth = parent.depth + 1;
+		child.parent = parentIndex;
+		for (int32_t& grandChild : child.children)
+		{
+			grandChild = -1;
+		}
+		child.subtreeCount = 0;
+		child.objects.clear();
+
+		parent.children[octant] = childIndex;
+
+		return childIndex;
+	}
+
+	void InsertIntoNode(int32_t nodeIndex, uint32_t id)
+	{
+		Entry& entry = entries[id];
+		entry.node = nodeIndex;
+		entry.slot = static_cast<uint32_t>(nodes[nodeIndex].objects.size());
+		nodes[nodeIndex].objects.push_back(id);
+
+		for (int32_t i = nodeIndex; i >= 0; i = nodes[i].parent)
+		{
+			nodes[i].subtreeCount++;
+		}
+	}
+
+	void RemoveFromNode(int32_t nodeIndex, uint32_t slot)
+	{
+		auto& objects = nodes[nodeIndex].objects;
+		if (slot + 1 < objects.size())
+		{
+			objects[slot] = objects.back();
+			entries[objects[slot]].slot = slot;
+		}
+		objects.pop_back();
+
+		// Every node on the way up that became empty was empty below as well
+		int32_t emptyTop = -1;
+		for (int32_t i = nodeIndex; i >= 0; i = nodes[i].parent)
+		{
+			if (--nodes[i].subtreeCount == 0 && i != 0)
+			{
+				emptyTop = i;
+			}
+		}
+
+		if (emptyTop < 0)
+		{
+			return;
+		}
+
+		Node& parent = nodes[nodes[emptyTop].parent];
+		for (int32_t& child : parent.children)
+		{
+			if (child == emptyTop)
+			{
+				child = -1;
+			}
+		}
+
+		for (int32_t i = nodeIndex; ; i = nodes[i].parent)
+		{
+			freeNodes.push_back(i);
+			if (i == emptyTop)
+			{
+				break;
+			}
+		}
+	}
+
+	// test(boxMin, boxMax) returns -1 outside, 0 intersecting, 1 inside. Everything below a node inside is taken untested.
+	template<typename Test>
+	void Query(std::vector<T*>& outObjects, const Test& test) const
+	{
+		struct StackItem
+		{
+			int32_t node;
+			bool bInside;
+		};
+
+		// Depth first, at most 7 siblings wait per level
+		StackItem stack[8 * (LOOSE_OCTREE_MAX_DEPTH + 1)];
+		int stackSize = 0;
+		stack[stackSize++] = { 0, false };
+
+		while (stackSize > 0)
+		{
+			StackItem item = stack[--stackSize];
+			const Node& node = nodes[item.node];
+
+			for (uint32_t id : node.objects)
+			{
+				const Entry& entry = entries[id];
+				if (item.bInside || test(entry.boxMin, entry.boxMax) >= 0)
+				{
+					outObjects.push_back(entry.object);
+				}
+			}
+
+			for (int32_t childIndex : node.children)
+			{
+				if (childIndex < 0)
+				{
+					continue;
+				}
+
+				bool bChildInside = item.bInside;
+				if (!bChildInside)
+				{
+					const Node& child = nodes[childIndex];
+					TVector3 looseExtent(child.halfSize * 2.0f, child.halfSize * 2.0f, child.halfSize * 2.0f);
+
+					int result = test(child.center - looseExtent, child.center + looseExtent);
+					if (result < 0)
+					{
+						continue;
+					}
+
+					bChildInside = result > 0;
+				}
+
+				stack[stackSize++] = { childIndex, bChildInside };
+			}
+		}
+	}
+
+private:
+	uint32_t maxDepth;
+
+	std::vector<Node> nodes;
+	std::vector<int32_t> freeNodes;
+
+	std::vector<Entry> entries;
+	std::vector<uint32_t> freeEntries;
+
+	uint32_t objectCount = 0;
+};
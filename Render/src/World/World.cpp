@@ -1,9 +1,14 @@
 #include "World.h"
 #include "../Engine/Engine.h"
+#include "../Component/MeshComponent.h"
+#include "../Actor/Light/DirectionalLightActor.h"
+#include "../Actor/Light/PointLightActor.h"
+#include "../Actor/Light/SpotLightActor.h"
 #include <algorithm>
 
-
 World::World()
+	:meshOctree(TVector3::Zero, SCENE_INDEX_ROOT_HALF_SIZE, SCENE_INDEX_MAX_DEPTH),
+	lightOctree(TVector3::Zero, SCENE_INDEX_ROOT_HALF_SIZE, SCENE_INDEX_MAX_DEPTH)
 {
 }
 
@@ -30,10 +35,18 @@ void World::Update(const GameTimer& gt)
 {
 	OnKeyboardInput(gt);
 
-	// Tick actors
-	for (auto& actor : actors)
+	// Tick actors, the ones flagged for it on the workers
+	Actor::TickActors(actors, gt.DeltaTime(), tickActors);
+
+	UpdateTransforms();
+
+	UpdateSceneIndex();
+
+	UpdateShadowCascades();
+
+	if (bDrawSceneIndex)
 	{
-		actor->Tick(gt.DeltaTime());
+		DrawSceneIndex();
 	}
 
 	// Calculate FPS and draw text
@@ -67,6 +80,11 @@ void World::Update(const GameTimer& gt)
 
 }
 
+void World::ExtractRenderData(RenderSnapshot& snapshot, uint64_t frameIndex)
+{
+	snapshot.Extract(*this, frameIndex);
+}
+
 void World::EndFrame(const GameTimer& gt)
 {
 	SavePrevFrameData();
@@ -74,24 +92,186 @@ void World::EndFrame(const GameTimer& gt)
 	float DeltaTime = gt.DeltaTime();
 
 	// Clear Primitives
-	points.clear();
-	lines.clear();
-	triangles.clear();
+	debugDraw.Clear();
 
 	// Clear Texts
 	textManager.UpdateTexts(DeltaTime);
 }
 
-void World::SavePrevFrameData()
+void World::UpdateTransforms()
+{
+	transformUpdateQueue.clear();
+
+	for (const auto& actor : actors)
+	{
+		actor->GetUnattachedComponents(transformUpdateQueue);
+	}
+
+	// The queue grows while it is walked, children are appended after their parent was updated
+	for (size_t i = 0; i < transformUpdateQueue.size(); i++)
+	{
+		Component* component = transformUpdateQueue[i];
+		if (!component->NeedsTransformUpdate())
+		{
+			continue;
+		}
+
+		if (component->UpdateWorldMatrix())
+		{
+			updatedTransforms.push_back(component);
+		}
+
+		const auto& children = component->GetChildren();
+		transformUpdateQueue.insert(transformUpdateQueue.end(), children.begin(), children.end());
+	}
+}
+
+static void GetSceneIndexBounds(MeshComponent* meshComponent, TVector3& outMin, TVector3& outMax)
+{
+	TBoundingBox box;
+	if (meshComponent->IsMeshValid() && meshComponent->GetWorldBoundingBox(box))
+	{
+		outMin = box.boxMin;
+		outMax = box.boxMax;
+	}
+	else
+	{
+		outMin = outMax = meshComponent->GetWorldLocation();
+	}
+}
+
+static bool GetSceneIndexBounds(LightActor* light, TVector3& outMin, TVector3& outMax)
 {
-	for (auto& actor : actors)
+	float range;
+	if (light->GetType() == ELightType::PointLight)
+	{
+		range = static_cast<PointLightActor*>(light)->GetAttenuationRange();
+	}
+	else if (light->GetType() == ELightType::SpotLight)
+	{
+		range = static_cast<SpotLightActor*>(light)->GetAttenuationRange();
+	}
+	else
+	{
+		return false;
+	}
+
+	TVector3 location = light->GetActorLocation();
+	outMin = location - TVector3(range);
+	outMax = location + TVector3(range);
+
+	return true;
+}
+
+void World::UpdateSceneIndex()
+{
+	TVector3 boxMin, boxMax;
+
+	bool bStaticMeshesChanged = false;
+
+	// New mesh components
+	const auto& meshComponents = classRegistry.Get<MeshComponent>();
+	for (; indexedMeshCount < meshComponents.size(); indexedMeshCount++)
+	{
+		MeshComponent* meshComponent = meshComponents[indexedMeshCount];
+		GetSceneIndexBounds(meshComponent, boxMin, boxMax);
+		meshComponent->SetSceneIndexId(meshOctree.Add(meshComponent, boxMin, boxMax));
+
+		bStaticMeshesChanged |= meshComponent->bStatic;
+	}
+
+	// Moved ones
+	for (Component* component : updatedTransforms)
 	{
-		if (actor->GetRootComponent())
+		uint32_t id = component->GetSceneIndexId();
+		if (id != LOOSE_OCTREE_INVALID_ID)
 		{
-			actor->SetActorPrevTransform(actor->GetActorTransform());
+			auto meshComponent = static_cast<MeshComponent*>(component);
+			GetSceneIndexBounds(meshComponent, boxMin, boxMax);
+			meshOctree.Update(id, boxMin, boxMax);
+
+			bStaticMeshesChanged |= meshComponent->bStatic;
 		}
 	}
 
+	if (bStaticMeshesChanged)
+	{
+		staticMeshVersion++;
+	}
+
+	// Lights are few and their range changes without a transform, all of them are refreshed
+	for (LightActor* light : classRegistry.Get<LightActor>())
+	{
+		if (!GetSceneIndexBounds(light, boxMin, boxMax))
+		{
+			continue;
+		}
+
+		if (light->GetSceneIndexId() == LOOSE_OCTREE_INVALID_ID)
+		{
+			light->SetSceneIndexId(lightOctree.Add(light, boxMin, boxMax));
+		}
+		else
+		{
+			lightOctree.Update(light->GetSceneIndexId(), boxMin, boxMax);
+		}
+	}
+}
+
+void World::UpdateShadowCascades()
+{
+	// The first directional light casts the cascaded shadows
+	const auto& directionalLights = classRegistry.Get<DirectionalLightActor>();
+	bHasShadowCascades = !directionalLights.empty() && directionalLights[0]->IsCastShadows();
+
+	if (bHasShadowCascades)
+	{
+		shadowCascadeFitter.Fit(cameraComponent->GetView(), cameraComponent->GetNearZ(), cameraComponent->GetFarZ(),
+			cameraComponent->GetFovY(), cameraComponent->GetAspect(), directionalLights[0]->GetLightDirection());
+	}
+}
+
+static Color MapSceneIndexDepthToColor(uint32_t depth)
+{
+	switch (depth)
+	{
+	case 0:
+		return Color::Red;
+	case 1:
+		return Color::Yellow;
+	case 2:
+		return Color::Green;
+	case 3:
+		return Color::Cyan;
+	case 4:
+		return Color::Blue;
+	default:
+		return Color::Magenta;
+	}
+}
+
+void World::DrawSceneIndex()
+{
+	// Cells holding objects, their loose bounds are twice as large
+	meshOctree.ForEachNode([this](const TVector3& center, float halfSize, uint32_t depth, uint32_t objectCount)
+		{
+			if (objectCount > 0)
+			{
+				TVector3 extent(halfSize);
+				DrawBox3D(center - extent, center + extent, MapSceneIndexDepthToColor(depth));
+			}
+		});
+}
+
+void World::SavePrevFrameData()
+{
+	// Unchanged components have prev == current already
+	for (Component* component : updatedTransforms)
+	{
+		component->SavePrevWorldMatrix();
+	}
+	updatedTransforms.clear();
+
 	TMatrix view = cameraComponent->GetView();
 	TMatrix proj = cameraComponent->GetProj();
 	TMatrix viewProj = view * proj;
@@ -165,82 +345,43 @@ void World::OnKeyboardInput(const GameTimer& gt)
 
 }
 
-void World::DrawPoint(const TVector3& pointInWorld, const Color& color, int size)
+void World::DrawPoint(const TVector3& pointInWorld, const Color& color, int size, EDebugDepthMode depthMode)
 {
-	points.emplace_back(pointInWorld, color);
+	debugDraw.AddPoint(pointInWorld, color, depthMode);
 
 	if (size != 0)
 	{
 		float offset = 0.01f * size;
 
-		points.emplace_back(pointInWorld + TVector3(offset, 0.0f, 0.0f), color);
-		points.emplace_back(pointInWorld + TVector3(0.0f, offset, 0.0f), color);
-		points.emplace_back(pointInWorld + TVector3(0.0f, 0.0f, offset), color);
-		points.emplace_back(pointInWorld + TVector3(-offset, 0.0f, 0.0f), color);
-		points.emplace_back(pointInWorld + TVector3(0.0f, -offset, 0.0f), color);
-		points.emplace_back(pointInWorld + TVector3(0.0f, 0.0f, -offset), color);
+		debugDraw.AddPoint(pointInWorld + TVector3(offset, 0.0f, 0.0f), color, depthMode);
+		debugDraw.AddPoint(pointInWorld + TVector3(0.0f, offset, 0.0f), color, depthMode);
+		debugDraw.AddPoint(pointInWorld + TVector3(0.0f, 0.0f, offset), color, depthMode);
+		debugDraw.AddPoint(pointInWorld + TVector3(-offset, 0.0f, 0.0f), color, depthMode);
+		debugDraw.AddPoint(pointInWorld + TVector3(0.0f, -offset, 0.0f), color, depthMode);
+		debugDraw.AddPoint(pointInWorld + TVector3(0.0f, 0.0f, -offset), color, depthMode);
 	}
 }
 
-void World::DrawPoint(const Point& point)
-{
-	points.push_back(point);
-}
-
-const std::vector<Point>& World::GetPoints()
-{
-	return points;
-}
-
-void World::DrawLine(const TVector3& pointAInWorld, const TVector3& pointBInWorld, const Color& color)
-{
-	lines.emplace_back(pointAInWorld, pointBInWorld, color);
-}
-
-void World::DrawLine(const Line& line)
-{
-	lines.push_back(line);
-}
-
-const std::vector<Line>& World::GetLines()
-{
-	return lines;
-}
-
-void World::DrawBox3D(const TVector3& minPointInWorld, const TVector3& maxPointInWorld, const Color& color)
+void World::DrawLine(const TVector3& pointAInWorld, const TVector3& pointBInWorld, const Color& color, EDebugDepthMode depthMode)
 {
-	TVector3 minP = minPointInWorld;
-	TVector3 maxP = maxPointInWorld;
-
-	DrawLine(TVector3(minP.x, minP.y, minP.z), TVector3(minP.x, minP.y, maxP.z), color);
-	DrawLine(TVector3(minP.x, maxP.y, minP.z), TVector3(minP.x, maxP.y, maxP.z), color);
-	DrawLine(TVector3(maxP.x, minP.y, minP.z), TVector3(maxP.x, minP.y, maxP.z), color);
-	DrawLine(TVector3(maxP.x, maxP.y, minP.z), TVector3(maxP.x, maxP.y, maxP.z), color);
-
-	DrawLine(TVector3(minP.x, minP.y, minP.z), TVector3(maxP.x, minP.y, minP.z), color);
-	DrawLine(TVector3(minP.x, maxP.y, minP.z), TVector3(maxP.x, maxP.y, minP.z), color);
-	DrawLine(TVector3(minP.x, minP.y, maxP.z), TVector3(maxP.x, minP.y, maxP.z), color);
-	DrawLine(TVector3(minP.x, maxP.y, maxP.z), TVector3(maxP.x, maxP.y, maxP.z), color);
-
-	DrawLine(TVector3(minP.x, minP.y, minP.z), TVector3(minP.x, maxP.y, minP.z), color);
-	DrawLine(TVector3(maxP.x, minP.y, minP.z), TVector3(maxP.x, maxP.y, minP.z), color);
-	DrawLine(TVector3(minP.x, minP.y, maxP.z), TVector3(minP.x, maxP.y, maxP.z), color);
-	DrawLine(TVector3(maxP.x, minP.y, maxP.z), TVector3(maxP.x, maxP.y, maxP.z), color);
+	debugDraw.AddLine(pointAInWorld, pointBInWorld, color, depthMode);
 }
 
-void World::DrawTriangle(const TVector3& pointAInWorld, const TVector3& pointBInWorld, const TVector3& pointCInWorld, const Color& color)
+void World::DrawBox3D(const TVector3& minPointInWorld, const TVector3& maxPointInWorld, const Color& color, EDebugDepthMode depthMode)
 {
-	triangles.emplace_back(pointAInWorld, pointBInWorld, pointCInWorld, color);
+	debugDraw.AddBox(minPointInWorld, maxPointInWorld, color, depthMode);
 }
 
-void World::DrawTriangle(const Triangle& triangle)
+void World::DrawTriangle(const TVector3& pointAInWorld, const TVector3& pointBInWorld, const TVector3& pointCInWorld, const Color& color, EDebugDepthMode depthMode)
 {
-	triangles.push_back(triangle);
+	debugDraw.AddTriangle(pointAInWorld, pointBInWorld, pointCInWorld, color, depthMode);
 }
 
-const std::vector<Triangle>& World::GetTriangles()
+void World::TakeDebugDraw(DebugDrawBuffer& outDebugDraw)
 {
-	return triangles;
+	// The old contents come back as empty capacity for the next frame
+	outDebugDraw.Clear();
+	debugDraw.Swap(outDebugDraw);
 }
 
 void World::DrawSprite(const std::string& textureName, const UIntPoint& textureSize, const RECT& sourceRect, const RECT& destRect)
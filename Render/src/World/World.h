@@ -3,24 +3,39 @@
 #include <vector>
 #include <memory>
 #include "../Actor/Actor.h"
+#include "ClassRegistry.h"
+#include "LooseOctree.h"
 #include "../Mesh/Color.h"
-#include "../Mesh/Primitive.h"
+#include "../Mesh/DebugDrawBuffer.h"
 #include "../Mesh/Sprite.h"
 #include "../Mesh/TextManager.h"
 #include "../Engine/GameTimer.h"
+#include "../Engine/FramePipeline.h"
 #include "../Component/CameraComponent.h"
+#include "../Render/ShadowCascades.h"
 
 class Engine;
+class MeshComponent;
+class LightActor;
 
-class World
+// Root cell of the scene index, larger or farther objects stay in the root. The smallest cells have a half size of
+// SCENE_INDEX_ROOT_HALF_SIZE / 2^SCENE_INDEX_MAX_DEPTH, deeper trees cost more to update and to walk than they cull.
+#define SCENE_INDEX_ROOT_HALF_SIZE 1024.0f
+#define SCENE_INDEX_MAX_DEPTH 5
+
+class World : public IFrameSimulation
 {
 public:
 	World();
 	virtual ~World() {}
 
 	virtual void InitWorld(Engine* InEngine);
-	virtual void Update(const GameTimer& gt);
-	virtual void EndFrame(const GameTimer& gt);
+	virtual void Update(const GameTimer& gt) override;
+	virtual void ExtractRenderData(RenderSnapshot& snapshot, uint64_t frameIndex) override;
+	virtual void EndFrame(const GameTimer& gt) override;
+
+	// Rebuilds the world matrices of the components that moved, breadth first from the unattached ones
+	void UpdateTransforms();
 
 private:
 	void SavePrevFrameData();
@@ -40,53 +55,63 @@ public:
 		T* result = newActor.get();
 		actors.push_back(std::move(newActor));
 
+		result->AddToRegistry(classRegistry);
+
 		return result;
 	}
 
-	std::vector<Actor*> GetActors()
-	{
-		std::vector<Actor*> result;
+	// The lists below are owned by the world and valid until the next AddActor or AddComponent
 
-		for (const auto& actor : actors)
-		{
-			result.push_back(actor.get());
-		}
-
-		return result;
+	const std::vector<Actor*>& GetActors() const
+	{
+		return classRegistry.Get<Actor>();
 	}
 
+	// T and its subclasses, T must use DECLARE_CLASS
 	template<typename T>
-	std::vector<T*> GetAllActorsOfClass()
+	const std::vector<T*>& GetAllActorsOfClass() const
 	{
-		std::vector<T*> result;
-
-		for (const auto& actor : actors)
-		{
-			T* actorOfClass = dynamic_cast<T*>(actor.get());
-			if (actorOfClass)
-			{
-				result.push_back(actorOfClass);
-			}
-		}
+		return classRegistry.Get<T>();
+	}
 
-		return result;
+	// Components of all actors, T must use DECLARE_CLASS
+	template<typename T>
+	const std::vector<T*>& GetAllComponentsOfClass() const
+	{
+		return classRegistry.Get<T>();
 	}
 
 	CameraComponent* GetCameraComponent() { return cameraComponent; }
 
-public:
-	void DrawPoint(const TVector3& pointInWorld, const Color& color, int size = 0);
-	void DrawPoint(const Point& point);
-	const std::vector<Point>& GetPoints();
+	// Scene index, mesh components by world bounding box and point and spot lights by range.
+	// Updated after the transforms, directional lights are not in it.
+	const LooseOctree<MeshComponent>& GetMeshOctree() const { return meshOctree; }
+	const LooseOctree<LightActor>& GetLightOctree() const { return lightOctree; }
 
-	void DrawLine(const TVector3& pointAInWorld, const TVector3& pointBInWorld, const Color& color);
-	void DrawLine(const Line& line);
-	const std::vector<Line>& GetLines();
+	// Changes when a static mesh component is added or moved, shadow maps cached for an older version are stale
+	uint64_t GetStaticMeshVersion() const { return staticMeshVersion; }
 
-	void DrawBox3D(const TVector3& minPointInWorld, const TVector3& maxPointInWorld, const Color& color);
-	void DrawTriangle(const TVector3& pointAInWorld, const TVector3& pointBInWorld, const TVector3& pointCInWorld, const Color& color);
-	void DrawTriangle(const Triangle& triangle);
-	const std::vector<Triangle>& GetTriangles();
+	// Cascades of the first directional light, fitted to the camera after the transforms
+	bool HasShadowCascades() const { return bHasShadowCascades; }
+	const ShadowCascadeFitter& GetShadowCascades() const { return shadowCascadeFitter; }
+
+private:
+	void UpdateSceneIndex();
+	void UpdateShadowCascades();
+
+	// Draws the cells of the mesh octree, colored by depth
+	void DrawSceneIndex();
+
+public:
+	// Debug primitives, drawn for one frame. Only from the game thread, parallel ticking actors must not draw.
+	void DrawPoint(const TVector3& pointInWorld, const Color& color, int size = 0, EDebugDepthMode depthMode = EDebugDepthMode::DepthTest);
+	void DrawLine(const TVector3& pointAInWorld, const TVector3& pointBInWorld, const Color& color, EDebugDepthMode depthMode = EDebugDepthMode::DepthTest);
+	void DrawBox3D(const TVector3& minPointInWorld, const TVector3& maxPointInWorld, const Color& color, EDebugDepthMode depthMode = EDebugDepthMode::DepthTest);
+	void DrawTriangle(const TVector3& pointAInWorld, const TVector3& pointBInWorld, const TVector3& pointCInWorld, const Color& color,
+		EDebugDepthMode depthMode = EDebugDepthMode::DepthTest);
+
+	// Swaps the primitives drawn this frame into outDebugDraw, which is cleared first
+	void TakeDebugDraw(DebugDrawBuffer& outDebugDraw);
 
 	void DrawSprite(const std::string& textureName, const UIntPoint& textureSize, const RECT& sourceRect, const RECT& destRect);
 	const std::vector<TSprite>& GetSprites();
@@ -96,12 +121,21 @@ public:
 
 protected:
 	std::vector<std::unique_ptr<Actor>> actors;
-	std::vector<Point> points;
-	std::vector<Line> lines;
-	std::vector<Triangle> triangles;
+	DebugDrawBuffer debugDraw;
 	std::vector<TSprite> Sprites;
 	TextManager textManager;
 
+	ClassRegistry classRegistry;
+
+	LooseOctree<MeshComponent> meshOctree;
+	LooseOctree<LightActor> lightOctree;
+	uint64_t staticMeshVersion = 0;
+
+	ShadowCascadeFitter shadowCascadeFitter;
+	bool bHasShadowCascades = false;
+
+	bool bDrawSceneIndex = false;
+
 protected:
 	Engine* engine = nullptr;
 	HWND  mainWindowHandle = nullptr; // main window handle
@@ -109,6 +143,14 @@ protected:
 	float moveSpeed = 2.0f;
 
 private:
+	// Kept between frames so the passes do not allocate
+	std::vector<Actor*> tickActors;
+	std::vector<Component*> transformUpdateQueue;
+	std::vector<Component*> updatedTransforms;
+
+	// The class lists only grow, the ones before are in the scene index
+	size_t indexedMeshCount = 0;
+
 	POINT LastMousePos;
 	bool bKey_H_Pressed = false;
 	bool bKey_J_Pressed = false;